@@ -70,6 +70,7 @@ LOCAL_SRC_FILES:= \
     ./sdp/bta_sdp.c \
     ./sdp/bta_sdp_cfg.c \
     ./sys/bta_sys_main.c \
+    ./sys/bta_sys_msg.c \
     ./sys/bta_sys_conn.c \
     ./sys/utl.c \
     ./jv/bta_jv_act.c \
@@ -103,3 +104,41 @@ LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
 LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
 
 include $(BUILD_STATIC_LIBRARY)
+
+# BTA unit tests for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+                   $(LOCAL_PATH)/include \
+                   $(LOCAL_PATH)/gatt \
+                   $(LOCAL_PATH)/sys \
+                   $(LOCAL_PATH)/../ \
+                   $(LOCAL_PATH)/../btcore/include \
+                   $(LOCAL_PATH)/../hci/include \
+                   $(LOCAL_PATH)/../include \
+                   $(LOCAL_PATH)/../osi/test \
+                   $(LOCAL_PATH)/../stack/btm \
+                   $(LOCAL_PATH)/../stack/include \
+                   $(LOCAL_PATH)/../udrv/include \
+                   $(LOCAL_PATH)/../utils/include \
+                   $(LOCAL_PATH)/../vnd/include \
+                   $(bluetooth_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../osi/test/AllocationTestHarness.cpp \
+    ./gatt/bta_gattc_cache.c \
+    ./sys/bta_sys_msg.c \
+    ./test/bta_gattc_cache_test.cpp \
+    ./test/bta_sys_msg_test.cpp
+
+LOCAL_MODULE := net_test_bta
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libdl
+LOCAL_STATIC_LIBRARIES := libosi libcutils
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS) -DBUILDCFG
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+
+include $(BUILD_NATIVE_TEST)
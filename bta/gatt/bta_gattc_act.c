@@ -1053,10 +1053,8 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
     if (p_clcb->status != GATT_SUCCESS)
     {
         /* clean up cache */
-        if(p_clcb->p_srcb && p_clcb->p_srcb->p_srvc_cache) {
-            list_free(p_clcb->p_srcb->p_srvc_cache);
-            p_clcb->p_srcb->p_srvc_cache = NULL;
-        }
+        if (p_clcb->p_srcb)
+            bta_gattc_free_srvc_cache(p_clcb->p_srcb);
 
         /* used to reset cache in application */
         bta_gattc_cache_reset(p_clcb->p_srcb->server_bda);
@@ -1084,7 +1082,7 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
          * referenced by p_clcb->p_q_cmd
          */
         if (p_q_cmd != p_clcb->p_q_cmd)
-            osi_free_and_reset((void **)&p_q_cmd);
+            bta_sys_free_msg(p_q_cmd);
     }
 }
 /*******************************************************************************
@@ -1278,7 +1276,8 @@ void bta_gattc_read_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data)
     event = p_clcb->p_q_cmd->api_read.cmpl_evt;
     cb_data.read.conn_id = p_clcb->bta_conn_id;
 
-    osi_free_and_reset((void **)&p_clcb->p_q_cmd);
+    bta_sys_free_msg(p_clcb->p_q_cmd);
+    p_clcb->p_q_cmd = NULL;
     /* read complete, callback */
     ( *p_clcb->p_rcb->p_cback)(event, (tBTA_GATTC *)&cb_data);
 
@@ -1310,7 +1309,8 @@ void bta_gattc_write_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data)
     else
         event = p_clcb->p_q_cmd->api_write.cmpl_evt;
 
-    osi_free_and_reset((void **)&p_clcb->p_q_cmd);
+    bta_sys_free_msg(p_clcb->p_q_cmd);
+    p_clcb->p_q_cmd = NULL;
     cb_data.write.conn_id = p_clcb->bta_conn_id;
     /* write complete, callback */
     ( *p_clcb->p_rcb->p_cback)(event, (tBTA_GATTC *)&cb_data);
@@ -1329,7 +1329,8 @@ void bta_gattc_exec_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data)
 {
     tBTA_GATTC          cb_data;
 
-    osi_free_and_reset((void **)&p_clcb->p_q_cmd);
+    bta_sys_free_msg(p_clcb->p_q_cmd);
+    p_clcb->p_q_cmd = NULL;
     p_clcb->status      = BTA_GATT_OK;
 
     /* execute complete, callback */
@@ -1353,7 +1354,8 @@ void bta_gattc_cfg_mtu_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data)
 {
     tBTA_GATTC          cb_data;
 
-    osi_free_and_reset((void **)&p_clcb->p_q_cmd);
+    bta_sys_free_msg(p_clcb->p_q_cmd);
+    p_clcb->p_q_cmd = NULL;
 
     if (p_data->p_cmpl  &&  p_data->status == BTA_GATT_OK)
         p_clcb->p_srcb->mtu  = p_data->p_cmpl->mtu;
@@ -1664,10 +1666,7 @@ void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg)
             }
         }
         /* in all other cases, mark it and delete the cache */
-        if (p_srvc_cb->p_srvc_cache != NULL) {
-            list_free(p_srvc_cb->p_srvc_cache);
-            p_srvc_cb->p_srvc_cache = NULL;
-        }
+        bta_gattc_free_srvc_cache(p_srvc_cb);
     }
     /* used to reset cache in application */
     bta_gattc_cache_reset(p_msg->api_conn.remote_bda);
@@ -337,7 +337,7 @@ void  BTA_GATTC_GetGattDb(UINT16 conn_id, UINT16 start_handle, UINT16 end_handle
 void BTA_GATTC_ReadCharacteristic(UINT16 conn_id, UINT16 handle, tBTA_GATT_AUTH_REQ auth_req)
 {
     tBTA_GATTC_API_READ *p_buf =
-        (tBTA_GATTC_API_READ *)osi_calloc(sizeof(tBTA_GATTC_API_READ));
+        (tBTA_GATTC_API_READ *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_READ));
 
     p_buf->hdr.event = BTA_GATTC_API_READ_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -363,7 +363,7 @@ void BTA_GATTC_ReadCharacteristic(UINT16 conn_id, UINT16 handle, tBTA_GATT_AUTH_
 void BTA_GATTC_ReadCharDescr (UINT16 conn_id, UINT16 handle, tBTA_GATT_AUTH_REQ auth_req)
 {
     tBTA_GATTC_API_READ *p_buf =
-        (tBTA_GATTC_API_READ *)osi_calloc(sizeof(tBTA_GATTC_API_READ));
+        (tBTA_GATTC_API_READ *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_READ));
 
     p_buf->hdr.event = BTA_GATTC_API_READ_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -391,7 +391,7 @@ void BTA_GATTC_ReadMultiple(UINT16 conn_id, tBTA_GATTC_MULTI *p_read_multi,
                             tBTA_GATT_AUTH_REQ auth_req)
 {
     tBTA_GATTC_API_READ_MULTI *p_buf =
-        (tBTA_GATTC_API_READ_MULTI *)osi_calloc(sizeof(tBTA_GATTC_API_READ_MULTI));
+        (tBTA_GATTC_API_READ_MULTI *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_READ_MULTI));
 
     p_buf->hdr.event = BTA_GATTC_API_READ_MULTI_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -427,7 +427,7 @@ void BTA_GATTC_WriteCharValue ( UINT16 conn_id,
                                 tBTA_GATT_AUTH_REQ auth_req)
 {
     tBTA_GATTC_API_WRITE  *p_buf =
-        (tBTA_GATTC_API_WRITE *)osi_calloc(sizeof(tBTA_GATTC_API_WRITE) + len);
+        (tBTA_GATTC_API_WRITE *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_WRITE) + len);
 
     p_buf->hdr.event = BTA_GATTC_API_WRITE_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -470,7 +470,7 @@ void BTA_GATTC_WriteCharDescr (UINT16 conn_id,
     if (p_data != NULL)
         len += p_data->len;
 
-    tBTA_GATTC_API_WRITE *p_buf = (tBTA_GATTC_API_WRITE *)osi_calloc(len);
+    tBTA_GATTC_API_WRITE *p_buf = (tBTA_GATTC_API_WRITE *)bta_sys_alloc_msg(len);
     p_buf->hdr.event = BTA_GATTC_API_WRITE_EVT;
     p_buf->hdr.layer_specific = conn_id;
     p_buf->auth_req = auth_req;
@@ -508,7 +508,7 @@ void BTA_GATTC_PrepareWrite  (UINT16 conn_id, UINT16 handle,
                               tBTA_GATT_AUTH_REQ auth_req)
 {
     tBTA_GATTC_API_WRITE *p_buf =
-        (tBTA_GATTC_API_WRITE *)osi_calloc(sizeof(tBTA_GATTC_API_WRITE) + len);
+        (tBTA_GATTC_API_WRITE *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_WRITE) + len);
 
     p_buf->hdr.event = BTA_GATTC_API_WRITE_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -542,7 +542,7 @@ void BTA_GATTC_PrepareWrite  (UINT16 conn_id, UINT16 handle,
 void BTA_GATTC_ExecuteWrite  (UINT16 conn_id, BOOLEAN is_execute)
 {
     tBTA_GATTC_API_EXEC *p_buf =
-        (tBTA_GATTC_API_EXEC *)osi_calloc(sizeof(tBTA_GATTC_API_EXEC));
+        (tBTA_GATTC_API_EXEC *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_EXEC));
 
     p_buf->hdr.event = BTA_GATTC_API_EXEC_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -566,7 +566,7 @@ void BTA_GATTC_ExecuteWrite  (UINT16 conn_id, BOOLEAN is_execute)
 void BTA_GATTC_SendIndConfirm (UINT16 conn_id, UINT16 handle)
 {
     tBTA_GATTC_API_CONFIRM *p_buf =
-        (tBTA_GATTC_API_CONFIRM *)osi_calloc(sizeof(tBTA_GATTC_API_CONFIRM));
+        (tBTA_GATTC_API_CONFIRM *)bta_sys_alloc_msg(sizeof(tBTA_GATTC_API_CONFIRM));
 
     APPL_TRACE_API("%s conn_id=%d handle=0x%04x", __func__, conn_id, handle);
 
@@ -31,6 +31,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "bta_gattc_int.h"
@@ -171,10 +172,7 @@ static void bta_gattc_display_explore_record(tBTA_GATTC_ATTR_REC *p_rec, UINT8 n
 *******************************************************************************/
 tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
 {
-    if (p_srvc_cb->p_srvc_cache != NULL) {
-        list_free(p_srvc_cb->p_srvc_cache);
-        p_srvc_cb->p_srvc_cache = NULL;
-    }
+    bta_gattc_free_srvc_cache(p_srvc_cb);
 
     osi_free(p_srvc_cb->p_srvc_list);
     p_srvc_cb->p_srvc_list =
@@ -187,6 +185,154 @@ tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
     return BTA_GATT_OK;
 }
 
+/*******************************************************************************
+**
+** Function         bta_gattc_free_handle_index
+**
+** Description      Free the handle lookup tables of the database cache.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_free_handle_index(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    osi_free_and_reset((void **)&p_srvc_cb->p_srvc_index);
+    osi_free_and_reset((void **)&p_srvc_cb->p_attr_index);
+    p_srvc_cb->num_srvc_index = 0;
+    p_srvc_cb->num_attr_index = 0;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_free_srvc_cache
+**
+** Description      Free the database cache and its handle lookup tables.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void bta_gattc_free_srvc_cache(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    bta_gattc_free_handle_index(p_srvc_cb);
+
+    if (p_srvc_cb->p_srvc_cache != NULL) {
+        list_free(p_srvc_cb->p_srvc_cache);
+        p_srvc_cb->p_srvc_cache = NULL;
+    }
+}
+
+static int srvc_index_cmp(const void *a, const void *b) {
+    const tBTA_GATTC_SERVICE *sa = *(tBTA_GATTC_SERVICE * const *)a;
+    const tBTA_GATTC_SERVICE *sb = *(tBTA_GATTC_SERVICE * const *)b;
+    return (int)sa->s_handle - (int)sb->s_handle;
+}
+
+static int attr_index_cmp(const void *a, const void *b) {
+    return (int)((const tBTA_GATTC_ATTR_INDEX *)a)->handle -
+           (int)((const tBTA_GATTC_ATTR_INDEX *)b)->handle;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_build_handle_index
+**
+** Description      Build the tables used to look up services, characteristics
+**                  and descriptors of the database cache by handle. Called once
+**                  the cache is complete, after discovery or loading it from NV.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_build_handle_index(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    size_t num_srvc = 0, num_attr = 0;
+
+    bta_gattc_free_handle_index(p_srvc_cb);
+
+    if (!p_srvc_cb->p_srvc_cache || list_is_empty(p_srvc_cb->p_srvc_cache))
+        return;
+
+    for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
+         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn)) {
+        tBTA_GATTC_SERVICE *p_srvc = list_node(sn);
+        num_srvc++;
+
+        for (list_node_t *cn = list_begin(p_srvc->characteristics);
+             cn != list_end(p_srvc->characteristics); cn = list_next(cn)) {
+            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
+            num_attr += 1 + list_length(p_char->descriptors);
+        }
+    }
+
+    /* every handle fits in a UINT16, so a sane database always fits too */
+    if (num_srvc > UINT16_MAX || num_attr > UINT16_MAX)
+        return;
+
+    p_srvc_cb->p_srvc_index = osi_malloc(num_srvc * sizeof(tBTA_GATTC_SERVICE *));
+    if (num_attr > 0)
+        p_srvc_cb->p_attr_index = osi_malloc(num_attr * sizeof(tBTA_GATTC_ATTR_INDEX));
+
+    for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
+         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn)) {
+        tBTA_GATTC_SERVICE *p_srvc = list_node(sn);
+        p_srvc_cb->p_srvc_index[p_srvc_cb->num_srvc_index++] = p_srvc;
+
+        for (list_node_t *cn = list_begin(p_srvc->characteristics);
+             cn != list_end(p_srvc->characteristics); cn = list_next(cn)) {
+            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
+            tBTA_GATTC_ATTR_INDEX *p_entry = &p_srvc_cb->p_attr_index[p_srvc_cb->num_attr_index++];
+            p_entry->handle = p_char->handle;
+            p_entry->is_descr = FALSE;
+            p_entry->p_attr = p_char;
+
+            for (list_node_t *dn = list_begin(p_char->descriptors);
+                 dn != list_end(p_char->descriptors); dn = list_next(dn)) {
+                tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
+                p_entry = &p_srvc_cb->p_attr_index[p_srvc_cb->num_attr_index++];
+                p_entry->handle = p_desc->handle;
+                p_entry->is_descr = TRUE;
+                p_entry->p_attr = p_desc;
+            }
+        }
+    }
+
+    qsort(p_srvc_cb->p_srvc_index, p_srvc_cb->num_srvc_index,
+          sizeof(tBTA_GATTC_SERVICE *), srvc_index_cmp);
+    if (p_srvc_cb->num_attr_index > 0)
+        qsort(p_srvc_cb->p_attr_index, p_srvc_cb->num_attr_index,
+              sizeof(tBTA_GATTC_ATTR_INDEX), attr_index_cmp);
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_find_indexed_attr
+**
+** Description      Binary search the attribute handle index for a
+**                  characteristic (is_descr FALSE) or descriptor handle.
+**
+** Returns          pointer to the attribute, NULL if not found.
+**
+*******************************************************************************/
+static void *bta_gattc_find_indexed_attr(const tBTA_GATTC_SERV *p_srcb, UINT16 handle,
+                                         BOOLEAN is_descr)
+{
+    size_t lo = 0, hi = p_srcb->num_attr_index;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (p_srcb->p_attr_index[mid].handle < handle)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < p_srcb->num_attr_index && p_srcb->p_attr_index[lo].handle == handle &&
+        p_srcb->p_attr_index[lo].is_descr == is_descr)
+        return p_srcb->p_attr_index[lo].p_attr;
+
+    return NULL;
+}
+
 static void characteristic_free(void *ptr) {
   tBTA_GATTC_CHARACTERISTIC *p_char = ptr;
   list_free(p_char->descriptors);
@@ -519,6 +665,8 @@ static void bta_gattc_explore_srvc(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb)
     /* no service found at all, the end of server discovery*/
     LOG_WARN(LOG_TAG, "%s no more services found", __func__);
 
+    bta_gattc_build_handle_index(p_srvc_cb);
+
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
     if(p_srvc_cb->p_srvc_cache)
         bta_gattc_display_cache_server(p_srvc_cb->p_srvc_cache);
@@ -1059,18 +1207,40 @@ tBTA_GATTC_SERVICE*  bta_gattc_find_matching_service(const list_t *services, UIN
 }
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) {
+    if (p_srcb && p_srcb->p_srvc_index) {
+        /* last service starting at or before the handle */
+        size_t lo = 0, hi = p_srcb->num_srvc_index;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (p_srcb->p_srvc_index[mid]->s_handle <= handle)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (lo > 0 && handle <= p_srcb->p_srvc_index[lo - 1]->e_handle)
+            return p_srcb->p_srvc_index[lo - 1];
+        return NULL;
+    }
+
     const list_t *services = bta_gattc_get_services_srcb(p_srcb);
 
     return bta_gattc_find_matching_service(services, handle);
 }
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle(UINT16 conn_id, UINT16 handle) {
-    const list_t *services = bta_gattc_get_services(conn_id);
+    tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
-    return bta_gattc_find_matching_service(services, handle);
+    if (p_clcb == NULL)
+        return NULL;
+
+    return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) {
+    if (p_srcb && p_srcb->p_attr_index)
+        return bta_gattc_find_indexed_attr(p_srcb, handle, FALSE);
+
     const tBTA_GATTC_SERVICE* service = bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
 
     if (!service)
@@ -1097,6 +1267,9 @@ tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic(UINT16 conn_id, UINT16
 }
 
 tBTA_GATTC_DESCRIPTOR*  bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) {
+    if (p_srcb && p_srcb->p_attr_index)
+        return bta_gattc_find_indexed_attr(p_srcb, handle, TRUE);
+
     const tBTA_GATTC_SERVICE* service = bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
 
     if (!service) {
@@ -1363,8 +1536,7 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
     /* first attribute loading, initialize buffer */
     APPL_TRACE_ERROR("%s: bta_gattc_rebuild_cache", __func__);
 
-    list_free(p_srvc_cb->p_srvc_cache);
-    p_srvc_cb->p_srvc_cache = NULL;
+    bta_gattc_free_srvc_cache(p_srvc_cb);
 
     while (num_attr > 0 && p_attr != NULL)
     {
@@ -1400,6 +1572,8 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
         p_attr ++;
         num_attr --;
     }
+
+    bta_gattc_build_handle_index(p_srvc_cb);
 }
 
 /*******************************************************************************
@@ -263,6 +263,14 @@ enum
 };
 typedef UINT8 tBTA_GATTC_STATE;
 
+/* handle index entry of a cached characteristic or descriptor */
+typedef struct
+{
+    UINT16              handle;
+    BOOLEAN             is_descr;
+    void                *p_attr;        /* tBTA_GATTC_CHARACTERISTIC or tBTA_GATTC_DESCRIPTOR */
+} tBTA_GATTC_ATTR_INDEX;
+
 typedef struct
 {
     BOOLEAN             in_use;
@@ -278,6 +286,11 @@ typedef struct
     UINT8               state;
 
     list_t              *p_srvc_cache;  /* list of tBTA_GATTC_SERVICE */
+    /* lookup tables into p_srvc_cache, built once it is complete */
+    tBTA_GATTC_SERVICE  **p_srvc_index;     /* services sorted by start handle */
+    UINT16              num_srvc_index;
+    tBTA_GATTC_ATTR_INDEX *p_attr_index;    /* attributes sorted by handle */
+    UINT16              num_attr_index;
     UINT8               update_count;   /* indication received */
     UINT8               num_clcb;       /* number of associated CLCB */
 
@@ -481,11 +494,14 @@ extern tBTA_GATT_STATUS bta_gattc_discover_pri_service(UINT16 conn_id, tBTA_GATT
 extern void bta_gattc_search_service(tBTA_GATTC_CLCB *p_clcb, tBT_UUID *p_uuid);
 extern const list_t* bta_gattc_get_services(UINT16 conn_id);
 extern const tBTA_GATTC_SERVICE* bta_gattc_get_service_for_handle(UINT16 conn_id, UINT16 handle);
+extern const tBTA_GATTC_SERVICE* bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle);
 tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle);
 extern tBTA_GATTC_CHARACTERISTIC* bta_gattc_get_characteristic(UINT16 conn_id, UINT16 handle);
+extern tBTA_GATTC_DESCRIPTOR* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle);
 extern tBTA_GATTC_DESCRIPTOR* bta_gattc_get_descriptor(UINT16 conn_id, UINT16 handle);
 extern void bta_gattc_get_gatt_db(UINT16 conn_id, UINT16 start_handle, UINT16 end_handle, btgatt_db_element_t **db, int *count);
 extern tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb);
+extern void bta_gattc_free_srvc_cache(tBTA_GATTC_SERV *p_srvc_cb);
 extern void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srcv, UINT16 num_attr, tBTA_GATTC_NV_ATTR *attr);
 extern void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id);
 extern void bta_gattc_reset_discover_st(tBTA_GATTC_SERV *p_srcb, tBTA_GATT_STATUS status);
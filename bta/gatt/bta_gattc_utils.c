@@ -304,7 +304,8 @@ void bta_gattc_clcb_dealloc(tBTA_GATTC_CLCB *p_clcb)
             p_srcb->mtu = 0;
         }
 
-        osi_free_and_reset((void **)&p_clcb->p_q_cmd);
+        bta_sys_free_msg(p_clcb->p_q_cmd);
+        p_clcb->p_q_cmd = NULL;
         memset(p_clcb, 0, sizeof(tBTA_GATTC_CLCB));
     } else {
         APPL_TRACE_ERROR("bta_gattc_clcb_dealloc p_clcb=NULL");
@@ -409,8 +410,7 @@ tBTA_GATTC_SERV * bta_gattc_srcb_alloc(BD_ADDR bda)
 
     if (p_tcb != NULL)
     {
-        if (p_tcb->p_srvc_cache != NULL)
-            list_free(p_tcb->p_srvc_cache);
+        bta_gattc_free_srvc_cache(p_tcb);
 
         osi_free_and_reset((void **)&p_tcb->p_srvc_list);
         memset(p_tcb, 0 , sizeof(tBTA_GATTC_SERV));
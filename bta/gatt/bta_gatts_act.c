@@ -669,6 +669,104 @@ void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
 }
 
 
+/*******************************************************************************
+**
+** Function         bta_gatts_notify_multi
+**
+** Description      GATTS send the same handle value notification to several
+**                  connections.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_notify_multi (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI *p_notify = &p_msg->api_notify_multi;
+    tBTA_GATTS_SRVC_CB  *p_srvc_cb;
+    tBTA_GATTS_RCB      *p_rcb;
+    tGATT_STATUS        status[BTA_GATTS_NOTIFY_MULTI_MAX];
+    tGATT_IF            gatt_if;
+    BD_ADDR             remote_bda;
+    tBTA_TRANSPORT      transport;
+    tBTA_GATTS          cb_data;
+    UINT8               ii;
+
+    p_srvc_cb = bta_gatts_find_srvc_cb_by_attr_id (p_cb, p_notify->attr_id);
+
+    if (p_srvc_cb == NULL)
+    {
+        APPL_TRACE_ERROR("Not an registered servce attribute ID: 0x%04x",
+                          p_notify->attr_id);
+        return;
+    }
+
+    GATTS_HandleValueNotificationMulti(p_notify->num_conn, p_notify->conn_ids,
+                                       p_notify->attr_id, p_notify->len,
+                                       p_notify->value, status);
+
+    for (ii = 0; ii < p_notify->num_conn; ii ++)
+    {
+        if (!GATT_GetConnectionInfor(p_notify->conn_ids[ii], &gatt_if, remote_bda, &transport))
+        {
+            APPL_TRACE_ERROR("Unknown connection ID: %d fail sending notification",
+                              p_notify->conn_ids[ii]);
+            continue;
+        }
+
+        /* if over BR_EDR, inform PM for mode change */
+        if (transport == BTA_TRANSPORT_BR_EDR)
+        {
+            bta_sys_busy(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+            bta_sys_idle(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+        }
+
+        p_rcb = bta_gatts_find_app_rcb_by_app_if(gatt_if);
+        if (p_rcb && p_cb->rcb[p_srvc_cb->rcb_idx].p_cback)
+        {
+            cb_data.req_data.status = status[ii];
+            cb_data.req_data.conn_id = p_notify->conn_ids[ii];
+
+            (*p_rcb->p_cback)(BTA_GATTS_CONF_EVT, &cb_data);
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_gatts_set_attr_value
+**
+** Description      GATTS store an attribute value the stack answers reads with.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_set_attr_value (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
+{
+    tBTA_GATTS_API_SET_ATTR_VAL *p_set = &p_msg->api_set_attr_val;
+    tBTA_GATTS_SRVC_CB  *p_srvc_cb;
+    tGATT_STATUS        status;
+
+    p_srvc_cb = bta_gatts_find_srvc_cb_by_attr_id (p_cb, p_set->attr_id);
+
+    if (p_srvc_cb == NULL)
+    {
+        APPL_TRACE_ERROR("Not an registered servce attribute ID: 0x%04x",
+                          p_set->attr_id);
+        return;
+    }
+
+    status = GATTS_SetAttributeValue(p_srvc_cb->service_id, p_set->attr_id, p_set->len,
+                                     p_set->has_value ? p_set->value : NULL,
+                                     p_set->notify_app);
+
+    /* e.g. a client configuration descriptor, which is kept per client */
+    if (status != GATT_SUCCESS)
+    {
+        APPL_TRACE_DEBUG("%s: attribute ID 0x%04x status %d", __func__,
+                          p_set->attr_id, status);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         bta_gatts_open
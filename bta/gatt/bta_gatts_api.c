@@ -332,7 +332,7 @@ void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id, UINT16 dat
                                       UINT8 *p_data, BOOLEAN need_confirm)
 {
     tBTA_GATTS_API_INDICATION *p_buf =
-        (tBTA_GATTS_API_INDICATION *)osi_calloc(sizeof(tBTA_GATTS_API_INDICATION));
+        (tBTA_GATTS_API_INDICATION *)bta_sys_alloc_msg(sizeof(tBTA_GATTS_API_INDICATION));
 
     p_buf->hdr.event = BTA_GATTS_API_INDICATION_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -346,6 +346,94 @@ void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id, UINT16 dat
     bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotificationMulti
+**
+** Description      This function is called to send the same handle value
+**                  notification to several connections at once.
+**
+** Parameters       num_conn - number of connections, at most
+**                             BTA_GATTS_NOTIFY_MULTI_MAX.
+**                  conn_ids - connection identifiers to notify.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notification data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+void BTA_GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *conn_ids,
+                                             UINT16 attr_id, UINT16 data_len,
+                                             UINT8 *p_data)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI *p_buf;
+
+    if (num_conn == 0 || num_conn > BTA_GATTS_NOTIFY_MULTI_MAX ||
+        data_len > BTA_GATT_MAX_ATTR_LEN)
+    {
+        APPL_TRACE_ERROR("%s: invalid num_conn %d or data_len %d", __func__,
+                         num_conn, data_len);
+        return;
+    }
+
+    p_buf = (tBTA_GATTS_API_NOTIFY_MULTI *)bta_sys_alloc_msg(sizeof(tBTA_GATTS_API_NOTIFY_MULTI));
+
+    p_buf->hdr.event = BTA_GATTS_API_NOTIFY_MULTI_EVT;
+    p_buf->attr_id = attr_id;
+    p_buf->num_conn = num_conn;
+    memcpy(p_buf->conn_ids, conn_ids, num_conn * sizeof(UINT16));
+    p_buf->len = data_len;
+    if (data_len > 0 && p_data != NULL)
+        memcpy(p_buf->value, p_data, data_len);
+
+    bta_sys_sendmsg(p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         BTA_GATTS_SetAttributeValue
+**
+** Description      This function is called to hand the value of a characteristic
+**                  value or descriptor to the stack, which then answers client
+**                  reads of it without a BTA_GATTS_READ_EVT. A client write
+**                  drops the stored value until it is set again.
+**
+** Parameters       attr_id - characteristic value or descriptor ID.
+**                  data_len - value length.
+**                  p_data: value, NULL to have reads sent to the application
+**                          again.
+**                  notify_app: TRUE to still get a BTA_GATTS_READ_EVT for reads
+**                          starting at offset 0; only the rest of a long read
+**                          is then answered by the stack.
+**
+** Returns          None
+**
+*******************************************************************************/
+void BTA_GATTS_SetAttributeValue (UINT16 attr_id, UINT16 data_len, UINT8 *p_data,
+                                  BOOLEAN notify_app)
+{
+    tBTA_GATTS_API_SET_ATTR_VAL *p_buf;
+
+    if (data_len > BTA_GATT_MAX_ATTR_LEN)
+    {
+        APPL_TRACE_ERROR("%s: invalid data_len %d", __func__, data_len);
+        return;
+    }
+
+    p_buf = (tBTA_GATTS_API_SET_ATTR_VAL *)bta_sys_alloc_msg(sizeof(tBTA_GATTS_API_SET_ATTR_VAL));
+
+    p_buf->hdr.event = BTA_GATTS_API_SET_ATTR_VAL_EVT;
+    p_buf->attr_id = attr_id;
+    p_buf->has_value = (p_data != NULL);
+    p_buf->notify_app = notify_app;
+    p_buf->len = p_buf->has_value ? data_len : 0;
+    if (p_buf->len > 0)
+        memcpy(p_buf->value, p_data, data_len);
+
+    bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
@@ -364,7 +452,7 @@ void BTA_GATTS_SendRsp (UINT16 conn_id, UINT32 trans_id,
                         tBTA_GATT_STATUS status, tBTA_GATTS_RSP *p_msg)
 {
     const size_t len = sizeof(tBTA_GATTS_API_RSP) + sizeof(tBTA_GATTS_RSP);
-    tBTA_GATTS_API_RSP *p_buf = (tBTA_GATTS_API_RSP *)osi_calloc(len);
+    tBTA_GATTS_API_RSP *p_buf = (tBTA_GATTS_API_RSP *)bta_sys_alloc_msg(len);
 
     p_buf->hdr.event = BTA_GATTS_API_RSP_EVT;
     p_buf->hdr.layer_specific = conn_id;
@@ -189,6 +189,9 @@ typedef struct
 
 #define BTA_GATT_MAX_ATTR_LEN       GATT_MAX_ATTR_LEN
 
+/* max number of connections one BTA_GATTS_HandleValueNotificationMulti() call notifies */
+#define BTA_GATTS_NOTIFY_MULTI_MAX  GATT_MAX_PHY_CHANNEL
+
 #define BTA_GATTC_TYPE_WRITE             GATT_WRITE
 #define BTA_GATTC_TYPE_WRITE_NO_RSP      GATT_WRITE_NO_RSP
 typedef UINT8 tBTA_GATTC_WRITE_TYPE;
@@ -1197,6 +1200,52 @@ extern void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id,
                                              UINT8 *p_data,
                                              BOOLEAN need_confirm);
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotificationMulti
+**
+** Description      This function is called to send the same handle value
+**                  notification to several connections at once. The value is
+**                  passed down once and a BTA_GATTS_CONF_EVT is reported for
+**                  each connection.
+**
+** Parameters       num_conn - number of connections, at most
+**                             BTA_GATTS_NOTIFY_MULTI_MAX.
+**                  conn_ids - connection identifiers to notify.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notification data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+extern void BTA_GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *conn_ids,
+                                                    UINT16 attr_id, UINT16 data_len,
+                                                    UINT8 *p_data);
+
+/*******************************************************************************
+**
+** Function         BTA_GATTS_SetAttributeValue
+**
+** Description      This function is called to hand the value of a characteristic
+**                  value or descriptor to the stack, which then answers client
+**                  reads of it without a BTA_GATTS_READ_EVT. A client write
+**                  drops the stored value until it is set again.
+**
+** Parameters       attr_id - characteristic value or descriptor ID.
+**                  data_len - value length.
+**                  p_data: value, NULL to have reads sent to the application
+**                          again.
+**                  notify_app: TRUE to still get a BTA_GATTS_READ_EVT for reads
+**                          starting at offset 0; only the rest of a long read
+**                          is then answered by the stack.
+**
+** Returns          None
+**
+*******************************************************************************/
+extern void BTA_GATTS_SetAttributeValue (UINT16 attr_id, UINT16 data_len, UINT8 *p_data,
+                                         BOOLEAN notify_app);
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
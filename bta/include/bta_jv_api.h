@@ -687,14 +687,18 @@ tBTA_JV_STATUS BTA_JvL2capReady(UINT32 handle, UINT32 *p_data_size);
 ** Description      This function writes data to an L2CAP connection
 **                  When the operation is complete, tBTA_JV_L2CAP_CBACK is
 **                  called with BTA_JV_L2CAP_WRITE_EVT. Works for
-**                  PSM-based connections
+**                  PSM-based connections. |p_buf| must have at least
+**                  L2CAP_MIN_OFFSET bytes of headroom before the payload
+**                  and, on an ERTM connection, L2CAP_FCS_LEN bytes after
+**                  it. It is owned by BTA JV from this call on, including
+**                  when the request fails.
 **
 ** Returns          BTA_JV_SUCCESS, if the request is being processed.
 **                  BTA_JV_FAILURE, otherwise.
 **
 *******************************************************************************/
 tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id,
-                                               UINT8 *p_data, UINT16 len, void *user_data);
+                                               BT_HDR *p_buf, void *user_data);
 
 
 /*******************************************************************************
@@ -704,7 +708,9 @@ tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id,
 ** Description      This function writes data to an L2CAP connection
 **                  When the operation is complete, tBTA_JV_L2CAP_CBACK is
 **                  called with BTA_JV_L2CAP_WRITE_FIXED_EVT. Works for
-**                  fixed-channel connections
+**                  fixed-channel connections. |p_buf| must have at least
+**                  L2CAP_MIN_OFFSET bytes of headroom before the payload
+**                  and is owned by BTA JV from this call on.
 **
 ** Returns          BTA_JV_SUCCESS, if the request is being processed.
 **                  BTA_JV_FAILURE, otherwise.
@@ -712,7 +718,7 @@ tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id,
 *******************************************************************************/
 tBTA_JV_STATUS BTA_JvL2capWriteFixed(UINT16 channel, BD_ADDR *addr, UINT32 req_id,
                                                tBTA_JV_L2CAP_CBACK *p_cback,
-                                               UINT8 *p_data, UINT16 len, void *user_data);
+                                               BT_HDR *p_buf, void *user_data);
 
 /*******************************************************************************
 **
@@ -1379,10 +1379,8 @@ void bta_jv_l2cap_write(tBTA_JV_MSG *p_data)
      * happens around 1 of 4 disconnects, as a disconnect on the server channel causes a disconnect
      * to be send on the client (notification) channel, but at the peer typically disconnects both
      * the OBEX disconnect request crosses the incoming l2cap disconnect.
-     * If p_cback is cleared, we simply discard the data.
-     * RISK: The caller must handle any cleanup based on another signal than BTA_JV_L2CAP_WRITE_EVT,
-     *       which is typically not possible, as the pointer to the allocated buffer is stored
-     *       in this message, and can therefore not be freed, hence we have a mem-leak-by-design.*/
+     * If p_cback is cleared, we simply discard the data. The buffer is owned by this message,
+     * so it is freed here rather than leaked. */
     if (ls->p_cb->p_cback != NULL) {
         evt_data.status = BTA_JV_FAILURE;
         evt_data.handle = ls->handle;
@@ -1390,16 +1388,22 @@ void bta_jv_l2cap_write(tBTA_JV_MSG *p_data)
         evt_data.cong   = ls->p_cb->cong;
         evt_data.len    = 0;
         bta_jv_pm_conn_busy(ls->p_cb->p_pm_cb);
-        if (!evt_data.cong &&
-           BT_PASS == GAP_ConnWriteData(ls->handle, ls->p_data, ls->len, &evt_data.len))
-        {
-           evt_data.status = BTA_JV_SUCCESS;
+        if (evt_data.cong) {
+            osi_free(ls->p_buf);
+        } else {
+            UINT16 len = ls->p_buf->len;
+            /* GAP takes ownership of the buffer, no copy is made */
+            if (BT_PASS == GAP_ConnBTWrite(ls->handle, ls->p_buf)) {
+                evt_data.status = BTA_JV_SUCCESS;
+                evt_data.len = len;
+            }
         }
         ls->p_cb->p_cback(BTA_JV_L2CAP_WRITE_EVT, (tBTA_JV *)&evt_data, ls->user_data);
     } else {
         /* As this pointer is checked in the API function, this occurs only when the channel is
          * disconnected after the API function is called, but before the message is handled. */
         APPL_TRACE_ERROR("%s() ls->p_cb->p_cback == NULL", __func__);
+        osi_free(ls->p_buf);
     }
 }
 
@@ -1416,20 +1420,15 @@ void bta_jv_l2cap_write_fixed(tBTA_JV_MSG *p_data)
 {
     tBTA_JV_L2CAP_WRITE_FIXED evt_data;
     tBTA_JV_API_L2CAP_WRITE_FIXED *ls = &(p_data->l2cap_write_fixed);
-    BT_HDR *msg = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + ls->len + L2CAP_MIN_OFFSET);
 
     evt_data.status  = BTA_JV_FAILURE;
     evt_data.channel = ls->channel;
     memcpy(evt_data.addr, ls->addr, sizeof(evt_data.addr));
     evt_data.req_id  = ls->req_id;
-    evt_data.len     = 0;
-
-
-    memcpy(((uint8_t*)(msg + 1)) + L2CAP_MIN_OFFSET, ls->p_data, ls->len);
-    msg->len = ls->len;
-    msg->offset = L2CAP_MIN_OFFSET;
+    evt_data.len     = ls->p_buf->len;
 
-    L2CA_SendFixedChnlData(ls->channel, ls->addr, msg);
+    /* L2CAP takes ownership of the buffer, no copy is made */
+    L2CA_SendFixedChnlData(ls->channel, ls->addr, ls->p_buf);
 
     ls->p_cback(BTA_JV_L2CAP_WRITE_FIXED_EVT, (tBTA_JV *)&evt_data, ls->user_data);
 }
@@ -685,14 +685,15 @@ tBTA_JV_STATUS BTA_JvL2capReady(UINT32 handle, UINT32 *p_data_size)
 ** Description      This function writes data to an L2CAP connection
 **                  When the operation is complete, tBTA_JV_L2CAP_CBACK is
 **                  called with BTA_JV_L2CAP_WRITE_EVT. Works for
-**                  PSM-based connections
+**                  PSM-based connections. BTA JV takes ownership of |p_buf|
+**                  and frees it if the request fails.
 **
 ** Returns          BTA_JV_SUCCESS, if the request is being processed.
 **                  BTA_JV_FAILURE, otherwise.
 **
 *******************************************************************************/
-tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id, UINT8 *p_data,
-        UINT16 len, void *user_data)
+tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id, BT_HDR *p_buf,
+        void *user_data)
 {
     tBTA_JV_STATUS status = BTA_JV_FAILURE;
 
@@ -700,18 +701,19 @@ tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id, UINT8 *p_data,
 
     if (handle < BTA_JV_MAX_L2C_CONN && bta_jv_cb.l2c_cb[handle].p_cback) {
         tBTA_JV_API_L2CAP_WRITE *p_msg =
-            (tBTA_JV_API_L2CAP_WRITE *)osi_malloc(sizeof(tBTA_JV_API_L2CAP_WRITE));
+            (tBTA_JV_API_L2CAP_WRITE *)bta_sys_alloc_msg(sizeof(tBTA_JV_API_L2CAP_WRITE));
         p_msg->hdr.event = BTA_JV_API_L2CAP_WRITE_EVT;
         p_msg->handle = handle;
         p_msg->req_id = req_id;
-        p_msg->p_data = p_data;
+        p_msg->p_buf = p_buf;
         p_msg->p_cb = &bta_jv_cb.l2c_cb[handle];
-        p_msg->len = len;
         p_msg->user_data = user_data;
 
         bta_sys_sendmsg(p_msg);
 
         status = BTA_JV_SUCCESS;
+    } else {
+        osi_free(p_buf);
     }
 
     return status;
@@ -731,10 +733,10 @@ tBTA_JV_STATUS BTA_JvL2capWrite(UINT32 handle, UINT32 req_id, UINT8 *p_data,
 **
 *******************************************************************************/
 tBTA_JV_STATUS BTA_JvL2capWriteFixed(UINT16 channel, BD_ADDR *addr, UINT32 req_id,
-        tBTA_JV_L2CAP_CBACK *p_cback, UINT8 *p_data, UINT16 len, void *user_data)
+        tBTA_JV_L2CAP_CBACK *p_cback, BT_HDR *p_buf, void *user_data)
 {
     tBTA_JV_API_L2CAP_WRITE_FIXED *p_msg =
-        (tBTA_JV_API_L2CAP_WRITE_FIXED *)osi_malloc(sizeof(tBTA_JV_API_L2CAP_WRITE_FIXED));
+        (tBTA_JV_API_L2CAP_WRITE_FIXED *)bta_sys_alloc_msg(sizeof(tBTA_JV_API_L2CAP_WRITE_FIXED));
 
     APPL_TRACE_API("%s", __func__);
 
@@ -742,9 +744,8 @@ tBTA_JV_STATUS BTA_JvL2capWriteFixed(UINT16 channel, BD_ADDR *addr, UINT32 req_i
     p_msg->channel = channel;
     memcpy(p_msg->addr, addr, sizeof(p_msg->addr));
     p_msg->req_id = req_id;
-    p_msg->p_data = p_data;
+    p_msg->p_buf = p_buf;
     p_msg->p_cback = p_cback;
-    p_msg->len = len;
     p_msg->user_data = user_data;
 
     bta_sys_sendmsg(p_msg);
@@ -943,7 +944,7 @@ tBTA_JV_STATUS BTA_JvRfcommWrite(UINT32 handle, UINT32 req_id)
     if (hi < BTA_JV_MAX_RFC_CONN && bta_jv_cb.rfc_cb[hi].p_cback &&
         si < BTA_JV_MAX_RFC_SR_SESSION && bta_jv_cb.rfc_cb[hi].rfc_hdl[si]) {
         tBTA_JV_API_RFCOMM_WRITE *p_msg =
-            (tBTA_JV_API_RFCOMM_WRITE *)osi_malloc(sizeof(tBTA_JV_API_RFCOMM_WRITE));
+            (tBTA_JV_API_RFCOMM_WRITE *)bta_sys_alloc_msg(sizeof(tBTA_JV_API_RFCOMM_WRITE));
         p_msg->hdr.event = BTA_JV_API_RFCOMM_WRITE_EVT;
         p_msg->handle = handle;
         p_msg->req_id = req_id;
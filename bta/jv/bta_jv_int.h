@@ -229,8 +229,7 @@ typedef struct
     UINT32              handle;
     UINT32              req_id;
     tBTA_JV_L2C_CB      *p_cb;
-    UINT8               *p_data;
-    UINT16              len;
+    BT_HDR              *p_buf;
     void                *user_data;
 } tBTA_JV_API_L2CAP_WRITE;
 
@@ -242,8 +241,7 @@ typedef struct
     BD_ADDR             addr;
     UINT32              req_id;
     tBTA_JV_L2CAP_CBACK *p_cback;
-    UINT8               *p_data;
-    UINT16              len;
+    BT_HDR              *p_buf;
     void                *user_data;
 } tBTA_JV_API_L2CAP_WRITE_FIXED;
 
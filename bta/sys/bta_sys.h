@@ -211,6 +211,13 @@ typedef UINT8 tBTA_SYS_HW_EVT;
 /* HW enable callback type */
 typedef void (tBTA_SYS_HW_CBACK)(tBTA_SYS_HW_EVT status);
 
+/* BTA system message allocation counters */
+typedef struct
+{
+    UINT32  pool_allocs;    /* messages served from the pre-allocated pools */
+    UINT32  heap_allocs;    /* messages too large for, or allocated while, the pools were exhausted */
+} tBTA_SYS_MSG_STATS;
+
 /*****************************************************************************
 **  Function declarations
 *****************************************************************************/
@@ -228,6 +235,9 @@ extern void bta_sys_deregister(UINT8 id);
 extern BOOLEAN bta_sys_is_register(UINT8 id);
 extern UINT16 bta_sys_get_sys_features(void);
 extern void bta_sys_sendmsg(void *p_msg);
+extern void *bta_sys_alloc_msg(size_t size);
+extern void bta_sys_free_msg(void *p_msg);
+extern void bta_sys_get_msg_stats(tBTA_SYS_MSG_STATS *p_stats);
 extern void bta_sys_start_timer(alarm_t *alarm, period_ms_t interval,
                                 uint16_t event, uint16_t layer_specific);
 extern void bta_sys_disable(tBTA_SYS_HW_MODULE module);
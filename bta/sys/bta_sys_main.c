@@ -39,6 +39,7 @@
 #include "osi/include/hash_map.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/profiler.h"
 #include "osi/include/thread.h"
 #include "utl.h"
 
@@ -54,6 +55,9 @@ tBTA_SYS_CB bta_sys_cb;
 fixed_queue_t *btu_bta_alarm_queue;
 extern thread_t *bt_workqueue_thread;
 
+/* Run time of bta_sys_event, by event */
+static profiler_events_t *bta_sys_event_profile;
+
 /* trace level */
 /* TODO Hard-coded trace levels -  Needs to be configurable */
 UINT8 appl_trace_level = BT_TRACE_LEVEL_WARNING; //APPL_INITIAL_TRACE_LEVEL;
@@ -177,6 +181,8 @@ void bta_sys_init(void)
 
     btu_bta_alarm_queue = fixed_queue_new(SIZE_MAX);
 
+    bta_sys_event_profile = profiler_events_new("bta_sys_event");
+
     alarm_register_processing_queue(btu_bta_alarm_queue, bt_workqueue_thread);
 
     appl_trace_level = APPL_INITIAL_TRACE_LEVEL;
@@ -194,9 +200,17 @@ void bta_sys_init(void)
 }
 
 void bta_sys_free(void) {
+    tBTA_SYS_MSG_STATS stats;
+    bta_sys_get_msg_stats(&stats);
+    APPL_TRACE_DEBUG("%s messages from pools %u, from heap %u", __func__,
+                     stats.pool_allocs, stats.heap_allocs);
+
     alarm_unregister_processing_queue(btu_bta_alarm_queue);
     fixed_queue_free(btu_bta_alarm_queue, NULL);
     btu_bta_alarm_queue = NULL;
+
+    profiler_events_free(bta_sys_event_profile);
+    bta_sys_event_profile = NULL;
 }
 
 /*******************************************************************************
@@ -485,9 +499,12 @@ void bta_sys_event(BT_HDR *p_msg)
 {
     UINT8       id;
     BOOLEAN     freebuf = TRUE;
+    profiler_scope_t scope;
 
     APPL_TRACE_EVENT("BTA got event 0x%x", p_msg->event);
 
+    profiler_event_begin(bta_sys_event_profile, p_msg->event, &scope);
+
     /* get subsystem id from event */
     id = (UINT8) (p_msg->event >> 8);
 
@@ -503,9 +520,10 @@ void bta_sys_event(BT_HDR *p_msg)
 
     if (freebuf)
     {
-        osi_free(p_msg);
+        bta_sys_free_msg(p_msg);
     }
 
+    profiler_event_end(&scope);
 }
 
 /*******************************************************************************
@@ -574,9 +592,12 @@ void bta_sys_sendmsg(void *p_msg)
     // There is a race condition that occurs if the stack is shut down while
     // there is a procedure in progress that can schedule a task via this
     // message queue. This causes |btu_bta_msg_queue| to get cleaned up before
-    // it gets used here; hence we check for NULL before using it.
+    // it gets used here; hence we check for NULL before using it. The message
+    // is then dropped, and freed since nothing else will.
     if (btu_bta_msg_queue)
         fixed_queue_enqueue(btu_bta_msg_queue, p_msg);
+    else
+        bta_sys_free_msg(p_msg);
 }
 
 /*******************************************************************************
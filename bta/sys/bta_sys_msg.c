@@ -0,0 +1,216 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Pools of pre-allocated BTA system messages.
+ *
+ *  Each size class is a fixed array of blocks. Free blocks are kept on a
+ *  lock-free stack, since messages are allocated by API callers on any
+ *  thread and freed on the BTU thread once they have been handled. A tag
+ *  in the upper half of the stack head protects against ABA when a block
+ *  is popped and pushed back while another thread is popping it.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bt_common.h"
+#include "bt_target.h"
+#include "bta_sys.h"
+#include "osi/include/osi.h"
+
+/* Blocks are 8 byte aligned so that any message structure fits */
+#define BTA_SYS_MSG_SMALL_SIZE      64
+#define BTA_SYS_MSG_MEDIUM_SIZE     256
+#define BTA_SYS_MSG_LARGE_SIZE      768
+
+#define BTA_SYS_MSG_POOL_WORDS(size, num) ((num) > 0 ? (size) * (num) / 8 : 1)
+
+typedef struct
+{
+    UINT16      size;       /* bytes in each block */
+    UINT16      num;        /* number of blocks */
+    UINT8       *p_blocks;
+    UINT32      *p_next;    /* index + 1 of the next free block, 0 for none */
+    uint64_t    head;       /* tag << 32 | index + 1 of the first free block */
+    UINT32      carved;     /* blocks handed out at least once */
+} tBTA_SYS_MSG_POOL;
+
+static uint64_t bta_sys_msg_small[BTA_SYS_MSG_POOL_WORDS(BTA_SYS_MSG_SMALL_SIZE,
+                                                          BTA_SYS_MSG_POOL_SMALL_NUM)];
+static uint64_t bta_sys_msg_medium[BTA_SYS_MSG_POOL_WORDS(BTA_SYS_MSG_MEDIUM_SIZE,
+                                                           BTA_SYS_MSG_POOL_MEDIUM_NUM)];
+static uint64_t bta_sys_msg_large[BTA_SYS_MSG_POOL_WORDS(BTA_SYS_MSG_LARGE_SIZE,
+                                                          BTA_SYS_MSG_POOL_LARGE_NUM)];
+
+static UINT32 bta_sys_msg_small_next[BTA_SYS_MSG_POOL_SMALL_NUM + 1];
+static UINT32 bta_sys_msg_medium_next[BTA_SYS_MSG_POOL_MEDIUM_NUM + 1];
+static UINT32 bta_sys_msg_large_next[BTA_SYS_MSG_POOL_LARGE_NUM + 1];
+
+/* Smallest size class first */
+static tBTA_SYS_MSG_POOL bta_sys_msg_pools[] =
+{
+    { BTA_SYS_MSG_SMALL_SIZE, BTA_SYS_MSG_POOL_SMALL_NUM,
+      (UINT8 *)bta_sys_msg_small, bta_sys_msg_small_next, 0, 0 },
+    { BTA_SYS_MSG_MEDIUM_SIZE, BTA_SYS_MSG_POOL_MEDIUM_NUM,
+      (UINT8 *)bta_sys_msg_medium, bta_sys_msg_medium_next, 0, 0 },
+    { BTA_SYS_MSG_LARGE_SIZE, BTA_SYS_MSG_POOL_LARGE_NUM,
+      (UINT8 *)bta_sys_msg_large, bta_sys_msg_large_next, 0, 0 },
+};
+
+static tBTA_SYS_MSG_STATS bta_sys_msg_stats;
+
+/*******************************************************************************
+**
+** Function         bta_sys_msg_pool_get
+**
+** Description      Takes a block from |p_pool|.
+**
+** Returns          The block, or NULL if every block is in use.
+**
+*******************************************************************************/
+static void *bta_sys_msg_pool_get(tBTA_SYS_MSG_POOL *p_pool)
+{
+    uint64_t head = __atomic_load_n(&p_pool->head, __ATOMIC_ACQUIRE);
+    UINT32 top;
+
+    do
+    {
+        top = (UINT32)head;
+        if (top == 0)
+        {
+            /* Nothing has been freed yet; hand out a block never used before */
+            UINT32 index = __atomic_fetch_add(&p_pool->carved, 1, __ATOMIC_RELAXED);
+            if (index >= p_pool->num)
+            {
+                __atomic_store_n(&p_pool->carved, p_pool->num, __ATOMIC_RELAXED);
+                return NULL;
+            }
+            return p_pool->p_blocks + (size_t)index * p_pool->size;
+        }
+
+        UINT32 next = __atomic_load_n(&p_pool->p_next[top - 1], __ATOMIC_RELAXED);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (__atomic_compare_exchange_n(&p_pool->head, &head, new_head, TRUE,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            break;
+    } while (TRUE);
+
+    return p_pool->p_blocks + (size_t)(top - 1) * p_pool->size;
+}
+
+/*******************************************************************************
+**
+** Function         bta_sys_msg_pool_put
+**
+** Description      Returns the block at |index| to |p_pool|.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_sys_msg_pool_put(tBTA_SYS_MSG_POOL *p_pool, UINT32 index)
+{
+    uint64_t head = __atomic_load_n(&p_pool->head, __ATOMIC_RELAXED);
+    uint64_t new_head;
+
+    do
+    {
+        __atomic_store_n(&p_pool->p_next[index], (UINT32)head, __ATOMIC_RELAXED);
+        new_head = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!__atomic_compare_exchange_n(&p_pool->head, &head, new_head, TRUE,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*******************************************************************************
+**
+** Function         bta_sys_alloc_msg
+**
+** Description      Allocates a zeroed message of |size| bytes to be sent with
+**                  bta_sys_sendmsg. Messages up to the largest size class
+**                  come from the pools when a block is free, otherwise from
+**                  the heap. The message must be released with
+**                  bta_sys_free_msg, which bta_sys_event does once the
+**                  handler is done with it.
+**
+** Returns          The message.
+**
+*******************************************************************************/
+void *bta_sys_alloc_msg(size_t size)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(bta_sys_msg_pools); i++)
+    {
+        tBTA_SYS_MSG_POOL *p_pool = &bta_sys_msg_pools[i];
+        if (size > p_pool->size)
+            continue;
+
+        void *p_msg = bta_sys_msg_pool_get(p_pool);
+        if (p_msg != NULL)
+        {
+            __atomic_fetch_add(&bta_sys_msg_stats.pool_allocs, 1, __ATOMIC_RELAXED);
+            memset(p_msg, 0, size);
+            return p_msg;
+        }
+    }
+
+    __atomic_fetch_add(&bta_sys_msg_stats.heap_allocs, 1, __ATOMIC_RELAXED);
+    return osi_calloc(size);
+}
+
+/*******************************************************************************
+**
+** Function         bta_sys_free_msg
+**
+** Description      Frees a message allocated with bta_sys_alloc_msg, or any
+**                  other buffer allocated with osi_malloc or osi_calloc.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_sys_free_msg(void *p_msg)
+{
+    const UINT8 *p = (const UINT8 *)p_msg;
+
+    for (size_t i = 0; i < ARRAY_SIZE(bta_sys_msg_pools); i++)
+    {
+        tBTA_SYS_MSG_POOL *p_pool = &bta_sys_msg_pools[i];
+        if (p >= p_pool->p_blocks &&
+            p < p_pool->p_blocks + (size_t)p_pool->num * p_pool->size)
+        {
+            bta_sys_msg_pool_put(p_pool, (UINT32)((p - p_pool->p_blocks) / p_pool->size));
+            return;
+        }
+    }
+
+    osi_free(p_msg);
+}
+
+/*******************************************************************************
+**
+** Function         bta_sys_get_msg_stats
+**
+** Description      Copies the message allocation counters to |p_stats|.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_sys_get_msg_stats(tBTA_SYS_MSG_STATS *p_stats)
+{
+    p_stats->pool_allocs = __atomic_load_n(&bta_sys_msg_stats.pool_allocs, __ATOMIC_RELAXED);
+    p_stats->heap_allocs = __atomic_load_n(&bta_sys_msg_stats.heap_allocs, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,238 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "bt_common.h"
+#include "bta_gattc_int.h"
+#include "btm_int.h"
+#include "osi/include/list.h"
+#include "sdp_api.h"
+
+// bta_gattc_cache.c is linked on its own. The lookups under test reach
+// none of the rest of the stack, so these only satisfy the linker.
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+UINT8 btif_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...) {
+}
+
+tGATT_STATUS GATTC_Discover(UINT16 conn_id, tGATT_DISC_TYPE disc_type,
+                            tGATT_DISC_PARAM *p_param) {
+  return GATT_ERROR;
+}
+
+BOOLEAN SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB *p_db, UINT32 len, UINT16 num_uuid,
+                            tSDP_UUID *p_uuid_list, UINT16 num_attr, UINT16 *p_attr_list) {
+  return FALSE;
+}
+
+BOOLEAN SDP_ServiceSearchAttributeRequest2(UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
+                                           tSDP_DISC_CMPL_CB2 *p_cb, void *user_data) {
+  return FALSE;
+}
+
+tSDP_DISC_REC *SDP_FindServiceInDb(tSDP_DISCOVERY_DB *p_db, UINT16 service_uuid,
+                                   tSDP_DISC_REC *p_start_rec) {
+  return NULL;
+}
+
+BOOLEAN SDP_FindProtocolListElemInRec(tSDP_DISC_REC *p_rec, UINT16 layer_uuid,
+                                      tSDP_PROTOCOL_ELEM *p_elem) {
+  return FALSE;
+}
+
+BOOLEAN SDP_FindServiceUUIDInRec(tSDP_DISC_REC *p_rec, tBT_UUID *p_uuid) {
+  return FALSE;
+}
+
+tBTA_GATTC_CLCB *bta_gattc_find_clcb_by_conn_id(UINT16 conn_id) {
+  return NULL;
+}
+
+tBTA_GATTC_SERV *bta_gattc_find_scb_by_cid(UINT16 conn_id) {
+  return NULL;
+}
+
+void bta_gattc_reset_discover_st(tBTA_GATTC_SERV *p_srcb, tBTA_GATT_STATUS status) {
+}
+
+BOOLEAN bta_gattc_sm_execute(tBTA_GATTC_CLCB *p_clcb, UINT16 event, tBTA_GATTC_DATA *p_data) {
+  return FALSE;
+}
+
+BOOLEAN bta_gattc_uuid_compare(const tBT_UUID *p_src, const tBT_UUID *p_tar,
+                               BOOLEAN is_precise) {
+  return FALSE;
+}
+
+void bta_to_btif_uuid(bt_uuid_t *p_dest, tBT_UUID *p_src) {
+}
+
+BOOLEAN btm_sec_is_a_bonded_dev(BD_ADDR bda) {
+  return FALSE;
+}
+
+}  // extern "C"
+
+// A large server: 16 services of 24 characteristics, each with two
+// descriptors.
+static const UINT16 NUM_SERVICES = 16;
+static const UINT16 CHARS_PER_SERVICE = 24;
+static const UINT16 DESCRS_PER_CHAR = 2;
+
+// Lookups of every handle in the database per benchmark run.
+static const int BENCH_ROUNDS = 200;
+
+namespace {
+
+tBTA_GATTC_NV_ATTR nv_attr(UINT8 type, UINT16 s_handle, UINT16 e_handle, UINT16 uuid16) {
+  tBTA_GATTC_NV_ATTR attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.attr_type = type;
+  attr.s_handle = s_handle;
+  attr.e_handle = e_handle;
+  attr.uuid.len = LEN_UUID_16;
+  attr.uuid.uu.uuid16 = uuid16;
+  attr.is_primary = TRUE;
+  attr.prop = GATT_CHAR_PROP_BIT_READ;
+  return attr;
+}
+
+// Lays the database out as a server does: each characteristic is a
+// declaration, then its value, then its descriptors.
+std::vector<tBTA_GATTC_NV_ATTR> synthetic_database() {
+  const UINT16 handles_per_char = 2 + DESCRS_PER_CHAR;
+  const UINT16 handles_per_service = 1 + CHARS_PER_SERVICE * handles_per_char;
+  std::vector<tBTA_GATTC_NV_ATTR> attrs;
+  UINT16 handle = 1;
+
+  for (UINT16 s = 0; s < NUM_SERVICES; ++s) {
+    attrs.push_back(nv_attr(BTA_GATTC_ATTR_TYPE_SRVC, handle,
+                            handle + handles_per_service - 1, 0x1800 + s));
+    handle++;
+    for (UINT16 c = 0; c < CHARS_PER_SERVICE; ++c) {
+      attrs.push_back(nv_attr(BTA_GATTC_ATTR_TYPE_CHAR, handle + 1, 0, 0x2a00 + c));
+      handle += 2;
+      for (UINT16 d = 0; d < DESCRS_PER_CHAR; ++d)
+        attrs.push_back(nv_attr(BTA_GATTC_ATTR_TYPE_CHAR_DESCR, handle++, 0, 0x2900 + d));
+    }
+  }
+  return attrs;
+}
+
+}  // namespace
+
+class BtaGattcCacheTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      memset(&srcb_, 0, sizeof(srcb_));
+
+      std::vector<tBTA_GATTC_NV_ATTR> attrs = synthetic_database();
+      last_handle_ = attrs.back().s_handle;
+      bta_gattc_rebuild_cache(&srcb_, attrs.size(), attrs.data());
+      ASSERT_TRUE(srcb_.p_attr_index != NULL);
+
+      // The same cache without its index, so lookups walk the lists.
+      unindexed_ = srcb_;
+      unindexed_.p_srvc_index = NULL;
+      unindexed_.p_attr_index = NULL;
+      unindexed_.num_srvc_index = 0;
+      unindexed_.num_attr_index = 0;
+    }
+
+    virtual void TearDown() {
+      bta_gattc_free_srvc_cache(&srcb_);
+      AllocationTestHarness::TearDown();
+    }
+
+    // Looks every handle up as a characteristic and as a descriptor, and
+    // returns how many were found.
+    size_t LookUpAll(tBTA_GATTC_SERV *p_srcb) {
+      size_t found = 0;
+      for (UINT16 handle = 0; handle <= last_handle_; ++handle) {
+        found += bta_gattc_get_characteristic_srcb(p_srcb, handle) != NULL;
+        found += bta_gattc_get_descriptor_srcb(p_srcb, handle) != NULL;
+      }
+      return found;
+    }
+
+    tBTA_GATTC_SERV srcb_;
+    tBTA_GATTC_SERV unindexed_;
+    UINT16 last_handle_;
+};
+
+TEST_F(BtaGattcCacheTest, test_indexed_lookups_match_list_walk) {
+  EXPECT_EQ(NUM_SERVICES, srcb_.num_srvc_index);
+  EXPECT_EQ(NUM_SERVICES * CHARS_PER_SERVICE * (1 + DESCRS_PER_CHAR), srcb_.num_attr_index);
+
+  size_t chars = 0, descrs = 0;
+  for (UINT16 handle = 0; handle <= last_handle_ + 2; ++handle) {
+    tBTA_GATTC_CHARACTERISTIC *p_char = bta_gattc_get_characteristic_srcb(&srcb_, handle);
+    EXPECT_EQ(bta_gattc_get_characteristic_srcb(&unindexed_, handle), p_char)
+        << "handle " << handle;
+    if (p_char) {
+      EXPECT_EQ(handle, p_char->handle);
+      chars++;
+    }
+
+    tBTA_GATTC_DESCRIPTOR *p_desc = bta_gattc_get_descriptor_srcb(&srcb_, handle);
+    EXPECT_EQ(bta_gattc_get_descriptor_srcb(&unindexed_, handle), p_desc)
+        << "handle " << handle;
+    if (p_desc) {
+      EXPECT_EQ(handle, p_desc->handle);
+      descrs++;
+    }
+
+    EXPECT_EQ(bta_gattc_get_service_for_handle_srcb(&unindexed_, handle),
+              bta_gattc_get_service_for_handle_srcb(&srcb_, handle))
+        << "handle " << handle;
+  }
+  EXPECT_EQ((size_t)NUM_SERVICES * CHARS_PER_SERVICE, chars);
+  EXPECT_EQ((size_t)NUM_SERVICES * CHARS_PER_SERVICE * DESCRS_PER_CHAR, descrs);
+}
+
+TEST_F(BtaGattcCacheTest, test_benchmark_handle_lookup) {
+  const size_t lookups = 2 * (size_t)(last_handle_ + 1) * BENCH_ROUNDS;
+
+  auto start = std::chrono::steady_clock::now();
+  size_t found = 0;
+  for (int i = 0; i < BENCH_ROUNDS; ++i)
+    found += LookUpAll(&srcb_);
+  const double indexed_ns = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count() / lookups;
+
+  start = std::chrono::steady_clock::now();
+  size_t walked = 0;
+  for (int i = 0; i < BENCH_ROUNDS; ++i)
+    walked += LookUpAll(&unindexed_);
+  const double walk_ns = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count() / lookups;
+
+  EXPECT_EQ(walked, found);
+  printf("GATTC cache lookup over %u handles: %.1f ns indexed, %.1f ns walking the lists\n",
+         last_handle_, indexed_ns, walk_ns);
+}
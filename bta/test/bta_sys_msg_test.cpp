@@ -0,0 +1,274 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "bt_common.h"
+#include "bta_gattc_int.h"
+#include "bta_sys.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/osi.h"
+}
+
+static const size_t POOL_BLOCKS = BTA_SYS_MSG_POOL_SMALL_NUM +
+                                  BTA_SYS_MSG_POOL_MEDIUM_NUM +
+                                  BTA_SYS_MSG_POOL_LARGE_NUM;
+
+// Larger than the largest size class in bta_sys_msg.c.
+static const size_t HEAP_ONLY_SIZE = 1024;
+
+// Message sizes of a small API request, a GATTC write of a default MTU
+// value, a long GATTC write and an RFCOMM sized one.
+static const size_t MSG_SIZES[] = { 24, 68, 200, 560 };
+
+static const int PRODUCERS = 4;
+static const int MSGS_PER_PRODUCER = 20000;
+
+// At most this many messages are queued to the consumer at once, like
+// requests waiting on the BTU thread during a write flood.
+static const size_t QUEUE_DEPTH = 16;
+
+static const int FLOOD_WRITES = 100000;
+
+namespace {
+
+typedef void *(*alloc_fn)(size_t size);
+typedef void (*free_fn)(void *p_msg);
+
+struct TestMsg {
+  size_t size;
+  int producer;
+  int seq;
+};
+
+// Fills the body of |p_msg| with a byte derived from its header.
+UINT8 test_msg_fill(const TestMsg *p_msg) {
+  return (UINT8)(p_msg->seq * PRODUCERS + p_msg->producer + 1);
+}
+
+// Returns whether the body of |p_msg| still holds its fill.
+bool test_msg_intact(const TestMsg *p_msg) {
+  const UINT8 *p = (const UINT8 *)(p_msg + 1);
+  for (size_t i = 0; i < p_msg->size - sizeof(TestMsg); ++i) {
+    if (p[i] != test_msg_fill(p_msg))
+      return false;
+  }
+  return true;
+}
+
+void *heap_alloc(size_t size) {
+  return osi_calloc(size);
+}
+
+void heap_free(void *p_msg) {
+  osi_free(p_msg);
+}
+
+// Builds the message BTA_GATTC_WriteCharValue() sends for a |len| byte value.
+tBTA_GATTC_API_WRITE *gattc_write_msg(alloc_fn alloc, const UINT8 *p_value,
+                                      UINT16 len) {
+  tBTA_GATTC_API_WRITE *p_buf =
+      (tBTA_GATTC_API_WRITE *)alloc(sizeof(tBTA_GATTC_API_WRITE) + len);
+
+  p_buf->hdr.event = BTA_GATTC_API_WRITE_EVT;
+  p_buf->hdr.layer_specific = 1;
+  p_buf->auth_req = BTA_GATT_AUTH_REQ_NONE;
+  p_buf->handle = 0x2a;
+  p_buf->cmpl_evt = BTA_GATTC_WRITE_CHAR_EVT;
+  p_buf->write_type = BTA_GATTC_TYPE_WRITE_NO_RSP;
+  p_buf->len = len;
+  p_buf->p_value = (UINT8 *)(p_buf + 1);
+  memcpy(p_buf->p_value, p_value, len);
+  return p_buf;
+}
+
+// Floods a GATTC client with |FLOOD_WRITES| writes of |len| bytes from one
+// thread while another frees them as bta_sys_event() does, and returns the
+// time per write in nanoseconds.
+double gattc_write_flood(alloc_fn alloc, free_fn free_msg, UINT16 len) {
+  fixed_queue_t *queue = fixed_queue_new(QUEUE_DEPTH);
+  std::vector<UINT8> value(len, 0x5a);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::thread btu([&]() {
+    for (int i = 0; i < FLOOD_WRITES; ++i)
+      free_msg(fixed_queue_dequeue(queue));
+  });
+  for (int i = 0; i < FLOOD_WRITES; ++i)
+    fixed_queue_enqueue(queue, gattc_write_msg(alloc, value.data(), len));
+  btu.join();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  fixed_queue_free(queue, NULL);
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             elapsed).count() / FLOOD_WRITES;
+}
+
+}  // namespace
+
+class BtaSysMsgTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    bta_sys_get_msg_stats(&start_stats);
+  }
+
+  UINT32 pool_allocs() {
+    tBTA_SYS_MSG_STATS stats;
+    bta_sys_get_msg_stats(&stats);
+    return stats.pool_allocs - start_stats.pool_allocs;
+  }
+
+  UINT32 heap_allocs() {
+    tBTA_SYS_MSG_STATS stats;
+    bta_sys_get_msg_stats(&stats);
+    return stats.heap_allocs - start_stats.heap_allocs;
+  }
+
+  tBTA_SYS_MSG_STATS start_stats;
+};
+
+TEST_F(BtaSysMsgTest, test_alloc_is_zeroed) {
+  for (size_t size : MSG_SIZES) {
+    UINT8 *p_msg = (UINT8 *)bta_sys_alloc_msg(size);
+    memset(p_msg, 0xff, size);
+    bta_sys_free_msg(p_msg);
+
+    // The block just freed is the first one handed out again.
+    p_msg = (UINT8 *)bta_sys_alloc_msg(size);
+    for (size_t i = 0; i < size; ++i)
+      ASSERT_EQ(0, p_msg[i]);
+    bta_sys_free_msg(p_msg);
+  }
+  EXPECT_EQ(2 * ARRAY_SIZE(MSG_SIZES), pool_allocs());
+  EXPECT_EQ(0u, heap_allocs());
+}
+
+TEST_F(BtaSysMsgTest, test_exhausted_pools_fall_back_to_heap) {
+  // Small messages spill into the larger size classes before the heap.
+  std::vector<void *> msgs;
+  for (size_t i = 0; i < POOL_BLOCKS; ++i)
+    msgs.push_back(bta_sys_alloc_msg(MSG_SIZES[0]));
+  EXPECT_EQ(POOL_BLOCKS, pool_allocs());
+  EXPECT_EQ(0u, heap_allocs());
+  EXPECT_EQ(POOL_BLOCKS, std::set<void *>(msgs.begin(), msgs.end()).size());
+
+  void *p_heap = bta_sys_alloc_msg(MSG_SIZES[0]);
+  EXPECT_EQ(POOL_BLOCKS, pool_allocs());
+  EXPECT_EQ(1u, heap_allocs());
+  EXPECT_EQ(0u, std::set<void *>(msgs.begin(), msgs.end()).count(p_heap));
+
+  // A heap message is released to the heap, which the harness checks.
+  bta_sys_free_msg(p_heap);
+
+  // Once a block is back, the pools serve again.
+  bta_sys_free_msg(msgs.back());
+  msgs.back() = bta_sys_alloc_msg(MSG_SIZES[0]);
+  EXPECT_EQ(POOL_BLOCKS + 1, pool_allocs());
+  EXPECT_EQ(1u, heap_allocs());
+
+  for (void *p_msg : msgs)
+    bta_sys_free_msg(p_msg);
+}
+
+TEST_F(BtaSysMsgTest, test_large_msg_from_heap) {
+  void *p_msg = bta_sys_alloc_msg(HEAP_ONLY_SIZE);
+  memset(p_msg, 0xff, HEAP_ONLY_SIZE);
+  EXPECT_EQ(0u, pool_allocs());
+  EXPECT_EQ(1u, heap_allocs());
+  bta_sys_free_msg(p_msg);
+}
+
+// API callers allocate on their own threads and the BTU thread frees, which
+// is the case the tagged free list has to get right. A block handed out to
+// two threads at once shows up as an overwritten message, or as a message
+// lost or seen twice in a producer's sequence.
+TEST_F(BtaSysMsgTest, test_concurrent_alloc_free) {
+  fixed_queue_t *queue = fixed_queue_new(QUEUE_DEPTH);
+  std::atomic<int> corrupted(0);
+
+  std::thread btu([&]() {
+    int next_seq[PRODUCERS] = { 0 };
+    for (int i = 0; i < PRODUCERS * MSGS_PER_PRODUCER; ++i) {
+      TestMsg *p_msg = (TestMsg *)fixed_queue_dequeue(queue);
+      if (p_msg->producer < 0 || p_msg->producer >= PRODUCERS ||
+          p_msg->seq != next_seq[p_msg->producer]++ || !test_msg_intact(p_msg))
+        ++corrupted;
+      bta_sys_free_msg(p_msg);
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < PRODUCERS; ++i) {
+    producers.emplace_back([&, i]() {
+      for (int j = 0; j < MSGS_PER_PRODUCER; ++j) {
+        const size_t size = MSG_SIZES[j % ARRAY_SIZE(MSG_SIZES)];
+        TestMsg *p_msg = (TestMsg *)bta_sys_alloc_msg(size);
+        p_msg->size = size;
+        p_msg->producer = i;
+        p_msg->seq = j;
+        memset(p_msg + 1, test_msg_fill(p_msg), size - sizeof(TestMsg));
+
+        // Messages freed right away on the producer's own thread race
+        // with the BTU thread for the head of the same free list.
+        void *p_local = bta_sys_alloc_msg(size);
+        memset(p_local, 0, size);
+        bta_sys_free_msg(p_local);
+
+        if (!test_msg_intact(p_msg))
+          ++corrupted;
+        fixed_queue_enqueue(queue, p_msg);
+      }
+    });
+  }
+
+  for (auto &producer : producers)
+    producer.join();
+  btu.join();
+  fixed_queue_free(queue, NULL);
+
+  EXPECT_EQ(0, corrupted);
+  EXPECT_EQ((UINT32)(2 * PRODUCERS * MSGS_PER_PRODUCER),
+            pool_allocs() + heap_allocs());
+  EXPECT_GT(pool_allocs(), 0u);
+}
+
+// Compares the pools with osi_calloc/osi_free for a GATTC write flood.
+// Timing is only reported, not asserted on.
+TEST_F(BtaSysMsgTest, test_benchmark_gattc_write_flood) {
+  for (UINT16 len : { 20, 244 }) {
+    const double heap_ns = gattc_write_flood(heap_alloc, heap_free, len);
+    const UINT32 pooled_before = pool_allocs();
+    const double pool_ns =
+        gattc_write_flood(bta_sys_alloc_msg, bta_sys_free_msg, len);
+
+    EXPECT_GT(pool_allocs(), pooled_before);
+    printf("GATTC write flood, %u byte values: heap %.0f ns, pools %.0f ns "
+           "per write\n", len, heap_ns, pool_ns);
+  }
+}
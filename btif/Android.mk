@@ -29,6 +29,7 @@ btifCommonSrc := \
 btifCommonSrc += \
   src/btif_av.c \
   src/btif_avrcp_audio_track.cpp \
+  src/btif_bonded_table.c \
   src/btif_config.c \
   src/btif_config_transcode.cpp \
   src/btif_core.c \
@@ -51,6 +52,7 @@ btifCommonSrc += \
   src/btif_pan.c \
   src/btif_profile_queue.c \
   src/btif_rc.c \
+  src/btif_rc_txn.c \
   src/btif_sm.c \
   src/btif_sock.c \
   src/btif_sock_rfc.c \
@@ -85,7 +87,12 @@ btifCommonSrc += \
 
 # Tests
 btifTestSrc := \
-  test/btif_storage_test.cpp
+  ../osi/test/AllocationTestHarness.cpp \
+  test/btif_storage_test.cpp \
+  test/btif_bonded_table_test.cpp \
+  test/btif_sock_thread_test.cpp \
+  test/btif_sock_util_test.cpp \
+  test/btif_rc_txn_test.cpp
 
 # Includes
 btifCommonIncludes := \
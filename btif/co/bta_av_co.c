@@ -28,6 +28,8 @@
  *
  ******************************************************************************/
 
+#include <pthread.h>
+
 #include "string.h"
 #include "a2d_api.h"
 #include "a2d_sbc.h"
@@ -42,7 +44,6 @@
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_util.h"
-#include "osi/include/mutex.h"
 
 #include "bt_utils.h"
 #include "a2d_aptx.h"
@@ -297,6 +298,10 @@ typedef struct
 /* Control block instance */
 static tBTA_AV_CO_CB bta_av_co_cb;
 
+/* Guards the codec configuration and peer capabilities in bta_av_co_cb, which
+ * the BTA and media threads both access */
+static pthread_mutex_t bta_av_co_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
 static BOOLEAN bta_av_co_audio_codec_build_config(const UINT8 *p_codec_caps, UINT8 *p_codec_cfg);
 static void bta_av_co_audio_peer_reset_config(tBTA_AV_CO_PEER *p_peer);
 static BOOLEAN bta_av_co_cp_is_scmst(const UINT8 *p_protectinfo);
@@ -687,7 +692,7 @@ UINT8 bta_av_audio_sink_getconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
         APPL_TRACE_DEBUG("bta_av_audio_sink_getconfig last SRC reached");
 
         /* Protect access to bta_av_co_cb.codec_cfg */
-        mutex_global_lock();
+        pthread_mutex_lock(&bta_av_co_lock);
 
         /* Find a src that matches the codec config */
         if (bta_av_co_audio_peer_src_supports_codec(p_peer, &index))
@@ -720,7 +725,7 @@ UINT8 bta_av_audio_sink_getconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
             }
         }
         /* Protect access to bta_av_co_cb.codec_cfg */
-        mutex_global_unlock();
+        pthread_mutex_unlock(&bta_av_co_lock);
     }
     return result;
 }
@@ -846,7 +851,7 @@ UINT8 bta_av_co_audio_getconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
         APPL_TRACE_DEBUG("bta_av_co_audio_getconfig last sink reached");
 
         /* Protect access to bta_av_co_cb.codec_cfg */
-        mutex_global_lock();
+        pthread_mutex_lock(&bta_av_co_lock);
 
         /* Find a sink that matches the codec config */
         if (bta_av_co_audio_peer_supports_codec(p_peer, &index))
@@ -912,7 +917,7 @@ UINT8 bta_av_co_audio_getconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
             }
         }
         /* Protect access to bta_av_co_cb.codec_cfg */
-        mutex_global_unlock();
+        pthread_mutex_unlock(&bta_av_co_lock);
     }
     return result;
 }
@@ -1005,7 +1010,7 @@ void bta_av_co_audio_setconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
         {
 
             /* Protect access to bta_av_co_cb.codec_cfg */
-            mutex_global_lock();
+            pthread_mutex_lock(&bta_av_co_lock);
 
             /* Check if the configuration matches the current codec config */
             switch (codec_type)
@@ -1094,7 +1099,7 @@ void bta_av_co_audio_setconfig(tBTA_AV_HNDL hndl, tBTA_AV_CODEC codec_type,
                 break;
             }
             /* Protect access to bta_av_co_cb.codec_cfg */
-            mutex_global_unlock();
+            pthread_mutex_unlock(&bta_av_co_lock);
         }
         else
         {
@@ -2127,7 +2132,7 @@ BOOLEAN bta_av_co_audio_codec_supported(tBTIF_STATUS *p_status)
  *******************************************************************************/
 void bta_av_co_audio_codec_reset(void)
 {
-    mutex_global_lock();
+    pthread_mutex_lock(&bta_av_co_lock);
     FUNC_TRACE();
 
     /* Reset the current configuration to SBC */
@@ -2156,7 +2161,7 @@ void bta_av_co_audio_codec_reset(void)
     if (A2D_BldAptx_hdInfo(A2D_MEDIA_TYPE_AUDIO, (tA2D_APTX_HD_CIE *)&btif_av_aptx_hd_default_config, bta_av_co_cb.codec_cfg_aptx_hd.info) != A2D_SUCCESS)
         APPL_TRACE_ERROR("%s A2D_BldAptx_hdInfo failed", __func__);
 
-    mutex_global_unlock();
+    pthread_mutex_unlock(&bta_av_co_lock);
 }
 
 /*******************************************************************************
@@ -2280,6 +2285,9 @@ BOOLEAN bta_av_co_audio_set_codec(const tBTIF_AV_MEDIA_FEEDINGS *p_feeding, tBTI
         break;
     }
 
+    /* Protect access to bta_av_co_cb.codec_cfg */
+    pthread_mutex_lock(&bta_av_co_lock);
+
     /* The new config was correctly built. The default codec is set to be SBC */
     bta_av_co_cb.codec_cfg_sbc = new_cfg_sbc;
     bta_av_co_cb.codec_cfg = &bta_av_co_cb.codec_cfg_sbc;
@@ -2291,7 +2299,10 @@ BOOLEAN bta_av_co_audio_set_codec(const tBTIF_AV_MEDIA_FEEDINGS *p_feeding, tBTI
 
     /* Check all devices support it */
     *p_status = BTIF_SUCCESS;
-    return bta_av_co_audio_codec_supported(p_status);
+    BOOLEAN supported = bta_av_co_audio_codec_supported(p_status);
+
+    pthread_mutex_unlock(&bta_av_co_lock);
+    return supported;
 }
 
 UINT8 bta_av_select_codec(UINT8 hdl)
@@ -2364,7 +2375,7 @@ BOOLEAN bta_av_co_audio_get_codec_config(UINT8 *p_config, UINT16 *p_minmtu, UINT
     /* Minimum MTU is by default very large */
     *p_minmtu = 0xFFFF;
 
-    mutex_global_lock();
+    pthread_mutex_lock(&bta_av_co_lock);
     if (type == BTIF_AV_CODEC_SBC)
     {
         APPL_TRACE_DEBUG("%s SBC", __func__);
@@ -2428,7 +2439,7 @@ BOOLEAN bta_av_co_audio_get_codec_config(UINT8 *p_config, UINT16 *p_minmtu, UINT
             }
         }
     }
-    mutex_global_unlock();
+    pthread_mutex_unlock(&bta_av_co_lock);
 
     return result;
 }
@@ -2455,7 +2466,7 @@ BOOLEAN bta_av_co_audio_get_sbc_config(tA2D_SBC_CIE *p_sbc_config, UINT16 *p_min
     /* Minimum MTU is by default very large */
     *p_minmtu = 0xFFFF;
 
-    mutex_global_lock();
+    pthread_mutex_lock(&bta_av_co_lock);
     if (bta_av_co_cb.codec_cfg->id == BTIF_AV_CODEC_SBC)
     {
         if (A2D_ParsSbcInfo(p_sbc_config, bta_av_co_cb.codec_cfg->info, FALSE) == A2D_SUCCESS)
@@ -2500,7 +2511,7 @@ BOOLEAN bta_av_co_audio_get_sbc_config(tA2D_SBC_CIE *p_sbc_config, UINT16 *p_min
         APPL_TRACE_EVENT("%s Not SBC, still return the default values", __func__);
         *p_sbc_config = btif_av_sbc_default_config;
     }
-    mutex_global_unlock();
+    pthread_mutex_unlock(&bta_av_co_lock);
 
     return result;
 }
@@ -2526,7 +2537,7 @@ BOOLEAN bta_av_co_audio_get_aac_config(tA2D_AAC_CIE *p_aac_config, UINT16 *p_min
     /* Minimum MTU is by default very large */
     *p_minmtu = 0xFFFF;
 
-    mutex_global_lock();
+    pthread_mutex_lock(&bta_av_co_lock);
     if (bta_av_co_cb.codec_cfg->id == BTIF_AV_CODEC_M24)
     {
         if (A2D_ParsAacInfo(p_aac_config, bta_av_co_cb.codec_cfg->info, FALSE) == A2D_SUCCESS)
@@ -2553,7 +2564,7 @@ BOOLEAN bta_av_co_audio_get_aac_config(tA2D_AAC_CIE *p_aac_config, UINT16 *p_min
         APPL_TRACE_EVENT("%s Not SBC, still return the default values", __func__);
         *p_aac_config = btif_av_aac_default_config;
     }
-    mutex_global_unlock();
+    pthread_mutex_unlock(&bta_av_co_lock);
 
     return result;
 }
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_bonded_table.h
+ *
+ *  Description:   In-memory table of bonded devices with their link keys and
+ *                 LE keys decoded from the config
+ *
+ *******************************************************************************/
+
+#ifndef BTIF_BONDED_TABLE_H
+#define BTIF_BONDED_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hardware/bluetooth.h>
+
+#define BONDED_TABLE_LINK_KEY_LEN   16
+
+/* One slot per BTIF_DM_LE_KEY_* type */
+#define BONDED_TABLE_LE_KEY_SLOTS   6
+
+/* Large enough for any of the tBTM_LE_*_KEYS structures */
+#define BONDED_TABLE_LE_KEY_MAX_LEN 32
+
+typedef struct {
+    uint8_t  type;           /* BTIF_DM_LE_KEY_* value, 0 if the slot is free */
+    uint8_t  len;
+    uint8_t  value[BONDED_TABLE_LE_KEY_MAX_LEN];
+} bonded_le_key_t;
+
+/* A device stays in the table while it has a link key or at least one LE
+ * key. */
+typedef struct {
+    bt_bdaddr_t addr;
+    bool     has_link_key;
+    uint8_t  link_key[BONDED_TABLE_LINK_KEY_LEN];
+    uint8_t  link_key_type;
+    uint8_t  pin_length;
+    uint8_t  num_le_keys;
+    bonded_le_key_t le_keys[BONDED_TABLE_LE_KEY_SLOTS];
+} bonded_device_t;
+
+typedef struct bonded_table_t bonded_table_t;
+
+/* Returns a new, empty table. The table must be freed with
+ * |bonded_table_free|. */
+bonded_table_t *bonded_table_new(void);
+
+/* Frees |table| and all of its devices. Accepts NULL. */
+void bonded_table_free(bonded_table_t *table);
+
+/* Removes all devices from |table|. */
+void bonded_table_clear(bonded_table_t *table);
+
+/* Returns the number of bonded devices in |table|. */
+size_t bonded_table_size(const bonded_table_t *table);
+
+/* Returns the device with address |addr|, or NULL if it is not bonded. The
+ * pointer is valid until the device is removed from |table|. */
+const bonded_device_t *bonded_table_get(const bonded_table_t *table,
+                                        const bt_bdaddr_t *addr);
+
+/* Sets the link key of |addr|, adding the device if it was not bonded. */
+bool bonded_table_set_link_key(bonded_table_t *table, const bt_bdaddr_t *addr,
+                               const uint8_t *link_key, uint8_t key_type,
+                               uint8_t pin_length);
+
+/* Sets the LE key of type |key_type| of |addr|, adding the device if it was
+ * not bonded. Returns false if |len| exceeds BONDED_TABLE_LE_KEY_MAX_LEN. */
+bool bonded_table_set_le_key(bonded_table_t *table, const bt_bdaddr_t *addr,
+                             uint8_t key_type, const void *value, size_t len);
+
+/* Removes the link key of |addr|. The device is removed from |table| if it has
+ * no LE keys left. */
+void bonded_table_remove_link_key(bonded_table_t *table,
+                                  const bt_bdaddr_t *addr);
+
+/* Removes all LE keys of |addr|. The device is removed from |table| if it has
+ * no link key. */
+void bonded_table_remove_le_keys(bonded_table_t *table,
+                                 const bt_bdaddr_t *addr);
+
+/* Returns the LE key of type |key_type| of |device|, or NULL if it has none. */
+const bonded_le_key_t *bonded_table_get_le_key(const bonded_device_t *device,
+                                               uint8_t key_type);
+
+/* Copies the addresses of up to |max_addrs| bonded devices into |addrs|, in
+ * the order they were added. Returns the number of addresses copied. */
+size_t bonded_table_get_addrs(const bonded_table_t *table, bt_bdaddr_t *addrs,
+                              size_t max_addrs);
+
+typedef bool (*bonded_table_iter_cb)(const bonded_device_t *device,
+                                     void *context);
+
+/* Calls |callback| with |context| for every bonded device in the order they
+ * were added, until |callback| returns false. |table| must not be modified by
+ * |callback|. */
+void bonded_table_foreach(const bonded_table_t *table,
+                          bonded_table_iter_cb callback, void *context);
+
+#endif
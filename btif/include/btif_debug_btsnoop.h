@@ -42,3 +42,6 @@ void btif_debug_btsnoop_init(void);
 
 // Writes btsnoop data base64 encoded to fd
 void btif_debug_btsnoop_dump(int fd);
+
+// Writes the HCI layer's snoop ring to fd as a base64 encoded btsnoop file
+void btif_debug_btsnoop_ring_dump(int fd);
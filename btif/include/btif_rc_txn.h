@@ -0,0 +1,142 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_rc_txn.h
+ *
+ *  Description:   AVRCP transaction bookkeeping: the AVCTP transaction label
+ *                 pool and coalescing of SetAbsoluteVolume commands
+ *
+ *******************************************************************************/
+
+#ifndef BTIF_RC_TXN_H
+#define BTIF_RC_TXN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* AVCTP transaction labels are 4 bits wide */
+#define RC_LABEL_POOL_SIZE 16
+
+typedef struct {
+    uint8_t  in_use;         /* labels currently allocated */
+    uint8_t  peak_in_use;    /* most labels allocated at the same time */
+    uint32_t allocations;
+    uint32_t releases;
+    uint32_t exhausted;      /* allocations failed because all labels were in use */
+    uint32_t stale_releases; /* releases of labels that were not allocated */
+} rc_label_stats_t;
+
+typedef struct {
+    uint16_t in_use_mask;    /* bit n is set while label n is allocated */
+    uint8_t  next;           /* label to try first on the next allocation */
+    rc_label_stats_t stats;
+} rc_label_pool_t;
+
+/* Frees all labels and clears the statistics of |pool|. */
+void rc_label_pool_init(rc_label_pool_t *pool);
+
+/* Frees all labels of |pool|, keeping the statistics. */
+void rc_label_pool_reset(rc_label_pool_t *pool);
+
+/* Allocates a free label into |label|. Labels are handed out round robin, so
+ * a label that was just released is the last one to be reused and a late
+ * response cannot be mistaken for the reply to a newer command. Returns false
+ * if all labels are in use. */
+bool rc_label_pool_alloc(rc_label_pool_t *pool, uint8_t *label);
+
+/* Releases |label|. Returns false, and counts a stale release, if |label| was
+ * not allocated. */
+bool rc_label_pool_release(rc_label_pool_t *pool, uint8_t label);
+
+bool rc_label_pool_is_allocated(const rc_label_pool_t *pool, uint8_t label);
+
+/* How long a SetAbsoluteVolume command may stay unanswered before it is
+ * abandoned and the pending volume, if any, is sent. */
+#define RC_ABS_VOL_RSP_TIMEOUT_MS 2000
+
+/* Hooks into the AVCT layer used to send SetAbsoluteVolume commands. */
+typedef struct {
+    /* Sends a SetAbsoluteVolume command for |volume| and stores its
+     * transaction label in |label|. Returns false if it could not be sent. */
+    bool (*send)(void *context, uint8_t volume, uint8_t *label);
+
+    /* Gives up on the command sent with |label|, which was not answered in
+     * time. */
+    void (*abandon)(void *context, uint8_t label);
+
+    /* Arms a timer that calls rc_abs_vol_timeout() in |timeout_ms|, replacing
+     * any timer already armed. */
+    void (*start_timer)(void *context, uint32_t timeout_ms);
+
+    /* Disarms the timer armed by |start_timer|. */
+    void (*stop_timer)(void *context);
+} rc_abs_vol_ops_t;
+
+typedef enum {
+    RC_ABS_VOL_SENT,      /* the volume was sent right away */
+    RC_ABS_VOL_QUEUED,    /* the volume is sent once the outstanding command completes */
+    RC_ABS_VOL_FAILED     /* the volume could not be sent */
+} rc_abs_vol_status_t;
+
+/* SetAbsoluteVolume state of one connected device. At most one command is
+ * outstanding; volumes requested in the meantime replace each other and only
+ * the latest is sent once the outstanding command completes. */
+typedef struct {
+    const rc_abs_vol_ops_t *ops;
+    void     *context;
+    bool     outstanding;
+    uint8_t  outstanding_label;
+    uint8_t  outstanding_volume;
+    uint32_t sent_ms;
+    bool     pending;
+    uint8_t  pending_volume;
+    uint32_t coalesced;      /* requested volumes replaced before being sent */
+    uint32_t send_failures;  /* pending volumes that could not be sent */
+} rc_abs_vol_t;
+
+/* Initializes |vol| to send commands through |ops| with |context|. */
+void rc_abs_vol_init(rc_abs_vol_t *vol, const rc_abs_vol_ops_t *ops,
+                     void *context);
+
+/* Returns true while a command is waiting for its response. */
+bool rc_abs_vol_busy(const rc_abs_vol_t *vol);
+
+/* Returns true if |label| belongs to the outstanding command, that is, if a
+ * response with |label| is the one rc_abs_vol_complete() expects. */
+bool rc_abs_vol_is_outstanding(const rc_abs_vol_t *vol, uint8_t label);
+
+/* Requests |volume| at |now_ms|, as returned by time_get_os_boottime_ms(). */
+rc_abs_vol_status_t rc_abs_vol_set(rc_abs_vol_t *vol, uint8_t volume,
+                                   uint32_t now_ms);
+
+/* Handles the response to the command sent with |label|, after its label was
+ * released, and sends the pending volume if there is one. A pending volume
+ * that cannot be sent stays pending and is sent with the next request or
+ * timeout. Returns false if |label| does not belong to the outstanding
+ * command. */
+bool rc_abs_vol_complete(rc_abs_vol_t *vol, uint8_t label, uint32_t now_ms);
+
+/* Handles the timer armed through |start_timer| firing at |now_ms|. If the
+ * outstanding command has gone unanswered for RC_ABS_VOL_RSP_TIMEOUT_MS it is
+ * abandoned, and the pending volume, if any, is sent. Also retries a pending
+ * volume that could not be sent earlier. Returns true if a volume was sent. */
+bool rc_abs_vol_timeout(rc_abs_vol_t *vol, uint32_t now_ms);
+
+#endif
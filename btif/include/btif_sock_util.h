@@ -28,6 +28,11 @@
 #define BTIF_SOCK_UTIL_H
 
 #include <stdint.h>
+#include <sys/types.h>
+
+#include "bt_types.h"
+#include "osi/include/hash_map.h"
+#include "osi/include/list.h"
 
 void dump_bin(const char* title, const char* data, int size);
 
@@ -35,4 +40,34 @@ int sock_send_fd(int sock_fd, const uint8_t* buffer, int len, int send_fd);
 int sock_send_all(int sock_fd, const uint8_t* buf, int len);
 int sock_recv_all(int sock_fd, uint8_t* buf, int len);
 
+/* Receives the next message from the SOCK_SEQPACKET socket |sock_fd| without
+ * blocking. The returned buffer is sized to the message, at most |max_len|
+ * bytes, with |headroom| bytes reserved before the payload for lower layer
+ * headers and |tailroom| bytes after it for trailers such as the L2CAP FCS.
+ * Returns NULL if no message could be read. */
+BT_HDR *sock_recv_msg_buf(int sock_fd, uint16_t headroom, uint16_t tailroom,
+                          uint16_t max_len);
+
+/* Sends the payloads of the BT_HDRs in |bufs| to the stream socket |sock_fd|
+ * in order, gathering several buffers into each sendmsg() and stopping when
+ * the socket would block. Buffers sent completely are removed from |bufs|; a
+ * buffer sent in part is advanced past the bytes sent. Returns the number of
+ * bytes sent, or -1 on error. */
+ssize_t sock_send_buf_list(int sock_fd, list_t *bufs);
+
+/* Returns a new, empty index of sockets keyed by socket id. Must be freed
+ * with |hash_map_free|. */
+hash_map_t *sock_id_index_new(void);
+
+/* Returns the first id after |last_id| that is not 0 and not a key of
+ * |index|, wrapping around on overflow. */
+uint32_t sock_id_index_next(const hash_map_t *index, uint32_t last_id);
+
+/* Returns the first id after |last_id| that belongs to slot |slot| of a table
+ * of |num_slots| sockets, i.e. with |id % num_slots == slot|, so that a lookup
+ * by id goes straight to the slot and only has to compare the id to reject a
+ * stale one. Restarts from the first generation on overflow and never
+ * returns 0. */
+uint32_t sock_slot_id_next(uint32_t last_id, size_t slot, size_t num_slots);
+
 #endif
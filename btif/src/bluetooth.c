@@ -58,6 +58,8 @@
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/profiler.h"
+#include "osi/include/properties.h"
 #include "osi/include/wakelock.h"
 #include "stack_manager.h"
 #include "btif_config.h"
@@ -159,6 +161,10 @@ static int init(bt_callbacks_t *callbacks) {
   allocation_tracker_init();
 #endif
 
+  char profiler_enabled[PROPERTY_VALUE_MAX] = {0};
+  osi_property_get("persist.bluetooth.profiler", profiler_enabled, "false");
+  profiler_set_enabled(strncmp(profiler_enabled, "true", 4) == 0);
+
   bt_hal_cbacks = callbacks;
   stack_manager_get_interface()->init_stack();
   btif_debug_init();
@@ -365,11 +371,13 @@ static void dump(int fd, const char **arguments)
     if (arguments != NULL && arguments[0] != NULL) {
       if (strncmp(arguments[0], "--proto-text", 12) == 0) {
         btif_update_a2dp_metrics();
+        profiler_update_metrics();
         metrics_print(fd, true);
         return;
       }
       if (strncmp(arguments[0], "--proto-bin", 11) == 0) {
         btif_update_a2dp_metrics();
+        profiler_update_metrics();
         metrics_write(fd, true);
         return;
       }
@@ -380,9 +388,11 @@ static void dump(int fd, const char **arguments)
     btif_debug_config_dump(fd);
     wakelock_debug_dump(fd);
     alarm_debug_dump(fd);
+    profiler_debug_dump(fd);
 #if defined(BTSNOOP_MEM) && (BTSNOOP_MEM == TRUE)
     btif_debug_btsnoop_dump(fd);
 #endif
+    btif_debug_btsnoop_ring_dump(fd);
 
     close(fd);
 }
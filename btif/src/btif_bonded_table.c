@@ -0,0 +1,231 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_bonded_table.c
+ *
+ *  Description:   In-memory table of bonded devices with their link keys and
+ *                 LE keys decoded from the config
+ *
+ *******************************************************************************/
+
+#include <assert.h>
+#include <string.h>
+
+#include "btcore/include/bdaddr.h"
+#include "btif_bonded_table.h"
+#include "osi/include/allocator.h"
+#include "osi/include/hash_map.h"
+#include "osi/include/list.h"
+
+#define BONDED_TABLE_BUCKETS 256
+
+struct bonded_table_t {
+    list_t     *devices;     /* bonded_device_t, in the order they were added */
+    hash_map_t *by_addr;     /* bt_bdaddr_t -> bonded_device_t in |devices| */
+};
+
+static bool addr_equals(const void *x, const void *y)
+{
+    return bdaddr_equals((const bt_bdaddr_t *)x, (const bt_bdaddr_t *)y);
+}
+
+bonded_table_t *bonded_table_new(void)
+{
+    bonded_table_t *table = osi_calloc(sizeof(bonded_table_t));
+    table->devices = list_new(osi_free);
+    table->by_addr = hash_map_new(BONDED_TABLE_BUCKETS, hash_function_bdaddr,
+                                  NULL, NULL, addr_equals);
+    return table;
+}
+
+void bonded_table_free(bonded_table_t *table)
+{
+    if (!table)
+        return;
+
+    hash_map_free(table->by_addr);
+    list_free(table->devices);
+    osi_free(table);
+}
+
+void bonded_table_clear(bonded_table_t *table)
+{
+    assert(table != NULL);
+
+    hash_map_clear(table->by_addr);
+    list_clear(table->devices);
+}
+
+size_t bonded_table_size(const bonded_table_t *table)
+{
+    assert(table != NULL);
+    return list_length(table->devices);
+}
+
+const bonded_device_t *bonded_table_get(const bonded_table_t *table,
+                                        const bt_bdaddr_t *addr)
+{
+    assert(table != NULL);
+    assert(addr != NULL);
+    return hash_map_get(table->by_addr, addr);
+}
+
+static bonded_device_t *get_or_add_device(bonded_table_t *table,
+                                          const bt_bdaddr_t *addr)
+{
+    bonded_device_t *device = hash_map_get(table->by_addr, addr);
+    if (device)
+        return device;
+
+    device = osi_calloc(sizeof(bonded_device_t));
+    bdaddr_copy(&device->addr, addr);
+    list_append(table->devices, device);
+    hash_map_set(table->by_addr, &device->addr, device);
+    return device;
+}
+
+static void remove_if_unbonded(bonded_table_t *table, bonded_device_t *device)
+{
+    if (device->has_link_key || device->num_le_keys > 0)
+        return;
+
+    hash_map_erase(table->by_addr, &device->addr);
+    list_remove(table->devices, device);
+}
+
+bool bonded_table_set_link_key(bonded_table_t *table, const bt_bdaddr_t *addr,
+                               const uint8_t *link_key, uint8_t key_type,
+                               uint8_t pin_length)
+{
+    assert(table != NULL);
+    assert(addr != NULL);
+    assert(link_key != NULL);
+
+    bonded_device_t *device = get_or_add_device(table, addr);
+    memcpy(device->link_key, link_key, BONDED_TABLE_LINK_KEY_LEN);
+    device->link_key_type = key_type;
+    device->pin_length = pin_length;
+    device->has_link_key = true;
+    return true;
+}
+
+bool bonded_table_set_le_key(bonded_table_t *table, const bt_bdaddr_t *addr,
+                             uint8_t key_type, const void *value, size_t len)
+{
+    assert(table != NULL);
+    assert(addr != NULL);
+    assert(value != NULL);
+    assert(key_type != 0);
+
+    if (len > BONDED_TABLE_LE_KEY_MAX_LEN)
+        return false;
+
+    bonded_device_t *device = get_or_add_device(table, addr);
+    bonded_le_key_t *slot = (bonded_le_key_t *)bonded_table_get_le_key(device, key_type);
+    if (!slot)
+    {
+        if (device->num_le_keys == BONDED_TABLE_LE_KEY_SLOTS)
+        {
+            remove_if_unbonded(table, device);
+            return false;
+        }
+        slot = &device->le_keys[device->num_le_keys++];
+        slot->type = key_type;
+    }
+
+    memset(slot->value, 0, sizeof(slot->value));
+    memcpy(slot->value, value, len);
+    slot->len = len;
+    return true;
+}
+
+void bonded_table_remove_link_key(bonded_table_t *table,
+                                  const bt_bdaddr_t *addr)
+{
+    assert(table != NULL);
+    assert(addr != NULL);
+
+    bonded_device_t *device = hash_map_get(table->by_addr, addr);
+    if (!device)
+        return;
+
+    memset(device->link_key, 0, sizeof(device->link_key));
+    device->has_link_key = false;
+    remove_if_unbonded(table, device);
+}
+
+void bonded_table_remove_le_keys(bonded_table_t *table,
+                                 const bt_bdaddr_t *addr)
+{
+    assert(table != NULL);
+    assert(addr != NULL);
+
+    bonded_device_t *device = hash_map_get(table->by_addr, addr);
+    if (!device)
+        return;
+
+    memset(device->le_keys, 0, sizeof(device->le_keys));
+    device->num_le_keys = 0;
+    remove_if_unbonded(table, device);
+}
+
+const bonded_le_key_t *bonded_table_get_le_key(const bonded_device_t *device,
+                                               uint8_t key_type)
+{
+    assert(device != NULL);
+
+    for (int i = 0; i < device->num_le_keys; i++)
+    {
+        if (device->le_keys[i].type == key_type)
+            return &device->le_keys[i];
+    }
+    return NULL;
+}
+
+size_t bonded_table_get_addrs(const bonded_table_t *table, bt_bdaddr_t *addrs,
+                              size_t max_addrs)
+{
+    assert(table != NULL);
+    assert(addrs != NULL || max_addrs == 0);
+
+    size_t num_addrs = 0;
+    for (const list_node_t *node = list_begin(table->devices);
+         node != list_end(table->devices) && num_addrs < max_addrs;
+         node = list_next(node))
+    {
+        const bonded_device_t *device = list_node(node);
+        bdaddr_copy(&addrs[num_addrs++], &device->addr);
+    }
+    return num_addrs;
+}
+
+void bonded_table_foreach(const bonded_table_t *table,
+                          bonded_table_iter_cb callback, void *context)
+{
+    assert(table != NULL);
+    assert(callback != NULL);
+
+    for (const list_node_t *node = list_begin(table->devices);
+         node != list_end(table->devices); node = list_next(node))
+    {
+        if (!callback(list_node(node), context))
+            return;
+    }
+}
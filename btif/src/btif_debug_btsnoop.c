@@ -42,6 +42,14 @@ static const uint8_t MAX_LINE_LENGTH = 128;
 static ringbuffer_t *buffer = NULL;
 static uint64_t last_timestamp_ms = 0;
 
+// Base64 encodes the snoop ring dump as it is produced.
+typedef struct {
+  int fd;
+  uint8_t pending[3];
+  size_t num_pending;
+  size_t line_length;
+} b64_writer_t;
+
 static size_t btsnoop_calculate_packet_length(uint16_t type, const uint8_t *data, size_t length);
 
 static void btsnoop_cb(const uint16_t type, const uint8_t *data, const size_t length) {
@@ -207,3 +215,37 @@ void btif_debug_btsnoop_dump(int fd) {
 error:
   ringbuffer_free(ringbuffer);
 }
+
+static void b64_write(b64_writer_t *writer, const uint8_t *data, size_t length) {
+  char b64_out[5] = {0};
+
+  if (writer->line_length >= MAX_LINE_LENGTH) {
+    dprintf(writer->fd, "\n");
+    writer->line_length = 0;
+  }
+  writer->line_length += b64_ntop(data, length, b64_out, sizeof(b64_out));
+  dprintf(writer->fd, "%s", b64_out);
+}
+
+static void ring_dump_cb(const uint8_t *data, size_t length, void *context) {
+  b64_writer_t *writer = (b64_writer_t *)context;
+
+  for (size_t i = 0; i < length; ++i) {
+    writer->pending[writer->num_pending++] = data[i];
+    if (writer->num_pending == sizeof(writer->pending)) {
+      b64_write(writer, writer->pending, writer->num_pending);
+      writer->num_pending = 0;
+    }
+  }
+}
+
+void btif_debug_btsnoop_ring_dump(int fd) {
+  dprintf(fd, "--- BEGIN:BTSNOOP_LOG_RING ---\n");
+
+  b64_writer_t writer = {.fd = fd, .num_pending = 0, .line_length = 0};
+  size_t num_packets = btsnoop_mem_ring_dump(ring_dump_cb, &writer);
+  if (writer.num_pending > 0)
+    b64_write(&writer, writer.pending, writer.num_pending);
+
+  dprintf(fd, "\n--- END:BTSNOOP_LOG_RING (%zu packets) ---\n", num_packets);
+}
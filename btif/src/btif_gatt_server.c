@@ -27,6 +27,7 @@
 #define LOG_TAG "bt_btif_gatt"
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,7 +48,9 @@
 #include "btif_gatt_util.h"
 #include "btif_storage.h"
 #include "bt_common.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 
 /************************************************************************************
 **  Constants & Macros
@@ -74,7 +77,8 @@ typedef enum {
     BTIF_GATTS_STOP_SERVICE,
     BTIF_GATTS_DELETE_SERVICE,
     BTIF_GATTS_SEND_INDICATION,
-    BTIF_GATTS_SEND_RESPONSE
+    BTIF_GATTS_SEND_RESPONSE,
+    BTIF_GATTS_SEND_NOTIFY_BATCH
 } btif_gatts_event_t;
 
 /************************************************************************************
@@ -105,16 +109,90 @@ typedef struct
 
 } __attribute__((packed)) btif_gatts_cb_t;
 
+// The same notification value sent to several connections in a row, as
+// servers do when fanning out a characteristic change to its subscribers.
+typedef struct
+{
+    uint8_t             value[BTGATT_MAX_ATTR_LEN];
+    uint16_t            conn_ids[BTA_GATTS_NOTIFY_MULTI_MAX];
+    uint16_t            attr_handle;
+    uint16_t            len;
+    uint8_t             server_if;
+    uint8_t             num_conn;
+} btif_gatts_notify_batch_t;
+
+// A read the app was asked to answer from the start of the value. Its answer
+// is handed to the stack, which then serves the rest of a long read without
+// coming back up; the app still sees every read that starts over.
+typedef struct
+{
+    uint32_t            trans_id;
+    uint16_t            conn_id;
+    uint16_t            attr_handle;
+} btif_gatts_read_t;
+
 /************************************************************************************
 **  Static variables
 ************************************************************************************/
 
 extern const btgatt_callbacks_t *bt_gatt_callbacks;
 
+// Batch that has been posted to the btif thread but not run yet. Further
+// notifications of the same value are added to it instead of being posted
+// on their own; any other request posted in between closes it so that
+// requests keep the order the app made them in.
+static btif_gatts_notify_batch_t *pending_notify_batch;
+static pthread_mutex_t notify_batch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// One per link at most, since a client has one request outstanding at a
+// time. Only used on the btif thread.
+static btif_gatts_read_t pending_reads[BTA_GATTS_NOTIFY_MULTI_MAX];
+
 /************************************************************************************
 **  Static functions
 ************************************************************************************/
 
+static void btif_gatts_close_notify_batch(void);
+
+static void btif_gatts_track_read(uint16_t conn_id, uint32_t trans_id, uint16_t attr_handle)
+{
+    btif_gatts_read_t *p_read = NULL;
+
+    for (int i = 0; i < BTA_GATTS_NOTIFY_MULTI_MAX; ++i)
+    {
+        if (pending_reads[i].conn_id == conn_id)
+        {
+            p_read = &pending_reads[i];
+            break;
+        }
+        if (p_read == NULL && pending_reads[i].conn_id == 0)
+            p_read = &pending_reads[i];
+    }
+
+    if (p_read == NULL)
+        return;
+
+    p_read->conn_id = conn_id;
+    p_read->trans_id = trans_id;
+    p_read->attr_handle = attr_handle;
+}
+
+// Returns the handle |trans_id| read from offset 0 on |conn_id|, or 0.
+static uint16_t btif_gatts_take_read(uint16_t conn_id, uint32_t trans_id)
+{
+    for (int i = 0; i < BTA_GATTS_NOTIFY_MULTI_MAX; ++i)
+    {
+        btif_gatts_read_t *p_read = &pending_reads[i];
+        if (p_read->conn_id != conn_id)
+            continue;
+
+        uint16_t attr_handle = (p_read->trans_id == trans_id) ? p_read->attr_handle : 0;
+        memset(p_read, 0, sizeof(*p_read));
+        return attr_handle;
+    }
+    return 0;
+}
+
 static void btapp_gatts_copy_req_data(UINT16 event, char *p_dest, char *p_src)
 {
     tBTA_GATTS *p_dest_data = (tBTA_GATTS*) p_dest;
@@ -200,6 +278,7 @@ static void btapp_gatts_handle_cback(uint16_t event, char* p_param)
             bt_bdaddr_t bda;
             bdcpy(bda.address, p_data->conn.remote_bda);
 
+            btif_gatts_take_read(p_data->conn.conn_id, 0);
             HAL_CBACK(bt_gatt_callbacks, server->connection_cb,
                       p_data->conn.conn_id, p_data->conn.server_if, FALSE, &bda);
             break;
@@ -281,6 +360,10 @@ static void btapp_gatts_handle_cback(uint16_t event, char* p_param)
             bt_bdaddr_t bda;
             bdcpy(bda.address, p_data->req_data.remote_bda);
 
+            if (p_data->req_data.p_data->read_req.offset == 0)
+                btif_gatts_track_read(p_data->req_data.conn_id, p_data->req_data.trans_id,
+                                      p_data->req_data.p_data->read_req.handle);
+
             HAL_CBACK(bt_gatt_callbacks, server->request_read_cb,
                       p_data->req_data.conn_id,p_data->req_data.trans_id, &bda,
                       p_data->req_data.p_data->read_req.handle,
@@ -357,6 +440,25 @@ static void btapp_gatts_cback(tBTA_GATTS_EVT event, tBTA_GATTS *p_data)
     ASSERTC(status == BT_STATUS_SUCCESS, "Context transfer failed!", status);
 }
 
+static void btgatts_handle_notify_batch(UNUSED_ATTR uint16_t event, char* p_param)
+{
+    btif_gatts_notify_batch_t *p_batch = *(btif_gatts_notify_batch_t **)p_param;
+
+    pthread_mutex_lock(&notify_batch_lock);
+    if (pending_notify_batch == p_batch)
+        pending_notify_batch = NULL;
+    pthread_mutex_unlock(&notify_batch_lock);
+
+    if (p_batch->num_conn == 1)
+        BTA_GATTS_HandleValueIndication(p_batch->conn_ids[0], p_batch->attr_handle,
+                                        p_batch->len, p_batch->value, FALSE);
+    else
+        BTA_GATTS_HandleValueNotificationMulti(p_batch->num_conn, p_batch->conn_ids,
+                                               p_batch->attr_handle, p_batch->len,
+                                               p_batch->value);
+    osi_free(p_batch);
+}
+
 static void btgatts_handle_event(uint16_t event, char* p_param)
 {
     btif_gatts_cb_t* p_cb = (btif_gatts_cb_t*)p_param;
@@ -501,6 +603,17 @@ static void btgatts_handle_event(uint16_t event, char* p_param)
             btgatt_response_t *p_rsp = &p_cb->response;
             btif_to_bta_response(&rsp_struct, p_rsp);
 
+            // Apps answer a read from offset 0 with the whole value, so the
+            // rest of a long read can be served from it.
+            uint16_t attr_handle = btif_gatts_take_read(p_cb->conn_id, p_cb->trans_id);
+            if (attr_handle != 0 && p_cb->status == BTA_GATT_OK &&
+                rsp_struct.attr_value.handle == attr_handle &&
+                rsp_struct.attr_value.offset == 0)
+            {
+                BTA_GATTS_SetAttributeValue(attr_handle, rsp_struct.attr_value.len,
+                                            rsp_struct.attr_value.value, TRUE);
+            }
+
             BTA_GATTS_SendRsp(p_cb->conn_id, p_cb->trans_id,
                               p_cb->status, &rsp_struct);
 
@@ -522,6 +635,7 @@ static void btgatts_handle_event(uint16_t event, char* p_param)
 static bt_status_t btif_gatts_register_app(bt_uuid_t *uuid)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     memcpy(&btif_cb.uuid, uuid, sizeof(bt_uuid_t));
     return btif_transfer_context(btgatts_handle_event, BTIF_GATTS_REGISTER_APP,
@@ -531,6 +645,7 @@ static bt_status_t btif_gatts_register_app(bt_uuid_t *uuid)
 static bt_status_t btif_gatts_unregister_app( int server_if )
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     return btif_transfer_context(btgatts_handle_event, BTIF_GATTS_UNREGISTER_APP,
@@ -541,6 +656,7 @@ static bt_status_t btif_gatts_open( int server_if, const bt_bdaddr_t *bd_addr,
                                       bool is_direct, int transport )
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.is_direct = is_direct ? 1 : 0;
@@ -553,6 +669,7 @@ static bt_status_t btif_gatts_open( int server_if, const bt_bdaddr_t *bd_addr,
 static bt_status_t btif_gatts_close(int server_if, const bt_bdaddr_t *bd_addr, int conn_id)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.conn_id = (uint16_t) conn_id;
@@ -565,6 +682,7 @@ static bt_status_t btif_gatts_add_service(int server_if, btgatt_srvc_id_t *srvc_
                                           int num_handles)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.num_handles = (uint8_t) num_handles;
@@ -577,6 +695,7 @@ static bt_status_t btif_gatts_add_included_service(int server_if, int service_ha
                                                    int included_handle)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -590,6 +709,7 @@ static bt_status_t btif_gatts_add_characteristic(int server_if, int service_hand
                                                  int permissions)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -604,6 +724,7 @@ static bt_status_t btif_gatts_add_descriptor(int server_if, int service_handle,
                                              int permissions)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -616,6 +737,7 @@ static bt_status_t btif_gatts_add_descriptor(int server_if, int service_handle,
 static bt_status_t btif_gatts_start_service(int server_if, int service_handle, int transport)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -627,6 +749,7 @@ static bt_status_t btif_gatts_start_service(int server_if, int service_handle, i
 static bt_status_t btif_gatts_stop_service(int server_if, int service_handle)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -637,6 +760,7 @@ static bt_status_t btif_gatts_stop_service(int server_if, int service_handle)
 static bt_status_t btif_gatts_delete_service(int server_if, int service_handle)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.srvc_handle = (uint16_t) service_handle;
@@ -644,10 +768,73 @@ static bt_status_t btif_gatts_delete_service(int server_if, int service_handle)
                                  (char*) &btif_cb, sizeof(btif_gatts_cb_t), NULL);
 }
 
+static void btif_gatts_close_notify_batch(void)
+{
+    pthread_mutex_lock(&notify_batch_lock);
+    pending_notify_batch = NULL;
+    pthread_mutex_unlock(&notify_batch_lock);
+}
+
+static bt_status_t btif_gatts_send_notification(int server_if, int attribute_handle,
+                                                int conn_id, int len, char* p_value)
+{
+    btif_gatts_notify_batch_t *p_batch;
+    bt_status_t status;
+
+    if (len > BTGATT_MAX_ATTR_LEN)
+        len = BTGATT_MAX_ATTR_LEN;
+
+    pthread_mutex_lock(&notify_batch_lock);
+    p_batch = pending_notify_batch;
+    if (p_batch != NULL && p_batch->server_if == server_if &&
+        p_batch->attr_handle == attribute_handle && p_batch->len == len &&
+        p_batch->num_conn < BTA_GATTS_NOTIFY_MULTI_MAX &&
+        memcmp(p_batch->value, p_value, len) == 0)
+    {
+        int i;
+        for (i = 0; i < p_batch->num_conn; ++i)
+            if (p_batch->conn_ids[i] == conn_id)
+                break;
+
+        if (i == p_batch->num_conn)
+        {
+            p_batch->conn_ids[p_batch->num_conn++] = (uint16_t) conn_id;
+            pthread_mutex_unlock(&notify_batch_lock);
+            return BT_STATUS_SUCCESS;
+        }
+    }
+
+    p_batch = osi_malloc(sizeof(btif_gatts_notify_batch_t));
+    p_batch->server_if = (uint8_t) server_if;
+    p_batch->attr_handle = (uint16_t) attribute_handle;
+    p_batch->len = (uint16_t) len;
+    p_batch->num_conn = 1;
+    p_batch->conn_ids[0] = (uint16_t) conn_id;
+    memcpy(p_batch->value, p_value, len);
+
+    // Posted under the lock so no other notification can be posted between
+    // this batch becoming pending and it reaching the btif queue.
+    pending_notify_batch = p_batch;
+    status = btif_transfer_context(btgatts_handle_notify_batch, BTIF_GATTS_SEND_NOTIFY_BATCH,
+                                   (char*) &p_batch, sizeof(p_batch), NULL);
+    if (status != BT_STATUS_SUCCESS)
+    {
+        pending_notify_batch = NULL;
+        osi_free(p_batch);
+    }
+    pthread_mutex_unlock(&notify_batch_lock);
+    return status;
+}
+
 static bt_status_t btif_gatts_send_indication(int server_if, int attribute_handle, int conn_id,
                                               int len, int confirm, char* p_value)
 {
     CHECK_BTGATT_INIT();
+    if (!confirm)
+        return btif_gatts_send_notification(server_if, attribute_handle, conn_id,
+                                            len, p_value);
+
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.server_if = (uint8_t) server_if;
     btif_cb.conn_id = (uint16_t) conn_id;
@@ -663,6 +850,7 @@ static bt_status_t btif_gatts_send_response(int conn_id, int trans_id,
                                             int status, btgatt_response_t *response)
 {
     CHECK_BTGATT_INIT();
+    btif_gatts_close_notify_batch();
     btif_gatts_cb_t btif_cb;
     btif_cb.conn_id = (uint16_t) conn_id;
     btif_cb.trans_id = (uint32_t) trans_id;
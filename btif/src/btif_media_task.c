@@ -57,7 +57,6 @@
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
-#include "osi/include/mutex.h"
 #include "osi/include/thread.h"
 #include "bt_utils.h"
 #include "a2d_api.h"
@@ -422,6 +421,10 @@ typedef struct {
 
 static UINT64 last_frame_us = 0;
 
+/* Serializes codec setup and updates. Separate from the locks of the stack so
+ * that RFCOMM or other traffic cannot hold up the encoder thread. */
+static pthread_mutex_t media_codec_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
 static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_encoder_update(void);
@@ -1474,7 +1477,7 @@ tBTIF_STATUS btif_a2dp_setup_codec(tBTA_AV_HNDL hdl)
 
     APPL_TRACE_EVENT("## A2DP SETUP CODEC ##");
 
-    mutex_global_lock();
+    pthread_mutex_lock(&media_codec_lock);
 
 
 #ifdef BTA_AV_SPLIT_A2DP_DEF_FREQ_48KHZ
@@ -1510,7 +1513,7 @@ tBTIF_STATUS btif_a2dp_setup_codec(tBTA_AV_HNDL hdl)
         status = BTIF_ERROR_SRV_AV_FEEDING_NOT_SUPPORTED;
     }
 
-    mutex_global_unlock();
+    pthread_mutex_unlock(&media_codec_lock);
         return status;
 }
 
@@ -1528,10 +1531,10 @@ tBTIF_STATUS btif_a2dp_setup_codec(tBTA_AV_HNDL hdl)
 void btif_a2dp_update_codec(void)
 {
     APPL_TRACE_DEBUG("## A2DP UPDATE CODEC ##");
-    mutex_global_lock();
+    pthread_mutex_lock(&media_codec_lock);
     btif_media_task_start_aa_req();
     btif_a2dp_encoder_update();
-    mutex_global_unlock();
+    pthread_mutex_unlock(&media_codec_lock);
 }
 
 
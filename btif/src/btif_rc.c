@@ -39,6 +39,7 @@
 #include "bta_av_api.h"
 #include "btif_av.h"
 #include "btif_common.h"
+#include "btif_rc_txn.h"
 #include "btif_util.h"
 #include "bt_common.h"
 #include "device/include/interop.h"
@@ -46,6 +47,7 @@
 #include "bdaddr.h"
 #include "osi/include/list.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "btu.h"
 #define RC_INVALID_TRACK_ID (0xFFFFFFFFFFFFFFFFULL)
 
@@ -82,7 +84,7 @@
 #define IDX_GET_TOTAL_ITEMS_RSP    15
 #define MAX_VOLUME 128
 #define MAX_LABEL 16
-#define MAX_TRANSACTIONS_PER_SESSION 16
+#define MAX_TRANSACTIONS_PER_SESSION RC_LABEL_POOL_SIZE
 #define PLAY_STATUS_PLAYING 1
 #define MAX_CMD_QUEUE_LEN 16
 #define ERR_PLAYER_NOT_ADDRESED 0x13
@@ -262,6 +264,8 @@ typedef struct {
     btif_rc_reg_notifications_t rc_notif[MAX_RC_NOTIFICATIONS];
     unsigned int                rc_volume;
     uint8_t                     rc_vol_label;
+    rc_abs_vol_t                rc_abs_vol;             /* SetAbsoluteVolume coalescing */
+    alarm_t                     *rc_abs_vol_timer;      /* SetAbsoluteVolume rsp timeout */
     list_t                      *rc_supported_event_list;
     btif_rc_player_app_settings_t   rc_app_settings;
     alarm_t                     *rc_play_status_timer;
@@ -269,6 +273,9 @@ typedef struct {
     UINT64                      rc_playing_uid;
     BOOLEAN                     rc_procedure_complete;
     BOOLEAN                     rc_play_processed;
+    BT_HDR                      *rc_elem_attr_rsp;      /* encoded GetElementAttributes rsp */
+    UINT32                      rc_elem_attr_rsp_mask;  /* attributes in rc_elem_attr_rsp */
+    UINT32                      rc_elem_attr_req_mask;  /* attributes of the pending cmd */
 } btif_rc_cb_t;
 
 typedef struct {
@@ -283,6 +290,7 @@ typedef struct
 {
     pthread_mutex_t lbllock;
     rc_transaction_t transaction[MAX_TRANSACTIONS_PER_SESSION];
+    rc_label_pool_t labels;
     BOOLEAN lbllock_destroyed;
 } rc_device_t;
 
@@ -324,6 +332,9 @@ static void send_reject_response (UINT8 rc_handle, UINT8 label,
 static UINT8 opcode_from_pdu(UINT8 pdu);
 static void send_metamsg_rsp (UINT8 rc_handle, UINT8 label,
     tBTA_AV_CODE code, tAVRC_RESPONSE *pmetamsg_resp);
+static BOOLEAN elem_attr_cache_send(int index, UINT8 label, UINT32 attr_mask);
+static void elem_attr_cache_store(int index, BT_HDR *p_msg);
+static void elem_attr_cache_flush(int index);
 #if (AVRC_ADV_CTRL_INCLUDED == TRUE)
 static void register_volumechange(UINT8 label, int index);
 #endif
@@ -335,7 +346,9 @@ static void release_transaction(UINT8 label);
 static rc_transaction_t* get_transaction_by_lbl(UINT8 label);
 #if (AVRC_ADV_CTRL_INCLUDED == TRUE)
 static void handle_rc_metamsg_rsp(tBTA_AV_META_MSG *pmeta_msg);
+static void abs_vol_complete(int index, UINT8 label);
 #endif
+static const rc_abs_vol_ops_t abs_vol_ops;
 #if (AVRC_CTLR_INCLUDED == TRUE)
 static void handle_avk_rc_metamsg_cmd(tBTA_AV_META_MSG *pmeta_msg);
 static void handle_avk_rc_metamsg_rsp(tBTA_AV_META_MSG *pmeta_msg);
@@ -364,6 +377,7 @@ static bt_status_t get_player_app_setting_cmd(uint8_t num_attrib, uint8_t* attri
 #endif
 static void rc_start_play_status_timer(void);
 static bool absolute_volume_disabled(void);
+static bool elem_attr_cache_allowed(void);
 static void btif_rc_upstreams_evt(UINT16 event, tAVRC_COMMAND* p_param, UINT8 ctype, UINT8 label,
                                     int index);
 #if (AVRC_ADV_CTRL_INCLUDED == TRUE)
@@ -384,6 +398,10 @@ static void send_browsemsg_rsp (UINT8 rc_handle, UINT8 label,
 /* Two RC CBs needed to handle two connections*/
 static btif_rc_cb_t btif_rc_cb[BTIF_RC_NUM_CB];
 static btrc_callbacks_t *bt_rc_callbacks = NULL;
+/* Guards the encoded GetElementAttributes responses, which the JNI thread
+ * fills while the btif thread replays them */
+static pthread_mutex_t elem_attr_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static BOOLEAN elem_attr_cache_enabled = FALSE;
 static btrc_ctrl_callbacks_t *bt_rc_ctrl_callbacks = NULL;
 
 /*****************************************************************************
@@ -858,6 +876,8 @@ void handle_rc_connect (tBTA_AV_RC_OPEN *p_rc_open)
         btif_rc_cb[index].rc_features = p_rc_open->peer_features;
         btif_rc_cb[index].rc_vol_label = MAX_LABEL;
         btif_rc_cb[index].rc_volume = MAX_VOLUME;
+        rc_abs_vol_init(&btif_rc_cb[index].rc_abs_vol, &abs_vol_ops,
+                        &btif_rc_cb[index]);
         btif_rc_cb[index].rc_connected = TRUE;
         btif_rc_cb[index].rc_handle = p_rc_open->rc_handle;
         btif_rc_init_txn_label_queue(index);
@@ -946,9 +966,13 @@ void handle_rc_disconnect (tBTA_AV_RC_CLOSE *p_rc_close)
     btif_rc_cb[index].rc_features = 0;
     btif_rc_cb[index].rc_vol_label = MAX_LABEL;
     btif_rc_cb[index].rc_volume = MAX_VOLUME;
+    alarm_cancel(btif_rc_cb[index].rc_abs_vol_timer);
+    rc_abs_vol_init(&btif_rc_cb[index].rc_abs_vol, &abs_vol_ops,
+                    &btif_rc_cb[index]);
     btif_rc_cb[index].rc_play_processed = FALSE;
     btif_rc_cb[index].rc_pending_play = FALSE;
     btif_rc_init_txn_label_queue(index);
+    elem_attr_cache_flush(index);
 
     //CLose Uinput only when all RCs are disconnected
     is_connected = btif_rc_get_connection_state();
@@ -1707,6 +1731,12 @@ void btif_rc_handler(tBTA_AV_EVT event, tBTA_AV *p_data)
     {
         case BTIF_AV_CLEANUP_REQ_EVT:
         {
+            for (int i = 0; i < BTIF_RC_NUM_CB; i++)
+            {
+                elem_attr_cache_flush(i);
+                alarm_free(btif_rc_cb[i].rc_abs_vol_timer);
+                btif_rc_cb[i].rc_abs_vol_timer = NULL;
+            }
             memset(&btif_rc_cb, 0, sizeof(btif_rc_cb_t));
             close_uinput();
 
@@ -2085,6 +2115,9 @@ static void send_metamsg_rsp (UINT8 rc_handle, UINT8 label, tBTA_AV_CODE code,
 
         if (status == AVRC_STS_NO_ERROR)
         {
+            if (pmetamsg_resp->rsp.pdu == AVRC_PDU_GET_ELEMENT_ATTR &&
+                pmetamsg_resp->rsp.status == AVRC_STS_NO_ERROR)
+                elem_attr_cache_store(index, p_msg);
             BTA_AvMetaRsp(rc_handle, label, ctype, p_msg);
         }
         else
@@ -2367,6 +2400,15 @@ static void btif_rc_upstreams_evt(UINT16 event, tAVRC_COMMAND *pavrc_cmd, UINT8
                     }
                 }
             }
+            UINT32 attr_mask = 0;
+            for (int attr_cnt = 0; attr_cnt < num_attr; attr_cnt++)
+                attr_mask |= 1 << element_attrs[attr_cnt];
+
+            /* controllers poll the same track over and over, replay the last response */
+            if (elem_attr_cache_send(index, label, attr_mask))
+                break;
+
+            btif_rc_cb[index].rc_elem_attr_req_mask = attr_mask;
             FILL_PDU_QUEUE(IDX_GET_ELEMENT_ATTR_RSP, ctype, label, TRUE, index, pavrc_cmd->pdu);
             HAL_CBACK(bt_rc_callbacks, get_element_attr_cb, num_attr, element_attrs, &remote_addr);
         }
@@ -2701,11 +2743,13 @@ static bt_status_t init(btrc_callbacks_t* callbacks, int max_connections)
     bt_rc_callbacks = callbacks;
     btif_max_rc_clients = max_connections;
     memset (&btif_rc_cb, 0, sizeof(btif_rc_cb));
+    elem_attr_cache_enabled = elem_attr_cache_allowed();
     for (i = 0; i < btif_max_rc_clients; i++)
     {
         btif_rc_cb[i].rc_vol_label=MAX_LABEL;
         btif_rc_cb[i].rc_volume=MAX_VOLUME;
         btif_rc_cb[i].rc_handle = BTIF_RC_HANDLE_NONE;
+        rc_abs_vol_init(&btif_rc_cb[i].rc_abs_vol, &abs_vol_ops, &btif_rc_cb[i]);
     }
     lbl_init();
 
@@ -3189,6 +3233,7 @@ static bt_status_t register_notification_rsp(btrc_event_id_t event_id,
             break;
         case BTRC_EVT_TRACK_CHANGE:
             memcpy(&(avrc_rsp.reg_notif.param.track), &(p_param->track), sizeof(btrc_uid_t));
+            elem_attr_cache_flush(index);
             break;
         case BTRC_EVT_PLAY_POS_CHANGED:
             avrc_rsp.reg_notif.param.play_pos = p_param->song_pos;
@@ -3709,6 +3754,89 @@ static bt_status_t is_device_active_in_handoff(bt_bdaddr_t *bd_addr)
 ** Returns          bt_status_t
 **
 ***************************************************************************/
+static bool abs_vol_send_cmd(void *context, uint8_t volume, uint8_t *label)
+{
+    btif_rc_cb_t *p_cb = (btif_rc_cb_t *)context;
+    tAVRC_COMMAND avrc_cmd = {0};
+    BT_HDR *p_msg = NULL;
+    rc_transaction_t *p_transaction = NULL;
+
+    avrc_cmd.volume.opcode = AVRC_OP_VENDOR;
+    avrc_cmd.volume.pdu = AVRC_PDU_SET_ABSOLUTE_VOLUME;
+    avrc_cmd.volume.status = AVRC_STS_NO_ERROR;
+    avrc_cmd.volume.volume = volume;
+
+    if (AVRC_BldCommand(&avrc_cmd, &p_msg) != AVRC_STS_NO_ERROR)
+    {
+        BTIF_TRACE_ERROR("%s: failed to build absolute volume command", __FUNCTION__);
+        return false;
+    }
+
+    bt_status_t tran_status = get_transaction(&p_transaction);
+    if (BT_STATUS_SUCCESS != tran_status || NULL == p_transaction)
+    {
+        osi_free(p_msg);
+        BTIF_TRACE_ERROR("%s: failed to obtain transaction details. status: 0x%02x",
+                         __FUNCTION__, tran_status);
+        return false;
+    }
+
+    BTIF_TRACE_DEBUG("%s msgreq being sent out with label %d",
+                     __FUNCTION__, p_transaction->lbl);
+    BTA_AvMetaCmd(p_cb->rc_handle, p_transaction->lbl, AVRC_CMD_CTRL, p_msg);
+    *label = p_transaction->lbl;
+    return true;
+}
+
+static void abs_vol_abandon_cmd(UNUSED_ATTR void *context, uint8_t label)
+{
+    BTIF_TRACE_WARNING("%s: no response to absolute volume command with label %d",
+                       __FUNCTION__, label);
+    release_transaction(label);
+}
+
+static void btif_rc_abs_vol_timeout_handler(UNUSED_ATTR uint16_t event, char *data)
+{
+    int index = *(int *)data;
+
+    pthread_mutex_lock(&device.lbllock);
+    rc_abs_vol_timeout(&btif_rc_cb[index].rc_abs_vol, time_get_os_boottime_ms());
+    pthread_mutex_unlock(&device.lbllock);
+}
+
+static void btif_rc_abs_vol_timer_timeout(void *data)
+{
+    int index = (btif_rc_cb_t *)data - btif_rc_cb;
+
+    btif_transfer_context(btif_rc_abs_vol_timeout_handler, 0,
+                          (char *)&index, sizeof(index), NULL);
+}
+
+static void abs_vol_start_timer(void *context, uint32_t timeout_ms)
+{
+    btif_rc_cb_t *p_cb = (btif_rc_cb_t *)context;
+
+    if (p_cb->rc_abs_vol_timer == NULL)
+        p_cb->rc_abs_vol_timer = alarm_new("btif_rc.abs_vol_timer");
+    alarm_set_on_queue(p_cb->rc_abs_vol_timer, timeout_ms,
+                       btif_rc_abs_vol_timer_timeout, p_cb,
+                       btu_general_alarm_queue);
+}
+
+static void abs_vol_stop_timer(void *context)
+{
+    btif_rc_cb_t *p_cb = (btif_rc_cb_t *)context;
+
+    alarm_cancel(p_cb->rc_abs_vol_timer);
+}
+
+static const rc_abs_vol_ops_t abs_vol_ops = {
+    abs_vol_send_cmd,
+    abs_vol_abandon_cmd,
+    abs_vol_start_timer,
+    abs_vol_stop_timer
+};
+
 static bt_status_t set_volume(uint8_t volume, bt_bdaddr_t *bd_addr)
 {
     int index = btif_rc_get_idx_by_addr(bd_addr->address);
@@ -3721,54 +3849,44 @@ static bt_status_t set_volume(uint8_t volume, bt_bdaddr_t *bd_addr)
     BTIF_TRACE_DEBUG("- %s on index = %d", __FUNCTION__, index);
     CHECK_RC_CONNECTED
     tAVRC_STS status = BT_STATUS_UNSUPPORTED;
-    rc_transaction_t *p_transaction=NULL;
 
-    if(btif_rc_cb[index].rc_volume==volume)
+    /* The volume lock also guards the SetAbsoluteVolume state, which the
+     * btif thread updates when responses arrive */
+    pthread_mutex_lock(&device.lbllock);
+    rc_abs_vol_t *p_abs_vol = &btif_rc_cb[index].rc_abs_vol;
+
+    if (btif_rc_cb[index].rc_volume == volume && !rc_abs_vol_busy(p_abs_vol))
     {
         status=BT_STATUS_DONE;
         BTIF_TRACE_ERROR("%s: volume value already set earlier: 0x%02x",__FUNCTION__, volume);
-        return status;
     }
-
-    if ((btif_rc_cb[index].rc_features & BTA_AV_FEAT_RCTG) &&
+    else if ((btif_rc_cb[index].rc_features & BTA_AV_FEAT_RCTG) &&
         (btif_rc_cb[index].rc_features & BTA_AV_FEAT_ADV_CTRL))
     {
-        tAVRC_COMMAND avrc_cmd = {0};
-        BT_HDR *p_msg = NULL;
-
         BTIF_TRACE_DEBUG("%s: Peer supports absolute volume. newVolume=%d", __FUNCTION__, volume);
-        avrc_cmd.volume.opcode = AVRC_OP_VENDOR;
-        avrc_cmd.volume.pdu = AVRC_PDU_SET_ABSOLUTE_VOLUME;
-        avrc_cmd.volume.status = AVRC_STS_NO_ERROR;
-        avrc_cmd.volume.volume = volume;
-
-        if (AVRC_BldCommand(&avrc_cmd, &p_msg) == AVRC_STS_NO_ERROR)
+        switch (rc_abs_vol_set(p_abs_vol, volume, time_get_os_boottime_ms()))
         {
-            bt_status_t tran_status=get_transaction(&p_transaction);
-            if (BT_STATUS_SUCCESS == tran_status && NULL!=p_transaction)
-            {
-                BTIF_TRACE_DEBUG("%s msgreq being sent out with label %d",
-                                   __FUNCTION__,p_transaction->lbl);
-                BTA_AvMetaCmd(btif_rc_cb[index].rc_handle,p_transaction->lbl, AVRC_CMD_CTRL, p_msg);
-                status =  BT_STATUS_SUCCESS;
-            }
-            else
-            {
-                osi_free(p_msg);
-                BTIF_TRACE_ERROR("%s: failed to obtain transaction details. status: 0x%02x",
-                                    __FUNCTION__, tran_status);
+            case RC_ABS_VOL_SENT:
+                status = BT_STATUS_SUCCESS;
+                break;
+
+            case RC_ABS_VOL_QUEUED:
+                /* Sent once the outstanding command completes, unless a newer
+                 * volume replaces it first */
+                BTIF_TRACE_DEBUG("%s: volume %d queued, %u coalesced so far",
+                                 __FUNCTION__, volume, p_abs_vol->coalesced);
+                status = BT_STATUS_SUCCESS;
+                break;
+
+            default:
                 status = BT_STATUS_FAIL;
-            }
-        }
-        else
-        {
-            BTIF_TRACE_ERROR("%s: failed to build absolute volume command. status: 0x%02x",
-                                __FUNCTION__, status);
-            status = BT_STATUS_FAIL;
+                break;
         }
     }
     else
         status=BT_STATUS_NOT_READY;
+
+    pthread_mutex_unlock(&device.lbllock);
     return status;
 }
 
@@ -3814,6 +3932,35 @@ static void register_volumechange (UINT8 lbl, int index)
     }
 }
 
+/***************************************************************************
+**
+** Function         abs_vol_complete
+**
+** Description      Releases the label of an answered SetAbsoluteVolume command
+**                  and sends the volume that was queued behind it, if any.
+**                  A late response to an abandoned command is dropped, since
+**                  its label may already be in use by another transaction.
+**
+** Returns          void
+**
+***************************************************************************/
+static void abs_vol_complete(int index, UINT8 label)
+{
+    rc_abs_vol_t *p_abs_vol = &btif_rc_cb[index].rc_abs_vol;
+
+    pthread_mutex_lock(&device.lbllock);
+    if (!rc_abs_vol_is_outstanding(p_abs_vol, label))
+    {
+        pthread_mutex_unlock(&device.lbllock);
+        BTIF_TRACE_WARNING("%s: unexpected absolute volume response, label %d",
+                           __FUNCTION__, label);
+        return;
+    }
+    release_transaction(label);
+    rc_abs_vol_complete(p_abs_vol, label, time_get_os_boottime_ms());
+    pthread_mutex_unlock(&device.lbllock);
+}
+
 /***************************************************************************
 **
 ** Function         handle_rc_metamsg_rsp
@@ -3852,12 +3999,12 @@ static void handle_rc_metamsg_rsp(tBTA_AV_META_MSG *pmeta_msg)
                 && AVRC_EVT_VOLUME_CHANGE==avrc_response.reg_notif.event_id
                 && btif_rc_cb[index].rc_vol_label==pmeta_msg->label)
             {
-                btif_rc_cb[index].rc_vol_label=MAX_LABEL;
                 release_transaction(btif_rc_cb[index].rc_vol_label);
+                btif_rc_cb[index].rc_vol_label=MAX_LABEL;
             }
             else if (AVRC_PDU_SET_ABSOLUTE_VOLUME==avrc_response.rsp.pdu)
             {
-                release_transaction(pmeta_msg->label);
+                abs_vol_complete(index, pmeta_msg->label);
             }
             return;
         }
@@ -3888,8 +4035,9 @@ static void handle_rc_metamsg_rsp(tBTA_AV_META_MSG *pmeta_msg)
      }
      else if (AVRC_PDU_SET_ABSOLUTE_VOLUME==avrc_response.rsp.pdu)
      {
-          /* free up the label here */
-          release_transaction(pmeta_msg->label);
+          /* free up the label here, and send the latest volume requested
+           * while this command was outstanding */
+          abs_vol_complete(index, pmeta_msg->label);
      }
 
      BTIF_TRACE_EVENT("%s: Passing received metamsg response to app. pdu: %s",
@@ -5249,6 +5397,11 @@ static void cleanup_ctrl()
         bt_rc_ctrl_callbacks = NULL;
     }
     alarm_free(btif_rc_cb[0].rc_play_status_timer);
+    for (int i = 0; i < BTIF_RC_NUM_CB; i++)
+    {
+        alarm_free(btif_rc_cb[i].rc_abs_vol_timer);
+        btif_rc_cb[i].rc_abs_vol_timer = NULL;
+    }
     memset(&btif_rc_cb, 0, sizeof(btif_rc_cb_t));
     lbl_destroy();
     BTIF_TRACE_EVENT("## %s ## completed", __FUNCTION__);
@@ -6038,6 +6191,7 @@ void lbl_init()
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
     pthread_mutex_init(&(device.lbllock), &attr);
     pthread_mutexattr_destroy(&attr);
+    rc_label_pool_init(&device.labels);
     init_all_transactions();
 }
 
@@ -6052,10 +6206,13 @@ void lbl_init()
 void init_all_transactions()
 {
     UINT8 txn_indx=0;
+    pthread_mutex_lock(&device.lbllock);
     for(txn_indx=0; txn_indx < MAX_TRANSACTIONS_PER_SESSION; txn_indx++)
     {
         initialize_transaction(txn_indx);
     }
+    rc_label_pool_reset(&device.labels);
+    pthread_mutex_unlock(&device.lbllock);
 }
 
 /*******************************************************************************
@@ -6102,20 +6259,21 @@ rc_transaction_t *get_transaction_by_lbl(UINT8 lbl)
 bt_status_t  get_transaction(rc_transaction_t **ptransaction)
 {
     bt_status_t result = BT_STATUS_NOMEM;
-    UINT8 i=0;
+    UINT8 lbl;
     pthread_mutex_lock(&device.lbllock);
 
-    // Check for unused transactions
-    for (i=0; i<MAX_TRANSACTIONS_PER_SESSION; i++)
+    if (rc_label_pool_alloc(&device.labels, &lbl))
     {
-        if (FALSE==device.transaction[i].in_use)
-        {
-            BTIF_TRACE_DEBUG("%s:Got transaction.label: %d",__FUNCTION__,device.transaction[i].lbl);
-            device.transaction[i].in_use = TRUE;
-            *ptransaction = &(device.transaction[i]);
-            result = BT_STATUS_SUCCESS;
-            break;
-        }
+        BTIF_TRACE_DEBUG("%s:Got transaction.label: %d",__FUNCTION__,lbl);
+        device.transaction[lbl].in_use = TRUE;
+        *ptransaction = &(device.transaction[lbl]);
+        result = BT_STATUS_SUCCESS;
+    }
+    else
+    {
+        BTIF_TRACE_ERROR("%s: all %d labels in use, %u allocations failed so far",
+                         __FUNCTION__, MAX_TRANSACTIONS_PER_SESSION,
+                         device.labels.stats.exhausted);
     }
 
     pthread_mutex_unlock(&device.lbllock);
@@ -6132,14 +6290,17 @@ bt_status_t  get_transaction(rc_transaction_t **ptransaction)
 *******************************************************************************/
 void release_transaction(UINT8 lbl)
 {
-    rc_transaction_t *transaction = get_transaction_by_lbl(lbl);
+    pthread_mutex_lock(&device.lbllock);
 
-    /* If the transaction is in use... */
-    if (transaction != NULL)
+    /* Labels that are not in use, e.g. released again by a late response,
+     * are only counted by the pool */
+    if (rc_label_pool_release(&device.labels, lbl))
     {
         BTIF_TRACE_DEBUG("%s: lbl: %d", __FUNCTION__, lbl);
         initialize_transaction(lbl);
     }
+
+    pthread_mutex_unlock(&device.lbllock);
 }
 
 /*******************************************************************************
@@ -6184,3 +6345,92 @@ static bool absolute_volume_disabled() {
     }
     return false;
 }
+
+static bool elem_attr_cache_allowed() {
+    char cache_enabled[PROPERTY_VALUE_MAX] = {0};
+    osi_property_get("persist.bluetooth.avrcpmetacache", cache_enabled, "false");
+    return strncmp(cache_enabled, "true", 4) == 0;
+}
+
+/*******************************************************************************
+**
+** Function         elem_attr_cache_send
+**
+** Description      Sends a copy of the cached GetElementAttributes response if
+**                  it holds exactly the requested attributes of the current
+**                  track.
+**
+** Returns          TRUE if the response was sent from the cache
+**
+*******************************************************************************/
+static BOOLEAN elem_attr_cache_send(int index, UINT8 label, UINT32 attr_mask)
+{
+    BT_HDR *p_msg = NULL;
+
+    if (!elem_attr_cache_enabled)
+        return FALSE;
+
+    pthread_mutex_lock(&elem_attr_cache_lock);
+    BT_HDR *p_cached = btif_rc_cb[index].rc_elem_attr_rsp;
+    if (p_cached != NULL && btif_rc_cb[index].rc_elem_attr_rsp_mask == attr_mask)
+    {
+        size_t size = BT_HDR_SIZE + p_cached->offset + p_cached->len;
+        p_msg = (BT_HDR *)osi_malloc(size);
+        memcpy(p_msg, p_cached, size);
+    }
+    pthread_mutex_unlock(&elem_attr_cache_lock);
+
+    if (p_msg == NULL)
+        return FALSE;
+
+    BTIF_TRACE_DEBUG("%s: label %d served from cache", __func__, label);
+    BTA_AvMetaRsp(btif_rc_cb[index].rc_handle, label, AVRC_RSP_IMPL_STBL, p_msg);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         elem_attr_cache_store
+**
+** Description      Keeps a copy of an encoded GetElementAttributes response
+**                  before it is handed to BTA_AvMetaRsp, which consumes it.
+**                  Responses are only kept while a single request is
+**                  outstanding, so the request attribute mask matches.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void elem_attr_cache_store(int index, BT_HDR *p_msg)
+{
+    if (!elem_attr_cache_enabled ||
+        btif_rc_cb[index].rc_pdu_info[IDX_GET_ELEMENT_ATTR_RSP].size != 0)
+        return;
+
+    size_t size = BT_HDR_SIZE + p_msg->offset + p_msg->len;
+    BT_HDR *p_cached = (BT_HDR *)osi_malloc(size);
+    memcpy(p_cached, p_msg, size);
+
+    pthread_mutex_lock(&elem_attr_cache_lock);
+    osi_free(btif_rc_cb[index].rc_elem_attr_rsp);
+    btif_rc_cb[index].rc_elem_attr_rsp = p_cached;
+    btif_rc_cb[index].rc_elem_attr_rsp_mask = btif_rc_cb[index].rc_elem_attr_req_mask;
+    pthread_mutex_unlock(&elem_attr_cache_lock);
+}
+
+/*******************************************************************************
+**
+** Function         elem_attr_cache_flush
+**
+** Description      Drops the cached GetElementAttributes response, e.g. when
+**                  the track changes or the controller disconnects.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void elem_attr_cache_flush(int index)
+{
+    pthread_mutex_lock(&elem_attr_cache_lock);
+    osi_free_and_reset((void **)&btif_rc_cb[index].rc_elem_attr_rsp);
+    btif_rc_cb[index].rc_elem_attr_rsp_mask = 0;
+    pthread_mutex_unlock(&elem_attr_cache_lock);
+}
@@ -0,0 +1,220 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_rc_txn.c
+ *
+ *  Description:   AVRCP transaction bookkeeping: the AVCTP transaction label
+ *                 pool and coalescing of SetAbsoluteVolume commands
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_btif_rc"
+
+#include <assert.h>
+#include <string.h>
+
+#include "btif_rc_txn.h"
+#include "osi/include/log.h"
+
+void rc_label_pool_init(rc_label_pool_t *pool)
+{
+    assert(pool != NULL);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void rc_label_pool_reset(rc_label_pool_t *pool)
+{
+    assert(pool != NULL);
+    pool->in_use_mask = 0;
+    pool->stats.in_use = 0;
+}
+
+bool rc_label_pool_alloc(rc_label_pool_t *pool, uint8_t *label)
+{
+    assert(pool != NULL);
+    assert(label != NULL);
+
+    for (int i = 0; i < RC_LABEL_POOL_SIZE; i++)
+    {
+        uint8_t lbl = (pool->next + i) % RC_LABEL_POOL_SIZE;
+        if (pool->in_use_mask & (1 << lbl))
+            continue;
+
+        pool->in_use_mask |= (1 << lbl);
+        pool->next = (lbl + 1) % RC_LABEL_POOL_SIZE;
+        pool->stats.allocations++;
+        if (++pool->stats.in_use > pool->stats.peak_in_use)
+            pool->stats.peak_in_use = pool->stats.in_use;
+        *label = lbl;
+        return true;
+    }
+
+    pool->stats.exhausted++;
+    return false;
+}
+
+bool rc_label_pool_release(rc_label_pool_t *pool, uint8_t label)
+{
+    assert(pool != NULL);
+
+    if (!rc_label_pool_is_allocated(pool, label))
+    {
+        pool->stats.stale_releases++;
+        return false;
+    }
+
+    pool->in_use_mask &= ~(1 << label);
+    pool->stats.in_use--;
+    pool->stats.releases++;
+    return true;
+}
+
+bool rc_label_pool_is_allocated(const rc_label_pool_t *pool, uint8_t label)
+{
+    assert(pool != NULL);
+    return label < RC_LABEL_POOL_SIZE && (pool->in_use_mask & (1 << label));
+}
+
+void rc_abs_vol_init(rc_abs_vol_t *vol, const rc_abs_vol_ops_t *ops,
+                     void *context)
+{
+    assert(vol != NULL);
+    assert(ops != NULL);
+
+    memset(vol, 0, sizeof(*vol));
+    vol->ops = ops;
+    vol->context = context;
+}
+
+bool rc_abs_vol_busy(const rc_abs_vol_t *vol)
+{
+    assert(vol != NULL);
+    return vol->outstanding;
+}
+
+bool rc_abs_vol_is_outstanding(const rc_abs_vol_t *vol, uint8_t label)
+{
+    assert(vol != NULL);
+    return vol->outstanding && label == vol->outstanding_label;
+}
+
+static rc_abs_vol_status_t abs_vol_send(rc_abs_vol_t *vol, uint8_t volume,
+                                        uint32_t now_ms)
+{
+    uint8_t label;
+    if (!vol->ops->send(vol->context, volume, &label))
+        return RC_ABS_VOL_FAILED;
+
+    vol->outstanding = true;
+    vol->outstanding_label = label;
+    vol->outstanding_volume = volume;
+    vol->sent_ms = now_ms;
+    if (vol->ops->start_timer)
+        vol->ops->start_timer(vol->context, RC_ABS_VOL_RSP_TIMEOUT_MS);
+    return RC_ABS_VOL_SENT;
+}
+
+/* Gives up on the outstanding command once it has gone unanswered for
+ * RC_ABS_VOL_RSP_TIMEOUT_MS. Returns true if there is none left. */
+static bool abs_vol_expire(rc_abs_vol_t *vol, uint32_t now_ms)
+{
+    if (!vol->outstanding)
+        return true;
+    if (now_ms - vol->sent_ms < RC_ABS_VOL_RSP_TIMEOUT_MS)
+        return false;
+
+    vol->outstanding = false;
+    if (vol->ops->abandon)
+        vol->ops->abandon(vol->context, vol->outstanding_label);
+    return true;
+}
+
+/* Sends the pending volume. If that fails the volume stays pending and the
+ * timer is armed to retry it. */
+static bool abs_vol_flush(rc_abs_vol_t *vol, uint32_t now_ms)
+{
+    if (!vol->pending)
+        return false;
+
+    if (abs_vol_send(vol, vol->pending_volume, now_ms) != RC_ABS_VOL_SENT)
+    {
+        vol->send_failures++;
+        LOG_WARN(LOG_TAG, "%s unable to send pending volume %d, retrying in %d ms",
+                 __func__, vol->pending_volume, RC_ABS_VOL_RSP_TIMEOUT_MS);
+        if (vol->ops->start_timer)
+            vol->ops->start_timer(vol->context, RC_ABS_VOL_RSP_TIMEOUT_MS);
+        return false;
+    }
+
+    vol->pending = false;
+    return true;
+}
+
+rc_abs_vol_status_t rc_abs_vol_set(rc_abs_vol_t *vol, uint8_t volume,
+                                   uint32_t now_ms)
+{
+    assert(vol != NULL);
+    assert(vol->ops != NULL);
+
+    /* Normally the timer has already abandoned an unanswered command */
+    if (abs_vol_expire(vol, now_ms))
+    {
+        if (vol->pending)
+        {
+            vol->pending = false;
+            vol->coalesced++;
+        }
+        return abs_vol_send(vol, volume, now_ms);
+    }
+
+    if (vol->pending)
+        vol->coalesced++;
+
+    /* The outstanding command already sets this volume */
+    vol->pending = (volume != vol->outstanding_volume);
+    vol->pending_volume = volume;
+    return RC_ABS_VOL_QUEUED;
+}
+
+bool rc_abs_vol_complete(rc_abs_vol_t *vol, uint8_t label, uint32_t now_ms)
+{
+    assert(vol != NULL);
+
+    if (!rc_abs_vol_is_outstanding(vol, label))
+        return false;
+
+    vol->outstanding = false;
+    if (vol->ops->stop_timer)
+        vol->ops->stop_timer(vol->context);
+    abs_vol_flush(vol, now_ms);
+    return true;
+}
+
+bool rc_abs_vol_timeout(rc_abs_vol_t *vol, uint32_t now_ms)
+{
+    assert(vol != NULL);
+    assert(vol->ops != NULL);
+
+    /* A timer that fired as its command completed belongs to a newer one */
+    if (!abs_vol_expire(vol, now_ms))
+        return false;
+
+    return abs_vol_flush(vol, now_ms);
+}
@@ -30,6 +30,7 @@
 #include <hardware/bt_sock.h>
 
 #include "osi/include/allocator.h"
+#include "osi/include/hash_map.h"
 #include "osi/include/log.h"
 
 #include "bt_target.h"
@@ -93,6 +94,8 @@ static bt_status_t btSock_start_l2cap_server_l(l2cap_socket *sock);
 static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
 
 l2cap_socket *socks = NULL;
+// Index of |socks| by socket id, used for every event lookup.
+static hash_map_t *socks_by_id = NULL;
 static uid_set_t* uid_set = NULL;
 static int pth = -1;
 
@@ -224,25 +227,21 @@ static char is_inited(void)
 /* only call with mutex taken */
 static l2cap_socket *btsock_l2cap_find_by_id_l(uint32_t id)
 {
-    l2cap_socket *sock = socks;
+    if (!socks_by_id)
+        return NULL;
 
-    while (sock && sock->id != id)
-        sock = sock->next;
-
-    return sock;
+    return (l2cap_socket *)hash_map_get(socks_by_id, UINT_TO_PTR(id));
 }
 
 static void btsock_l2cap_free_l(l2cap_socket *sock)
 {
     uint8_t *buf;
-    l2cap_socket *t = socks;
-
-    while(t && t != sock)
-        t = t->next;
 
-    if (!t) /* prever double-frees */
+    if (btsock_l2cap_find_by_id_l(sock->id) != sock) /* prever double-frees */
         return;
 
+    hash_map_erase(socks_by_id, UINT_TO_PTR(sock->id));
+
     if (sock->next)
         sock->next->prev = sock->prev;
 
@@ -341,21 +340,10 @@ static l2cap_socket *btsock_l2cap_alloc_l(const char *name, const bt_bdaddr_t *a
     sock->prev = NULL;
     if (socks)
         socks->prev = sock;
-    sock->id = (socks ? socks->id : 0) + 1;
+    /* paranoia cap on: no ID duplicates due to overflow */
+    sock->id = sock_id_index_next(socks_by_id, socks ? socks->id : 0);
     socks = sock;
-    /* paranoia cap on: verify no ID duplicates due to overflow and fix as needed */
-    while (1) {
-        l2cap_socket *t;
-        t = socks->next;
-        while (t && t->id != sock->id) {
-            t = t->next;
-        }
-        if (!t && sock->id) /* non-zeor handle is unique -> we're done */
-            break;
-        /* if we're here, we found a duplicate */
-        if (!++sock->id) /* no zero IDs allowed */
-            sock->id++;
-    }
+    hash_map_set(socks_by_id, UINT_TO_PTR(sock->id), sock);
     APPL_TRACE_DEBUG("SOCK_LIST: alloc(id = %d)", sock->id);
     return sock;
 
@@ -370,6 +358,8 @@ bt_status_t btsock_l2cap_init(int handle, uid_set_t* set)
     pthread_mutex_lock(&state_lock);
     pth = handle;
     socks = NULL;
+    hash_map_free(socks_by_id);
+    socks_by_id = sock_id_index_new();
     uid_set = set;
     pthread_mutex_unlock(&state_lock);
 
@@ -382,6 +372,8 @@ bt_status_t btsock_l2cap_cleanup()
     pth = -1;
     while (socks)
         btsock_l2cap_free_l(socks);
+    hash_map_free(socks_by_id);
+    socks_by_id = NULL;
     pthread_mutex_unlock(&state_lock);
 
     return BT_STATUS_SUCCESS;
@@ -649,14 +641,10 @@ static void on_l2cap_outgoing_congest(tBTA_JV_L2CAP_CONG *p, uint32_t id)
     pthread_mutex_unlock(&state_lock);
 }
 
-static void on_l2cap_write_done(void* req_id, uint16_t len, uint32_t id)
+static void on_l2cap_write_done(uint16_t len, uint32_t id)
 {
     l2cap_socket *sock;
 
-    if (req_id != NULL) {
-        osi_free(req_id); //free the buffer
-    }
-
     int app_uid = -1;
 
     pthread_mutex_lock(&state_lock);
@@ -674,14 +662,10 @@ static void on_l2cap_write_done(void* req_id, uint16_t len, uint32_t id)
     uid_set_add_tx(uid_set, app_uid, len);
 }
 
-static void on_l2cap_write_fixed_done(void* req_id, uint16_t len, uint32_t id)
+static void on_l2cap_write_fixed_done(uint16_t len, uint32_t id)
 {
     l2cap_socket *sock;
 
-    if (req_id != NULL) {
-        osi_free(req_id); //free the buffer
-    }
-
     int app_uid = -1;
     pthread_mutex_lock(&state_lock);
     sock = btsock_l2cap_find_by_id_l(id);
@@ -785,12 +769,12 @@ static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV *p_data, void *user_data
 
     case BTA_JV_L2CAP_WRITE_EVT:
         APPL_TRACE_DEBUG("BTA_JV_L2CAP_WRITE_EVT: id: %u", sock_id);
-        on_l2cap_write_done(UINT_TO_PTR(p_data->l2c_write.req_id), p_data->l2c_write.len, sock_id);
+        on_l2cap_write_done(p_data->l2c_write.len, sock_id);
         break;
 
     case BTA_JV_L2CAP_WRITE_FIXED_EVT:
         APPL_TRACE_DEBUG("BTA_JV_L2CAP_WRITE_FIXED_EVT: id: %u", sock_id);
-        on_l2cap_write_fixed_done(UINT_TO_PTR(p_data->l2c_write_fixed.req_id), p_data->l2c_write.len, sock_id);
+        on_l2cap_write_fixed_done(p_data->l2c_write_fixed.len, sock_id);
         break;
 
     case BTA_JV_L2CAP_CONG_EVT:
@@ -1045,57 +1029,36 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id)
 
                 if (!(flags & SOCK_THREAD_FD_EXCEPTION) || (ioctl(sock->our_fd, FIONREAD, &size)
                         == 0 && size)) {
-                    uint8_t *buffer = osi_malloc(L2CAP_MAX_SDU_LENGTH);
-                    /* Apparently we hijack the req_id (UINT32) to pass the pointer to the buffer to
-                     * the write complete callback, which call a free... wonder if this works on a
-                     * 64 bit platform? */
                     /* The socket is created with SOCK_SEQPACKET, hence we read one message at
-                     * the time. The maximum size of a message is allocated to ensure data is
-                     * not lost. This is okay to do as Android uses virtual memory, hence even
-                     * if we only use a fraction of the memory it should not block for others
-                     * to use the memory. As the definition of ioctl(FIONREAD) do not clearly
-                     * define what value will be returned if multiple messages are written to
-                     * the socket before any message is read from the socket, we could
-                     * potentially risk to allocate way more memory than needed. One of the use
-                     * cases for this socket is obex where multiple 64kbyte messages are
-                     * typically written to the socket in a tight loop, hence we risk the ioctl
-                     * will return the total amount of data in the buffer, which could be
-                     * multiple 64kbyte chunks.
-                     * UPDATE: As the stack cannot handle 64kbyte buffers, the size is reduced
-                     * to around 8kbyte - and using malloc for buffer allocation here seems to
-                     * be wrong
-                     * UPDATE: Since we are responsible for freeing the buffer in the
-                     * write_complete_ind, it is OK to use malloc. */
-                    ssize_t count;
-                    OSI_NO_INTR(count = recv(fd, buffer, L2CAP_MAX_SDU_LENGTH,
-                                             MSG_NOSIGNAL | MSG_DONTWAIT));
-                    APPL_TRACE_DEBUG("btsock_l2cap_signaled - %d bytes received from socket",
-                                     count);
-
-                    // TODO(armansito): |buffer|, which is created above via
-                    // malloc, is being cast below to UINT32 to be used as
-                    // the |req_id| parameter of BTA_JvL2capWriteFixed and
-                    // BTA_JvL2capWrite. The "id" then gets freed in an
-                    // obscure callback elsewhere. We need to watch out for
-                    // this type of unsafe practice, as this is error prone
-                    // and difficult to follow.
-                    if (sock->fixed_chan) {
-                        if (BTA_JvL2capWriteFixed(sock->channel,
-                                                  (BD_ADDR*)&sock->addr,
-                                                  PTR_TO_UINT(buffer),
-                                                  btsock_l2cap_cbk, buffer,
-                                                  count,
-                                                  UINT_TO_PTR(user_id)) != BTA_JV_SUCCESS) {
-                            // On fail, free the buffer
-                            on_l2cap_write_fixed_done(buffer, count, user_id);
+                     * the time. The buffer is sized to the message with the L2CAP headroom
+                     * reserved, and BTA JV takes ownership of it, so the payload is not copied
+                     * again on its way to L2CAP. In ERTM mode L2CAP appends the FCS to the
+                     * frame in place, so room for it is kept after the payload. */
+                    BT_HDR *p_buf = sock_recv_msg_buf(fd, L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                                      L2CAP_MAX_SDU_LENGTH);
+                    if (p_buf) {
+                        uint16_t count = p_buf->len;
+                        APPL_TRACE_DEBUG("btsock_l2cap_signaled - %d bytes received from socket",
+                                         count);
+
+                        if (sock->fixed_chan) {
+                            if (BTA_JvL2capWriteFixed(sock->channel,
+                                                      (BD_ADDR*)&sock->addr,
+                                                      sock->id,
+                                                      btsock_l2cap_cbk, p_buf,
+                                                      UINT_TO_PTR(user_id)) != BTA_JV_SUCCESS) {
+                                on_l2cap_write_fixed_done(count, user_id);
+                            }
+                        } else {
+                            if (BTA_JvL2capWrite(sock->handle, sock->id, p_buf,
+                                                 UINT_TO_PTR(user_id)) != BTA_JV_SUCCESS) {
+                                on_l2cap_write_done(count, user_id);
+                            }
                         }
                     } else {
-                        if (BTA_JvL2capWrite(sock->handle, PTR_TO_UINT(buffer),
-                                             buffer, count,
-                                             UINT_TO_PTR(user_id)) != BTA_JV_SUCCESS) {
-                          // On fail, free the buffer
-                          on_l2cap_write_done(buffer, count, user_id);
-                        }
+                        //nothing to send, keep monitoring the fd for outgoing data
+                        btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_RD,
+                                             sock->id);
                     }
                 }
             } else
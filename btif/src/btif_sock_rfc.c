@@ -95,6 +95,9 @@ typedef struct {
   list_t *incoming_queue;
 } rfc_slot_t;
 
+// Slot ids are tagged with the slot index: a slot at index |i| is always
+// given an id with |id % MAX_RFC_CHANNEL == i|, so lookups by id go straight
+// to the slot and only have to compare the id to reject stale ones.
 static rfc_slot_t rfc_slots[MAX_RFC_CHANNEL];
 static uint32_t rfc_slot_id;
 static volatile int pth = -1; // poll thread handle
@@ -153,9 +156,9 @@ static rfc_slot_t *find_free_slot(void) {
 static rfc_slot_t *find_rfc_slot_by_id(uint32_t id) {
   assert(id != 0);
 
-  for (size_t i = 0; i < ARRAY_SIZE(rfc_slots); ++i)
-    if (rfc_slots[i].id == id)
-      return &rfc_slots[i];
+  rfc_slot_t *slot = &rfc_slots[id % MAX_RFC_CHANNEL];
+  if (slot->id == id)
+    return slot;
 
   LOG_ERROR(LOG_TAG, "%s unable to find RFCOMM slot id: %d", __func__, id);
   return NULL;
@@ -224,9 +227,7 @@ static rfc_slot_t *alloc_rfc_slot(const bt_bdaddr_t *addr, const char *name, con
     return NULL;
   }
 
-  // Increment slot id and make sure we don't use id=0.
-  if (++rfc_slot_id == 0)
-    rfc_slot_id = 1;
+  rfc_slot_id = sock_slot_id_next(rfc_slot_id, slot - rfc_slots, MAX_RFC_CHANNEL);
 
   slot->fd = fds[0];
   slot->app_fd = fds[1];
@@ -840,57 +841,16 @@ static void jv_dm_cback(tBTA_JV_EVT event, tBTA_JV *p_data, void *user_data) {
   }
 }
 
-typedef enum {
-  SENT_FAILED,
-  SENT_NONE,
-  SENT_PARTIAL,
-  SENT_ALL,
-} sent_status_t;
-
-static sent_status_t send_data_to_app(int fd, BT_HDR *p_buf) {
-  if (p_buf->len == 0)
-    return SENT_ALL;
-
-  ssize_t sent;
-  OSI_NO_INTR(sent = send(fd, p_buf->data + p_buf->offset, p_buf->len,
-                          MSG_DONTWAIT));
-
-  if (sent == -1) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK)
-      return SENT_NONE;
+static bool flush_incoming_que_on_wr_signal(rfc_slot_t *slot) {
+  if (sock_send_buf_list(slot->fd, slot->incoming_queue) == -1) {
     LOG_ERROR(LOG_TAG, "%s error writing RFCOMM data back to app: %s", __func__, strerror(errno));
-    return SENT_FAILED;
+    return false;
   }
 
-  if (sent == 0)
-    return SENT_FAILED;
-
-  if (sent == p_buf->len)
-    return SENT_ALL;
-
-  p_buf->offset += sent;
-  p_buf->len -= sent;
-  return SENT_PARTIAL;
-}
-
-static bool flush_incoming_que_on_wr_signal(rfc_slot_t *slot) {
-  while (!list_is_empty(slot->incoming_queue)) {
-    BT_HDR *p_buf = list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
-      case SENT_NONE:
-      case SENT_PARTIAL:
-        //monitor the fd to get callback when app is ready to receive data
-        btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR, slot->id);
-        return true;
-
-      case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
-        break;
-
-      case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
-        return false;
-    }
+  if (!list_is_empty(slot->incoming_queue)) {
+    //monitor the fd to get callback when app is ready to receive data
+    btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR, slot->id);
+    return true;
   }
 
   //app is ready to receive data, tell stack to start the data flow
@@ -959,26 +919,19 @@ int bta_co_rfc_data_incoming(void *user_data, BT_HDR *p_buf) {
   app_uid = slot->app_uid;
   bytes_rx = p_buf->len;
 
-  if (list_is_empty(slot->incoming_queue)) {
-    switch (send_data_to_app(slot->fd, p_buf)) {
-      case SENT_NONE:
-      case SENT_PARTIAL:
-        list_append(slot->incoming_queue, p_buf);
-        btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR, slot->id);
-        break;
-
-      case SENT_ALL:
-        osi_free(p_buf);
-        ret = 1;  // Enable data flow.
-        break;
-
-      case SENT_FAILED:
-        osi_free(p_buf);
-        cleanup_rfc_slot(slot);
-        break;
+  // Queue the frame behind any data the app has not taken yet. If nothing was
+  // waiting, send it right away straight out of the received buffer.
+  bool queue_was_empty = list_is_empty(slot->incoming_queue);
+  list_append(slot->incoming_queue, p_buf);
+  if (queue_was_empty) {
+    if (sock_send_buf_list(slot->fd, slot->incoming_queue) == -1) {
+      LOG_ERROR(LOG_TAG, "%s error writing RFCOMM data back to app: %s", __func__, strerror(errno));
+      cleanup_rfc_slot(slot);
+    } else if (list_is_empty(slot->incoming_queue)) {
+      ret = 1;  // Enable data flow.
+    } else {
+      btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR, slot->id);
     }
-  } else {
-    list_append(slot->incoming_queue, p_buf);
   }
 
 out:;
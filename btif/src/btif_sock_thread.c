@@ -20,7 +20,7 @@
  *
  *  Filename:      btif_sock_thread.c
  *
- *  Description:   socket select thread
+ *  Description:   socket epoll thread
  *
  *
  ***********************************************************************************/
@@ -39,8 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -53,44 +52,55 @@
 #include "btif_sock.h"
 #include "btif_sock_util.h"
 #include "btif_util.h"
+#include "osi/include/allocator.h"
+#include "osi/include/hash_functions.h"
+#include "osi/include/hash_map.h"
+#include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
 
 #define asrt(s) if(!(s)) APPL_TRACE_ERROR("## %s assert %s failed at line:%d ##",__FUNCTION__, #s, __LINE__)
 #define print_events(events) do { \
-    APPL_TRACE_DEBUG("print poll event:%x", events); \
-    if (events & POLLIN) APPL_TRACE_DEBUG(  "   POLLIN "); \
-    if (events & POLLPRI) APPL_TRACE_DEBUG( "   POLLPRI "); \
-    if (events & POLLOUT) APPL_TRACE_DEBUG( "   POLLOUT "); \
-    if (events & POLLERR) APPL_TRACE_DEBUG( "   POLLERR "); \
-    if (events & POLLHUP) APPL_TRACE_DEBUG( "   POLLHUP "); \
-    if (events & POLLNVAL) APPL_TRACE_DEBUG("   POLLNVAL "); \
-    if (events & POLLRDHUP) APPL_TRACE_DEBUG("   POLLRDHUP"); \
+    APPL_TRACE_DEBUG("print epoll event:%x", events); \
+    if (events & EPOLLIN) APPL_TRACE_DEBUG(  "   EPOLLIN "); \
+    if (events & EPOLLPRI) APPL_TRACE_DEBUG( "   EPOLLPRI "); \
+    if (events & EPOLLOUT) APPL_TRACE_DEBUG( "   EPOLLOUT "); \
+    if (events & EPOLLERR) APPL_TRACE_DEBUG( "   EPOLLERR "); \
+    if (events & EPOLLHUP) APPL_TRACE_DEBUG( "   EPOLLHUP "); \
+    if (events & EPOLLRDHUP) APPL_TRACE_DEBUG("   EPOLLRDHUP"); \
     } while(0)
 
 #define MAX_THREAD 8
-#define MAX_POLL 64
-#define POLL_EXCEPTION_EVENTS (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL)
+// Number of events harvested per epoll_wait() call. This is a batch size only,
+// not a limit on the number of file descriptors a thread can monitor.
+#define MAX_EVENTS 64
+#define POLL_SLOT_BUCKETS 128
+#define POLL_EXCEPTION_EVENTS (EPOLLHUP | EPOLLRDHUP | EPOLLERR)
 #define IS_EXCEPTION(e) ((e) & POLL_EXCEPTION_EVENTS)
-#define IS_READ(e) ((e) & POLLIN)
-#define IS_WRITE(e) ((e) & POLLOUT)
+#define IS_READ(e) ((e) & EPOLLIN)
+#define IS_WRITE(e) ((e) & EPOLLOUT)
 /*cmd executes in socket poll thread */
 #define CMD_WAKEUP       1
 #define CMD_EXIT         2
-#define CMD_ADD_FD       3
 #define CMD_REMOVE_FD    4
 #define CMD_USER_PRIVATE 5
 
+// Monitored file descriptors are registered with EPOLLONESHOT: once an event
+// is reported the kernel disarms the descriptor until it is re-armed with
+// EPOLL_CTL_MOD. Re-arming is done directly by |btsock_thread_add_fd| from
+// whichever thread calls it, so no command needs to be sent to the poll
+// thread. |poll_slots| holds the requested flags for each descriptor and is
+// guarded by |slot_lock|.
 typedef struct {
-    struct pollfd pfd;
+    int fd;
     uint32_t user_id;
     int type;
     int flags;
 } poll_slot_t;
 typedef struct {
     int cmd_fdr, cmd_fdw;
-    int poll_count;
-    poll_slot_t ps[MAX_POLL];
-    int psi[MAX_POLL]; //index of poll slot
+    int epoll_fd;
+    hash_map_t *poll_slots;
+    pthread_mutex_t slot_lock;
     volatile pthread_t thread_id;
     btsock_signaled_cb callback;
     btsock_cmd_cb cmd_callback;
@@ -131,7 +141,8 @@ static inline int create_thread(void *(*start_routine)(void *), void * arg,
     pthread_setschedparam(*thread_id, policy, &param);
     return ret;
 }
-static void init_poll(int cmd_fd);
+static bool init_poll(int h);
+static void cleanup_poll(int h);
 static int alloc_thread_slot()
 {
     int i;
@@ -153,6 +164,7 @@ static void free_thread_slot(int h)
     if(0 <= h && h < MAX_THREAD)
     {
         close_cmd_fd(h);
+        cleanup_poll(h);
         ts[h].used = 0;
     }
     else APPL_TRACE_ERROR("invalid thread handle:%d", h);
@@ -168,9 +180,11 @@ int btsock_thread_init()
         for(h = 0; h < MAX_THREAD; h++)
         {
             ts[h].cmd_fdr = ts[h].cmd_fdw = -1;
+            ts[h].epoll_fd = -1;
+            ts[h].poll_slots = NULL;
+            pthread_mutex_init(&ts[h].slot_lock, NULL);
             ts[h].used = 0;
             ts[h].thread_id = -1;
-            ts[h].poll_count = 0;
             ts[h].callback = NULL;
             ts[h].cmd_callback = NULL;
         }
@@ -186,36 +200,53 @@ int btsock_thread_create(btsock_signaled_cb callback, btsock_cmd_cb cmd_callback
     APPL_TRACE_DEBUG("alloc_thread_slot ret:%d", h);
     if(h >= 0)
     {
-        init_poll(h);
+        if(!init_poll(h))
+        {
+            pthread_mutex_lock(&thread_slot_lock);
+            free_thread_slot(h);
+            pthread_mutex_unlock(&thread_slot_lock);
+            return -1;
+        }
+        ts[h].callback = callback;
+        ts[h].cmd_callback = cmd_callback;
         pthread_t thread;
         int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
         if (status)
         {
             APPL_TRACE_ERROR("create_thread failed: %s", strerror(status));
+            pthread_mutex_lock(&thread_slot_lock);
             free_thread_slot(h);
+            pthread_mutex_unlock(&thread_slot_lock);
             return -1;
         }
 
         ts[h].thread_id = thread;
         APPL_TRACE_DEBUG("h:%d, thread id:%d", h, ts[h].thread_id);
-        ts[h].callback = callback;
-        ts[h].cmd_callback = cmd_callback;
     }
     return h;
 }
 
-/* create dummy socket pair used to wake up select loop */
-static inline void init_cmd_fd(int h)
+/* create dummy socket pair used to wake up the epoll loop */
+static inline bool init_cmd_fd(int h)
 {
     asrt(ts[h].cmd_fdr == -1 && ts[h].cmd_fdw == -1);
     if(socketpair(AF_UNIX, SOCK_STREAM, 0, &ts[h].cmd_fdr) < 0)
     {
         APPL_TRACE_ERROR("socketpair failed: %s", strerror(errno));
-        return;
+        return false;
     }
     APPL_TRACE_DEBUG("h:%d, cmd_fdr:%d, cmd_fdw:%d", h, ts[h].cmd_fdr, ts[h].cmd_fdw);
-    //add the cmd fd for read & write
-    add_poll(h, ts[h].cmd_fdr, 0, SOCK_THREAD_FD_RD, 0);
+    //the cmd fd is level triggered and never disarmed
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = ts[h].cmd_fdr;
+    if(epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ts[h].cmd_fdr, &event) == -1)
+    {
+        APPL_TRACE_ERROR("unable to register cmd fd:%d, err:%s", ts[h].cmd_fdr, strerror(errno));
+        return false;
+    }
+    return true;
 }
 static inline void close_cmd_fd(int h)
 {
@@ -245,30 +276,16 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id)
         APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
         return FALSE;
     }
-    if(ts[h].cmd_fdw == -1)
+    if(ts[h].epoll_fd == -1)
     {
-        APPL_TRACE_ERROR("cmd socket is not created. socket thread may not initialized");
+        APPL_TRACE_ERROR("epoll fd is not created. socket thread may not initialized");
         return FALSE;
     }
-    if(flags & SOCK_THREAD_ADD_FD_SYNC)
-    {
-        //must executed in socket poll thread
-        if(ts[h].thread_id == pthread_self())
-        {
-            //cleanup one-time flags
-            flags &= ~SOCK_THREAD_ADD_FD_SYNC;
-            add_poll(h, fd, type, flags, user_id);
-            return TRUE;
-        }
-        APPL_TRACE_DEBUG("THREAD_ADD_FD_SYNC is not called in poll thread, fallback to async");
-    }
-    sock_cmd_t cmd = {CMD_ADD_FD, fd, type, flags, user_id};
+    //epoll_ctl may be called from any thread, so every add is synchronous
+    flags &= ~SOCK_THREAD_ADD_FD_SYNC;
     APPL_TRACE_DEBUG("adding fd:%d, flags:0x%x", fd, flags);
-
-    ssize_t ret;
-    OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
-
-    return ret == sizeof(cmd);
+    add_poll(h, fd, type, flags, user_id);
+    return TRUE;
 }
 
 bool btsock_thread_remove_fd_and_close(int thread_handle, int fd)
@@ -367,6 +384,7 @@ int btsock_thread_exit(int h)
 
     if (ret == sizeof(cmd)) {
         pthread_join(ts[h].thread_id, 0);
+        ts[h].thread_id = -1;
         pthread_mutex_lock(&thread_slot_lock);
         free_thread_slot(h);
         pthread_mutex_unlock(&thread_slot_lock);
@@ -374,87 +392,126 @@ int btsock_thread_exit(int h)
     }
     return FALSE;
 }
-static void init_poll(int h)
+static bool init_poll(int h)
 {
-    int i;
-    ts[h].poll_count = 0;
     ts[h].thread_id = -1;
     ts[h].callback = NULL;
     ts[h].cmd_callback = NULL;
-    for(i = 0; i < MAX_POLL; i++)
+    ts[h].poll_slots = hash_map_new(POLL_SLOT_BUCKETS, hash_function_integer,
+            NULL, osi_free, NULL);
+    ts[h].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(ts[h].epoll_fd == -1)
     {
-        ts[h].ps[i].pfd.fd = -1;
-        ts[h].psi[i] = -1;
+        APPL_TRACE_ERROR("epoll_create1 failed: %s", strerror(errno));
+        return false;
     }
-    init_cmd_fd(h);
+    return init_cmd_fd(h);
 }
-static inline unsigned int flags2pevents(int flags)
+static void cleanup_poll(int h)
 {
-    unsigned int pevents = 0;
+    if(ts[h].epoll_fd != -1)
+    {
+        close(ts[h].epoll_fd);
+        ts[h].epoll_fd = -1;
+    }
+    pthread_mutex_lock(&ts[h].slot_lock);
+    hash_map_free(ts[h].poll_slots);
+    ts[h].poll_slots = NULL;
+    pthread_mutex_unlock(&ts[h].slot_lock);
+}
+static inline uint32_t flags2pevents(int flags)
+{
+    uint32_t pevents = EPOLLONESHOT;
     if(flags & SOCK_THREAD_FD_WR)
-        pevents |= POLLOUT;
+        pevents |= EPOLLOUT;
     if(flags & SOCK_THREAD_FD_RD)
-        pevents |= POLLIN;
+        pevents |= EPOLLIN;
     pevents |= POLL_EXCEPTION_EVENTS;
     return pevents;
 }
 
+/* must be called with slot_lock held. Arms the one-shot interest for |ps| and
+ * returns EPOLL_CTL_MOD if the fd was already registered, EPOLL_CTL_ADD if it
+ * had to be registered or -1 on failure */
+static inline int arm_poll(int h, poll_slot_t* ps)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = flags2pevents(ps->flags);
+    event.data.fd = ps->fd;
+
+    //fds stay registered (disarmed) after their slot is dropped, so try to
+    //modify before adding
+    if(epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_MOD, ps->fd, &event) == 0)
+        return EPOLL_CTL_MOD;
+    if(errno == ENOENT && epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ps->fd, &event) == 0)
+        return EPOLL_CTL_ADD;
+    APPL_TRACE_ERROR("unable to arm fd:%d, err:%s", ps->fd, strerror(errno));
+    return -1;
+}
+
+/* must be called with slot_lock held */
 static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags, uint32_t user_id)
 {
-    ps->pfd.fd = fd;
+    ps->fd = fd;
     ps->user_id = user_id;
     if(ps->type != 0 && ps->type != type)
         APPL_TRACE_ERROR("poll socket type should not changed! type was:%d, type now:%d", ps->type, type);
     ps->type = type;
     ps->flags = flags;
-    ps->pfd.events = flags2pevents(flags);
-    ps->pfd.revents = 0;
 }
 static inline void add_poll(int h, int fd, int type, int flags, uint32_t user_id)
 {
     asrt(fd != -1);
-    int i;
-    int empty = -1;
-    poll_slot_t* ps = ts[h].ps;
-
-    for(i = 0; i < MAX_POLL; i++)
+    pthread_mutex_lock(&ts[h].slot_lock);
+    poll_slot_t* ps = (poll_slot_t*)hash_map_get(ts[h].poll_slots, INT_TO_PTR(fd));
+    if(ps)
     {
-        if(ps[i].pfd.fd == fd)
+        ps->flags |= flags;
+        if(arm_poll(h, ps) == EPOLL_CTL_ADD)
         {
-            asrt(ts[h].poll_count < MAX_POLL);
-
-            set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
-            return;
+            //the fd was closed without being removed and its number reused,
+            //so the slot's flags and type are stale
+            ps->flags = flags;
+            ps->type = 0;
+            arm_poll(h, ps);
         }
-        else if(empty < 0 && ps[i].pfd.fd == -1)
-            empty = i;
+        set_poll(ps, fd, type, ps->flags, user_id);
     }
-    if(empty >= 0)
+    else
     {
-        asrt(ts[h].poll_count < MAX_POLL);
-        set_poll(&ps[empty], fd, type, flags, user_id);
-        ++ts[h].poll_count;
-        return;
+        ps = (poll_slot_t*)osi_calloc(sizeof(poll_slot_t));
+        set_poll(ps, fd, type, flags, user_id);
+        hash_map_set(ts[h].poll_slots, INT_TO_PTR(fd), ps);
+        arm_poll(h, ps);
     }
-    APPL_TRACE_ERROR("exceeded max poll slot:%d!", MAX_POLL);
+    pthread_mutex_unlock(&ts[h].slot_lock);
 }
+/* must be called with slot_lock held */
 static inline void remove_poll(int h, poll_slot_t* ps, int flags)
 {
+    int fd = ps->fd;
     if(flags == ps->flags)
     {
-        //all monitored events signaled. To remove it, just clear the slot
-        --ts[h].poll_count;
-        memset(ps, 0, sizeof(*ps));
-        ps->pfd.fd = -1;
+        //all monitored events signaled. To remove it, just drop the slot. The
+        //fd stays registered but disarmed until it is added again.
+        hash_map_erase(ts[h].poll_slots, INT_TO_PTR(fd));
     }
     else
     {
         //one read or one write monitor event signaled, removed the accordding bit
         ps->flags &= ~flags;
-        //update the poll events mask
-        ps->pfd.events = flags2pevents(ps->flags);
+        //re-arm the remaining events
+        arm_poll(h, ps);
     }
 }
+static inline void delete_poll(int h, int fd)
+{
+    pthread_mutex_lock(&ts[h].slot_lock);
+    hash_map_erase(ts[h].poll_slots, INT_TO_PTR(fd));
+    epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    pthread_mutex_unlock(&ts[h].slot_lock);
+}
 static int process_cmd_sock(int h)
 {
     sock_cmd_t cmd = {-1, 0, 0, 0, 0};
@@ -471,19 +528,8 @@ static int process_cmd_sock(int h)
     APPL_TRACE_DEBUG("cmd.id:%d", cmd.id);
     switch(cmd.id)
     {
-        case CMD_ADD_FD:
-            add_poll(h, cmd.fd, cmd.type, cmd.flags, cmd.user_id);
-            break;
         case CMD_REMOVE_FD:
-            for (int i = 1; i < MAX_POLL; ++i)
-            {
-                poll_slot_t *poll_slot = &ts[h].ps[i];
-                if (poll_slot->pfd.fd == cmd.fd)
-                {
-                    remove_poll(h, poll_slot, poll_slot->flags);
-                    break;
-                }
-            }
+            delete_poll(h, cmd.fd);
             close(cmd.fd);
             break;
         case CMD_WAKEUP:
@@ -501,105 +547,83 @@ static int process_cmd_sock(int h)
     }
     return TRUE;
 }
-static void process_data_sock(int h, struct pollfd *pfds, int count)
+static void process_data_sock(int h, const struct epoll_event *event)
 {
-    asrt(count <= ts[h].poll_count);
-    int i;
-    for( i= 1; i < ts[h].poll_count; i++)
+    int fd = event->data.fd;
+    uint32_t user_id;
+    int type;
+    int flags = 0;
+
+    pthread_mutex_lock(&ts[h].slot_lock);
+    poll_slot_t* ps = (poll_slot_t*)hash_map_get(ts[h].poll_slots, INT_TO_PTR(fd));
+    if(!ps)
     {
-        if(pfds[i].revents)
-        {
-            int ps_i = ts[h].psi[i];
-            asrt(pfds[i].fd == ts[h].ps[ps_i].pfd.fd);
-            uint32_t user_id = ts[h].ps[ps_i].user_id;
-            int type = ts[h].ps[ps_i].type;
-            int flags = 0;
-            print_events(pfds[i].revents);
-            if(IS_READ(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_RD;
-            }
-            if(IS_WRITE(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_WR;
-            }
-            if(IS_EXCEPTION(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_EXCEPTION;
-                //remove the whole slot not flags
-                remove_poll(h, &ts[h].ps[ps_i], ts[h].ps[ps_i].flags);
-            }
-            else if(flags)
-                 remove_poll(h, &ts[h].ps[ps_i], flags); //remove the monitor flags that already processed
-            if(flags)
-                ts[h].callback(pfds[i].fd, type, flags, user_id);
-        }
+        //removed while the event was pending
+        pthread_mutex_unlock(&ts[h].slot_lock);
+        return;
     }
-}
-
-static void prepare_poll_fds(int h, struct pollfd* pfds)
-{
-    int count = 0;
-    int ps_i = 0;
-    int pfd_i = 0;
-    asrt(ts[h].poll_count <= MAX_POLL);
-    memset(pfds, 0, sizeof(pfds[0])*ts[h].poll_count);
-    while(count < ts[h].poll_count)
-    {
-        if(ps_i >= MAX_POLL)
-        {
-            APPL_TRACE_ERROR("exceed max poll range, ps_i:%d, MAX_POLL:%d, count:%d, ts[h].poll_count:%d",
-                    ps_i, MAX_POLL, count, ts[h].poll_count);
-            return;
-        }
-        if(ts[h].ps[ps_i].pfd.fd >= 0 && pfd_i < MAX_POLL)
-        {
-            pfds[pfd_i] =  ts[h].ps[ps_i].pfd;
-            ts[h].psi[pfd_i] = ps_i;
-            count++;
-            pfd_i++;
-        }
-        ps_i++;
+    user_id = ps->user_id;
+    type = ps->type;
+    print_events(event->events);
+    if(IS_READ(event->events) && (ps->flags & SOCK_THREAD_FD_RD))
+    {
+        flags |= SOCK_THREAD_FD_RD;
+    }
+    if(IS_WRITE(event->events) && (ps->flags & SOCK_THREAD_FD_WR))
+    {
+        flags |= SOCK_THREAD_FD_WR;
     }
+    if(IS_EXCEPTION(event->events))
+    {
+        flags |= SOCK_THREAD_FD_EXCEPTION;
+        //remove the whole slot not flags
+        hash_map_erase(ts[h].poll_slots, INT_TO_PTR(fd));
+        epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    else if(flags)
+        remove_poll(h, ps, flags); //remove the monitor flags that already processed
+    else
+        arm_poll(h, ps); //stale event from an earlier arm, keep monitoring
+    pthread_mutex_unlock(&ts[h].slot_lock);
+
+    if(flags)
+        ts[h].callback(fd, type, flags, user_id);
 }
+
 static void *sock_poll_thread(void *arg)
 {
-    struct pollfd pfds[MAX_POLL];
-    memset(pfds, 0, sizeof(pfds));
+    struct epoll_event events[MAX_EVENTS];
     int h = (intptr_t)arg;
 
     prctl(PR_SET_NAME, (unsigned long)"btif_sock_poll", 0, 0, 0);
     for(;;)
     {
-        prepare_poll_fds(h, pfds);
         int ret;
-        OSI_NO_INTR(ret = poll(pfds, ts[h].poll_count, -1));
+        OSI_NO_INTR(ret = epoll_wait(ts[h].epoll_fd, events, MAX_EVENTS, -1));
         if(ret == -1)
         {
-            APPL_TRACE_ERROR("poll ret -1, exit the thread, errno:%d, err:%s", errno, strerror(errno));
+            APPL_TRACE_ERROR("epoll_wait ret -1, exit the thread, errno:%d, err:%s", errno, strerror(errno));
             break;
         }
-        if(ret != 0)
+        //commands are processed before data so removed fds are not signaled
+        bool should_exit = false;
+        for(int i = 0; i < ret; i++)
         {
-            int need_process_data_fd = TRUE;
-            if(pfds[0].revents) //cmd fd always is the first one
+            if(events[i].data.fd == ts[h].cmd_fdr && !process_cmd_sock(h))
             {
-                asrt(pfds[0].fd == ts[h].cmd_fdr);
-                if(!process_cmd_sock(h))
-                {
-                    APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
-                    break;
-                }
-                if(ret == 1)
-                    need_process_data_fd = FALSE;
-                else ret--; //exclude the cmd fd
+                APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
+                should_exit = true;
+                break;
             }
-            if(need_process_data_fd)
-                process_data_sock(h, pfds, ret);
         }
-        else {APPL_TRACE_DEBUG("no data, select ret: %d", ret)};
+        if(should_exit)
+            break;
+        for(int i = 0; i < ret; i++)
+        {
+            if(events[i].data.fd != ts[h].cmd_fdr)
+                process_data_sock(h, &events[i]);
+        }
     }
-    ts[h].thread_id = -1;
     APPL_TRACE_DEBUG("socket poll thread exiting, h:%d", h);
     return 0;
 }
@@ -49,10 +49,15 @@
 #include "btu.h"
 #include "bt_common.h"
 #include "hcimsgs.h"
+#include "osi/include/allocator.h"
+#include "osi/include/hash_functions.h"
 #include "osi/include/log.h"
 #include "port_api.h"
 #include "sdp_api.h"
 
+/* Buffers gathered into one sendmsg() by sock_send_buf_list */
+#define SOCK_SEND_MAX_IOV 16
+
 #define asrt(s) if(!(s)) BTIF_TRACE_ERROR("## %s assert %s failed at line:%d ##",__FUNCTION__, #s, __LINE__)
 
 int sock_send_all(int sock_fd, const uint8_t* buf, int len)
@@ -147,6 +152,133 @@ int sock_send_fd(int sock_fd, const uint8_t* buf, int len, int send_fd)
     return ret_len;
 }
 
+BT_HDR *sock_recv_msg_buf(int sock_fd, uint16_t headroom, uint16_t tailroom,
+                          uint16_t max_len)
+{
+    //peek at the real length of the next message so the buffer can be sized
+    //to it instead of to the largest possible message
+    ssize_t size;
+    OSI_NO_INTR(size = recv(sock_fd, NULL, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT));
+    if(size == 0)
+    {
+        //drop an empty message so it does not stay at the head of the queue
+        OSI_NO_INTR(size = recv(sock_fd, NULL, 0, MSG_DONTWAIT));
+        return NULL;
+    }
+    if(size < 0)
+        return NULL;
+    if(size > max_len)
+    {
+        BTIF_TRACE_ERROR("sock fd:%d message of %d bytes truncated to %d", sock_fd, size, max_len);
+        size = max_len;
+    }
+
+    BT_HDR *p_buf = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + headroom + size + tailroom);
+    p_buf->offset = headroom;
+    p_buf->layer_specific = 0;
+
+    ssize_t ret;
+    OSI_NO_INTR(ret = recv(sock_fd, (uint8_t *)(p_buf + 1) + headroom, size,
+                           MSG_NOSIGNAL | MSG_DONTWAIT));
+    if(ret <= 0)
+    {
+        BTIF_TRACE_ERROR("sock fd:%d recv errno:%d, ret:%d", sock_fd, errno, ret);
+        osi_free(p_buf);
+        return NULL;
+    }
+    p_buf->len = ret;
+    return p_buf;
+}
+
+ssize_t sock_send_buf_list(int sock_fd, list_t *bufs)
+{
+    ssize_t total = 0;
+
+    while(!list_is_empty(bufs))
+    {
+        struct iovec iov[SOCK_SEND_MAX_IOV];
+        size_t iovcnt = 0;
+        size_t want = 0;
+        for(const list_node_t *node = list_begin(bufs);
+            node != list_end(bufs) && iovcnt < SOCK_SEND_MAX_IOV;
+            node = list_next(node))
+        {
+            BT_HDR *p_buf = (BT_HDR *)list_node(node);
+            iov[iovcnt].iov_base = (uint8_t *)(p_buf + 1) + p_buf->offset;
+            iov[iovcnt].iov_len = p_buf->len;
+            want += p_buf->len;
+            iovcnt++;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent;
+        OSI_NO_INTR(sent = sendmsg(sock_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL));
+        if(sent == -1)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            BTIF_TRACE_ERROR("sock fd:%d sendmsg errno:%d", sock_fd, errno);
+            return -1;
+        }
+        total += sent;
+
+        //drop the buffers that went out completely and advance the one that
+        //went out in part
+        size_t left = sent;
+        for(size_t i = 0; i < iovcnt; i++)
+        {
+            BT_HDR *p_buf = (BT_HDR *)list_front(bufs);
+            if(left < p_buf->len)
+            {
+                p_buf->offset += left;
+                p_buf->len -= left;
+                break;
+            }
+            left -= p_buf->len;
+            list_remove(bufs, p_buf);
+        }
+
+        if((size_t)sent < want)
+            break;
+    }
+    return total;
+}
+
+// Socket ids are small and handed out in sequence, so they spread evenly and
+// the index rarely has to grow past this.
+#define SOCK_ID_INDEX_BUCKETS 256
+
+hash_map_t *sock_id_index_new(void)
+{
+    return hash_map_new(SOCK_ID_INDEX_BUCKETS, hash_function_integer, NULL, NULL, NULL);
+}
+
+uint32_t sock_id_index_next(const hash_map_t *index, uint32_t last_id)
+{
+    uint32_t id = last_id + 1;
+
+    /* no zero ids allowed, nor ones still in use after wrapping around */
+    while (!id || hash_map_has_key(index, UINT_TO_PTR(id)))
+        id++;
+    return id;
+}
+
+uint32_t sock_slot_id_next(uint32_t last_id, size_t slot, size_t num_slots)
+{
+    uint64_t next_id = (uint64_t)last_id + 1;
+
+    next_id += (slot + num_slots - next_id % num_slots) % num_slots;
+    if (next_id > UINT32_MAX)
+        next_id = slot;
+    if (next_id == 0)
+        next_id = num_slots;
+    return (uint32_t)next_id;
+}
+
 static const char* hex_table = "0123456789abcdef";
 static inline void byte2hex(const char* data, char** str)
 {
@@ -35,6 +35,7 @@
 #include <alloca.h>
 #include <assert.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -42,6 +43,7 @@
 #include "bta_hh_api.h"
 #include "btcore/include/bdaddr.h"
 #include "btif_api.h"
+#include "btif_bonded_table.h"
 #include "btif_config.h"
 #include "btif_hh.h"
 #include "btif_util.h"
@@ -147,6 +149,31 @@ typedef struct
     bt_bdaddr_t devices[BTM_SEC_MAX_DEVICE_RECORDS];
 } btif_bonded_devices_t;
 
+/************************************************************************************
+**  Static variables
+************************************************************************************/
+
+/* Bonded devices decoded from the config. Built on first use, rebuilt when the
+ * bonded devices are loaded and kept up to date as bonds are added and removed,
+ * so that queries do not have to walk and decode the whole config. */
+static bonded_table_t *bonded_table;
+static pthread_mutex_t bonded_table_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+#if (BLE_INCLUDED == TRUE)
+/* LE keys of a bonded device, in the order they are handed to BTA */
+static const struct {
+    uint8_t type;
+    size_t  len;
+} btif_in_le_keys[] = {
+    { BTIF_DM_LE_KEY_PENC,  sizeof(tBTM_LE_PENC_KEYS) },
+    { BTIF_DM_LE_KEY_PID,   sizeof(tBTM_LE_PID_KEYS) },
+    { BTIF_DM_LE_KEY_LID,   sizeof(tBTM_LE_PID_KEYS) },
+    { BTIF_DM_LE_KEY_PCSRK, sizeof(tBTM_LE_PCSRK_KEYS) },
+    { BTIF_DM_LE_KEY_LENC,  sizeof(tBTM_LE_LENC_KEYS) },
+    { BTIF_DM_LE_KEY_LCSRK, sizeof(tBTM_LE_LCSRK_KEYS) },
+};
+#endif
+
 /************************************************************************************
 **  External variables
 ************************************************************************************/
@@ -163,8 +190,6 @@ extern void btif_gatts_add_bonded_dev_from_nv(BD_ADDR bda);
 **  Internal Functions
 ************************************************************************************/
 
-static bt_status_t btif_in_fetch_bonded_ble_device(const char *remote_bd_addr,int add,
-                                              btif_bonded_devices_t *p_bonded_devices);
 static bt_status_t btif_in_fetch_bonded_device(const char *bdstr);
 
 /************************************************************************************
@@ -384,149 +409,249 @@ static int cfg2prop(bt_bdaddr_t *remote_bd_addr, bt_property_t *prop)
 
 /*******************************************************************************
 **
-** Function         btif_in_fetch_bonded_devices
+** Function         btif_in_bonded_table_decode
 **
-** Description      Internal helper function to fetch the bonded devices
-**                  from NVRAM
+** Description      Internal helper function to decode the link key and the LE
+**                  keys of the remote device |bdstr| from NVRAM into the
+**                  bonded device table. Must be called with bonded_table_lock
+**                  held.
 **
-** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
+** Returns          void
 **
 *******************************************************************************/
-static bt_status_t btif_in_fetch_bonded_device(const char *bdstr)
+static void btif_in_bonded_table_decode(const char *bdstr)
 {
-    BOOLEAN bt_linkkey_file_found=FALSE;
+    bt_bdaddr_t bd_addr;
+    string_to_bdaddr(bdstr, &bd_addr);
+
+    LINK_KEY link_key;
+    size_t size = sizeof(link_key);
+    int linkkey_type;
+    if (btif_config_get_bin(bdstr, "LinkKey", link_key, &size) &&
+        btif_config_get_int(bdstr, "LinkKeyType", &linkkey_type))
+    {
+        int pin_length = 0;
+        btif_config_get_int(bdstr, "PinLength", &pin_length);
+        bonded_table_set_link_key(bonded_table, &bd_addr, link_key,
+                                  (uint8_t)linkkey_type, (uint8_t)pin_length);
+    }
 
-        LINK_KEY link_key;
-        size_t size = sizeof(link_key);
-        if(btif_config_get_bin(bdstr, "LinkKey", (uint8_t *)link_key, &size))
-        {
-            int linkkey_type;
-            if(btif_config_get_int(bdstr, "LinkKeyType", &linkkey_type))
-            {
-                bt_linkkey_file_found = TRUE;
-            }
-            else
-            {
-                bt_linkkey_file_found = FALSE;
-            }
-        }
 #if (BLE_INCLUDED == TRUE)
-        if((btif_in_fetch_bonded_ble_device(bdstr, FALSE, NULL) != BT_STATUS_SUCCESS)
-                && (!bt_linkkey_file_found))
-        {
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", bdstr);
-            return BT_STATUS_FAIL;
-        }
-#else
-        if((!bt_linkkey_file_found))
-        {
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key found", bdstr);
-            return BT_STATUS_FAIL;
-        }
+    int device_type;
+    if (!btif_config_get_int(bdstr, "DevType", &device_type) ||
+        (device_type & BT_DEVICE_TYPE_BLE) != BT_DEVICE_TYPE_BLE)
+        return;
+
+    for (size_t i = 0; i < ARRAY_SIZE(btif_in_le_keys); i++)
+    {
+        char buffer[BONDED_TABLE_LE_KEY_MAX_LEN];
+        memset(buffer, 0, sizeof(buffer));
+        if (btif_storage_get_ble_bonding_key(&bd_addr, btif_in_le_keys[i].type, buffer,
+                                             btif_in_le_keys[i].len) != BT_STATUS_SUCCESS)
+            continue;
+
+        bonded_table_set_le_key(bonded_table, &bd_addr, btif_in_le_keys[i].type,
+                                buffer, btif_in_le_keys[i].len);
+    }
 #endif
-    return BT_STATUS_SUCCESS;
 }
 
 /*******************************************************************************
 **
-** Function         btif_in_fetch_bonded_devices
+** Function         btif_in_bonded_table_load
 **
-** Description      Internal helper function to fetch the bonded devices
-**                  from NVRAM
+** Description      Internal helper function to (re)build the bonded device
+**                  table from NVRAM. Must be called with bonded_table_lock
+**                  held.
 **
-** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
+** Returns          void
 **
 *******************************************************************************/
-static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_devices, int add)
+static void btif_in_bonded_table_load(void)
 {
-    memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
-
-    BOOLEAN bt_linkkey_file_found=FALSE;
-    int device_type;
+    if (bonded_table == NULL)
+        bonded_table = bonded_table_new();
+    else
+        bonded_table_clear(bonded_table);
 
     for (const btif_config_section_iter_t *iter = btif_config_section_begin(); iter != btif_config_section_end(); iter = btif_config_section_next(iter)) {
         const char *name = btif_config_section_name(iter);
         if (!string_is_bdaddr(name))
             continue;
 
-        BTIF_TRACE_DEBUG("Remote device:%s", name);
-        LINK_KEY link_key;
-        size_t size = sizeof(link_key);
-        if (btif_config_get_bin(name, "LinkKey", link_key, &size)) {
-            int linkkey_type;
-            if (btif_config_get_int(name, "LinkKeyType", &linkkey_type)) {
-                bt_bdaddr_t bd_addr;
-                string_to_bdaddr(name, &bd_addr);
-                if (add) {
-                    DEV_CLASS dev_class = {0, 0, 0};
-                    int cod;
-                    int pin_length = 0;
-                    if (btif_config_get_int(name, "DevClass", &cod))
-                        uint2devclass((UINT32)cod, dev_class);
-                    btif_config_get_int(name, "PinLength", &pin_length);
-                    BTA_DmAddDevice(bd_addr.address, dev_class, link_key, 0, 0,
-                                    (UINT8)linkkey_type, 0, pin_length);
+        btif_in_bonded_table_decode(name);
+    }
 
-#if BLE_INCLUDED == TRUE
-                    if (btif_config_get_int(name, "DevType", &device_type) &&
-                        (device_type == BT_DEVICE_TYPE_DUMO) ) {
-                        btif_gatts_add_bonded_dev_from_nv(bd_addr.address);
-                    }
-#endif
-                }
-                bt_linkkey_file_found = TRUE;
-                memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &bd_addr, sizeof(bt_bdaddr_t));
-            } else {
-#if (BLE_INCLUDED == TRUE)
-                bt_linkkey_file_found = FALSE;
-#else
-                BTIF_TRACE_ERROR("bounded device:%s, LinkKeyType or PinLength is invalid", name);
-#endif
-            }
-        }
-#if (BLE_INCLUDED == TRUE)
-        if (!btif_in_fetch_bonded_ble_device(name, add, p_bonded_devices) &&
-            !bt_linkkey_file_found) {
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", name);
-        }
-#else
-        if(!bt_linkkey_file_found)
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key", name);
-#endif
+    BTIF_TRACE_DEBUG("%s: %zu bonded devices", __func__, bonded_table_size(bonded_table));
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_bonded_table
+**
+** Description      Internal helper function to get the bonded device table,
+**                  building it from NVRAM on first use. Must be called with
+**                  bonded_table_lock held.
+**
+** Returns          The bonded device table
+**
+*******************************************************************************/
+static bonded_table_t *btif_in_bonded_table(void)
+{
+    if (bonded_table == NULL)
+        btif_in_bonded_table_load();
+    return bonded_table;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_fetch_bonded_device
+**
+** Description      Internal helper function to check whether the remote
+**                  device |bdstr| has a link key or an LE key
+**
+** Returns          BT_STATUS_SUCCESS if it does, BT_STATUS_FAIL otherwise
+**
+*******************************************************************************/
+static bt_status_t btif_in_fetch_bonded_device(const char *bdstr)
+{
+    bt_bdaddr_t bd_addr;
+    if (!string_to_bdaddr(bdstr, &bd_addr))
+        return BT_STATUS_FAIL;
+
+    pthread_mutex_lock(&bonded_table_lock);
+    bool bonded = bonded_table_get(btif_in_bonded_table(), &bd_addr) != NULL;
+    pthread_mutex_unlock(&bonded_table_lock);
+
+    if (!bonded)
+    {
+        BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", bdstr);
+        return BT_STATUS_FAIL;
     }
     return BT_STATUS_SUCCESS;
 }
 
-static void btif_read_le_key(const uint8_t key_type, const size_t key_len, bt_bdaddr_t bd_addr,
-                 const uint8_t addr_type, const bool add_key, bool *device_added, bool *key_found)
+#if (BLE_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btif_in_add_bonded_ble_device
+**
+** Description      Internal helper function to add an LE bonded device and its
+**                  keys to BTA
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_add_bonded_ble_device(const bonded_device_t *device)
 {
-    assert(device_added);
-    assert(key_found);
+    bt_bdaddr_t bd_addr;
+    BD_ADDR bta_bd_addr;
+    int addr_type;
 
-    char buffer[100];
-    memset(buffer, 0, sizeof(buffer));
+    bdaddr_copy(&bd_addr, &device->addr);
+    bdcpy(bta_bd_addr, bd_addr.address);
 
-    if (btif_storage_get_ble_bonding_key(&bd_addr, key_type, buffer, key_len) == BT_STATUS_SUCCESS)
+    if (btif_storage_get_remote_addr_type(&bd_addr, &addr_type) != BT_STATUS_SUCCESS)
     {
-        if (add_key)
-        {
-            BD_ADDR bta_bd_addr;
-            bdcpy(bta_bd_addr, bd_addr.address);
+        addr_type = BLE_ADDR_PUBLIC;
+        btif_storage_set_remote_addr_type(&bd_addr, BLE_ADDR_PUBLIC);
+    }
 
-            if (!*device_added)
-            {
-                BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
-                *device_added = true;
-            }
+    BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
 
-            char bd_str[20] = {0};
-            BTIF_TRACE_DEBUG("%s() Adding key type %d for %s", __func__,
-                key_type, bdaddr_to_string(&bd_addr, bd_str, sizeof(bd_str)));
-            BTA_DmAddBleKey(bta_bd_addr, (tBTA_LE_KEY_VALUE *)buffer, key_type);
-        }
+    for (size_t i = 0; i < ARRAY_SIZE(btif_in_le_keys); i++)
+    {
+        const bonded_le_key_t *key = bonded_table_get_le_key(device, btif_in_le_keys[i].type);
+        if (!key)
+            continue;
+
+        tBTA_LE_KEY_VALUE key_value;
+        memset(&key_value, 0, sizeof(key_value));
+        memcpy(&key_value, key->value, key->len);
 
-        *key_found = true;
+        BTIF_TRACE_DEBUG("%s() Adding key type %d", __func__, key->type);
+        BTA_DmAddBleKey(bta_bd_addr, &key_value, key->type);
     }
+
+    btif_gatts_add_bonded_dev_from_nv(bta_bd_addr);
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         btif_in_add_bonded_device
+**
+** Description      Internal helper function to add a bonded device and its
+**                  keys to BTA and to the list of bonded devices in |context|
+**
+** Returns          true, to continue with the next bonded device
+**
+*******************************************************************************/
+static bool btif_in_add_bonded_device(const bonded_device_t *device, void *context)
+{
+    btif_bonded_devices_t *p_bonded_devices = (btif_bonded_devices_t *)context;
+    bdstr_t bdstr;
+    bdaddr_to_string(&device->addr, bdstr, sizeof(bdstr));
+    BTIF_TRACE_DEBUG("Remote device:%s", bdstr);
+
+    if (p_bonded_devices->num_devices == BTM_SEC_MAX_DEVICE_RECORDS)
+    {
+        BTIF_TRACE_ERROR("%s: too many bonded devices, ignoring %s", __func__, bdstr);
+        return false;
+    }
+
+    if (device->has_link_key)
+    {
+        BD_ADDR bta_bd_addr;
+        DEV_CLASS dev_class = {0, 0, 0};
+        LINK_KEY link_key;
+        int cod;
+
+        bdcpy(bta_bd_addr, device->addr.address);
+        memcpy(link_key, device->link_key, sizeof(link_key));
+        if (btif_config_get_int(bdstr, "DevClass", &cod))
+            uint2devclass((UINT32)cod, dev_class);
+        BTA_DmAddDevice(bta_bd_addr, dev_class, link_key, 0, 0,
+                        device->link_key_type, 0, device->pin_length);
+
+#if BLE_INCLUDED == TRUE
+        int device_type;
+        if (btif_config_get_int(bdstr, "DevType", &device_type) &&
+            (device_type == BT_DEVICE_TYPE_DUMO) ) {
+            btif_gatts_add_bonded_dev_from_nv(bta_bd_addr);
+        }
+#endif
+    }
+
+#if (BLE_INCLUDED == TRUE)
+    if (device->num_le_keys > 0)
+        btif_in_add_bonded_ble_device(device);
+#endif
+
+    bdaddr_copy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &device->addr);
+    return true;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_fetch_bonded_devices
+**
+** Description      Internal helper function to rebuild the bonded device table
+**                  from NVRAM and add the bonded devices to BTA
+**
+** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
+**
+*******************************************************************************/
+static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_devices)
+{
+    memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
+
+    pthread_mutex_lock(&bonded_table_lock);
+    btif_in_bonded_table_load();
+    bonded_table_foreach(bonded_table, btif_in_add_bonded_device, p_bonded_devices);
+    pthread_mutex_unlock(&bonded_table_lock);
+
+    return BT_STATUS_SUCCESS;
 }
 
 /*******************************************************************************
@@ -594,19 +719,16 @@ bt_status_t btif_storage_get_adapter_property(bt_property_t *property)
     }
     else if (property->type == BT_PROPERTY_ADAPTER_BONDED_DEVICES)
     {
-        btif_bonded_devices_t bonded_devices;
-
-        btif_in_fetch_bonded_devices(&bonded_devices, 0);
+        pthread_mutex_lock(&bonded_table_lock);
+        size_t num_devices = bonded_table_get_addrs(btif_in_bonded_table(),
+                                                    (bt_bdaddr_t *)property->val,
+                                                    property->len / sizeof(bt_bdaddr_t));
+        pthread_mutex_unlock(&bonded_table_lock);
 
-        BTIF_TRACE_DEBUG("%s: Number of bonded devices: %d Property:BT_PROPERTY_ADAPTER_BONDED_DEVICES", __FUNCTION__, bonded_devices.num_devices);
-
-        if (bonded_devices.num_devices > 0)
-        {
-            property->len = bonded_devices.num_devices * sizeof(bt_bdaddr_t);
-            memcpy(property->val, bonded_devices.devices, property->len);
-        }
+        BTIF_TRACE_DEBUG("%s: Number of bonded devices: %zu Property:BT_PROPERTY_ADAPTER_BONDED_DEVICES", __FUNCTION__, num_devices);
 
         /* if there are no bonded_devices, then length shall be 0 */
+        property->len = num_devices * sizeof(bt_bdaddr_t);
         return BT_STATUS_SUCCESS;
     }
     else if (property->type == BT_PROPERTY_UUIDS)
@@ -795,6 +917,15 @@ bt_status_t btif_storage_add_bonded_device(bt_bdaddr_t *remote_bd_addr,
         btif_config_set_int(bdstr, "Restricted", 1);
     }
 
+    if (ret)
+    {
+        pthread_mutex_lock(&bonded_table_lock);
+        if (bonded_table)
+            bonded_table_set_link_key(bonded_table, remote_bd_addr, link_key,
+                                      key_type, pin_length);
+        pthread_mutex_unlock(&bonded_table_lock);
+    }
+
     /* write bonded info immediately */
     btif_config_flush();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
@@ -827,6 +958,12 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
         ret &= btif_config_remove(bdstr, "PinLength");
     if(btif_config_exist(bdstr, "LinkKey"))
         ret &= btif_config_remove(bdstr, "LinkKey");
+
+    pthread_mutex_lock(&bonded_table_lock);
+    if (bonded_table)
+        bonded_table_remove_link_key(bonded_table, remote_bd_addr);
+    pthread_mutex_unlock(&bonded_table_lock);
+
     /* write bonded info immediately */
     btif_config_flush();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
@@ -845,13 +982,11 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
 *******************************************************************************/
 BOOLEAN btif_storage_is_device_bonded(bt_bdaddr_t *remote_bd_addr)
 {
-    bdstr_t bdstr;
-    bdaddr_to_string(remote_bd_addr, bdstr, sizeof(bdstr));
-    if((btif_config_exist(bdstr, "LinkKey")) &&
-       (btif_config_exist(bdstr, "LinkKeyType")))
-        return TRUE;
-    else
-        return FALSE;
+    pthread_mutex_lock(&bonded_table_lock);
+    const bonded_device_t *device = bonded_table_get(btif_in_bonded_table(), remote_bd_addr);
+    BOOLEAN bonded = (device != NULL && device->has_link_key);
+    pthread_mutex_unlock(&bonded_table_lock);
+    return bonded;
 }
 
 /*******************************************************************************
@@ -880,7 +1015,7 @@ bt_status_t btif_storage_load_bonded_devices(void)
     bt_uuid_t local_uuids[BT_MAX_NUM_UUIDS];
     bt_uuid_t remote_uuids[BT_MAX_NUM_UUIDS];
 
-    btif_in_fetch_bonded_devices(&bonded_devices, 1);
+    btif_in_fetch_bonded_devices(&bonded_devices);
 
     /* Now send the adapter_properties_cb with all adapter_properties */
     {
@@ -1030,6 +1165,13 @@ bt_status_t btif_storage_add_ble_bonding_key(bt_bdaddr_t *remote_bd_addr,
             return BT_STATUS_FAIL;
     }
     int ret = btif_config_set_bin(bdstr, name, (const uint8_t *)key, key_length);
+    if (ret)
+    {
+        pthread_mutex_lock(&bonded_table_lock);
+        if (bonded_table)
+            bonded_table_set_le_key(bonded_table, remote_bd_addr, key_type, key, key_length);
+        pthread_mutex_unlock(&bonded_table_lock);
+    }
     btif_config_save();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
@@ -1106,6 +1248,12 @@ bt_status_t btif_storage_remove_ble_bonding_keys(bt_bdaddr_t *remote_bd_addr)
         ret &= btif_config_remove(bdstr, "LE_KEY_LENC");
     if(btif_config_exist(bdstr, "LE_KEY_LCSRK"))
         ret &= btif_config_remove(bdstr, "LE_KEY_LCSRK");
+
+    pthread_mutex_lock(&bonded_table_lock);
+    if (bonded_table)
+        bonded_table_remove_le_keys(bonded_table, remote_bd_addr);
+    pthread_mutex_unlock(&bonded_table_lock);
+
     btif_config_save();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
@@ -1209,62 +1357,6 @@ bt_status_t btif_storage_remove_ble_local_keys(void)
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
 
-static bt_status_t btif_in_fetch_bonded_ble_device(const char *remote_bd_addr, int add, btif_bonded_devices_t *p_bonded_devices)
-{
-    int device_type;
-    int addr_type;
-    bt_bdaddr_t bd_addr;
-    BD_ADDR bta_bd_addr;
-    bool device_added = false;
-    bool key_found = false;
-
-    if (!btif_config_get_int(remote_bd_addr, "DevType", &device_type))
-        return BT_STATUS_FAIL;
-
-    if ((device_type & BT_DEVICE_TYPE_BLE) == BT_DEVICE_TYPE_BLE)
-    {
-        BTIF_TRACE_DEBUG("%s Found a LE device: %s", __func__, remote_bd_addr);
-
-        string_to_bdaddr(remote_bd_addr, &bd_addr);
-        bdcpy(bta_bd_addr, bd_addr.address);
-
-        if (btif_storage_get_remote_addr_type(&bd_addr, &addr_type) != BT_STATUS_SUCCESS)
-        {
-            addr_type = BLE_ADDR_PUBLIC;
-            btif_storage_set_remote_addr_type(&bd_addr, BLE_ADDR_PUBLIC);
-        }
-
-        btif_read_le_key(BTIF_DM_LE_KEY_PENC, sizeof(tBTM_LE_PENC_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        btif_read_le_key(BTIF_DM_LE_KEY_PID, sizeof(tBTM_LE_PID_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        btif_read_le_key(BTIF_DM_LE_KEY_LID, sizeof(tBTM_LE_PID_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        btif_read_le_key(BTIF_DM_LE_KEY_PCSRK, sizeof(tBTM_LE_PCSRK_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        btif_read_le_key(BTIF_DM_LE_KEY_LENC, sizeof(tBTM_LE_LENC_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        btif_read_le_key(BTIF_DM_LE_KEY_LCSRK, sizeof(tBTM_LE_LCSRK_KEYS),
-                         bd_addr, addr_type, add, &device_added, &key_found);
-
-        // Fill in the bonded devices
-        if (device_added)
-        {
-            memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &bd_addr, sizeof(bt_bdaddr_t));
-            btif_gatts_add_bonded_dev_from_nv(bta_bd_addr);
-        }
-
-        if (key_found)
-            return BT_STATUS_SUCCESS;
-    }
-    return BT_STATUS_FAIL;
-}
-
 bt_status_t btif_storage_set_remote_addr_type(bt_bdaddr_t *remote_bd_addr,
                                               UINT8 addr_type)
 {
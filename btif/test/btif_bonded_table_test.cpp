@@ -0,0 +1,331 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctype.h>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include "btcore/include/bdaddr.h"
+#include "btif/include/btif_bonded_table.h"
+#include "osi/include/config.h"
+}
+
+using std::chrono::steady_clock;
+
+// Values of BTIF_DM_LE_KEY_PENC and BTIF_DM_LE_KEY_PID.
+static const uint8_t LE_KEY_PENC = 0x01;
+static const uint8_t LE_KEY_PID = 0x02;
+
+// Size of the synthetic bonded device config used by the benchmark. Every
+// other device is a dual mode device that also has LE keys.
+static const size_t BENCH_DEVICES = 2000;
+static const size_t BENCH_QUERIES = 5;
+
+static const uint8_t kLinkKey[BONDED_TABLE_LINK_KEY_LEN] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+
+static bt_bdaddr_t make_addr(size_t i) {
+  bt_bdaddr_t addr = {{0xBE, 0x4C, 0x00, (uint8_t)(i >> 16), (uint8_t)(i >> 8),
+                       (uint8_t)i}};
+  return addr;
+}
+
+namespace {
+
+// Reads bonded devices the way btif_storage does without the table: every
+// value is looked up under the config lock and binary values are decoded from
+// their hex strings.
+struct ConfigReader {
+  config_t *config;
+  std::mutex lock;
+
+  bool GetInt(const char *section, const char *key, int *value) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!config_has_key(config, section, key))
+      return false;
+    *value = config_get_int(config, section, key, 0);
+    return true;
+  }
+
+  bool GetBin(const char *section, const char *key, uint8_t *value,
+              size_t *length) {
+    const char *value_str;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      value_str = config_get_string(config, section, key, NULL);
+    }
+    if (!value_str)
+      return false;
+
+    size_t value_len = strlen(value_str);
+    if ((value_len % 2) != 0 || *length < (value_len / 2))
+      return false;
+    for (size_t i = 0; i < value_len; ++i)
+      if (!isxdigit(value_str[i]))
+        return false;
+    for (*length = 0; *value_str; value_str += 2, *length += 1)
+      sscanf(value_str, "%02hhx", &value[*length]);
+    return true;
+  }
+
+  // Decodes the keys of |name| into |table|, or only checks that it is bonded
+  // if |table| is NULL. Returns true if the device is bonded.
+  bool Decode(const char *name, bonded_table_t *table) {
+    bt_bdaddr_t addr;
+    string_to_bdaddr(name, &addr);
+
+    bool bonded = false;
+    uint8_t link_key[BONDED_TABLE_LINK_KEY_LEN];
+    size_t size = sizeof(link_key);
+    int key_type;
+    if (GetBin(name, "LinkKey", link_key, &size) &&
+        GetInt(name, "LinkKeyType", &key_type)) {
+      int pin_length = 0;
+      GetInt(name, "PinLength", &pin_length);
+      if (table)
+        bonded_table_set_link_key(table, &addr, link_key, key_type, pin_length);
+      bonded = true;
+    }
+
+    int dev_type;
+    if (!GetInt(name, "DevType", &dev_type) || !(dev_type & 0x02))
+      return bonded;
+
+    const struct {
+      const char *key;
+      uint8_t type;
+    } le_keys[] = {{"LE_KEY_PENC", LE_KEY_PENC}, {"LE_KEY_PID", LE_KEY_PID}};
+    for (const auto &le_key : le_keys) {
+      uint8_t value[BONDED_TABLE_LE_KEY_MAX_LEN];
+      size = sizeof(value);
+      if (!GetBin(name, le_key.key, value, &size))
+        continue;
+      if (table)
+        bonded_table_set_le_key(table, &addr, le_key.type, value, size);
+      bonded = true;
+    }
+    return bonded;
+  }
+};
+
+std::string to_hex(const uint8_t *data, size_t len) {
+  std::string hex;
+  char byte[3];
+  for (size_t i = 0; i < len; ++i) {
+    snprintf(byte, sizeof(byte), "%02x", data[i]);
+    hex += byte;
+  }
+  return hex;
+}
+
+int64_t elapsed_us(steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+class BtifBondedTableTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { table_ = bonded_table_new(); }
+
+  virtual void TearDown() { bonded_table_free(table_); }
+
+  bonded_table_t *table_;
+};
+
+TEST_F(BtifBondedTableTest, test_link_key) {
+  bt_bdaddr_t addr = make_addr(1);
+  EXPECT_TRUE(bonded_table_get(table_, &addr) == NULL);
+
+  EXPECT_TRUE(bonded_table_set_link_key(table_, &addr, kLinkKey, 4, 16));
+  const bonded_device_t *device = bonded_table_get(table_, &addr);
+  ASSERT_TRUE(device != NULL);
+  EXPECT_TRUE(device->has_link_key);
+  EXPECT_EQ(0, memcmp(kLinkKey, device->link_key, sizeof(kLinkKey)));
+  EXPECT_EQ(4, device->link_key_type);
+  EXPECT_EQ(16, device->pin_length);
+  EXPECT_EQ(1u, bonded_table_size(table_));
+
+  // Setting the key again updates the same device.
+  EXPECT_TRUE(bonded_table_set_link_key(table_, &addr, kLinkKey, 5, 0));
+  EXPECT_EQ(1u, bonded_table_size(table_));
+  EXPECT_EQ(5, bonded_table_get(table_, &addr)->link_key_type);
+
+  bonded_table_remove_link_key(table_, &addr);
+  EXPECT_TRUE(bonded_table_get(table_, &addr) == NULL);
+  EXPECT_EQ(0u, bonded_table_size(table_));
+}
+
+TEST_F(BtifBondedTableTest, test_le_keys) {
+  bt_bdaddr_t addr = make_addr(2);
+  uint8_t penc[28];
+  memset(penc, 0xA5, sizeof(penc));
+
+  EXPECT_TRUE(bonded_table_set_le_key(table_, &addr, LE_KEY_PENC, penc,
+                                      sizeof(penc)));
+  const bonded_device_t *device = bonded_table_get(table_, &addr);
+  ASSERT_TRUE(device != NULL);
+  EXPECT_FALSE(device->has_link_key);
+
+  const bonded_le_key_t *key = bonded_table_get_le_key(device, LE_KEY_PENC);
+  ASSERT_TRUE(key != NULL);
+  EXPECT_EQ(sizeof(penc), key->len);
+  EXPECT_EQ(0, memcmp(penc, key->value, sizeof(penc)));
+  EXPECT_TRUE(bonded_table_get_le_key(device, LE_KEY_PID) == NULL);
+
+  uint8_t too_long[BONDED_TABLE_LE_KEY_MAX_LEN + 1] = {0};
+  EXPECT_FALSE(bonded_table_set_le_key(table_, &addr, LE_KEY_PID, too_long,
+                                       sizeof(too_long)));
+  EXPECT_TRUE(bonded_table_get_le_key(device, LE_KEY_PID) == NULL);
+
+  bonded_table_remove_le_keys(table_, &addr);
+  EXPECT_TRUE(bonded_table_get(table_, &addr) == NULL);
+}
+
+TEST_F(BtifBondedTableTest, test_dual_mode_device) {
+  bt_bdaddr_t addr = make_addr(3);
+  uint8_t pid[23] = {0};
+
+  bonded_table_set_link_key(table_, &addr, kLinkKey, 4, 0);
+  bonded_table_set_le_key(table_, &addr, LE_KEY_PID, pid, sizeof(pid));
+  EXPECT_EQ(1u, bonded_table_size(table_));
+
+  // The device stays bonded as long as one of its keys is left.
+  bonded_table_remove_le_keys(table_, &addr);
+  ASSERT_TRUE(bonded_table_get(table_, &addr) != NULL);
+  EXPECT_EQ(0, bonded_table_get(table_, &addr)->num_le_keys);
+
+  bonded_table_set_le_key(table_, &addr, LE_KEY_PID, pid, sizeof(pid));
+  bonded_table_remove_link_key(table_, &addr);
+  ASSERT_TRUE(bonded_table_get(table_, &addr) != NULL);
+  EXPECT_FALSE(bonded_table_get(table_, &addr)->has_link_key);
+}
+
+TEST_F(BtifBondedTableTest, test_get_addrs_order) {
+  for (size_t i = 0; i < 5; ++i) {
+    bt_bdaddr_t addr = make_addr(i);
+    bonded_table_set_link_key(table_, &addr, kLinkKey, 4, 0);
+  }
+  bt_bdaddr_t removed = make_addr(1);
+  bonded_table_remove_link_key(table_, &removed);
+
+  bt_bdaddr_t addrs[8];
+  ASSERT_EQ(4u, bonded_table_get_addrs(table_, addrs, 8));
+  const size_t expected[] = {0, 2, 3, 4};
+  for (size_t i = 0; i < 4; ++i) {
+    bt_bdaddr_t addr = make_addr(expected[i]);
+    EXPECT_TRUE(bdaddr_equals(&addr, &addrs[i]));
+  }
+
+  // The output is bounded by the room the caller has.
+  EXPECT_EQ(2u, bonded_table_get_addrs(table_, addrs, 2));
+  EXPECT_EQ(0u, bonded_table_get_addrs(table_, NULL, 0));
+
+  bonded_table_clear(table_);
+  EXPECT_EQ(0u, bonded_table_get_addrs(table_, addrs, 8));
+}
+
+// Compares walking and decoding the config on every bonded devices query with
+// building the table once and answering queries from it.
+TEST_F(BtifBondedTableTest, test_load_and_query_benchmark) {
+  config_t *config = config_new_empty();
+  ASSERT_TRUE(config != NULL);
+
+  uint8_t penc[28], pid[23];
+  memset(penc, 0x5A, sizeof(penc));
+  memset(pid, 0x3C, sizeof(pid));
+  const std::string link_key_hex = to_hex(kLinkKey, sizeof(kLinkKey));
+  const std::string penc_hex = to_hex(penc, sizeof(penc));
+  const std::string pid_hex = to_hex(pid, sizeof(pid));
+
+  for (size_t i = 0; i < BENCH_DEVICES; ++i) {
+    bt_bdaddr_t addr = make_addr(i);
+    bdstr_t name;
+    bdaddr_to_string(&addr, name, sizeof(name));
+    const bool dual_mode = (i % 2) == 1;
+    config_set_string(config, name, "Name", "Bonded device");
+    config_set_int(config, name, "DevClass", 0x240404);
+    config_set_int(config, name, "DevType", dual_mode ? 3 : 1);
+    config_set_int(config, name, "LinkKeyType", 4);
+    config_set_int(config, name, "PinLength", 0);
+    config_set_string(config, name, "LinkKey", link_key_hex.c_str());
+    if (dual_mode) {
+      config_set_string(config, name, "LE_KEY_PENC", penc_hex.c_str());
+      config_set_string(config, name, "LE_KEY_PID", pid_hex.c_str());
+    }
+  }
+
+  ConfigReader reader;
+  reader.config = config;
+
+  // Every query walks and decodes the whole config.
+  std::vector<bt_bdaddr_t> walked;
+  steady_clock::time_point start = steady_clock::now();
+  for (size_t q = 0; q < BENCH_QUERIES; ++q) {
+    walked.clear();
+    for (const config_section_node_t *iter = config_section_begin(config);
+         iter != config_section_end(config); iter = config_section_next(iter)) {
+      const char *name = config_section_name(iter);
+      bt_bdaddr_t addr;
+      if (reader.Decode(name, NULL) && string_to_bdaddr(name, &addr))
+        walked.push_back(addr);
+    }
+  }
+  const int64_t walk_query_us = elapsed_us(start) / BENCH_QUERIES;
+
+  // The table is built once and serves the queries.
+  start = steady_clock::now();
+  for (const config_section_node_t *iter = config_section_begin(config);
+       iter != config_section_end(config); iter = config_section_next(iter))
+    reader.Decode(config_section_name(iter), table_);
+  const int64_t load_us = elapsed_us(start);
+
+  std::vector<bt_bdaddr_t> queried(BENCH_DEVICES);
+  size_t num_queried = 0;
+  start = steady_clock::now();
+  for (size_t q = 0; q < BENCH_QUERIES; ++q)
+    num_queried = bonded_table_get_addrs(table_, queried.data(), queried.size());
+  const int64_t table_query_us = elapsed_us(start) / BENCH_QUERIES;
+
+  ASSERT_EQ(BENCH_DEVICES, walked.size());
+  ASSERT_EQ(BENCH_DEVICES, num_queried);
+  EXPECT_EQ(0, memcmp(walked.data(), queried.data(),
+                      BENCH_DEVICES * sizeof(bt_bdaddr_t)));
+
+  bt_bdaddr_t addr = make_addr(BENCH_DEVICES - 1);
+  const bonded_device_t *device = bonded_table_get(table_, &addr);
+  ASSERT_TRUE(device != NULL);
+  EXPECT_EQ(0, memcmp(kLinkKey, device->link_key, sizeof(kLinkKey)));
+  const bonded_le_key_t *key = bonded_table_get_le_key(device, LE_KEY_PENC);
+  ASSERT_TRUE(key != NULL);
+  EXPECT_EQ(0, memcmp(penc, key->value, sizeof(penc)));
+
+  printf("%zu bonded devices: walking the config takes %lld us per query; "
+         "loading the table takes %lld us, then %lld us per query\n",
+         BENCH_DEVICES, (long long)walk_query_us, (long long)load_us,
+         (long long)table_query_us);
+
+  config_free(config);
+}
@@ -0,0 +1,286 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern "C" {
+#include "btif/include/btif_rc_txn.h"
+}
+
+// Stands in for AVCT: hands out transaction labels from a pool the same way
+// btif_rc does and records every SetAbsoluteVolume command put on the air.
+struct FakeAvct {
+  struct Command {
+    uint8_t label;
+    uint8_t volume;
+  };
+
+  rc_label_pool_t labels;
+  std::vector<Command> sent;
+  std::vector<uint8_t> abandoned;
+  bool fail_sends = false;
+  bool timer_armed = false;
+  uint32_t timer_ms = 0;
+
+  // Answers the last command sent, the only one that can be outstanding.
+  bool Respond(rc_abs_vol_t *vol, uint32_t now_ms) {
+    if (sent.empty())
+      return false;
+    uint8_t label = sent.back().label;
+    if (!rc_abs_vol_is_outstanding(vol, label))
+      return false;
+    rc_label_pool_release(&labels, label);
+    return rc_abs_vol_complete(vol, label, now_ms);
+  }
+};
+
+static bool fake_send(void *context, uint8_t volume, uint8_t *label) {
+  FakeAvct *avct = static_cast<FakeAvct *>(context);
+  if (avct->fail_sends || !rc_label_pool_alloc(&avct->labels, label))
+    return false;
+  avct->sent.push_back({*label, volume});
+  return true;
+}
+
+static void fake_abandon(void *context, uint8_t label) {
+  FakeAvct *avct = static_cast<FakeAvct *>(context);
+  rc_label_pool_release(&avct->labels, label);
+  avct->abandoned.push_back(label);
+}
+
+static void fake_start_timer(void *context, uint32_t timeout_ms) {
+  FakeAvct *avct = static_cast<FakeAvct *>(context);
+  avct->timer_armed = true;
+  avct->timer_ms = timeout_ms;
+}
+
+static void fake_stop_timer(void *context) {
+  static_cast<FakeAvct *>(context)->timer_armed = false;
+}
+
+static const rc_abs_vol_ops_t fake_ops = {fake_send, fake_abandon,
+                                          fake_start_timer, fake_stop_timer};
+
+class BtifRcTxnTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    rc_label_pool_init(&avct_.labels);
+    rc_abs_vol_init(&vol_, &fake_ops, &avct_);
+  }
+
+  FakeAvct avct_;
+  rc_abs_vol_t vol_;
+};
+
+TEST_F(BtifRcTxnTest, test_label_pool_exhaustion) {
+  rc_label_pool_t pool;
+  rc_label_pool_init(&pool);
+
+  uint8_t label;
+  for (int i = 0; i < RC_LABEL_POOL_SIZE; i++) {
+    EXPECT_TRUE(rc_label_pool_alloc(&pool, &label));
+    EXPECT_EQ(i, label);
+  }
+  EXPECT_FALSE(rc_label_pool_alloc(&pool, &label));
+
+  EXPECT_EQ(RC_LABEL_POOL_SIZE, pool.stats.in_use);
+  EXPECT_EQ(RC_LABEL_POOL_SIZE, pool.stats.peak_in_use);
+  EXPECT_EQ((uint32_t)RC_LABEL_POOL_SIZE, pool.stats.allocations);
+  EXPECT_EQ(1u, pool.stats.exhausted);
+
+  EXPECT_TRUE(rc_label_pool_release(&pool, 5));
+  EXPECT_TRUE(rc_label_pool_alloc(&pool, &label));
+  EXPECT_EQ(5, label);
+}
+
+TEST_F(BtifRcTxnTest, test_label_pool_round_robin) {
+  rc_label_pool_t pool;
+  rc_label_pool_init(&pool);
+
+  // A label that was just released is not handed out again right away, so a
+  // late response cannot be matched to a newer command.
+  uint8_t first, second;
+  ASSERT_TRUE(rc_label_pool_alloc(&pool, &first));
+  ASSERT_TRUE(rc_label_pool_release(&pool, first));
+  ASSERT_TRUE(rc_label_pool_alloc(&pool, &second));
+  EXPECT_NE(first, second);
+
+  EXPECT_EQ(1, pool.stats.in_use);
+  EXPECT_EQ(1, pool.stats.peak_in_use);
+}
+
+TEST_F(BtifRcTxnTest, test_label_pool_stale_release) {
+  rc_label_pool_t pool;
+  rc_label_pool_init(&pool);
+
+  uint8_t label;
+  ASSERT_TRUE(rc_label_pool_alloc(&pool, &label));
+  EXPECT_TRUE(rc_label_pool_release(&pool, label));
+  EXPECT_FALSE(rc_label_pool_release(&pool, label));
+  EXPECT_FALSE(rc_label_pool_release(&pool, RC_LABEL_POOL_SIZE));
+
+  EXPECT_EQ(0, pool.stats.in_use);
+  EXPECT_EQ(1u, pool.stats.releases);
+  EXPECT_EQ(2u, pool.stats.stale_releases);
+}
+
+TEST_F(BtifRcTxnTest, test_label_pool_reset_keeps_stats) {
+  rc_label_pool_t pool;
+  rc_label_pool_init(&pool);
+
+  uint8_t label;
+  ASSERT_TRUE(rc_label_pool_alloc(&pool, &label));
+  rc_label_pool_reset(&pool);
+
+  EXPECT_FALSE(rc_label_pool_is_allocated(&pool, label));
+  EXPECT_EQ(0, pool.stats.in_use);
+  EXPECT_EQ(1u, pool.stats.allocations);
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_coalesces_slider_drag) {
+  EXPECT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  for (uint8_t volume = 11; volume <= 60; volume++)
+    EXPECT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, volume, volume));
+
+  // Only one command is on the air while the drag is in progress.
+  ASSERT_EQ(1u, avct_.sent.size());
+  EXPECT_EQ(1, avct_.labels.stats.peak_in_use);
+
+  // The response releases the first command and the last volume goes out.
+  EXPECT_TRUE(avct_.Respond(&vol_, 100));
+  ASSERT_EQ(2u, avct_.sent.size());
+  EXPECT_EQ(60, avct_.sent[1].volume);
+  EXPECT_EQ(49u, vol_.coalesced);
+
+  EXPECT_TRUE(avct_.Respond(&vol_, 200));
+  EXPECT_FALSE(rc_abs_vol_busy(&vol_));
+  EXPECT_EQ(2u, avct_.sent.size());
+  EXPECT_EQ(0, avct_.labels.stats.in_use);
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_ignores_unknown_label) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  ASSERT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, 20, 10));
+
+  uint8_t other = (avct_.sent[0].label + 1) % RC_LABEL_POOL_SIZE;
+  EXPECT_FALSE(rc_abs_vol_complete(&vol_, other, 20));
+  EXPECT_TRUE(rc_abs_vol_busy(&vol_));
+  EXPECT_EQ(1u, avct_.sent.size());
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_drops_pending_equal_to_outstanding) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  ASSERT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, 20, 10));
+  ASSERT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, 10, 20));
+
+  EXPECT_TRUE(avct_.Respond(&vol_, 30));
+  EXPECT_FALSE(rc_abs_vol_busy(&vol_));
+  EXPECT_EQ(1u, avct_.sent.size());
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_abandons_unanswered_command) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  uint8_t label = avct_.sent[0].label;
+
+  EXPECT_EQ(RC_ABS_VOL_QUEUED,
+            rc_abs_vol_set(&vol_, 20, RC_ABS_VOL_RSP_TIMEOUT_MS - 1));
+  EXPECT_EQ(RC_ABS_VOL_SENT,
+            rc_abs_vol_set(&vol_, 30, RC_ABS_VOL_RSP_TIMEOUT_MS));
+
+  ASSERT_EQ(1u, avct_.abandoned.size());
+  EXPECT_EQ(label, avct_.abandoned[0]);
+  ASSERT_EQ(2u, avct_.sent.size());
+  EXPECT_EQ(30, avct_.sent[1].volume);
+  EXPECT_EQ(1, avct_.labels.stats.in_use);
+
+  // A late response to the abandoned command does not complete the new one,
+  // so its label must not be released either.
+  EXPECT_FALSE(rc_abs_vol_is_outstanding(&vol_, label));
+  EXPECT_TRUE(rc_abs_vol_is_outstanding(&vol_, avct_.sent[1].label));
+  EXPECT_FALSE(rc_abs_vol_complete(&vol_, label, RC_ABS_VOL_RSP_TIMEOUT_MS + 1));
+  EXPECT_TRUE(rc_abs_vol_busy(&vol_));
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_send_failure) {
+  uint8_t label;
+  for (int i = 0; i < RC_LABEL_POOL_SIZE; i++)
+    ASSERT_TRUE(rc_label_pool_alloc(&avct_.labels, &label));
+
+  EXPECT_EQ(RC_ABS_VOL_FAILED, rc_abs_vol_set(&vol_, 10, 0));
+  EXPECT_FALSE(rc_abs_vol_busy(&vol_));
+  EXPECT_EQ(1u, avct_.labels.stats.exhausted);
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_timer_flushes_pending) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  EXPECT_TRUE(avct_.timer_armed);
+  EXPECT_EQ((uint32_t)RC_ABS_VOL_RSP_TIMEOUT_MS, avct_.timer_ms);
+  uint8_t label = avct_.sent[0].label;
+  ASSERT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, 20, 10));
+
+  // The peer never answers and no other volume is requested: the timer alone
+  // releases the label and sends the pending volume.
+  EXPECT_TRUE(rc_abs_vol_timeout(&vol_, RC_ABS_VOL_RSP_TIMEOUT_MS));
+  ASSERT_EQ(1u, avct_.abandoned.size());
+  EXPECT_EQ(label, avct_.abandoned[0]);
+  EXPECT_FALSE(rc_label_pool_is_allocated(&avct_.labels, label));
+  ASSERT_EQ(2u, avct_.sent.size());
+  EXPECT_EQ(20, avct_.sent[1].volume);
+  EXPECT_TRUE(avct_.timer_armed);
+
+  // With nothing pending the next timeout only abandons the command.
+  EXPECT_FALSE(rc_abs_vol_timeout(&vol_, 2 * RC_ABS_VOL_RSP_TIMEOUT_MS));
+  EXPECT_EQ(2u, avct_.abandoned.size());
+  EXPECT_FALSE(rc_abs_vol_busy(&vol_));
+  EXPECT_EQ(0, avct_.labels.stats.in_use);
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_response_stops_timer) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  EXPECT_TRUE(avct_.Respond(&vol_, 100));
+  EXPECT_FALSE(avct_.timer_armed);
+
+  // A timeout racing with the response of an earlier command does not
+  // abandon the newer one.
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 20, 1000));
+  EXPECT_FALSE(rc_abs_vol_timeout(&vol_, RC_ABS_VOL_RSP_TIMEOUT_MS));
+  EXPECT_TRUE(avct_.abandoned.empty());
+  EXPECT_TRUE(rc_abs_vol_busy(&vol_));
+}
+
+TEST_F(BtifRcTxnTest, test_abs_vol_pending_send_failure_is_retried) {
+  ASSERT_EQ(RC_ABS_VOL_SENT, rc_abs_vol_set(&vol_, 10, 0));
+  ASSERT_EQ(RC_ABS_VOL_QUEUED, rc_abs_vol_set(&vol_, 20, 10));
+
+  // The pending volume cannot be sent when the response arrives; it is kept
+  // and the timer is armed to try again.
+  avct_.fail_sends = true;
+  EXPECT_TRUE(avct_.Respond(&vol_, 100));
+  EXPECT_EQ(1u, avct_.sent.size());
+  EXPECT_EQ(1u, vol_.send_failures);
+  EXPECT_TRUE(vol_.pending);
+  EXPECT_TRUE(avct_.timer_armed);
+
+  avct_.fail_sends = false;
+  EXPECT_TRUE(rc_abs_vol_timeout(&vol_, 100 + RC_ABS_VOL_RSP_TIMEOUT_MS));
+  ASSERT_EQ(2u, avct_.sent.size());
+  EXPECT_EQ(20, avct_.sent[1].volume);
+  EXPECT_FALSE(vol_.pending);
+}
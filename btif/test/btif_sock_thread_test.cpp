@@ -0,0 +1,191 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C" {
+#include "btif/include/btif_sock_thread.h"
+#include "osi/include/osi.h"
+#include "osi/include/semaphore.h"
+}
+
+// More sockets than the old poll() implementation could monitor (64).
+static const int NUM_SOCKETS = 512;
+static const int ROUNDS = 20;
+static const int TEST_SOCK_TYPE = BTSOCK_RFCOMM;
+
+static int thread_handle = -1;
+static int app_fds[NUM_SOCKETS];
+static int our_fds[NUM_SOCKETS];
+static int events_pending;
+static int read_events;
+static int exception_events;
+static semaphore_t *done_semaphore;
+static uint64_t rearm_time_ns;
+
+static uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void signaled_cb(int fd, int type, int flags, uint32_t user_id) {
+  EXPECT_EQ(TEST_SOCK_TYPE, type);
+  EXPECT_LT(user_id, (uint32_t)NUM_SOCKETS);
+  EXPECT_EQ(our_fds[user_id], fd);
+
+  if (flags & SOCK_THREAD_FD_EXCEPTION) {
+    ++exception_events;
+  } else if (flags & SOCK_THREAD_FD_RD) {
+    char byte;
+    EXPECT_EQ(1, recv(fd, &byte, 1, MSG_DONTWAIT));
+    ++read_events;
+  }
+
+  if (--events_pending == 0)
+    semaphore_post(done_semaphore);
+}
+
+static void rearm_cb(int fd, UNUSED_ATTR int type, int flags, uint32_t user_id) {
+  // Data is left unread, so re-arming from the callback must fire again at
+  // once without any help from the command socket.
+  EXPECT_TRUE(flags & SOCK_THREAD_FD_RD);
+  if (--events_pending == 0) {
+    semaphore_post(done_semaphore);
+    return;
+  }
+  uint64_t start = now_ns();
+  btsock_thread_add_fd(thread_handle, fd, TEST_SOCK_TYPE, SOCK_THREAD_FD_RD, user_id);
+  rearm_time_ns += now_ns() - start;
+}
+
+class BtifSockThreadTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    events_pending = 0;
+    read_events = 0;
+    exception_events = 0;
+    rearm_time_ns = 0;
+    done_semaphore = semaphore_new(0);
+    btsock_thread_init();
+    for (int i = 0; i < NUM_SOCKETS; ++i) {
+      int fds[2];
+      ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+      our_fds[i] = fds[0];
+      app_fds[i] = fds[1];
+    }
+  }
+
+  virtual void TearDown() {
+    btsock_thread_exit(thread_handle);
+    thread_handle = -1;
+    for (int i = 0; i < NUM_SOCKETS; ++i) {
+      if (our_fds[i] != -1)
+        close(our_fds[i]);
+      if (app_fds[i] != -1)
+        close(app_fds[i]);
+    }
+    semaphore_free(done_semaphore);
+  }
+};
+
+TEST_F(BtifSockThreadTest, test_many_sockets_read) {
+  thread_handle = btsock_thread_create(signaled_cb, NULL);
+  ASSERT_GE(thread_handle, 0);
+
+  uint64_t start = now_ns();
+  for (int round = 0; round < ROUNDS; ++round) {
+    events_pending = NUM_SOCKETS;
+    for (int i = 0; i < NUM_SOCKETS; ++i)
+      btsock_thread_add_fd(thread_handle, our_fds[i], TEST_SOCK_TYPE,
+                           SOCK_THREAD_FD_RD, i);
+    for (int i = 0; i < NUM_SOCKETS; ++i)
+      ASSERT_EQ(1, send(app_fds[i], "x", 1, 0));
+    semaphore_wait(done_semaphore);
+  }
+  uint64_t elapsed_ns = now_ns() - start;
+
+  EXPECT_EQ(NUM_SOCKETS * ROUNDS, read_events);
+  EXPECT_EQ(0, exception_events);
+  printf("%d sockets: %.0f events/sec\n", NUM_SOCKETS,
+         read_events * 1000000000.0 / elapsed_ns);
+}
+
+TEST_F(BtifSockThreadTest, test_rearm_in_callback) {
+  thread_handle = btsock_thread_create(rearm_cb, NULL);
+  ASSERT_GE(thread_handle, 0);
+
+  const int rearms_per_socket = 16;
+  events_pending = NUM_SOCKETS * rearms_per_socket;
+  uint64_t start = now_ns();
+  for (int i = 0; i < NUM_SOCKETS; ++i) {
+    ASSERT_EQ(1, send(app_fds[i], "x", 1, 0));
+    btsock_thread_add_fd(thread_handle, our_fds[i], TEST_SOCK_TYPE,
+                         SOCK_THREAD_FD_RD, i);
+  }
+  semaphore_wait(done_semaphore);
+  uint64_t elapsed_ns = now_ns() - start;
+
+  int rearms = NUM_SOCKETS * (rearms_per_socket - 1);
+  printf("%d re-arms: %.0f events/sec, %.0f ns per re-arm, %.0f ns per event\n",
+         rearms, NUM_SOCKETS * rearms_per_socket * 1000000000.0 / elapsed_ns,
+         (double)rearm_time_ns / rearms,
+         (double)elapsed_ns / (NUM_SOCKETS * rearms_per_socket));
+}
+
+TEST_F(BtifSockThreadTest, test_exception_on_peer_close) {
+  thread_handle = btsock_thread_create(signaled_cb, NULL);
+  ASSERT_GE(thread_handle, 0);
+
+  events_pending = NUM_SOCKETS;
+  for (int i = 0; i < NUM_SOCKETS; ++i)
+    btsock_thread_add_fd(thread_handle, our_fds[i], TEST_SOCK_TYPE,
+                         SOCK_THREAD_FD_EXCEPTION, i);
+  for (int i = 0; i < NUM_SOCKETS; ++i) {
+    close(app_fds[i]);
+    app_fds[i] = -1;
+  }
+  semaphore_wait(done_semaphore);
+
+  EXPECT_EQ(NUM_SOCKETS, exception_events);
+}
+
+TEST_F(BtifSockThreadTest, test_remove_fd_and_close) {
+  thread_handle = btsock_thread_create(signaled_cb, NULL);
+  ASSERT_GE(thread_handle, 0);
+
+  for (int i = 0; i < NUM_SOCKETS; ++i) {
+    btsock_thread_add_fd(thread_handle, our_fds[i], TEST_SOCK_TYPE,
+                         SOCK_THREAD_FD_RD, i);
+    EXPECT_TRUE(btsock_thread_remove_fd_and_close(thread_handle, our_fds[i]));
+  }
+
+  // Exiting joins the poll thread, so every remove has been processed.
+  btsock_thread_exit(thread_handle);
+  thread_handle = -1;
+  for (int i = 0; i < NUM_SOCKETS; ++i) {
+    EXPECT_EQ(-1, fcntl(our_fds[i], F_GETFD));
+    our_fds[i] = -1;
+  }
+  EXPECT_EQ(0, read_events);
+}
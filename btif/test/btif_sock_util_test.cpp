@@ -0,0 +1,450 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "osi/test/AllocationTestHarness.h"
+
+extern "C" {
+#include "btif/include/btif_sock_util.h"
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+#include "stack/include/l2c_api.h"
+#include "stack/include/l2cdefs.h"
+#include "stack/include/rfcdefs.h"
+}
+
+// OBEX pushes 64 KB packets, which the app writes to the L2CAP socket as a
+// burst of MTU sized messages.
+static const size_t OBEX_PACKET_SIZE = 64 * 1024;
+static const size_t OBEX_BURSTS = 32;
+static const size_t MESSAGE_SIZE = 990 * 8;
+
+// RFCOMM frames as L2CAP hands them up with the default RFCOMM MTU, and the
+// amount pushed through the app socket per benchmark run.
+static const uint16_t RFCOMM_FRAME_SIZE = 990;
+static const size_t RFCOMM_BENCH_BYTES = 16 * 1024 * 1024;
+
+// The MPS of an ERTM L2CAP socket, so one message is one I-frame.
+static const uint16_t ERTM_MPS = 1010;
+
+// Builds a received RFCOMM frame the way the L2CAP lower edge delivers it: the
+// payload follows the L2CAP and RFCOMM headers in the same buffer.
+static BT_HDR *make_rx_frame(uint16_t len, uint8_t seed) {
+  BT_HDR *p_buf = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET +
+                                       RFCOMM_MIN_OFFSET + len);
+  p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+  p_buf->len = len;
+  uint8_t *p = (uint8_t *)(p_buf + 1) + p_buf->offset;
+  for (uint16_t i = 0; i < len; ++i)
+    p[i] = (uint8_t)(seed + i);
+  return p_buf;
+}
+
+class BtifSockUtilTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_SEQPACKET, 0, fds_));
+    int size = OBEX_PACKET_SIZE * 2;
+    setsockopt(fds_[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds_[0], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+
+  virtual void TearDown() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  int fds_[2];
+};
+
+TEST_F(BtifSockUtilTest, test_recv_msg_buf_sized_to_message) {
+  const uint8_t data[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+  ASSERT_EQ((ssize_t)sizeof(data), send(fds_[1], data, sizeof(data), 0));
+
+  BT_HDR *p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                    L2CAP_MAX_SDU_LENGTH);
+  ASSERT_TRUE(p_buf != NULL);
+  EXPECT_EQ(L2CAP_MIN_OFFSET, p_buf->offset);
+  EXPECT_EQ(sizeof(data), p_buf->len);
+  EXPECT_EQ(0, memcmp(data, (uint8_t *)(p_buf + 1) + p_buf->offset, sizeof(data)));
+  osi_free(p_buf);
+
+  // Nothing left to read.
+  EXPECT_TRUE(sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                L2CAP_MAX_SDU_LENGTH) == NULL);
+}
+
+TEST_F(BtifSockUtilTest, test_recv_msg_buf_empty_message) {
+  ASSERT_EQ(0, send(fds_[1], NULL, 0, 0));
+  const uint8_t data[] = {0xAA};
+  ASSERT_EQ(1, send(fds_[1], data, sizeof(data), 0));
+
+  // The empty message is dropped instead of blocking the queue.
+  EXPECT_TRUE(sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                L2CAP_MAX_SDU_LENGTH) == NULL);
+  BT_HDR *p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                    L2CAP_MAX_SDU_LENGTH);
+  ASSERT_TRUE(p_buf != NULL);
+  EXPECT_EQ(1, p_buf->len);
+  osi_free(p_buf);
+}
+
+TEST_F(BtifSockUtilTest, test_recv_msg_buf_truncates_oversized_message) {
+  uint8_t data[64];
+  memset(data, 0x5A, sizeof(data));
+  ASSERT_EQ((ssize_t)sizeof(data), send(fds_[1], data, sizeof(data), 0));
+
+  BT_HDR *p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN, 16);
+  ASSERT_TRUE(p_buf != NULL);
+  EXPECT_EQ(16, p_buf->len);
+  osi_free(p_buf);
+}
+
+TEST_F(BtifSockUtilTest, test_obex_burst) {
+  uint8_t *packet = (uint8_t *)osi_malloc(OBEX_PACKET_SIZE);
+  for (size_t i = 0; i < OBEX_PACKET_SIZE; ++i)
+    packet[i] = (uint8_t)i;
+
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  size_t payload_bytes = 0;
+  for (size_t burst = 0; burst < OBEX_BURSTS; ++burst) {
+    for (size_t sent = 0; sent < OBEX_PACKET_SIZE; sent += MESSAGE_SIZE) {
+      size_t len = std::min(MESSAGE_SIZE, OBEX_PACKET_SIZE - sent);
+      ASSERT_EQ((ssize_t)len, send(fds_[1], packet + sent, len, 0));
+    }
+
+    size_t received = 0;
+    BT_HDR *p_buf;
+    while ((p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                      L2CAP_MAX_SDU_LENGTH)) != NULL) {
+      ++allocations;
+      allocated_bytes += sizeof(BT_HDR) + p_buf->offset + p_buf->len + L2CAP_FCS_LEN;
+      ASSERT_EQ(0, memcmp(packet + received,
+                          (uint8_t *)(p_buf + 1) + p_buf->offset, p_buf->len));
+      received += p_buf->len;
+      osi_free(p_buf);
+    }
+    EXPECT_EQ(OBEX_PACKET_SIZE, received);
+    payload_bytes += received;
+  }
+  osi_free(packet);
+
+  // Previously every message cost an L2CAP_MAX_SDU_LENGTH buffer plus the
+  // BT_HDR that GAP copied the payload into.
+  const double mb = payload_bytes / (1024.0 * 1024.0);
+  const size_t old_allocated_bytes =
+      allocations * (L2CAP_MAX_SDU_LENGTH + sizeof(BT_HDR) + L2CAP_MIN_OFFSET +
+                     MESSAGE_SIZE);
+  printf("per MB: %.1f allocations (was %.1f), %.0f bytes allocated (was %.0f), "
+         "0 bytes copied (was %.0f)\n",
+         allocations / mb, 2 * allocations / mb, allocated_bytes / mb,
+         old_allocated_bytes / mb, payload_bytes / mb);
+  EXPECT_LT(allocated_bytes, payload_bytes + allocations * 64);
+}
+
+// Writes the FCS after the payload of |p_buf| the way prepare_I_frame() in
+// l2c_fcr.c does for an ERTM I-frame.
+static void append_ertm_fcs(BT_HDR *p_buf) {
+  uint8_t *p = (uint8_t *)(p_buf + 1) + p_buf->offset + p_buf->len;
+  UINT16_TO_STREAM(p, 0xF0F0);
+  p_buf->len += L2CAP_FCS_LEN;
+}
+
+// The allocation tracker checks the canary after every buffer when it is
+// freed, so an FCS written past the end of the allocation fails the test.
+class BtifSockMsgBufErtmTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_SEQPACKET, 0, fds_));
+  }
+
+  virtual void TearDown() {
+    close(fds_[0]);
+    close(fds_[1]);
+    AllocationTestHarness::TearDown();
+  }
+
+  int fds_[2];
+};
+
+TEST_F(BtifSockMsgBufErtmTest, test_fcs_fits_after_message_filling_buffer) {
+  std::vector<uint8_t> data(ERTM_MPS, 0x3C);
+  ASSERT_EQ((ssize_t)data.size(), send(fds_[1], data.data(), data.size(), 0));
+
+  BT_HDR *p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                    ERTM_MPS);
+  ASSERT_TRUE(p_buf != NULL);
+  EXPECT_EQ(ERTM_MPS, p_buf->len);
+
+  append_ertm_fcs(p_buf);
+  EXPECT_EQ(0, memcmp(data.data(), (uint8_t *)(p_buf + 1) + p_buf->offset,
+                      data.size()));
+  osi_free(p_buf);
+}
+
+TEST_F(BtifSockMsgBufErtmTest, test_fcs_fits_after_truncated_message) {
+  std::vector<uint8_t> data(ERTM_MPS + 100, 0x3C);
+  ASSERT_EQ((ssize_t)data.size(), send(fds_[1], data.data(), data.size(), 0));
+
+  BT_HDR *p_buf = sock_recv_msg_buf(fds_[0], L2CAP_MIN_OFFSET, L2CAP_FCS_LEN,
+                                    ERTM_MPS);
+  ASSERT_TRUE(p_buf != NULL);
+  EXPECT_EQ(ERTM_MPS, p_buf->len);
+
+  append_ertm_fcs(p_buf);
+  osi_free(p_buf);
+}
+
+class BtifSockSendBufListTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_STREAM, 0, fds_));
+    bufs_ = list_new(osi_free);
+  }
+
+  virtual void TearDown() {
+    list_free(bufs_);
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  int fds_[2];
+  list_t *bufs_;
+};
+
+TEST_F(BtifSockSendBufListTest, test_send_buf_list_gathers_buffers) {
+  list_append(bufs_, make_rx_frame(10, 0));
+  list_append(bufs_, make_rx_frame(0, 0));
+  list_append(bufs_, make_rx_frame(20, 10));
+
+  EXPECT_EQ(30, sock_send_buf_list(fds_[1], bufs_));
+  EXPECT_TRUE(list_is_empty(bufs_));
+
+  uint8_t data[64];
+  ASSERT_EQ(30, recv(fds_[0], data, sizeof(data), MSG_DONTWAIT));
+  for (int i = 0; i < 30; ++i)
+    EXPECT_EQ(i, data[i]);
+}
+
+TEST_F(BtifSockSendBufListTest, test_send_buf_list_stops_when_socket_full) {
+  int size = 4096;
+  setsockopt(fds_[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  setsockopt(fds_[0], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  const size_t frames = 256;
+  for (size_t i = 0; i < frames; ++i)
+    list_append(bufs_, make_rx_frame(RFCOMM_FRAME_SIZE, (uint8_t)(i * RFCOMM_FRAME_SIZE)));
+
+  // Alternate between filling the socket and draining it; the byte stream
+  // must come out in order, whatever buffer boundary the socket cut at.
+  std::vector<uint8_t> received;
+  while (!list_is_empty(bufs_)) {
+    ASSERT_LT(0, sock_send_buf_list(fds_[1], bufs_));
+    uint8_t data[8192];
+    ssize_t ret;
+    while ((ret = recv(fds_[0], data, sizeof(data), MSG_DONTWAIT)) > 0)
+      received.insert(received.end(), data, data + ret);
+  }
+
+  ASSERT_EQ(frames * RFCOMM_FRAME_SIZE, received.size());
+  for (size_t i = 0; i < received.size(); ++i)
+    ASSERT_EQ((uint8_t)i, received[i]) << "at byte " << i;
+}
+
+TEST_F(BtifSockSendBufListTest, test_send_buf_list_error) {
+  list_append(bufs_, make_rx_frame(10, 0));
+  close(fds_[0]);
+  EXPECT_EQ(-1, sock_send_buf_list(fds_[1], bufs_));
+  fds_[0] = socket(AF_LOCAL, SOCK_STREAM, 0);
+}
+
+// Moves RFCOMM_BENCH_BYTES of received frames to the app socket three ways:
+// copying them out first like PORT_ReadData, one send() per frame, and
+// gathered with sock_send_buf_list. Reports MB/s and the bytes copied.
+TEST_F(BtifSockSendBufListTest, test_rfcomm_rx_to_app_throughput) {
+  enum Mode { COPY_THEN_SEND, SEND_PER_FRAME, SEND_BUF_LIST };
+  const char *names[] = {"copy + send", "send per frame", "sendmsg buf list"};
+  const size_t frames = RFCOMM_BENCH_BYTES / RFCOMM_FRAME_SIZE;
+
+  for (int mode = COPY_THEN_SEND; mode <= SEND_BUF_LIST; ++mode) {
+    size_t drained = 0;
+    std::thread app([&]() {
+      std::vector<uint8_t> data(64 * 1024);
+      ssize_t ret;
+      while (drained < frames * RFCOMM_FRAME_SIZE &&
+             (ret = recv(fds_[0], data.data(), data.size(), 0)) > 0)
+        drained += ret;
+    });
+
+    size_t copied = 0;
+    std::vector<uint8_t> flat(4 * RFCOMM_FRAME_SIZE);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; i += 4) {
+      // A burst of frames from the fake L2CAP lower edge.
+      for (size_t j = i; j < std::min(frames, i + 4); ++j)
+        list_append(bufs_, make_rx_frame(RFCOMM_FRAME_SIZE, (uint8_t)j));
+
+      if (mode == COPY_THEN_SEND) {
+        size_t len = 0;
+        while (!list_is_empty(bufs_)) {
+          BT_HDR *p_buf = (BT_HDR *)list_front(bufs_);
+          memcpy(flat.data() + len, (uint8_t *)(p_buf + 1) + p_buf->offset, p_buf->len);
+          len += p_buf->len;
+          list_remove(bufs_, p_buf);
+        }
+        copied += len;
+        ASSERT_EQ((int)len, sock_send_all(fds_[1], flat.data(), len));
+      } else if (mode == SEND_PER_FRAME) {
+        while (!list_is_empty(bufs_)) {
+          BT_HDR *p_buf = (BT_HDR *)list_front(bufs_);
+          ASSERT_EQ((int)p_buf->len, sock_send_all(fds_[1], (uint8_t *)(p_buf + 1) + p_buf->offset, p_buf->len));
+          list_remove(bufs_, p_buf);
+        }
+      } else {
+        while (!list_is_empty(bufs_))
+          ASSERT_LE(0, sock_send_buf_list(fds_[1], bufs_));
+      }
+    }
+    app.join();
+    const double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(frames * RFCOMM_FRAME_SIZE, drained);
+    printf("%s: %.1f MB/s, %zu bytes copied\n", names[mode],
+           drained / (1024.0 * 1024.0) / seconds, copied);
+  }
+}
+
+// As many sockets as btif_sock_rfc has slots.
+static const size_t NUM_RFC_SLOTS = 30;
+
+TEST(BtifSockIdTest, test_id_index_lookup_probe_length) {
+  hash_map_t *index = sock_id_index_new();
+  ASSERT_TRUE(index != NULL);
+
+  // Open and close sockets the way the L2CAP socket layer does, keeping a
+  // sliding window of open ones, so ids keep increasing.
+  const size_t open_sockets = 64;
+  uint32_t last_id = 0;
+  std::vector<uint32_t> ids;
+  for (size_t i = 0; i < 4096; ++i) {
+    last_id = sock_id_index_next(index, last_id);
+    ASSERT_NE(0U, last_id);
+    EXPECT_FALSE(hash_map_has_key(index, UINT_TO_PTR(last_id)));
+    hash_map_set(index, UINT_TO_PTR(last_id), UINT_TO_PTR(last_id));
+    ids.push_back(last_id);
+
+    if (ids.size() > open_sockets) {
+      EXPECT_TRUE(hash_map_erase(index, UINT_TO_PTR(ids.front())));
+      ids.erase(ids.begin());
+    }
+
+    // Every lookup finds its socket within a few slots however long the
+    // index has been in use.
+    EXPECT_LE(hash_map_longest_probe(index), 4U) << "after " << i << " sockets";
+  }
+
+  for (uint32_t id : ids)
+    EXPECT_EQ(UINT_TO_PTR(id), hash_map_get(index, UINT_TO_PTR(id)));
+
+  hash_map_free(index);
+}
+
+TEST(BtifSockIdTest, test_id_index_next_skips_ids_in_use) {
+  hash_map_t *index = sock_id_index_new();
+  ASSERT_TRUE(index != NULL);
+
+  hash_map_set(index, UINT_TO_PTR(1), UINT_TO_PTR(1));
+  hash_map_set(index, UINT_TO_PTR(2), UINT_TO_PTR(2));
+  hash_map_set(index, UINT_TO_PTR(UINT32_MAX), UINT_TO_PTR(1));
+
+  EXPECT_EQ(3U, sock_id_index_next(index, 0));
+  EXPECT_EQ(3U, sock_id_index_next(index, UINT32_MAX - 1));
+  EXPECT_EQ(10U, sock_id_index_next(index, 9));
+
+  hash_map_free(index);
+}
+
+TEST(BtifSockIdTest, test_slot_ids) {
+  uint32_t slot_ids[NUM_RFC_SLOTS] = { 0 };
+  uint32_t last_id = 0;
+
+  // Slots are reused in no particular order.
+  for (size_t i = 0; i < 1000; ++i) {
+    size_t slot = (i * 7) % NUM_RFC_SLOTS;
+    uint32_t stale_id = slot_ids[slot];
+
+    uint32_t id = sock_slot_id_next(last_id, slot, NUM_RFC_SLOTS);
+    EXPECT_GT(id, last_id);
+    EXPECT_EQ(slot, id % NUM_RFC_SLOTS);
+    slot_ids[slot] = last_id = id;
+
+    // The lookup goes straight to the slot; an id from before it was
+    // reused no longer matches.
+    if (stale_id)
+      EXPECT_NE(stale_id, slot_ids[stale_id % NUM_RFC_SLOTS]);
+    EXPECT_EQ(id, slot_ids[id % NUM_RFC_SLOTS]);
+  }
+}
+
+TEST(BtifSockIdTest, test_slot_id_overflow) {
+  // The first generation, skipping 0 for slot 0.
+  EXPECT_EQ(NUM_RFC_SLOTS, sock_slot_id_next(UINT32_MAX - 1, 0, NUM_RFC_SLOTS));
+  EXPECT_EQ(5U, sock_slot_id_next(UINT32_MAX - 2, 5, NUM_RFC_SLOTS));
+  EXPECT_EQ(7U, sock_slot_id_next(0, 7, NUM_RFC_SLOTS));
+}
+
+// Prints the time per socket lookup by id with as many sockets as are usually
+// open and with many more. Only prints, wall clock time is not reliable
+// enough to test against.
+TEST(BtifSockIdTest, test_benchmark_id_index_lookup) {
+  const size_t lookups = 200000;
+  hash_map_t *index = sock_id_index_new();
+  ASSERT_TRUE(index != NULL);
+
+  uint32_t last_id = 0;
+  for (size_t num_socks = 1; num_socks <= 1024; ++num_socks) {
+    last_id = sock_id_index_next(index, last_id);
+    hash_map_set(index, UINT_TO_PTR(last_id), UINT_TO_PTR(last_id));
+    if (num_socks != 8 && num_socks != 1024)
+      continue;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (size_t i = 0; i < lookups; ++i)
+      found += hash_map_get(index, UINT_TO_PTR(i % num_socks + 1)) != NULL;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(lookups, found);
+    printf("%zu sockets: %.1f ns per lookup\n", num_socks, (double)elapsed / lookups);
+  }
+
+  hash_map_free(index);
+}
@@ -101,6 +101,12 @@ typedef enum {
   // to preferred conn params immediately post connection. Disable automatic switching to
   // preferred conn params for such devices and allow them to explicity ask for it.
   INTEROP_DISABLE_LE_CONN_PREFERRED_PARAMS,
+
+  // Some LE devices misbehave when the link switches to long data PDUs or when
+  // we start an ATT MTU exchange they did not ask for. Leave the data length
+  // and MTU at their defaults on connection for such devices.
+  INTEROP_DISABLE_LE_AUTO_DATA_LENGTH,
+  INTEROP_DISABLE_LE_AUTO_MTU,
 } interop_feature_t;
 
 // Check if a given |addr| matches a known interoperability workaround as identified
@@ -19,22 +19,48 @@
 #define LOG_TAG "bt_device_interop"
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h> // For bsearch and qsort
 #include <string.h> // For memcmp
 
 #include "btcore/include/module.h"
 #include "device/include/interop.h"
 #include "device/include/interop_database.h"
-#include "osi/include/allocator.h"
-#include "osi/include/list.h"
+#include "osi/include/array.h"
 #include "osi/include/log.h"
 
 #define CASE_RETURN_STR(const) case const: return #const;
 
-static list_t *interop_list = NULL;
+#define ADDR_DB_SIZE (sizeof(interop_addr_database) / sizeof(interop_addr_entry_t))
+#define NAME_DB_SIZE (sizeof(interop_name_database) / sizeof(interop_name_entry_t))
+
+// A name trie node; the first level below the root holds the feature, the
+// levels below that the name characters. Child and sibling index into
+// |name_trie|, 0 (the root) meaning none.
+typedef struct {
+  uint16_t child;
+  uint16_t sibling;
+  uint8_t c;
+  bool terminal;
+} interop_trie_node_t;
+
+static pthread_once_t index_once = PTHREAD_ONCE_INIT;
+
+// |interop_addr_database| sorted by feature, prefix length and prefix.
+static const interop_addr_entry_t *addr_index[ADDR_DB_SIZE];
+static uint8_t addr_index_lengths;
+
+static interop_trie_node_t name_trie[1 + NAME_DB_SIZE * (sizeof(interop_name_database[0].name) + 1)];
+static size_t name_trie_size = 1;
+
+// Dynamic entries, kept sorted the same way as |addr_index|.
+static array_t *interop_array = NULL;
+static uint8_t interop_array_lengths;
 
 static const char* interop_feature_string_(const interop_feature_t feature);
-static void interop_free_entry_(void *data);
-static void interop_lazy_init_(void);
+static void interop_build_index_(void);
+static int interop_entry_cmp_(const void *a, const void *b);
+static int interop_entry_ptr_cmp_(const void *a, const void *b);
 static bool interop_match_fixed_(const interop_feature_t feature, const bt_bdaddr_t *addr);
 static bool interop_match_dynamic_(const interop_feature_t feature, const bt_bdaddr_t *addr);
 
@@ -57,15 +83,27 @@ bool interop_match_addr(const interop_feature_t feature, const bt_bdaddr_t *addr
 bool interop_match_name(const interop_feature_t feature, const char *name) {
   assert(name);
 
-  const size_t db_size = sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name, interop_name_database[i].length) == 0) {
+  pthread_once(&index_once, interop_build_index_);
+
+  // Walk down the feature's branch; any complete entry along the way is a
+  // prefix of |name|.
+  uint16_t node = name_trie[0].child;
+  uint8_t c = (uint8_t)feature;
+  for (const char *p = name; node != 0; c = (uint8_t)*p++) {
+    while (node != 0 && name_trie[node].c != c)
+      node = name_trie[node].sibling;
+    if (node == 0)
+      break;
+
+    if (name_trie[node].terminal) {
       LOG_WARN(LOG_TAG, "%s() Device with name: %s is a match for interop workaround %s", __func__,
           name, interop_feature_string_(feature));
       return true;
     }
+
+    if (*p == '\0')
+      break;
+    node = name_trie[node].child;
   }
 
   return false;
@@ -113,25 +151,32 @@ void interop_database_add(const uint16_t feature, const bt_bdaddr_t *addr, size_
   assert(length > 0);
   assert(length < sizeof(bt_bdaddr_t));
 
-  interop_addr_entry_t *entry = osi_calloc(sizeof(interop_addr_entry_t));
-  memcpy(&entry->addr, addr, length);
-  entry->feature = feature;
-  entry->length = length;
+  interop_addr_entry_t entry;
+  memset(&entry, 0, sizeof(entry));
+  memcpy(&entry.addr, addr, length);
+  entry.feature = feature;
+  entry.length = length;
+
+  if (interop_array == NULL)
+    interop_array = array_new(sizeof(interop_addr_entry_t));
 
-  interop_lazy_init_();
-  list_append(interop_list, entry);
+  // Entries are added once at start-up, lookups happen on every connection.
+  array_append_ptr(interop_array, &entry);
+  qsort(array_ptr(interop_array), array_length(interop_array), sizeof(interop_addr_entry_t),
+      interop_entry_cmp_);
+  interop_array_lengths |= 1 << length;
 }
 
 void interop_database_clear() {
-  if (interop_list)
-    list_clear(interop_list);
+  array_free(interop_array);
+  interop_array = NULL;
+  interop_array_lengths = 0;
 }
 
 // Module life-cycle functions
 
 static future_t *interop_clean_up(void) {
-  list_free(interop_list);
-  interop_list = NULL;
+  interop_database_clear();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -160,35 +205,82 @@ static const char* interop_feature_string_(const interop_feature_t feature) {
     CASE_RETURN_STR(INTEROP_DISABLE_SNIFF_DURING_SCO)
     CASE_RETURN_STR(INTEROP_INCREASE_AG_CONN_TIMEOUT)
     CASE_RETURN_STR(INTEROP_DISABLE_LE_CONN_PREFERRED_PARAMS)
+    CASE_RETURN_STR(INTEROP_DISABLE_LE_AUTO_DATA_LENGTH)
+    CASE_RETURN_STR(INTEROP_DISABLE_LE_AUTO_MTU)
   }
 
   return "UNKNOWN";
 }
 
-static void interop_free_entry_(void *data) {
-  interop_addr_entry_t *entry = (interop_addr_entry_t *)data;
-  osi_free(entry);
+// Orders entries by feature, then prefix length, then prefix, so that a
+// lookup is one binary search per prefix length in use.
+static int interop_entry_cmp_(const void *a, const void *b) {
+  const interop_addr_entry_t *lhs = (const interop_addr_entry_t *)a;
+  const interop_addr_entry_t *rhs = (const interop_addr_entry_t *)b;
+
+  if (lhs->feature != rhs->feature)
+    return lhs->feature < rhs->feature ? -1 : 1;
+  if (lhs->length != rhs->length)
+    return lhs->length < rhs->length ? -1 : 1;
+  return memcmp(&lhs->addr, &rhs->addr, lhs->length);
 }
 
-static void interop_lazy_init_(void) {
-  if (interop_list == NULL) {
-    interop_list = list_new(interop_free_entry_);
+static int interop_entry_ptr_cmp_(const void *a, const void *b) {
+  return interop_entry_cmp_(*(const interop_addr_entry_t * const *)a,
+      *(const interop_addr_entry_t * const *)b);
+}
+
+static void interop_trie_insert_(uint8_t feature, const char *name, size_t length) {
+  uint16_t parent = 0;
+  for (size_t i = 0; i <= length; ++i) {
+    const uint8_t c = (i == 0) ? feature : (uint8_t)name[i - 1];
+
+    uint16_t node = name_trie[parent].child;
+    while (node != 0 && name_trie[node].c != c)
+      node = name_trie[node].sibling;
+
+    if (node == 0) {
+      assert(name_trie_size < sizeof(name_trie) / sizeof(name_trie[0]));
+      node = name_trie_size++;
+      name_trie[node].c = c;
+      name_trie[node].sibling = name_trie[parent].child;
+      name_trie[parent].child = node;
+    }
+    parent = node;
+  }
+  name_trie[parent].terminal = true;
+}
+
+static void interop_build_index_(void) {
+  for (size_t i = 0; i != ADDR_DB_SIZE; ++i) {
+    addr_index[i] = &interop_addr_database[i];
+    addr_index_lengths |= 1 << interop_addr_database[i].length;
+  }
+  qsort(addr_index, ADDR_DB_SIZE, sizeof(addr_index[0]), interop_entry_ptr_cmp_);
+
+  for (size_t i = 0; i != NAME_DB_SIZE; ++i) {
+    interop_trie_insert_((uint8_t)interop_name_database[i].feature,
+        interop_name_database[i].name, interop_name_database[i].length);
   }
 }
 
 static bool interop_match_dynamic_(const interop_feature_t feature, const bt_bdaddr_t *addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0)
+  if (interop_array == NULL || array_length(interop_array) == 0)
     return false;
 
-  const list_node_t *node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t *entry = list_node(node);
-    assert(entry);
+  interop_addr_entry_t key;
+  memset(&key, 0, sizeof(key));
+  key.feature = feature;
 
-    if (feature == entry->feature && memcmp(addr, &entry->addr, entry->length) == 0)
-      return true;
+  for (size_t length = 1; length < sizeof(bt_bdaddr_t); ++length) {
+    if (!(interop_array_lengths & (1 << length)))
+      continue;
 
-    node = list_next(node);
+    key.length = length;
+    memcpy(&key.addr, addr, length);
+    if (bsearch(&key, array_ptr(interop_array), array_length(interop_array),
+        sizeof(interop_addr_entry_t), interop_entry_cmp_))
+      return true;
   }
   return false;
 }
@@ -196,12 +288,22 @@ static bool interop_match_dynamic_(const interop_feature_t feature, const bt_bda
 static bool interop_match_fixed_(const interop_feature_t feature, const bt_bdaddr_t *addr) {
   assert(addr);
 
-  const size_t db_size = sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr, interop_addr_database[i].length) == 0) {
+  pthread_once(&index_once, interop_build_index_);
+
+  interop_addr_entry_t key;
+  memset(&key, 0, sizeof(key));
+  key.feature = feature;
+  const interop_addr_entry_t *p_key = &key;
+
+  for (size_t length = 1; length < sizeof(bt_bdaddr_t); ++length) {
+    if (!(addr_index_lengths & (1 << length)))
+      continue;
+
+    key.length = length;
+    memcpy(&key.addr, addr, length);
+    if (bsearch(&p_key, addr_index, ADDR_DB_SIZE, sizeof(addr_index[0]),
+        interop_entry_ptr_cmp_))
       return true;
-    }
   }
 
   return false;
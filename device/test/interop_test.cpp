@@ -18,8 +18,12 @@
 
 #include <gtest/gtest.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 extern "C" {
 #include "device/include/interop.h"
+#include "device/include/interop_database.h"
 }
 
 TEST(InteropTest, test_lookup_hit) {
@@ -75,3 +79,97 @@ TEST(InteropTest, test_name_miss) {
   EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "audi"));
   EXPECT_FALSE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "BMW M3"));
 }
+
+// Reference implementations of the original linear scans.
+static bool linear_match_addr(const interop_feature_t feature, const bt_bdaddr_t *addr,
+    const interop_addr_entry_t *entries, size_t count) {
+  for (size_t i = 0; i != count; ++i) {
+    if (feature == entries[i].feature &&
+        memcmp(addr, &entries[i].addr, entries[i].length) == 0)
+      return true;
+  }
+  return false;
+}
+
+static bool linear_match_name(const interop_feature_t feature, const char *name) {
+  const size_t db_size = sizeof(interop_name_database) / sizeof(interop_name_entry_t);
+  for (size_t i = 0; i != db_size; ++i) {
+    if (feature == interop_name_database[i].feature &&
+        strlen(name) >= interop_name_database[i].length &&
+        strncmp(name, interop_name_database[i].name, interop_name_database[i].length) == 0)
+      return true;
+  }
+  return false;
+}
+
+static const int NUM_FEATURES = INTEROP_DISABLE_LE_CONN_PREFERRED_PARAMS + 1;
+static const size_t ADDR_DB_SIZE = sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
+
+// Half of the addresses share a prefix with a database entry so that both hits
+// and near misses are covered.
+static void random_addr(bt_bdaddr_t *addr) {
+  for (size_t i = 0; i < sizeof(addr->address); ++i)
+    addr->address[i] = rand();
+  if (rand() % 2) {
+    const interop_addr_entry_t *entry = &interop_addr_database[rand() % ADDR_DB_SIZE];
+    size_t length = entry->length - (rand() % 2);
+    memcpy(addr->address, entry->addr.address, length);
+  }
+}
+
+TEST(InteropTest, test_fixed_matches_linear_scan) {
+  srand(42);
+  for (int i = 0; i < 20000; ++i) {
+    bt_bdaddr_t addr;
+    random_addr(&addr);
+    const interop_feature_t feature = (interop_feature_t)(rand() % NUM_FEATURES);
+    EXPECT_EQ(linear_match_addr(feature, &addr, interop_addr_database, ADDR_DB_SIZE),
+              interop_match_addr(feature, &addr));
+  }
+}
+
+TEST(InteropTest, test_dynamic_matches_linear_scan) {
+  srand(7);
+  interop_addr_entry_t added[64];
+  memset(added, 0, sizeof(added));
+  for (size_t i = 0; i < 64; ++i) {
+    random_addr(&added[i].addr);
+    added[i].length = 1 + rand() % 5;
+    added[i].feature = (interop_feature_t)(rand() % NUM_FEATURES);
+    interop_database_add(added[i].feature, &added[i].addr, added[i].length);
+  }
+
+  for (int i = 0; i < 20000; ++i) {
+    bt_bdaddr_t addr;
+    random_addr(&addr);
+    if (rand() % 2)
+      memcpy(addr.address, added[rand() % 64].addr.address, 3);
+    const interop_feature_t feature = (interop_feature_t)(rand() % NUM_FEATURES);
+    EXPECT_EQ(linear_match_addr(feature, &addr, interop_addr_database, ADDR_DB_SIZE) ||
+              linear_match_addr(feature, &addr, added, 64),
+              interop_match_addr(feature, &addr));
+  }
+
+  interop_database_clear();
+}
+
+TEST(InteropTest, test_name_matches_linear_scan) {
+  srand(1);
+  const size_t db_size = sizeof(interop_name_database) / sizeof(interop_name_entry_t);
+  for (int i = 0; i < 20000; ++i) {
+    const interop_name_entry_t *entry = &interop_name_database[rand() % db_size];
+    char name[64];
+    size_t length = rand() % (entry->length + 1);
+    memcpy(name, entry->name, length);
+    // Extend, corrupt or truncate the name.
+    size_t tail = rand() % 4;
+    for (size_t j = 0; j < tail; ++j)
+      name[length++] = "aB M"[rand() % 4];
+    name[length] = '\0';
+    if (length > 0 && rand() % 4 == 0)
+      name[rand() % length] ^= 0x20;
+
+    const interop_feature_t feature = (interop_feature_t)(rand() % NUM_FEATURES);
+    EXPECT_EQ(linear_match_name(feature, name), interop_match_name(feature, name)) << name;
+  }
+}
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "bt_types.h"
@@ -31,6 +32,36 @@ typedef void (*btsnoop_data_cb)(const uint16_t type, const uint8_t *p_data, cons
 void btsnoop_mem_set_callback(btsnoop_data_cb cb);
 
 // This function is invoked every time an HCI packet
-// is sent/received. Packets will be filtered  and then
-// forwarded to the |btsnoop_data_cb|.
+// is sent/received. Packets will be recorded in the snoop
+// ring, if there is one, then filtered and forwarded to the
+// |btsnoop_data_cb|.
 void btsnoop_mem_capture(const BT_HDR *p_buf);
+
+// Sizes of the in-memory snoop ring.
+typedef struct {
+  size_t num_packets;   // Most recent packets kept; older ones are overwritten.
+  size_t command_len;   // Bytes kept of each HCI command.
+  size_t event_len;     // Bytes kept of each HCI event.
+  size_t acl_len;       // Bytes kept of each ACL packet.
+  size_t sco_len;       // Bytes kept of each SCO packet.
+} btsnoop_mem_ring_config_t;
+
+// Allocates the snoop ring, which keeps the most recent HCI packets
+// regardless of |btsnoop_data_cb| and of btsnoop file logging, so that
+// they can be dumped after a failure. |config| may be NULL to use the
+// BTSNOOP_MEM_RING_* defaults from bt_target.h. Does nothing if the ring
+// already exists. Must not be called while packets are being captured.
+void btsnoop_mem_ring_init(const btsnoop_mem_ring_config_t *config);
+
+// Frees the snoop ring. Must not be called while packets are being
+// captured or the ring is being dumped.
+void btsnoop_mem_ring_cleanup(void);
+
+// Callback invoked with consecutive chunks of a snoop ring dump.
+typedef void (*btsnoop_mem_dump_cb)(const uint8_t *data, size_t len, void *context);
+
+// Writes the packets in the snoop ring, oldest first, to |cb| as a
+// btsnoop file. Safe to call while packets are being captured; packets
+// overwritten while they are read are left out. Returns the number of
+// packets written.
+size_t btsnoop_mem_ring_dump(btsnoop_mem_dump_cb cb, void *context);
@@ -24,6 +24,7 @@
 #include "osi/include/data_dispatcher.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/future.h"
+#include "osi/include/list.h"
 #include "osi/include/osi.h"
 #include "bt_types.h"
 
@@ -99,6 +100,13 @@ typedef struct hci_t {
   // Send some data downward through the HCI layer
   void (*transmit_downward)(data_dispatcher_type_t type, void *data);
 
+  // Deliver a list of BT_HDR packets upward as if they had been received from
+  // the controller, for replaying captured traffic. Blocks until they have
+  // been handed to the higher layers. Takes ownership of the packets. If
+  // |dispatched_us| is not NULL, it receives the CLOCK_MONOTONIC time in
+  // microseconds at which each packet, in list order, was handed on.
+  void (*inject_upward)(list_t *packets, uint64_t *dispatched_us);
+
   /** SSR cleanup is used in HW reset cases
   ** which would close all the client channels
   ** and turns off the chip*/
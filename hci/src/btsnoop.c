@@ -91,6 +91,10 @@ static future_t *start_up(void) {
   LOG_INFO(LOG_TAG, "%s Time GMT offset %ld\n", __func__, tm_cur.tm_gmtoff);
   gmt_offset = tm_cur.tm_gmtoff;
 
+  // The snoop ring outlives the module so that it can still be dumped
+  // after the stack went down.
+  btsnoop_mem_ring_init(NULL);
+
   module_started = true;
   stack_config->get_btsnoop_ext_options(&hci_ext_dump_enabled, &btsnoop_conf_from_file);
 #if (BTSNOOP_DEFAULT == TRUE)
@@ -16,19 +16,55 @@
  *
  ******************************************************************************/
 
+#include <arpa/inet.h>
 #include <assert.h>
+#include <string.h>
 #include <time.h>
 
+#include "bt_target.h"
 #include "hci/include/btsnoop_mem.h"
+#include "osi/include/allocator.h"
+
+// Epoch in microseconds since 01/01/0000.
+static const uint64_t BTSNOOP_EPOCH_DELTA = 0x00dcddb30f2f8000ULL;
+
+// btsnoop file header: identification pattern, version 1, datalink 1002 (H4).
+static const uint8_t BTSNOOP_FILE_HEADER[] = {
+  'b', 't', 's', 'n', 'o', 'o', 'p', '\0', 0, 0, 0, 1, 0, 0, 0x03, 0xea
+};
+
+// btsnoop packet record header, followed by the H4 packet type.
+static const size_t BTSNOOP_RECORD_HEADER_SIZE = 24 + 1;
+
+// One packet in the snoop ring. |seq| is zero while the slot is being
+// written and the index of the packet plus one once it is complete, so
+// that a dump can tell whether the slot was overwritten while it read it.
+typedef struct {
+  uint64_t seq;
+  uint64_t timestamp_us;
+  uint16_t type;
+  uint16_t length;
+  uint16_t included_length;
+  uint8_t data[];
+} ring_slot_t;
 
 static btsnoop_data_cb data_callback = NULL;
 
+static btsnoop_mem_ring_config_t ring_config;
+static uint8_t *ring_slots = NULL;
+static size_t ring_slot_size;
+static uint64_t ring_head;
+
+static size_t ring_max_len(const btsnoop_mem_ring_config_t *config);
+static size_t ring_snap_len(uint16_t type);
+static void ring_record(uint16_t type, const uint8_t *data, size_t length, size_t available);
+
 void btsnoop_mem_set_callback(btsnoop_data_cb cb) {
   data_callback = cb;
 }
 
 void btsnoop_mem_capture(const BT_HDR *packet) {
-  if (!data_callback)
+  if (!data_callback && !ring_slots)
     return;
 
   assert(packet);
@@ -61,6 +97,166 @@ void btsnoop_mem_capture(const BT_HDR *packet) {
       break;
   }
 
-  if (length)
+  if (!length)
+    return;
+
+  if (ring_slots)
+    ring_record(type, data, length, packet->len);
+
+  if (data_callback)
     (*data_callback)(type, data, length);
 }
+
+void btsnoop_mem_ring_init(const btsnoop_mem_ring_config_t *config) {
+  static const btsnoop_mem_ring_config_t default_config = {
+    .num_packets = BTSNOOP_MEM_RING_PACKETS,
+    .command_len = BTSNOOP_MEM_RING_CMD_LEN,
+    .event_len = BTSNOOP_MEM_RING_EVT_LEN,
+    .acl_len = BTSNOOP_MEM_RING_ACL_LEN,
+    .sco_len = BTSNOOP_MEM_RING_SCO_LEN,
+  };
+
+  if (ring_slots)
+    return;
+
+  if (!config)
+    config = &default_config;
+  if (config->num_packets == 0)
+    return;
+
+  ring_config = *config;
+  ring_slot_size = (sizeof(ring_slot_t) + ring_max_len(config) + 7) & ~(size_t)7;
+  ring_head = 0;
+  ring_slots = osi_calloc(ring_config.num_packets * ring_slot_size);
+}
+
+void btsnoop_mem_ring_cleanup(void) {
+  osi_free(ring_slots);
+  ring_slots = NULL;
+}
+
+size_t btsnoop_mem_ring_dump(btsnoop_mem_dump_cb cb, void *context) {
+  assert(cb != NULL);
+
+  cb(BTSNOOP_FILE_HEADER, sizeof(BTSNOOP_FILE_HEADER), context);
+  if (!ring_slots)
+    return 0;
+
+  // btsnoop timestamps are in local time.
+  time_t t = time(NULL);
+  struct tm tm_cur;
+  localtime_r(&t, &tm_cur);
+  const uint64_t time_offset_us =
+      BTSNOOP_EPOCH_DELTA + (int64_t)tm_cur.tm_gmtoff * 1000000LL;
+
+  ring_slot_t *slot = osi_malloc(ring_slot_size);
+  uint8_t *record = osi_malloc(BTSNOOP_RECORD_HEADER_SIZE + ring_max_len(&ring_config));
+
+  const uint64_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+  const uint64_t first = head > ring_config.num_packets ? head - ring_config.num_packets : 0;
+  size_t num_packets = 0;
+
+  for (uint64_t index = first; index < head; ++index) {
+    const ring_slot_t *src =
+        (const ring_slot_t *)(ring_slots + (index % ring_config.num_packets) * ring_slot_size);
+
+    // Skip the packet if it is still being written or was overwritten
+    // while it was copied.
+    if (__atomic_load_n(&src->seq, __ATOMIC_ACQUIRE) != index + 1)
+      continue;
+    memcpy(slot, src, ring_slot_size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&src->seq, __ATOMIC_RELAXED) != index + 1)
+      continue;
+
+    uint8_t h4_type;
+    uint32_t flags;
+    switch (slot->type) {
+      case BT_EVT_TO_LM_HCI_CMD:  h4_type = 1; flags = 2; break;
+      case BT_EVT_TO_LM_HCI_ACL:  h4_type = 2; flags = 0; break;
+      case BT_EVT_TO_BTU_HCI_ACL: h4_type = 2; flags = 1; break;
+      case BT_EVT_TO_LM_HCI_SCO:  h4_type = 3; flags = 0; break;
+      case BT_EVT_TO_BTU_HCI_SCO: h4_type = 3; flags = 1; break;
+      case BT_EVT_TO_BTU_HCI_EVT: h4_type = 4; flags = 3; break;
+      default: continue;
+    }
+
+    // The lengths include the H4 type byte.
+    const uint64_t timestamp = slot->timestamp_us + time_offset_us;
+    const uint32_t fields[] = {
+      htonl(slot->length + 1),
+      htonl(slot->included_length + 1),
+      htonl(flags),
+      0,  // cumulative drops
+      htonl(timestamp >> 32),
+      htonl(timestamp & 0xFFFFFFFF),
+    };
+    memcpy(record, fields, sizeof(fields));
+    record[sizeof(fields)] = h4_type;
+    memcpy(record + BTSNOOP_RECORD_HEADER_SIZE, slot->data, slot->included_length);
+
+    cb(record, BTSNOOP_RECORD_HEADER_SIZE + slot->included_length, context);
+    ++num_packets;
+  }
+
+  osi_free(record);
+  osi_free(slot);
+  return num_packets;
+}
+
+static size_t ring_max_len(const btsnoop_mem_ring_config_t *config) {
+  size_t len = config->command_len;
+  if (config->event_len > len)
+    len = config->event_len;
+  if (config->acl_len > len)
+    len = config->acl_len;
+  if (config->sco_len > len)
+    len = config->sco_len;
+  return len;
+}
+
+static size_t ring_snap_len(uint16_t type) {
+  switch (type) {
+    case BT_EVT_TO_LM_HCI_CMD:
+      return ring_config.command_len;
+    case BT_EVT_TO_BTU_HCI_EVT:
+      return ring_config.event_len;
+    case BT_EVT_TO_LM_HCI_ACL:
+    case BT_EVT_TO_BTU_HCI_ACL:
+      return ring_config.acl_len;
+    case BT_EVT_TO_LM_HCI_SCO:
+    case BT_EVT_TO_BTU_HCI_SCO:
+      return ring_config.sco_len;
+    default:
+      return 0;
+  }
+}
+
+// Packets are captured from more than one thread. Each writer claims its
+// own slot with an atomic increment, so capture never blocks; a slot is
+// only shared if the ring wraps around during a single write.
+static void ring_record(uint16_t type, const uint8_t *data, size_t length, size_t available) {
+  size_t included_length = ring_snap_len(type);
+  if (included_length > length)
+    included_length = length;
+  if (included_length > available)
+    included_length = available;
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  const uint64_t index = __atomic_fetch_add(&ring_head, 1, __ATOMIC_ACQ_REL);
+  ring_slot_t *slot =
+      (ring_slot_t *)(ring_slots + (index % ring_config.num_packets) * ring_slot_size);
+
+  __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  slot->timestamp_us = (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+  slot->type = type;
+  slot->length = length;
+  slot->included_length = included_length;
+  memcpy(slot->data, data, included_length);
+
+  __atomic_store_n(&slot->seq, index + 1, __ATOMIC_RELEASE);
+}
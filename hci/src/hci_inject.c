@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #include "bt_types.h"
 #include "buffer_allocator.h"
@@ -41,10 +42,33 @@ typedef enum {
   HCI_PACKET_EVENT    = 4,
 } hci_packet_t;
 
+// Frames with this bit set in the type are delivered upward, as if the
+// controller had sent them, instead of being sent to the controller. Each
+// one is acknowledged with an HCI_INJECT_ACK frame so that a replay client
+// can measure how quickly the stack takes them in.
+static const uint8_t HCI_INJECT_INBOUND = 0x80;
+
+// Reply frame: 4 byte sequence number of the inbound frame on this
+// connection, then 4 bytes of microseconds from the frame being read off
+// the socket to the HCI layer having dispatched it. Little endian.
+static const uint8_t HCI_INJECT_ACK = 0xFF;
+#define HCI_INJECT_ACK_SIZE (3 + 8)
+
+// Inbound frames handed to the HCI layer at once.
+#define INBOUND_BATCH_MAX 64
+
+// Acknowledgements kept for a client that is not reading them fast enough.
+// Past that, whole acknowledgements are dropped so the stream stays framed.
+#define PENDING_ACKS_MAX 4096
+
 typedef struct {
   socket_t *socket;
   uint8_t buffer[65536 + 3];  // 2 bytes length prefix, 1 byte type prefix.
   size_t buffer_size;
+  uint32_t inbound_count;     // Inbound frames received, for acknowledgements.
+  uint8_t acks[PENDING_ACKS_MAX * HCI_INJECT_ACK_SIZE];
+  size_t acks_size;           // Acknowledgement bytes not yet written.
+  bool write_registered;      // Whether we wait for the socket to be writable.
 } client_t;
 
 static const port_t LISTEN_PORT = 8873;
@@ -57,8 +81,12 @@ static thread_t *thread;
 static list_t *clients;
 
 static int hci_packet_to_event(hci_packet_t packet);
+static int hci_packet_to_inbound_event(hci_packet_t packet);
+static void inject_inbound(client_t *client, list_t *packets, const uint64_t *received_us);
+static void flush_acks(client_t *client);
 static void accept_ready(socket_t *socket, void *context);
 static void read_ready(socket_t *socket, void *context);
+static void write_ready(socket_t *socket, void *context);
 static void client_free(void *ptr);
 
 bool hci_inject_open(const hci_t *hci_interface) {
@@ -124,6 +152,26 @@ static int hci_packet_to_event(hci_packet_t packet) {
   }
 }
 
+static int hci_packet_to_inbound_event(hci_packet_t packet) {
+  switch (packet) {
+    case HCI_PACKET_ACL_DATA:
+      return MSG_HC_TO_STACK_HCI_ACL;
+    case HCI_PACKET_SCO_DATA:
+      return MSG_HC_TO_STACK_HCI_SCO;
+    case HCI_PACKET_EVENT:
+      return MSG_HC_TO_STACK_HCI_EVT;
+    default:
+      LOG_ERROR(LOG_TAG, "%s unsupported inbound packet type: %d", __func__, packet);
+      return -1;
+  }
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
 static void accept_ready(socket_t *socket, UNUSED_ATTR void *context) {
   assert(socket != NULL);
   assert(socket == listen_socket);
@@ -158,9 +206,13 @@ static void read_ready(UNUSED_ATTR socket_t *socket, void *context) {
   }
   client->buffer_size += ret;
 
+  list_t *inbound = NULL;
+  uint64_t received_us[INBOUND_BATCH_MAX];
+
   while (client->buffer_size > 3) {
     uint8_t *buffer = client->buffer;
-    hci_packet_t packet_type = (hci_packet_t)buffer[0];
+    hci_packet_t packet_type = (hci_packet_t)(buffer[0] & ~HCI_INJECT_INBOUND);
+    bool is_inbound = (buffer[0] & HCI_INJECT_INBOUND) != 0;
     size_t packet_len = (buffer[2] << 8) | buffer[1];
     size_t frame_len = 3 + packet_len;
 
@@ -171,14 +223,28 @@ static void read_ready(UNUSED_ATTR socket_t *socket, void *context) {
     // TODO(sharvil): once we have an HCI parser, we can eliminate
     //   the 2-byte size field since it will be contained in the packet.
 
-    BT_HDR *buf = (BT_HDR *)buffer_allocator->alloc(BT_HDR_SIZE + packet_len);
+    int event = is_inbound ? hci_packet_to_inbound_event(packet_type) :
+        hci_packet_to_event(packet_type);
+    BT_HDR *buf = (event != -1) ?
+        (BT_HDR *)buffer_allocator->alloc(BT_HDR_SIZE + packet_len) : NULL;
     if (buf) {
-      buf->event = hci_packet_to_event(packet_type);
+      buf->event = event;
       buf->offset = 0;
       buf->layer_specific = 0;
       buf->len = packet_len;
       memcpy(buf->data, buffer + 3, packet_len);
-      hci->transmit_downward(buf->event, buf);
+      if (!is_inbound) {
+        hci->transmit_downward(buf->event, buf);
+      } else {
+        if (!inbound)
+          inbound = list_new(NULL);
+        received_us[list_length(inbound)] = now_us();
+        list_append(inbound, buf);
+        if (list_length(inbound) == INBOUND_BATCH_MAX) {
+          inject_inbound(client, inbound, received_us);
+          list_clear(inbound);
+        }
+      }
     } else {
       LOG_ERROR(LOG_TAG, "%s dropping injected packet of length %zu", __func__, packet_len);
     }
@@ -187,6 +253,74 @@ static void read_ready(UNUSED_ATTR socket_t *socket, void *context) {
     memmove(buffer, buffer + frame_len, remainder);
     client->buffer_size -= frame_len;
   }
+
+  if (inbound) {
+    inject_inbound(client, inbound, received_us);
+    list_free(inbound);
+  }
+  flush_acks(client);
+}
+
+static void write_ready(UNUSED_ATTR socket_t *socket, void *context) {
+  assert(context != NULL);
+
+  flush_acks((client_t *)context);
+}
+
+// Hands |packets| to the HCI layer in one go and queues an acknowledgement
+// for each of them, timed from when the frame was read, |received_us|, to
+// when the HCI layer handed it on.
+static void inject_inbound(client_t *client, list_t *packets, const uint64_t *received_us) {
+  const size_t count = list_length(packets);
+  uint64_t dispatched_us[INBOUND_BATCH_MAX];
+
+  assert(count <= INBOUND_BATCH_MAX);
+  hci->inject_upward(packets, dispatched_us);
+
+  size_t dropped = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const uint32_t seq = client->inbound_count++;
+    if (client->acks_size + HCI_INJECT_ACK_SIZE > sizeof(client->acks)) {
+      ++dropped;
+      continue;
+    }
+
+    uint64_t latency_us = dispatched_us[i] - received_us[i];
+    if (latency_us > UINT32_MAX)
+      latency_us = UINT32_MAX;
+
+    uint8_t *p = client->acks + client->acks_size;
+    *p++ = HCI_INJECT_ACK;
+    *p++ = 8;
+    *p++ = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+      *p++ = seq >> shift;
+    for (int shift = 0; shift < 32; shift += 8)
+      *p++ = latency_us >> shift;
+    client->acks_size += HCI_INJECT_ACK_SIZE;
+  }
+
+  if (dropped)
+    LOG_WARN(LOG_TAG, "%s client not reading, dropped %zu acknowledgements", __func__, dropped);
+}
+
+// Writes what the socket takes of the pending acknowledgements and waits for
+// it to become writable again if some are left.
+static void flush_acks(client_t *client) {
+  if (client->acks_size) {
+    ssize_t ret = socket_write(client->socket, client->acks, client->acks_size);
+    if (ret > 0) {
+      client->acks_size -= ret;
+      memmove(client->acks, client->acks + ret, client->acks_size);
+    }
+  }
+
+  const bool wait_writable = client->acks_size != 0;
+  if (wait_writable != client->write_registered) {
+    client->write_registered = wait_writable;
+    socket_register(client->socket, thread_get_reactor(thread), client, read_ready,
+        wait_writable ? write_ready : NULL);
+  }
 }
 
 static void client_free(void *ptr) {
@@ -25,6 +25,7 @@
 #include <signal.h>
 #include <string.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "btcore/include/module.h"
@@ -101,6 +102,12 @@ typedef struct {
   BT_HDR *command;
 } waiting_command_t;
 
+typedef struct {
+  list_t *packets;
+  uint64_t *dispatched_us;
+  future_t *done;
+} inject_upward_t;
+
 typedef enum {
     BT_SOC_DEFAULT = 0,
     BT_SOC_SMD = BT_SOC_DEFAULT,
@@ -179,6 +186,7 @@ static void command_timed_out(void *context);
 
 static void hal_says_data_ready(serial_data_type_t type);
 static bool filter_incoming_event(BT_HDR *packet);
+static void dispatch_incoming(serial_data_type_t type, BT_HDR *packet);
 
 static serial_data_type_t event_to_data_type(uint16_t event);
 static waiting_command_t *get_waiting_command(command_opcode_t opcode);
@@ -728,32 +736,7 @@ static void hal_says_data_ready(serial_data_type_t type) {
 
     if (incoming->state == FINISHED) {
       incoming->buffer->len = incoming->index;
-      btsnoop->capture(incoming->buffer, true);
-
-      if (type != DATA_TYPE_EVENT) {
-        if(hci_state == HCI_READY) {
-          packet_fragmenter->reassemble_and_dispatch(incoming->buffer);
-        } else {
-          LOG_WARN("%s, Ignoring the ACL pkt received", __func__);
-          buffer_allocator->free(incoming->buffer);
-        }
-      } else if (!filter_incoming_event(incoming->buffer)) {
-        if (hci_state == HCI_READY) {
-          // Dispatch the event by event code
-          uint8_t *stream = incoming->buffer->data;
-          uint8_t event_code;
-          STREAM_TO_UINT8(event_code, stream);
-
-          data_dispatcher_dispatch(
-            interface.event_dispatcher,
-            event_code,
-            incoming->buffer
-          );
-        } else {
-          LOG_WARN("%s, Ignoring the event pkt received", __func__);
-          buffer_allocator->free(incoming->buffer);
-        }
-      }
+      dispatch_incoming(type, incoming->buffer);
 
       // We don't control the buffer anymore
       incoming->buffer = NULL;
@@ -768,6 +751,90 @@ static void hal_says_data_ready(serial_data_type_t type) {
   }
 }
 
+// Captures a complete incoming packet and hands it to the higher layers.
+// Takes ownership of |packet|. Must be called on the HCI thread.
+static void dispatch_incoming(serial_data_type_t type, BT_HDR *packet) {
+  btsnoop->capture(packet, true);
+
+  if (type != DATA_TYPE_EVENT) {
+    if(hci_state == HCI_READY) {
+      packet_fragmenter->reassemble_and_dispatch(packet);
+    } else {
+      LOG_WARN("%s, Ignoring the ACL pkt received", __func__);
+      buffer_allocator->free(packet);
+    }
+  } else if (!filter_incoming_event(packet)) {
+    if (hci_state == HCI_READY) {
+      // Dispatch the event by event code
+      uint8_t *stream = packet->data;
+      uint8_t event_code;
+      STREAM_TO_UINT8(event_code, stream);
+
+      data_dispatcher_dispatch(
+        interface.event_dispatcher,
+        event_code,
+        packet
+      );
+    } else {
+      LOG_WARN("%s, Ignoring the event pkt received", __func__);
+      buffer_allocator->free(packet);
+    }
+  }
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void event_inject_upward(void *context) {
+  inject_upward_t *inject = (inject_upward_t *)context;
+  size_t i = 0;
+
+  for (const list_node_t *node = list_begin(inject->packets);
+      node != list_end(inject->packets);
+      node = list_next(node)) {
+    BT_HDR *packet = list_node(node);
+    switch (packet->event & MSG_EVT_MASK) {
+      case MSG_HC_TO_STACK_HCI_EVT:
+        dispatch_incoming(DATA_TYPE_EVENT, packet);
+        break;
+      case MSG_HC_TO_STACK_HCI_ACL:
+        dispatch_incoming(DATA_TYPE_ACL, packet);
+        break;
+      case MSG_HC_TO_STACK_HCI_SCO:
+        dispatch_incoming(DATA_TYPE_SCO, packet);
+        break;
+      default:
+        LOG_ERROR(LOG_TAG, "%s invalid event type 0x%x", __func__, packet->event);
+        buffer_allocator->free(packet);
+        break;
+    }
+    if (inject->dispatched_us)
+      inject->dispatched_us[i++] = now_us();
+  }
+
+  future_ready(inject->done, FUTURE_SUCCESS);
+}
+
+// Runs |packets| through the receive path on the HCI thread, as if they
+// had been read from the controller, and waits until they have been handed
+// to the higher layers. Takes ownership of the packets but not of the list.
+static void inject_upward(list_t *packets, uint64_t *dispatched_us) {
+  assert(packets != NULL);
+
+  if (list_is_empty(packets))
+    return;
+
+  inject_upward_t inject;
+  inject.packets = packets;
+  inject.dispatched_us = dispatched_us;
+  inject.done = future_new();
+  thread_post(thread, event_inject_upward, &inject);
+  future_await(inject.done);
+}
+
 // Returns true if the event was intercepted and should not proceed to
 // higher layers. Also inspects an incoming event for interesting
 // information, like how many commands are now able to be sent.
@@ -954,6 +1021,7 @@ static void init_layer_interface() {
     interface.transmit_command = transmit_command;
     interface.transmit_command_futured = transmit_command_futured;
     interface.transmit_downward = transmit_downward;
+    interface.inject_upward = inject_upward;
     interface.ssr_cleanup = ssr_cleanup;
     interface_created = true;
   }
@@ -971,6 +1039,7 @@ void hci_layer_cleanup_interface() {
     interface.transmit_command = NULL;
     interface.transmit_command_futured = NULL;
     interface.transmit_downward = NULL;
+    interface.inject_upward = NULL;
     interface_created = false;
   }
 }
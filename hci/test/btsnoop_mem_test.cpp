@@ -0,0 +1,242 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hci/include/btsnoop_mem.h"
+#include "osi/include/allocator.h"
+}
+
+static const size_t FILE_HEADER_SIZE = 16;
+static const size_t RECORD_HEADER_SIZE = 24;
+
+namespace {
+
+struct Record {
+  uint32_t length;
+  uint32_t included_length;
+  uint32_t flags;
+  uint64_t timestamp;
+  std::vector<uint8_t> data;  // H4 type followed by the included bytes
+};
+
+void append_cb(const uint8_t *data, size_t len, void *context) {
+  std::vector<uint8_t> *out = static_cast<std::vector<uint8_t> *>(context);
+  out->insert(out->end(), data, data + len);
+}
+
+uint32_t read_be32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return ntohl(value);
+}
+
+// Parses a btsnoop file. Fails the test if it is malformed.
+std::vector<Record> parse(const std::vector<uint8_t> &file) {
+  std::vector<Record> records;
+  EXPECT_LE(FILE_HEADER_SIZE, file.size());
+  if (file.size() < FILE_HEADER_SIZE)
+    return records;
+
+  EXPECT_EQ(0, memcmp(file.data(), "btsnoop\0", 8));
+  EXPECT_EQ(1u, read_be32(&file[8]));
+  EXPECT_EQ(1002u, read_be32(&file[12]));
+
+  size_t offset = FILE_HEADER_SIZE;
+  while (offset + RECORD_HEADER_SIZE <= file.size()) {
+    const uint8_t *p = &file[offset];
+    Record record;
+    record.length = read_be32(p);
+    record.included_length = read_be32(p + 4);
+    record.flags = read_be32(p + 8);
+    EXPECT_EQ(0u, read_be32(p + 12));
+    record.timestamp = ((uint64_t)read_be32(p + 16) << 32) | read_be32(p + 20);
+    offset += RECORD_HEADER_SIZE;
+
+    EXPECT_LE(offset + record.included_length, file.size());
+    if (offset + record.included_length > file.size())
+      break;
+    record.data.assign(&file[offset], &file[offset] + record.included_length);
+    offset += record.included_length;
+    records.push_back(record);
+  }
+  EXPECT_EQ(file.size(), offset);
+  return records;
+}
+
+std::vector<Record> dump(size_t *num_packets) {
+  std::vector<uint8_t> file;
+  *num_packets = btsnoop_mem_ring_dump(append_cb, &file);
+  return parse(file);
+}
+
+}  // namespace
+
+class BtsnoopMemTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    btsnoop_mem_ring_config_t config;
+    config.num_packets = 4;
+    config.command_len = 258;
+    config.event_len = 257;
+    config.acl_len = 8;
+    config.sco_len = 3;
+    btsnoop_mem_ring_init(&config);
+  }
+
+  virtual void TearDown() {
+    for (BT_HDR *packet : packets_)
+      osi_free(packet);
+    btsnoop_mem_ring_cleanup();
+    AllocationTestHarness::TearDown();
+  }
+
+  // Captures an HCI packet of |type| made of |header| and |payload_len|
+  // bytes of |fill|.
+  void Capture(uint16_t type, std::vector<uint8_t> header, size_t payload_len,
+               uint8_t fill) {
+    BT_HDR *packet = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + header.size() + payload_len);
+    packet->event = type;
+    packet->offset = 0;
+    packet->len = header.size() + payload_len;
+    memcpy(packet->data, header.data(), header.size());
+    memset(packet->data + header.size(), fill, payload_len);
+    btsnoop_mem_capture(packet);
+    packets_.push_back(packet);
+  }
+
+  void CaptureEvent(uint8_t code, uint8_t payload_len) {
+    Capture(BT_EVT_TO_BTU_HCI_EVT, {code, payload_len}, payload_len, code);
+  }
+
+  void CaptureAcl(uint16_t type, uint16_t payload_len) {
+    Capture(type, {0x01, 0x20, (uint8_t)payload_len, (uint8_t)(payload_len >> 8)},
+            payload_len, 0xAC);
+  }
+
+  std::vector<BT_HDR *> packets_;
+};
+
+TEST_F(BtsnoopMemTest, test_empty_ring) {
+  size_t num_packets;
+  std::vector<Record> records = dump(&num_packets);
+  EXPECT_EQ(0u, num_packets);
+  EXPECT_TRUE(records.empty());
+}
+
+TEST_F(BtsnoopMemTest, test_no_ring) {
+  btsnoop_mem_ring_cleanup();
+  CaptureEvent(0x0E, 4);
+
+  size_t num_packets;
+  std::vector<Record> records = dump(&num_packets);
+  EXPECT_EQ(0u, num_packets);
+  EXPECT_TRUE(records.empty());
+}
+
+TEST_F(BtsnoopMemTest, test_wraparound) {
+  for (uint8_t code = 1; code <= 10; ++code)
+    CaptureEvent(code, 4);
+
+  // Only the four most recent packets are kept, oldest first.
+  size_t num_packets;
+  std::vector<Record> records = dump(&num_packets);
+  ASSERT_EQ(4u, num_packets);
+  ASSERT_EQ(4u, records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(4, records[i].data[0]);  // H4 event
+    EXPECT_EQ(7 + i, records[i].data[1]);
+    if (i > 0) {
+      EXPECT_LE(records[i - 1].timestamp, records[i].timestamp);
+    }
+  }
+}
+
+TEST_F(BtsnoopMemTest, test_truncation) {
+  CaptureAcl(BT_EVT_TO_LM_HCI_ACL, 100);
+  CaptureAcl(BT_EVT_TO_BTU_HCI_ACL, 2);
+  CaptureEvent(0x3E, 255);
+  Capture(BT_EVT_TO_LM_HCI_CMD, {0x03, 0x0C, 0x00}, 0, 0);
+
+  size_t num_packets;
+  std::vector<Record> records = dump(&num_packets);
+  ASSERT_EQ(4u, records.size());
+
+  // ACL packets keep their headers only; lengths include the H4 type.
+  EXPECT_EQ(1u + 4 + 100, records[0].length);
+  EXPECT_EQ(1u + 8, records[0].included_length);
+  EXPECT_EQ(0u, records[0].flags);  // sent data
+  EXPECT_EQ(2, records[0].data[0]);
+  EXPECT_EQ(0x01, records[0].data[1]);
+  EXPECT_EQ(100, records[0].data[3]);
+
+  // Packets shorter than the limit are kept whole.
+  EXPECT_EQ(1u + 4 + 2, records[1].length);
+  EXPECT_EQ(1u + 4 + 2, records[1].included_length);
+  EXPECT_EQ(1u, records[1].flags);  // received data
+
+  // Events and commands are kept whole.
+  EXPECT_EQ(1u + 2 + 255, records[2].length);
+  EXPECT_EQ(1u + 2 + 255, records[2].included_length);
+  EXPECT_EQ(3u, records[2].flags);
+  EXPECT_EQ(0x3E, records[2].data.back());
+
+  EXPECT_EQ(1u + 3, records[3].length);
+  EXPECT_EQ(1u + 3, records[3].included_length);
+  EXPECT_EQ(2u, records[3].flags);
+  EXPECT_EQ(1, records[3].data[0]);
+}
+
+// Measures what the ring adds to every captured packet.
+TEST_F(BtsnoopMemTest, test_capture_cost) {
+  static const size_t PACKETS = 200000;
+
+  BT_HDR *packet = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + 4 + 1021);
+  packet->event = BT_EVT_TO_BTU_HCI_ACL;
+  packet->offset = 0;
+  packet->len = 4 + 1021;
+  packet->data[0] = 0x01;
+  packet->data[1] = 0x20;
+  packet->data[2] = 1021 & 0xFF;
+  packet->data[3] = 1021 >> 8;
+  packets_.push_back(packet);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < PACKETS; ++i)
+    btsnoop_mem_capture(packet);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  size_t num_packets;
+  dump(&num_packets);
+  EXPECT_EQ(4u, num_packets);
+
+  printf("snoop ring capture: %lld ns per ACL packet\n",
+         (long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                         .count() / PACKETS));
+}
@@ -105,6 +105,21 @@
 #define BTA_DISABLE_DELAY 200 /* in milliseconds */
 #endif
 
+/* Number of pre-allocated BTA system messages in each size class (up to
+** 64, 256 and 768 bytes). Larger messages, or any allocated while a class
+** is exhausted, come from the heap */
+#ifndef BTA_SYS_MSG_POOL_SMALL_NUM
+#define BTA_SYS_MSG_POOL_SMALL_NUM 32
+#endif
+
+#ifndef BTA_SYS_MSG_POOL_MEDIUM_NUM
+#define BTA_SYS_MSG_POOL_MEDIUM_NUM 32
+#endif
+
+#ifndef BTA_SYS_MSG_POOL_LARGE_NUM
+#define BTA_SYS_MSG_POOL_LARGE_NUM 16
+#endif
+
 #ifndef SBC_FOR_EMBEDDED_LINUX
 #define SBC_FOR_EMBEDDED_LINUX TRUE
 #endif
@@ -607,6 +622,18 @@
 #define L2CAP_LINK_STARTUP_TOUT     60
 #endif
 
+/* Bytes an LE credit based channel lets the peer send ahead of being read.
+ * Sets the initial credits of channels that leave them to L2CAP. */
+#ifndef L2CAP_LE_COC_RX_BUDGET
+#define L2CAP_LE_COC_RX_BUDGET      (8 * 1024)
+#endif
+
+/* Ask for the largest LE data length as soon as a link is up, when both sides
+ * support data length extension. */
+#ifndef L2CAP_LE_AUTO_DATA_LENGTH
+#define L2CAP_LE_AUTO_DATA_LENGTH   TRUE
+#endif
+
 /* The L2CAP MTU; must be in accord with the HCI ACL buffer size. */
 #ifndef L2CAP_MTU_SIZE
 #define L2CAP_MTU_SIZE              1691
@@ -823,6 +850,12 @@
 #define GATT_MAX_PHY_CHANNEL        7
 #endif
 
+/* ATT MTU the stack requests by itself once an LE link is connected, unless an
+ * app sets its own preference. 23 (the default MTU) or less disables it. */
+#ifndef GATT_PREFERRED_MTU
+#define GATT_PREFERRED_MTU          517
+#endif
+
 /* Used for conformance testing ONLY */
 #ifndef GATT_CONFORMANCE_TESTING
 #define GATT_CONFORMANCE_TESTING           FALSE
@@ -1669,6 +1702,30 @@ The maximum number of payload octets that the local device can receive in a sing
 #define BTSNOOP_MEM TRUE
 #endif
 
+/* Number of most recent HCI packets kept by the in-memory snoop ring in
+** the HCI layer, or 0 to disable it */
+#ifndef BTSNOOP_MEM_RING_PACKETS
+#define BTSNOOP_MEM_RING_PACKETS 512
+#endif
+
+/* Bytes kept of each HCI packet in the snoop ring. Commands and events are
+** kept whole; ACL and SCO packets only up to their headers by default */
+#ifndef BTSNOOP_MEM_RING_CMD_LEN
+#define BTSNOOP_MEM_RING_CMD_LEN 258    /* HCI command header + 255 bytes */
+#endif
+
+#ifndef BTSNOOP_MEM_RING_EVT_LEN
+#define BTSNOOP_MEM_RING_EVT_LEN 257    /* HCI event header + 255 bytes */
+#endif
+
+#ifndef BTSNOOP_MEM_RING_ACL_LEN
+#define BTSNOOP_MEM_RING_ACL_LEN 8      /* HCI ACL header + L2CAP header */
+#endif
+
+#ifndef BTSNOOP_MEM_RING_SCO_LEN
+#define BTSNOOP_MEM_RING_SCO_LEN 3      /* HCI SCO header */
+#endif
+
 #include "bt_trace.h"
 
 #endif /* BT_TARGET_H */
@@ -110,6 +110,7 @@ void bte_main_boot_entry(void)
       LOG_ERROR(LOG_TAG, "%s unable to allocate hci message queue.", __func__);
       return;
     }
+    fixed_queue_profile(btu_hci_msg_queue, "btu_hci_msg_queue");
 
     data_dispatcher_register_default(hci->event_dispatcher, btu_hci_msg_queue);
     hci->set_data_queue(btu_hci_msg_queue);
@@ -38,10 +38,12 @@ btosiCommonSrc := \
     ./src/hash_functions.c \
     ./src/hash_map.c \
     ./src/hash_map_utils.c \
+    ./src/ilist.c \
     ./src/list.c \
     ./src/metrics.cpp \
     ./src/mutex.c \
     ./src/osi.c \
+    ./src/profiler.c \
     ./src/properties.c \
     ./src/reactor.c \
     ./src/ringbuffer.c \
@@ -67,7 +69,10 @@ btosiCommonTestSrc := \
     ./test/future_test.cpp \
     ./test/hash_map_test.cpp \
     ./test/hash_map_utils_test.cpp \
+    ./test/ilist_test.cpp \
     ./test/list_test.cpp \
+    ./test/mutex_test.cpp \
+    ./test/profiler_test.cpp \
     ./test/properties_test.cpp \
     ./test/rand_test.cpp \
     ./test/reactor_test.cpp \
@@ -35,6 +35,9 @@ typedef void (*eager_reader_cb)(eager_reader_t *reader, void *context);
 // internal read thread named |thread_name|. The returned object must be freed using
 // |eager_reader_free|. |fd_to_read| must be valid, |buffer_size| and |max_buffer_count|
 // must be greater than zero. |allocator| and |thread_name| may not be NULL.
+// Reads append to the newest buffer until it is full, and consumed buffers
+// are reused, so a steady stream needs no allocations. At most
+// |max_buffer_count| buffers are in use; SIZE_MAX means no limit.
 eager_reader_t *eager_reader_new(
   int fd_to_read,
   const allocator_t *allocator,
@@ -52,6 +52,11 @@ size_t fixed_queue_length(fixed_queue_t *queue);
 // not be NULL.
 size_t fixed_queue_capacity(fixed_queue_t *queue);
 
+// Records the enqueue to dequeue latency of elements of |queue| under |name|
+// in the dispatch profile while profiling is enabled (see profiler.h). May
+// be called at most once per queue. |queue| and |name| may not be NULL.
+void fixed_queue_profile(fixed_queue_t *queue, const char *name);
+
 // Enqueues the given |data| into the |queue|. The caller will be blocked
 // if no more space is available in the queue. Neither |queue| nor |data|
 // may be NULL.
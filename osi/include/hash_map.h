@@ -44,8 +44,10 @@ typedef void (*data_free_fn)(void *data);
 
 // Returns a new, empty hash_map. Returns NULL if not enough memory could be allocated
 // for the hash_map structure. The returned hash_map must be freed with |hash_map_free|.
-// The |num_bucket| specifies the number of hashable buckets for the map and must not
-// be zero.  The |hash_fn| specifies a hash function to be used and must not be NULL.
+// The |num_bucket| specifies the initial number of buckets for the map and must not
+// be zero. The map grows as needed, so it only needs to be a hint of the expected
+// number of elements. The |hash_fn| specifies a hash function to be used and must
+// not be NULL.
 // The |key_fn| and |data_fn| are called whenever a hash_map element is removed from
 // the hash_map. They can be used to release resources held by the hash_map element,
 // e.g.  memory or file descriptor.  |key_fn| and |data_fn| may be NULL if no cleanup
@@ -71,10 +73,15 @@ bool hash_map_is_empty(const hash_map_t *hash_map);
 // NULL |hash_map|.
 size_t hash_map_size(const hash_map_t *hash_map);
 
-// Returns the number of buckets in the hash map.  This function does not accept a
-// NULL |hash_map|.
+// Returns the current number of buckets in the hash map, which grows with the
+// number of elements.  This function does not accept a NULL |hash_map|.
 size_t hash_map_num_buckets(const hash_map_t *hash_map);
 
+// Returns the longest distance of an element from its home slot, counted as
+// the number of slots a lookup of it examines in the table holding it, 0 if
+// the hash map is empty.  This function does not accept a NULL |hash_map|.
+size_t hash_map_longest_probe(const hash_map_t *hash_map);
+
 // Returns true if the hash_map has a valid entry for the presented key.
 // This function does not accept a NULL |hash_map|.
 bool hash_map_has_key(const hash_map_t *hash_map, const void *key);
@@ -103,6 +110,7 @@ void hash_map_clear(hash_map_t *hash_map);
 // Iterates through the entire |hash_map| and calls |callback| for each data
 // element and passes through the |context| argument. If the hash_map is
 // empty, |callback| will never be called. It is not safe to mutate the
-// hash_map inside the callback. Neither |hash_map| nor |callback| may be NULL.
+// hash_map inside the callback, and the entry passed to |callback| is only valid
+// during the call. Neither |hash_map| nor |callback| may be NULL.
 // If |callback| returns false, the iteration loop will immediately exit.
 void hash_map_foreach(hash_map_t *hash_map, hash_map_iter_cb callback, void *context);
@@ -0,0 +1,117 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "osi/include/list.h"
+
+// An intrusive doubly-linked list: the links live in an |ilist_node_t|
+// embedded in each element, so adding an element never allocates and
+// removing one takes constant time. An element can be in one list per
+// embedded node at a time. The list never owns its elements.
+
+typedef struct ilist_node_t {
+  struct ilist_node_t *next;    // NULL while the element is not in a list.
+  struct ilist_node_t *prev;
+} ilist_node_t;
+
+typedef struct {
+  ilist_node_t head;
+  size_t offset;                // Of the ilist_node_t within each element.
+  size_t length;
+} ilist_t;
+
+// Initializes |list| as an empty list of elements of type |type|, linked
+// through their |member| field of type ilist_node_t.
+#define ILIST_INIT(list, type, member) ilist_init((list), offsetof(type, member))
+
+// Iterates |var|, a |type| pointer, over the elements of |list| front to
+// back. |var| may not be removed from the list inside the loop.
+#define ILIST_FOREACH(list, type, var) \
+  for (type *var = (type *)ilist_front(list); var != NULL; \
+       var = (type *)ilist_next((list), var))
+
+// Same as |ILIST_FOREACH|, except that |var| may be removed from the list,
+// and even freed, inside the loop. |next| holds the following element.
+#define ILIST_FOREACH_SAFE(list, type, var, next) \
+  for (type *var = (type *)ilist_front(list), \
+            *next = var ? (type *)ilist_next((list), var) : NULL; \
+       var != NULL; \
+       var = next, next = var ? (type *)ilist_next((list), var) : NULL)
+
+// Initializes |list| as an empty list whose elements embed their
+// ilist_node_t |node_offset| bytes from their start. Prefer |ILIST_INIT|.
+// |list| may not be NULL. A list needs no cleanup other than removing the
+// elements that have to be reused, see |ilist_clear|.
+void ilist_init(ilist_t *list, size_t node_offset);
+
+// Returns true if |list| has no elements. |list| may not be NULL.
+bool ilist_is_empty(const ilist_t *list);
+
+// Returns the number of elements in |list|. |list| may not be NULL.
+size_t ilist_length(const ilist_t *list);
+
+// Returns true if |element| is in a list through the node |list| uses.
+// Neither |list| nor |element| may be NULL.
+bool ilist_is_linked(const ilist_t *list, const void *element);
+
+// Returns the first element of |list|, or NULL if it is empty. |list| may
+// not be NULL.
+void *ilist_front(const ilist_t *list);
+
+// Returns the last element of |list|, or NULL if it is empty. |list| may not
+// be NULL.
+void *ilist_back(const ilist_t *list);
+
+// Returns the element after |element| in |list|, or NULL if |element| is
+// the last one. Neither |list| nor |element| may be NULL, and |element|
+// must be in |list|.
+void *ilist_next(const ilist_t *list, const void *element);
+
+// Inserts |element| at the beginning of |list|. Neither may be NULL, and
+// |element| may not already be in a list through the same node.
+void ilist_prepend(ilist_t *list, void *element);
+
+// Inserts |element| at the end of |list|. Neither may be NULL, and
+// |element| may not already be in a list through the same node.
+void ilist_append(ilist_t *list, void *element);
+
+// Inserts |element| right after |prev|, which must be in |list|. None of
+// the arguments may be NULL, and |element| may not already be in a list
+// through the same node.
+void ilist_insert_after(ilist_t *list, void *prev, void *element);
+
+// Removes |element| from |list| in constant time. Neither may be NULL.
+// Returns false if |element| was not in a list, true otherwise, in which
+// case it must have been in |list|. |element| is not freed.
+bool ilist_remove(ilist_t *list, void *element);
+
+// Removes every element from |list|, calling |free_cb| on each of them
+// afterwards if it is not NULL. |list| may not be NULL.
+void ilist_clear(ilist_t *list, list_free_cb free_cb);
+
+// Calls |callback| with each element of |list| and |context| until
+// |callback| returns false. Returns the element for which |callback|
+// returned false, or NULL if it never did. |callback| may remove the
+// element it is passed from the list. Neither |list| nor |callback| may be
+// NULL.
+void *ilist_foreach(const ilist_t *list, list_iter_cb callback, void *context);
@@ -88,6 +88,25 @@ void metrics_a2dp_session(int64_t session_duration_sec,
                           float buffer_underruns_average,
                           int32_t buffer_underruns_count);
 
+// Record the CPU time |cpu_ms| (in milliseconds) used so far by the stack
+// thread named |thread|.
+void metrics_thread_profile(const char *thread, int64_t cpu_ms);
+
+// Record the enqueue to dispatch latency of the queue named |queue|.
+// |count| is the number of dispatched elements. |avg_us|, |p50_us|,
+// |p99_us| and |max_us| are the average, median, 99th percentile and
+// maximum latency (in microseconds).
+void metrics_queue_profile(const char *queue, uint64_t count, uint64_t avg_us,
+                           uint64_t p50_us, uint64_t p99_us, uint64_t max_us);
+
+// Record the run time of the handler for event |event| in the event table
+// named |table|. |count| is the number of dispatches. |avg_us| and |max_us|
+// are the average and maximum wall time, |cpu_avg_us| the average CPU time
+// (all in microseconds).
+void metrics_event_profile(const char *table, uint32_t event, uint64_t count,
+                           uint64_t avg_us, uint64_t max_us,
+                           uint64_t cpu_avg_us);
+
 // Writes the metrics, in packed protobuf format, into the descriptor |fd|.
 // If |clear| is true, metrics events are cleared afterwards.
 void metrics_write(int fd, bool clear);
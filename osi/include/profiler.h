@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Counters that attribute time on the stack threads to the queues and
+// events behind it: CPU time per thread, enqueue to dispatch latency per
+// queue and run time per event id. Nothing is recorded until profiling is
+// enabled with |profiler_set_enabled|. All functions are thread safe.
+
+typedef struct profiler_queue_t profiler_queue_t;
+typedef struct profiler_events_t profiler_events_t;
+
+// Tracks one event dispatch between |profiler_event_begin| and
+// |profiler_event_end|. Lives on the caller's stack.
+typedef struct {
+  profiler_events_t *events;
+  uint16_t event;
+  uint64_t start_us;
+  uint64_t start_cpu_ns;    // Non-zero if this dispatch samples CPU time.
+} profiler_scope_t;
+
+// Enables or disables recording. Counters are kept when disabled.
+void profiler_set_enabled(bool enabled);
+
+// Returns true if recording is enabled.
+bool profiler_is_enabled(void);
+
+// Returns the monotonic time in microseconds used for latencies.
+uint64_t profiler_now_us(void);
+
+// Creates a latency histogram named |name| and adds it to the dump. Returns
+// NULL on allocation failure. Must be freed with |profiler_queue_free|.
+profiler_queue_t *profiler_queue_new(const char *name);
+
+// Removes |queue| from the dump and frees it. |queue| may be NULL.
+void profiler_queue_free(profiler_queue_t *queue);
+
+// Records that an item spent |latency_us| in |queue| before its dispatch.
+// Does nothing if profiling is disabled or |queue| is NULL.
+void profiler_queue_record(profiler_queue_t *queue, uint64_t latency_us);
+
+// Creates a table of per event id run times named |name| and adds it to the
+// dump. Returns NULL on allocation failure. Must be freed with
+// |profiler_events_free|.
+profiler_events_t *profiler_events_new(const char *name);
+
+// Removes |events| from the dump and frees it. |events| may be NULL.
+void profiler_events_free(profiler_events_t *events);
+
+// Starts timing the dispatch of |event| into |scope|. Every few dispatches
+// also sample the thread's CPU time. |events| may be NULL.
+void profiler_event_begin(profiler_events_t *events, uint16_t event, profiler_scope_t *scope);
+
+// Records the run time of the dispatch started with |profiler_event_begin|.
+void profiler_event_end(profiler_scope_t *scope);
+
+// Adds the calling thread, named |name|, to the per-thread CPU time dump.
+void profiler_thread_register(const char *name);
+
+// Removes the calling thread from the per-thread CPU time dump.
+void profiler_thread_unregister(void);
+
+// Writes the counters to the file descriptor |fd| in human-readable form.
+void profiler_debug_dump(int fd);
+
+// Adds the counters to the pending metrics log.
+void profiler_update_metrics(void);
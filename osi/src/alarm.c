@@ -36,7 +36,7 @@
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
+#include "osi/include/ilist.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -86,6 +86,7 @@ struct alarm_t {
   alarm_callback_t callback;
   void *data;
   alarm_stats_t stats;
+  ilist_node_t list_node;       // Links the alarm into |alarms| while it is set
 };
 
 
@@ -104,7 +105,7 @@ static const clockid_t CLOCK_ID_ALARM = CLOCK_BOOTTIME_ALARM;
 // functions execute serially and not concurrently. As a result, this mutex
 // also protects the |alarms| list.
 static pthread_mutex_t monitor;
-static list_t *alarms;
+static ilist_t *alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -270,7 +271,7 @@ void alarm_cancel(alarm_t *alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |monitor| lock.
 static void alarm_cancel_internal(alarm_t *alarm) {
-  bool needs_reschedule = (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (ilist_front(alarms) == alarm);
 
   remove_pending_alarm(alarm);
 
@@ -313,7 +314,8 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  ilist_clear(alarms, NULL);
+  osi_free(alarms);
   alarms = NULL;
 
   pthread_mutex_unlock(&monitor);
@@ -330,11 +332,8 @@ static bool lazy_initialize(void) {
 
   pthread_mutex_init(&monitor, NULL);
 
-  alarms = list_new(NULL);
-  if (!alarms) {
-    LOG_ERROR(LOG_TAG, "%s unable to allocate alarm list.", __func__);
-    goto error;
-  }
+  alarms = osi_malloc(sizeof(ilist_t));
+  ILIST_INIT(alarms, alarm_t, list_node);
 
   if (!timer_create_internal(CLOCK_ID, &timer))
     goto error;
@@ -398,7 +397,7 @@ error:
   if (timer_initialized)
     timer_delete(timer);
 
-  list_free(alarms);
+  osi_free(alarms);
   alarms = NULL;
 
   pthread_mutex_destroy(&monitor);
@@ -422,7 +421,7 @@ static period_ms_t now(void) {
 // Remove alarm from internal alarm list and the processing queue
 // The caller must hold the |monitor| lock.
 static void remove_pending_alarm(alarm_t *alarm) {
-  list_remove(alarms, alarm);
+  ilist_remove(alarms, alarm);
   while (fixed_queue_try_remove_from_queue(alarm->queue, alarm) != NULL) {
     // Remove all repeated alarm instances from the queue.
     // NOTE: We are defensive here - we shouldn't have repeated alarm instances
@@ -433,7 +432,7 @@ static void remove_pending_alarm(alarm_t *alarm) {
 static void schedule_next_instance(alarm_t *alarm) {
   // If the alarm is currently set and it's at the start of the list,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule = (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (ilist_front(alarms) == alarm);
   if (alarm->callback)
     remove_pending_alarm(alarm);
 
@@ -445,22 +444,21 @@ static void schedule_next_instance(alarm_t *alarm) {
   alarm->deadline = just_now + (alarm->period - ms_into_period);
 
   // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t *)list_front(alarms))->deadline > alarm->deadline) {
-    list_prepend(alarms, alarm);
+  if (ilist_is_empty(alarms) ||
+      ((alarm_t *)ilist_front(alarms))->deadline > alarm->deadline) {
+    ilist_prepend(alarms, alarm);
   } else {
-    for (list_node_t *node = list_begin(alarms); node != list_end(alarms); node = list_next(node)) {
-      list_node_t *next = list_next(node);
-      if (next == list_end(alarms) || ((alarm_t *)list_node(next))->deadline > alarm->deadline) {
-        list_insert_after(alarms, node, alarm);
+    ILIST_FOREACH(alarms, alarm_t, prev) {
+      alarm_t *next = ilist_next(alarms, prev);
+      if (next == NULL || next->deadline > alarm->deadline) {
+        ilist_insert_after(alarms, prev, alarm);
         break;
       }
     }
   }
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+  if (needs_reschedule || ilist_front(alarms) == alarm) {
     reschedule_root_alarm();
   }
 }
@@ -475,10 +473,10 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms))
+  if (ilist_is_empty(alarms))
     goto done;
 
-  const alarm_t *next = list_front(alarms);
+  const alarm_t *next = ilist_front(alarms);
   const int64_t next_expiration = next->deadline - now();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
@@ -568,9 +566,7 @@ void alarm_unregister_processing_queue(fixed_queue_t *queue) {
 
   // Cancel all alarms that are using this queue
   pthread_mutex_lock(&monitor);
-  for (list_node_t *node = list_begin(alarms); node != list_end(alarms); ) {
-    alarm_t *alarm = (alarm_t *)list_node(node);
-    node = list_next(node);
+  ILIST_FOREACH_SAFE(alarms, alarm_t, alarm, next) {
     // TODO: Each module is responsible for tearing down its alarms; currently,
     // this is not the case. In the future, this check should be replaced by
     // an assert.
@@ -647,14 +643,14 @@ static void callback_dispatch(UNUSED_ATTR void *context) {
     // We're done here if there are no alarms or the alarm at the front is in
     // the future. Release the monitor lock and exit right away since there's
     // nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = list_front(alarms))->deadline > now()) {
+    if (ilist_is_empty(alarms) ||
+        (alarm = ilist_front(alarms))->deadline > now()) {
       reschedule_root_alarm();
       pthread_mutex_unlock(&monitor);
       continue;
     }
 
-    list_remove(alarms, alarm);
+    ilist_remove(alarms, alarm);
 
     if (alarm->is_periodic) {
       alarm->prev_deadline = alarm->deadline;
@@ -740,12 +736,10 @@ void alarm_debug_dump(int fd)
 
   period_ms_t just_now = now();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n\n", ilist_length(alarms));
 
   // Dump info for each alarm
-  for (list_node_t *node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t *alarm = (alarm_t *)list_node(node);
+  ILIST_FOREACH(alarms, alarm_t, alarm) {
     alarm_stats_t *stats = &alarm->stats;
 
     dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
@@ -22,22 +22,29 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #include <string.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
-#include "osi/include/fixed_queue.h"
+#include "osi/include/ilist.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/reactor.h"
+#include "osi/include/semaphore.h"
 
 #if !defined(EFD_SEMAPHORE)
 #  define EFD_SEMAPHORE (1 << 0)
 #endif
 
+// Consumed buffers are kept for reuse, up to this many.
+static const size_t MAX_FREE_BUFFERS = 4;
+
 typedef struct {
-  size_t length;
-  size_t offset;
+  ilist_node_t node;
+  size_t length;        // Written by the inbound thread with |lock| held.
+  size_t offset;        // Only touched by the consumer.
   uint8_t data[];
 } data_buffer_t;
 
@@ -47,8 +54,15 @@ struct eager_reader_t {
 
   const allocator_t *allocator;
   size_t buffer_size;
-  fixed_queue_t *buffers;
-  data_buffer_t *current_buffer;
+
+  // Guards |buffers|, |free_buffers|, |filling_buffer| and the length of
+  // every buffer in use.
+  pthread_mutex_t lock;
+  ilist_t buffers;                // Filled buffers not yet taken by the consumer.
+  ilist_t free_buffers;           // Consumed buffers, ready to be filled again.
+  data_buffer_t *filling_buffer;  // Buffer the inbound thread appends to.
+  data_buffer_t *current_buffer;  // Buffer the consumer reads from.
+  semaphore_t *buffer_sem;        // Counts the buffers left to fill, NULL if unbounded.
 
   thread_t *inbound_read_thread;
   reactor_object_t *inbound_read_object;
@@ -59,6 +73,9 @@ struct eager_reader_t {
 };
 
 static bool has_byte(const eager_reader_t *reader);
+static data_buffer_t *acquire_buffer(eager_reader_t *reader);
+static void release_buffer_locked(eager_reader_t *reader, data_buffer_t *buffer);
+static void retire_current_buffer_locked(eager_reader_t *reader);
 static void inbound_data_waiting(void *context);
 static void internal_outbound_read_ready(void *context);
 
@@ -79,6 +96,9 @@ eager_reader_t *eager_reader_new(
 
   ret->allocator = allocator;
   ret->inbound_fd = fd_to_read;
+  pthread_mutex_init(&ret->lock, NULL);
+  ILIST_INIT(&ret->buffers, data_buffer_t, node);
+  ILIST_INIT(&ret->free_buffers, data_buffer_t, node);
 
   ret->bytes_available_fd = eventfd(0, 0);
   if (ret->bytes_available_fd == INVALID_FD) {
@@ -88,10 +108,12 @@ eager_reader_t *eager_reader_new(
 
   ret->buffer_size = buffer_size;
 
-  ret->buffers = fixed_queue_new(max_buffer_count);
-  if (!ret->buffers) {
-    LOG_ERROR(LOG_TAG, "%s unable to create buffers queue.", __func__);
-    goto error;
+  if (max_buffer_count != SIZE_MAX) {
+    ret->buffer_sem = semaphore_new(max_buffer_count < UINT_MAX ? max_buffer_count : UINT_MAX);
+    if (!ret->buffer_sem) {
+      LOG_ERROR(LOG_TAG, "%s unable to create buffer count semaphore.", __func__);
+      goto error;
+    }
   }
 
   ret->inbound_read_thread = thread_new(thread_name);
@@ -128,13 +150,17 @@ void eager_reader_free(eager_reader_t *reader) {
   if (reader->bytes_available_fd != INVALID_FD)
     close(reader->bytes_available_fd);
 
-  // Free the current buffer, because it's not in the queue
+  thread_free(reader->inbound_read_thread);
+
+  // Free the current buffer, because it's not in a list
   // and won't be freed below
   if (reader->current_buffer)
     reader->allocator->free(reader->current_buffer);
 
-  fixed_queue_free(reader->buffers, reader->allocator->free);
-  thread_free(reader->inbound_read_thread);
+  ilist_clear(&reader->buffers, reader->allocator->free);
+  ilist_clear(&reader->free_buffers, reader->allocator->free);
+  semaphore_free(reader->buffer_sem);
+  pthread_mutex_destroy(&reader->lock);
   osi_free(reader);
 }
 
@@ -181,23 +207,32 @@ size_t eager_reader_read(eager_reader_t *reader, uint8_t *buffer, size_t max_siz
 
   size_t bytes_consumed = 0;
   while (bytes_consumed < max_size) {
-    if (!reader->current_buffer)
-      reader->current_buffer = fixed_queue_dequeue(reader->buffers);
+    pthread_mutex_lock(&reader->lock);
+    retire_current_buffer_locked(reader);
+
+    data_buffer_t *current = reader->current_buffer;
+    if (!current) {
+      current = ilist_front(&reader->buffers);
+      assert(current != NULL);
+      ilist_remove(&reader->buffers, current);
+      reader->current_buffer = current;
+    }
+    size_t length = current->length;
+    pthread_mutex_unlock(&reader->lock);
 
-    size_t bytes_to_copy = reader->current_buffer->length - reader->current_buffer->offset;
+    size_t bytes_to_copy = length - current->offset;
     if (bytes_to_copy > (max_size - bytes_consumed))
       bytes_to_copy = max_size - bytes_consumed;
 
-    memcpy(&buffer[bytes_consumed], &reader->current_buffer->data[reader->current_buffer->offset], bytes_to_copy);
+    memcpy(&buffer[bytes_consumed], &current->data[current->offset], bytes_to_copy);
     bytes_consumed += bytes_to_copy;
-    reader->current_buffer->offset += bytes_to_copy;
-
-    if (reader->current_buffer->offset >= reader->current_buffer->length) {
-      reader->allocator->free(reader->current_buffer);
-      reader->current_buffer = NULL;
-    }
+    current->offset += bytes_to_copy;
   }
 
+  pthread_mutex_lock(&reader->lock);
+  retire_current_buffer_locked(reader);
+  pthread_mutex_unlock(&reader->lock);
+
   bytes_available -= bytes_consumed;
   if (eventfd_write(reader->bytes_available_fd, bytes_available) == -1) {
     LOG_ERROR(LOG_TAG, "%s unable to write back bytes available for output data.", __func__);
@@ -235,25 +270,95 @@ static bool has_byte(const eager_reader_t *reader) {
   return FD_ISSET(reader->bytes_available_fd, &read_fds);
 }
 
-static void inbound_data_waiting(void *context) {
-  eager_reader_t *reader = (eager_reader_t *)context;
+// Returns an empty buffer, reusing a consumed one if there is any. Blocks
+// while |max_buffer_count| buffers are in use. Runs on the inbound thread.
+static data_buffer_t *acquire_buffer(eager_reader_t *reader) {
+  if (reader->buffer_sem)
+    semaphore_wait(reader->buffer_sem);
+
+  pthread_mutex_lock(&reader->lock);
+  data_buffer_t *buffer = ilist_front(&reader->free_buffers);
+  if (buffer)
+    ilist_remove(&reader->free_buffers, buffer);
+  pthread_mutex_unlock(&reader->lock);
 
-  data_buffer_t *buffer = (data_buffer_t *)reader->allocator->alloc(reader->buffer_size + sizeof(data_buffer_t));
   if (!buffer) {
-    LOG_ERROR(LOG_TAG, "%s couldn't aquire memory for inbound data buffer.", __func__);
-    return;
+    buffer = (data_buffer_t *)reader->allocator->alloc(reader->buffer_size + sizeof(data_buffer_t));
+    if (!buffer) {
+      if (reader->buffer_sem)
+        semaphore_post(reader->buffer_sem);
+      return NULL;
+    }
+    buffer->node.next = buffer->node.prev = NULL;
   }
 
   buffer->length = 0;
   buffer->offset = 0;
+  return buffer;
+}
+
+// Keeps |buffer| for reuse or frees it. |buffer| may not be in a list.
+// Must be called with |lock| held.
+static void release_buffer_locked(eager_reader_t *reader, data_buffer_t *buffer) {
+  if (ilist_length(&reader->free_buffers) < MAX_FREE_BUFFERS)
+    ilist_prepend(&reader->free_buffers, buffer);
+  else
+    reader->allocator->free(buffer);
+
+  if (reader->buffer_sem)
+    semaphore_post(reader->buffer_sem);
+}
+
+// Recycles the consumer's buffer once it is drained, unless the inbound
+// thread may still append to it: small reads then share one buffer.
+// Must be called with |lock| held.
+static void retire_current_buffer_locked(eager_reader_t *reader) {
+  data_buffer_t *current = reader->current_buffer;
+  if (!current || current->offset < current->length)
+    return;
+
+  if (current == reader->filling_buffer) {
+    if (current->length < reader->buffer_size)
+      return;
+    reader->filling_buffer = NULL;
+  }
+
+  reader->current_buffer = NULL;
+  release_buffer_locked(reader, current);
+}
 
+static void inbound_data_waiting(void *context) {
+  eager_reader_t *reader = (eager_reader_t *)context;
+
+  // Only this thread changes the lengths, so they can be read without the
+  // lock. The consumer only drops |filling_buffer| once it is full.
+  pthread_mutex_lock(&reader->lock);
+  data_buffer_t *buffer = reader->filling_buffer;
+  pthread_mutex_unlock(&reader->lock);
+
+  bool is_new_buffer = (buffer == NULL || buffer->length == reader->buffer_size);
+  if (is_new_buffer) {
+    buffer = acquire_buffer(reader);
+    if (!buffer) {
+      LOG_ERROR(LOG_TAG, "%s couldn't aquire memory for inbound data buffer.", __func__);
+      return;
+    }
+  }
+
+  // The consumer never reads past |length|, so the rest of the buffer can
+  // be filled while it reads the start.
   ssize_t bytes_read;
-  OSI_NO_INTR(bytes_read = read(reader->inbound_fd, buffer->data,
-                                reader->buffer_size));
+  OSI_NO_INTR(bytes_read = read(reader->inbound_fd, buffer->data + buffer->length,
+                                reader->buffer_size - buffer->length));
   if (bytes_read > 0) {
     // Save the data for later
-    buffer->length = bytes_read;
-    fixed_queue_enqueue(reader->buffers, buffer);
+    pthread_mutex_lock(&reader->lock);
+    buffer->length += bytes_read;
+    if (is_new_buffer) {
+      ilist_append(&reader->buffers, buffer);
+      reader->filling_buffer = buffer;
+    }
+    pthread_mutex_unlock(&reader->lock);
 
     // Tell consumers data is available by incrementing
     // the semaphore by the number of bytes we just read
@@ -264,7 +369,11 @@ static void inbound_data_waiting(void *context) {
     else
       LOG_WARN(LOG_TAG, "%s unable to read from file descriptor: %s", __func__, strerror(errno));
 
-    reader->allocator->free(buffer);
+    if (is_new_buffer) {
+      pthread_mutex_lock(&reader->lock);
+      release_buffer_locked(reader, buffer);
+      pthread_mutex_unlock(&reader->lock);
+    }
   }
 }
 
@@ -24,9 +24,22 @@
 #include "osi/include/fixed_queue.h"
 #include "osi/include/list.h"
 #include "osi/include/osi.h"
+#include "osi/include/profiler.h"
 #include "osi/include/semaphore.h"
 #include "osi/include/reactor.h"
 
+// Enqueue times of the newest elements of a profiled queue, oldest first.
+// Elements enqueued while profiling was disabled have no stamp, so the ring
+// may be shorter than the queue but never longer, except briefly after an
+// element is removed from the middle of the queue.
+typedef struct {
+  profiler_queue_t *latency;
+  uint64_t *stamps;
+  size_t size;
+  size_t start;
+  size_t count;
+} queue_profile_t;
+
 typedef struct fixed_queue_t {
   list_t *list;
   semaphore_t *enqueue_sem;
@@ -37,9 +50,13 @@ typedef struct fixed_queue_t {
   reactor_object_t *dequeue_object;
   fixed_queue_cb dequeue_ready;
   void *dequeue_context;
+
+  queue_profile_t *profile;
 } fixed_queue_t;
 
 static void internal_dequeue_ready(void *context);
+static void profile_enqueued(fixed_queue_t *queue);
+static void profile_dequeued(fixed_queue_t *queue);
 
 fixed_queue_t *fixed_queue_new(size_t capacity) {
   fixed_queue_t *ret = osi_calloc(sizeof(fixed_queue_t));
@@ -76,6 +93,12 @@ void fixed_queue_free(fixed_queue_t *queue, fixed_queue_free_cb free_cb) {
     for (const list_node_t *node = list_begin(queue->list); node != list_end(queue->list); node = list_next(node))
       free_cb(list_node(node));
 
+  if (queue->profile) {
+    profiler_queue_free(queue->profile->latency);
+    osi_free(queue->profile->stamps);
+    osi_free(queue->profile);
+  }
+
   list_free(queue->list);
   semaphore_free(queue->enqueue_sem);
   semaphore_free(queue->dequeue_sem);
@@ -111,6 +134,19 @@ size_t fixed_queue_capacity(fixed_queue_t *queue) {
   return queue->capacity;
 }
 
+void fixed_queue_profile(fixed_queue_t *queue, const char *name) {
+  assert(queue != NULL);
+  assert(name != NULL);
+
+  queue_profile_t *profile = osi_calloc(sizeof(queue_profile_t));
+  profile->latency = profiler_queue_new(name);
+
+  pthread_mutex_lock(&queue->lock);
+  assert(queue->profile == NULL);
+  queue->profile = profile;
+  pthread_mutex_unlock(&queue->lock);
+}
+
 void fixed_queue_enqueue(fixed_queue_t *queue, void *data) {
   assert(queue != NULL);
   assert(data != NULL);
@@ -119,6 +155,7 @@ void fixed_queue_enqueue(fixed_queue_t *queue, void *data) {
 
   pthread_mutex_lock(&queue->lock);
   list_append(queue->list, data);
+  profile_enqueued(queue);
   pthread_mutex_unlock(&queue->lock);
 
   semaphore_post(queue->dequeue_sem);
@@ -130,6 +167,7 @@ void *fixed_queue_dequeue(fixed_queue_t *queue) {
   semaphore_wait(queue->dequeue_sem);
 
   pthread_mutex_lock(&queue->lock);
+  profile_dequeued(queue);
   void *ret = list_front(queue->list);
   list_remove(queue->list, ret);
   pthread_mutex_unlock(&queue->lock);
@@ -148,6 +186,7 @@ bool fixed_queue_try_enqueue(fixed_queue_t *queue, void *data) {
 
   pthread_mutex_lock(&queue->lock);
   list_append(queue->list, data);
+  profile_enqueued(queue);
   pthread_mutex_unlock(&queue->lock);
 
   semaphore_post(queue->dequeue_sem);
@@ -162,6 +201,7 @@ void *fixed_queue_try_dequeue(fixed_queue_t *queue) {
     return NULL;
 
   pthread_mutex_lock(&queue->lock);
+  profile_dequeued(queue);
   void *ret = list_front(queue->list);
   list_remove(queue->list, ret);
   pthread_mutex_unlock(&queue->lock);
@@ -266,3 +306,48 @@ static void internal_dequeue_ready(void *context) {
   fixed_queue_t *queue = context;
   queue->dequeue_ready(queue, queue->dequeue_context);
 }
+
+// Must be called with the queue lock held, after the element is appended.
+static void profile_enqueued(fixed_queue_t *queue) {
+  queue_profile_t *profile = queue->profile;
+  if (!profile || !profiler_is_enabled())
+    return;
+
+  if (profile->count == profile->size) {
+    size_t size = profile->size ? profile->size * 2 : 16;
+    uint64_t *stamps = osi_malloc(size * sizeof(uint64_t));
+    for (size_t i = 0; i < profile->count; ++i)
+      stamps[i] = profile->stamps[(profile->start + i) % profile->size];
+    osi_free(profile->stamps);
+    profile->stamps = stamps;
+    profile->size = size;
+    profile->start = 0;
+  }
+
+  profile->stamps[(profile->start + profile->count) % profile->size] = profiler_now_us();
+  ++profile->count;
+}
+
+// Must be called with the queue lock held, before the front element is
+// removed.
+static void profile_dequeued(fixed_queue_t *queue) {
+  queue_profile_t *profile = queue->profile;
+  if (!profile)
+    return;
+
+  // Drop the stamps of elements removed from the middle of the queue. The
+  // oldest are dropped since it is not known which they were.
+  const size_t length = list_length(queue->list);
+  while (profile->count > length) {
+    profile->start = (profile->start + 1) % profile->size;
+    --profile->count;
+  }
+
+  // The front element has a stamp only if every element does.
+  if (profile->count == 0 || profile->count < length)
+    return;
+
+  profiler_queue_record(profile->latency, profiler_now_us() - profile->stamps[profile->start]);
+  profile->start = (profile->start + 1) % profile->size;
+  --profile->count;
+}
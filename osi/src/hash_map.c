@@ -20,18 +20,46 @@
 
 #include "osi/include/allocator.h"
 #include "osi/include/hash_map.h"
-#include "osi/include/list.h"
 #include "osi/include/osi.h"
 
-struct hash_map_t;
-
-typedef struct hash_map_bucket_t {
-  list_t *list;
-} hash_map_bucket_t;
+// Entries live inline in a power of two sized table and are placed by Robin
+// Hood linear probing: an entry being inserted takes over the slot of any
+// entry closer to its own home slot. This keeps probe sequences short and
+// lets a lookup stop as soon as it passes the point where its key would
+// have been placed.
+//
+// Once three quarters full, the table is replaced by one twice its size.
+// Later insertions and removals each move a few slots of the old table to
+// the new one, so no single call pays for rehashing the whole map. Until
+// the old table is drained, lookups check both.
+
+#define MIN_CAPACITY 8
+
+// Slots of the old table drained by each insertion or removal. Draining
+// finishes before the new table can get more than half full.
+#define DRAIN_STEP 4
+
+// Values of |hash_map_slot_t.probe| other than the distance of the entry
+// from its home slot plus one.
+#define SLOT_EMPTY 0
+#define SLOT_DRAINED UINT32_MAX   // Old table only, the entry has left.
+
+typedef struct {
+  hash_map_entry_t entry;
+  hash_index_t hash;
+  uint32_t probe;
+} hash_map_slot_t;
+
+typedef struct {
+  hash_map_slot_t *slots;
+  size_t capacity;
+  unsigned shift;
+} hash_map_table_t;
 
 typedef struct hash_map_t {
-  hash_map_bucket_t *bucket;
-  size_t num_bucket;
+  hash_map_table_t table;
+  hash_map_table_t old;
+  size_t drained;
   size_t hash_size;
   hash_index_fn hash_fn;
   key_free_fn key_fn;
@@ -40,13 +68,18 @@ typedef struct hash_map_t {
   key_equality_fn keys_are_equal;
 } hash_map_t;
 
-// Hidden constructor for list, only to be used by us.
-list_t *list_new_internal(list_free_cb callback, const allocator_t *zeroed_allocator);
-
-static void bucket_free_(void *data);
+static bool table_new_(const hash_map_t *hash_map, hash_map_table_t *table, size_t capacity);
+static void table_free_(const hash_map_t *hash_map, hash_map_table_t *table);
+static hash_map_slot_t *table_find_(const hash_map_t *hash_map,
+    const hash_map_table_t *table, size_t drained, const void *key, hash_index_t hash);
+static void table_insert_(hash_map_table_t *table, hash_map_slot_t slot);
+static void table_remove_(hash_map_table_t *table, hash_map_slot_t *slot);
+static hash_map_slot_t *find_slot_(const hash_map_t *hash_map, const void *key,
+    hash_index_t hash, bool *in_old);
+static bool grow_(hash_map_t *hash_map);
+static void drain_(hash_map_t *hash_map, size_t slots);
+static void entry_free_(const hash_map_t *hash_map, hash_map_entry_t *entry);
 static bool default_key_equality(const void *x, const void *y);
-static hash_map_entry_t *find_bucket_entry_(list_t *hash_bucket_list,
-    const void *key);
 
 // Hidden constructor, only to be used by the allocation tracker. Behaves the same as
 // |hash_map_new|, except you get to specify the allocator.
@@ -71,9 +104,11 @@ hash_map_t *hash_map_new_internal(
   hash_map->allocator = zeroed_allocator;
   hash_map->keys_are_equal = equality_fn ? equality_fn : default_key_equality;
 
-  hash_map->num_bucket = num_bucket;
-  hash_map->bucket = zeroed_allocator->alloc(sizeof(hash_map_bucket_t) * num_bucket);
-  if (hash_map->bucket == NULL) {
+  size_t capacity = MIN_CAPACITY;
+  while (capacity < num_bucket)
+    capacity *= 2;
+
+  if (!table_new_(hash_map, &hash_map->table, capacity)) {
     zeroed_allocator->free(hash_map);
     return NULL;
   }
@@ -93,7 +128,7 @@ void hash_map_free(hash_map_t *hash_map) {
   if (hash_map == NULL)
     return;
   hash_map_clear(hash_map);
-  hash_map->allocator->free(hash_map->bucket);
+  table_free_(hash_map, &hash_map->table);
   hash_map->allocator->free(hash_map);
 }
 
@@ -109,77 +144,103 @@ size_t hash_map_size(const hash_map_t *hash_map) {
 
 size_t hash_map_num_buckets(const hash_map_t *hash_map) {
   assert(hash_map != NULL);
-  return hash_map->num_bucket;
+  return hash_map->table.capacity;
 }
 
-bool hash_map_has_key(const hash_map_t *hash_map, const void *key) {
+size_t hash_map_longest_probe(const hash_map_t *hash_map) {
   assert(hash_map != NULL);
 
-  hash_index_t hash_key = hash_map->hash_fn(key) % hash_map->num_bucket;
-  list_t *hash_bucket_list = hash_map->bucket[hash_key].list;
+  size_t longest = 0;
+  for (size_t i = 0; i < hash_map->table.capacity; ++i) {
+    if (hash_map->table.slots[i].probe > longest)
+      longest = hash_map->table.slots[i].probe;
+  }
 
-  hash_map_entry_t *hash_map_entry = find_bucket_entry_(hash_bucket_list, key);
-  return (hash_map_entry != NULL);
+  for (size_t i = hash_map->drained; i < hash_map->old.capacity; ++i) {
+    uint32_t probe = hash_map->old.slots[i].probe;
+    if (probe != SLOT_DRAINED && probe > longest)
+      longest = probe;
+  }
+  return longest;
+}
+
+bool hash_map_has_key(const hash_map_t *hash_map, const void *key) {
+  assert(hash_map != NULL);
+
+  bool in_old;
+  return find_slot_(hash_map, key, hash_map->hash_fn(key), &in_old) != NULL;
 }
 
 bool hash_map_set(hash_map_t *hash_map, const void *key, void *data) {
   assert(hash_map != NULL);
   assert(data != NULL);
 
-  hash_index_t hash_key = hash_map->hash_fn(key) % hash_map->num_bucket;
+  hash_index_t hash = hash_map->hash_fn(key);
+  bool in_old;
+  hash_map_slot_t *slot = find_slot_(hash_map, key, hash, &in_old);
 
-  if (hash_map->bucket[hash_key].list == NULL) {
-    hash_map->bucket[hash_key].list = list_new_internal(bucket_free_, hash_map->allocator);
-    if (hash_map->bucket[hash_key].list == NULL)
-        return false;
+  if (slot && !in_old) {
+    hash_map_entry_t replaced = slot->entry;
+    slot->entry.key = key;
+    slot->entry.data = data;
+    entry_free_(hash_map, &replaced);
+    return true;
   }
-  list_t *hash_bucket_list = hash_map->bucket[hash_key].list;
-
-  hash_map_entry_t *hash_map_entry = find_bucket_entry_(hash_bucket_list, key);
 
-  if (hash_map_entry) {
-    // Calls hash_map callback to delete the hash_map_entry.
-    UNUSED_ATTR bool rc = list_remove(hash_bucket_list, hash_map_entry);
-    assert(rc == true);
+  hash_map_entry_t replaced;
+  if (slot) {
+    replaced = slot->entry;
+    slot->probe = SLOT_DRAINED;
   } else {
+    // Keep a quarter of the slots free so probe sequences stay short.
+    if ((hash_map->hash_size + 1) * 4 > hash_map->table.capacity * 3 && !grow_(hash_map) &&
+        hash_map->hash_size + 1 >= hash_map->table.capacity)
+      return false;
     hash_map->hash_size++;
   }
-  hash_map_entry = hash_map->allocator->alloc(sizeof(hash_map_entry_t));
-  if (hash_map_entry == NULL)
-    return false;
 
-  hash_map_entry->key = key;
-  hash_map_entry->data = data;
-  hash_map_entry->hash_map = hash_map;
+  hash_map_slot_t inserted;
+  inserted.entry.key = key;
+  inserted.entry.data = data;
+  inserted.entry.hash_map = hash_map;
+  inserted.hash = hash;
+  table_insert_(&hash_map->table, inserted);
+
+  if (slot)
+    entry_free_(hash_map, &replaced);
 
-  return list_append(hash_bucket_list, hash_map_entry);
+  drain_(hash_map, DRAIN_STEP);
+  return true;
 }
 
 bool hash_map_erase(hash_map_t *hash_map, const void *key) {
   assert(hash_map != NULL);
 
-  hash_index_t hash_key = hash_map->hash_fn(key) % hash_map->num_bucket;
-  list_t *hash_bucket_list = hash_map->bucket[hash_key].list;
-
-  hash_map_entry_t *hash_map_entry = find_bucket_entry_(hash_bucket_list, key);
-  if (hash_map_entry == NULL) {
+  bool in_old;
+  hash_map_slot_t *slot = find_slot_(hash_map, key, hash_map->hash_fn(key), &in_old);
+  if (slot == NULL) {
     return false;
   }
 
+  hash_map_entry_t erased = slot->entry;
+  if (in_old)
+    slot->probe = SLOT_DRAINED;
+  else
+    table_remove_(&hash_map->table, slot);
   hash_map->hash_size--;
 
-  return list_remove(hash_bucket_list, hash_map_entry);
+  drain_(hash_map, DRAIN_STEP);
+  entry_free_(hash_map, &erased);
+  return true;
 }
 
 void *hash_map_get(const hash_map_t *hash_map, const void *key) {
   assert(hash_map != NULL);
 
-  hash_index_t hash_key = hash_map->hash_fn(key) % hash_map->num_bucket;
-  list_t *hash_bucket_list = hash_map->bucket[hash_key].list;
-
-  hash_map_entry_t *hash_map_entry = find_bucket_entry_(hash_bucket_list, key);
-  if (hash_map_entry != NULL)
-    return hash_map_entry->data;
+  bool in_old;
+  hash_map_slot_t *slot = find_slot_(hash_map, key, hash_map->hash_fn(key), &in_old);
+  if (slot != NULL)
+    return slot->entry.data;
 
   return NULL;
 }
@@ -187,60 +248,183 @@ void *hash_map_get(const hash_map_t *hash_map, const void *key) {
 void hash_map_clear(hash_map_t *hash_map) {
   assert(hash_map != NULL);
 
-  for (hash_index_t i = 0; i < hash_map->num_bucket; i++){
-    if (hash_map->bucket[i].list == NULL)
-      continue;
-    list_free(hash_map->bucket[i].list);
-    hash_map->bucket[i].list = NULL;
+  hash_map_table_t *tables[] = { &hash_map->old, &hash_map->table };
+  for (size_t t = 0; t < ARRAY_SIZE(tables); ++t) {
+    for (hash_index_t i = 0; i < tables[t]->capacity; ++i) {
+      hash_map_slot_t *slot = &tables[t]->slots[i];
+      if (slot->probe == SLOT_EMPTY || slot->probe == SLOT_DRAINED)
+        continue;
+      hash_map_entry_t cleared = slot->entry;
+      slot->probe = SLOT_EMPTY;
+      entry_free_(hash_map, &cleared);
+    }
   }
+
+  table_free_(hash_map, &hash_map->old);
+  hash_map->drained = 0;
+  hash_map->hash_size = 0;
 }
 
 void hash_map_foreach(hash_map_t *hash_map, hash_map_iter_cb callback, void *context) {
   assert(hash_map != NULL);
   assert(callback != NULL);
 
-  for (hash_index_t i = 0; i < hash_map->num_bucket; ++i){
-    if (hash_map->bucket[i].list == NULL)
-      continue;
-    for (const list_node_t *iter = list_begin(hash_map->bucket[i].list);
-        iter != list_end(hash_map->bucket[i].list);
-        iter = list_next(iter)) {
-       hash_map_entry_t *hash_map_entry = (hash_map_entry_t *)list_node(iter);
-       if (!callback(hash_map_entry, context))
+  hash_map_table_t *tables[] = { &hash_map->table, &hash_map->old };
+  for (size_t t = 0; t < ARRAY_SIZE(tables); ++t) {
+    for (hash_index_t i = 0; i < tables[t]->capacity; ++i) {
+      hash_map_slot_t *slot = &tables[t]->slots[i];
+      if (slot->probe == SLOT_EMPTY || slot->probe == SLOT_DRAINED)
+        continue;
+      if (!callback(&slot->entry, context))
         return;
     }
   }
 }
 
-static void bucket_free_(void *data) {
-  assert(data != NULL);
-  hash_map_entry_t *hash_map_entry = (hash_map_entry_t *)data;
-  const hash_map_t *hash_map = hash_map_entry->hash_map;
+static bool table_new_(const hash_map_t *hash_map, hash_map_table_t *table, size_t capacity) {
+  // Zeroed, so every slot starts out as SLOT_EMPTY.
+  table->slots = hash_map->allocator->alloc(sizeof(hash_map_slot_t) * capacity);
+  if (table->slots == NULL)
+    return false;
 
-  if (hash_map->key_fn)
-    hash_map->key_fn((void *)hash_map_entry->key);
-  if (hash_map->data_fn)
-    hash_map->data_fn(hash_map_entry->data);
-  hash_map->allocator->free(hash_map_entry);
+  table->capacity = capacity;
+  table->shift = 64;
+  for (size_t i = capacity; i > 1; i /= 2)
+    table->shift--;
+  return true;
 }
 
-static hash_map_entry_t * find_bucket_entry_(list_t *hash_bucket_list,
-    const void *key) {
+static void table_free_(const hash_map_t *hash_map, hash_map_table_t *table) {
+  if (table->slots)
+    hash_map->allocator->free(table->slots);
+  table->slots = NULL;
+  table->capacity = 0;
+}
 
-  if (hash_bucket_list == NULL)
-    return NULL;
+// Returns the home slot of |hash|. Multiplying by 2^64 divided by the
+// golden ratio spreads keys such as pointers, whose low bits are mostly
+// zero, across the table.
+static size_t home_slot_(const hash_map_table_t *table, hash_index_t hash) {
+  return (size_t)(((uint64_t)hash * 0x9E3779B97F4A7C15ULL) >> table->shift);
+}
 
-  for (const list_node_t *iter = list_begin(hash_bucket_list);
-      iter != list_end(hash_bucket_list);
-      iter = list_next(iter)) {
-    hash_map_entry_t *hash_map_entry = (hash_map_entry_t *)list_node(iter);
-    if (hash_map_entry->hash_map->keys_are_equal(hash_map_entry->key, key)) {
-      return hash_map_entry;
+// The first |drained| slots of |table| are known to be SLOT_DRAINED.
+static hash_map_slot_t *table_find_(const hash_map_t *hash_map,
+    const hash_map_table_t *table, size_t drained, const void *key, hash_index_t hash) {
+  const size_t mask = table->capacity - 1;
+  size_t i = home_slot_(table, hash);
+
+  for (size_t probe = 1; probe <= table->capacity; ++probe, i = (i + 1) & mask) {
+    if (i < drained) {
+      probe += drained - i;
+      i = drained;
+      if (probe > table->capacity)
+        break;
     }
+
+    hash_map_slot_t *slot = &table->slots[i];
+    if (slot->probe == SLOT_EMPTY)
+      return NULL;
+    if (slot->probe == SLOT_DRAINED)
+      continue;
+    // |key| would have taken this slot over had it been inserted.
+    if (slot->probe < probe)
+      return NULL;
+    if (slot->hash == hash && hash_map->keys_are_equal(slot->entry.key, key))
+      return slot;
   }
   return NULL;
 }
 
+// |table| must have a free slot and must not hold the key of |slot|.
+static void table_insert_(hash_map_table_t *table, hash_map_slot_t slot) {
+  const size_t mask = table->capacity - 1;
+  size_t i = home_slot_(table, slot.hash);
+
+  for (slot.probe = 1; ; ++slot.probe, i = (i + 1) & mask) {
+    hash_map_slot_t *current = &table->slots[i];
+    if (current->probe == SLOT_EMPTY) {
+      *current = slot;
+      return;
+    }
+    if (current->probe < slot.probe) {
+      hash_map_slot_t displaced = *current;
+      *current = slot;
+      slot = displaced;
+    }
+  }
+}
+
+// Shifts the entries following |slot| back into the gap, which leaves the
+// table as if the removed entry had never been inserted.
+static void table_remove_(hash_map_table_t *table, hash_map_slot_t *slot) {
+  const size_t mask = table->capacity - 1;
+  size_t i = slot - table->slots;
+
+  for (;;) {
+    size_t next = (i + 1) & mask;
+    if (table->slots[next].probe <= 1) {
+      table->slots[i].probe = SLOT_EMPTY;
+      return;
+    }
+    table->slots[i] = table->slots[next];
+    table->slots[i].probe--;
+    i = next;
+  }
+}
+
+static hash_map_slot_t *find_slot_(const hash_map_t *hash_map, const void *key,
+    hash_index_t hash, bool *in_old) {
+  hash_map_slot_t *slot = table_find_(hash_map, &hash_map->table, 0, key, hash);
+  *in_old = false;
+  if (slot != NULL || hash_map->old.capacity == 0)
+    return slot;
+
+  *in_old = true;
+  return table_find_(hash_map, &hash_map->old, hash_map->drained, key, hash);
+}
+
+static bool grow_(hash_map_t *hash_map) {
+  // The old table is drained long before the new one fills up.
+  assert(hash_map->old.capacity == 0);
+
+  hash_map_table_t table;
+  if (!table_new_(hash_map, &table, hash_map->table.capacity * 2))
+    return false;
+
+  hash_map->old = hash_map->table;
+  hash_map->table = table;
+  hash_map->drained = 0;
+  return true;
+}
+
+// Moves the entries in the next |slots| slots of the old table to the
+// current one, and frees the old table once it is empty.
+static void drain_(hash_map_t *hash_map, size_t slots) {
+  hash_map_table_t *old = &hash_map->old;
+  if (old->capacity == 0)
+    return;
+
+  for (; slots > 0 && hash_map->drained < old->capacity; --slots) {
+    hash_map_slot_t *slot = &old->slots[hash_map->drained++];
+    if (slot->probe != SLOT_EMPTY && slot->probe != SLOT_DRAINED)
+      table_insert_(&hash_map->table, *slot);
+    slot->probe = SLOT_DRAINED;
+  }
+
+  if (hash_map->drained == old->capacity) {
+    table_free_(hash_map, old);
+    hash_map->drained = 0;
+  }
+}
+
+static void entry_free_(const hash_map_t *hash_map, hash_map_entry_t *entry) {
+  if (hash_map->key_fn)
+    hash_map->key_fn((void *)entry->key);
+  if (hash_map->data_fn)
+    hash_map->data_fn(entry->data);
+}
+
 static bool default_key_equality(const void *x, const void *y) {
   return x == y;
 }
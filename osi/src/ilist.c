@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <assert.h>
+
+#include "osi/include/ilist.h"
+
+// The list is circular through |head|, which is never an element.
+
+static ilist_node_t *node_of_(const ilist_t *list, const void *element);
+static void *element_of_(const ilist_t *list, const ilist_node_t *node);
+static void link_after_(ilist_t *list, ilist_node_t *prev, ilist_node_t *node);
+
+void ilist_init(ilist_t *list, size_t node_offset) {
+  assert(list != NULL);
+
+  list->head.next = &list->head;
+  list->head.prev = &list->head;
+  list->offset = node_offset;
+  list->length = 0;
+}
+
+bool ilist_is_empty(const ilist_t *list) {
+  assert(list != NULL);
+  return (list->length == 0);
+}
+
+size_t ilist_length(const ilist_t *list) {
+  assert(list != NULL);
+  return list->length;
+}
+
+bool ilist_is_linked(const ilist_t *list, const void *element) {
+  assert(list != NULL);
+  assert(element != NULL);
+
+  return (node_of_(list, element)->next != NULL);
+}
+
+void *ilist_front(const ilist_t *list) {
+  assert(list != NULL);
+  return element_of_(list, list->head.next);
+}
+
+void *ilist_back(const ilist_t *list) {
+  assert(list != NULL);
+  return element_of_(list, list->head.prev);
+}
+
+void *ilist_next(const ilist_t *list, const void *element) {
+  assert(list != NULL);
+  assert(element != NULL);
+
+  const ilist_node_t *node = node_of_(list, element);
+  assert(node->next != NULL);
+  return element_of_(list, node->next);
+}
+
+void ilist_prepend(ilist_t *list, void *element) {
+  assert(list != NULL);
+  assert(element != NULL);
+
+  link_after_(list, &list->head, node_of_(list, element));
+}
+
+void ilist_append(ilist_t *list, void *element) {
+  assert(list != NULL);
+  assert(element != NULL);
+
+  link_after_(list, list->head.prev, node_of_(list, element));
+}
+
+void ilist_insert_after(ilist_t *list, void *prev, void *element) {
+  assert(list != NULL);
+  assert(prev != NULL);
+  assert(element != NULL);
+
+  ilist_node_t *prev_node = node_of_(list, prev);
+  assert(prev_node->next != NULL);
+  link_after_(list, prev_node, node_of_(list, element));
+}
+
+bool ilist_remove(ilist_t *list, void *element) {
+  assert(list != NULL);
+  assert(element != NULL);
+
+  ilist_node_t *node = node_of_(list, element);
+  if (node->next == NULL)
+    return false;
+
+  assert(list->length > 0);
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = NULL;
+  node->prev = NULL;
+  --list->length;
+  return true;
+}
+
+void ilist_clear(ilist_t *list, list_free_cb free_cb) {
+  assert(list != NULL);
+
+  while (!ilist_is_empty(list)) {
+    void *element = ilist_front(list);
+    ilist_remove(list, element);
+    if (free_cb)
+      free_cb(element);
+  }
+}
+
+void *ilist_foreach(const ilist_t *list, list_iter_cb callback, void *context) {
+  assert(list != NULL);
+  assert(callback != NULL);
+
+  for (ilist_node_t *node = list->head.next; node != &list->head; ) {
+    ilist_node_t *next = node->next;
+    void *element = element_of_(list, node);
+    if (!callback(element, context))
+      return element;
+    node = next;
+  }
+  return NULL;
+}
+
+static ilist_node_t *node_of_(const ilist_t *list, const void *element) {
+  return (ilist_node_t *)((char *)element + list->offset);
+}
+
+static void *element_of_(const ilist_t *list, const ilist_node_t *node) {
+  if (node == &list->head)
+    return NULL;
+  return (char *)node - list->offset;
+}
+
+static void link_after_(ilist_t *list, ilist_node_t *prev, ilist_node_t *node) {
+  assert(node->next == NULL);
+
+  node->prev = prev;
+  node->next = prev->next;
+  prev->next->prev = node;
+  prev->next = node;
+  ++list->length;
+}
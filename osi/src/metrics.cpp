@@ -39,10 +39,13 @@ using clearcut::connectivity::BluetoothLog;
 using clearcut::connectivity::BluetoothSession;
 using clearcut::connectivity::DeviceInfo;
 using clearcut::connectivity::DeviceInfo_DeviceType;
+using clearcut::connectivity::EventProfile;
 using clearcut::connectivity::PairEvent;
+using clearcut::connectivity::QueueProfile;
 using clearcut::connectivity::ScanEvent;
 using clearcut::connectivity::ScanEvent_ScanTechnologyType;
 using clearcut::connectivity::ScanEvent_ScanEventType;
+using clearcut::connectivity::ThreadProfile;
 using clearcut::connectivity::WakeEvent;
 using clearcut::connectivity::WakeEvent_WakeEventType;
 
@@ -177,6 +180,53 @@ void metrics_a2dp_session(int64_t session_duration_sec,
   a2dp_session->set_buffer_underruns_count(buffer_underruns_count);
 }
 
+void metrics_thread_profile(const char *thread, int64_t cpu_ms) {
+  std::lock_guard<std::mutex> lock(log_lock);
+  lazy_initialize();
+
+  ThreadProfile *profile = pending->add_thread_profile();
+
+  if (thread)
+    profile->set_name(thread);
+
+  profile->set_cpu_millis(cpu_ms);
+}
+
+void metrics_queue_profile(const char *queue, uint64_t count, uint64_t avg_us,
+                           uint64_t p50_us, uint64_t p99_us, uint64_t max_us) {
+  std::lock_guard<std::mutex> lock(log_lock);
+  lazy_initialize();
+
+  QueueProfile *profile = pending->add_queue_profile();
+
+  if (queue)
+    profile->set_name(queue);
+
+  profile->set_count(count);
+  profile->set_latency_avg_micros(avg_us);
+  profile->set_latency_p50_micros(p50_us);
+  profile->set_latency_p99_micros(p99_us);
+  profile->set_latency_max_micros(max_us);
+}
+
+void metrics_event_profile(const char *table, uint32_t event, uint64_t count,
+                           uint64_t avg_us, uint64_t max_us,
+                           uint64_t cpu_avg_us) {
+  std::lock_guard<std::mutex> lock(log_lock);
+  lazy_initialize();
+
+  EventProfile *profile = pending->add_event_profile();
+
+  if (table)
+    profile->set_table(table);
+
+  profile->set_event(event);
+  profile->set_count(count);
+  profile->set_run_time_avg_micros(avg_us);
+  profile->set_run_time_max_micros(max_us);
+  profile->set_cpu_time_avg_micros(cpu_avg_us);
+}
+
 void metrics_write(int fd, bool clear) {
   log_lock.lock();
   LOG_DEBUG(LOG_TAG, "%s serializing metrics", __func__);
@@ -51,6 +51,21 @@ void metrics_a2dp_session(int64_t session_duration_sec,
   //TODO(jpawlowski): implement
 }
 
+void metrics_thread_profile(const char *thread, int64_t cpu_ms) {
+  //TODO(jpawlowski): implement
+}
+
+void metrics_queue_profile(const char *queue, uint64_t count, uint64_t avg_us,
+                           uint64_t p50_us, uint64_t p99_us, uint64_t max_us) {
+  //TODO(jpawlowski): implement
+}
+
+void metrics_event_profile(const char *table, uint32_t event, uint64_t count,
+                           uint64_t avg_us, uint64_t max_us,
+                           uint64_t cpu_avg_us) {
+  //TODO(jpawlowski): implement
+}
+
 void metrics_write(int fd, bool clear) {
   //TODO(jpawlowski): implement
 }
@@ -0,0 +1,408 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_profiler"
+
+#include "osi/include/profiler.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/compat.h"
+#include "osi/include/list.h"
+#include "osi/include/metrics.h"
+#include "osi/include/osi.h"
+
+#define PROFILER_NAME_MAX 32
+
+// Bucket 0 counts latencies under 1us, bucket i those in [2^(i-1), 2^i) us
+// and the last bucket everything from about 4s up.
+#define HISTOGRAM_BUCKETS 24
+
+// Distinct event ids tracked per table; any others are counted together.
+#define EVENT_SLOTS 256
+
+// Reading the thread CPU clock is a system call, so only one in this many
+// dispatches samples it.
+#define CPU_SAMPLE_PERIOD 8
+
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t buckets[HISTOGRAM_BUCKETS];
+} histogram_t;
+
+struct profiler_queue_t {
+  char name[PROFILER_NAME_MAX];
+  histogram_t latency;
+};
+
+typedef struct {
+  uint32_t key;             // Event id + 1, or 0 while the slot is free.
+  uint64_t count;
+  uint64_t wall_total_us;
+  uint64_t wall_max_us;
+  uint64_t cpu_samples;
+  uint64_t cpu_total_ns;
+} event_slot_t;
+
+struct profiler_events_t {
+  char name[PROFILER_NAME_MAX];
+  uint64_t dispatches;
+  event_slot_t overflow;
+  event_slot_t slots[EVENT_SLOTS];
+};
+
+typedef struct {
+  char name[PROFILER_NAME_MAX];
+  pthread_t pthread;
+} thread_entry_t;
+
+static bool enabled;
+
+// Protects the lists below, not the counters, which are updated atomically.
+// The lists exist only while they are not empty.
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static list_t *queues;
+static list_t *event_tables;
+static list_t *threads;
+
+static void add_to(list_t **list, void *item, list_free_cb free_cb);
+static void remove_from(list_t **list, void *item);
+static void update_max(uint64_t *max, uint64_t value);
+static uint64_t thread_cpu_ns(void);
+static event_slot_t *find_slot(profiler_events_t *events, uint16_t event);
+static uint64_t percentile_us(const histogram_t *histogram, unsigned percent);
+static uint64_t load(const uint64_t *counter);
+
+void profiler_set_enabled(bool enable) {
+  __atomic_store_n(&enabled, enable, __ATOMIC_RELAXED);
+}
+
+bool profiler_is_enabled(void) {
+  return __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+}
+
+uint64_t profiler_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+profiler_queue_t *profiler_queue_new(const char *name) {
+  assert(name != NULL);
+
+  profiler_queue_t *queue = osi_calloc(sizeof(profiler_queue_t));
+  strlcpy(queue->name, name, sizeof(queue->name));
+  add_to(&queues, queue, NULL);
+  return queue;
+}
+
+void profiler_queue_free(profiler_queue_t *queue) {
+  if (!queue)
+    return;
+
+  remove_from(&queues, queue);
+  osi_free(queue);
+}
+
+void profiler_queue_record(profiler_queue_t *queue, uint64_t latency_us) {
+  if (!queue || !profiler_is_enabled())
+    return;
+
+  histogram_t *histogram = &queue->latency;
+  size_t bucket = latency_us ? 64 - __builtin_clzll(latency_us) : 0;
+  if (bucket >= HISTOGRAM_BUCKETS)
+    bucket = HISTOGRAM_BUCKETS - 1;
+
+  __atomic_fetch_add(&histogram->buckets[bucket], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->total_us, latency_us, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+  update_max(&histogram->max_us, latency_us);
+}
+
+profiler_events_t *profiler_events_new(const char *name) {
+  assert(name != NULL);
+
+  profiler_events_t *events = osi_calloc(sizeof(profiler_events_t));
+  strlcpy(events->name, name, sizeof(events->name));
+  add_to(&event_tables, events, NULL);
+  return events;
+}
+
+void profiler_events_free(profiler_events_t *events) {
+  if (!events)
+    return;
+
+  remove_from(&event_tables, events);
+  osi_free(events);
+}
+
+void profiler_event_begin(profiler_events_t *events, uint16_t event, profiler_scope_t *scope) {
+  assert(scope != NULL);
+
+  if (!events || !profiler_is_enabled()) {
+    scope->events = NULL;
+    return;
+  }
+
+  scope->events = events;
+  scope->event = event;
+  scope->start_cpu_ns = 0;
+  if (__atomic_fetch_add(&events->dispatches, 1, __ATOMIC_RELAXED) % CPU_SAMPLE_PERIOD == 0)
+    scope->start_cpu_ns = thread_cpu_ns();
+  scope->start_us = profiler_now_us();
+}
+
+void profiler_event_end(profiler_scope_t *scope) {
+  assert(scope != NULL);
+
+  if (!scope->events)
+    return;
+
+  const uint64_t wall_us = profiler_now_us() - scope->start_us;
+  event_slot_t *slot = find_slot(scope->events, scope->event);
+
+  __atomic_fetch_add(&slot->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&slot->wall_total_us, wall_us, __ATOMIC_RELAXED);
+  update_max(&slot->wall_max_us, wall_us);
+
+  if (scope->start_cpu_ns) {
+    __atomic_fetch_add(&slot->cpu_total_ns, thread_cpu_ns() - scope->start_cpu_ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&slot->cpu_samples, 1, __ATOMIC_RELAXED);
+  }
+}
+
+void profiler_thread_register(const char *name) {
+  assert(name != NULL);
+
+  thread_entry_t *entry = osi_calloc(sizeof(thread_entry_t));
+  strlcpy(entry->name, name, sizeof(entry->name));
+  entry->pthread = pthread_self();
+  add_to(&threads, entry, osi_free);
+}
+
+void profiler_thread_unregister(void) {
+  thread_entry_t *self = NULL;
+
+  pthread_mutex_lock(&lock);
+  if (threads) {
+    for (const list_node_t *node = list_begin(threads); node != list_end(threads); node = list_next(node)) {
+      thread_entry_t *entry = list_node(node);
+      if (pthread_equal(entry->pthread, pthread_self())) {
+        self = entry;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&lock);
+
+  if (self)
+    remove_from(&threads, self);
+}
+
+void profiler_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Dispatch Profile:\n");
+  dprintf(fd, "  Enabled: %s\n", profiler_is_enabled() ? "true" : "false");
+
+  pthread_mutex_lock(&lock);
+
+  // Threads are removed from the list before they exit, so their CPU
+  // clocks are valid while the lock is held.
+  dprintf(fd, "  Thread CPU time in ms:\n");
+  if (threads) {
+    for (const list_node_t *node = list_begin(threads); node != list_end(threads); node = list_next(node)) {
+      const thread_entry_t *entry = list_node(node);
+      clockid_t clock_id;
+      struct timespec ts;
+      if (pthread_getcpuclockid(entry->pthread, &clock_id) || clock_gettime(clock_id, &ts))
+        continue;
+      dprintf(fd, "    %-40s: %llu\n", entry->name,
+              (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+    }
+  }
+
+  dprintf(fd, "  Queue latency in us (count/avg/p50/p99/max):\n");
+  if (queues) {
+    for (const list_node_t *node = list_begin(queues); node != list_end(queues); node = list_next(node)) {
+      const profiler_queue_t *queue = list_node(node);
+      const uint64_t count = load(&queue->latency.count);
+      if (!count)
+        continue;
+      dprintf(fd, "    %-40s: %llu / %llu / %llu / %llu / %llu\n", queue->name,
+              (unsigned long long)count,
+              (unsigned long long)(load(&queue->latency.total_us) / count),
+              (unsigned long long)percentile_us(&queue->latency, 50),
+              (unsigned long long)percentile_us(&queue->latency, 99),
+              (unsigned long long)load(&queue->latency.max_us));
+    }
+  }
+
+  // CPU time is estimated from the sampled dispatches.
+  dprintf(fd, "  Event run time in us (count/avg/max/avg cpu):\n");
+  if (event_tables) {
+    for (const list_node_t *node = list_begin(event_tables); node != list_end(event_tables); node = list_next(node)) {
+      profiler_events_t *events = list_node(node);
+      for (size_t i = 0; i <= EVENT_SLOTS; ++i) {
+        const event_slot_t *slot = (i < EVENT_SLOTS) ? &events->slots[i] : &events->overflow;
+        const uint64_t count = load(&slot->count);
+        const uint64_t cpu_samples = load(&slot->cpu_samples);
+        if (!count)
+          continue;
+
+        char label[PROFILER_NAME_MAX + 16];
+        if (i < EVENT_SLOTS)
+          snprintf(label, sizeof(label), "%s 0x%04x", events->name, __atomic_load_n(&slot->key, __ATOMIC_RELAXED) - 1);
+        else
+          snprintf(label, sizeof(label), "%s other", events->name);
+        dprintf(fd, "    %-40s: %llu / %llu / %llu / %llu\n", label,
+                (unsigned long long)count,
+                (unsigned long long)(load(&slot->wall_total_us) / count),
+                (unsigned long long)load(&slot->wall_max_us),
+                (unsigned long long)(cpu_samples ? load(&slot->cpu_total_ns) / cpu_samples / 1000 : 0));
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&lock);
+}
+
+void profiler_update_metrics(void) {
+  pthread_mutex_lock(&lock);
+
+  if (threads) {
+    for (const list_node_t *node = list_begin(threads); node != list_end(threads); node = list_next(node)) {
+      const thread_entry_t *entry = list_node(node);
+      clockid_t clock_id;
+      struct timespec ts;
+      if (pthread_getcpuclockid(entry->pthread, &clock_id) || clock_gettime(clock_id, &ts))
+        continue;
+      metrics_thread_profile(entry->name, (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+    }
+  }
+
+  if (queues) {
+    for (const list_node_t *node = list_begin(queues); node != list_end(queues); node = list_next(node)) {
+      const profiler_queue_t *queue = list_node(node);
+      const uint64_t count = load(&queue->latency.count);
+      if (!count)
+        continue;
+      metrics_queue_profile(queue->name, count,
+                            load(&queue->latency.total_us) / count,
+                            percentile_us(&queue->latency, 50),
+                            percentile_us(&queue->latency, 99),
+                            load(&queue->latency.max_us));
+    }
+  }
+
+  if (event_tables) {
+    for (const list_node_t *node = list_begin(event_tables); node != list_end(event_tables); node = list_next(node)) {
+      profiler_events_t *events = list_node(node);
+      for (size_t i = 0; i < EVENT_SLOTS; ++i) {
+        const event_slot_t *slot = &events->slots[i];
+        const uint64_t count = load(&slot->count);
+        const uint64_t cpu_samples = load(&slot->cpu_samples);
+        if (!count)
+          continue;
+        metrics_event_profile(events->name, __atomic_load_n(&slot->key, __ATOMIC_RELAXED) - 1, count,
+                              load(&slot->wall_total_us) / count,
+                              load(&slot->wall_max_us),
+                              cpu_samples ? load(&slot->cpu_total_ns) / cpu_samples / 1000 : 0);
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&lock);
+}
+
+static void add_to(list_t **list, void *item, list_free_cb free_cb) {
+  pthread_mutex_lock(&lock);
+  if (!*list)
+    *list = list_new(free_cb);
+  list_append(*list, item);
+  pthread_mutex_unlock(&lock);
+}
+
+static void remove_from(list_t **list, void *item) {
+  pthread_mutex_lock(&lock);
+  if (*list) {
+    list_remove(*list, item);
+    if (list_is_empty(*list)) {
+      list_free(*list);
+      *list = NULL;
+    }
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+static void update_max(uint64_t *max, uint64_t value) {
+  uint64_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+  while (value > current &&
+         !__atomic_compare_exchange_n(max, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static uint64_t thread_cpu_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  const uint64_t ns = (uint64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  return ns ? ns : 1;
+}
+
+// Events map to slots by open addressing. A slot is claimed for good by the
+// first event that lands on it, so lookups never need a lock.
+static event_slot_t *find_slot(profiler_events_t *events, uint16_t event) {
+  const uint32_t key = (uint32_t)event + 1;
+  size_t index = (event * 2654435761u) % EVENT_SLOTS;
+
+  for (size_t probe = 0; probe < EVENT_SLOTS; ++probe) {
+    event_slot_t *slot = &events->slots[index];
+    uint32_t current = __atomic_load_n(&slot->key, __ATOMIC_RELAXED);
+    if (current == key)
+      return slot;
+    if (current == 0) {
+      if (__atomic_compare_exchange_n(&slot->key, &current, key, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ||
+          current == key)
+        return slot;
+    }
+    index = (index + 1) % EVENT_SLOTS;
+  }
+
+  return &events->overflow;
+}
+
+// Returns the upper bound of the bucket holding the |percent|th percentile.
+static uint64_t percentile_us(const histogram_t *histogram, unsigned percent) {
+  const uint64_t count = load(&histogram->count);
+  const uint64_t target = (count * percent + 99) / 100;
+  uint64_t seen = 0;
+
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS - 1; ++i) {
+    seen += load(&histogram->buckets[i]);
+    if (seen >= target)
+      return 1ULL << i;
+  }
+  return load(&histogram->max_us);
+}
+
+static uint64_t load(const uint64_t *counter) {
+  return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
@@ -33,6 +33,7 @@
 #include "osi/include/compat.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/profiler.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
@@ -77,6 +78,7 @@ thread_t *thread_new_sized(const char *name, size_t work_queue_capacity) {
   ret->work_queue = fixed_queue_new(work_queue_capacity);
   if (!ret->work_queue)
     goto error;
+  fixed_queue_profile(ret->work_queue, name);
 
   // Start is on the stack, but we use a semaphore, so it's safe
   struct start_arg start;
@@ -197,6 +199,7 @@ static void *run_thread(void *start_arg) {
     return NULL;
   }
   thread->tid = gettid();
+  profiler_thread_register(thread->name);
 
   LOG_WARN(LOG_TAG, "%s: thread id %d, thread name %s started", __func__, thread->tid, thread->name);
 
@@ -224,6 +227,7 @@ static void *run_thread(void *start_arg) {
   if (count > fixed_queue_capacity(thread->work_queue))
     LOG_DEBUG(LOG_TAG, "%s growing event queue on shutdown.", __func__);
 
+  profiler_thread_unregister();
   LOG_WARN(LOG_TAG, "%s: thread id %d, thread name %s exited", __func__, thread->tid, thread->name);
   return NULL;
 }
@@ -18,6 +18,8 @@
 
 #include <gtest/gtest.h>
 
+#include <time.h>
+
 #include "AllocationTestHarness.h"
 
 extern "C" {
@@ -145,3 +147,106 @@ TEST_F(EagerReaderTest, test_large_data_multibyte) {
   eager_reader_free(reader);
   thread_free(read_thread);
 }
+
+static size_t g_alloc_count;
+static void *counting_alloc(size_t size) {
+  __atomic_add_fetch(&g_alloc_count, 1, __ATOMIC_RELAXED);
+  return osi_malloc(size);
+}
+
+static const allocator_t counting_allocator = { counting_alloc, osi_free };
+
+static size_t g_bytes_expected;
+static size_t g_bytes_received;
+
+// Reads whatever is available and posts |done| once |g_bytes_expected|
+// bytes arrived since the last post.
+static void expect_chunk(eager_reader_t *reader, UNUSED_ATTR void *context) {
+  uint8_t buffer[64];
+  size_t bytes_read;
+  while ((bytes_read = eager_reader_read(reader, buffer, sizeof(buffer))) > 0) {
+    g_bytes_received += bytes_read;
+    if (g_bytes_received == g_bytes_expected) {
+      g_bytes_received = 0;
+      semaphore_post(done);
+    }
+  }
+}
+
+TEST_F(EagerReaderTest, test_small_reads_share_buffer) {
+  eager_reader_t *reader = eager_reader_new(pipefd[0], &counting_allocator, 1024, SIZE_MAX, "test_thread");
+
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_chunk, NULL);
+
+  g_alloc_count = 0;
+  g_bytes_received = 0;
+  g_bytes_expected = strlen(small_data);
+  for (int i = 0; i < 10; i++) {
+    write(pipefd[1], small_data, strlen(small_data));
+    semaphore_wait(done);
+  }
+
+  // All ten writes fit in the first buffer.
+  EXPECT_EQ(1U, g_alloc_count);
+
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
+
+TEST_F(EagerReaderTest, test_buffers_recycled) {
+  eager_reader_t *reader = eager_reader_new(pipefd[0], &counting_allocator, BUFFER_SIZE, SIZE_MAX, "test_thread");
+
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_chunk, NULL);
+
+  g_alloc_count = 0;
+  g_bytes_received = 0;
+  g_bytes_expected = 20;
+  size_t length = strlen(large_data);
+  for (size_t i = 0; i + g_bytes_expected <= length; i += g_bytes_expected) {
+    write(pipefd[1], large_data + i, g_bytes_expected);
+    semaphore_wait(done);
+  }
+
+  // Without recycling every BUFFER_SIZE bytes would take an allocation.
+  EXPECT_LE(g_alloc_count, 3U);
+
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
+
+// Pushes 1MB through the reader in HCI sized writes, waiting for each to be
+// read before sending the next. Prints the buffer allocations per MB and the
+// time from write to the consumer having read the whole write.
+TEST_F(EagerReaderTest, test_benchmark_latency_and_allocations) {
+  const size_t chunk_size = 260;
+  const size_t total_bytes = 1024 * 1024;
+  uint8_t chunk[chunk_size];
+  memset(chunk, 0x42, chunk_size);
+
+  eager_reader_t *reader = eager_reader_new(pipefd[0], &counting_allocator, 1026, SIZE_MAX, "test_thread");
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_chunk, NULL);
+
+  g_alloc_count = 0;
+  g_bytes_received = 0;
+  g_bytes_expected = chunk_size;
+  size_t chunks = 0;
+  double total_ns = 0;
+  for (size_t sent = 0; sent < total_bytes; sent += chunk_size, chunks++) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    write(pipefd[1], chunk, chunk_size);
+    semaphore_wait(done);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    total_ns += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+  }
+
+  printf("%zu allocations per MB, %.1f us write to read latency\n",
+         g_alloc_count, total_ns / chunks / 1000);
+  EXPECT_LT(g_alloc_count, 16U);
+
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
@@ -18,9 +18,12 @@
 
 #include <gtest/gtest.h>
 
+#include <time.h>
+
 #include "AllocationTestHarness.h"
 
 extern "C" {
+#include "osi/include/hash_functions.h"
 #include "osi/include/hash_map.h"
 #include "osi/include/osi.h"
 }
@@ -200,3 +203,210 @@ TEST_F(HashMapTest, test_iter) {
 
   hash_map_free(hash_map);
 }
+
+static uint64_t lookup_time_ns(hash_map_t *hash_map, size_t num_keys, size_t lookups) {
+  struct timespec start, end;
+  void *sink = NULL;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < lookups; i++) {
+    // Socket ids are small sequential integers.
+    sink = hash_map_get(hash_map, UINT_TO_PTR(i % num_keys + 1));
+    EXPECT_TRUE(sink != NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+}
+
+// Small sequential integer keys, as socket ids are, stay at or next to their
+// home slot however many there are, so lookups do not get slower as more are
+// added.
+TEST_F(HashMapTest, test_integer_key_probe_length) {
+  const size_t PROBE_LIMIT = 4;
+  hash_map_t *hash_map = hash_map_new(256, hash_function_integer, NULL, NULL, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+  EXPECT_EQ(0U, hash_map_longest_probe(hash_map));
+
+  for (size_t num_keys = 1; num_keys <= 4096; num_keys++) {
+    hash_map_set(hash_map, UINT_TO_PTR(num_keys), UINT_TO_PTR(num_keys));
+    EXPECT_LE(hash_map_longest_probe(hash_map), PROBE_LIMIT) << num_keys << " keys";
+  }
+
+  // Removing keys never lengthens a probe sequence.
+  for (size_t i = 1; i <= 4096; i += 3)
+    hash_map_erase(hash_map, UINT_TO_PTR(i));
+  EXPECT_LE(hash_map_longest_probe(hash_map), PROBE_LIMIT);
+
+  hash_map_free(hash_map);
+}
+
+// Prints the time per lookup with as many keys as the btif socket layers
+// usually have, and with many more. Only prints, wall clock time is not
+// reliable enough to test against.
+TEST_F(HashMapTest, test_benchmark_integer_key_lookup) {
+  const size_t lookups = 200000;
+  hash_map_t *hash_map = hash_map_new(256, hash_function_integer, NULL, NULL, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+
+  for (size_t num_keys = 1; num_keys <= 4096; num_keys++) {
+    hash_map_set(hash_map, UINT_TO_PTR(num_keys), UINT_TO_PTR(num_keys));
+    if (num_keys != 8 && num_keys != 256 && num_keys != 4096)
+      continue;
+
+    lookup_time_ns(hash_map, num_keys, lookups);  // Warm up.
+    uint64_t elapsed_ns = lookup_time_ns(hash_map, num_keys, lookups);
+    printf("%zu keys: %.1f ns per lookup\n", num_keys, (double)elapsed_ns / lookups);
+  }
+
+  hash_map_free(hash_map);
+}
+
+TEST_F(HashMapTest, test_grow) {
+  hash_map_t *hash_map = hash_map_new(5, hash_function_integer, NULL, NULL, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+  const size_t initial_buckets = hash_map_num_buckets(hash_map);
+
+  const size_t num_keys = 10000;
+  for (size_t i = 1; i <= num_keys; i++) {
+    EXPECT_TRUE(hash_map_set(hash_map, UINT_TO_PTR(i), UINT_TO_PTR(i)));
+    // Entries being moved to the grown table can still be found.
+    EXPECT_EQ(UINT_TO_PTR(i / 2 + 1), hash_map_get(hash_map, UINT_TO_PTR(i / 2 + 1)));
+  }
+  EXPECT_EQ(num_keys, hash_map_size(hash_map));
+  EXPECT_LT(initial_buckets, hash_map_num_buckets(hash_map));
+
+  for (size_t i = 1; i <= num_keys; i++)
+    EXPECT_EQ(UINT_TO_PTR(i), hash_map_get(hash_map, UINT_TO_PTR(i)));
+  EXPECT_FALSE(hash_map_has_key(hash_map, UINT_TO_PTR(num_keys + 1)));
+
+  hash_map_free(hash_map);
+}
+
+TEST_F(HashMapTest, test_set_and_erase_while_growing) {
+  hash_map_t *hash_map = hash_map_new(8, hash_function_integer, key_free_fn00, data_free_fn00, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+  g_data_free = 0;
+  g_key_free = 0;
+
+  // Fill the map right up to the point where it grows.
+  size_t num_keys = 0;
+  while (hash_map_num_buckets(hash_map) == 8)
+    hash_map_set(hash_map, UINT_TO_PTR(++num_keys), UINT_TO_PTR(1));
+
+  // Replace and erase entries that may still be in the old table.
+  for (size_t i = 1; i <= num_keys; i++)
+    hash_map_set(hash_map, UINT_TO_PTR(i), UINT_TO_PTR(2));
+  EXPECT_EQ(num_keys, g_data_free);
+  for (size_t i = 1; i <= num_keys; i += 2)
+    EXPECT_TRUE(hash_map_erase(hash_map, UINT_TO_PTR(i)));
+  EXPECT_FALSE(hash_map_erase(hash_map, UINT_TO_PTR(1)));
+
+  for (size_t i = 1; i <= num_keys; i++)
+    EXPECT_EQ((i % 2) ? NULL : UINT_TO_PTR(2), hash_map_get(hash_map, UINT_TO_PTR(i)));
+  EXPECT_EQ(num_keys / 2, hash_map_size(hash_map));
+
+  hash_map_clear(hash_map);
+  EXPECT_TRUE(hash_map_is_empty(hash_map));
+  EXPECT_EQ(num_keys * 2, g_data_free);
+  EXPECT_EQ(num_keys * 2, g_key_free);
+
+  hash_map_free(hash_map);
+}
+
+static hash_index_t hash_colliding(UNUSED_ATTR const void *key) {
+  return 42;
+}
+
+TEST_F(HashMapTest, test_erase_colliding) {
+  hash_map_t *hash_map = hash_map_new(64, hash_colliding, NULL, NULL, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+
+  const size_t num_keys = 32;
+  for (size_t i = 1; i <= num_keys; i++)
+    hash_map_set(hash_map, UINT_TO_PTR(i), UINT_TO_PTR(i));
+  // Every key shares the same home slot, so they line up behind each other.
+  EXPECT_EQ(num_keys, hash_map_longest_probe(hash_map));
+
+  for (size_t i = 1; i <= num_keys; i += 3)
+    EXPECT_TRUE(hash_map_erase(hash_map, UINT_TO_PTR(i)));
+
+  for (size_t i = 1; i <= num_keys; i++)
+    EXPECT_EQ((i % 3 == 1) ? NULL : UINT_TO_PTR(i), hash_map_get(hash_map, UINT_TO_PTR(i)));
+
+  hash_map_free(hash_map);
+}
+
+static bool count_entries_cb(hash_map_entry_t *hash_map_entry, void *context) {
+  EXPECT_EQ(hash_map_entry->key, hash_map_entry->data);
+  ++*(size_t *)context;
+  return true;
+}
+
+TEST_F(HashMapTest, test_iter_while_growing) {
+  hash_map_t *hash_map = hash_map_new(8, hash_function_integer, NULL, NULL, NULL);
+  ASSERT_TRUE(hash_map != NULL);
+
+  for (size_t num_keys = 1; num_keys <= 100; num_keys++) {
+    hash_map_set(hash_map, UINT_TO_PTR(num_keys), UINT_TO_PTR(num_keys));
+
+    size_t count = 0;
+    hash_map_foreach(hash_map, count_entries_cb, &count);
+    EXPECT_EQ(num_keys, count);
+  }
+
+  hash_map_free(hash_map);
+}
+
+static double elapsed_ns(const struct timespec &start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// Insert, lookup and erase throughput with pointer keys, as used by the
+// allocation tracker, starting from the default bucket count. Prints the
+// cost per operation.
+TEST_F(HashMapTest, test_benchmark_pointer_keys) {
+  const size_t sizes[] = { 16, 256, 4096 };
+  const size_t rounds = 20;
+
+  for (size_t s = 0; s < ARRAY_SIZE(sizes); s++) {
+    const size_t num_keys = sizes[s];
+    // The second half of |keys| is never inserted.
+    uint64_t *keys = new uint64_t[num_keys * 2];
+    double insert_ns = 0, lookup_ns = 0, miss_ns = 0, erase_ns = 0;
+
+    for (size_t round = 0; round < rounds; round++) {
+      hash_map_t *hash_map = hash_map_new(42, hash_function_pointer, NULL, NULL, NULL);
+      ASSERT_TRUE(hash_map != NULL);
+      struct timespec start;
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (size_t i = 0; i < num_keys; i++)
+        hash_map_set(hash_map, &keys[i], &keys[i]);
+      insert_ns += elapsed_ns(start);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (size_t i = 0; i < num_keys; i++)
+        EXPECT_EQ(&keys[i], hash_map_get(hash_map, &keys[i]));
+      lookup_ns += elapsed_ns(start);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (size_t i = 0; i < num_keys; i++)
+        EXPECT_FALSE(hash_map_has_key(hash_map, &keys[i] + num_keys));
+      miss_ns += elapsed_ns(start);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (size_t i = 0; i < num_keys; i++)
+        EXPECT_TRUE(hash_map_erase(hash_map, &keys[i]));
+      erase_ns += elapsed_ns(start);
+
+      EXPECT_TRUE(hash_map_is_empty(hash_map));
+      hash_map_free(hash_map);
+    }
+
+    const double ops = (double)num_keys * rounds;
+    printf("%zu keys: insert %.1f ns, lookup %.1f ns, miss %.1f ns, erase %.1f ns\n",
+           num_keys, insert_ns / ops, lookup_ns / ops, miss_ns / ops, erase_ns / ops);
+    delete[] keys;
+  }
+}
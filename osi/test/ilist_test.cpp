@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <time.h>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
+#include "osi/include/ilist.h"
+#include "osi/include/list.h"
+#include "osi/include/osi.h"
+}
+
+typedef struct {
+  int value;
+  ilist_node_t node;
+} element_t;
+
+class IlistTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    ILIST_INIT(&list, element_t, node);
+    for (size_t i = 0; i < ARRAY_SIZE(elements); ++i) {
+      elements[i].value = i;
+      elements[i].node.next = elements[i].node.prev = NULL;
+    }
+  }
+
+  // Returns the values of |list| front to back, walking it both ways.
+  std::vector<int> values() {
+    std::vector<int> forward;
+    ILIST_FOREACH(&list, element_t, element)
+      forward.push_back(element->value);
+
+    std::vector<int> backward;
+    for (ilist_node_t *node = list.head.prev; node != &list.head; node = node->prev)
+      backward.insert(backward.begin(), ((element_t *)((char *)node - list.offset))->value);
+
+    EXPECT_EQ(forward, backward);
+    EXPECT_EQ(forward.size(), ilist_length(&list));
+    return forward;
+  }
+
+  ilist_t list;
+  element_t elements[5];
+};
+
+static bool stop_at_value(void *data, void *context) {
+  return ((element_t *)data)->value != *(int *)context;
+}
+
+static bool remove_odd(void *data, void *context) {
+  element_t *element = (element_t *)data;
+  if (element->value % 2)
+    ilist_remove((ilist_t *)context, element);
+  return true;
+}
+
+static size_t g_free_count;
+static void count_free(void *data) {
+  EXPECT_TRUE(((element_t *)data)->node.next == NULL);
+  ++g_free_count;
+}
+
+TEST_F(IlistTest, test_empty_list) {
+  EXPECT_TRUE(ilist_is_empty(&list));
+  EXPECT_EQ(0U, ilist_length(&list));
+  EXPECT_TRUE(ilist_front(&list) == NULL);
+  EXPECT_TRUE(ilist_back(&list) == NULL);
+  EXPECT_TRUE(values().empty());
+}
+
+TEST_F(IlistTest, test_append_prepend) {
+  ilist_append(&list, &elements[1]);
+  ilist_append(&list, &elements[2]);
+  ilist_prepend(&list, &elements[0]);
+
+  EXPECT_FALSE(ilist_is_empty(&list));
+  EXPECT_EQ(&elements[0], ilist_front(&list));
+  EXPECT_EQ(&elements[2], ilist_back(&list));
+  EXPECT_EQ(&elements[1], ilist_next(&list, &elements[0]));
+  EXPECT_TRUE(ilist_next(&list, &elements[2]) == NULL);
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2 }), values());
+}
+
+TEST_F(IlistTest, test_insert_after) {
+  ilist_append(&list, &elements[0]);
+  ilist_append(&list, &elements[2]);
+  ilist_insert_after(&list, &elements[0], &elements[1]);
+  ilist_insert_after(&list, &elements[2], &elements[3]);
+
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3 }), values());
+}
+
+TEST_F(IlistTest, test_remove) {
+  for (int i = 0; i < 4; ++i)
+    ilist_append(&list, &elements[i]);
+
+  EXPECT_TRUE(ilist_remove(&list, &elements[1]));
+  EXPECT_TRUE(ilist_remove(&list, &elements[3]));
+  EXPECT_EQ(std::vector<int>({ 0, 2 }), values());
+
+  EXPECT_FALSE(ilist_is_linked(&list, &elements[1]));
+  EXPECT_FALSE(ilist_remove(&list, &elements[1]));
+  EXPECT_FALSE(ilist_remove(&list, &elements[4]));
+  EXPECT_TRUE(ilist_is_linked(&list, &elements[2]));
+
+  // A removed element can be added again.
+  ilist_prepend(&list, &elements[3]);
+  EXPECT_EQ(std::vector<int>({ 3, 0, 2 }), values());
+}
+
+TEST_F(IlistTest, test_foreach_safe_remove) {
+  for (int i = 0; i < 5; ++i)
+    ilist_append(&list, &elements[i]);
+
+  ILIST_FOREACH_SAFE(&list, element_t, element, next) {
+    if (element->value % 2 == 0)
+      ilist_remove(&list, element);
+  }
+  EXPECT_EQ(std::vector<int>({ 1, 3 }), values());
+}
+
+TEST_F(IlistTest, test_foreach_callback) {
+  for (int i = 0; i < 5; ++i)
+    ilist_append(&list, &elements[i]);
+
+  int value = 3;
+  EXPECT_EQ(&elements[3], ilist_foreach(&list, stop_at_value, &value));
+  value = 7;
+  EXPECT_TRUE(ilist_foreach(&list, stop_at_value, &value) == NULL);
+
+  EXPECT_TRUE(ilist_foreach(&list, remove_odd, &list) == NULL);
+  EXPECT_EQ(std::vector<int>({ 0, 2, 4 }), values());
+}
+
+TEST_F(IlistTest, test_clear) {
+  for (int i = 0; i < 5; ++i)
+    ilist_append(&list, &elements[i]);
+
+  g_free_count = 0;
+  ilist_clear(&list, count_free);
+  EXPECT_EQ(5U, g_free_count);
+  EXPECT_TRUE(ilist_is_empty(&list));
+
+  ilist_append(&list, &elements[0]);
+  ilist_clear(&list, NULL);
+  EXPECT_FALSE(ilist_is_linked(&list, &elements[0]));
+}
+
+TEST_F(IlistTest, test_append_does_not_allocate) {
+  for (int i = 0; i < 5; ++i)
+    ilist_append(&list, &elements[i]);
+  EXPECT_EQ(0U, allocation_tracker_expect_no_allocations());
+  ilist_clear(&list, NULL);
+
+  list_t *old_list = list_new(NULL);
+  for (int i = 0; i < 5; ++i)
+    list_append(old_list, &elements[i]);
+  EXPECT_GT(allocation_tracker_expect_no_allocations(), 0U);
+  list_free(old_list);
+}
+
+static double elapsed_ns(const struct timespec &start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static bool sum_values(void *data, void *context) {
+  *(int *)context += ((element_t *)data)->value;
+  return true;
+}
+
+// Append, iterate and remove from the middle with heap allocated elements,
+// list_t against ilist_t. Prints the time per element; unlike ilist_t,
+// list_t also allocates a node for every append.
+TEST_F(IlistTest, test_benchmark_against_list) {
+  const size_t num_elements = 1024;
+  const size_t rounds = 20;
+  element_t **heap = new element_t *[num_elements];
+  for (size_t i = 0; i < num_elements; ++i) {
+    heap[i] = (element_t *)osi_calloc(sizeof(element_t));
+    heap[i]->value = 1;
+  }
+  double list_ns[3] = { 0 }, ilist_ns[3] = { 0 };
+
+  for (size_t round = 0; round < rounds; ++round) {
+    struct timespec start;
+    int sum = 0;
+
+    list_t *old_list = list_new(NULL);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < num_elements; ++i)
+      list_append(old_list, heap[i]);
+    list_ns[0] += elapsed_ns(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    list_foreach(old_list, sum_values, &sum);
+    list_ns[1] += elapsed_ns(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < num_elements; ++i)
+      list_remove(old_list, heap[(i + num_elements / 2) % num_elements]);
+    list_ns[2] += elapsed_ns(start);
+    list_free(old_list);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < num_elements; ++i)
+      ilist_append(&list, heap[i]);
+    ilist_ns[0] += elapsed_ns(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ilist_foreach(&list, sum_values, &sum);
+    ilist_ns[1] += elapsed_ns(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < num_elements; ++i)
+      ilist_remove(&list, heap[(i + num_elements / 2) % num_elements]);
+    ilist_ns[2] += elapsed_ns(start);
+
+    EXPECT_EQ((int)(2 * num_elements), sum);
+    EXPECT_TRUE(ilist_is_empty(&list));
+  }
+
+  const double ops = (double)num_elements * rounds;
+  printf("list_t:  append %.1f ns, iterate %.1f ns, remove %.1f ns\n",
+         list_ns[0] / ops, list_ns[1] / ops, list_ns[2] / ops);
+  printf("ilist_t: append %.1f ns, iterate %.1f ns, remove %.1f ns\n",
+         ilist_ns[0] / ops, ilist_ns[1] / ops, ilist_ns[2] / ops);
+
+  for (size_t i = 0; i < num_elements; ++i)
+    osi_free(heap[i]);
+  delete[] heap;
+}
@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "osi/include/mutex.h"
+}
+
+class MutexTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    mutex_init();
+  }
+
+  virtual void TearDown() {
+    mutex_cleanup();
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(MutexTest, test_global_lock_recursive) {
+  mutex_global_lock();
+  mutex_global_lock();
+  mutex_global_unlock();
+  mutex_global_unlock();
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/profiler.h"
+}
+
+class ProfilerTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    profiler_set_enabled(true);
+  }
+
+  virtual void TearDown() {
+    profiler_set_enabled(false);
+    AllocationTestHarness::TearDown();
+  }
+
+  // Returns the output of |profiler_debug_dump|.
+  std::string dump() {
+    FILE *file = tmpfile();
+    profiler_debug_dump(fileno(file));
+    rewind(file);
+
+    std::string output;
+    char buffer[256];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      output.append(buffer, read);
+    fclose(file);
+    return output;
+  }
+};
+
+TEST_F(ProfilerTest, test_queue_record) {
+  profiler_queue_t *queue = profiler_queue_new("test_queue");
+
+  profiler_queue_record(queue, 10);
+  profiler_queue_record(queue, 30);
+
+  std::string output = dump();
+  EXPECT_NE(std::string::npos, output.find("test_queue"));
+  EXPECT_NE(std::string::npos, output.find(": 2 / 20 / 16 / 32 / 30"));
+
+  profiler_queue_free(queue);
+  EXPECT_EQ(std::string::npos, dump().find("test_queue"));
+}
+
+TEST_F(ProfilerTest, test_disabled_records_nothing) {
+  profiler_queue_t *queue = profiler_queue_new("test_queue");
+
+  profiler_set_enabled(false);
+  profiler_queue_record(queue, 10);
+  EXPECT_EQ(std::string::npos, dump().find("test_queue"));
+
+  profiler_queue_free(queue);
+}
+
+TEST_F(ProfilerTest, test_event_run_time) {
+  profiler_events_t *events = profiler_events_new("test_events");
+  profiler_scope_t scope;
+
+  for (int i = 0; i < 3; ++i) {
+    profiler_event_begin(events, 0x1234, &scope);
+    profiler_event_end(&scope);
+  }
+  profiler_event_begin(events, 0x0042, &scope);
+  profiler_event_end(&scope);
+
+  std::string output = dump();
+  size_t line = output.find("test_events 0x1234");
+  ASSERT_NE(std::string::npos, line);
+  EXPECT_EQ(0u, output.compare(output.find(':', line), 5, ": 3 /"));
+  EXPECT_NE(std::string::npos, output.find("test_events 0x0042"));
+
+  profiler_events_free(events);
+}
+
+TEST_F(ProfilerTest, test_event_null_table) {
+  profiler_scope_t scope;
+
+  profiler_event_begin(NULL, 1, &scope);
+  profiler_event_end(&scope);
+}
+
+TEST_F(ProfilerTest, test_fixed_queue_latency) {
+  fixed_queue_t *queue = fixed_queue_new(SIZE_MAX);
+  fixed_queue_profile(queue, "test_fixed_queue");
+  int elements[4];
+
+  // Not stamped while disabled, so not recorded either.
+  profiler_set_enabled(false);
+  fixed_queue_enqueue(queue, &elements[0]);
+  profiler_set_enabled(true);
+  for (int i = 1; i < 4; ++i)
+    fixed_queue_enqueue(queue, &elements[i]);
+
+  EXPECT_EQ(&elements[0], fixed_queue_dequeue(queue));
+  EXPECT_EQ(&elements[2], fixed_queue_try_remove_from_queue(queue, &elements[2]));
+  EXPECT_EQ(&elements[1], fixed_queue_dequeue(queue));
+  EXPECT_EQ(&elements[3], fixed_queue_try_dequeue(queue));
+
+  std::string output = dump();
+  size_t line = output.find("test_fixed_queue");
+  ASSERT_NE(std::string::npos, line);
+  EXPECT_EQ(0u, output.compare(output.find(':', line), 5, ": 2 /"));
+
+  fixed_queue_free(queue, NULL);
+  EXPECT_EQ(std::string::npos, dump().find("test_fixed_queue"));
+}
+
+TEST_F(ProfilerTest, test_thread_register) {
+  profiler_thread_register("test_thread");
+  EXPECT_NE(std::string::npos, dump().find("test_thread"));
+
+  profiler_thread_unregister();
+  EXPECT_EQ(std::string::npos, dump().find("test_thread"));
+}
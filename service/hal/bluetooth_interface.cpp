@@ -97,6 +97,13 @@ void RemoteDevicePropertiesCallback(bt_status_t status,
                                      properties));
 }
 
+void DeviceFoundCallback(int num_properties, bt_property_t* properties) {
+  shared_lock<shared_timed_mutex> lock(g_instance_lock);
+  VERIFY_INTERFACE_OR_RETURN();
+  VLOG(1) << "Device found - num_properties: " << num_properties;
+  FOR_EACH_BLUETOOTH_OBSERVER(DeviceFoundCallback(num_properties, properties));
+}
+
 void DiscoveryStateChangedCallback(bt_discovery_state_t state) {
   shared_lock<shared_timed_mutex> lock(g_instance_lock);
   VERIFY_INTERFACE_OR_RETURN();
@@ -198,7 +205,7 @@ bt_callbacks_t bt_callbacks = {
   AdapterStateChangedCallback,
   AdapterPropertiesCallback,
   RemoteDevicePropertiesCallback,
-  nullptr, /* device_found_cb */
+  DeviceFoundCallback,
   DiscoveryStateChangedCallback,
   PinRequestCallback,
   SSPRequestCallback,
@@ -346,6 +353,12 @@ void BluetoothInterface::Observer::RemoteDevicePropertiesCallback(
   // Do nothing.
 }
 
+void BluetoothInterface::Observer::DeviceFoundCallback(
+    int /* num_properties */,
+    bt_property_t* /* properties */) {
+  // Do nothing.
+}
+
 void BluetoothInterface::Observer::DiscoveryStateChangedCallback(
     bt_discovery_state_t /* state */) {
   // Do nothing.
@@ -162,3 +162,91 @@ LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
 LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
 
 include $(BUILD_STATIC_LIBRARY)
+
+# Bluetooth stack unit tests for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+                   $(LOCAL_PATH)/include \
+                   $(LOCAL_PATH)/a2dp \
+                   $(LOCAL_PATH)/avct \
+                   $(LOCAL_PATH)/avdt \
+                   $(LOCAL_PATH)/avrc \
+                   $(LOCAL_PATH)/btm \
+                   $(LOCAL_PATH)/gatt \
+                   $(LOCAL_PATH)/l2cap \
+                   $(LOCAL_PATH)/rfcomm \
+                   $(LOCAL_PATH)/../audio_a2dp_hw \
+                   $(LOCAL_PATH)/../bta/include \
+                   $(LOCAL_PATH)/../bta/sys \
+                   $(LOCAL_PATH)/../btcore/include \
+                   $(LOCAL_PATH)/../btif/co \
+                   $(LOCAL_PATH)/../btif/include \
+                   $(LOCAL_PATH)/../embdrv/sbc/encoder/include \
+                   $(LOCAL_PATH)/../hci/include \
+                   $(LOCAL_PATH)/../include \
+                   $(LOCAL_PATH)/../osi/test \
+                   $(LOCAL_PATH)/../udrv/include \
+                   $(LOCAL_PATH)/../utils/include \
+                   $(LOCAL_PATH)/../vnd/include \
+                   $(LOCAL_PATH)/../ \
+                   $(bluetooth_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../osi/test/AllocationTestHarness.cpp \
+    ../osi/test/AlarmTestHarness.cpp \
+    ../btif/co/bta_av_co.c \
+    ./avrc/avrc_api.c \
+    ./avrc/avrc_bld_ct.c \
+    ./avrc/avrc_bld_tg.c \
+    ./avrc/avrc_utils.c \
+    ./gatt/att_protocol.c \
+    ./gatt/gatt_api.c \
+    ./gatt/gatt_attr.c \
+    ./gatt/gatt_auth.c \
+    ./gatt/gatt_cl.c \
+    ./gatt/gatt_db.c \
+    ./gatt/gatt_main.c \
+    ./gatt/gatt_sr.c \
+    ./gatt/gatt_utils.c \
+    ./hcic/hciblecmds.c \
+    ./hcic/hcicmds.c \
+    ./l2cap/l2c_api.c \
+    ./l2cap/l2c_ble.c \
+    ./l2cap/l2c_csm.c \
+    ./l2cap/l2c_fcr.c \
+    ./l2cap/l2c_link.c \
+    ./l2cap/l2c_main.c \
+    ./l2cap/l2c_ucd.c \
+    ./l2cap/l2c_utils.c \
+    ./rfcomm/port_api.c \
+    ./rfcomm/port_rfc.c \
+    ./rfcomm/port_utils.c \
+    ./rfcomm/rfc_l2cap_if.c \
+    ./rfcomm/rfc_mx_fsm.c \
+    ./rfcomm/rfc_port_fsm.c \
+    ./rfcomm/rfc_port_if.c \
+    ./rfcomm/rfc_ts_frames.c \
+    ./rfcomm/rfc_utils.c \
+    ./test/L2capTestHarness.cpp \
+    ./test/avrc_bld_tg_test.cpp \
+    ./test/avrc_frag_test.cpp \
+    ./test/gatt_long_read_test.cpp \
+    ./test/gatt_mtu_test.cpp \
+    ./test/gatt_notify_test.cpp \
+    ./test/l2cap_le_coc_test.cpp \
+    ./test/port_lock_test.cpp \
+    ./test/port_write_test.cpp \
+    ./test/rfc_fcs_test.cpp
+
+LOCAL_MODULE := net_test_stack
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libdl
+LOCAL_STATIC_LIBRARIES := libosi libbtcore libcutils
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+
+include $(BUILD_NATIVE_TEST)
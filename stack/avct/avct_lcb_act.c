@@ -1061,6 +1061,7 @@ void avct_bcb_send_msg(tAVCT_BCB *p_bcb, tAVCT_LCB_EVT *p_data)
     else
     {
         AVCT_TRACE_ERROR("### bcb_send_msg, length incorrect");
+        osi_free(p_data->ul_msg.p_buf);
     }
 }
 #endif
@@ -156,42 +156,94 @@ static BT_HDR * avrc_copy_packet(BT_HDR *p_pkt, int rsp_pkt_len)
 #if (AVRC_METADATA_INCLUDED == TRUE)
 /******************************************************************************
 **
-** Function         avrc_prep_end_frag
+** Function         avrc_write_frag_hdr
 **
-** Description      This function prepares an end response fragment
+** Description      Writes the vendor dependent and metadata headers of a
+**                  response fragment at p_data.
 **
 ** Returns          Nothing.
 **
 ******************************************************************************/
-static void avrc_prep_end_frag(UINT8 handle)
+static void avrc_write_frag_hdr(UINT8 *p_data, UINT8 rsp_type, UINT8 pdu,
+                                UINT8 pkt_type, UINT16 param_len)
 {
-    tAVRC_FRAG_CB   *p_fcb;
-    BT_HDR  *p_pkt_new;
-    UINT8   *p_data, *p_orig_data;
-    UINT8   rsp_type;
-
-    AVRC_TRACE_DEBUG("avrc_prep_end_frag" );
-    p_fcb = &avrc_cb.fcb[handle];
+    *p_data++       = rsp_type;
+    *p_data++       = (AVRC_SUB_PANEL << AVRC_SUBTYPE_SHIFT);
+    *p_data++       = AVRC_OP_VENDOR;
+    AVRC_CO_ID_TO_BE_STREAM(p_data, AVRC_CO_METADATA);
+    *p_data++       = pdu;
+    *p_data++       = pkt_type;
+    UINT16_TO_BE_STREAM(p_data, param_len);
+}
 
+/******************************************************************************
+**
+** Function         avrc_next_frag
+**
+** Description      This function takes the next START or CONTINUE fragment
+**                  off the pending fragmented message.
+**
+**                  p_fmsg always holds the rest of the response with its
+**                  headers at the front, so the end fragment goes out of the
+**                  original buffer with a header prepended in place.  Every
+**                  other fragment only copies its own parameters; once the
+**                  leftover fits in the end fragment, the original buffer is
+**                  sent as this fragment and the shorter leftover is copied
+**                  out instead.
+**
+** Returns          The fragment to send.
+**
+******************************************************************************/
+static BT_HDR * avrc_next_frag(tAVRC_FRAG_CB *p_fcb, UINT8 pkt_type)
+{
+    BT_HDR  *p_msg = p_fcb->p_fmsg;
+    BT_HDR  *p_frag;
+    BT_HDR  *p_end;
+    UINT8   *p_data = avrc_get_data_ptr(p_msg);
     /* The response type of the end fragment should be the same as the the PDU of "End Fragment
     ** Response" Errata: https://www.bluetooth.org/errata/errata_view.cfm?errata_id=4383
     */
-    p_orig_data = ((UINT8 *)(p_fcb->p_fmsg + 1) + p_fcb->p_fmsg->offset);
-    rsp_type = ((*p_orig_data) & AVRC_CTYPE_MASK);
+    UINT8   rsp_type = (*p_data) & AVRC_CTYPE_MASK;
+    UINT16  rem_len = p_msg->len - AVRC_MAX_CTRL_DATA_LEN;
 
-    p_pkt_new           = p_fcb->p_fmsg;
-    p_pkt_new->len      -= (AVRC_MAX_CTRL_DATA_LEN - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE);
-    p_pkt_new->offset   += (AVRC_MAX_CTRL_DATA_LEN - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE);
-    p_data = (UINT8 *)(p_pkt_new+1) + p_pkt_new->offset;
-    *p_data++       = rsp_type;
-    *p_data++       = (AVRC_SUB_PANEL << AVRC_SUBTYPE_SHIFT);
-    *p_data++       = AVRC_OP_VENDOR;
-    AVRC_CO_ID_TO_BE_STREAM(p_data, AVRC_CO_METADATA);
-    *p_data++       = p_fcb->frag_pdu;
-    *p_data++       = AVRC_PKT_END;
+    if (rem_len <= AVRC_FRAG_PARAM_LEN)
+    {
+        /* copy the leftover into the end fragment, send the original buffer now */
+        p_end = (BT_HDR *)osi_malloc(BT_HDR_SIZE + AVCT_MSG_OFFSET + AVRC_VENDOR_HDR_SIZE +
+                                     AVRC_MIN_META_HDR_SIZE + rem_len);
+        p_end->offset = AVCT_MSG_OFFSET;
+        p_end->len = AVRC_VENDOR_HDR_SIZE + AVRC_MIN_META_HDR_SIZE + rem_len;
+        p_end->layer_specific = p_msg->layer_specific;
+        p_end->event = p_msg->event;
+        p_data = avrc_get_data_ptr(p_end);
+        avrc_write_frag_hdr(p_data, rsp_type, p_fcb->frag_pdu, AVRC_PKT_END, rem_len);
+        memcpy(p_data + AVRC_VENDOR_HDR_SIZE + AVRC_MIN_META_HDR_SIZE,
+               avrc_get_data_ptr(p_msg) + AVRC_MAX_CTRL_DATA_LEN, rem_len);
+
+        p_frag = p_msg;
+        p_frag->len = AVRC_MAX_CTRL_DATA_LEN;
+        p_fcb->p_fmsg = p_end;
+    }
+    else
+    {
+        p_frag = (BT_HDR *)osi_malloc(BT_HDR_SIZE + AVCT_MSG_OFFSET + AVRC_MAX_CTRL_DATA_LEN);
+        p_frag->offset = AVCT_MSG_OFFSET;
+        p_frag->len = AVRC_MAX_CTRL_DATA_LEN;
+        p_frag->layer_specific = p_msg->layer_specific;
+        p_frag->event = p_msg->event;
+        memcpy(avrc_get_data_ptr(p_frag) + AVRC_VENDOR_HDR_SIZE + AVRC_MIN_META_HDR_SIZE,
+               p_data + AVRC_VENDOR_HDR_SIZE + AVRC_MIN_META_HDR_SIZE, AVRC_FRAG_PARAM_LEN);
+
+        /* prepare the left over as an end fragment, reusing the consumed octets */
+        p_msg->offset += AVRC_FRAG_PARAM_LEN;
+        p_msg->len    -= AVRC_FRAG_PARAM_LEN;
+        avrc_write_frag_hdr(avrc_get_data_ptr(p_msg), rsp_type, p_fcb->frag_pdu, AVRC_PKT_END,
+                            p_msg->len - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE);
+    }
 
-    /* 4=pdu, pkt_type & len */
-    UINT16_TO_BE_STREAM(p_data, (p_pkt_new->len - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE));
+    avrc_write_frag_hdr(avrc_get_data_ptr(p_frag), rsp_type, p_fcb->frag_pdu, pkt_type,
+                        AVRC_FRAG_PARAM_LEN);
+    return p_frag;
 }
 
 /******************************************************************************
@@ -206,8 +258,7 @@ static void avrc_prep_end_frag(UINT8 handle)
 static void avrc_send_continue_frag(UINT8 handle, UINT8 label)
 {
     tAVRC_FRAG_CB   *p_fcb;
-    BT_HDR  *p_pkt_old, *p_pkt;
-    UINT8   *p_old, *p_data;
+    BT_HDR  *p_pkt;
     UINT8   cr = AVCT_RSP;
 
     p_fcb = &avrc_cb.fcb[handle];
@@ -216,25 +267,7 @@ static void avrc_send_continue_frag(UINT8 handle, UINT8 label)
     AVRC_TRACE_DEBUG("%s handle = %u label = %u len = %d",
                      __func__, handle, label, p_pkt->len);
     if (p_pkt->len > AVRC_MAX_CTRL_DATA_LEN) {
-        int offset_len = MAX(AVCT_MSG_OFFSET, p_pkt->offset);
-        p_pkt_old = p_fcb->p_fmsg;
-        p_pkt = (BT_HDR *)osi_malloc(AVRC_PACKET_LEN + offset_len + BT_HDR_SIZE);
-        p_pkt->len = AVRC_MAX_CTRL_DATA_LEN;
-        p_pkt->offset = AVCT_MSG_OFFSET;
-        p_pkt->layer_specific = p_pkt_old->layer_specific;
-        p_pkt->event = p_pkt_old->event;
-        p_old = (UINT8 *)(p_pkt_old + 1) + p_pkt_old->offset;
-        p_data = (UINT8 *)(p_pkt + 1) + p_pkt->offset;
-        memcpy (p_data, p_old, AVRC_MAX_CTRL_DATA_LEN);
-        /* use AVRC continue packet type */
-        p_data += AVRC_VENDOR_HDR_SIZE;
-        p_data++; /* pdu */
-        *p_data++ = AVRC_PKT_CONTINUE;
-        /* 4=pdu, pkt_type & len */
-        UINT16_TO_BE_STREAM(p_data, (AVRC_MAX_CTRL_DATA_LEN - AVRC_VENDOR_HDR_SIZE - 4));
-
-        /* prepare the left over for as an end fragment */
-        avrc_prep_end_frag (handle);
+        p_pkt = avrc_next_frag(p_fcb, AVRC_PKT_CONTINUE);
     } else {
         /* end fragment. clean the control block */
         p_fcb->frag_enabled = FALSE;
@@ -1012,7 +1045,6 @@ UINT16 AVRC_MsgReq (UINT8 handle, UINT8 label, UINT8 ctype, BT_HDR *p_pkt)
     BOOLEAN chk_frag = TRUE;
     UINT8   *p_start = NULL;
     tAVRC_FRAG_CB   *p_fcb;
-    UINT16  len;
 
     if (!p_pkt)
         return AVRC_BAD_PARAM;
@@ -1063,34 +1095,13 @@ UINT16 AVRC_MsgReq (UINT8 handle, UINT8 label, UINT8 ctype, BT_HDR *p_pkt)
     {
         if (p_pkt->len > AVRC_MAX_CTRL_DATA_LEN)
         {
-            int offset_len = MAX(AVCT_MSG_OFFSET, p_pkt->offset);
-            BT_HDR *p_pkt_new =
-                (BT_HDR *)osi_malloc(AVRC_PACKET_LEN + offset_len + BT_HDR_SIZE);
             if (p_start != NULL) {
                 p_fcb->frag_enabled = TRUE;
                 p_fcb->p_fmsg       = p_pkt;
                 p_fcb->frag_pdu     = *p_start;
-                p_pkt               = p_pkt_new;
-                p_pkt_new           = p_fcb->p_fmsg;
-                p_pkt->len          = AVRC_MAX_CTRL_DATA_LEN;
-                p_pkt->offset       = p_pkt_new->offset;
-                p_pkt->layer_specific = p_pkt_new->layer_specific;
-                p_pkt->event = p_pkt_new->event;
-                p_data = (UINT8 *)(p_pkt+1) + p_pkt->offset;
-                p_start -= AVRC_VENDOR_HDR_SIZE;
-                memcpy (p_data, p_start, AVRC_MAX_CTRL_DATA_LEN);
-                /* use AVRC start packet type */
-                p_data += AVRC_VENDOR_HDR_SIZE;
-                p_data++; /* pdu */
-                *p_data++ = AVRC_PKT_START;
-                /* 4 pdu, pkt_type & len */
-                len = (AVRC_MAX_CTRL_DATA_LEN - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE);
-                UINT16_TO_BE_STREAM(p_data, len);
-
-                /* prepare the left over for as an end fragment */
-                avrc_prep_end_frag (handle);
-                AVRC_TRACE_DEBUG ("%s p_pkt len:%d/%d, next len:%d", __func__,
-                                  p_pkt->len, len, p_fcb->p_fmsg->len );
+                p_pkt = avrc_next_frag(p_fcb, AVRC_PKT_START);
+                AVRC_TRACE_DEBUG ("%s p_pkt len:%d, next len:%d", __func__,
+                                  p_pkt->len, p_fcb->p_fmsg->len );
             } else {
                 /* TODO: Is this "else" block valid? Remove it? */
                 AVRC_TRACE_ERROR ("AVRC_MsgReq no buffers for fragmentation" );
@@ -22,6 +22,7 @@
 #include "avrc_defs.h"
 #include "avrc_int.h"
 #include "bt_utils.h"
+#include "l2cdefs.h"
 
 /*****************************************************************************
 **  Global data
@@ -303,10 +304,8 @@ static tAVRC_STS avrc_bld_set_app_setting_value_rsp (tAVRC_RSP *p_rsp, BT_HDR *p
 static tAVRC_STS avrc_bld_app_setting_text_rsp (tAVRC_GET_APP_ATTR_TXT_RSP *p_rsp, BT_HDR *p_pkt)
 {
     UINT8   *p_data, *p_start, *p_len, *p_count;
-    UINT16  len, len_left;
+    UINT16  len;
     UINT8   xx;
-    tAVRC_STS   sts = AVRC_STS_NO_ERROR;
-    UINT8       num_added = 0;
 
     if (!p_rsp->p_attrs)
     {
@@ -318,11 +317,9 @@ static tAVRC_STS avrc_bld_app_setting_text_rsp (tAVRC_GET_APP_ATTR_TXT_RSP *p_rs
     p_data = p_len = p_start + 2; /* pdu + rsvd */
 
     /*
-     * NOTE: The buffer is allocated within avrc_bld_init_rsp_buffer(), and is
-     * always of size BT_DEFAULT_BUFFER_SIZE.
+     * NOTE: AVRC_BldResponse() sizes the buffer with avrc_bld_rsp_len(), which
+     * counts every attribute, so there is always room for all of them.
      */
-    len_left = BT_DEFAULT_BUFFER_SIZE - BT_HDR_SIZE - p_pkt->offset - p_pkt->len;
-
     BE_STREAM_TO_UINT16(len, p_data);
     p_count = p_data;
 
@@ -338,14 +335,6 @@ static tAVRC_STS avrc_bld_app_setting_text_rsp (tAVRC_GET_APP_ATTR_TXT_RSP *p_rs
 
     for (xx=0; xx<p_rsp->num_attr; xx++)
     {
-        if  (len_left < (p_rsp->p_attrs[xx].str_len + 4))
-        {
-            AVRC_TRACE_ERROR("%s out of room (str_len:%d, left:%d)",
-                             __func__, xx, p_rsp->p_attrs[xx].str_len, len_left);
-            p_rsp->num_attr = num_added;
-            sts = AVRC_STS_INTERNAL_ERR;
-            break;
-        }
         if ( !p_rsp->p_attrs[xx].str_len || !p_rsp->p_attrs[xx].p_str )
         {
             AVRC_TRACE_ERROR("%s NULL attr text[%d]", __func__, xx);
@@ -356,13 +345,12 @@ static tAVRC_STS avrc_bld_app_setting_text_rsp (tAVRC_GET_APP_ATTR_TXT_RSP *p_rs
         UINT8_TO_BE_STREAM(p_data, p_rsp->p_attrs[xx].str_len);
         ARRAY_TO_BE_STREAM(p_data, p_rsp->p_attrs[xx].p_str, p_rsp->p_attrs[xx].str_len);
         (*p_count)++;
-        num_added++;
     }
     len = p_data - p_count;
     UINT16_TO_BE_STREAM(p_len, len);
     p_pkt->len = (p_data - p_start);
 
-    return sts;
+    return AVRC_STS_NO_ERROR;
 }
 
 /*******************************************************************************
@@ -1118,6 +1106,120 @@ static tAVRC_STS avrc_bld_browse_rejected_rsp (tAVRC_RSP *p_rsp, BT_HDR *p_pkt)
     return AVRC_STS_NO_ERROR;
 }
 
+/* The browse channel runs in ERTM mode, where L2CAP writes the FCS right
+** after the payload of the buffer it is given. */
+#define AVRC_BLD_RSP_TAILROOM   L2CAP_FCS_LEN
+
+/* Smallest response buffer; every buffer is a power of two from here on */
+#define AVRC_BLD_MIN_BUF_SIZE   64
+
+/*******************************************************************************
+**
+** Function         avrc_bld_rsp_buf_size
+**
+** Description      Response buffers are allocated in power of two sizes, so
+**                  that the capacity of a buffer passed back in to append to
+**                  is known from the octets it holds.
+**
+** Returns          The allocation size for |needed| octets.
+**
+*******************************************************************************/
+static UINT32 avrc_bld_rsp_buf_size(UINT32 needed)
+{
+    UINT32 size = AVRC_BLD_MIN_BUF_SIZE;
+
+    while (size < needed)
+        size <<= 1;
+    return size;
+}
+
+/*******************************************************************************
+**
+** Function         avrc_bld_alloc_rsp_buffer
+**
+** Description      Allocates a response buffer with room for |len| octets
+**                  after |offset| and for the FCS after those.
+**
+** Returns          The buffer.
+**
+*******************************************************************************/
+static BT_HDR *avrc_bld_alloc_rsp_buffer(UINT16 offset, UINT32 len)
+{
+    return (BT_HDR *)osi_malloc(avrc_bld_rsp_buf_size(BT_HDR_SIZE + offset + len +
+                                                      AVRC_BLD_RSP_TAILROOM));
+}
+
+/*******************************************************************************
+**
+** Function         avrc_bld_rsp_len
+**
+** Description      This function computes how many octets the response
+**                  builders write after the buffer offset for this response.
+**
+** Returns          The encoded length of the response.
+**
+*******************************************************************************/
+static UINT32 avrc_bld_rsp_len(tAVRC_RESPONSE *p_rsp, UINT8 opcode)
+{
+    UINT32 len = AVRC_MIN_META_HDR_SIZE;
+    UINT8  xx;
+
+    if (opcode == AVRC_OP_PASS_THRU)
+        return AVRC_FIXED_RSP_LEN;
+
+    if (p_rsp->rsp.status != AVRC_STS_NO_ERROR)
+        return len + 1;
+
+    switch (p_rsp->pdu)
+    {
+    case AVRC_PDU_GET_CAPABILITIES:
+        len += 2 + p_rsp->get_caps.count *
+            ((p_rsp->get_caps.capability_id == AVRC_CAP_COMPANY_ID) ? 3 : 1);
+        break;
+
+    case AVRC_PDU_LIST_PLAYER_APP_ATTR:
+        len += 1 + p_rsp->list_app_attr.num_attr;
+        break;
+
+    case AVRC_PDU_LIST_PLAYER_APP_VALUES:
+        len += 1 + p_rsp->list_app_values.num_val;
+        break;
+
+    case AVRC_PDU_GET_CUR_PLAYER_APP_VALUE:
+        len += 1 + 2 * p_rsp->get_cur_app_val.num_val;
+        break;
+
+    case AVRC_PDU_GET_PLAYER_APP_ATTR_TEXT:
+    case AVRC_PDU_GET_PLAYER_APP_VALUE_TEXT:
+        len += 1;
+        for (xx = 0; xx < p_rsp->get_app_attr_txt.num_attr; xx++)
+            len += 4 + p_rsp->get_app_attr_txt.p_attrs[xx].str_len;
+        break;
+
+    case AVRC_PDU_GET_ELEMENT_ATTR:
+        len += 1;
+        for (xx = 0; xx < p_rsp->get_elem_attrs.num_attr; xx++)
+        {
+            /* attr_id(4), charset_id(2), str_len(2) */
+            len += 8;
+            if (p_rsp->get_elem_attrs.p_attrs[xx].name.p_str)
+                len += p_rsp->get_elem_attrs.p_attrs[xx].name.str_len;
+        }
+        break;
+
+    case AVRC_PDU_REGISTER_NOTIFICATION:
+        /* event_id, then at most the player application settings */
+        len += 2 + 2 * AVRC_MAX_APP_SETTINGS;
+        break;
+
+    default:
+        len = AVRC_FIXED_RSP_LEN;
+        break;
+    }
+
+    return (len < AVRC_FIXED_RSP_LEN) ? AVRC_FIXED_RSP_LEN : len;
+}
+
 /*******************************************************************************
 **
 ** Function         avrc_bld_init_rsp_buffer
@@ -1153,8 +1255,8 @@ static BT_HDR *avrc_bld_init_rsp_buffer(tAVRC_RESPONSE *p_rsp)
         break;
     }
 
-    /* allocate and initialize the buffer */
-    BT_HDR *p_pkt = (BT_HDR *)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    /* allocate and initialize a buffer that fits the encoded response */
+    BT_HDR *p_pkt = avrc_bld_alloc_rsp_buffer(offset, avrc_bld_rsp_len(p_rsp, opcode));
     UINT8 *p_data, *p_start;
 
     p_pkt->layer_specific = chnl;
@@ -1183,6 +1285,36 @@ static BT_HDR *avrc_bld_init_rsp_buffer(tAVRC_RESPONSE *p_rsp)
     return p_pkt;
 }
 
+/*******************************************************************************
+**
+** Function         avrc_bld_grow_rsp_buffer
+**
+** Description      Makes room for |extra| more octets in a buffer from
+**                  avrc_bld_alloc_rsp_buffer that a caller passed back in to
+**                  append another response to. The buffer is kept while its
+**                  slack is enough, otherwise it moves to a buffer of the
+**                  next power of two that fits, so repeated appends copy
+**                  each octet a bounded number of times.
+**
+** Returns          The buffer to build into. If it moved, the old buffer is
+**                  freed.
+**
+*******************************************************************************/
+static BT_HDR *avrc_bld_grow_rsp_buffer(BT_HDR *p_pkt, UINT32 extra)
+{
+    UINT32 used = BT_HDR_SIZE + p_pkt->offset + p_pkt->len;
+    UINT32 needed = used + extra + AVRC_BLD_RSP_TAILROOM;
+
+    /* The buffer was sized for at least what it holds plus the tailroom */
+    if (needed <= avrc_bld_rsp_buf_size(used + AVRC_BLD_RSP_TAILROOM))
+        return p_pkt;
+
+    BT_HDR *p_new = (BT_HDR *)osi_malloc(avrc_bld_rsp_buf_size(needed));
+    memcpy(p_new, p_pkt, used);
+    osi_free(p_pkt);
+    return p_new;
+}
+
 /*******************************************************************************
 **
 ** Function         AVRC_BldResponse
@@ -1217,6 +1349,11 @@ tAVRC_STS AVRC_BldResponse( UINT8 handle, tAVRC_RESPONSE *p_rsp, BT_HDR **pp_pkt
         }
         alloc = TRUE;
     }
+    else
+    {
+        *pp_pkt = avrc_bld_grow_rsp_buffer(*pp_pkt,
+                                           avrc_bld_rsp_len(p_rsp, (*pp_pkt)->event));
+    }
     status = AVRC_STS_NO_ERROR;
     p_pkt = *pp_pkt;
 
@@ -1311,6 +1448,76 @@ tAVRC_STS AVRC_BldResponse( UINT8 handle, tAVRC_RESPONSE *p_rsp, BT_HDR **pp_pkt
     return status;
 }
 
+/*******************************************************************************
+**
+** Function         avrc_bld_browse_rsp_len
+**
+** Description      This function computes how many octets the browse response
+**                  builders write after the buffer offset for this response.
+**
+** Returns          The encoded length of the response.
+**
+*******************************************************************************/
+static UINT32 avrc_bld_browse_rsp_len(tAVRC_RESPONSE *p_rsp)
+{
+    /* pdu(1), param len(2), status(1) */
+    UINT32 len = 4;
+    UINT16 xx, yy;
+    tAVRC_ITEM *p_item;
+
+    if (p_rsp->rsp.status != AVRC_STS_NO_ERROR)
+        return len;
+
+    switch (p_rsp->pdu)
+    {
+    case AVRC_PDU_GET_FOLDER_ITEMS:
+        /* uid_counter(2), num_items(2), item_type(1) and item_len(2) per item */
+        len += 4;
+        for (xx = 0; xx < p_rsp->get_items.item_count; xx++)
+        {
+            p_item = &p_rsp->get_items.p_item_list[xx];
+            len += 3;
+            switch (p_item->item_type)
+            {
+            case AVRC_ITEM_PLAYER:
+                len += 28 + p_item->u.player.name.str_len;
+                break;
+            case AVRC_ITEM_FOLDER:
+                len += 14 + p_item->u.folder.name.str_len;
+                break;
+            case AVRC_ITEM_MEDIA:
+                len += 14 + p_item->u.media.name.str_len;
+                for (yy = 0; yy < p_item->u.media.attr_count; yy++)
+                    len += 8 + p_item->u.media.p_attr_list[yy].name.str_len;
+                break;
+            }
+        }
+        break;
+
+    case AVRC_PDU_SET_BROWSED_PLAYER:
+        len += 9;
+        for (xx = 0; xx < p_rsp->br_player.folder_depth; xx++)
+            len += 2 + p_rsp->br_player.p_folders[xx].str_len;
+        break;
+
+    case AVRC_PDU_CHANGE_PATH:
+        len += 4;
+        break;
+
+    case AVRC_PDU_GET_ITEM_ATTRIBUTES:
+        len += 1;
+        for (xx = 0; xx < p_rsp->get_attrs.attr_count; xx++)
+            len += 8 + p_rsp->get_attrs.p_attr_list[xx].name.str_len;
+        break;
+
+    case AVRC_PDU_GET_TOTAL_NUMBER_OF_ITEMS:
+        len += 6;
+        break;
+    }
+
+    return len;
+}
+
 /*******************************************************************************
 **
 ** Function         avrc_bld_init_browse_rsp_buffer
@@ -1325,12 +1532,11 @@ static BT_HDR *avrc_bld_init_browse_rsp_buffer(tAVRC_RESPONSE *p_rsp)
 {
     UINT16 offset = AVCT_BROWSE_OFFSET;
     UINT16 chnl = AVCT_DATA_BROWSE;
-    UINT16 len  = BT_DEFAULT_BUFFER_SIZE;
     BT_HDR *p_pkt = NULL;
 
     AVRC_TRACE_API("avrc_bld_init_browse_rsp_buffer ");
     /* allocate and initialize the buffer */
-    p_pkt = (BT_HDR *)osi_malloc(len);
+    p_pkt = avrc_bld_alloc_rsp_buffer(offset, avrc_bld_browse_rsp_len(p_rsp));
 
     if (p_pkt != NULL)
     {
@@ -1378,6 +1584,10 @@ tAVRC_STS AVRC_BldBrowseResponse( UINT8 handle, tAVRC_RESPONSE *p_rsp, BT_HDR **
         }
         alloc = TRUE;
     }
+    else
+    {
+        *pp_pkt = avrc_bld_grow_rsp_buffer(*pp_pkt, avrc_bld_browse_rsp_len(p_rsp));
+    }
     status = AVRC_STS_NO_ERROR;
     p_pkt = *pp_pkt;
 
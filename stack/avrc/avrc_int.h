@@ -97,6 +97,12 @@
 
 #define AVRC_MAX_CTRL_DATA_LEN      (AVRC_PACKET_LEN)
 
+/* room for every fixed size response built by AVRC_BldResponse */
+#define AVRC_FIXED_RSP_LEN          16
+
+/* parameter octets carried by a START or CONTINUE response fragment */
+#define AVRC_FRAG_PARAM_LEN         (AVRC_MAX_CTRL_DATA_LEN - AVRC_VENDOR_HDR_SIZE - AVRC_MIN_META_HDR_SIZE)
+
 /*****************************************************************************
 **  Type definitions
 *****************************************************************************/
@@ -1041,6 +1041,7 @@ void btm_read_remote_version_complete (UINT8 *p)
 #if (defined(BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
             if (p_acl_cb->transport == BT_TRANSPORT_LE){
                 l2cble_notify_le_connection (p_acl_cb->remote_addr);
+                l2cble_use_max_data_length (p_acl_cb->remote_addr);
             }
 #endif  // (defined(BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
                 BTM_TRACE_WARNING ("btm_read_remote_version_complete: BDA: %02x-%02x-%02x-%02x-%02x-%02x",
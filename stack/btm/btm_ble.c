@@ -77,13 +77,13 @@ BOOLEAN BTM_SecAddBleDevice (BD_ADDR bd_addr, BD_NAME bd_name, tBT_DEVICE_TYPE d
     tBTM_SEC_DEV_REC  *p_dev_rec = btm_find_dev(bd_addr);
 
     if (!p_dev_rec) {
-        if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
+        if (ilist_length(&btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
             BTM_TRACE_ERROR("%s: %d max devices reached!", __func__, BTM_SEC_MAX_DEVICE_RECORDS);
             return FALSE;
         }
 
         p_dev_rec = osi_calloc(sizeof(tBTM_SEC_DEV_REC));
-        list_append(btm_cb.sec_dev_rec, p_dev_rec);
+        ilist_append(&btm_cb.sec_dev_rec, p_dev_rec);
 
         memcpy(p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
         p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
@@ -857,7 +857,7 @@ tBTM_STATUS BTM_SetBleDataLength(BD_ADDR bd_addr, UINT16 tx_pdu_length)
         return BTM_ILLEGAL_VALUE;
     }
 
-    if (!HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
+    if (p_acl != NULL && !HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
     {
         BTM_TRACE_ERROR("%s failed, peer does not support request", __FUNCTION__);
         return BTM_ILLEGAL_VALUE;
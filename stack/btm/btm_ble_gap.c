@@ -1000,10 +1000,9 @@ static UINT8 btm_set_conn_mode_adv_init_addr(tBTM_BLE_INQ_CB *p_cb,
     if ((btm_cb.ble_ctr_cb.privacy_mode ==  BTM_PRIVACY_1_2 && p_cb->afp != AP_SCAN_CONN_ALL) ||
         btm_cb.ble_ctr_cb.privacy_mode ==  BTM_PRIVACY_MIXED)
     {
-        list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_resolving_list_bit_set, NULL);
-        if (n) {
+        tBTM_SEC_DEV_REC *p_dev_rec = ilist_foreach(&btm_cb.sec_dev_rec, is_resolving_list_bit_set, NULL);
+        if (p_dev_rec) {
             /* if enhanced privacy is required, set Identity address and matching IRK peer */
-            tBTM_SEC_DEV_REC  *p_dev_rec = list_node(n);
             memcpy(p_peer_addr_ptr, p_dev_rec->ble.static_addr, BD_ADDR_LEN);
             *p_peer_addr_type = p_dev_rec->ble.static_addr_type;
 
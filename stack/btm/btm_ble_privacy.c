@@ -263,7 +263,7 @@ void btm_ble_clear_resolving_list_complete(UINT8 *p, UINT16 evt_len)
         BTM_TRACE_DEBUG("%s resolving_list_avail_size=%d",
                         __func__, btm_cb.ble_ctr_cb.resolving_list_avail_size);
 
-        list_foreach(btm_cb.sec_dev_rec, clear_resolving_list_bit, NULL);
+        ilist_foreach(&btm_cb.sec_dev_rec, clear_resolving_list_bit, NULL);
     }
 }
 
@@ -966,8 +966,7 @@ void btm_ble_enable_resolving_list_for_platform (UINT8 rl_mask)
         return;
     }
 
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_on_resolving_list, NULL);
-    if (n)
+    if (ilist_foreach(&btm_cb.sec_dev_rec, is_on_resolving_list, NULL))
         btm_ble_enable_resolving_list(rl_mask);
     else
         btm_ble_disable_resolving_list(rl_mask, TRUE);
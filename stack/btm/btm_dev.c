@@ -71,14 +71,14 @@ BOOLEAN BTM_SecAddDevice (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name,
     p_dev_rec = btm_find_dev (bd_addr);
     if (!p_dev_rec)
     {
-        if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
+        if (ilist_length(&btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
             BTM_TRACE_DEBUG("%s: Max devices reached!", __func__);
             return FALSE;
         }
 
         BTM_TRACE_DEBUG ("%s: allocate a new dev rec", __func__);
         p_dev_rec = osi_calloc(sizeof(tBTM_SEC_DEV_REC));
-        list_append(btm_cb.sec_dev_rec, p_dev_rec);
+        ilist_append(&btm_cb.sec_dev_rec, p_dev_rec);
 
         memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
         p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
@@ -244,12 +244,12 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
     tBTM_INQ_INFO    *p_inq_info;
     BTM_TRACE_EVENT ("btm_sec_alloc_dev");
 
-    if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
+    if (ilist_length(&btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
         p_dev_rec = btm_find_oldest_dev();
     } else {
         BTM_TRACE_DEBUG ("allocate a new dev rec");
         p_dev_rec = osi_calloc(sizeof(tBTM_SEC_DEV_REC));
-        list_append(btm_cb.sec_dev_rec, p_dev_rec);
+        ilist_append(&btm_cb.sec_dev_rec, p_dev_rec);
     }
 
     p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;           /* Default value */
@@ -390,11 +390,7 @@ bool is_handle_equal(void *data, void *context)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_dev_by_handle (UINT16 handle)
 {
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-    if (n)
-        return list_node(n);
-
-    return NULL;
+    return ilist_foreach(&btm_cb.sec_dev_rec, is_handle_equal, &handle);
 }
 
 bool is_address_equal(void *data, void *context)
@@ -430,11 +426,7 @@ tBTM_SEC_DEV_REC *btm_find_dev(BD_ADDR bd_addr)
     if (!bd_addr)
         return NULL;
 
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_address_equal, bd_addr);
-    if (n)
-        return list_node(n);
-
-    return NULL;
+    return ilist_foreach(&btm_cb.sec_dev_rec, is_address_equal, bd_addr);
 }
 
 /*******************************************************************************
@@ -453,16 +445,14 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
 
     BTM_TRACE_DEBUG("%s", __func__);
 
-    list_node_t *end = list_end(btm_cb.sec_dev_rec);
-    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
-        tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
-
+    ILIST_FOREACH_SAFE(&btm_cb.sec_dev_rec, tBTM_SEC_DEV_REC, p_dev_rec, p_next) {
         if (p_target_rec == p_dev_rec)
             continue;
 
         if (!memcmp (p_dev_rec->bd_addr, p_target_rec->bd_addr, BD_ADDR_LEN))
         {
             memcpy(p_target_rec, p_dev_rec, sizeof(tBTM_SEC_DEV_REC));
+            p_target_rec->list_node = temp_rec.list_node;
             p_target_rec->ble = temp_rec.ble;
             p_target_rec->ble_hci_handle = temp_rec.ble_hci_handle;
             p_target_rec->enc_key_size = temp_rec.enc_key_size;
@@ -475,9 +465,9 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
             p_target_rec->bond_type = temp_rec.bond_type;
 
             /* remove the combined record */
-            list_remove(btm_cb.sec_dev_rec, p_dev_rec);
-
-            p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;
+            ilist_remove(&btm_cb.sec_dev_rec, p_dev_rec);
+            osi_free(p_dev_rec);
+            continue;
         }
 
         /* an RPA device entry is a duplicate of the target record */
@@ -489,9 +479,8 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
                 p_target_rec->device_type |= p_dev_rec->device_type;
 
                 /* remove the combined record */
-                list_remove(btm_cb.sec_dev_rec, p_dev_rec);
-
-                p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;
+                ilist_remove(&btm_cb.sec_dev_rec, p_dev_rec);
+                osi_free(p_dev_rec);
             }
         }
     }
@@ -540,9 +529,7 @@ tBTM_SEC_DEV_REC *btm_find_oldest_dev (void)
     UINT32       ot_paired = 0xFFFFFFFF;
 
     /* First look for the non-paired devices for the oldest entry */
-    list_node_t *end = list_end(btm_cb.sec_dev_rec);
-    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
-        tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
+    ILIST_FOREACH(&btm_cb.sec_dev_rec, tBTM_SEC_DEV_REC, p_dev_rec) {
         /* Device is not paired */
         if ((p_dev_rec->sec_flags & (BTM_SEC_LINK_KEY_KNOWN |BTM_SEC_LE_LINK_KEY_KNOWN)) == 0) {
             if (p_dev_rec->timestamp < ot) {
@@ -161,7 +161,7 @@ static void reset_complete(void *result) {
   l2cu_device_reset ();
 
   /* Clear current security state */
-  list_foreach(btm_cb.sec_dev_rec, set_sec_state_idle, NULL);
+  ilist_foreach(&btm_cb.sec_dev_rec, set_sec_state_idle, NULL);
 
   /* After the reset controller should restore all parameters to defaults. */
   btm_cb.btm_inq_vars.inq_counter       = 1;
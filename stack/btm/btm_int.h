@@ -31,6 +31,7 @@
 
 #include "rfcdefs.h"
 #include "osi/include/alarm.h"
+#include "osi/include/ilist.h"
 #include "osi/include/list.h"
 #include "osi/include/fixed_queue.h"
 
@@ -518,6 +519,7 @@ typedef UINT8 tBTM_BOND_TYPE;
 */
 typedef struct
 {
+    ilist_node_t         list_node;         /* Link in btm_cb.sec_dev_rec         */
     tBTM_SEC_SERV_REC   *p_cur_service;
     tBTM_SEC_CALLBACK   *p_callback;
     void                *p_ref_data;
@@ -879,7 +881,7 @@ typedef struct
     UINT16                   disc_handle;   /* for legacy devices */
     UINT8                    disc_reason;   /* for legacy devices */
     tBTM_SEC_SERV_REC        sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
-    list_t                  *sec_dev_rec;   /* list of tBTM_SEC_DEV_REC */
+    ilist_t                  sec_dev_rec;   /* list of tBTM_SEC_DEV_REC */
     tBTM_SEC_SERV_REC       *p_out_serv;
     tBTM_MKEY_CALLBACK      *mkey_cback;
 
@@ -73,7 +73,7 @@ void btm_init (void)
     btm_sco_init();                     /* SCO Database and Structures (If included) */
 #endif
 
-    btm_cb.sec_dev_rec = list_new(osi_free);
+    ILIST_INIT(&btm_cb.sec_dev_rec, tBTM_SEC_DEV_REC, list_node);
 
     btm_dev_init();                     /* Device Manager Structures & HCI_Reset */
 }
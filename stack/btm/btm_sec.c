@@ -3090,13 +3090,9 @@ void btm_sec_rmt_name_request_complete (UINT8 *p_bd_addr, UINT8 *p_bd_name, UINT
         p_dev_rec = btm_find_dev (p_bd_addr);
     else
     {
-        list_node_t *node = list_foreach(btm_cb.sec_dev_rec, is_state_getting_name, NULL);
-        if (node != NULL) {
-            p_dev_rec = list_node(node);
+        p_dev_rec = ilist_foreach(&btm_cb.sec_dev_rec, is_state_getting_name, NULL);
+        if (p_dev_rec != NULL)
             p_bd_addr = p_dev_rec->bd_addr;
-        } else {
-            p_dev_rec = NULL;
-        }
     }
 
     /* Commenting out trace due to obf/compilation problems.
@@ -5871,11 +5867,7 @@ bool is_sec_state_equal(void *data, void *context)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_sec_find_dev_by_sec_state (UINT8 state)
 {
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_sec_state_equal, &state);
-    if (n)
-        return list_node(n);
-
-    return NULL;
+    return ilist_foreach(&btm_cb.sec_dev_rec, is_sec_state_equal, &state);
 }
 
 /*******************************************************************************
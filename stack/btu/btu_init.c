@@ -139,6 +139,7 @@ void BTU_StartUp(void)
     btu_bta_msg_queue = fixed_queue_new(SIZE_MAX);
     if (btu_bta_msg_queue == NULL)
         goto error_exit;
+    fixed_queue_profile(btu_bta_msg_queue, "btu_bta_msg_queue");
 
     btu_general_alarm_queue = fixed_queue_new(SIZE_MAX);
     if (btu_general_alarm_queue == NULL)
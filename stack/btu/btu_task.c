@@ -43,6 +43,7 @@
 #include "osi/include/hash_map.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/profiler.h"
 #include "osi/include/thread.h"
 #include "port_api.h"
 #include "port_ext.h"
@@ -102,11 +103,23 @@ extern fixed_queue_t *btif_msg_queue;
 
 extern thread_t *bt_workqueue_thread;
 
+/* Run time of btu_hci_msg_process, by message type and HCI event code */
+static profiler_events_t *btu_hci_msg_profile;
+
 static void btu_hci_msg_process(BT_HDR *p_msg);
 
 void btu_hci_msg_ready(fixed_queue_t *queue, UNUSED_ATTR void *context) {
     BT_HDR *p_msg = (BT_HDR *)fixed_queue_dequeue(queue);
+    UINT16 event = p_msg->event & BT_EVT_MASK;
+    profiler_scope_t scope;
+
+    /* Tell HCI events apart by their event code */
+    if (event == BT_EVT_TO_BTU_HCI_EVT)
+        event |= p_msg->data[p_msg->offset];
+
+    profiler_event_begin(btu_hci_msg_profile, event, &scope);
     btu_hci_msg_process(p_msg);
+    profiler_event_end(&scope);
 }
 
 void btu_bta_msg_ready(fixed_queue_t *queue, UNUSED_ATTR void *context) {
@@ -177,6 +190,8 @@ void btu_task_start_up(UNUSED_ATTR void *context) {
    */
   btu_init_core();
 
+  btu_hci_msg_profile = profiler_events_new("btu_hci_msg");
+
   /* Initialize any optional stack components */
   BTE_InitStack();
 
@@ -216,6 +231,9 @@ void btu_task_shut_down(UNUSED_ATTR void *context) {
 
   bta_sys_free();
   btu_free_core();
+
+  profiler_events_free(btu_hci_msg_profile);
+  btu_hci_msg_profile = NULL;
 }
 
 #if (defined(HCILP_INCLUDED) && HCILP_INCLUDED == TRUE)
@@ -170,9 +170,9 @@ UINT16 GAP_ConnOpen (char *p_serv_name, UINT8 service_id, BOOLEAN is_server,
     /* Configure L2CAP COC, if transport is LE */
     if (p_cfg && transport == BT_TRANSPORT_LE)
     {
-        p_ccb->local_coc_cfg.credits = L2CAP_LE_DEFAULT_CREDIT;
+        p_ccb->local_coc_cfg.credits = L2CAP_LE_AUTO_CFG;
         p_ccb->local_coc_cfg.mtu = p_cfg->mtu;
-        p_ccb->local_coc_cfg.mps = L2CAP_LE_DEFAULT_MPS;
+        p_ccb->local_coc_cfg.mps = L2CAP_LE_AUTO_CFG;
     }
 
     p_ccb->p_callback     = p_cb;
@@ -377,7 +377,10 @@ UINT16 GAP_ConnReadData (UINT16 gap_handle, UINT8 *p_data, UINT16 max_len, UINT1
             p_buf->len    -= copy_len;
             break;
         }
-        osi_free(fixed_queue_try_dequeue(p_ccb->rx_queue));
+        p_buf = fixed_queue_try_dequeue(p_ccb->rx_queue);
+        if (p_ccb->transport == BT_TRANSPORT_LE)
+            L2CA_LECocSduConsumed(p_ccb->connection_id, p_buf);
+        osi_free(p_buf);
     }
 
     p_ccb->rx_queue_size -= *p_len;
@@ -457,6 +460,8 @@ UINT16 GAP_ConnBTRead (UINT16 gap_handle, BT_HDR **pp_buf)
         *pp_buf = p_buf;
 
         p_ccb->rx_queue_size -= p_buf->len;
+        if (p_ccb->transport == BT_TRANSPORT_LE)
+            L2CA_LECocSduConsumed(p_ccb->connection_id, p_buf);
         return (BT_PASS);
     }
     else
@@ -466,6 +471,45 @@ UINT16 GAP_ConnBTRead (UINT16 gap_handle, BT_HDR **pp_buf)
     }
 }
 
+/*******************************************************************************
+**
+** Function         gap_send_tx_queue
+**
+** Description      Sends the buffers queued on the connection's tx queue
+**                  through L2CAP unless the connection is congested.
+**
+** Returns          BT_PASS                 - data sent or queued
+**                  GAP_ERR_BAD_STATE       - L2CAP rejected the data
+**
+*******************************************************************************/
+static UINT16 gap_send_tx_queue (tGAP_CCB *p_ccb, UINT16 gap_handle)
+{
+    if (p_ccb->is_congested)
+    {
+        return (BT_PASS);
+    }
+
+    /* Send the buffer through L2CAP */
+#if (GAP_CONN_POST_EVT_INCLUDED == TRUE)
+    gap_send_event (gap_handle);
+#else
+    BT_HDR *p_buf;
+    while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_ccb->tx_queue)) != NULL)
+    {
+        UINT8 status = L2CA_DATA_WRITE (p_ccb->connection_id, p_buf);
+
+        if (status == L2CAP_DW_CONGESTED)
+        {
+            p_ccb->is_congested = TRUE;
+            break;
+        }
+        else if (status != L2CAP_DW_SUCCESS)
+            return (GAP_ERR_BAD_STATE);
+    }
+#endif
+    return (BT_PASS);
+}
+
 /*******************************************************************************
 **
 ** Function         GAP_ConnWriteData
@@ -519,29 +563,70 @@ UINT16 GAP_ConnWriteData (UINT16 gap_handle, UINT8 *p_data, UINT16 max_len, UINT
         fixed_queue_enqueue(p_ccb->tx_queue, p_buf);
     }
 
-    if (p_ccb->is_congested)
+    return gap_send_tx_queue (p_ccb, gap_handle);
+}
+
+/*******************************************************************************
+**
+** Function         GAP_ConnBTWrite
+**
+** Description      Bluetooth-aware applications will call this function to
+**                  write data to the connection. The buffer must be allocated
+**                  with at least L2CAP_MIN_OFFSET bytes of headroom in front
+**                  of the payload and, on an ERTM connection, L2CAP_FCS_LEN
+**                  bytes after it for the FCS that L2CAP appends in place.
+**                  The connection takes ownership of the buffer and frees
+**                  it on error. Payloads larger than the remote MTU are
+**                  segmented with GAP_ConnWriteData().
+**
+** Parameters:      handle      - Handle of the connection returned in the Open
+**                  p_buf       - Buffer to send
+**
+** Returns          BT_PASS                 - data sent or queued
+**                  GAP_ERR_BAD_HANDLE      - invalid handle
+**                  GAP_ERR_BAD_STATE       - connection not established
+**                  GAP_ERR_BUF_OFFSET      - buffer offset is too small
+**
+*******************************************************************************/
+UINT16 GAP_ConnBTWrite (UINT16 gap_handle, BT_HDR *p_buf)
+{
+    tGAP_CCB    *p_ccb = gap_find_ccb_by_handle (gap_handle);
+
+    if (!p_ccb)
     {
-        return (BT_PASS);
+        osi_free (p_buf);
+        return (GAP_ERR_BAD_HANDLE);
     }
 
-    /* Send the buffer through L2CAP */
-#if (GAP_CONN_POST_EVT_INCLUDED == TRUE)
-    gap_send_event (gap_handle);
-#else
-    while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_ccb->tx_queue)) != NULL)
+    if (p_ccb->con_state != GAP_CCB_STATE_CONNECTED)
     {
-        UINT8 status = L2CA_DATA_WRITE (p_ccb->connection_id, p_buf);
+        osi_free (p_buf);
+        return (GAP_ERR_BAD_STATE);
+    }
 
-        if (status == L2CAP_DW_CONGESTED)
-        {
-            p_ccb->is_congested = TRUE;
-            break;
-        }
-        else if (status != L2CAP_DW_SUCCESS)
-            return (GAP_ERR_BAD_STATE);
+    if (p_buf->offset < L2CAP_MIN_OFFSET)
+    {
+        osi_free (p_buf);
+        return (GAP_ERR_BUF_OFFSET);
     }
-#endif
-    return (BT_PASS);
+
+    if (p_buf->len > p_ccb->rem_mtu_size)
+    {
+        UINT16 len;
+        UINT16 status = GAP_ConnWriteData (gap_handle,
+                                           (UINT8 *)(p_buf + 1) + p_buf->offset,
+                                           p_buf->len, &len);
+        osi_free (p_buf);
+        return (status);
+    }
+
+    p_buf->event = BT_EVT_TO_BTU_SP_DATA;
+
+    GAP_TRACE_EVENT ("GAP_BTWrite %d bytes", p_buf->len);
+
+    fixed_queue_enqueue(p_ccb->tx_queue, p_buf);
+
+    return gap_send_tx_queue (p_ccb, gap_handle);
 }
 
 
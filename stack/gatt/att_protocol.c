@@ -317,6 +317,34 @@ BT_HDR *attp_build_value_cmd (UINT16 payload_size, UINT8 op_code, UINT16 handle,
     return p_buf;
 }
 
+/*******************************************************************************
+**
+** Function         attp_copy_value_cmd
+**
+** Description      Copy a built attribute value PDU for another link, truncating
+**                  the value to fit the payload size of that link.
+**
+** Returns          The copy, owned by the caller.
+**
+*******************************************************************************/
+BT_HDR *attp_copy_value_cmd (UINT16 payload_size, const BT_HDR *p_src)
+{
+    UINT16 len = (p_src->len > payload_size) ? payload_size : p_src->len;
+    BT_HDR *p_buf =
+        (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + len);
+
+    memcpy(p_buf, p_src, sizeof(BT_HDR));
+    p_buf->offset = L2CAP_MIN_OFFSET;
+    p_buf->len = len;
+    memcpy((UINT8 *)(p_buf + 1) + L2CAP_MIN_OFFSET,
+           (const UINT8 *)(p_src + 1) + p_src->offset, len);
+
+    if (len < p_src->len)
+        GATT_TRACE_WARNING("attribute value too long, to be truncated to %d", len - 3);
+
+    return p_buf;
+}
+
 /*******************************************************************************
 **
 ** Function         attp_send_msg_to_l2cap
@@ -513,11 +541,10 @@ tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code,
         switch (op_code)
         {
         case GATT_REQ_MTU:
+            /* payload_size changes only once the server answers, see
+               gatt_process_mtu_rsp() */
             if (p_msg->mtu <= GATT_MAX_MTU_SIZE)
-            {
-                p_tcb->payload_size = p_msg->mtu;
                 p_cmd = attp_build_mtu_cmd(GATT_REQ_MTU, p_msg->mtu);
-            }
             else
                 status = GATT_ILLEGAL_PARAMETER;
             break;
@@ -377,6 +377,47 @@ UINT16 GATTS_AddCharDescriptor (UINT16 service_handle,
                                 p_descr_uuid);
 
 }
+/*******************************************************************************
+**
+** Function         GATTS_SetAttributeValue
+**
+** Description      This function is called to store the value of a characteristic
+**                  value or descriptor the application owns. Read and Read Blob
+**                  requests for it are then answered by the stack without a
+**                  GATTS_REQ_TYPE_READ to the application. A write from a client
+**                  drops the stored value until the application sets it again.
+**
+** Parameter        service_handle  : service the attribute belongs to.
+**                  attr_handle     : characteristic value or descriptor handle.
+**                  val_len         : value length.
+**                  p_val           : value, NULL to have reads sent to the
+**                                    application again.
+**                  notify_app      : TRUE to still get a GATTS_REQ_TYPE_READ for
+**                                    reads starting at offset 0, so that only
+**                                    the rest of a long read is answered here.
+**
+** Returns          GATT_SUCCESS if the value was stored; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_SetAttributeValue (UINT16 service_handle, UINT16 attr_handle,
+                                      UINT16 val_len, UINT8 *p_val, BOOLEAN notify_app)
+{
+    tGATT_HDL_LIST_ELEM  *p_decl;
+
+    GATT_TRACE_API ("GATTS_SetAttributeValue attr_handle=0x%04x len=%d", attr_handle, val_len);
+
+    if ((p_decl = gatt_find_hdl_buffer_by_handle(service_handle)) == NULL)
+    {
+        GATT_TRACE_DEBUG("Service not created");
+        return GATT_NOT_FOUND;
+    }
+
+    if (attr_handle <= service_handle || attr_handle > p_decl->asgn_range.e_handle)
+        return GATT_ILLEGAL_PARAMETER;
+
+    return gatts_db_set_attr_value(&p_decl->svc_db, attr_handle, val_len, p_val, notify_app);
+}
+
 /*******************************************************************************
 **
 ** Function         GATTS_DeleteService
@@ -701,6 +742,104 @@ tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
     return cmd_sent;
 }
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotificationMulti
+**
+** Description      This function sends the same handle value notification to
+**                  several clients. The PDU is built once and copied for each
+**                  link, truncated to that link's MTU.
+**
+** Parameter        num_conn: number of entries in conn_ids.
+**                  conn_ids: connection identifiers to notify.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: if not NULL, receives the status of each connection.
+**
+** Returns          GATT_SUCCESS if sent to every connection; otherwise the error
+**                  code of the last connection that failed.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *conn_ids,
+                                                 UINT16 attr_handle, UINT16 val_len,
+                                                 UINT8 *p_val, tGATT_STATUS *p_status)
+{
+    tGATT_STATUS    status = GATT_SUCCESS;
+    tGATT_STATUS    cmd_sent;
+    tGATT_TCB       *p_tcb;
+    BT_HDR          *p_pdu;
+    BT_HDR          *p_buf;
+    UINT16          payload_size = 0;
+    UINT8           last = 0;
+    UINT8           ii;
+
+    GATT_TRACE_API ("GATTS_HandleValueNotificationMulti num_conn=%d", num_conn);
+
+    if (num_conn == 0 || conn_ids == NULL || !GATT_HANDLE_IS_VALID (attr_handle))
+    {
+        for (ii = 0; p_status != NULL && ii < num_conn; ii ++)
+            p_status[ii] = GATT_ILLEGAL_PARAMETER;
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    /* size the shared PDU for the largest MTU among the links */
+    for (ii = 0; ii < num_conn; ii ++)
+    {
+        p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_ids[ii]));
+
+        if (gatt_get_regcb(GATT_GET_GATT_IF(conn_ids[ii])) == NULL || p_tcb == NULL)
+        {
+            GATT_TRACE_ERROR ("GATTS_HandleValueNotificationMulti Unknown conn_id: %u ",
+                              conn_ids[ii]);
+            status = (tGATT_STATUS) GATT_INVALID_CONN_ID;
+            if (p_status)
+                p_status[ii] = (tGATT_STATUS) GATT_INVALID_CONN_ID;
+            continue;
+        }
+
+        if (p_tcb->payload_size > payload_size)
+            payload_size = p_tcb->payload_size;
+        last = ii;
+    }
+
+    if (payload_size == 0)
+        return status;
+
+    /* no larger than the value needs: opcode + handle + value */
+    if (payload_size > val_len + 3)
+        payload_size = val_len + 3;
+
+    p_pdu = attp_build_value_cmd(payload_size, GATT_HANDLE_VALUE_NOTIF, attr_handle,
+                                 0, val_len, p_val);
+
+    for (ii = 0; ii <= last; ii ++)
+    {
+        p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_ids[ii]));
+
+        if (gatt_get_regcb(GATT_GET_GATT_IF(conn_ids[ii])) == NULL || p_tcb == NULL)
+            continue;
+
+        /* the last link takes the shared PDU itself when it fits */
+        if (ii == last && p_pdu->len <= p_tcb->payload_size)
+        {
+            p_buf = p_pdu;
+            p_pdu = NULL;
+        }
+        else
+            p_buf = attp_copy_value_cmd(p_tcb->payload_size, p_pdu);
+
+        cmd_sent = attp_send_sr_msg (p_tcb, p_buf);
+        if (cmd_sent != GATT_SUCCESS && cmd_sent != GATT_CONGESTED)
+            status = cmd_sent;
+        if (p_status)
+            p_status[ii] = cmd_sent;
+    }
+
+    osi_free(p_pdu);
+    return status;
+}
+
 /*******************************************************************************
 **
 ** Function         GATTS_SendRsp
@@ -781,15 +920,15 @@ tGATT_STATUS GATTC_ConfigureMTU (UINT16 conn_id, UINT16 mtu)
 
     GATT_TRACE_API ("GATTC_ConfigureMTU conn_id=%d mtu=%d", conn_id, mtu );
 
-    /* Validate that the link is BLE, not BR/EDR */
-    if (p_tcb->transport != BT_TRANSPORT_LE)
+    if ( (p_tcb == NULL) || (p_reg==NULL) || (mtu < GATT_DEF_BLE_MTU_SIZE) || (mtu > GATT_MAX_MTU_SIZE))
     {
-        return GATT_ERROR;
+        return GATT_ILLEGAL_PARAMETER;
     }
 
-    if ( (p_tcb == NULL) || (p_reg==NULL) || (mtu < GATT_DEF_BLE_MTU_SIZE) || (mtu > GATT_MAX_MTU_SIZE))
+    /* Validate that the link is BLE, not BR/EDR */
+    if (p_tcb->transport != BT_TRANSPORT_LE)
     {
-        return GATT_ILLEGAL_PARAMETER;
+        return GATT_ERROR;
     }
 
     if (gatt_is_clcb_allocated(conn_id))
@@ -800,10 +939,23 @@ tGATT_STATUS GATTC_ConfigureMTU (UINT16 conn_id, UINT16 mtu)
 
     if ((p_clcb = gatt_clcb_alloc(conn_id)) != NULL)
     {
-        p_clcb->p_tcb->payload_size = mtu;
         p_clcb->operation = GATTC_OPTYPE_CONFIG;
 
+        /* the client may exchange the MTU only once per link, e.g. the GATT
+           profile already did on connection; report the MTU in use instead */
+        if (p_tcb->mtu_exchanged)
+        {
+            GATT_TRACE_DEBUG("GATTC_ConfigureMTU already exchanged, mtu=%d", p_tcb->payload_size);
+            gatt_end_operation(p_clcb, GATT_SUCCESS, NULL);
+            return GATT_SUCCESS;
+        }
+
+        /* the MTU in use only changes once the server has answered */
+        p_clcb->counter = mtu;
+
         ret = attp_send_cl_msg (p_clcb->p_tcb, p_clcb->clcb_idx, GATT_REQ_MTU, (tGATT_CL_MSG *)&mtu);
+        if (ret != GATT_SUCCESS && ret != GATT_CMD_STARTED && ret != GATT_CONGESTED)
+            gatt_clcb_dealloc(p_clcb);
     }
 
     return ret;
@@ -28,6 +28,7 @@
 
 #include "gatt_api.h"
 #include "gatt_int.h"
+#include "device/include/interop.h"
 
 #if BLE_INCLUDED == TRUE
 
@@ -49,6 +50,7 @@ static void gatt_cl_op_cmpl_cback(UINT16 conn_id, tGATTC_OPTYPE op, tGATT_STATUS
               tGATT_CL_COMPLETE *p_data);
 
 static void gatt_cl_start_config_ccc(tGATT_PROFILE_CLCB *p_clcb);
+static BOOLEAN gatt_cl_start_auto_mtu(tGATT_PROFILE_CLCB *p_clcb);
 
 
 static tGATT_CBACK gatt_profile_cback =
@@ -249,7 +251,10 @@ static void gatt_connect_cback (tGATT_IF gatt_if, BD_ADDR bda, UINT16 conn_id,
 
         p_clcb->connected = TRUE;
         p_clcb->ccc_stage = GATT_SVC_CHANGED_SERVICE;
-        gatt_cl_start_config_ccc(p_clcb);
+
+        /* service change CCC configuration follows the MTU exchange */
+        if (!gatt_cl_start_auto_mtu(p_clcb))
+            gatt_cl_start_config_ccc(p_clcb);
     } else {
         if (p_clcb != NULL)
             gatt_profile_clcb_dealloc(p_clcb);
@@ -373,10 +378,53 @@ static void gatt_disc_cmpl_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGA
 static void gatt_cl_op_cmpl_cback (UINT16 conn_id, tGATTC_OPTYPE op,
                                    tGATT_STATUS status, tGATT_CL_COMPLETE *p_data)
 {
-    UNUSED(conn_id);
-    UNUSED(op);
-    UNUSED(status);
+    tGATT_PROFILE_CLCB *p_clcb;
     UNUSED(p_data);
+
+    if (op != GATTC_OPTYPE_CONFIG)
+        return;
+
+    GATT_TRACE_DEBUG("%s: MTU exchange done, status=%d", __func__, status);
+
+    if ((p_clcb = gatt_profile_find_clcb_by_conn_id(conn_id)) != NULL)
+        gatt_cl_start_config_ccc(p_clcb);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_start_auto_mtu
+**
+** Description      Gatt profile starts an MTU exchange on a new LE link for
+**                  GATT_PREFERRED_MTU, unless the peer has an interop entry
+**                  against it.
+**
+** Returns          TRUE if the exchange was started.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_start_auto_mtu(tGATT_PROFILE_CLCB *p_clcb)
+{
+    tGATT_STATUS    status;
+    UINT16          mtu = GATT_PREFERRED_MTU;
+
+    if (p_clcb->transport != BT_TRANSPORT_LE)
+        return FALSE;
+
+    if (mtu > GATT_MAX_MTU_SIZE)
+        mtu = GATT_MAX_MTU_SIZE;
+
+    if (mtu <= GATT_DEF_BLE_MTU_SIZE)
+        return FALSE;
+
+    if (interop_match_addr(INTEROP_DISABLE_LE_AUTO_MTU, (const bt_bdaddr_t *)p_clcb->bda))
+    {
+        GATT_TRACE_DEBUG("%s: disabled by interop entry", __func__);
+        return FALSE;
+    }
+
+    status = GATTC_ConfigureMTU(p_clcb->conn_id, mtu);
+    GATT_TRACE_DEBUG("%s: mtu=%d status=%d", __func__, mtu, status);
+
+    return (status == GATT_SUCCESS || status == GATT_CMD_STARTED || status == GATT_CONGESTED);
 }
 
 /*******************************************************************************
@@ -1065,8 +1065,11 @@ void gatt_process_mtu_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT16 len, UINT
     {
     STREAM_TO_UINT16(mtu, p_data);
 
-    if (mtu < p_tcb->payload_size && mtu >= GATT_DEF_BLE_MTU_SIZE)
-        p_tcb->payload_size = mtu;
+    /* the MTU is the smaller of the one we asked for and the server's */
+    if (mtu >= GATT_DEF_BLE_MTU_SIZE)
+        p_tcb->payload_size = (mtu < p_clcb->counter) ? mtu : p_clcb->counter;
+
+    p_tcb->mtu_exchanged = TRUE;
     }
 
     l2cble_set_fixed_channel_tx_data_length(p_tcb->peer_bda, L2CAP_ATT_CID, p_tcb->payload_size);
@@ -62,7 +62,9 @@ static tGATT_STATUS gatts_send_app_read_request(tGATT_TCB *p_tcb, UINT8 op_code,
 BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN is_pri,
                                UINT16 s_hdl, UINT16 num_handle)
 {
-    p_db->svc_buffer = fixed_queue_new(SIZE_MAX);
+    /* gatt_alloc_hdl_buffer() has made the queue already */
+    if (p_db->svc_buffer == NULL)
+        p_db->svc_buffer = fixed_queue_new(SIZE_MAX);
 
     if (!allocate_svc_db_buf(p_db))
     {
@@ -290,6 +292,29 @@ static tGATT_STATUS read_attr_value (void *p_attr,
             status = GATT_SUCCESS;
         }
     }
+    /* value stored by the application; if it asked to be notified it still
+       answers the start of each read and anything past what it stored */
+    else if (p_attr16->p_value != NULL &&
+             (!p_attr16->p_value->cached_val.notify_app ||
+              (offset != 0 && offset < p_attr16->p_value->cached_val.len)))
+    {
+        tGATT_ATTR_CACHED_VAL *p_val = &p_attr16->p_value->cached_val;
+
+        if (offset > p_val->len)
+        {
+            status = GATT_INVALID_OFFSET;
+        }
+        else
+        {
+            len = p_val->len - offset;
+            if (len > mtu)
+                len = mtu;
+
+            memcpy(p, p_val->p_data + offset, len);
+            p += len;
+            status = GATT_SUCCESS;
+        }
+    }
     else /* characteristic description or characteristic value */
     {
         status = GATT_PENDING;
@@ -663,6 +688,80 @@ tGATT_STATUS gatts_read_attr_value_by_handle(tGATT_TCB *p_tcb,
     return status;
 }
 
+/*******************************************************************************
+**
+** Function         gatts_db_set_attr_value
+**
+** Description      Store the value of an application owned attribute, i.e. a
+**                  characteristic value or descriptor, so that reads of it are
+**                  answered from the database instead of by the application.
+**
+** Parameter        p_db: pointer to the attribute database.
+**                  handle: Attribute handle.
+**                  len: value length.
+**                  p_value: the value, NULL to hand reads back to the application.
+**                  notify_app: keep sending reads at offset 0 to the application,
+**                              so only the rest of a long read is served here.
+**
+** Returns          Status of operation.
+**
+*******************************************************************************/
+tGATT_STATUS gatts_db_set_attr_value(tGATT_SVC_DB *p_db, UINT16 handle, UINT16 len, UINT8 *p_value,
+                                     BOOLEAN notify_app)
+{
+    tGATT_ATTR16    *p_attr = NULL;
+
+    if (p_db)
+    {
+        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+
+        while (p_attr && handle > p_attr->handle)
+            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+    }
+
+    if (p_attr == NULL || p_attr->handle != handle)
+        return GATT_NOT_FOUND;
+
+    if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
+    {
+        switch (p_attr->uuid)
+        {
+            case GATT_UUID_PRI_SERVICE:
+            case GATT_UUID_SEC_SERVICE:
+            case GATT_UUID_CHAR_DECLARE:
+            case GATT_UUID_INCLUDE_SERVICE:
+            /* the application keeps one per client */
+            case GATT_UUID_CHAR_CLIENT_CONFIG:
+                return GATT_ILLEGAL_PARAMETER;
+
+            default:
+                break;
+        }
+    }
+
+    if (p_value != NULL && len > GATT_MAX_ATTR_LEN)
+        return GATT_INVALID_ATTR_LEN;
+
+    if (p_attr->p_value != NULL)
+    {
+        osi_free(fixed_queue_try_remove_from_queue(p_db->svc_buffer, p_attr->p_value));
+        p_attr->p_value = NULL;
+    }
+
+    if (p_value != NULL)
+    {
+        /* kept with the database buffers, so it is freed with the service */
+        p_attr->p_value = (tGATT_ATTR_VALUE *)osi_malloc(sizeof(tGATT_ATTR_VALUE) + len);
+        p_attr->p_value->cached_val.len = len;
+        p_attr->p_value->cached_val.notify_app = notify_app;
+        p_attr->p_value->cached_val.p_data = (UINT8 *)(p_attr->p_value + 1);
+        memcpy(p_attr->p_value->cached_val.p_data, p_value, len);
+        fixed_queue_enqueue(p_db->svc_buffer, p_attr->p_value);
+    }
+
+    return GATT_SUCCESS;
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_read_attr_perm_check
@@ -153,6 +153,15 @@ typedef struct
     UINT16                      char_val_handle;
 } tGATT_CHAR_DECL;
 
+/* Value of an application owned attribute that the stack answers reads with
+*/
+typedef struct
+{
+    UINT16                      len;
+    BOOLEAN                     notify_app;     /* reads from offset 0 still go to the application */
+    UINT8                       *p_data;
+} tGATT_ATTR_CACHED_VAL;
+
 /* attribute value maintained in the server database
 */
 typedef union
@@ -160,6 +169,7 @@ typedef union
     tBT_UUID                uuid;               /* service declaration */
     tGATT_CHAR_DECL         char_decl;          /* characteristic declaration */
     tGATT_INCL_SRVC         incl_handle;        /* included service */
+    tGATT_ATTR_CACHED_VAL   cached_val;         /* characteristic value or descriptor */
 
 } tGATT_ATTR_VALUE;
 
@@ -356,6 +366,7 @@ typedef struct
 
     UINT16          att_lcid;           /* L2CAP channel ID for ATT */
     UINT16          payload_size;
+    BOOLEAN         mtu_exchanged;      /* our client has completed an MTU exchange */
 
     tGATT_CH_STATE  ch_state;
     UINT8           ch_flags;
@@ -401,7 +412,7 @@ typedef struct
     UINT16                  clcb_idx;
     UINT16                  s_handle;       /* starting handle of the active request */
     UINT16                  e_handle;       /* ending handle of the active request */
-    UINT16                  counter;        /* used as offset, attribute length, num of prepare write */
+    UINT16                  counter;        /* used as offset, attribute length, num of prepare write, requested MTU */
     UINT16                  start_offset;
     tGATT_AUTH_REQ          auth_req;       /* authentication requirement */
     UINT8                   operation;      /* one logic channel can have one operation active */
@@ -553,6 +564,9 @@ extern UINT16 gatt_profile_find_conn_id_by_bd_addr(BD_ADDR bda);
 /* Functions provided by att_protocol.c */
 extern tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code, tGATT_CL_MSG *p_msg);
 extern BT_HDR *attp_build_sr_msg(tGATT_TCB *p_tcb, UINT8 op_code, tGATT_SR_MSG *p_msg);
+extern BT_HDR *attp_build_value_cmd (UINT16 payload_size, UINT8 op_code, UINT16 handle,
+                                     UINT16 offset, UINT16 len, UINT8 *p_data);
+extern BT_HDR *attp_copy_value_cmd (UINT16 payload_size, const BT_HDR *p_src);
 extern tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP);
 
@@ -684,6 +698,8 @@ extern tGATT_STATUS gatts_read_attr_value_by_handle(tGATT_TCB *p_tcb,tGATT_SVC_D
                                                     UINT8 *p_value, UINT16 *p_len, UINT16 mtu,tGATT_SEC_FLAG sec_flag,UINT8 key_size,UINT32 trans_id);
 extern tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,UINT16 handle, UINT16 offset, UINT8 *p_data,
                                                  UINT16 len, tGATT_SEC_FLAG sec_flag, UINT8 key_size);
+extern tGATT_STATUS gatts_db_set_attr_value(tGATT_SVC_DB *p_db, UINT16 handle, UINT16 len, UINT8 *p_value,
+                                            BOOLEAN notify_app);
 extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db, BOOLEAN is_long, UINT16 handle, tGATT_SEC_FLAG sec_flag,UINT8 key_size);
 extern void gatts_update_srv_list_elem(UINT8 i_sreg, UINT16 handle, BOOLEAN is_primary);
 extern tBT_UUID * gatts_get_service_uuid (tGATT_SVC_DB *p_db);
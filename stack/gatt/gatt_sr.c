@@ -1097,6 +1097,9 @@ void gatts_process_write_req (tGATT_TCB *p_tcb, UINT8 i_rcb, UINT16 handle,
 
     if (status == GATT_SUCCESS)
     {
+        /* a stored value is stale once written; the application sets it again */
+        gatts_db_set_attr_value(gatt_cb.sr_reg[i_rcb].p_db, handle, 0, NULL, FALSE);
+
         if ((trans_id = gatt_sr_enqueue_cmd(p_tcb, op_code, handle)) != 0)
         {
             p_sreg = &gatt_cb.sr_reg[i_rcb];
@@ -632,7 +632,9 @@ extern tAVRC_STS AVRC_BldCommand( tAVRC_COMMAND *p_cmd, BT_HDR **pp_pkt);
 ** Function         AVRC_BldResponse
 **
 ** Description      This function builds the given AVRCP response to the given
-**                  GKI buffer
+**                  GKI buffer. If *pp_pkt is NULL a buffer is allocated;
+**                  otherwise the response is appended to *pp_pkt, which must
+**                  have been built by this function, and *pp_pkt may move.
 **
 ** Returns          AVRC_STS_NO_ERROR, if the response is built successfully
 **                  Otherwise, the error code.
@@ -645,7 +647,9 @@ extern tAVRC_STS AVRC_BldResponse( UINT8 handle, tAVRC_RESPONSE *p_rsp, BT_HDR *
 ** Function         AVRC_BldBrowseResponse
 **
 ** Description      This function builds the given AVRCP response to the given
-**                  GKI buffer
+**                  GKI buffer. If *pp_pkt is NULL a buffer is allocated;
+**                  otherwise the response is appended to *pp_pkt, which must
+**                  have been built by this function, and *pp_pkt may move.
 **
 ** Returns          AVRC_STS_NO_ERROR, if the response is built successfully
 **                  Otherwise, the error code.
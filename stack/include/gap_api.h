@@ -223,6 +223,24 @@ extern UINT16 GAP_ConnBTRead (UINT16 gap_handle, BT_HDR **pp_buf);
 extern UINT16 GAP_ConnWriteData (UINT16 gap_handle, UINT8 *p_data,
                                          UINT16 max_len, UINT16 *p_len);
 
+/*******************************************************************************
+**
+** Function         GAP_ConnBTWrite
+**
+** Description      Bluetooth-aware applications will call this function to
+**                  send data to the connection without a data copy. The
+**                  buffer needs L2CAP_MIN_OFFSET bytes of headroom, and
+**                  L2CAP_FCS_LEN bytes of tailroom on an ERTM connection. It
+**                  is always consumed, including on error.
+**
+** Returns          BT_PASS                 - data sent or queued
+**                  GAP_ERR_BAD_HANDLE      - invalid handle
+**                  GAP_ERR_BAD_STATE       - connection not established
+**                  GAP_ERR_BUF_OFFSET      - buffer offset is too small
+**
+*******************************************************************************/
+extern UINT16 GAP_ConnBTWrite (UINT16 gap_handle, BT_HDR *p_buf);
+
 /*******************************************************************************
 **
 ** Function         GAP_ConnReconfig
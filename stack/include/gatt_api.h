@@ -798,6 +798,30 @@ extern UINT16 GATTS_AddCharacteristic (UINT16 service_handle, tBT_UUID *char_uui
 extern UINT16 GATTS_AddCharDescriptor (UINT16 service_handle, tGATT_PERM perm,
                                        tBT_UUID * p_descr_uuid);
 
+/*******************************************************************************
+**
+** Function         GATTS_SetAttributeValue
+**
+** Description      This function is called to store the value of a characteristic
+**                  value or descriptor the application owns, so that the stack
+**                  answers Read and Read Blob requests for it. A write from a
+**                  client drops the stored value until it is set again.
+**
+** Parameter        service_handle  : service the attribute belongs to.
+**                  attr_handle     : characteristic value or descriptor handle.
+**                  val_len         : value length.
+**                  p_val           : value, NULL to have reads sent to the
+**                                    application again.
+**                  notify_app      : TRUE to still get a GATTS_REQ_TYPE_READ for
+**                                    reads starting at offset 0, so that only
+**                                    the rest of a long read is answered here.
+**
+** Returns          GATT_SUCCESS if the value was stored; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_SetAttributeValue (UINT16 service_handle, UINT16 attr_handle,
+                                             UINT16 val_len, UINT8 *p_val, BOOLEAN notify_app);
+
 /*******************************************************************************
 **
 ** Function         GATTS_DeleteService
@@ -880,6 +904,27 @@ extern  tGATT_STATUS GATTS_HandleValueIndication (UINT16 conn_id,
 extern  tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
                                                     UINT16 val_len, UINT8 *p_val);
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotificationMulti
+**
+** Description      This function sends the same handle value notification to
+**                  several clients, building the PDU only once.
+**
+** Parameter        num_conn: number of entries in conn_ids.
+**                  conn_ids: connection identifiers to notify.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: if not NULL, receives the status of each connection.
+**
+** Returns          GATT_SUCCESS if sent to every connection; otherwise error code.
+**
+*******************************************************************************/
+extern  tGATT_STATUS GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *conn_ids,
+                                                         UINT16 attr_handle, UINT16 val_len,
+                                                         UINT8 *p_val, tGATT_STATUS *p_status);
+
 
 /*******************************************************************************
 **
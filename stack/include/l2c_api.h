@@ -169,8 +169,11 @@ typedef struct
 } tL2CAP_CFG_INFO;
 
 /* Define a structure to hold the configuration parameter for LE L2CAP connection
-** oriented channels.
+** oriented channels. Leaving the local mps or credits at L2CAP_LE_AUTO_CFG lets
+** L2CAP size them from the link's data length and its receive budget.
 */
+#define L2CAP_LE_AUTO_CFG       0
+
 typedef struct
 {
     UINT16  mtu;
@@ -503,6 +506,19 @@ extern BOOLEAN L2CA_ConnectLECocRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid, U
 *******************************************************************************/
 extern BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO* peer_cfg);
 
+/*******************************************************************************
+**
+**  Function         L2CA_LECocSduConsumed
+**
+**  Description      Tell L2CAP the upper layer is done with an SDU received on
+**                   an LE Connection Oriented Channel. The peer only gets the
+**                   credits of its PDUs back after this.
+**
+**  Return value:    TRUE if the channel was found
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_LECocSduConsumed (UINT16 lcid, BT_HDR *p_sdu);
+
 // This function sets the callback routines for the L2CAP connection referred to by
 // |local_cid|. The callback routines can only be modified for outgoing connections
 // established by |L2CA_ConnectReq| or accepted incoming connections. |callbacks|
@@ -634,6 +634,33 @@ BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO* peer_cfg)
     return TRUE;
 }
 
+/*******************************************************************************
+**
+**  Function         L2CA_LECocSduConsumed
+**
+**  Description      Higher layers call this function once they are done with an
+**                   SDU received on an LE Connection Oriented Channel, so the
+**                   credits of the PDUs that carried it go back to the peer.
+**
+**  Parameters:      local channel id
+**                   The SDU as handed to the data indication callback
+**
+**  Return value:    TRUE if the channel was found
+**
+*******************************************************************************/
+BOOLEAN L2CA_LECocSduConsumed (UINT16 lcid, BT_HDR *p_sdu)
+{
+    tL2C_CCB *p_ccb = l2cu_find_ccb_by_cid(NULL, lcid);
+    if (p_ccb == NULL || p_ccb->p_lcb == NULL || p_ccb->p_lcb->transport != BT_TRANSPORT_LE)
+    {
+        L2CAP_TRACE_WARNING("%s No LE CCB for CID:0x%04x", __func__, lcid);
+        return FALSE;
+    }
+
+    l2cble_return_rx_credits(p_ccb, p_sdu->layer_specific);
+    return TRUE;
+}
+
 bool L2CA_SetConnectionCallbacks(uint16_t local_cid, const tL2CAP_APPL_INFO *callbacks) {
   assert(callbacks != NULL);
   assert(callbacks->pL2CA_ConnectInd_Cb == NULL);
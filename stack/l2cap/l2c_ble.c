@@ -270,6 +270,48 @@ void l2cble_use_preferred_conn_params(BD_ADDR bda) {
     }
 }
 
+/*******************************************************************************
+**
+** Function         l2cble_use_max_data_length
+**
+** Description      Ask for the largest LE data length on a new link when both
+**                  controllers support data length extension, so that ACL
+**                  packets are not limited to 27 bytes until an upper layer
+**                  asks for more. The controller caps the request to what it
+**                  supports. Called once per link, when reading the remote
+**                  version completes, as the remote LE features are read
+**                  before it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_use_max_data_length (BD_ADDR bda)
+{
+#if (defined(L2CAP_LE_AUTO_DATA_LENGTH) && (L2CAP_LE_AUTO_DATA_LENGTH == TRUE))
+    tL2C_LCB *p_lcb = l2cu_find_lcb_by_bd_addr (bda, BT_TRANSPORT_LE);
+    tACL_CONN *p_acl = btm_bda_to_acl (bda, BT_TRANSPORT_LE);
+
+    if (p_lcb == NULL || p_acl == NULL || p_lcb->auto_data_len)
+        return;
+
+    if (!controller_get_interface()->supports_ble_packet_extension() ||
+        !HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
+        return;
+
+    if (interop_match_addr(INTEROP_DISABLE_LE_AUTO_DATA_LENGTH,
+                           (const bt_bdaddr_t *)p_lcb->remote_bd_addr))
+    {
+        L2CAP_TRACE_DEBUG("%s: disabled by interop entry", __func__);
+        return;
+    }
+
+    if (BTM_SetBleDataLength(p_lcb->remote_bd_addr, BTM_BLE_DATA_SIZE_MAX) == BTM_SUCCESS)
+        p_lcb->auto_data_len = TRUE;
+#else
+    UNUSED(bda);
+#endif
+}
+
 /*******************************************************************************
 **
 ** Function l2cble_notify_le_connection
@@ -1214,6 +1256,10 @@ void l2cble_update_data_length(tL2C_LCB *p_lcb)
     if (p_lcb == NULL)
         return;
 
+    /* the maximum has been asked for already, no channel can need more */
+    if (p_lcb->auto_data_len)
+        return;
+
     for (i = 0; i < L2CAP_NUM_FIXED_CHNLS; i++)
     {
         if (i + L2CAP_FIRST_FIXED_CHNL != L2CAP_BLE_SIGNALLING_CID)
@@ -1253,7 +1299,9 @@ void l2cble_process_data_length_change_event(UINT16 handle, UINT16 tx_data_len,
     if (tx_data_len > 0)
         p_lcb->tx_data_len = tx_data_len;
 
-    /* ignore rx_data len for now */
+    /* sizes the MPS of LE CoC channels set up from now on */
+    if (rx_data_len > 0)
+        p_lcb->rx_data_len = rx_data_len;
 }
 
 /*******************************************************************************
@@ -1293,6 +1341,65 @@ void l2cble_set_fixed_channel_tx_data_length(BD_ADDR remote_bda, UINT16 fix_cid,
     l2cble_update_data_length(p_lcb);
 }
 
+/*******************************************************************************
+**
+** Function         l2cble_size_coc_rx
+**
+** Description      This function fills in the local MPS and initial credits of
+**                  an LE connection oriented channel where they were left to
+**                  L2CAP. A PDU carries a whole SDU if it fits in a few LE data
+**                  packets, otherwise it fills those packets. The credits let
+**                  the peer send L2CAP_LE_COC_RX_BUDGET bytes ahead of the
+**                  upper layer reading them, and at least two whole SDUs.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2cble_size_coc_rx (tL2C_CCB *p_ccb)
+{
+    tL2CAP_LE_CFG_INFO *p_cfg = &p_ccb->local_conn_cfg;
+    tL2C_LCB *p_lcb = p_ccb->p_lcb;
+
+    if (p_cfg->mps == L2CAP_LE_AUTO_CFG)
+    {
+        /* The largest LE data packet the link carries and our controller buffers */
+        UINT32 frag_len = (p_lcb && p_lcb->rx_data_len) ? p_lcb->rx_data_len :
+                          (p_lcb ? p_lcb->tx_data_len : 0);
+        UINT16 acl_len = controller_get_interface()->get_acl_data_size_ble();
+        if (acl_len != 0 && acl_len < frag_len)
+            frag_len = acl_len;
+        if (frag_len < BTM_BLE_DATA_SIZE_MIN)
+            frag_len = BTM_BLE_DATA_SIZE_MIN;
+
+        UINT32 mps = (UINT32)p_cfg->mtu + L2CAP_LCC_SDU_LENGTH;
+        if (mps > frag_len * L2CAP_LE_AUTO_MPS_FRAGS - L2CAP_PKT_OVERHEAD)
+            mps = frag_len * L2CAP_LE_AUTO_MPS_FRAGS - L2CAP_PKT_OVERHEAD;
+        if (mps < L2CAP_LE_MIN_MPS)
+            mps = L2CAP_LE_MIN_MPS;
+        if (mps > L2CAP_LE_MAX_MPS)
+            mps = L2CAP_LE_MAX_MPS;
+        p_cfg->mps = (UINT16)mps;
+    }
+
+    if (p_cfg->credits == L2CAP_LE_AUTO_CFG)
+    {
+        /* Credits come back only as SDUs are read, so the peer must be able to
+         * send a whole SDU with the half we may be sitting on outstanding */
+        UINT32 sdu_pdus = ((UINT32)p_cfg->mtu + L2CAP_LCC_SDU_LENGTH + p_cfg->mps - 1) / p_cfg->mps;
+        UINT32 credits = L2CAP_LE_COC_RX_BUDGET / p_cfg->mps;
+        if (credits < 2 * sdu_pdus)
+            credits = 2 * sdu_pdus;
+        if (credits > L2CAP_LE_MAX_CREDIT)
+            credits = L2CAP_LE_MAX_CREDIT;
+        p_cfg->credits = (UINT16)credits;
+    }
+
+    p_ccb->ble_rx_credits_used = 0;
+
+    L2CAP_TRACE_DEBUG ("%s CID: 0x%04x mtu: %d mps: %d credits: %d", __func__,
+                       p_ccb->local_cid, p_cfg->mtu, p_cfg->mps, p_cfg->credits);
+}
+
 /*******************************************************************************
 **
 ** Function         l2cble_credit_based_conn_req
@@ -1314,6 +1421,7 @@ void l2cble_credit_based_conn_req (tL2C_CCB *p_ccb)
         return;
     }
 
+    l2cble_size_coc_rx(p_ccb);
     l2cu_send_peer_ble_credit_based_conn_req (p_ccb);
     return;
 }
@@ -1339,6 +1447,7 @@ void l2cble_credit_based_conn_res (tL2C_CCB *p_ccb, UINT16 result)
         return;
     }
 
+    l2cble_size_coc_rx(p_ccb);
     l2cu_send_peer_ble_credit_based_conn_res (p_ccb, result);
     return;
 }
@@ -1369,6 +1478,38 @@ void l2cble_send_flow_control_credit(tL2C_CCB *p_ccb, UINT16 credit_value)
 
 }
 
+/*******************************************************************************
+**
+** Function         l2cble_return_rx_credits
+**
+** Description      This function gives back the credits of PDUs the upper layer
+**                  is done with on an LE connection oriented channel. They are
+**                  sent in one packet once they reach half of the initial
+**                  credits, so the peer never runs dry waiting for them and we
+**                  don't answer every PDU.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_return_rx_credits(tL2C_CCB *p_ccb, UINT16 credits)
+{
+    /* Only an open channel has a peer waiting for credits */
+    if (p_ccb->chnl_state != CST_OPEN)
+        return;
+
+    UINT16 batch = p_ccb->local_conn_cfg.credits / 2;
+    if (batch == 0)
+        batch = 1;
+
+    p_ccb->ble_rx_credits_used += credits;
+    if (p_ccb->ble_rx_credits_used < batch)
+        return;
+
+    UINT16 credit = p_ccb->ble_rx_credits_used;
+    p_ccb->ble_rx_credits_used = 0;
+    l2c_csm_execute(p_ccb, L2CEVT_L2CA_SEND_FLOW_CONTROL_CREDIT, &credit);
+}
+
 /*******************************************************************************
 **
 ** Function         l2cble_send_peer_disc_req
@@ -846,7 +846,11 @@ void l2c_fcr_proc_pdu (tL2C_CCB *p_ccb, BT_HDR *p_buf)
 ** Function         l2c_lcc_proc_pdu
 **
 ** Description      This function is the entry point for processing of a
-**                  received PDU when in LE Coc flow control modes.
+**                  received PDU when in LE Coc flow control modes. The SDU
+**                  handed up counts the PDUs that carried it in layer_specific;
+**                  their credits go back to the peer once the upper layer
+**                  calls L2CA_LECocSduConsumed. Dropped PDUs give theirs back
+**                  right away.
 **
 ** Returns          -
 **
@@ -865,6 +869,7 @@ void l2c_lcc_proc_pdu(tL2C_CCB *p_ccb, BT_HDR *p_buf)
     {
         /* Discard the buffer */
         osi_free(p_buf);
+        l2cble_return_rx_credits(p_ccb, 1);
         return;
     }
 
@@ -876,6 +881,7 @@ void l2c_lcc_proc_pdu(tL2C_CCB *p_ccb, BT_HDR *p_buf)
         {
             /* Discard the buffer */
             osi_free(p_buf);
+            l2cble_return_rx_credits(p_ccb, 1);
             return;
         }
 
@@ -883,6 +889,7 @@ void l2c_lcc_proc_pdu(tL2C_CCB *p_ccb, BT_HDR *p_buf)
         if ((p_data = (BT_HDR *) osi_malloc(L2CAP_MAX_BUF_SIZE)) == NULL)
         {
             osi_free(p_buf);
+            l2cble_return_rx_credits(p_ccb, 1);
             return;
         }
 
@@ -893,6 +900,7 @@ void l2c_lcc_proc_pdu(tL2C_CCB *p_ccb, BT_HDR *p_buf)
         p_buf->len -= sizeof(sdu_length);
         p_buf->offset += sizeof(sdu_length);
         p_data->offset = 0;
+        p_data->layer_specific = 0;
 
     }
     else
@@ -900,6 +908,7 @@ void l2c_lcc_proc_pdu(tL2C_CCB *p_ccb, BT_HDR *p_buf)
 
     memcpy((UINT8*)(p_data + 1) + p_data->offset + p_data->len, (UINT8*)(p_buf + 1) + p_buf->offset, p_buf->len);
     p_data->len += p_buf->len;
+    p_data->layer_specific++;
     p = (UINT8*)(p_data+1) + p_data->offset;
     if (p_data->len == p_ccb->ble_sdu_length)
     {
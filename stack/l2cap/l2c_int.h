@@ -45,6 +45,7 @@
 #define L2CAP_LE_DEFAULT_MTU        512
 #define L2CAP_LE_DEFAULT_MPS        23
 #define L2CAP_LE_DEFAULT_CREDIT     1
+#define L2CAP_LE_AUTO_MPS_FRAGS     4   /* Most LE data packets per auto sized PDU */
 
 /*
  * Timeout values (in milliseconds).
@@ -279,6 +280,7 @@ typedef struct t_l2c_ccb
     BOOLEAN             is_first_seg;           /* Dtermine whether the received packet is the first segment or not */
     BT_HDR*             ble_sdu;                /* Buffer for storing unassembled sdu*/
     UINT16              ble_sdu_length;         /* Length of unassembled sdu length*/
+    UINT16              ble_rx_credits_used;    /* Credits of read PDUs not yet returned */
     struct t_l2c_ccb    *p_next_ccb;            /* Next CCB in the chain            */
     struct t_l2c_ccb    *p_prev_ccb;            /* Previous CCB in the chain        */
     struct t_l2c_linkcb *p_lcb;                 /* Link this CCB is assigned to     */
@@ -428,6 +430,8 @@ typedef struct t_l2c_linkcb
 #if (BLE_INCLUDED == TRUE)
     tBLE_ADDR_TYPE      ble_addr_type;
     UINT16              tx_data_len;            /* tx data length used in data length extension */
+    UINT16              rx_data_len;            /* rx data length, 0 until the controller reports it */
+    BOOLEAN             auto_data_len;          /* maximum data length requested on connection */
     fixed_queue_t       *le_sec_pending_q;      /* LE coc channels waiting for security check completion */
     UINT8               sec_act;
 #define L2C_BLE_CONN_UPDATE_DISABLE 0x1  /* disable update connection parameters */
@@ -767,6 +771,7 @@ extern void l2cble_conn_comp (UINT16 handle, UINT8 role, BD_ADDR bda, tBLE_ADDR_
                               UINT16 conn_interval, UINT16 conn_latency, UINT16 conn_timeout);
 extern BOOLEAN l2cble_init_direct_conn (tL2C_LCB *p_lcb);
 extern void l2cble_notify_le_connection (BD_ADDR bda);
+extern void l2cble_use_max_data_length (BD_ADDR bda);
 extern void l2c_ble_link_adjust_allocation (void);
 extern void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status);
 
@@ -774,6 +779,7 @@ extern void l2cble_credit_based_conn_req (tL2C_CCB *p_ccb);
 extern void l2cble_credit_based_conn_res (tL2C_CCB *p_ccb, UINT16 result);
 extern void l2cble_send_peer_disc_req(tL2C_CCB *p_ccb);
 extern void l2cble_send_flow_control_credit(tL2C_CCB *p_ccb, UINT16 credit_value);
+extern void l2cble_return_rx_credits(tL2C_CCB *p_ccb, UINT16 credits);
 extern BOOLEAN l2ble_sec_access_req(BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator, tL2CAP_SEC_CBACK *p_callback, void *p_ref_data);
 
 #if (defined BLE_LLT_INCLUDED) && (BLE_LLT_INCLUDED == TRUE)
@@ -72,7 +72,6 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
     tL2C_LCB    *p_lcb;
     tL2C_CCB    *p_ccb = NULL;
     UINT16      l2cap_len, rcv_cid, psm;
-    UINT16      credit;
 
     /* Extract the handle */
     STREAM_TO_UINT16 (handle, p);
@@ -235,10 +234,8 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
         {
             if (p_lcb->transport == BT_TRANSPORT_LE)
             {
+               // Its credit goes back once the upper layer reads the SDU
                l2c_lcc_proc_pdu(p_ccb,p_msg);
-               // Got a pkt, valid send out credits to the peer device
-               credit = L2CAP_LE_DEFAULT_CREDIT;
-               l2c_csm_execute(p_ccb, L2CEVT_L2CA_SEND_FLOW_CONTROL_CREDIT, &credit);
             }
             else
             {
@@ -865,6 +862,8 @@ void l2c_init (void)
 void l2c_free(void) {
     list_free(l2cb.rcv_pending_q);
     l2cb.rcv_pending_q = NULL;
+    alarm_free(l2cb.receive_hold_timer);
+    l2cb.receive_hold_timer = NULL;
 }
 
 void l2c_receive_hold_timer_timeout(UNUSED_ATTR void *data)
@@ -27,7 +27,6 @@
 #include <string.h>
 
 #include "osi/include/log.h"
-#include "osi/include/mutex.h"
 
 #include "btm_api.h"
 #include "btm_int.h"
@@ -1157,7 +1156,7 @@ int PORT_Purge (UINT16 handle, UINT8 purge_flags)
 
     if (purge_flags & PORT_PURGE_RXCLEAR)
     {
-        mutex_global_lock();    /* to prevent missing credit */
+        port_lock(p_port);    /* to prevent missing credit */
 
         count = fixed_queue_length(p_port->rx.queue);
 
@@ -1166,7 +1165,7 @@ int PORT_Purge (UINT16 handle, UINT8 purge_flags)
 
         p_port->rx.queue_size = 0;
 
-        mutex_global_unlock();
+        port_unlock(p_port);
 
         /* If we flowed controlled peer based on rx_queue size enable data again */
         if (count)
@@ -1175,14 +1174,14 @@ int PORT_Purge (UINT16 handle, UINT8 purge_flags)
 
     if (purge_flags & PORT_PURGE_TXCLEAR)
     {
-        mutex_global_lock(); /* to prevent tx.queue_size from being negative */
+        port_lock(p_port); /* to prevent tx.queue_size from being negative */
 
         while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->tx.queue)) != NULL)
             osi_free(p_buf);
 
         p_port->tx.queue_size = 0;
 
-        mutex_global_unlock();
+        port_unlock(p_port);
 
         events = PORT_EV_TXEMPTY;
 
@@ -1258,11 +1257,11 @@ int PORT_ReadData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
 
             *p_len += max_len;
 
-            mutex_global_lock();
+            port_lock(p_port);
 
             p_port->rx.queue_size -= max_len;
 
-            mutex_global_unlock();
+            port_unlock(p_port);
 
             break;
         }
@@ -1273,7 +1272,7 @@ int PORT_ReadData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
             *p_len  += p_buf->len;
             max_len -= p_buf->len;
 
-            mutex_global_lock();
+            port_lock(p_port);
 
             p_port->rx.queue_size -= p_buf->len;
 
@@ -1284,7 +1283,7 @@ int PORT_ReadData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
 
             osi_free(fixed_queue_try_dequeue(p_port->rx.queue));
 
-            mutex_global_unlock();
+            port_unlock(p_port);
 
             count++;
         }
@@ -1341,14 +1340,14 @@ int PORT_Read (UINT16 handle, BT_HDR **pp_buf)
         return (PORT_LINE_ERR);
     }
 
-    mutex_global_lock();
+    port_lock(p_port);
 
     p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->rx.queue);
     if (p_buf)
     {
         p_port->rx.queue_size -= p_buf->len;
 
-        mutex_global_unlock();
+        port_unlock(p_port);
 
         /* If rfcomm suspended traffic from the peer based on the rx_queue_size */
         /* check if it can be resumed now */
@@ -1356,7 +1355,7 @@ int PORT_Read (UINT16 handle, BT_HDR **pp_buf)
     }
     else
     {
-        mutex_global_unlock();
+        port_unlock(p_port);
     }
 
     *pp_buf = p_buf;
@@ -1491,6 +1490,46 @@ int PORT_Write (UINT16 handle, BT_HDR *p_buf)
 
     return (PORT_SUCCESS);
 }
+/*******************************************************************************
+**
+** Function         port_tx_buf_capacity
+**
+** Description      Returns how many data bytes a transmit buffer of the port
+**                  holds: one frame to the peer, but no more than would fit
+**                  into the default buffer size.
+**
+*******************************************************************************/
+static UINT16 port_tx_buf_capacity (tPORT *p_port)
+{
+    UINT16 length = RFCOMM_DATA_BUF_SIZE -
+            (UINT16)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
+
+    return ((p_port->peer_mtu < length) ? p_port->peer_mtu : length);
+}
+
+/*******************************************************************************
+**
+** Function         port_alloc_tx_buf
+**
+** Description      Allocates an empty transmit buffer of RFCOMM_DATA_BUF_SIZE.
+**                  The peer MTU may still grow with parameter negotiation
+**                  after buffers were queued, so they are not sized to it:
+**                  data appended to the last buffer of the transmit queue is
+**                  bounded by port_tx_buf_capacity(), which the default size
+**                  always holds.
+**
+*******************************************************************************/
+static BT_HDR *port_alloc_tx_buf (tPORT *p_port)
+{
+    BT_HDR *p_buf = (BT_HDR *)osi_malloc(RFCOMM_DATA_BUF_SIZE);
+
+    p_buf->offset         = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+    p_buf->len            = 0;
+    p_buf->layer_specific = p_port->inx;
+    p_buf->event          = BT_EVT_TO_BTU_SP_DATA;
+    return (p_buf);
+}
+
 /*******************************************************************************
 **
 ** Function         PORT_WriteDataCO
@@ -1544,12 +1583,11 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
     if(available == 0)
         return PORT_SUCCESS;
     /* Length for each buffer is the smaller of GKI buffer, peer MTU, or max_len */
-    length = RFCOMM_DATA_BUF_SIZE -
-            (UINT16)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
+    length = port_tx_buf_capacity (p_port);
 
     /* If there are buffers scheduled for transmission check if requested */
     /* data fits into the end of the queue */
-    mutex_global_lock();
+    port_lock(p_port);
 
     if (((p_buf = (BT_HDR *)fixed_queue_try_peek_last(p_port->tx.queue)) != NULL)
      && (((int)p_buf->len + available) <= (int)p_port->peer_mtu)
@@ -1561,7 +1599,7 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
 
         {
             error("p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, available:%d", available);
-            mutex_global_unlock();
+            port_unlock(p_port);
             return (PORT_UNKNOWN_ERROR);
         }
         //memcpy ((UINT8 *)(p_buf + 1) + p_buf->offset + p_buf->len, p_data, max_len);
@@ -1570,12 +1608,12 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
         *p_len = available;
         p_buf->len += (UINT16)available;
 
-        mutex_global_unlock();
+        port_unlock(p_port);
 
         return (PORT_SUCCESS);
     }
 
-    mutex_global_unlock();
+    port_unlock(p_port);
 
     //int max_read = length < p_port->peer_mtu ? length : p_port->peer_mtu;
 
@@ -1595,16 +1633,11 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
          }
 
         /* continue with rfcomm data write */
-        p_buf = (BT_HDR *)osi_malloc(RFCOMM_DATA_BUF_SIZE);
-        p_buf->offset         = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-        p_buf->layer_specific = handle;
+        p_buf = port_alloc_tx_buf (p_port);
 
-        if (p_port->peer_mtu < length)
-            length = p_port->peer_mtu;
         if (available < (int)length)
             length = (UINT16)available;
         p_buf->len = length;
-        p_buf->event          = BT_EVT_TO_BTU_SP_DATA;
 
         //memcpy ((UINT8 *)(p_buf + 1) + p_buf->offset, p_data, length);
         //if(recv(fd, (UINT8 *)(p_buf + 1) + p_buf->offset, (int)length, 0) != (int)length)
@@ -1612,6 +1645,7 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
                                       DATA_CO_CALLBACK_TYPE_OUTGOING) == FALSE)
         {
             error("p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d", length);
+            osi_free(p_buf);
             return (PORT_UNKNOWN_ERROR);
         }
 
@@ -1689,12 +1723,11 @@ int PORT_WriteData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
     }
 
     /* Length for each buffer is the smaller of GKI buffer, peer MTU, or max_len */
-    length = RFCOMM_DATA_BUF_SIZE -
-            (UINT16)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
+    length = port_tx_buf_capacity (p_port);
 
     /* If there are buffers scheduled for transmission check if requested */
     /* data fits into the end of the queue */
-    mutex_global_lock();
+    port_lock(p_port);
 
     if (((p_buf = (BT_HDR *)fixed_queue_try_peek_last(p_port->tx.queue)) != NULL)
      && ((p_buf->len + max_len) <= p_port->peer_mtu)
@@ -1706,12 +1739,12 @@ int PORT_WriteData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
         *p_len = max_len;
         p_buf->len += max_len;
 
-        mutex_global_unlock();
+        port_unlock(p_port);
 
         return (PORT_SUCCESS);
     }
 
-    mutex_global_unlock();
+    port_unlock(p_port);
 
     while (max_len)
     {
@@ -1721,16 +1754,11 @@ int PORT_WriteData (UINT16 handle, char *p_data, UINT16 max_len, UINT16 *p_len)
             break;
 
         /* continue with rfcomm data write */
-        p_buf = (BT_HDR *)osi_malloc(RFCOMM_DATA_BUF_SIZE);
-        p_buf->offset         = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-        p_buf->layer_specific = handle;
+        p_buf = port_alloc_tx_buf (p_port);
 
-        if (p_port->peer_mtu < length)
-            length = p_port->peer_mtu;
         if (max_len < length)
             length = max_len;
         p_buf->len = length;
-        p_buf->event          = BT_EVT_TO_BTU_SP_DATA;
 
         memcpy ((UINT8 *)(p_buf + 1) + p_buf->offset, p_data, length);
 
@@ -1819,6 +1847,7 @@ int PORT_Test (UINT16 handle, UINT8 *p_data, UINT16 len)
 void RFCOMM_Init (void)
 {
     memset (&rfc_cb, 0, sizeof (tRFC_CB));  /* Init RFCOMM control block */
+    port_init_locks ();
 
     rfc_cb.rfc.last_mux = MAX_BD_CONNECTIONS;
 
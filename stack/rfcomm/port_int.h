@@ -25,6 +25,8 @@
 #ifndef PORT_INT_H
 #define PORT_INT_H
 
+#include <pthread.h>
+
 #include "bt_target.h"
 #include "osi/include/alarm.h"
 #include "osi/include/fixed_queue.h"
@@ -213,6 +215,9 @@ typedef struct
 {
     tPORT        port[MAX_RFC_PORTS];            /* Port info pool */
     tRFC_MCB     rfc_mcb[MAX_BD_CONNECTIONS];    /* RFCOMM bd_connections pool */
+    pthread_mutex_t port_lock[MAX_RFC_PORTS];    /* Guards the data queues of each port. */
+                                                 /* Kept outside tPORT, which is cleared */
+                                                 /* when a port is allocated or released */
 } tPORT_CB;
 
 #ifdef __cplusplus
@@ -233,6 +238,9 @@ extern tPORT    *port_find_port (UINT8 dlci, BD_ADDR bd_addr);
 extern UINT32   port_get_signal_changes (tPORT *p_port, UINT8 old_signals, UINT8 signal);
 extern UINT32   port_flow_control_user (tPORT *p_port);
 extern void     port_flow_control_peer(tPORT *p_port, BOOLEAN enable, UINT16 count);
+extern void     port_init_locks (void);
+extern void     port_lock (tPORT *p_port);
+extern void     port_unlock (tPORT *p_port);
 
 /*
 ** Functions provided by the port_rfc.c
@@ -24,8 +24,6 @@
  ******************************************************************************/
 #include <string.h>
 
-#include "osi/include/mutex.h"
-
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bt_utils.h"
@@ -890,12 +888,12 @@ void PORT_DataInd (tRFC_MCB *p_mcb, UINT8 dlci, BT_HDR *p_buf)
         }
     }
 
-    mutex_global_lock();
+    port_lock(p_port);
 
     fixed_queue_enqueue(p_port->rx.queue, p_buf);
     p_port->rx.queue_size += p_buf->len;
 
-    mutex_global_unlock();
+    port_unlock(p_port);
 
     /* perform flow control procedures if necessary */
     port_flow_control_peer(p_port, FALSE, 0);
@@ -999,13 +997,13 @@ UINT32 port_rfc_send_tx_data (tPORT *p_port)
         while (!p_port->tx.peer_fc && p_port->rfc.p_mcb && p_port->rfc.p_mcb->peer_ready)
         {
             /* get data from tx queue and send it */
-            mutex_global_lock();
+            port_lock(p_port);
 
             if ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->tx.queue)) != NULL)
             {
                 p_port->tx.queue_size -= p_buf->len;
 
-                mutex_global_unlock();
+                port_unlock(p_port);
 
                 RFCOMM_TRACE_DEBUG ("Sending RFCOMM_DataReq tx.queue_size=%d", p_port->tx.queue_size);
 
@@ -1022,7 +1020,7 @@ UINT32 port_rfc_send_tx_data (tPORT *p_port)
             /* queue is empty-- all data sent */
             else
             {
-                mutex_global_unlock();
+                port_unlock(p_port);
 
                 events |= PORT_EV_TXEMPTY;
                 break;
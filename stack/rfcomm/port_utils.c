@@ -23,8 +23,6 @@
  ******************************************************************************/
 #include <string.h>
 
-#include "osi/include/mutex.h"
-
 #include "bt_target.h"
 #include "bt_common.h"
 #include "btm_int.h"
@@ -213,7 +211,7 @@ void port_release_port(tPORT *p_port)
     RFCOMM_TRACE_DEBUG("%s p_port: %p state: %d keep_handle: %d", __func__,
         p_port, p_port->rfc.state, p_port->keep_port_handle);
 
-    mutex_global_lock();
+    port_lock(p_port);
     BT_HDR *p_buf;
     while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->rx.queue)) != NULL)
         osi_free(p_buf);
@@ -222,7 +220,7 @@ void port_release_port(tPORT *p_port)
     while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->tx.queue)) != NULL)
         osi_free(p_buf);
     p_port->tx.queue_size = 0;
-    mutex_global_unlock();
+    port_unlock(p_port);
 
     alarm_cancel(p_port->rfc.port_timer);
 
@@ -590,3 +588,45 @@ void port_flow_control_peer(tPORT *p_port, BOOLEAN enable, UINT16 count)
     }
 }
 
+
+/*******************************************************************************
+**
+** Function         port_init_locks
+**
+** Description      Initializes the locks guarding the data queues of the ports.
+**                  Called once the RFCOMM control block has been cleared.
+**
+*******************************************************************************/
+void port_init_locks (void)
+{
+    for (int xx = 0; xx < MAX_RFC_PORTS; xx++)
+        pthread_mutex_init (&rfc_cb.port.port_lock[xx], NULL);
+}
+
+/*******************************************************************************
+**
+** Function         port_lock
+**
+** Description      Locks the tx and rx queues of a port, together with their
+**                  sizes, against the application threads reading and writing
+**                  data through the PORT API. Each port has its own lock so
+**                  that a busy port does not stall other ports or unrelated
+**                  users of the global lock.
+**
+*******************************************************************************/
+void port_lock (tPORT *p_port)
+{
+    pthread_mutex_lock (&rfc_cb.port.port_lock[p_port - rfc_cb.port.port]);
+}
+
+/*******************************************************************************
+**
+** Function         port_unlock
+**
+** Description      Unlocks the data queues of a port locked by port_lock.
+**
+*******************************************************************************/
+void port_unlock (tPORT *p_port)
+{
+    pthread_mutex_unlock (&rfc_cb.port.port_lock[p_port - rfc_cb.port.port]);
+}
@@ -260,7 +260,6 @@ extern tRFC_CB *rfc_cb_ptr;
 #define RFCOMM_UA_FCS(p_data, cr, dlci)    rfc_ua_fcs[cr][dlci]
 #define RFCOMM_DM_FCS(p_data, cr, dlci)    rfc_dm_fcs[cr][dlci]
 #define RFCOMM_DISC_FCS(p_data, cr, dlci)  rfc_disc_fcs[cr][dlci]
-#define RFCOMM_UIH_FCS(p_data, dlci)       rfc_uih_fcs[dlci]
 
 #else
 
@@ -270,10 +269,13 @@ extern  UINT8 rfc_calc_fcs (UINT16 len, UINT8 *p);
 #define RFCOMM_UA_FCS(p_data, cr, dlci)    rfc_calc_fcs(3, p_data)
 #define RFCOMM_DM_FCS(p_data, cr, dlci)    rfc_calc_fcs(3, p_data)
 #define RFCOMM_DISC_FCS(p_data, cr, dlci)  rfc_calc_fcs(3, p_data)
-#define RFCOMM_UIH_FCS(p_data, dlci)       rfc_calc_fcs(2, p_data)
 
 #endif
 
+/* UIH frames use the precomputed FCS of their address and control octets */
+#define RFCOMM_UIH_FCS(p_data) \
+    rfc_uih_fcs[((p_data)[1] & RFCOMM_PF) ? 1 : 0][(p_data)[0]]
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -307,7 +309,7 @@ extern void      rfc_timer_stop (tRFC_MCB *p_rfc_mcb);
 extern void      rfc_port_timer_start (tPORT *p_port, UINT16 tout);
 extern void      rfc_port_timer_stop (tPORT *p_port);
 
-BOOLEAN   rfc_check_uih_fcs (UINT8 dlci, UINT8 received_fcs);
+extern const UINT8 rfc_uih_fcs[2][256];
 BOOLEAN   rfc_check_fcs (UINT16 len, UINT8 *p, UINT8 received_fcs);
 tRFC_MCB  *rfc_find_lcid_mcb (UINT16 lcid);
 extern void      rfc_save_lcid_mcb (tRFC_MCB *p_rfc_mcb, UINT16 lcid);
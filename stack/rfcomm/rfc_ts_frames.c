@@ -197,7 +197,7 @@ void rfc_send_buf_uih (tRFC_MCB *p_mcb, UINT8 dlci, BT_HDR *p_buf)
 
     p_data  = (UINT8 *)(p_buf + 1) + p_buf->offset + p_buf->len++;
 
-    *p_data = RFCOMM_UIH_FCS ((UINT8 *)(p_buf + 1) + p_buf->offset, dlci);
+    *p_data = RFCOMM_UIH_FCS ((UINT8 *)(p_buf + 1) + p_buf->offset);
 
     if (dlci == RFCOMM_MX_DLCI)
     {
@@ -520,7 +520,7 @@ void rfc_send_credit(tRFC_MCB *p_mcb, UINT8 dlci, UINT8 credit)
     *p_data++ = RFCOMM_UIH | RFCOMM_PF;
     *p_data++ = RFCOMM_EA | 0;
     *p_data++ = credit;
-    *p_data   = RFCOMM_UIH_FCS ((UINT8 *)(p_buf + 1) + p_buf->offset, dlci);
+    *p_data   = RFCOMM_UIH_FCS ((UINT8 *)(p_buf + 1) + p_buf->offset);
 
     p_buf->len = 5;
 
@@ -579,6 +579,19 @@ UINT8 rfc_parse_data (tRFC_MCB *p_mcb, MX_FRAME *p_frame, BT_HDR *p_buf)
 
     fcs = *(p_data + len);
 
+    /* UIH frames carry all the data traffic, so check them first. Their FCS */
+    /* only covers the address and control octets and is a table lookup. */
+    if ((p_frame->type == RFCOMM_UIH) && RFCOMM_VALID_DLCI(p_frame->dlci)
+     && (fcs == RFCOMM_UIH_FCS(p_start)))
+    {
+        if (RFCOMM_FRAME_IS_RSP(p_mcb->is_initiator, p_frame->cr))
+        {
+            /* we assume that this is ok to allow bad implementations to work */
+            RFCOMM_TRACE_ERROR ("Bad UIH - response");
+        }
+        return (RFC_EVENT_UIH);
+    }
+
     /* All control frames that we are sending are sent with P=1, expect */
     /* reply with F=1 */
     /* According to TS 07.10 spec ivalid frames are discarded without */
@@ -635,19 +648,11 @@ UINT8 rfc_parse_data (tRFC_MCB *p_mcb, MX_FRAME *p_frame, BT_HDR *p_buf)
             RFCOMM_TRACE_ERROR ("Bad UIH - invalid DLCI");
             return (RFC_EVENT_BAD_FRAME);
         }
-        else if (!rfc_check_fcs (2, p_start, fcs))
+        else
         {
             RFCOMM_TRACE_ERROR ("Bad UIH - FCS");
             return (RFC_EVENT_BAD_FRAME);
         }
-        else if (RFCOMM_FRAME_IS_RSP(p_mcb->is_initiator, p_frame->cr))
-        {
-            /* we assume that this is ok to allow bad implementations to work */
-            RFCOMM_TRACE_ERROR ("Bad UIH - response");
-            return (RFC_EVENT_UIH);
-        }
-        else
-            return (RFC_EVENT_UIH);
     }
 
     return (RFC_EVENT_BAD_FRAME);
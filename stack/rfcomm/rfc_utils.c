@@ -69,6 +69,61 @@ static const UINT8 rfc_crctable[] =
     0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1,  0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF
 };
 
+/*******************************************************************************
+**
+** Variable         rfc_uih_fcs
+**
+** Description      FCS of every UIH frame header, indexed by the P/F (credit)
+**                  bit and the address octet. The UIH FCS only covers the
+**                  address and control octets, so for data frames the whole
+**                  check reduces to a lookup in this table.
+*******************************************************************************/
+const UINT8 rfc_uih_fcs[2][256] =
+{
+    {
+        0xC7, 0xAA, 0x1D, 0x70, 0xB2, 0xDF, 0x68, 0x05,  0x2D, 0x40, 0xF7, 0x9A, 0x58, 0x35, 0x82, 0xEF,
+        0xD2, 0xBF, 0x08, 0x65, 0xA7, 0xCA, 0x7D, 0x10,  0x38, 0x55, 0xE2, 0x8F, 0x4D, 0x20, 0x97, 0xFA,
+        0xED, 0x80, 0x37, 0x5A, 0x98, 0xF5, 0x42, 0x2F,  0x07, 0x6A, 0xDD, 0xB0, 0x72, 0x1F, 0xA8, 0xC5,
+        0xF8, 0x95, 0x22, 0x4F, 0x8D, 0xE0, 0x57, 0x3A,  0x12, 0x7F, 0xC8, 0xA5, 0x67, 0x0A, 0xBD, 0xD0,
+
+        0x93, 0xFE, 0x49, 0x24, 0xE6, 0x8B, 0x3C, 0x51,  0x79, 0x14, 0xA3, 0xCE, 0x0C, 0x61, 0xD6, 0xBB,
+        0x86, 0xEB, 0x5C, 0x31, 0xF3, 0x9E, 0x29, 0x44,  0x6C, 0x01, 0xB6, 0xDB, 0x19, 0x74, 0xC3, 0xAE,
+        0xB9, 0xD4, 0x63, 0x0E, 0xCC, 0xA1, 0x16, 0x7B,  0x53, 0x3E, 0x89, 0xE4, 0x26, 0x4B, 0xFC, 0x91,
+        0xAC, 0xC1, 0x76, 0x1B, 0xD9, 0xB4, 0x03, 0x6E,  0x46, 0x2B, 0x9C, 0xF1, 0x33, 0x5E, 0xE9, 0x84,
+
+        0x6F, 0x02, 0xB5, 0xD8, 0x1A, 0x77, 0xC0, 0xAD,  0x85, 0xE8, 0x5F, 0x32, 0xF0, 0x9D, 0x2A, 0x47,
+        0x7A, 0x17, 0xA0, 0xCD, 0x0F, 0x62, 0xD5, 0xB8,  0x90, 0xFD, 0x4A, 0x27, 0xE5, 0x88, 0x3F, 0x52,
+        0x45, 0x28, 0x9F, 0xF2, 0x30, 0x5D, 0xEA, 0x87,  0xAF, 0xC2, 0x75, 0x18, 0xDA, 0xB7, 0x00, 0x6D,
+        0x50, 0x3D, 0x8A, 0xE7, 0x25, 0x48, 0xFF, 0x92,  0xBA, 0xD7, 0x60, 0x0D, 0xCF, 0xA2, 0x15, 0x78,
+
+        0x3B, 0x56, 0xE1, 0x8C, 0x4E, 0x23, 0x94, 0xF9,  0xD1, 0xBC, 0x0B, 0x66, 0xA4, 0xC9, 0x7E, 0x13,
+        0x2E, 0x43, 0xF4, 0x99, 0x5B, 0x36, 0x81, 0xEC,  0xC4, 0xA9, 0x1E, 0x73, 0xB1, 0xDC, 0x6B, 0x06,
+        0x11, 0x7C, 0xCB, 0xA6, 0x64, 0x09, 0xBE, 0xD3,  0xFB, 0x96, 0x21, 0x4C, 0x8E, 0xE3, 0x54, 0x39,
+        0x04, 0x69, 0xDE, 0xB3, 0x71, 0x1C, 0xAB, 0xC6,  0xEE, 0x83, 0x34, 0x59, 0x9B, 0xF6, 0x41, 0x2C
+    },
+    {
+        0xDB, 0xB6, 0x01, 0x6C, 0xAE, 0xC3, 0x74, 0x19,  0x31, 0x5C, 0xEB, 0x86, 0x44, 0x29, 0x9E, 0xF3,
+        0xCE, 0xA3, 0x14, 0x79, 0xBB, 0xD6, 0x61, 0x0C,  0x24, 0x49, 0xFE, 0x93, 0x51, 0x3C, 0x8B, 0xE6,
+        0xF1, 0x9C, 0x2B, 0x46, 0x84, 0xE9, 0x5E, 0x33,  0x1B, 0x76, 0xC1, 0xAC, 0x6E, 0x03, 0xB4, 0xD9,
+        0xE4, 0x89, 0x3E, 0x53, 0x91, 0xFC, 0x4B, 0x26,  0x0E, 0x63, 0xD4, 0xB9, 0x7B, 0x16, 0xA1, 0xCC,
+
+        0x8F, 0xE2, 0x55, 0x38, 0xFA, 0x97, 0x20, 0x4D,  0x65, 0x08, 0xBF, 0xD2, 0x10, 0x7D, 0xCA, 0xA7,
+        0x9A, 0xF7, 0x40, 0x2D, 0xEF, 0x82, 0x35, 0x58,  0x70, 0x1D, 0xAA, 0xC7, 0x05, 0x68, 0xDF, 0xB2,
+        0xA5, 0xC8, 0x7F, 0x12, 0xD0, 0xBD, 0x0A, 0x67,  0x4F, 0x22, 0x95, 0xF8, 0x3A, 0x57, 0xE0, 0x8D,
+        0xB0, 0xDD, 0x6A, 0x07, 0xC5, 0xA8, 0x1F, 0x72,  0x5A, 0x37, 0x80, 0xED, 0x2F, 0x42, 0xF5, 0x98,
+
+        0x73, 0x1E, 0xA9, 0xC4, 0x06, 0x6B, 0xDC, 0xB1,  0x99, 0xF4, 0x43, 0x2E, 0xEC, 0x81, 0x36, 0x5B,
+        0x66, 0x0B, 0xBC, 0xD1, 0x13, 0x7E, 0xC9, 0xA4,  0x8C, 0xE1, 0x56, 0x3B, 0xF9, 0x94, 0x23, 0x4E,
+        0x59, 0x34, 0x83, 0xEE, 0x2C, 0x41, 0xF6, 0x9B,  0xB3, 0xDE, 0x69, 0x04, 0xC6, 0xAB, 0x1C, 0x71,
+        0x4C, 0x21, 0x96, 0xFB, 0x39, 0x54, 0xE3, 0x8E,  0xA6, 0xCB, 0x7C, 0x11, 0xD3, 0xBE, 0x09, 0x64,
+
+        0x27, 0x4A, 0xFD, 0x90, 0x52, 0x3F, 0x88, 0xE5,  0xCD, 0xA0, 0x17, 0x7A, 0xB8, 0xD5, 0x62, 0x0F,
+        0x32, 0x5F, 0xE8, 0x85, 0x47, 0x2A, 0x9D, 0xF0,  0xD8, 0xB5, 0x02, 0x6F, 0xAD, 0xC0, 0x77, 0x1A,
+        0x0D, 0x60, 0xD7, 0xBA, 0x78, 0x15, 0xA2, 0xCF,  0xE7, 0x8A, 0x3D, 0x50, 0x92, 0xFF, 0x48, 0x25,
+        0x18, 0x75, 0xC2, 0xAF, 0x6D, 0x00, 0xB7, 0xDA,  0xF2, 0x9F, 0x28, 0x45, 0x87, 0xEA, 0x5D, 0x30
+    }
+};
+
 
 /*******************************************************************************
 **
@@ -0,0 +1,572 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string.h>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "btm_int.h"
+#include "btu.h"
+#include "device/include/controller.h"
+#include "device/include/interop.h"
+#include "gatt_int.h"
+#include "hcimsgs.h"
+#include "l2c_int.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/osi.h"
+#include "sdp_api.h"
+#include "stack_config.h"
+}
+
+// Links the fake BTM and controller know about.
+static const size_t MAX_LINKS = 8;
+
+static const uint16_t LE_ACL_DATA_SIZE = 251;
+static const uint16_t ACL_BUFS = 8;
+
+static bool controller_dle;
+static std::set<int> interop_features;
+static std::vector<FakeHciPacket> sent_packets;
+
+// The channels the fake peer accepted, by its own CID.
+static std::map<uint16_t, uint16_t> peer_channels;
+static uint16_t next_peer_cid;
+static uint8_t next_signal_id;
+
+static tACL_CONN acl_conns[MAX_LINKS];
+static tBTM_SEC_DEV_REC sec_dev_recs[MAX_LINKS];
+static bt_device_features_t ble_features;
+static UINT8 local_features[HCI_FEATURE_BYTES_PER_PAGE];
+static controller_t controller;
+static stack_config_t stack_config;
+
+static tACL_CONN *find_acl(const BD_ADDR bda) {
+  for (size_t i = 0; i < MAX_LINKS; ++i) {
+    if (acl_conns[i].in_use && !memcmp(acl_conns[i].remote_addr, bda, BD_ADDR_LEN))
+      return &acl_conns[i];
+  }
+  return NULL;
+}
+
+static tACL_CONN *alloc_acl(const BD_ADDR bda) {
+  tACL_CONN *p_acl = find_acl(bda);
+  for (size_t i = 0; p_acl == NULL && i < MAX_LINKS; ++i) {
+    if (!acl_conns[i].in_use)
+      p_acl = &acl_conns[i];
+  }
+  return p_acl;
+}
+
+static bool controller_supports_ble(void) { return true; }
+static bool controller_supports_ble_packet_extension(void) { return controller_dle; }
+static const bt_device_features_t *controller_get_features_ble(void) { return &ble_features; }
+static uint16_t controller_get_acl_data_size_classic(void) { return 1021; }
+static uint16_t controller_get_acl_packet_size_classic(void) { return 1021 + HCI_DATA_PREAMBLE_SIZE; }
+static uint16_t controller_get_acl_data_size_ble(void) { return LE_ACL_DATA_SIZE; }
+static uint16_t controller_get_acl_packet_size_ble(void) { return LE_ACL_DATA_SIZE + HCI_DATA_PREAMBLE_SIZE; }
+static uint16_t controller_get_ble_default_data_packet_length(void) { return BTM_BLE_DATA_SIZE_MIN; }
+
+static bool stack_config_false(void) { return false; }
+
+static void receive_acl(uint16_t handle, uint16_t cid, const uint8_t *data,
+                        uint16_t len) {
+  BT_HDR *p_msg = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + HCI_DATA_PREAMBLE_SIZE +
+                                       L2CAP_PKT_OVERHEAD + len);
+  UINT8 *p = (UINT8 *)(p_msg + 1);
+
+  p_msg->offset = 0;
+  p_msg->len = HCI_DATA_PREAMBLE_SIZE + L2CAP_PKT_OVERHEAD + len;
+  p_msg->layer_specific = 0;
+  p_msg->event = BT_EVT_TO_BTU_HCI_ACL;
+  UINT16_TO_STREAM(p, handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT));
+  UINT16_TO_STREAM(p, L2CAP_PKT_OVERHEAD + len);
+  UINT16_TO_STREAM(p, len);
+  UINT16_TO_STREAM(p, cid);
+  memcpy(p, data, len);
+
+  l2c_rcv_acl_data(p_msg);
+}
+
+static void send_signal(uint16_t handle, uint8_t code, uint8_t id,
+                        const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> cmd(L2CAP_CMD_OVERHEAD + data.size());
+  UINT8 *p = cmd.data();
+
+  UINT8_TO_STREAM(p, code);
+  UINT8_TO_STREAM(p, id);
+  UINT16_TO_STREAM(p, data.size());
+  memcpy(p, data.data(), data.size());
+  receive_acl(handle, L2CAP_SIGNALLING_CID, cmd.data(), cmd.size());
+}
+
+static void push_le16(std::vector<uint8_t> &data, uint16_t value) {
+  data.push_back(value & 0xff);
+  data.push_back(value >> 8);
+}
+
+// Answers one signaling command from the stack as the fake peer.
+static void answer_signal(uint16_t handle, const std::vector<uint8_t> &cmd,
+                          uint16_t peer_mtu) {
+  const UINT8 *p = cmd.data();
+  UINT8 code, id;
+  UINT16 len, type, peer_cid, local_cid;
+  std::vector<uint8_t> rsp;
+
+  ASSERT_GE(cmd.size(), (size_t)L2CAP_CMD_OVERHEAD);
+  STREAM_TO_UINT8(code, p);
+  STREAM_TO_UINT8(id, p);
+  STREAM_TO_UINT16(len, p);
+  ASSERT_EQ(cmd.size(), (size_t)(L2CAP_CMD_OVERHEAD + len));
+
+  switch (code) {
+    case L2CAP_CMD_INFO_REQ:
+      // Basic mode and no fixed channels besides signaling.
+      STREAM_TO_UINT16(type, p);
+      push_le16(rsp, type);
+      if (type == L2CAP_EXTENDED_FEATURES_INFO_TYPE) {
+        push_le16(rsp, L2CAP_INFO_RESP_RESULT_SUCCESS);
+        push_le16(rsp, 0);
+        push_le16(rsp, 0);
+      } else {
+        push_le16(rsp, L2CAP_INFO_RESP_RESULT_NOT_SUPPORTED);
+      }
+      send_signal(handle, L2CAP_CMD_INFO_RSP, id, rsp);
+      break;
+
+    case L2CAP_CMD_CONN_REQ: {
+      p += 2;  // PSM
+      STREAM_TO_UINT16(local_cid, p);
+      peer_cid = next_peer_cid++;
+      peer_channels[peer_cid] = local_cid;
+      push_le16(rsp, peer_cid);
+      push_le16(rsp, local_cid);
+      push_le16(rsp, L2CAP_CONN_OK);
+      push_le16(rsp, 0);
+      send_signal(handle, L2CAP_CMD_CONN_RSP, id, rsp);
+
+      // The peer configures its side of the channel right away.
+      std::vector<uint8_t> req;
+      push_le16(req, local_cid);
+      push_le16(req, 0);
+      req.push_back(L2CAP_CFG_TYPE_MTU);
+      req.push_back(L2CAP_CFG_MTU_OPTION_LEN);
+      push_le16(req, peer_mtu);
+      send_signal(handle, L2CAP_CMD_CONFIG_REQ, ++next_signal_id, req);
+      break;
+    }
+
+    case L2CAP_CMD_CONFIG_REQ:
+      // Everything the stack asks for is fine with the peer.
+      STREAM_TO_UINT16(peer_cid, p);
+      ASSERT_EQ(1u, peer_channels.count(peer_cid));
+      push_le16(rsp, peer_channels[peer_cid]);
+      push_le16(rsp, 0);
+      push_le16(rsp, L2CAP_CFG_OK);
+      send_signal(handle, L2CAP_CMD_CONFIG_RSP, id, rsp);
+      break;
+
+    case L2CAP_CMD_DISC_REQ:
+      STREAM_TO_UINT16(peer_cid, p);
+      STREAM_TO_UINT16(local_cid, p);
+      peer_channels.erase(peer_cid);
+      push_le16(rsp, peer_cid);
+      push_le16(rsp, local_cid);
+      send_signal(handle, L2CAP_CMD_DISC_RSP, id, rsp);
+      break;
+  }
+}
+
+extern "C" {
+
+// The fake controller.
+void bte_main_hci_send(BT_HDR *p_msg, UINT16 event) {
+  UINT8 *p = (UINT8 *)(p_msg + 1) + p_msg->offset;
+  UINT16 handle, hci_len, l2cap_len;
+  FakeHciPacket packet;
+
+  STREAM_TO_UINT16(handle, p);
+  STREAM_TO_UINT16(hci_len, p);
+  STREAM_TO_UINT16(l2cap_len, p);
+  packet.is_cmd = false;
+  packet.opcode = 0;
+  packet.handle = HCID_GET_HANDLE(handle);
+  STREAM_TO_UINT16(packet.cid, p);
+  packet.payload.assign(p, p + l2cap_len);
+  EXPECT_EQ(hci_len, l2cap_len + L2CAP_PKT_OVERHEAD);
+  sent_packets.push_back(packet);
+  osi_free(p_msg);
+}
+
+void btu_hcif_send_cmd(UINT8 controller_id, BT_HDR *p_msg) {
+  UINT8 *p = (UINT8 *)(p_msg + 1) + p_msg->offset;
+  UINT8 param_len;
+  FakeHciPacket packet;
+
+  packet.is_cmd = true;
+  packet.handle = 0;
+  packet.cid = 0;
+  STREAM_TO_UINT16(packet.opcode, p);
+  STREAM_TO_UINT8(param_len, p);
+  packet.payload.assign(p, p + param_len);
+  sent_packets.push_back(packet);
+  osi_free(p_msg);
+}
+
+const controller_t *controller_get_interface() { return &controller; }
+const stack_config_t *stack_config_get_interface() { return &stack_config; }
+
+bool interop_match_addr(const interop_feature_t feature, const bt_bdaddr_t *addr) {
+  return interop_features.count(feature) != 0;
+}
+bool interop_match_name(const interop_feature_t feature, const char *name) { return false; }
+
+// The fake BTM.
+tBTM_CB btm_cb;
+fixed_queue_t *btu_general_alarm_queue;
+extern const BD_ADDR BT_BD_ANY;
+const BD_ADDR BT_BD_ANY = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+UINT8 appl_trace_level;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...) {}
+
+tACL_CONN *btm_bda_to_acl(BD_ADDR bda, tBT_TRANSPORT transport) {
+  tACL_CONN *p_acl = find_acl(bda);
+  return (p_acl != NULL && p_acl->transport == transport) ? p_acl : NULL;
+}
+
+void btm_acl_created(BD_ADDR bda, DEV_CLASS dc, BD_NAME bdn, UINT16 hci_handle,
+                     UINT8 link_role, tBT_TRANSPORT transport) {
+  tACL_CONN *p_acl = alloc_acl(bda);
+  ASSERT_TRUE(p_acl != NULL);
+  p_acl->in_use = TRUE;
+  memcpy(p_acl->remote_addr, bda, BD_ADDR_LEN);
+  p_acl->hci_handle = hci_handle;
+  p_acl->link_role = link_role;
+  p_acl->transport = transport;
+}
+
+void btm_acl_removed(BD_ADDR bda, tBT_TRANSPORT transport) {
+  tACL_CONN *p_acl = btm_bda_to_acl(bda, transport);
+  if (p_acl != NULL)
+    memset(p_acl, 0, sizeof(*p_acl));
+}
+
+tBTM_SEC_DEV_REC *btm_find_dev(BD_ADDR bd_addr) {
+  for (size_t i = 0; i < MAX_LINKS; ++i) {
+    if ((sec_dev_recs[i].sec_flags & BTM_SEC_IN_USE) &&
+        !memcmp(sec_dev_recs[i].bd_addr, bd_addr, BD_ADDR_LEN))
+      return &sec_dev_recs[i];
+  }
+  return NULL;
+}
+
+tBTM_SEC_DEV_REC *btm_find_or_alloc_dev(BD_ADDR bd_addr) {
+  tBTM_SEC_DEV_REC *p_dev_rec = btm_find_dev(bd_addr);
+  for (size_t i = 0; p_dev_rec == NULL && i < MAX_LINKS; ++i) {
+    if (!(sec_dev_recs[i].sec_flags & BTM_SEC_IN_USE)) {
+      p_dev_rec = &sec_dev_recs[i];
+      p_dev_rec->sec_flags = BTM_SEC_IN_USE;
+      memcpy(p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
+    }
+  }
+  return p_dev_rec;
+}
+
+// As in btm_ble.c; the controller caps the length to what it supports.
+tBTM_STATUS BTM_SetBleDataLength(BD_ADDR bd_addr, UINT16 tx_pdu_length) {
+  tACL_CONN *p_acl = btm_bda_to_acl(bd_addr, BT_TRANSPORT_LE);
+
+  if (!controller_dle)
+    return BTM_ILLEGAL_VALUE;
+  if (p_acl == NULL)
+    return BTM_WRONG_MODE;
+  if (!HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
+    return BTM_ILLEGAL_VALUE;
+
+  if (tx_pdu_length > BTM_BLE_DATA_SIZE_MAX)
+    tx_pdu_length = BTM_BLE_DATA_SIZE_MAX;
+  else if (tx_pdu_length < BTM_BLE_DATA_SIZE_MIN)
+    tx_pdu_length = BTM_BLE_DATA_SIZE_MIN;
+  btsnd_hcic_ble_set_data_length(p_acl->hci_handle, tx_pdu_length,
+                                 BTM_BLE_DATA_TX_TIME_MAX);
+  return BTM_SUCCESS;
+}
+
+UINT16 BTM_GetHCIConnHandle(BD_ADDR remote_bda, tBT_TRANSPORT transport) {
+  tACL_CONN *p_acl = btm_bda_to_acl(remote_bda, transport);
+  return p_acl ? p_acl->hci_handle : 0xFFFF;
+}
+
+UINT16 BTM_GetNumAclLinks(void) {
+  UINT16 num = 0;
+  for (size_t i = 0; i < MAX_LINKS; ++i)
+    num += acl_conns[i].in_use ? 1 : 0;
+  return num;
+}
+
+BOOLEAN BTM_GetSecurityFlagsByTransport(BD_ADDR bd_addr, UINT8 *p_sec_flags,
+                                        tBT_TRANSPORT transport) {
+  *p_sec_flags = 0;
+  return TRUE;
+}
+
+void BTM_ReadDevInfo(BD_ADDR remote_bda, tBT_DEVICE_TYPE *p_dev_type,
+                     tBLE_ADDR_TYPE *p_addr_type) {
+  *p_dev_type = BT_DEVICE_TYPE_BLE;
+  *p_addr_type = BLE_ADDR_PUBLIC;
+}
+
+BOOLEAN BTM_BleDataSignature(BD_ADDR bd_addr, UINT8 *p_text, UINT16 len,
+                             BLE_SIGNATURE signature) { return FALSE; }
+BOOLEAN BTM_BleVerifySignature(BD_ADDR bd_addr, UINT8 *p_orig, UINT16 len,
+                               UINT32 counter, UINT8 *p_comp) { return FALSE; }
+void BTM_BleUpdateAdvFilterPolicy(tBTM_BLE_AFP adv_policy) {}
+BOOLEAN BTM_BleUpdateAdvWhitelist(BOOLEAN add_remove, BD_ADDR emote_bda) { return TRUE; }
+BOOLEAN BTM_BleUpdateBgConnDev(BOOLEAN add_remove, BD_ADDR remote_bda) { return TRUE; }
+BOOLEAN BTM_GetRemoteDeviceName(BD_ADDR bda, BD_NAME bdname) { return FALSE; }
+tBTM_INQ_INFO *BTM_InqDbRead(BD_ADDR p_bda) { return NULL; }
+BOOLEAN BTM_IsDeviceUp(void) { return TRUE; }
+UINT16 BTM_ReadConnectability(UINT16 *p_window, UINT16 *p_interval) { return 0; }
+UINT8 *BTM_ReadLocalFeatures(void) { return local_features; }
+tBTM_STATUS BTM_ReadPowerMode(BD_ADDR remote_bda, tBTM_PM_MODE *p_mode) {
+  *p_mode = BTM_PM_MD_ACTIVE;
+  return BTM_SUCCESS;
+}
+tBTM_STATUS BTM_SetEncryption(BD_ADDR bd_addr, tBT_TRANSPORT transport,
+                              tBTM_SEC_CBACK *p_callback, void *p_ref_data,
+                              tBTM_BLE_SEC_ACT sec_act) { return BTM_SUCCESS; }
+tBTM_STATUS BTM_SetLinkSuperTout(BD_ADDR remote_bda, UINT16 timeout) { return BTM_SUCCESS; }
+tBTM_STATUS BTM_SetPowerMode(UINT8 pm_id, BD_ADDR remote_bda,
+                             tBTM_PM_PWR_MD *p_mode) { return BTM_SUCCESS; }
+BOOLEAN BTM_SetSecurityLevel(BOOLEAN is_originator, char *p_name, UINT8 service_id,
+                             UINT16 sec_level, UINT16 psm, UINT32 mx_proto_id,
+                             UINT32 mx_chan_id) { return TRUE; }
+tBTM_STATUS BTM_SwitchRole(BD_ADDR remote_bd_addr, UINT8 new_role,
+                           tBTM_CMPL_CB *p_cb) { return BTM_MODE_UNSUPPORTED; }
+tBTM_STATUS BTM_VendorSpecificCommand(UINT16 opcode, UINT8 param_len,
+                                      UINT8 *p_param_buf,
+                                      tBTM_VSC_CMPL_CB *p_cb) { return BTM_MODE_UNSUPPORTED; }
+
+BOOLEAN btm_acl_notif_conn_collision(BD_ADDR bda) { return FALSE; }
+void btm_acl_paging(BT_HDR *p, BD_ADDR dest) { osi_free(p); }
+void btm_acl_update_busy_level(tBTM_BLI_EVENT event) {}
+void btm_ble_dequeue_direct_conn_req(BD_ADDR rem_bda) {}
+BOOLEAN btm_ble_disable_resolving_list(UINT8 rl_mask, BOOLEAN to_resume) { return TRUE; }
+void btm_ble_enable_resolving_list(UINT8 rl_mask) {}
+void btm_ble_enqueue_direct_conn_req(void *p_param) {}
+tBTM_BLE_CONN_ST btm_ble_get_conn_st(void) { return BLE_CONN_IDLE; }
+void btm_ble_set_conn_st(tBTM_BLE_CONN_ST new_st) {}
+BOOLEAN btm_ble_get_enc_key_type(BD_ADDR bd_addr, UINT8 *p_key_types) { return FALSE; }
+void btm_ble_link_sec_check(BD_ADDR bd_addr, tBTM_LE_AUTH_REQ auth_req,
+                            tBTM_BLE_SEC_REQ_ACT *p_sec_req_act) {
+  *p_sec_req_act = BTM_BLE_SEC_REQ_ACT_NONE;
+}
+UINT8 btm_ble_read_sec_key_size(BD_ADDR bd_addr) { return 0; }
+tBTM_STATUS btm_ble_set_connectability(UINT16 combined_mode) { return BTM_SUCCESS; }
+BOOLEAN btm_ble_suspend_bg_conn(void) { return TRUE; }
+BOOLEAN btm_ble_topology_check(tBTM_BLE_STATE_MASK request) { return TRUE; }
+void btm_ble_update_link_topology_mask(UINT8 role, BOOLEAN increase) {}
+BOOLEAN btm_dev_support_switch(BD_ADDR bd_addr) { return FALSE; }
+void btm_establish_continue(tACL_CONN *p_acl_cb) {}
+UINT16 btm_get_max_packet_size(BD_ADDR addr) { return 0; }
+BOOLEAN btm_is_sco_active_by_bdaddr(BD_ADDR remote_bda) { return FALSE; }
+BOOLEAN btm_random_pseudo_to_identity_addr(BD_ADDR random_pseudo,
+                                           UINT8 *p_static_addr_type) { return FALSE; }
+tBTM_STATUS btm_remove_acl(BD_ADDR bd_addr, tBT_TRANSPORT transport) { return BTM_SUCCESS; }
+void btm_remove_sco_links(BD_ADDR bda) {}
+void btm_sco_acl_removed(BD_ADDR bda) {}
+void btm_sec_abort_access_req(BD_ADDR bd_addr) {}
+UINT8 btm_sec_clr_service_by_psm(UINT16 psm) { return 0; }
+void btm_sec_clr_temp_auth_service(BD_ADDR bda) {}
+tBTM_STATUS btm_sec_disconnect(UINT16 handle, UINT8 reason) { return BTM_SUCCESS; }
+BOOLEAN btm_sec_is_a_bonded_dev(BD_ADDR bda) { return FALSE; }
+
+// No service asks for security, so access is granted right away.
+tBTM_STATUS btm_sec_l2cap_access_req(BD_ADDR bd_addr, UINT16 psm, UINT16 handle,
+                                     CONNECTION_TYPE conn_type,
+                                     tBTM_SEC_CALLBACK *p_callback,
+                                     void *p_ref_data) {
+  (*p_callback)(bd_addr, BT_TRANSPORT_BR_EDR, p_ref_data, BTM_SUCCESS);
+  return BTM_SUCCESS;
+}
+BOOLEAN btm_ble_start_sec_check(BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator,
+                                tBTM_SEC_CALLBACK *p_callback, void *p_ref_data) {
+  (*p_callback)(bd_addr, BT_TRANSPORT_LE, p_ref_data, BTM_SUCCESS);
+  return TRUE;
+}
+tBTM_STATUS btm_sec_mx_access_request(BD_ADDR bd_addr, UINT16 psm,
+                                      BOOLEAN is_originator, UINT32 mx_proto_id,
+                                      UINT32 mx_chan_id,
+                                      tBTM_SEC_CALLBACK *p_callback,
+                                      void *p_ref_data) {
+  (*p_callback)(bd_addr, BT_TRANSPORT_BR_EDR, p_ref_data, BTM_SUCCESS);
+  return BTM_SUCCESS;
+}
+
+void btu_check_bt_sleep(void) {}
+
+BOOLEAN SDP_AddAttribute(UINT32 handle, UINT16 attr_id, UINT8 attr_type,
+                         UINT32 attr_len, UINT8 *p_val) { return TRUE; }
+BOOLEAN SDP_AddProtocolList(UINT32 handle, UINT16 num_elem,
+                            tSDP_PROTOCOL_ELEM *p_elem_list) { return TRUE; }
+BOOLEAN SDP_AddServiceClassIdList(UINT32 handle, UINT16 num_services,
+                                  UINT16 *p_service_uuids) { return TRUE; }
+BOOLEAN SDP_AddUuidSequence(UINT32 handle, UINT16 attr_id, UINT16 num_uuids,
+                            UINT16 *p_uuids) { return TRUE; }
+UINT32 SDP_CreateRecord(void) { return 1; }
+BOOLEAN SDP_DeleteRecord(UINT32 handle) { return TRUE; }
+
+}  // extern "C"
+
+const uint16_t L2capTestHarness::kFirstPeerCid;
+
+void L2capTestHarness::SetUp() {
+  AlarmTestHarness::SetUp();
+
+  controller_dle = true;
+  interop_features.clear();
+  sent_packets.clear();
+  peer_channels.clear();
+  next_peer_cid = kFirstPeerCid;
+  next_signal_id = 0;
+  memset(acl_conns, 0, sizeof(acl_conns));
+  memset(sec_dev_recs, 0, sizeof(sec_dev_recs));
+  memset(&ble_features, 0, sizeof(ble_features));
+  memset(&btm_cb, 0, sizeof(btm_cb));
+
+  memset(&controller, 0, sizeof(controller));
+  controller.supports_ble = controller_supports_ble;
+  controller.supports_ble_packet_extension = controller_supports_ble_packet_extension;
+  controller.get_features_ble = controller_get_features_ble;
+  controller.get_acl_data_size_classic = controller_get_acl_data_size_classic;
+  controller.get_acl_packet_size_classic = controller_get_acl_packet_size_classic;
+  controller.get_acl_data_size_ble = controller_get_acl_data_size_ble;
+  controller.get_acl_packet_size_ble = controller_get_acl_packet_size_ble;
+  controller.get_ble_default_data_packet_length =
+      controller_get_ble_default_data_packet_length;
+
+  memset(&stack_config, 0, sizeof(stack_config));
+  stack_config.get_pts_conn_updates_disabled = stack_config_false;
+  stack_config.get_pts_le_nonconn_adv_enabled = stack_config_false;
+
+  btu_general_alarm_queue = fixed_queue_new(SIZE_MAX);
+
+  l2c_init();
+  l2c_link_processs_num_bufs(ACL_BUFS);
+  l2c_link_processs_ble_num_bufs(ACL_BUFS);
+  gatt_init();
+}
+
+void L2capTestHarness::TearDown() {
+  // Disconnects the links the way the HCI Disconnection Complete event
+  // does, which releases their L2CAP and GATT control blocks.
+  for (size_t i = 0; i < MAX_L2CAP_LINKS; ++i) {
+    if (l2cb.lcb_pool[i].in_use)
+      l2c_link_hci_disc_comp(l2cb.lcb_pool[i].handle, HCI_ERR_PEER_USER);
+  }
+  gatt_free();
+  l2c_free();
+  sent_packets.clear();
+  peer_channels.clear();
+
+  fixed_queue_free(btu_general_alarm_queue, osi_free);
+  btu_general_alarm_queue = NULL;
+
+  AlarmTestHarness::TearDown();
+}
+
+void L2capTestHarness::SetControllerDataLengthExtension(bool supported) {
+  controller_dle = supported;
+}
+
+void L2capTestHarness::SetControllerLeBuffers(uint16_t num_bufs) {
+  l2c_link_processs_ble_num_bufs(num_bufs);
+}
+
+void L2capTestHarness::AddInteropEntry(interop_feature_t feature) {
+  interop_features.insert(feature);
+}
+
+void L2capTestHarness::ConnectLe(const BD_ADDR bda, uint16_t handle,
+                                bool peer_data_length_ext) {
+  l2cble_conn_comp(handle, HCI_ROLE_SLAVE, (UINT8 *)bda, BLE_ADDR_PUBLIC,
+                   BTM_BLE_CONN_INT_MIN_DEF, 0, BTM_BLE_CONN_TIMEOUT_DEF);
+
+  tACL_CONN *p_acl = find_acl(bda);
+  ASSERT_TRUE(p_acl != NULL);
+  if (peer_data_length_ext)
+    p_acl->peer_le_features[HCI_LE_FEATURE_DATA_LEN_EXT_OFF] |=
+        HCI_LE_FEATURE_DATA_LEN_EXT_MASK;
+}
+
+void L2capTestHarness::RemoteVersionComplete(const BD_ADDR bda) {
+  // As btm_read_remote_version_complete() does for an LE link.
+  l2cble_notify_le_connection((UINT8 *)bda);
+  l2cble_use_max_data_length((UINT8 *)bda);
+}
+
+void L2capTestHarness::ConnectClassic(const BD_ADDR bda, uint16_t handle) {
+  ASSERT_TRUE(l2c_link_hci_conn_comp(HCI_SUCCESS, handle, (UINT8 *)bda));
+}
+
+void L2capTestHarness::AnswerSignaling(uint16_t handle, uint16_t peer_mtu) {
+  std::vector<FakeHciPacket> others;
+
+  // Each answer can make the stack send the next command.
+  while (!sent_packets.empty()) {
+    for (const FakeHciPacket &packet : TakePackets()) {
+      if (!packet.is_cmd && packet.handle == handle &&
+          packet.cid == L2CAP_SIGNALLING_CID)
+        answer_signal(handle, packet.payload, peer_mtu);
+      else
+        others.push_back(packet);
+    }
+  }
+  sent_packets.swap(others);
+}
+
+uint16_t L2capTestHarness::LocalCid(uint16_t peer_cid) {
+  EXPECT_EQ(1u, peer_channels.count(peer_cid));
+  return peer_channels[peer_cid];
+}
+
+void L2capTestHarness::Receive(uint16_t handle, uint16_t cid,
+                               const uint8_t *data, uint16_t len) {
+  receive_acl(handle, cid, data, len);
+}
+
+void L2capTestHarness::CompletePackets(uint16_t handle, uint16_t num) {
+  UINT8 evt[5];
+  UINT8 *p = evt;
+
+  UINT8_TO_STREAM(p, 1);
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, num);
+  l2c_link_process_num_completed_pkts(evt);
+}
+
+std::vector<FakeHciPacket> L2capTestHarness::TakePackets() {
+  std::vector<FakeHciPacket> packets;
+  packets.swap(sent_packets);
+  return packets;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "AlarmTestHarness.h"
+
+extern "C" {
+#include "bt_types.h"
+#include "device/include/interop.h"
+}
+
+// A packet L2CAP or GATT handed to the fake controller.
+struct FakeHciPacket {
+  bool is_cmd;
+  uint16_t opcode;               // HCI commands only.
+  uint16_t handle;               // ACL data only.
+  uint16_t cid;                  // ACL data only, the L2CAP channel.
+  std::vector<uint8_t> payload;  // Command parameters or L2CAP payload.
+};
+
+// Runs the real L2CAP and GATT code over a fake controller and BTM, so
+// that tests can bring up simulated links and see every HCI command and
+// ACL packet the stack sends on them.
+class L2capTestHarness : public AlarmTestHarness {
+  protected:
+    static const uint16_t kFirstPeerCid = 0x0040;
+
+    virtual void SetUp();
+    virtual void TearDown();
+
+    // The local controller's LE data length extension support and the
+    // number of LE ACL packets it buffers. Set before connecting.
+    void SetControllerDataLengthExtension(bool supported);
+    void SetControllerLeBuffers(uint16_t num_bufs);
+
+    // Makes the interop database match |feature| for every device.
+    void AddInteropEntry(interop_feature_t feature);
+
+    // Completes an LE connection in the slave role, as the HCI LE
+    // Connection Complete event does.
+    void ConnectLe(const BD_ADDR bda, uint16_t handle, bool peer_data_length_ext);
+
+    // Completes the BR/EDR connection L2CAP is paging for, as the HCI
+    // Connection Complete event does.
+    void ConnectClassic(const BD_ADDR bda, uint16_t handle);
+
+    // Answers the L2CAP signaling commands sent on the BR/EDR link
+    // |handle| as a peer accepting every channel does, with |peer_mtu| as
+    // its MTU. The peer numbers its channels from |kFirstPeerCid| up.
+    // Packets other than signaling stay pending.
+    void AnswerSignaling(uint16_t handle, uint16_t peer_mtu);
+
+    // Returns the local CID of the channel the peer knows as |peer_cid|.
+    uint16_t LocalCid(uint16_t peer_cid);
+
+    // Runs what BTM does once the remote version is read on an LE link.
+    void RemoteVersionComplete(const BD_ADDR bda);
+
+    // Delivers an L2CAP packet from the peer.
+    void Receive(uint16_t handle, uint16_t cid, const uint8_t *data, uint16_t len);
+
+    // Reports |num| packets of |handle| as sent by the controller.
+    void CompletePackets(uint16_t handle, uint16_t num);
+
+    // Returns the packets sent since the last call, oldest first.
+    std::vector<FakeHciPacket> TakePackets();
+};
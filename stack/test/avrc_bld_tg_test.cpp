@@ -0,0 +1,260 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "avrc_api.h"
+#include "avrc_defs.h"
+#include "avrc_int.h"
+#include "bt_common.h"
+#include "l2cdefs.h"
+
+// The AVRC sources under test only need the control block from the rest of
+// the stack; the trace sink is in L2capTestHarness.cpp.
+tAVRC_CB avrc_cb;
+}
+
+static const UINT8 kHandle = 0;
+
+// Owns the attribute strings handed to the builders.
+struct AttrText {
+  explicit AttrText(size_t num_attrs, size_t str_len)
+      : text(str_len, 'a'), elems(num_attrs), settings(num_attrs) {
+    for (size_t i = 0; i < num_attrs; i++) {
+      elems[i].attr_id = AVRC_MEDIA_ATTR_ID_TITLE;
+      elems[i].name.charset_id = AVRC_CHARSET_ID_UTF8;
+      elems[i].name.str_len = str_len;
+      elems[i].name.p_str = &text[0];
+
+      settings[i].attr_id = AVRC_PLAYER_SETTING_REPEAT;
+      settings[i].charset_id = AVRC_CHARSET_ID_UTF8;
+      settings[i].str_len = str_len;
+      settings[i].p_str = &text[0];
+    }
+  }
+
+  std::vector<UINT8> text;
+  std::vector<tAVRC_ATTR_ENTRY> elems;
+  std::vector<tAVRC_APP_SETTING_TEXT> settings;
+};
+
+static tAVRC_RESPONSE elem_attrs_rsp(AttrText *attrs) {
+  tAVRC_RESPONSE rsp;
+  memset(&rsp, 0, sizeof(rsp));
+  rsp.get_elem_attrs.pdu = AVRC_PDU_GET_ELEMENT_ATTR;
+  rsp.get_elem_attrs.status = AVRC_STS_NO_ERROR;
+  rsp.get_elem_attrs.opcode = AVRC_OP_VENDOR;
+  rsp.get_elem_attrs.num_attr = attrs->elems.size();
+  rsp.get_elem_attrs.p_attrs = attrs->elems.data();
+  return rsp;
+}
+
+static const UINT8 *rsp_data(const BT_HDR *p_pkt) {
+  return (const UINT8 *)(p_pkt + 1) + p_pkt->offset;
+}
+
+// pdu(1), packet type(1), then the big endian parameter length.
+static UINT16 vendor_param_len(const BT_HDR *p_pkt) {
+  const UINT8 *p = rsp_data(p_pkt) + 2;
+  return (p[0] << 8) | p[1];
+}
+
+static UINT8 vendor_attr_count(const BT_HDR *p_pkt) {
+  return rsp_data(p_pkt)[AVRC_MIN_META_HDR_SIZE];
+}
+
+// Writes the FCS after the payload of |p_pkt| the way L2CAP does for an ERTM
+// I-frame. The allocation tracker checks the canary after the buffer when it
+// is freed.
+static void append_ertm_fcs(BT_HDR *p_pkt) {
+  UINT8 *p = (UINT8 *)(p_pkt + 1) + p_pkt->offset + p_pkt->len;
+  UINT16_TO_STREAM(p, 0xF0F0);
+  p_pkt->len += L2CAP_FCS_LEN;
+}
+
+class AvrcBldTgTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      memset(&avrc_cb, 0, sizeof(avrc_cb));
+    }
+};
+
+TEST_F(AvrcBldTgTest, test_elem_attrs_beyond_default_buffer_size) {
+  // 20 titles of 255 octets do not fit a BT_DEFAULT_BUFFER_SIZE buffer.
+  AttrText attrs(20, 255);
+  tAVRC_RESPONSE rsp = elem_attrs_rsp(&attrs);
+  BT_HDR *p_pkt = NULL;
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(20, vendor_attr_count(p_pkt));
+  EXPECT_EQ(1 + 20 * (8 + 255), vendor_param_len(p_pkt));
+  EXPECT_EQ(AVRC_MIN_META_HDR_SIZE + 1 + 20 * (8 + 255), p_pkt->len);
+
+  osi_free(p_pkt);
+}
+
+TEST_F(AvrcBldTgTest, test_elem_attrs_append_to_built_packet) {
+  AttrText first(1, 4);
+  AttrText more(16, 255);
+  tAVRC_RESPONSE rsp = elem_attrs_rsp(&first);
+  BT_HDR *p_pkt = NULL;
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+
+  // The first packet is sized for a single short title; appending to it must
+  // not write past that allocation.
+  rsp = elem_attrs_rsp(&more);
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(AVRC_OP_VENDOR, p_pkt->event);
+  EXPECT_EQ(17, vendor_attr_count(p_pkt));
+  EXPECT_EQ(AVRC_MIN_META_HDR_SIZE + 1 + (8 + 4) + 16 * (8 + 255), p_pkt->len);
+
+  // The last title appended is intact at the end of the packet.
+  const UINT8 *p_last = rsp_data(p_pkt) + p_pkt->len - 255;
+  EXPECT_EQ(0, memcmp(p_last, more.text.data(), 255));
+
+  osi_free(p_pkt);
+}
+
+TEST_F(AvrcBldTgTest, test_app_setting_text_keeps_every_attribute) {
+  AttrText attrs(20, 255);
+  tAVRC_RESPONSE rsp;
+  memset(&rsp, 0, sizeof(rsp));
+  rsp.get_app_attr_txt.pdu = AVRC_PDU_GET_PLAYER_APP_ATTR_TEXT;
+  rsp.get_app_attr_txt.status = AVRC_STS_NO_ERROR;
+  rsp.get_app_attr_txt.opcode = AVRC_OP_VENDOR;
+  rsp.get_app_attr_txt.num_attr = attrs.settings.size();
+  rsp.get_app_attr_txt.p_attrs = attrs.settings.data();
+  BT_HDR *p_pkt = NULL;
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(20, vendor_attr_count(p_pkt));
+  EXPECT_EQ(1 + 20 * (4 + 255), vendor_param_len(p_pkt));
+
+  // Appending grows the packet rather than dropping attributes.
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(40, vendor_attr_count(p_pkt));
+  EXPECT_EQ(1 + 40 * (4 + 255), vendor_param_len(p_pkt));
+
+  osi_free(p_pkt);
+}
+
+TEST_F(AvrcBldTgTest, test_rejected_rsp_fits_exact_buffer) {
+  tAVRC_RESPONSE rsp;
+  memset(&rsp, 0, sizeof(rsp));
+  rsp.rsp.pdu = AVRC_PDU_GET_ELEMENT_ATTR;
+  rsp.rsp.status = AVRC_STS_INTERNAL_ERR;
+  rsp.rsp.opcode = AVRC_OP_VENDOR;
+  BT_HDR *p_pkt = NULL;
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(AVRC_MIN_META_HDR_SIZE + 1, p_pkt->len);
+  EXPECT_EQ(AVRC_STS_INTERNAL_ERR, rsp_data(p_pkt)[AVRC_MIN_META_HDR_SIZE]);
+
+  osi_free(p_pkt);
+}
+
+TEST_F(AvrcBldTgTest, test_browse_rsp_into_smaller_packet) {
+  tAVRC_RESPONSE rsp;
+  memset(&rsp, 0, sizeof(rsp));
+  rsp.get_tot_items.pdu = AVRC_PDU_GET_TOTAL_NUMBER_OF_ITEMS;
+  rsp.get_tot_items.status = AVRC_STS_NO_ERROR;
+  BT_HDR *p_pkt = NULL;
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldBrowseResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+
+  // A GetItemAttributes response is far larger than the buffer above.
+  AttrText attrs(16, 255);
+  memset(&rsp, 0, sizeof(rsp));
+  rsp.get_attrs.pdu = AVRC_PDU_GET_ITEM_ATTRIBUTES;
+  rsp.get_attrs.status = AVRC_STS_NO_ERROR;
+  rsp.get_attrs.attr_count = attrs.elems.size();
+  rsp.get_attrs.p_attr_list = attrs.elems.data();
+
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldBrowseResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+  EXPECT_EQ(AVRC_OP_BROWSE, p_pkt->event);
+  EXPECT_EQ(3 + 2 + 16 * (8 + 255), p_pkt->len);
+
+  osi_free(p_pkt);
+}
+
+TEST_F(AvrcBldTgTest, test_browse_rsp_keeps_fcs_tailroom) {
+  // Every title length, so some response fills its buffer to the byte.
+  for (size_t str_len = 0; str_len <= 300; str_len++) {
+    AttrText attrs(1, str_len);
+    tAVRC_RESPONSE rsp;
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.get_attrs.pdu = AVRC_PDU_GET_ITEM_ATTRIBUTES;
+    rsp.get_attrs.status = AVRC_STS_NO_ERROR;
+    rsp.get_attrs.attr_count = attrs.elems.size();
+    rsp.get_attrs.p_attr_list = attrs.elems.data();
+    BT_HDR *p_pkt = NULL;
+
+    EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldBrowseResponse(kHandle, &rsp, &p_pkt));
+    ASSERT_TRUE(p_pkt != NULL);
+    EXPECT_EQ(3 + 2 + 8 + str_len, p_pkt->len);
+
+    append_ertm_fcs(p_pkt);
+    osi_free(p_pkt);
+  }
+}
+
+TEST_F(AvrcBldTgTest, test_appends_reuse_slack) {
+  AttrText attr(1, 20);
+  tAVRC_RESPONSE rsp = elem_attrs_rsp(&attr);
+  BT_HDR *p_pkt = NULL;
+  EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+  ASSERT_TRUE(p_pkt != NULL);
+
+  // Appending one attribute at a time only moves the packet when it runs out
+  // of room, and then to a buffer twice as large, so 200 appends move it a
+  // handful of times instead of on every call.
+  const int appends = 200;
+  int moves = 0;
+  for (int i = 0; i < appends; i++) {
+    BT_HDR *p_old = p_pkt;
+    EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(kHandle, &rsp, &p_pkt));
+    ASSERT_TRUE(p_pkt != NULL);
+    if (p_pkt != p_old)
+      moves++;
+  }
+  EXPECT_GT(moves, 0);
+  EXPECT_LE(moves, 8);
+  EXPECT_EQ(appends + 1, vendor_attr_count(p_pkt));
+  EXPECT_EQ(1 + (appends + 1) * (8 + 20), vendor_param_len(p_pkt));
+
+  const UINT8 *p_last = rsp_data(p_pkt) + p_pkt->len - 20;
+  EXPECT_EQ(0, memcmp(p_last, attr.text.data(), 20));
+
+  osi_free(p_pkt);
+}
@@ -0,0 +1,212 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "avct_api.h"
+#include "avrc_api.h"
+#include "avrc_defs.h"
+#include "avrc_int.h"
+#include "bt_common.h"
+#include "osi/include/osi.h"
+}
+
+static const UINT8 kLabel = 3;
+static const BD_ADDR kPeer = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+// AVCT is not linked into net_test_stack; these stand-ins keep what AVRC
+// hands it, so the test can tell sent buffers apart.
+static tAVCT_MSG_CBACK *avct_msg_cback;
+static std::vector<BT_HDR *> avct_sent;
+
+extern "C" {
+
+UINT16 AVCT_CreateConn(UINT8 *p_handle, tAVCT_CC *p_cc, BD_ADDR peer_addr) {
+  avct_msg_cback = p_cc->p_msg_cback;
+  *p_handle = 0;
+  return AVCT_SUCCESS;
+}
+
+UINT16 AVCT_RemoveConn(UINT8 handle) {
+  return AVCT_SUCCESS;
+}
+
+UINT16 AVCT_MsgReq(UINT8 handle, UINT8 label, UINT8 cr, BT_HDR *p_msg) {
+  avct_sent.push_back(p_msg);
+  return AVCT_SUCCESS;
+}
+
+}  // extern "C"
+
+static void ctrl_cback(UINT8 handle, UINT8 event, UINT16 result, BD_ADDR peer_addr) {
+}
+
+static void msg_cback(UINT8 handle, UINT8 label, UINT8 opcode, tAVRC_MSG *p_msg) {
+}
+
+static const UINT8 *pkt_data(const BT_HDR *p_pkt) {
+  return (const UINT8 *)(p_pkt + 1) + p_pkt->offset;
+}
+
+class AvrcFragTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      memset(&avrc_cb, 0, sizeof(avrc_cb));
+      avct_sent.clear();
+
+      tAVRC_CONN_CB ccb;
+      memset(&ccb, 0, sizeof(ccb));
+      ccb.p_ctrl_cback = ctrl_cback;
+      ccb.p_msg_cback = msg_cback;
+      ccb.conn = AVRC_CONN_ACP;
+      ccb.control = AVRC_CT_TARGET;
+      ASSERT_EQ(AVRC_SUCCESS, AVRC_Open(&handle_, &ccb, (BD_ADDR_PTR)kPeer));
+    }
+
+    virtual void TearDown() {
+      for (BT_HDR *p_pkt : avct_sent)
+        osi_free(p_pkt);
+      avct_sent.clear();
+      AVRC_Close(handle_);
+      osi_free_and_reset((void **)&avrc_cb.fcb[handle_].p_fmsg);
+      AllocationTestHarness::TearDown();
+    }
+
+    // Builds a GetElementAttributes response carrying one title of
+    // |title_len| octets per entry of |title_lens|.
+    BT_HDR *ElemAttrsRsp(const std::vector<UINT16> &title_lens) {
+      std::vector<tAVRC_ATTR_ENTRY> attrs(title_lens.size());
+      titles_.reserve(titles_.size() + attrs.size());
+      for (size_t i = 0; i < attrs.size(); i++) {
+        titles_.push_back(std::vector<UINT8>(title_lens[i], (UINT8)('a' + i)));
+        attrs[i].attr_id = AVRC_MEDIA_ATTR_ID_TITLE;
+        attrs[i].name.charset_id = AVRC_CHARSET_ID_UTF8;
+        attrs[i].name.str_len = title_lens[i];
+        attrs[i].name.p_str = titles_.back().data();
+      }
+
+      tAVRC_RESPONSE rsp;
+      memset(&rsp, 0, sizeof(rsp));
+      rsp.get_elem_attrs.pdu = AVRC_PDU_GET_ELEMENT_ATTR;
+      rsp.get_elem_attrs.status = AVRC_STS_NO_ERROR;
+      rsp.get_elem_attrs.opcode = AVRC_OP_VENDOR;
+      rsp.get_elem_attrs.num_attr = attrs.size();
+      rsp.get_elem_attrs.p_attrs = attrs.data();
+      BT_HDR *p_pkt = NULL;
+      EXPECT_EQ(AVRC_STS_NO_ERROR, AVRC_BldResponse(handle_, &rsp, &p_pkt));
+      return p_pkt;
+    }
+
+    // The peer asks for the next fragment of |pdu|.
+    void RequestContinuation(UINT8 pdu) {
+      BT_HDR *p_cmd = (BT_HDR *)osi_malloc(BT_HDR_SIZE + AVCT_MSG_OFFSET + AVRC_VENDOR_HDR_SIZE +
+                                           AVRC_MIN_META_HDR_SIZE + 1);
+      p_cmd->offset = AVCT_MSG_OFFSET;
+      p_cmd->layer_specific = AVCT_DATA_CTRL;
+      UINT8 *p = (UINT8 *)(p_cmd + 1) + p_cmd->offset;
+      *p++ = AVRC_CMD_CTRL;
+      *p++ = (AVRC_SUB_PANEL << AVRC_SUBTYPE_SHIFT);
+      *p++ = AVRC_OP_VENDOR;
+      AVRC_CO_ID_TO_BE_STREAM(p, AVRC_CO_METADATA);
+      *p++ = AVRC_PDU_REQUEST_CONTINUATION_RSP;
+      *p++ = AVRC_PKT_SINGLE;
+      UINT16_TO_BE_STREAM(p, 1);
+      *p++ = pdu;
+      p_cmd->len = p - pkt_data(p_cmd);
+      avct_msg_cback(handle_, kLabel, AVCT_CMD, p_cmd);
+    }
+
+    // Sends |p_pkt| as a response and pulls every fragment of it. Returns
+    // the parameter octets each fragment copied: none for a fragment sent
+    // out of |p_pkt| itself, all of them for any other.
+    std::vector<UINT16> SendFragmented(BT_HDR *p_pkt) {
+      const UINT8 *p_params = pkt_data(p_pkt) + AVRC_MIN_META_HDR_SIZE;
+      const std::vector<UINT8> params(p_params, p_params + p_pkt->len - AVRC_MIN_META_HDR_SIZE);
+      const UINT8 pdu = pkt_data(p_pkt)[0];
+
+      EXPECT_EQ(AVRC_SUCCESS, AVRC_MsgReq(handle_, kLabel, AVRC_RSP_IMPL_STBL, p_pkt));
+      std::vector<UINT8> reassembled;
+      std::vector<UINT16> copied;
+      for (size_t i = 0; i < avct_sent.size(); i++) {
+        const BT_HDR *p_frag = avct_sent[i];
+        EXPECT_LE(p_frag->len, AVRC_MAX_CTRL_DATA_LEN);
+        const UINT8 *p = pkt_data(p_frag) + AVRC_VENDOR_HDR_SIZE;
+        EXPECT_EQ(pdu, p[0]);
+        const UINT16 param_len = (p[2] << 8) | p[3];
+        EXPECT_EQ(p_frag->len, AVRC_VENDOR_HDR_SIZE + AVRC_MIN_META_HDR_SIZE + param_len);
+        reassembled.insert(reassembled.end(), p + AVRC_MIN_META_HDR_SIZE,
+                           p + AVRC_MIN_META_HDR_SIZE + param_len);
+        copied.push_back(p_frag == p_pkt ? 0 : param_len);
+
+        const UINT8 pkt_type = p[1] & AVRC_PKT_TYPE_MASK;
+        if (i == 0)
+          EXPECT_EQ(AVRC_PKT_START, pkt_type);
+        else if (pkt_type != AVRC_PKT_END)
+          EXPECT_EQ(AVRC_PKT_CONTINUE, pkt_type);
+        if (pkt_type != AVRC_PKT_END)
+          RequestContinuation(pdu);
+      }
+      EXPECT_EQ(params, reassembled);
+      return copied;
+    }
+
+    UINT8 handle_;
+    std::vector<std::vector<UINT8>> titles_;
+};
+
+// A response just over one packet goes out of its own buffer first; only
+// the short end fragment is copied.
+TEST_F(AvrcFragTest, test_two_fragments_copy_only_the_leftover) {
+  // 1 attribute count octet, then 8 octets of header per title.
+  BT_HDR *p_pkt = ElemAttrsRsp({ AVRC_FRAG_PARAM_LEN - 1 - 8 + 40 });
+  ASSERT_TRUE(p_pkt != NULL);
+
+  std::vector<UINT16> copied = SendFragmented(p_pkt);
+  ASSERT_EQ(2u, copied.size());
+  EXPECT_EQ(0, copied[0]);
+  EXPECT_EQ(40, copied[1]);
+}
+
+// However many fragments a response takes, each copies at most its own
+// parameters, and one of them is sent without a copy.
+TEST_F(AvrcFragTest, test_each_fragment_copies_at_most_its_parameters) {
+  BT_HDR *p_pkt = ElemAttrsRsp(std::vector<UINT16>(20, 255));
+  ASSERT_TRUE(p_pkt != NULL);
+  const size_t total_params = 1 + 20 * (8 + 255);
+
+  std::vector<UINT16> copied = SendFragmented(p_pkt);
+  ASSERT_EQ((total_params + AVRC_FRAG_PARAM_LEN - 1) / AVRC_FRAG_PARAM_LEN, copied.size());
+
+  size_t total_copied = 0;
+  size_t uncopied_frags = 0;
+  for (UINT16 len : copied) {
+    EXPECT_LE(len, AVRC_FRAG_PARAM_LEN);
+    total_copied += len;
+    if (len == 0)
+      uncopied_frags++;
+  }
+  EXPECT_EQ(1u, uncopied_frags);
+  EXPECT_EQ(total_params - AVRC_FRAG_PARAM_LEN, total_copied);
+}
@@ -0,0 +1,270 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "l2cdefs.h"
+}
+
+static const BD_ADDR kPeer = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint16_t kHandle = 0x0040;
+static const uint16_t kValueLen = 512;
+
+// Long reads timed per benchmark run.
+static const size_t kBenchmarkReads = 200;
+
+struct AppRead {
+  uint16_t conn_id;
+  uint32_t trans_id;
+  uint16_t handle;
+  uint16_t offset;
+};
+
+static std::vector<AppRead> app_reads;
+
+static void conn_cb(tGATT_IF gatt_if, BD_ADDR bda, UINT16 conn_id, BOOLEAN connected,
+                    tGATT_DISCONN_REASON reason, tBT_TRANSPORT transport) {
+}
+
+static void req_cb(UINT16 conn_id, UINT32 trans_id, tGATTS_REQ_TYPE type,
+                   tGATTS_DATA *p_data) {
+  if (type != GATTS_REQ_TYPE_READ)
+    return;
+  AppRead read = { conn_id, trans_id, p_data->read_req.handle, p_data->read_req.offset };
+  app_reads.push_back(read);
+}
+
+namespace {
+
+void push_le16(std::vector<uint8_t> &data, uint16_t value) {
+  data.push_back(value & 0xff);
+  data.push_back(value >> 8);
+}
+
+}  // namespace
+
+class GattLongReadTest : public L2capTestHarness {
+  protected:
+    virtual void SetUp() {
+      L2capTestHarness::SetUp();
+
+      app_reads.clear();
+      for (uint16_t i = 0; i < kValueLen; ++i)
+        value_[i] = (uint8_t)(i * 7 + 1);
+
+      tBT_UUID app_uuid;
+      app_uuid.len = LEN_UUID_128;
+      memset(app_uuid.uu.uuid128, 0x42, LEN_UUID_128);
+      tGATT_CBACK cb;
+      memset(&cb, 0, sizeof(cb));
+      cb.p_conn_cb = conn_cb;
+      cb.p_req_cb = req_cb;
+      gatt_if_ = GATT_Register(&app_uuid, &cb);
+      ASSERT_NE(0, gatt_if_);
+      GATT_StartIf(gatt_if_);
+
+      tBT_UUID svc_uuid;
+      svc_uuid.len = LEN_UUID_16;
+      svc_uuid.uu.uuid16 = 0x1234;
+      svc_handle_ = GATTS_CreateService(gatt_if_, &svc_uuid, 0, 4, TRUE);
+      ASSERT_NE(0, svc_handle_);
+
+      tBT_UUID char_uuid;
+      char_uuid.len = LEN_UUID_16;
+      char_uuid.uu.uuid16 = 0x5678;
+      attr_handle_ = GATTS_AddCharacteristic(svc_handle_, &char_uuid, GATT_PERM_READ,
+                                             GATT_CHAR_PROP_BIT_READ);
+      ASSERT_NE(0, attr_handle_);
+      ASSERT_EQ(GATT_SUCCESS, GATTS_StartService(gatt_if_, svc_handle_, GATT_TRANSPORT_LE));
+
+      // Settle the ATT MTU exchange GATT starts on the new link, keeping
+      // the default MTU.
+      ConnectLe(kPeer, kHandle, false);
+      const uint8_t mtu_rsp[] = { GATT_RSP_MTU, (uint8_t)GATT_DEF_BLE_MTU_SIZE, 0 };
+      Receive(kHandle, L2CAP_ATT_CID, mtu_rsp, sizeof(mtu_rsp));
+      TakeAttPdus();
+
+      tGATT_TCB *p_tcb = gatt_find_tcb_by_addr((UINT8 *)kPeer, BT_TRANSPORT_LE);
+      ASSERT_TRUE(p_tcb != NULL);
+      ASSERT_EQ(GATT_DEF_BLE_MTU_SIZE, p_tcb->payload_size);
+    }
+
+    virtual void TearDown() {
+      GATT_Deregister(gatt_if_);
+      L2capTestHarness::TearDown();
+    }
+
+    tGATT_SVC_DB *svc_db() {
+      return &gatt_find_hdl_buffer_by_handle(svc_handle_)->svc_db;
+    }
+
+    // Answers the application's outstanding read with the value from the
+    // requested offset on, the way an application without a stored value
+    // does.
+    void AnswerApp(const AppRead &read) {
+      tGATTS_RSP rsp;
+      memset(&rsp, 0, sizeof(rsp));
+      rsp.attr_value.handle = read.handle;
+      rsp.attr_value.offset = read.offset;
+      rsp.attr_value.len = kValueLen - read.offset;
+      memcpy(rsp.attr_value.value, value_ + read.offset, rsp.attr_value.len);
+      ASSERT_EQ(GATT_SUCCESS, GATTS_SendRsp(read.conn_id, read.trans_id, GATT_SUCCESS, &rsp));
+    }
+
+    // Reads the whole value as a client does: a Read Request, then Read
+    // Blob Requests until a response comes back short.
+    std::vector<uint8_t> LongRead() {
+      std::vector<uint8_t> result;
+      for (;;) {
+        std::vector<uint8_t> req;
+        if (result.empty()) {
+          req.push_back(GATT_REQ_READ);
+          push_le16(req, attr_handle_);
+        } else {
+          req.push_back(GATT_REQ_READ_BLOB);
+          push_le16(req, attr_handle_);
+          push_le16(req, result.size());
+        }
+        ++requests_;
+        Receive(kHandle, L2CAP_ATT_CID, req.data(), req.size());
+
+        std::vector<FakeHciPacket> pdus = TakeAttPdus();
+        while (pdus.empty() && !app_reads.empty()) {
+          AppRead read = app_reads.front();
+          app_reads.erase(app_reads.begin());
+          ++app_round_trips_;
+          AnswerApp(read);
+          pdus = TakeAttPdus();
+        }
+        EXPECT_EQ(1u, pdus.size());
+        if (pdus.size() != 1)
+          return result;
+
+        const std::vector<uint8_t> &rsp = pdus[0].payload;
+        EXPECT_EQ(result.empty() ? GATT_RSP_READ : GATT_RSP_READ_BLOB, rsp[0]);
+        result.insert(result.end(), rsp.begin() + 1, rsp.end());
+        if (rsp.size() < GATT_DEF_BLE_MTU_SIZE)
+          return result;
+      }
+    }
+
+    std::vector<FakeHciPacket> TakeAttPdus() {
+      std::vector<FakeHciPacket> pdus;
+      for (const FakeHciPacket &packet : TakePackets()) {
+        if (packet.is_cmd)
+          continue;
+        CompletePackets(packet.handle, 1);
+        if (packet.cid == L2CAP_ATT_CID)
+          pdus.push_back(packet);
+      }
+      return pdus;
+    }
+
+    // Times |kBenchmarkReads| long reads, in microseconds per long read.
+    double TimeLongReads() {
+      requests_ = 0;
+      app_round_trips_ = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < kBenchmarkReads; ++i)
+        LongRead();
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      return std::chrono::duration<double, std::micro>(elapsed).count() / kBenchmarkReads;
+    }
+
+    tGATT_IF gatt_if_;
+    uint16_t svc_handle_;
+    uint16_t attr_handle_;
+    uint8_t value_[kValueLen];
+    size_t requests_;
+    size_t app_round_trips_;
+};
+
+// With a stored value every slice of a long read is answered from the
+// database; without one every slice goes to the application.
+TEST_F(GattLongReadTest, test_read_by_handle_serves_stored_value) {
+  tGATT_TCB *p_tcb = gatt_find_tcb_by_addr((UINT8 *)kPeer, BT_TRANSPORT_LE);
+  // What fits in a Read Response after its opcode.
+  const uint16_t buf_len = p_tcb->payload_size - 1;
+  uint8_t slice[GATT_DEF_BLE_MTU_SIZE];
+  UINT16 len;
+
+  EXPECT_EQ(GATT_PENDING,
+            gatts_read_attr_value_by_handle(p_tcb, svc_db(), GATT_REQ_READ_BLOB, attr_handle_,
+                                            GATT_DEF_BLE_MTU_SIZE - 1, slice, &len, buf_len,
+                                            GATT_SEC_FLAG_LKEY_UNAUTHED, 0, 1));
+  EXPECT_EQ(1u, app_reads.size());
+  gatt_dequeue_sr_cmd(p_tcb);
+  app_reads.clear();
+
+  ASSERT_EQ(GATT_SUCCESS,
+            GATTS_SetAttributeValue(svc_handle_, attr_handle_, kValueLen, value_, FALSE));
+  std::vector<uint8_t> result;
+  for (uint16_t offset = 0; offset < kValueLen; offset += len) {
+    len = 0;
+    ASSERT_EQ(GATT_SUCCESS,
+              gatts_read_attr_value_by_handle(p_tcb, svc_db(),
+                                              offset ? GATT_REQ_READ_BLOB : GATT_REQ_READ,
+                                              attr_handle_, offset, slice, &len, buf_len,
+                                              GATT_SEC_FLAG_LKEY_UNAUTHED, 0, 1));
+    ASSERT_EQ(std::min(buf_len, (uint16_t)(kValueLen - offset)), len);
+    result.insert(result.end(), slice, slice + len);
+  }
+  EXPECT_EQ(0u, app_reads.size());
+  EXPECT_EQ(std::vector<uint8_t>(value_, value_ + kValueLen), result);
+}
+
+// In notify mode the application still answers the start of every long
+// read, and the stack serves the rest from what is stored.
+TEST_F(GattLongReadTest, test_notify_app_answers_start_of_long_read) {
+  ASSERT_EQ(GATT_SUCCESS,
+            GATTS_SetAttributeValue(svc_handle_, attr_handle_, kValueLen, value_, TRUE));
+
+  requests_ = 0;
+  app_round_trips_ = 0;
+  EXPECT_EQ(std::vector<uint8_t>(value_, value_ + kValueLen), LongRead());
+  EXPECT_EQ(1u, app_round_trips_);
+  EXPECT_EQ((size_t)(kValueLen / (GATT_DEF_BLE_MTU_SIZE - 1) + 1), requests_);
+}
+
+TEST_F(GattLongReadTest, test_benchmark_long_read_latency) {
+  const double app_us = TimeLongReads();
+  const size_t app_trips = app_round_trips_;
+  const size_t requests = requests_;
+  EXPECT_EQ(requests, app_trips);
+
+  ASSERT_EQ(GATT_SUCCESS,
+            GATTS_SetAttributeValue(svc_handle_, attr_handle_, kValueLen, value_, FALSE));
+  const double stored_us = TimeLongReads();
+  EXPECT_EQ(0u, app_round_trips_);
+  EXPECT_EQ(std::vector<uint8_t>(value_, value_ + kValueLen), LongRead());
+
+  printf("GATT long read of %u bytes at MTU %u: %zu requests, "
+         "%.1f us with %zu app round trips, %.1f us from the stored value\n",
+         kValueLen, GATT_DEF_BLE_MTU_SIZE, requests / kBenchmarkReads,
+         app_us, app_trips / kBenchmarkReads, stored_us);
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "gatt_int.h"
+#include "hcidefs.h"
+#include "l2cdefs.h"
+}
+
+static const BD_ADDR kPeer = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint16_t kHandle = 0x0040;
+
+// What the peer's GATT server supports.
+static const uint16_t kServerMtu = 247;
+
+namespace {
+
+std::vector<FakeHciPacket> hci_cmds(const std::vector<FakeHciPacket> &packets) {
+  std::vector<FakeHciPacket> cmds;
+  for (const FakeHciPacket &packet : packets) {
+    if (packet.is_cmd)
+      cmds.push_back(packet);
+  }
+  return cmds;
+}
+
+std::vector<FakeHciPacket> att_pdus(const std::vector<FakeHciPacket> &packets) {
+  std::vector<FakeHciPacket> pdus;
+  for (const FakeHciPacket &packet : packets) {
+    if (!packet.is_cmd && packet.cid == L2CAP_ATT_CID)
+      pdus.push_back(packet);
+  }
+  return pdus;
+}
+
+uint16_t le16(const std::vector<uint8_t> &data, size_t offset) {
+  return data[offset] | (data[offset + 1] << 8);
+}
+
+void expect_set_data_length(const FakeHciPacket &cmd, uint16_t tx_octets) {
+  EXPECT_EQ(HCI_BLE_SET_DATA_LENGTH, cmd.opcode);
+  ASSERT_EQ(6u, cmd.payload.size());
+  EXPECT_EQ(kHandle, le16(cmd.payload, 0));
+  EXPECT_EQ(tx_octets, le16(cmd.payload, 2));
+}
+
+void expect_mtu_req(const FakeHciPacket &pdu, uint16_t mtu) {
+  EXPECT_EQ(kHandle, pdu.handle);
+  ASSERT_EQ(3u, pdu.payload.size());
+  EXPECT_EQ(GATT_REQ_MTU, pdu.payload[0]);
+  EXPECT_EQ(mtu, le16(pdu.payload, 1));
+}
+
+}  // namespace
+
+class GattMtuTest : public L2capTestHarness {
+  protected:
+    tGATT_TCB *tcb() {
+      return gatt_find_tcb_by_addr((UINT8 *)kPeer, BT_TRANSPORT_LE);
+    }
+
+    void ReceiveMtuRsp(uint16_t mtu) {
+      const uint8_t rsp[] = { GATT_RSP_MTU, (uint8_t)mtu, (uint8_t)(mtu >> 8) };
+      Receive(kHandle, L2CAP_ATT_CID, rsp, sizeof(rsp));
+    }
+};
+
+// The link asks for the largest data length once the remote version is
+// read, and the GATT profile for its preferred MTU on connection. The
+// MTU the server answers with then needs no further command.
+TEST_F(GattMtuTest, test_auto_data_length_and_mtu_exchange) {
+  ConnectLe(kPeer, kHandle, true);
+  std::vector<FakeHciPacket> packets = TakePackets();
+  EXPECT_EQ(0u, hci_cmds(packets).size());
+  ASSERT_EQ(1u, att_pdus(packets).size());
+  expect_mtu_req(att_pdus(packets)[0], GATT_PREFERRED_MTU);
+  ASSERT_TRUE(tcb() != NULL);
+  EXPECT_EQ(GATT_DEF_BLE_MTU_SIZE, tcb()->payload_size);
+
+  RemoteVersionComplete(kPeer);
+  packets = TakePackets();
+  ASSERT_EQ(1u, packets.size());
+  ASSERT_TRUE(packets[0].is_cmd);
+  expect_set_data_length(packets[0], BTM_BLE_DATA_SIZE_MAX);
+
+  ReceiveMtuRsp(kServerMtu);
+  EXPECT_EQ(kServerMtu, tcb()->payload_size);
+  EXPECT_TRUE(tcb()->mtu_exchanged);
+
+  // The profile goes on to its service discovery.
+  packets = TakePackets();
+  EXPECT_EQ(0u, hci_cmds(packets).size());
+  ASSERT_EQ(1u, att_pdus(packets).size());
+  EXPECT_NE(GATT_REQ_MTU, att_pdus(packets)[0].payload[0]);
+}
+
+TEST_F(GattMtuTest, test_no_data_length_without_peer_support) {
+  ConnectLe(kPeer, kHandle, false);
+  RemoteVersionComplete(kPeer);
+  ReceiveMtuRsp(kServerMtu);
+
+  EXPECT_EQ(0u, hci_cmds(TakePackets()).size());
+  EXPECT_EQ(kServerMtu, tcb()->payload_size);
+}
+
+// Without the automatic request, the data length follows the MTU.
+TEST_F(GattMtuTest, test_interop_data_length_follows_mtu_exchange) {
+  AddInteropEntry(INTEROP_DISABLE_LE_AUTO_DATA_LENGTH);
+  ConnectLe(kPeer, kHandle, true);
+  RemoteVersionComplete(kPeer);
+  std::vector<FakeHciPacket> packets = TakePackets();
+  EXPECT_EQ(0u, hci_cmds(packets).size());
+  ASSERT_EQ(1u, att_pdus(packets).size());
+  expect_mtu_req(att_pdus(packets)[0], GATT_PREFERRED_MTU);
+
+  ReceiveMtuRsp(kServerMtu);
+  EXPECT_EQ(kServerMtu, tcb()->payload_size);
+  packets = hci_cmds(TakePackets());
+  ASSERT_EQ(1u, packets.size());
+  expect_set_data_length(packets[0], kServerMtu + L2CAP_PKT_OVERHEAD);
+}
+
+// The MTU in use is the default until the server agrees to another one.
+TEST_F(GattMtuTest, test_mtu_error_rsp_keeps_default_mtu) {
+  ConnectLe(kPeer, kHandle, true);
+  ASSERT_EQ(1u, att_pdus(TakePackets()).size());
+  ASSERT_TRUE(tcb() != NULL);
+  EXPECT_EQ(GATT_DEF_BLE_MTU_SIZE, tcb()->payload_size);
+
+  const uint8_t rsp[] = { GATT_RSP_ERROR, GATT_REQ_MTU, 0x00, 0x00,
+                          GATT_REQ_NOT_SUPPORTED };
+  Receive(kHandle, L2CAP_ATT_CID, rsp, sizeof(rsp));
+
+  EXPECT_EQ(GATT_DEF_BLE_MTU_SIZE, tcb()->payload_size);
+  EXPECT_FALSE(tcb()->mtu_exchanged);
+}
@@ -0,0 +1,178 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "l2cdefs.h"
+}
+
+static const uint16_t kFirstHandle = 0x0040;
+static const uint16_t kAttrHandle = 0x0010;
+static const uint16_t kValueLen = 20;
+
+// As many links as GATT serves at once, up to the 8 a server typically
+// fans a change out to.
+static const size_t kMaxLinks = std::min(8, GATT_MAX_PHY_CHANNEL);
+
+// Notification rounds sent to every link per benchmark run.
+static const size_t kBenchmarkRounds = 2000;
+
+static void conn_cb(tGATT_IF gatt_if, BD_ADDR bda, UINT16 conn_id, BOOLEAN connected,
+                    tGATT_DISCONN_REASON reason, tBT_TRANSPORT transport) {
+}
+
+class GattNotifyTest : public L2capTestHarness {
+  protected:
+    virtual void SetUp() {
+      L2capTestHarness::SetUp();
+
+      for (uint16_t i = 0; i < kValueLen; ++i)
+        value_[i] = (uint8_t)(i + 1);
+
+      tBT_UUID app_uuid;
+      app_uuid.len = LEN_UUID_128;
+      memset(app_uuid.uu.uuid128, 0x42, LEN_UUID_128);
+      tGATT_CBACK cb;
+      memset(&cb, 0, sizeof(cb));
+      cb.p_conn_cb = conn_cb;
+      gatt_if_ = GATT_Register(&app_uuid, &cb);
+      ASSERT_NE(0, gatt_if_);
+      GATT_StartIf(gatt_if_);
+    }
+
+    virtual void TearDown() {
+      GATT_Deregister(gatt_if_);
+      L2capTestHarness::TearDown();
+    }
+
+    // Connects clients until there are |num_links|, settling the ATT MTU
+    // exchange GATT starts on each.
+    void Connect(size_t num_links) {
+      for (size_t i = conn_ids_.size(); i < num_links; ++i) {
+        const BD_ADDR bda = {0x00, 0x11, 0x22, 0x33, 0x44, (uint8_t)i};
+        const uint16_t handle = kFirstHandle + i;
+        ConnectLe(bda, handle, false);
+        const uint8_t mtu_rsp[] = { GATT_RSP_MTU, (uint8_t)GATT_DEF_BLE_MTU_SIZE, 0 };
+        Receive(handle, L2CAP_ATT_CID, mtu_rsp, sizeof(mtu_rsp));
+
+        tGATT_TCB *p_tcb = gatt_find_tcb_by_addr((UINT8 *)bda, BT_TRANSPORT_LE);
+        ASSERT_TRUE(p_tcb != NULL);
+        conn_ids_.push_back(GATT_CREATE_CONN_ID(p_tcb->tcb_idx, gatt_if_));
+      }
+      TakeNotifications();
+    }
+
+    // Returns the notifications sent since the last call, telling the
+    // stack every packet got out until it has nothing left queued.
+    std::vector<FakeHciPacket> TakeNotifications() {
+      std::vector<FakeHciPacket> notifications;
+      std::vector<FakeHciPacket> packets = TakePackets();
+      while (!packets.empty()) {
+        for (const FakeHciPacket &packet : packets) {
+          if (packet.is_cmd)
+            continue;
+          CompletePackets(packet.handle, 1);
+          if (packet.cid == L2CAP_ATT_CID && packet.payload[0] == GATT_HANDLE_VALUE_NOTIF)
+            notifications.push_back(packet);
+        }
+        packets = TakePackets();
+      }
+      return notifications;
+    }
+
+    // Sends the value to every link |kBenchmarkRounds| times, and returns
+    // notifications per second.
+    double TimeNotifications(bool multi) {
+      const size_t num_links = conn_ids_.size();
+      size_t sent = 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (size_t round = 0; round < kBenchmarkRounds; ++round) {
+        if (multi) {
+          EXPECT_EQ(GATT_SUCCESS,
+                    GATTS_HandleValueNotificationMulti(num_links, conn_ids_.data(), kAttrHandle,
+                                                       kValueLen, value_, NULL));
+        } else {
+          for (UINT16 conn_id : conn_ids_)
+            EXPECT_EQ(GATT_SUCCESS,
+                      GATTS_HandleValueNotification(conn_id, kAttrHandle, kValueLen, value_));
+        }
+        sent += TakeNotifications().size();
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      EXPECT_EQ(kBenchmarkRounds * num_links, sent);
+      return sent / std::chrono::duration<double>(elapsed).count();
+    }
+
+    tGATT_IF gatt_if_;
+    std::vector<UINT16> conn_ids_;
+    uint8_t value_[kValueLen];
+};
+
+// Every link gets the same notification from one call.
+TEST_F(GattNotifyTest, test_notification_multi_reaches_every_link) {
+  Connect(kMaxLinks);
+
+  std::vector<tGATT_STATUS> status(kMaxLinks, GATT_ERROR);
+  ASSERT_EQ(GATT_SUCCESS,
+            GATTS_HandleValueNotificationMulti(kMaxLinks, conn_ids_.data(), kAttrHandle,
+                                               kValueLen, value_, status.data()));
+  for (tGATT_STATUS s : status)
+    EXPECT_EQ(GATT_SUCCESS, s);
+
+  std::vector<FakeHciPacket> notifications = TakeNotifications();
+  ASSERT_EQ(kMaxLinks, notifications.size());
+
+  std::vector<uint8_t> expected;
+  expected.push_back(GATT_HANDLE_VALUE_NOTIF);
+  expected.push_back(kAttrHandle & 0xff);
+  expected.push_back(kAttrHandle >> 8);
+  expected.insert(expected.end(), value_, value_ + kValueLen);
+
+  std::vector<uint16_t> handles;
+  for (const FakeHciPacket &notification : notifications) {
+    EXPECT_EQ(expected, notification.payload);
+    handles.push_back(notification.handle);
+  }
+  std::sort(handles.begin(), handles.end());
+  for (size_t i = 0; i < kMaxLinks; ++i)
+    EXPECT_EQ(kFirstHandle + i, handles[i]);
+}
+
+TEST_F(GattNotifyTest, test_benchmark_notifications_per_link_count) {
+  for (size_t num_links = 1; num_links <= kMaxLinks; ++num_links) {
+    Connect(num_links);
+    ASSERT_EQ(num_links, conn_ids_.size());
+
+    const double single = TimeNotifications(false);
+    const double multi = TimeNotifications(true);
+    printf("GATT notify, %zu link%s: %.0f/s one at a time, %.0f/s in one call\n",
+           num_links, num_links == 1 ? "" : "s", single, multi);
+  }
+}
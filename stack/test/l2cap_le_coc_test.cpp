@@ -0,0 +1,283 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "btm_ble_api.h"
+#include "gatt_int.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "l2cdefs.h"
+#include "osi/include/osi.h"
+}
+
+static const BD_ADDR kPeer = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint16_t kHandle = 0x0040;
+static const uint16_t kPsm = 0x0080;
+static const uint16_t kMtu = 512;
+
+// The peer receives as much as it is sent in one PDU.
+static const uint16_t kPeerMtu = 512;
+static const uint16_t kPeerMps = 512;
+
+// What the peer pushes through the channel per benchmark run.
+static const size_t kBenchmarkBytes = 16 * 1024 * 1024;
+
+static bool connected;
+static bool consume_on_receipt;
+static std::vector<BT_HDR *> received_sdus;
+
+static void connect_cfm(UINT16 lcid, UINT16 result) {
+  connected = (result == L2CAP_CONN_OK);
+}
+
+static void disconnect_ind(UINT16 lcid, BOOLEAN ack_needed) {
+  connected = false;
+}
+
+static void data_ind(UINT16 lcid, BT_HDR *p_buf) {
+  if (consume_on_receipt) {
+    L2CA_LECocSduConsumed(lcid, p_buf);
+    osi_free(p_buf);
+  } else {
+    received_sdus.push_back(p_buf);
+  }
+}
+
+namespace {
+
+uint16_t le16(const std::vector<uint8_t> &data, size_t offset) {
+  return data[offset] | (data[offset + 1] << 8);
+}
+
+void push_le16(std::vector<uint8_t> &data, uint16_t value) {
+  data.push_back(value & 0xff);
+  data.push_back(value >> 8);
+}
+
+}  // namespace
+
+class L2capLeCocTest : public L2capTestHarness {
+  protected:
+    virtual void SetUp() {
+      L2capTestHarness::SetUp();
+
+      connected = false;
+      consume_on_receipt = false;
+      received_sdus.clear();
+      peer_credits_ = 0;
+      credit_packets_ = 0;
+
+      tL2CAP_APPL_INFO appl_info;
+      memset(&appl_info, 0, sizeof(appl_info));
+      appl_info.pL2CA_ConnectCfm_Cb = connect_cfm;
+      appl_info.pL2CA_DisconnectInd_Cb = disconnect_ind;
+      appl_info.pL2CA_DataInd_Cb = data_ind;
+      psm_ = L2CA_RegisterLECoc(kPsm, &appl_info);
+      ASSERT_NE(0, psm_);
+
+      // Settle the ATT MTU exchange GATT starts on the new link.
+      ConnectLe(kPeer, kHandle, true);
+      const uint8_t mtu_rsp[] = { GATT_RSP_MTU, (uint8_t)GATT_DEF_BLE_MTU_SIZE, 0 };
+      Receive(kHandle, L2CAP_ATT_CID, mtu_rsp, sizeof(mtu_rsp));
+      TakeSignals();
+    }
+
+    virtual void TearDown() {
+      for (BT_HDR *p_buf : received_sdus)
+        osi_free(p_buf);
+      received_sdus.clear();
+      L2CA_DeregisterLECoc(psm_);
+
+      L2capTestHarness::TearDown();
+    }
+
+    // Opens a channel with L2CAP sizing our side of it, and answers it as
+    // the peer.
+    void Open() {
+      tL2CAP_LE_CFG_INFO cfg;
+      cfg.mtu = kMtu;
+      cfg.mps = L2CAP_LE_AUTO_CFG;
+      cfg.credits = L2CAP_LE_AUTO_CFG;
+      lcid_ = L2CA_ConnectLECocReq(psm_, (UINT8 *)kPeer, &cfg);
+      ASSERT_NE(0, lcid_);
+
+      std::vector<FakeHciPacket> signals = TakeSignals();
+      ASSERT_EQ(1u, signals.size());
+      const std::vector<uint8_t> &req = signals[0].payload;
+      ASSERT_EQ((size_t)L2CAP_CMD_OVERHEAD + L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ_LEN,
+                req.size());
+      ASSERT_EQ(L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ, req[0]);
+      EXPECT_EQ(lcid_, le16(req, 6));
+      EXPECT_EQ(kMtu, le16(req, 8));
+      mps_ = le16(req, 10);
+      initial_credits_ = le16(req, 12);
+      peer_credits_ = initial_credits_;
+
+      std::vector<uint8_t> rsp;
+      rsp.push_back(L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES);
+      rsp.push_back(req[1]);
+      push_le16(rsp, L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN);
+      push_le16(rsp, kFirstPeerCid);
+      push_le16(rsp, kPeerMtu);
+      push_le16(rsp, kPeerMps);
+      push_le16(rsp, 0);
+      push_le16(rsp, L2CAP_LE_CONN_OK);
+      Receive(kHandle, L2CAP_BLE_SIGNALLING_CID, rsp.data(), rsp.size());
+      ASSERT_TRUE(connected);
+    }
+
+    // Sends an SDU of |len| bytes in as many PDUs as our MPS needs, using
+    // up a credit for each.
+    void SendSdu(uint16_t len) {
+      std::vector<uint8_t> sdu;
+      push_le16(sdu, len);
+      sdu.resize(L2CAP_LCC_SDU_LENGTH + len, 0xa5);
+
+      for (size_t offset = 0; offset < sdu.size(); offset += mps_) {
+        ASSERT_GT(peer_credits_, 0);
+        --peer_credits_;
+        const size_t pdu_len = std::min(sdu.size() - offset, (size_t)mps_);
+        Receive(kHandle, lcid_, sdu.data() + offset, pdu_len);
+      }
+    }
+
+    // Picks up the credits the stack returned and tells it every packet
+    // it sent got out.
+    void CollectCredits() {
+      for (const FakeHciPacket &signal : TakeSignals()) {
+        const std::vector<uint8_t> &cmd = signal.payload;
+        ASSERT_EQ(L2CAP_CMD_BLE_FLOW_CTRL_CREDIT, cmd[0]);
+        EXPECT_EQ(lcid_, le16(cmd, 4));
+        peer_credits_ += le16(cmd, 6);
+        ++credit_packets_;
+      }
+    }
+
+    std::vector<FakeHciPacket> TakeSignals() {
+      std::vector<FakeHciPacket> packets = TakePackets();
+      std::vector<FakeHciPacket> signals;
+      for (const FakeHciPacket &packet : packets) {
+        if (packet.is_cmd)
+          continue;
+        CompletePackets(packet.handle, 1);
+        if (packet.cid == L2CAP_BLE_SIGNALLING_CID)
+          signals.push_back(packet);
+      }
+      return signals;
+    }
+
+    uint16_t psm_;
+    uint16_t lcid_;
+    uint16_t mps_;
+    uint16_t initial_credits_;
+    uint32_t peer_credits_;
+    size_t credit_packets_;
+};
+
+// Credits only go back as the upper layer reads SDUs, so what it has not
+// read is bounded by the initial credits.
+TEST_F(L2capLeCocTest, test_credits_return_when_sdus_are_read) {
+  Open();
+
+  // Without a larger data length, an SDU takes several PDUs.
+  const uint16_t pdus_per_sdu = (L2CAP_LCC_SDU_LENGTH + kMtu + mps_ - 1) / mps_;
+  ASSERT_GT(pdus_per_sdu, 1);
+  ASSERT_GE(initial_credits_, 2 * pdus_per_sdu);
+
+  while (peer_credits_ >= pdus_per_sdu)
+    SendSdu(kMtu);
+  CollectCredits();
+  EXPECT_EQ(0u, credit_packets_);
+  ASSERT_EQ((size_t)(initial_credits_ / pdus_per_sdu), received_sdus.size());
+  for (BT_HDR *p_buf : received_sdus) {
+    EXPECT_EQ(kMtu, p_buf->len);
+    EXPECT_EQ(pdus_per_sdu, p_buf->layer_specific);
+  }
+
+  // The credits come back in one packet once half of them are read.
+  const uint16_t batch = initial_credits_ / 2;
+  size_t read = 0;
+  while ((read + 1) * pdus_per_sdu < batch) {
+    L2CA_LECocSduConsumed(lcid_, received_sdus[read]);
+    ++read;
+  }
+  CollectCredits();
+  EXPECT_EQ(0u, credit_packets_);
+
+  const uint32_t held_credits = peer_credits_;
+  L2CA_LECocSduConsumed(lcid_, received_sdus[read]);
+  ++read;
+  CollectCredits();
+  EXPECT_EQ(1u, credit_packets_);
+  EXPECT_EQ(held_credits + read * pdus_per_sdu, peer_credits_);
+}
+
+// A PDU the stack drops never reaches the upper layer, so its credit is
+// counted for return right away.
+TEST_F(L2capLeCocTest, test_dropped_pdu_returns_its_credit) {
+  Open();
+  tL2C_CCB *p_ccb = l2cu_find_ccb_by_cid(NULL, lcid_);
+  ASSERT_TRUE(p_ccb != NULL);
+
+  std::vector<uint8_t> pdu;
+  push_le16(pdu, kMtu + 1);
+  pdu.resize(L2CAP_LCC_SDU_LENGTH + 1);
+  Receive(kHandle, lcid_, pdu.data(), pdu.size());
+
+  EXPECT_EQ(0u, received_sdus.size());
+  EXPECT_EQ(1, p_ccb->ble_rx_credits_used);
+}
+
+TEST_F(L2capLeCocTest, test_benchmark_le_coc_receive) {
+  // Both controllers carry the largest LE data packets, so a whole SDU
+  // fits in the MPS.
+  l2cble_process_data_length_change_event(kHandle, BTM_BLE_DATA_SIZE_MAX,
+                                          BTM_BLE_DATA_SIZE_MAX);
+  consume_on_receipt = true;
+  Open();
+  ASSERT_GE(mps_, L2CAP_LCC_SDU_LENGTH + kMtu);
+
+  const size_t num_sdus = kBenchmarkBytes / kMtu;
+  size_t sent = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while (sent < num_sdus) {
+    while (peer_credits_ > 0 && sent < num_sdus) {
+      SendSdu(kMtu);
+      ++sent;
+    }
+    CollectCredits();
+    ASSERT_TRUE(sent == num_sdus || peer_credits_ > 0) << "peer ran out of credits";
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+
+  printf("LE CoC receive: %.1f MB/s, mps %u, %u initial credits, %.1f SDUs per credit packet\n",
+         kBenchmarkBytes / seconds / (1024 * 1024), mps_, initial_credits_,
+         (double)num_sdus / credit_packets_);
+  EXPECT_LT(credit_packets_, num_sdus / 2);
+}
@@ -0,0 +1,241 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "bt_common.h"
+#include "a2d_api.h"
+#include "a2d_sbc.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/mutex.h"
+#include "port_int.h"
+#include "rfc_int.h"
+
+// From btif_av_co.h, which also pulls in the media task and audio HAL headers.
+void bta_av_co_audio_codec_reset(void);
+BOOLEAN bta_av_co_audio_get_sbc_config(tA2D_SBC_CIE *p_sbc_config,
+                                       UINT16 *p_minmtu);
+
+// bta_av_co.c builds and parses codec information through the A2DP layer and
+// asks BTA and btif_av about the link. Every codec is reported as valid so
+// the codec lock is taken on the same paths as with a real SBC sink. The
+// aptX and AAC information elements are only passed through, so they are
+// left opaque here.
+BOOLEAN bt_split_a2dp_enabled;
+BOOLEAN isA2dAptXEnabled;
+BOOLEAN isA2dAptXHdEnabled;
+tA2D_STATUS A2D_BldSbcInfo(UINT8 media_type, tA2D_SBC_CIE *p_ie,
+                           UINT8 *p_result) { return A2D_SUCCESS; }
+tA2D_STATUS A2D_ParsSbcInfo(tA2D_SBC_CIE *p_ie, const UINT8 *p_info,
+                            BOOLEAN for_caps);
+tA2D_STATUS A2D_BldAacInfo(UINT8 media_type, void *p_ie,
+                           UINT8 *p_result) { return A2D_SUCCESS; }
+tA2D_STATUS A2D_ParsAacInfo(void *p_ie, UINT8 *p_info,
+                            BOOLEAN for_caps) { return A2D_SUCCESS; }
+UINT8 A2D_BldAptxInfo(UINT8 media_type, void *p_ie,
+                      UINT8 *p_result) { return A2D_SUCCESS; }
+UINT8 A2D_ParsAptxInfo(void *p_ie, UINT8 *p_info,
+                       BOOLEAN for_caps) { return A2D_SUCCESS; }
+UINT8 A2D_BldAptx_hdInfo(UINT8 media_type, void *p_ie,
+                         UINT8 *p_result) { return A2D_SUCCESS; }
+UINT8 A2D_ParsAptx_hdInfo(void *p_ie, UINT8 *p_info,
+                          BOOLEAN for_caps) { return A2D_SUCCESS; }
+UINT8 a2d_av_aptx_cfg_in_cap(UINT8 *p_cfg, void *p_cap) { return 0; }
+UINT8 a2d_av_aptx_hd_cfg_in_cap(UINT8 *p_cfg, void *p_cap) { return 0; }
+UINT8 bta_av_aac_cfg_in_cap(UINT8 *p_cfg, void *p_cap) { return 0; }
+UINT8 bta_av_sbc_cfg_in_cap(UINT8 *p_cfg, tA2D_SBC_CIE *p_cap) { return 0; }
+UINT8 bta_av_sbc_cfg_matches_cap(UINT8 *p_cfg, tA2D_SBC_CIE *p_cap) { return 0; }
+void bta_av_sbc_bld_hdr(BT_HDR *p_buf, UINT16 fr_per_pkt) {}
+void bta_av_ci_setconfig(UINT8 hndl, UINT8 err_code, UINT8 category,
+                         UINT8 num_seid, UINT8 *p_seid, BOOLEAN recfg_needed,
+                         UINT8 avdt_handle) {}
+void BTA_AvReconfig(UINT8 hndl, BOOLEAN suspend, UINT8 sep_info_idx,
+                    UINT8 *p_codec_info, UINT8 num_protect,
+                    UINT8 *p_protect_info) {}
+UINT8 bta_av_get_codec_type() { return 0; }
+BOOLEAN btif_av_is_multicast_supported() { return FALSE; }
+BOOLEAN btif_av_is_offload_supported() { return FALSE; }
+BT_HDR *btif_media_aa_readbuf(void) { return NULL; }
+}
+
+// While set, A2D_ParsSbcInfo() parks the caller, which then holds the codec
+// lock of bta_av_co_audio_get_sbc_config(), until it is cleared again.
+static std::atomic<bool> hold_codec_lock(false);
+static std::atomic<bool> codec_lock_held(false);
+
+tA2D_STATUS A2D_ParsSbcInfo(tA2D_SBC_CIE *p_ie, const UINT8 *p_info,
+                            BOOLEAN for_caps) {
+  if (hold_codec_lock) {
+    codec_lock_held = true;
+    while (hold_codec_lock)
+      std::this_thread::yield();
+    codec_lock_held = false;
+  }
+  return A2D_SUCCESS;
+}
+
+// RFCOMM ports writing as fast as they can, each queuing one L2CAP sized
+// buffer per lock hold like PORT_WriteData does.
+static const int PORT_WRITERS = 4;
+static const size_t PORT_WRITE_SIZE = 1021;
+static const size_t PORT_QUEUE_DEPTH = 8;
+
+// A2DP media ticks, which read the codec configuration on every tick.
+static const int MEDIA_TICKS = 200;
+static const auto MEDIA_TICK_INTERVAL = std::chrono::milliseconds(1);
+
+static const auto DEADLOCK_TIMEOUT = std::chrono::seconds(5);
+
+namespace {
+
+// Queues one buffer on the tx queue of |p_port| and, once the queue is deep
+// enough, drops the oldest as if it had been sent, all under the port lock.
+void port_write(tPORT *p_port) {
+  BT_HDR *p_buf = (BT_HDR *)osi_malloc(BT_HDR_SIZE + PORT_WRITE_SIZE);
+  p_buf->len = PORT_WRITE_SIZE;
+
+  port_lock(p_port);
+  fixed_queue_enqueue(p_port->tx.queue, p_buf);
+  p_port->tx.queue_size += p_buf->len;
+  if (fixed_queue_length(p_port->tx.queue) > PORT_QUEUE_DEPTH) {
+    p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_port->tx.queue);
+    p_port->tx.queue_size -= p_buf->len;
+    osi_free(p_buf);
+  }
+  port_unlock(p_port);
+}
+
+// One media tick: the encoder reads the current SBC configuration, which
+// takes the codec lock in bta_av_co.c.
+void media_tick(void) {
+  tA2D_SBC_CIE sbc_config;
+  UINT16 minmtu;
+  bta_av_co_audio_get_sbc_config(&sbc_config, &minmtu);
+}
+
+}  // namespace
+
+class PortLockTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    mutex_init();
+    memset(&rfc_cb, 0, sizeof(rfc_cb));
+    port_init_locks();
+    for (int i = 0; i < PORT_WRITERS; ++i)
+      rfc_cb.port.port[i].tx.queue = fixed_queue_new(SIZE_MAX);
+    bta_av_co_audio_codec_reset();
+  }
+
+  virtual void TearDown() {
+    for (int i = 0; i < PORT_WRITERS; ++i)
+      fixed_queue_free(rfc_cb.port.port[i].tx.queue, osi_free);
+    mutex_cleanup();
+    AllocationTestHarness::TearDown();
+  }
+};
+
+// A port holding its queue lock must not block other ports, the codec
+// configuration or users of the global lock.
+TEST_F(PortLockTest, test_port_lock_does_not_block_others) {
+  port_lock(&rfc_cb.port.port[0]);
+
+  std::future<void> other = std::async(std::launch::async, []() {
+    port_write(&rfc_cb.port.port[1]);
+    media_tick();
+    mutex_global_lock();
+    mutex_global_unlock();
+  });
+  EXPECT_EQ(std::future_status::ready, other.wait_for(DEADLOCK_TIMEOUT));
+
+  port_unlock(&rfc_cb.port.port[0]);
+  other.get();
+  EXPECT_EQ(1u, fixed_queue_length(rfc_cb.port.port[1].tx.queue));
+  EXPECT_EQ(PORT_WRITE_SIZE, rfc_cb.port.port[1].tx.queue_size);
+}
+
+// Likewise the codec lock, held by the media task while it reads or changes
+// the codec configuration, must not block RFCOMM data.
+TEST_F(PortLockTest, test_codec_lock_does_not_block_ports) {
+  hold_codec_lock = true;
+  std::thread media(media_tick);
+  while (!codec_lock_held)
+    std::this_thread::yield();
+
+  std::future<void> port = std::async(std::launch::async, []() {
+    for (int i = 0; i < PORT_WRITERS; ++i)
+      port_write(&rfc_cb.port.port[i]);
+  });
+  EXPECT_EQ(std::future_status::ready, port.wait_for(DEADLOCK_TIMEOUT));
+
+  hold_codec_lock = false;
+  media.join();
+  port.get();
+  for (int i = 0; i < PORT_WRITERS; ++i)
+    EXPECT_EQ(1u, fixed_queue_length(rfc_cb.port.port[i].tx.queue));
+}
+
+// Runs busy port writers next to a 1 ms media tick and prints how long each
+// tick took. Timing is only reported, not asserted on.
+TEST_F(PortLockTest, test_benchmark_port_writers_media_tick) {
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> writes(0);
+
+  std::vector<std::thread> writers;
+  for (int i = 0; i < PORT_WRITERS; ++i) {
+    tPORT *p_port = &rfc_cb.port.port[i];
+    writers.emplace_back([&, p_port]() {
+      while (!done) {
+        port_write(p_port);
+        ++writes;
+      }
+    });
+  }
+
+  std::vector<int64_t> tick_ns;
+  for (int tick = 0; tick < MEDIA_TICKS; ++tick) {
+    std::this_thread::sleep_for(MEDIA_TICK_INTERVAL);
+    const auto start = std::chrono::steady_clock::now();
+    media_tick();
+    tick_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+
+  done = true;
+  for (auto &writer : writers)
+    writer.join();
+
+  ASSERT_EQ((size_t)MEDIA_TICKS, tick_ns.size());
+  EXPECT_GT(writes, 0u);
+
+  std::sort(tick_ns.begin(), tick_ns.end());
+  const size_t n = tick_ns.size();
+  printf("media tick p50 %lld ns, p99 %lld ns, max %lld ns; %llu port writes\n",
+         (long long)tick_ns[n / 2], (long long)tick_ns[n * 99 / 100],
+         (long long)tick_ns[n - 1], (unsigned long long)writes.load());
+}
@@ -0,0 +1,353 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "L2capTestHarness.h"
+
+extern "C" {
+#include "l2cdefs.h"
+#include "port_api.h"
+#include "port_int.h"
+#include "rfc_int.h"
+#include "rfcdefs.h"
+#include "sdpdefs.h"
+}
+
+static const BD_ADDR kPeer = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint16_t kHandle = 0x0001;
+static const uint8_t kScn = 3;
+
+// The peer's L2CAP MTU, which bounds the RFCOMM frames sent to it.
+static const uint16_t kPeerL2capMtu = 1017;
+
+// The RFCOMM channel is the first one the peer accepts.
+static const uint16_t kRfcommCid = 0x0040;
+
+// What the app pushes through the port per benchmark run, in the chunks a
+// socket read hands to it.
+static const size_t BENCH_BYTES = 8 * 1024 * 1024;
+static const uint16_t BENCH_CHUNK = 4096;
+
+namespace {
+
+struct RfcommFrame {
+  uint8_t dlci;
+  uint8_t type;
+  bool pf;
+  uint8_t credits;
+  std::vector<uint8_t> info;
+};
+
+RfcommFrame parse_frame(const std::vector<uint8_t> &packet) {
+  RfcommFrame frame;
+  size_t pos = 0;
+
+  frame.dlci = packet[pos++] >> RFCOMM_SHIFT_DLCI;
+  frame.type = packet[pos] & ~RFCOMM_PF_MASK;
+  frame.pf = (packet[pos++] & RFCOMM_PF_MASK) != 0;
+
+  size_t len = packet[pos] >> RFCOMM_SHIFT_LENGTH1;
+  if (!(packet[pos++] & RFCOMM_EA))
+    len += packet[pos++] << RFCOMM_SHIFT_LENGTH2;
+
+  frame.credits = 0;
+  if (frame.type == RFCOMM_UIH && frame.pf && frame.dlci != RFCOMM_MX_DLCI)
+    frame.credits = packet[pos++];
+
+  EXPECT_EQ(packet.size(), pos + len + 1);
+  frame.info.assign(packet.begin() + pos, packet.begin() + pos + len);
+  return frame;
+}
+
+}  // namespace
+
+// Opens an RFCOMM port to a fake peer over the real L2CAP, with the
+// harness' fake controller as L2CAP's lower edge. The peer answers what
+// the stack sends and grants credits back for every data frame it takes.
+class PortWriteTest : public L2capTestHarness {
+  protected:
+    virtual void SetUp() {
+      L2capTestHarness::SetUp();
+      RFCOMM_Init();
+      answer_sabme_ = true;
+      pending_sabme_ = 0;
+      msc_sent_ = false;
+      port_handle_ = 0;
+      received_.clear();
+      frames_ = 0;
+    }
+
+    // Starts connecting the port; L2CAP pages the peer first.
+    void CreateConnection() {
+      ASSERT_EQ(PORT_SUCCESS,
+                RFCOMM_CreateConnection(UUID_SERVCLASS_SERIAL_PORT, kScn, FALSE,
+                                        0, (UINT8 *)kPeer, &port_handle_,
+                                        port_mgmt_cb));
+      ConnectClassic(kPeer, kHandle);
+      AnswerSignaling(kHandle, kPeerL2capMtu);
+    }
+
+    void OpenPort() {
+      CreateConnection();
+      Pump();
+      ASSERT_EQ(PORT_STATE_OPENED, port()->state);
+    }
+
+    tPORT *port() { return &rfc_cb.port.port[port_handle_ - 1]; }
+
+    // Sends a frame from the peer. The peer is not the initiator.
+    void SendFrame(uint8_t dlci, uint8_t type, bool command,
+                   const std::vector<uint8_t> &info, uint8_t credits = 0) {
+      std::vector<uint8_t> frame;
+      frame.push_back(RFCOMM_EA | RFCOMM_CR(FALSE, command) |
+                      (dlci << RFCOMM_SHIFT_DLCI));
+      frame.push_back(type | ((type != RFCOMM_UIH || credits) ? RFCOMM_PF : 0));
+      if (info.size() <= 127) {
+        frame.push_back(RFCOMM_EA | (info.size() << RFCOMM_SHIFT_LENGTH1));
+      } else {
+        frame.push_back((info.size() & 0x7f) << RFCOMM_SHIFT_LENGTH1);
+        frame.push_back(info.size() >> RFCOMM_SHIFT_LENGTH2);
+      }
+      if (credits)
+        frame.push_back(credits);
+      frame.insert(frame.end(), info.begin(), info.end());
+      frame.push_back(rfc_calc_fcs(type == RFCOMM_UIH ? 2 : 3, frame.data()));
+      Receive(kHandle, LocalCid(kRfcommCid), frame.data(), frame.size());
+    }
+
+    void SendMx(uint8_t type, bool command, const std::vector<uint8_t> &data) {
+      std::vector<uint8_t> info;
+      info.push_back(RFCOMM_EA | RFCOMM_I_CR(command) | type);
+      info.push_back(RFCOMM_EA | (data.size() << RFCOMM_SHIFT_LENGTH1));
+      info.insert(info.end(), data.begin(), data.end());
+      SendFrame(RFCOMM_MX_DLCI, RFCOMM_UIH, true, info);
+    }
+
+    void AnswerMx(const std::vector<uint8_t> &info) {
+      const uint8_t type = info[0] & ~(RFCOMM_CR_MASK | RFCOMM_EA_MASK);
+      const bool command = (info[0] & RFCOMM_CR_MASK) != 0;
+      std::vector<uint8_t> data(info.begin() + 2, info.end());
+
+      if (!command)
+        return;
+
+      switch (type) {
+        case RFCOMM_MX_PN:
+          // Takes the MTU offered and answers credit based flow control.
+          if ((data[1] & RFCOMM_PN_CONV_LAYER_MASK) == RFCOMM_PN_CONV_LAYER_CBFC_I)
+            data[1] = RFCOMM_PN_CONV_LAYER_CBFC_R;
+          data[7] = RFCOMM_K_MAX;
+          SendMx(RFCOMM_MX_PN, false, data);
+          break;
+
+        case RFCOMM_MX_MSC:
+          SendMx(RFCOMM_MX_MSC, false, data);
+          if (!msc_sent_) {
+            data[1] = RFCOMM_EA | RFCOMM_MSC_RTC | RFCOMM_MSC_RTR | RFCOMM_MSC_DV;
+            SendMx(RFCOMM_MX_MSC, true, data);
+            msc_sent_ = true;
+          }
+          break;
+      }
+    }
+
+    // Answers every RFCOMM frame the stack has sent and returns a credit
+    // for each data frame taken, until the stack has nothing more to send.
+    void Pump() {
+      for (std::vector<FakeHciPacket> packets = TakePackets(); !packets.empty();
+           packets = TakePackets()) {
+        uint8_t credits = 0;
+        uint8_t data_dlci = 0;
+
+        CompletePackets(kHandle, packets.size());
+        for (const FakeHciPacket &packet : packets) {
+          ASSERT_FALSE(packet.is_cmd);
+          ASSERT_EQ(kRfcommCid, packet.cid);
+          RfcommFrame frame = parse_frame(packet.payload);
+
+          if (frame.type == RFCOMM_SABME) {
+            if (frame.dlci == RFCOMM_MX_DLCI || answer_sabme_)
+              SendFrame(frame.dlci, RFCOMM_UA, false, std::vector<uint8_t>());
+            else
+              pending_sabme_ = frame.dlci;
+          } else if (frame.type == RFCOMM_DISC) {
+            SendFrame(frame.dlci, RFCOMM_UA, false, std::vector<uint8_t>());
+          } else if (frame.type == RFCOMM_UIH && frame.dlci == RFCOMM_MX_DLCI) {
+            AnswerMx(frame.info);
+          } else if (frame.type == RFCOMM_UIH && !frame.info.empty()) {
+            received_.insert(received_.end(), frame.info.begin(), frame.info.end());
+            ++frames_;
+            ++credits;
+            data_dlci = frame.dlci;
+          }
+        }
+        if (credits)
+          SendFrame(data_dlci, RFCOMM_UIH, true, std::vector<uint8_t>(), credits);
+      }
+    }
+
+    // Answers the SABME held back while |answer_sabme_| was false.
+    void AnswerPendingSabme() {
+      answer_sabme_ = true;
+      ASSERT_NE(0, pending_sabme_);
+      SendFrame(pending_sabme_, RFCOMM_UA, false, std::vector<uint8_t>());
+      Pump();
+    }
+
+    static void port_mgmt_cb(UINT32 code, UINT16 port_handle) {}
+
+    bool answer_sabme_;
+    uint8_t pending_sabme_;
+    bool msc_sent_;
+    UINT16 port_handle_;
+    std::vector<uint8_t> received_;
+    size_t frames_;
+};
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t len, size_t start = 0) {
+  std::vector<uint8_t> data(len);
+  for (size_t i = 0; i < len; ++i)
+    data[i] = (uint8_t)((start + i) * 7);
+  return data;
+}
+
+// The socket the app writes to, read through the data call-out.
+const uint8_t *co_src;
+size_t co_left;
+size_t co_copied;
+
+int data_co_cb(UINT16 port_handle, UINT8 *p_buf, UINT16 len, int type) {
+  if (type == DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE) {
+    int available = co_left < BENCH_CHUNK ? co_left : BENCH_CHUNK;
+    memcpy(p_buf, &available, sizeof(available));
+    return TRUE;
+  }
+  if (type != DATA_CO_CALLBACK_TYPE_OUTGOING || len > co_left)
+    return FALSE;
+  memcpy(p_buf, co_src, len);
+  co_src += len;
+  co_left -= len;
+  co_copied += len;
+  return TRUE;
+}
+
+}  // namespace
+
+TEST_F(PortWriteTest, test_write_reaches_peer_in_mtu_frames) {
+  OpenPort();
+  const std::vector<uint8_t> data = pattern(3000);
+  UINT16 len = 0;
+
+  EXPECT_EQ(PORT_SUCCESS, PORT_WriteData(port_handle_, (char *)data.data(),
+                                         data.size(), &len));
+  EXPECT_EQ(data.size(), len);
+  Pump();
+
+  EXPECT_EQ(data, received_);
+  const size_t frame_size = port()->peer_mtu;
+  EXPECT_EQ((data.size() + frame_size - 1) / frame_size, frames_);
+}
+
+// Data written while the port opens is queued with the default MTU in
+// force. Parameter negotiation then raises the MTU before the port is up,
+// and the next write goes to the tail of the queue under the new one.
+TEST_F(PortWriteTest, test_append_after_mtu_grows_while_opening) {
+  const std::vector<uint8_t> data = pattern(600);
+  UINT16 len = 0;
+
+  answer_sabme_ = false;
+  CreateConnection();
+  EXPECT_EQ(RFCOMM_DEFAULT_MTU, port()->peer_mtu);
+  EXPECT_EQ(PORT_SUCCESS,
+            PORT_WriteData(port_handle_, (char *)data.data(), 100, &len));
+  EXPECT_EQ(100, len);
+
+  Pump();
+  ASSERT_EQ(PORT_STATE_OPENING, port()->state);
+  ASSERT_GT(port()->peer_mtu, data.size());
+  EXPECT_EQ(1u, fixed_queue_length(port()->tx.queue));
+
+  EXPECT_EQ(PORT_SUCCESS, PORT_WriteData(port_handle_, (char *)data.data() + 100,
+                                         data.size() - 100, &len));
+  EXPECT_EQ(data.size() - 100, len);
+  EXPECT_EQ(1u, fixed_queue_length(port()->tx.queue));
+
+  AnswerPendingSabme();
+  ASSERT_EQ(PORT_STATE_OPENED, port()->state);
+  EXPECT_EQ(data, received_);
+  EXPECT_EQ(1u, frames_);
+}
+
+// Compares the copying write with the call-out one the app socket uses,
+// from the app down to the controller. Timing is only reported, not
+// asserted on.
+TEST_F(PortWriteTest, test_benchmark_port_write) {
+  OpenPort();
+  const std::vector<uint8_t> data = pattern(BENCH_BYTES);
+  std::vector<uint8_t> app_buf(BENCH_CHUNK);
+  size_t copied = 0;
+
+  // The app reads its socket into a buffer that PORT_WriteData copies
+  // into frames.
+  auto start = std::chrono::steady_clock::now();
+  for (size_t sent = 0; sent < data.size();) {
+    UINT16 chunk = std::min((size_t)BENCH_CHUNK, data.size() - sent);
+    memcpy(app_buf.data(), data.data() + sent, chunk);
+    copied += chunk;
+    for (UINT16 off = 0; off < chunk;) {
+      UINT16 len = 0;
+      ASSERT_EQ(PORT_SUCCESS, PORT_WriteData(port_handle_,
+                                             (char *)app_buf.data() + off,
+                                             chunk - off, &len));
+      off += len;
+      copied += len;
+      Pump();
+    }
+    sent += chunk;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  const double copy_s = std::chrono::duration<double>(elapsed).count();
+  EXPECT_TRUE(data == received_);
+  printf("PORT_WriteData: %.1f MB/s, %zu bytes copied\n",
+         BENCH_BYTES / copy_s / (1024 * 1024), copied);
+
+  // The call-out reads the socket straight into the frames.
+  received_.clear();
+  co_src = data.data();
+  co_left = data.size();
+  co_copied = 0;
+  ASSERT_EQ(PORT_SUCCESS, PORT_SetDataCOCallback(port_handle_, data_co_cb));
+  start = std::chrono::steady_clock::now();
+  while (co_left) {
+    int len = 0;
+    ASSERT_EQ(PORT_SUCCESS, PORT_WriteDataCO(port_handle_, &len));
+    Pump();
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  const double co_s = std::chrono::duration<double>(elapsed).count();
+  EXPECT_TRUE(data == received_);
+  printf("PORT_WriteDataCO: %.1f MB/s, %zu bytes copied\n",
+         BENCH_BYTES / co_s / (1024 * 1024), co_copied);
+}
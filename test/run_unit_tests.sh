@@ -8,6 +8,8 @@ known_tests=(
   net_test_hci
   net_test_osi
   net_test_btif
+  net_test_stack
+  net_test_bta
 )
 
 usage() {
@@ -57,3 +57,37 @@ LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
 LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
 
 include $(BUILD_NATIVE_TEST)
+
+# Bluetooth benchmarks for target, run on top of test_vendor_lib
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := net_bench_bluetooth
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../../
+
+LOCAL_SRC_FILES := \
+    adapter/bluetooth_test.cpp \
+    bench/bench_test.cpp \
+    bench/bench_unittest.cpp \
+    gatt/gatt_test.cpp \
+    $(bluetoothHalSrc)
+
+LOCAL_SHARED_LIBRARIES += \
+    liblog \
+    libhardware \
+    libhardware_legacy \
+    libcutils \
+    libchrome
+
+LOCAL_STATIC_LIBRARIES += \
+  libbtcore \
+  libosi
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,265 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "bench/bench_test.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <base/json/json_writer.h>
+#include <base/logging.h>
+#include <base/values.h>
+
+namespace {
+
+// The port test_vendor_lib listens on for the test channel.
+const int kTestChannelPort = 6111;
+
+// How long to keep retrying the test channel while the stack enables.
+const int kConnectAttempts = 200;
+const int kConnectRetryIntervalUs = 50 * 1000;
+
+// Collects the results of all benchmarks and writes them out as one JSON
+// object once the whole suite has run.
+class BenchReport : public ::testing::Environment {
+ public:
+  void TearDown() override {
+    std::string json;
+    base::JSONWriter::WriteWithOptions(
+        results_, base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+
+    const char* path = getenv("BT_BENCH_OUTPUT");
+    FILE* out = path ? fopen(path, "w") : stdout;
+    if (!out) {
+      fprintf(stderr, "Unable to open %s: %s\n", path, strerror(errno));
+      out = stdout;
+    }
+    fputs(json.c_str(), out);
+    if (out != stdout)
+      fclose(out);
+  }
+
+  base::DictionaryValue results_;
+};
+
+BenchReport* const g_report = static_cast<BenchReport*>(
+    ::testing::AddGlobalEnvironment(new BenchReport()));
+
+int64_t ToMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+}  // namespace
+
+namespace bttest {
+
+const char kBenchDeviceNamePrefix[] = "BENCH";
+
+TestChannelClient::TestChannelClient() : fd_(-1) {}
+
+TestChannelClient::~TestChannelClient() {
+  Close();
+}
+
+void TestChannelClient::ConnectAsync(int port) {
+  CHECK(fd_ < 0 && !connect_thread_.joinable());
+  connect_thread_ = std::thread([this, port]() {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int attempt = 0; attempt < kConnectAttempts; ++attempt) {
+      int fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (fd < 0)
+        return;
+      if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)) == 0) {
+        fd_ = fd;
+        return;
+      }
+      close(fd);
+      usleep(kConnectRetryIntervalUs);
+    }
+  });
+}
+
+bool TestChannelClient::WaitForConnection() {
+  if (connect_thread_.joinable())
+    connect_thread_.join();
+  return fd_ >= 0;
+}
+
+bool TestChannelClient::SendCommand(const std::string& name,
+                                    const std::vector<std::string>& args) {
+  if (fd_ < 0 || name.size() > 255 || args.size() > 255)
+    return false;
+
+  // Every size is encoded in one octet: the name, the number of arguments and
+  // each argument.
+  std::string command;
+  command.push_back(static_cast<char>(name.size()));
+  command.append(name);
+  command.push_back(static_cast<char>(args.size()));
+  for (const std::string& arg : args) {
+    if (arg.size() > 255)
+      return false;
+    command.push_back(static_cast<char>(arg.size()));
+    command.append(arg);
+  }
+
+  size_t sent = 0;
+  while (sent < command.size()) {
+    ssize_t ret = send(fd_, command.data() + sent, command.size() - sent,
+                       MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    sent += ret;
+  }
+  return true;
+}
+
+void TestChannelClient::Close() {
+  if (connect_thread_.joinable())
+    connect_thread_.join();
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void LatencySamples::Add(std::chrono::steady_clock::duration sample) {
+  samples_us_.push_back(ToMicroseconds(sample));
+}
+
+void LatencySamples::Record(const std::string& path) const {
+  RecordBenchmarkResult(path + ".count", samples_us_.size());
+  if (samples_us_.empty())
+    return;
+
+  std::vector<int64_t> sorted(samples_us_);
+  std::sort(sorted.begin(), sorted.end());
+  int64_t sum = 0;
+  for (int64_t sample : sorted)
+    sum += sample;
+
+  const size_t n = sorted.size();
+  RecordBenchmarkResult(path + ".min_us", sorted.front());
+  RecordBenchmarkResult(path + ".p50_us", sorted[n / 2]);
+  RecordBenchmarkResult(path + ".p99_us",
+                        sorted[std::min(n - 1, n * 99 / 100)]);
+  RecordBenchmarkResult(path + ".max_us", sorted.back());
+  RecordBenchmarkResult(path + ".mean_us", static_cast<double>(sum) / n);
+}
+
+void RecordBenchmarkResult(const std::string& path, double value) {
+  g_report->results_.SetDouble(path, value);
+}
+
+void BenchTest::SetUp() {
+  expected_events_ = 0;
+  conn_id_ = 0;
+  connected_ = false;
+  events_callback_sem_ = semaphore_new(0);
+  connection_callback_sem_ = semaphore_new(0);
+
+  test_channel_.ConnectAsync(kTestChannelPort);
+  GattTest::SetUp();
+  ASSERT_TRUE(test_channel_.WaitForConnection())
+      << "Benchmarks need the test channel of test_vendor_lib on port "
+      << kTestChannelPort;
+  ASSERT_TRUE(test_channel_.SendCommand("CLEAR", {}));
+}
+
+void BenchTest::TearDown() {
+  GattTest::TearDown();
+  test_channel_.Close();
+
+  semaphore_free(events_callback_sem_);
+  semaphore_free(connection_callback_sem_);
+}
+
+void BenchTest::ExpectEvents(size_t count) {
+  std::lock_guard<std::mutex> lock(event_lock_);
+  ClearSemaphore(events_callback_sem_);
+  event_times_.clear();
+  event_times_.reserve(count);
+  expected_events_ = count;
+}
+
+std::vector<std::chrono::steady_clock::time_point> BenchTest::GetEventTimes() {
+  std::lock_guard<std::mutex> lock(event_lock_);
+  return event_times_;
+}
+
+void BenchTest::OnEvent() {
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(event_lock_);
+  if (event_times_.size() >= expected_events_)
+    return;
+  event_times_.push_back(now);
+  if (event_times_.size() == expected_events_)
+    semaphore_post(events_callback_sem_);
+}
+
+void BenchTest::DeviceFoundCallback(int num_properties,
+                                    bt_property_t* properties) {
+  const size_t prefix_length = strlen(kBenchDeviceNamePrefix);
+  for (int i = 0; i < num_properties; ++i) {
+    if (properties[i].type == BT_PROPERTY_BDNAME &&
+        properties[i].len >= static_cast<int>(prefix_length) &&
+        !memcmp(properties[i].val, kBenchDeviceNamePrefix, prefix_length)) {
+      OnEvent();
+      return;
+    }
+  }
+}
+
+void BenchTest::ScanResultCallback(
+    bluetooth::hal::BluetoothGattInterface* /* unused */,
+    const bt_bdaddr_t& bda, int rssi, uint8_t* adv_data) {
+  OnEvent();
+}
+
+void BenchTest::ConnectionCallback(
+    bluetooth::hal::BluetoothGattInterface* /* unused */,
+    int conn_id, int server_if, int connected, const bt_bdaddr_t& bda) {
+  conn_id_ = conn_id;
+  connected_ = connected;
+  semaphore_post(connection_callback_sem_);
+}
+
+void BenchTest::IndicationSentCallback(
+    bluetooth::hal::BluetoothGattInterface* /* unused */,
+    int conn_id, int status) {
+  OnEvent();
+}
+
+}  // bttest
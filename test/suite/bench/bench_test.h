@@ -0,0 +1,155 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gatt/gatt_test.h"
+
+namespace bttest {
+
+// Client side of the test channel of the simulated controller in
+// vendor_libs/test_vendor_lib, used by the benchmarks to generate traffic.
+class TestChannelClient {
+ public:
+  TestChannelClient();
+  ~TestChannelClient();
+
+  // Starts connecting to |port| on a separate thread. The vendor library
+  // blocks until the test channel is accepted while the stack is enabling, so
+  // this has to be called before bt_interface()->enable().
+  void ConnectAsync(int port);
+
+  // Waits for the connection started by ConnectAsync(). Returns false if the
+  // test channel could not be reached.
+  bool WaitForConnection();
+
+  // Sends the command |name| with |args|, encoded the same way as
+  // vendor_libs/test_vendor_lib/scripts/test_channel.py does.
+  bool SendCommand(const std::string& name,
+                   const std::vector<std::string>& args);
+
+  // Closes the connection. Call after the stack is disabled, once the vendor
+  // library no longer watches the other end.
+  void Close();
+
+ private:
+  std::thread connect_thread_;
+  int fd_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestChannelClient);
+};
+
+// Samples of one latency measured by a benchmark.
+class LatencySamples {
+ public:
+  void Add(std::chrono::steady_clock::duration sample);
+  size_t size() const { return samples_us_.size(); }
+
+  // Records the count, min, p50, p99, max and mean of the samples, in
+  // microseconds, under |path| in the benchmark report.
+  void Record(const std::string& path) const;
+
+ private:
+  std::vector<int64_t> samples_us_;
+};
+
+// Devices found during discovery are only counted as events if their name
+// starts with this prefix, so that the fixed inquiry result of the simulated
+// controller does not skew the results.
+extern const char kBenchDeviceNamePrefix[];
+
+// Records |value| under the dotted |path| of the JSON report that is written
+// once all benchmarks have run, to the file named by $BT_BENCH_OUTPUT or to
+// stdout.
+void RecordBenchmarkResult(const std::string& path, double value);
+
+// Fixture for the benchmarks. Runs against test_vendor_lib and times the HAL
+// callbacks for traffic generated through its test channel.
+class BenchTest : public GattTest {
+ protected:
+  BenchTest() = default;
+  virtual ~BenchTest() = default;
+
+  // Connects the test channel while the stack is enabling and resets the
+  // simulated controller.
+  void SetUp() override;
+
+  // Disables the stack, then closes the test channel.
+  void TearDown() override;
+
+  TestChannelClient* test_channel() { return &test_channel_; }
+
+  // Clears the recorded arrival times and makes |events_callback_sem_| post
+  // once |count| scan results, found devices or sent notifications arrive.
+  void ExpectEvents(size_t count);
+
+  // Returns the arrival times recorded since the last ExpectEvents().
+  std::vector<std::chrono::steady_clock::time_point> GetEventTimes();
+
+  int conn_id() const { return conn_id_; }
+  bool connected() const { return connected_; }
+
+  // bluetooth::hal::BluetoothInterface::Observer override
+  void DeviceFoundCallback(int num_properties,
+                           bt_property_t* properties) override;
+
+  // bluetooth::hal::BluetoothGattInterface::ClientObserver override
+  void ScanResultCallback(
+      bluetooth::hal::BluetoothGattInterface* /* unused */,
+      const bt_bdaddr_t& bda, int rssi, uint8_t* adv_data) override;
+
+  // bluetooth::hal::BluetoothGattInterface::ServerObserver overrides
+  void ConnectionCallback(
+      bluetooth::hal::BluetoothGattInterface* /* unused */,
+      int conn_id, int server_if, int connected,
+      const bt_bdaddr_t& bda) override;
+  void IndicationSentCallback(
+      bluetooth::hal::BluetoothGattInterface* /* unused */,
+      int conn_id, int status) override;
+
+  // Posted once the number of events passed to ExpectEvents() arrived.
+  semaphore_t* events_callback_sem_;
+
+  // Posted when a GATT server connection is established or lost.
+  semaphore_t* connection_callback_sem_;
+
+ private:
+  // Records the arrival of one event.
+  void OnEvent();
+
+  TestChannelClient test_channel_;
+
+  // Protects |event_times_| and |expected_events_|, which are written from the
+  // HAL callback thread.
+  std::mutex event_lock_;
+  std::vector<std::chrono::steady_clock::time_point> event_times_;
+  size_t expected_events_;
+
+  int conn_id_;
+  bool connected_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchTest);
+};
+
+}  // bttest
@@ -0,0 +1,377 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "bench/bench_test.h"
+
+namespace {
+
+using std::chrono::steady_clock;
+
+// LE scan: advertising reports generated per second by the controller, the
+// number of distinct advertisers and the advertising data lengths they cycle
+// through.
+const char kScanReportRate[] = "2000";
+const char kScanAdvertisers[] = "64";
+const std::vector<std::string> kScanDataLengths = {"0", "8", "31"};
+const size_t kScanReports = 4000;
+
+// Inquiry: devices reported per test channel command, and number of rounds.
+// Each device gets a new address so that the inquiry database does not filter
+// it out as a duplicate.
+const size_t kInquiryDevicesPerRound = 32;
+const size_t kInquiryRounds = 8;
+
+// GATT notifications: number sent one at a time and as a burst, and their
+// size, which fits the default ATT MTU of 23.
+const size_t kSerialNotifications = 500;
+const size_t kBurstNotifications = 5000;
+const int kNotificationLength = 20;
+
+// ACL flow control of the simulated peer for the notification benchmark.
+const char kCompletedPacketsBatch[] = "4";
+
+// BT_TRANSPORT_LE as understood by the GATT server HAL.
+const int kTransportLe = 2;
+
+// Sockets: the peer's RFCOMM server channel and LE PSM, round trips of a small
+// write, and the data echoed in bulk, written in chunks of at most
+// |kSocketChunkLength|.
+const int kRfcommChannel = 5;
+const int kLePsm = 0x0080;
+const size_t kSocketRoundTrips = 200;
+const size_t kSocketSmallWriteLength = 64;
+const size_t kSocketBulkLength = 2 * 1024 * 1024;
+const size_t kSocketChunkLength = 4096;
+
+// L2CAP_MASK_LE_COC_CHANNEL of btif/include/btif_sock_l2cap.h: selects an LE
+// credit based channel instead of a BR/EDR one.
+const int kLeCocChannelFlag = 0x20000;
+
+double ToSeconds(steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(duration)
+      .count();
+}
+
+void CreateUuid(bt_uuid_t* uuid, uint8_t seed) {
+  for (int i = 0; i < 16; ++i)
+    uuid->uu[i] = seed + i;
+}
+
+bool ReadAll(int fd, void* data, size_t length) {
+  uint8_t* p = static_cast<uint8_t*>(data);
+  while (length > 0) {
+    ssize_t ret = recv(fd, p, length, 0);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    p += ret;
+    length -= ret;
+  }
+  return true;
+}
+
+bool WriteAll(int fd, const void* data, size_t length) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  while (length > 0) {
+    ssize_t ret = send(fd, p, length, MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    p += ret;
+    length -= ret;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace bttest {
+
+// Times a socket of |type| to |channel| on |peer|, which echoes what it
+// receives, and records the results under |path|: the time to connect, round
+// trips of a small write and the rate of a bulk transfer. Writes go in chunks
+// of at most |chunk_length|; an L2CAP socket sends each write as one SDU, and
+// reads return one SDU each.
+static void RunSocketEchoBenchmark(const btsock_interface_t* sock_interface,
+                                   btsock_type_t type, const bt_bdaddr_t& peer,
+                                   int channel, size_t chunk_length,
+                                   const std::string& path) {
+  const steady_clock::time_point connect_start = steady_clock::now();
+  int fd = -1;
+  ASSERT_EQ(BT_STATUS_SUCCESS,
+            sock_interface->connect(&peer, type, nullptr, channel, &fd, 0, 0));
+  ASSERT_LE(0, fd);
+
+  // The stack sends the channel when the connection starts, and a connect
+  // signal once it is open.
+  int assigned_channel;
+  sock_connect_signal_t signal;
+  ASSERT_TRUE(ReadAll(fd, &assigned_channel, sizeof(assigned_channel)));
+  ASSERT_TRUE(ReadAll(fd, &signal, sizeof(signal)));
+  ASSERT_EQ(0, signal.status) << "Error connecting to the simulated peer.";
+  const steady_clock::duration connect_time =
+      steady_clock::now() - connect_start;
+  if (type == BTSOCK_L2CAP && signal.max_tx_packet_size != 0)
+    chunk_length = std::min<size_t>(chunk_length, signal.max_tx_packet_size);
+
+  std::vector<uint8_t> data(std::max(chunk_length, kSocketSmallWriteLength));
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = i;
+  std::vector<uint8_t> echo(data.size());
+
+  LatencySamples round_trip;
+  for (size_t i = 0; i < kSocketRoundTrips; ++i) {
+    const steady_clock::time_point start = steady_clock::now();
+    ASSERT_TRUE(WriteAll(fd, data.data(), kSocketSmallWriteLength));
+    ASSERT_TRUE(ReadAll(fd, echo.data(), kSocketSmallWriteLength));
+    round_trip.Add(steady_clock::now() - start);
+    ASSERT_TRUE(std::equal(echo.begin(), echo.begin() + kSocketSmallWriteLength,
+                           data.begin()));
+  }
+
+  // Writes on one thread and reads the echo on this one, so the transfer is
+  // paced by the flow control of the stack and not by the test.
+  const steady_clock::time_point bulk_start = steady_clock::now();
+  bool written = false;
+  std::thread writer([fd, chunk_length, &data, &written]() {
+    for (size_t sent = 0; sent < kSocketBulkLength; sent += chunk_length) {
+      if (!WriteAll(fd, data.data(),
+                    std::min(chunk_length, kSocketBulkLength - sent)))
+        return;
+    }
+    written = true;
+  });
+  size_t received = 0;
+  while (received < kSocketBulkLength) {
+    const size_t length = std::min(chunk_length, kSocketBulkLength - received);
+    if (!ReadAll(fd, echo.data(), length))
+      break;
+    received += length;
+  }
+  const double bulk_seconds = ToSeconds(steady_clock::now() - bulk_start);
+  if (received < kSocketBulkLength)
+    shutdown(fd, SHUT_RDWR);
+  writer.join();
+  close(fd);
+  ASSERT_TRUE(written);
+  ASSERT_EQ(kSocketBulkLength, received);
+
+  RecordBenchmarkResult(path + ".connect_us",
+                        ToSeconds(connect_time) * 1000000);
+  round_trip.Record(path + ".round_trip");
+  RecordBenchmarkResult(path + ".bytes_per_sec",
+                        kSocketBulkLength / bulk_seconds);
+}
+
+// Delivery of LE advertising reports from the controller to the GATT client
+// HAL while the controller generates them at a fixed rate.
+TEST_F(BenchTest, LeScanReportDelivery) {
+  std::vector<std::string> args = {kScanReportRate, kScanAdvertisers};
+  args.insert(args.end(), kScanDataLengths.begin(), kScanDataLengths.end());
+  ASSERT_TRUE(test_channel()->SendCommand("START_ADVERTISING_REPORTS", args));
+
+  ExpectEvents(kScanReports);
+  const steady_clock::time_point start = steady_clock::now();
+  gatt_client_interface()->scan(true);
+  semaphore_wait(events_callback_sem_);
+  gatt_client_interface()->scan(false);
+  ASSERT_TRUE(test_channel()->SendCommand("STOP_ADVERTISING_REPORTS", {}));
+
+  const std::vector<steady_clock::time_point> times = GetEventTimes();
+  ASSERT_EQ(kScanReports, times.size());
+
+  LatencySamples inter_arrival;
+  for (size_t i = 1; i < times.size(); ++i)
+    inter_arrival.Add(times[i] - times[i - 1]);
+
+  const double window = ToSeconds(times.back() - times.front());
+  RecordBenchmarkResult("le_scan_report.offered_reports_per_sec",
+                        atoi(kScanReportRate));
+  RecordBenchmarkResult("le_scan_report.reports_per_sec",
+                        (times.size() - 1) / window);
+  RecordBenchmarkResult("le_scan_report.first_report_us",
+                        ToSeconds(times.front() - start) * 1000000);
+  inter_arrival.Record("le_scan_report.inter_arrival");
+}
+
+// Delivery of extended inquiry results to the device found HAL callback,
+// measured from the test channel command that makes the controller send them.
+TEST_F(BenchTest, InquiryResultDelivery) {
+  ASSERT_EQ(BT_STATUS_SUCCESS, bt_interface()->start_discovery());
+  semaphore_wait(discovery_state_changed_callback_sem_);
+  ASSERT_EQ(BT_DISCOVERY_STARTED, GetDiscoveryState());
+
+  LatencySamples latency;
+  steady_clock::duration busy(0);
+  for (size_t round = 0; round < kInquiryRounds; ++round) {
+    std::vector<std::string> args;
+    for (size_t i = 0; i < kInquiryDevicesPerRound; ++i) {
+      char name[16];
+      snprintf(name, sizeof(name), "%s%02zu%02zu", kBenchDeviceNamePrefix,
+               round, i);
+      const char address[] = {'B', 'E', 'N', 'C', static_cast<char>(round),
+                              static_cast<char>(i)};
+      args.push_back(name);
+      args.push_back(std::string(address, sizeof(address)));
+    }
+
+    ExpectEvents(kInquiryDevicesPerRound);
+    const steady_clock::time_point start = steady_clock::now();
+    ASSERT_TRUE(test_channel()->SendCommand("DISCOVER", args));
+    semaphore_wait(events_callback_sem_);
+
+    const std::vector<steady_clock::time_point> times = GetEventTimes();
+    for (const auto& time : times)
+      latency.Add(time - start);
+    busy += times.back() - start;
+  }
+
+  ASSERT_EQ(BT_STATUS_SUCCESS, bt_interface()->cancel_discovery());
+  semaphore_wait(discovery_state_changed_callback_sem_);
+
+  RecordBenchmarkResult("inquiry_result.devices_per_sec",
+                        latency.size() / ToSeconds(busy));
+  latency.Record("inquiry_result.latency");
+}
+
+// Cost of sending GATT notifications from the server HAL down to L2CAP, one
+// at a time and as a burst, over an LE link whose peer discards the data.
+TEST_F(BenchTest, GattNotificationThroughput) {
+  ASSERT_TRUE(test_channel()->SendCommand("SET_ACL_MODE", {"sink"}));
+  ASSERT_TRUE(test_channel()->SendCommand("SET_COMPLETED_PACKETS",
+                                          {kCompletedPacketsBatch}));
+
+  bt_uuid_t uuid;
+  CreateUuid(&uuid, 0x10);
+  gatt_server_interface()->register_server(&uuid);
+  semaphore_wait(register_server_callback_sem_);
+  ASSERT_EQ(BT_STATUS_SUCCESS, status()) << "Error registering GATT server.";
+  const int server_if = server_interface_id();
+
+  btgatt_srvc_id_t srvc_id;
+  srvc_id.id.inst_id = 0;
+  srvc_id.is_primary = 1;
+  CreateUuid(&srvc_id.id.uuid, 0x20);
+  gatt_server_interface()->add_service(server_if, &srvc_id, 4 /* # handles */);
+  semaphore_wait(service_added_callback_sem_);
+  ASSERT_EQ(BT_STATUS_SUCCESS, status()) << "Error adding service.";
+  const int srvc_handle = service_handle();
+
+  CreateUuid(&uuid, 0x30);
+  gatt_server_interface()->add_characteristic(
+      server_if, srvc_handle, &uuid, 0x10 /* notify */, 0x01 /* read */);
+  semaphore_wait(characteristic_added_callback_sem_);
+  ASSERT_EQ(BT_STATUS_SUCCESS, status()) << "Error adding characteristic.";
+  const int char_handle = characteristic_handle();
+
+  gatt_server_interface()->start_service(server_if, srvc_handle, kTransportLe);
+  semaphore_wait(service_started_callback_sem_);
+  ASSERT_EQ(BT_STATUS_SUCCESS, status()) << "Error starting service.";
+
+  const bt_bdaddr_t peer = {{0xBE, 0x4C, 0x00, 0x00, 0x00, 0x01}};
+  gatt_server_interface()->connect(server_if, &peer, true, kTransportLe);
+  semaphore_wait(connection_callback_sem_);
+  ASSERT_TRUE(connected()) << "Error connecting to the simulated peer.";
+
+  char value[kNotificationLength];
+  memset(value, 0xA5, sizeof(value));
+
+  LatencySamples latency;
+  for (size_t i = 0; i < kSerialNotifications; ++i) {
+    ExpectEvents(1);
+    const steady_clock::time_point start = steady_clock::now();
+    gatt_server_interface()->send_indication(server_if, char_handle, conn_id(),
+                                             sizeof(value), 0, value);
+    semaphore_wait(events_callback_sem_);
+    latency.Add(GetEventTimes().front() - start);
+  }
+
+  ExpectEvents(kBurstNotifications);
+  const steady_clock::time_point start = steady_clock::now();
+  for (size_t i = 0; i < kBurstNotifications; ++i) {
+    gatt_server_interface()->send_indication(server_if, char_handle, conn_id(),
+                                             sizeof(value), 0, value);
+  }
+  semaphore_wait(events_callback_sem_);
+  const double burst_seconds = ToSeconds(GetEventTimes().back() - start);
+
+  gatt_server_interface()->disconnect(server_if, &peer, conn_id());
+  semaphore_wait(connection_callback_sem_);
+  gatt_server_interface()->stop_service(server_if, srvc_handle);
+  semaphore_wait(service_stopped_callback_sem_);
+  gatt_server_interface()->delete_service(server_if, srvc_handle);
+  semaphore_wait(service_deleted_callback_sem_);
+  gatt_server_interface()->unregister_server(server_if);
+
+  latency.Record("gatt_notification.latency");
+  RecordBenchmarkResult("gatt_notification.notifications_per_sec",
+                        kBurstNotifications / burst_seconds);
+  RecordBenchmarkResult("gatt_notification.bytes_per_sec",
+                        kBurstNotifications * sizeof(value) / burst_seconds);
+}
+
+// Connection time, round trip latency and echoed throughput of an RFCOMM
+// socket to a simulated peer that echoes every frame within the credits the
+// stack grants.
+TEST_F(BenchTest, RfcommSocketEcho) {
+  ASSERT_TRUE(test_channel()->SendCommand("SET_ACL_MODE", {"echo"}));
+  ASSERT_TRUE(test_channel()->SendCommand("SET_COMPLETED_PACKETS",
+                                          {kCompletedPacketsBatch}));
+
+  const btsock_interface_t* sock_interface =
+      static_cast<const btsock_interface_t*>(
+          bt_interface()->get_profile_interface(BT_PROFILE_SOCKETS_ID));
+  ASSERT_NE(nullptr, sock_interface);
+
+  const bt_bdaddr_t peer = {{0xBE, 0x4C, 0x00, 0x00, 0x00, 0x02}};
+  RunSocketEchoBenchmark(sock_interface, BTSOCK_RFCOMM, peer, kRfcommChannel,
+                         kSocketChunkLength, "rfcomm_socket");
+}
+
+// The same over an LE credit based L2CAP socket. BR/EDR L2CAP sockets use
+// enhanced retransmission mode, which the simulated peer does not implement.
+TEST_F(BenchTest, LeCocSocketEcho) {
+  ASSERT_TRUE(test_channel()->SendCommand("SET_ACL_MODE", {"echo"}));
+  ASSERT_TRUE(test_channel()->SendCommand("SET_COMPLETED_PACKETS",
+                                          {kCompletedPacketsBatch}));
+
+  const btsock_interface_t* sock_interface =
+      static_cast<const btsock_interface_t*>(
+          bt_interface()->get_profile_interface(BT_PROFILE_SOCKETS_ID));
+  ASSERT_NE(nullptr, sock_interface);
+
+  const bt_bdaddr_t peer = {{0xBE, 0x4C, 0x00, 0x00, 0x00, 0x03}};
+  RunSocketEchoBenchmark(sock_interface, BTSOCK_L2CAP, peer,
+                         kLePsm | kLeCocChannelFlag, kSocketChunkLength,
+                         "le_coc_socket");
+}
+
+}  // bttest
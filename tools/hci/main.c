@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include "osi/include/osi.h"
+#include "replay.h"
 
 typedef int (*handler_t)(int argc, char **argv);
 
@@ -35,6 +36,7 @@ static void usage(const char *name);
 
 static const command_t commands[] = {
   { "help", "<command> - shows help text for <command>.", help },
+  { "replay", "<btsnoop file> [speed] - replays the controller's packets from a btsnoop log into the stack, <speed> times as fast as recorded (0 for no gaps), and reports the stack's throughput and latency.", hci_replay },
   { "setDiscoverable", "(true|false) - whether the controller should be discoverable.", set_discoverable },
   { "setName", "<name> - sets the device's Bluetooth name to <name>.", set_name },
   { "setPcmLoopback", "(true|false) - enables or disables PCM loopback on the controller.", set_pcm_loopback },
@@ -0,0 +1,406 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "replay.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osi/include/osi.h"
+
+// Must match hci/src/hci_inject.c.
+static const uint8_t HCI_INJECT_INBOUND = 0x80;
+static const uint8_t HCI_INJECT_ACK = 0xFF;
+#define HCI_INJECT_ACK_SIZE (3 + 8)
+
+static const uint8_t BTSNOOP_IDENTIFICATION[] = { 'b', 't', 's', 'n', 'o', 'o', 'p', '\0' };
+static const size_t BTSNOOP_FILE_HEADER_SIZE = 16;
+static const size_t BTSNOOP_RECORD_HEADER_SIZE = 24;
+static const uint32_t BTSNOOP_VERSION = 1;
+static const uint32_t BTSNOOP_DATALINK_H4 = 1002;
+static const uint32_t BTSNOOP_FLAG_RECEIVED = 0x01;
+
+// How long to wait for outstanding acknowledgements once everything is sent.
+static const uint64_t DRAIN_TIMEOUT_US = 5 * 1000000LL;
+
+typedef struct {
+  const uint8_t *data;     // H4 type followed by the packet.
+  size_t length;           // Including the H4 type.
+  uint64_t timestamp_us;
+} record_t;
+
+typedef struct {
+  int sock;
+  uint8_t buffer[HCI_INJECT_ACK_SIZE * 64];
+  size_t buffer_size;
+
+  size_t num_packets;
+  uint64_t *sent_us;       // When each packet was written to the socket.
+  uint32_t *latency_us;    // Stack side latency reported for each packet.
+  uint64_t *round_trip_us; // From writing each packet to reading its ack.
+  size_t num_acked;
+  uint64_t last_ack_us;
+} replay_t;
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static uint32_t read_be32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+  return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  uint8_t *data = NULL;
+  if (fseek(file, 0, SEEK_END) == -1)
+    goto done;
+  long length = ftell(file);
+  if (length < 0 || fseek(file, 0, SEEK_SET) == -1)
+    goto done;
+
+  data = malloc(length ? length : 1);
+  if (data && fread(data, 1, length, file) != (size_t)length) {
+    free(data);
+    data = NULL;
+  }
+  *size = length;
+
+done:;
+  fclose(file);
+  return data;
+}
+
+// Collects the complete packets the controller sent from the btsnoop file
+// in |data|. Returns the number of records stored in |records|, which the
+// caller must free, or -1 if the file is not an H4 btsnoop log.
+static ssize_t parse_btsnoop(const uint8_t *data, size_t size, record_t **records, size_t *skipped) {
+  if (size < BTSNOOP_FILE_HEADER_SIZE ||
+      memcmp(data, BTSNOOP_IDENTIFICATION, sizeof(BTSNOOP_IDENTIFICATION)) ||
+      read_be32(data + 8) != BTSNOOP_VERSION ||
+      read_be32(data + 12) != BTSNOOP_DATALINK_H4)
+    return -1;
+
+  size_t capacity = 1024;
+  size_t count = 0;
+  *records = malloc(capacity * sizeof(record_t));
+  *skipped = 0;
+
+  size_t offset = BTSNOOP_FILE_HEADER_SIZE;
+  while (*records && offset + BTSNOOP_RECORD_HEADER_SIZE <= size) {
+    const uint8_t *header = data + offset;
+    const uint32_t length = read_be32(header);
+    const uint32_t included_length = read_be32(header + 4);
+    const uint32_t flags = read_be32(header + 8);
+    const uint64_t timestamp = ((uint64_t)read_be32(header + 16) << 32) | read_be32(header + 20);
+
+    offset += BTSNOOP_RECORD_HEADER_SIZE;
+    if (offset + included_length > size)
+      break;
+
+    const uint8_t *packet = data + offset;
+    offset += included_length;
+
+    // Only complete controller to host packets can be replayed; whatever
+    // the host sent will be regenerated by the stack itself.
+    if (!(flags & BTSNOOP_FLAG_RECEIVED))
+      continue;
+    if (included_length < 2 || included_length != length || included_length - 1 > UINT16_MAX ||
+        packet[0] < 2 || packet[0] > 4) {
+      ++*skipped;
+      continue;
+    }
+
+    if (count == capacity) {
+      capacity *= 2;
+      record_t *grown = realloc(*records, capacity * sizeof(record_t));
+      if (!grown) {
+        free(*records);
+        *records = NULL;
+        break;
+      }
+      *records = grown;
+    }
+
+    record_t *record = &(*records)[count++];
+    record->data = packet;
+    record->length = included_length;
+    record->timestamp_us = timestamp;
+  }
+
+  return *records ? (ssize_t)count : -1;
+}
+
+static int connect_to_stack(void) {
+  int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (sock == INVALID_FD)
+    return INVALID_FD;
+
+  struct sockaddr_in addr;
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(0x7F000001);
+  addr.sin_port = htons(8873);
+  int ret;
+  OSI_NO_INTR(ret = connect(sock, (const struct sockaddr *)&addr, sizeof(addr)));
+  if (ret == -1) {
+    close(sock);
+    return INVALID_FD;
+  }
+
+  int nodelay = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  return sock;
+}
+
+static bool write_all(int sock, const uint8_t *data, size_t length) {
+  while (length) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = send(sock, data, length, 0));
+    if (ret <= 0)
+      return false;
+    data += ret;
+    length -= ret;
+  }
+  return true;
+}
+
+// Reads acknowledgements until |deadline_us|. Returns false if the
+// connection was lost.
+static bool read_acks(replay_t *replay, uint64_t deadline_us) {
+  for (;;) {
+    const uint64_t now = now_us();
+    struct pollfd pfd = { replay->sock, POLLIN, 0 };
+    int timeout_ms = now < deadline_us ? (int)((deadline_us - now + 999) / 1000) : 0;
+    int ret;
+    OSI_NO_INTR(ret = poll(&pfd, 1, timeout_ms));
+    if (ret <= 0)
+      return ret == 0;
+
+    ssize_t count;
+    OSI_NO_INTR(count = recv(replay->sock, replay->buffer + replay->buffer_size,
+                             sizeof(replay->buffer) - replay->buffer_size, 0));
+    if (count <= 0)
+      return false;
+    replay->buffer_size += count;
+
+    const uint64_t received_us = now_us();
+    size_t offset = 0;
+    for (; offset + HCI_INJECT_ACK_SIZE <= replay->buffer_size; offset += HCI_INJECT_ACK_SIZE) {
+      const uint8_t *ack = replay->buffer + offset;
+      if (ack[0] != HCI_INJECT_ACK || ack[1] != 8 || ack[2] != 0) {
+        printf("Malformed acknowledgement from the stack.\n");
+        return false;
+      }
+
+      const uint32_t seq = read_le32(ack + 3);
+      if (seq >= replay->num_packets)
+        continue;
+      replay->latency_us[seq] = read_le32(ack + 7);
+      replay->round_trip_us[seq] = received_us - replay->sent_us[seq];
+      replay->last_ack_us = received_us;
+      ++replay->num_acked;
+    }
+    memmove(replay->buffer, replay->buffer + offset, replay->buffer_size - offset);
+    replay->buffer_size -= offset;
+
+    if (received_us >= deadline_us)
+      return true;
+  }
+}
+
+static int compare_u64(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void print_latency(const char *name, uint64_t *values, size_t count) {
+  if (!count)
+    return;
+
+  qsort(values, count, sizeof(uint64_t), compare_u64);
+  printf("  %-12s min %llu  p50 %llu  p90 %llu  p99 %llu  max %llu us\n", name,
+         (unsigned long long)values[0],
+         (unsigned long long)values[count / 2],
+         (unsigned long long)values[count * 90 / 100],
+         (unsigned long long)values[count * 99 / 100],
+         (unsigned long long)values[count - 1]);
+}
+
+static void report(const replay_t *replay, const record_t *records, uint64_t start_us) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < replay->num_packets; ++i)
+    bytes += records[i].length - 1;
+
+  const uint64_t trace_us = replay->num_packets > 1 ?
+      records[replay->num_packets - 1].timestamp_us - records[0].timestamp_us : 0;
+  const uint64_t elapsed_us = replay->last_ack_us > start_us ? replay->last_ack_us - start_us : 1;
+
+  printf("Replayed %zu packets (%zu bytes), %zu acknowledged.\n",
+         replay->num_packets, bytes, replay->num_acked);
+  printf("  trace %.3f s, replay %.3f s\n", trace_us / 1e6, elapsed_us / 1e6);
+  printf("  throughput %.0f packets/s, %.0f bytes/s\n",
+         replay->num_acked * 1e6 / elapsed_us, bytes * 1e6 / elapsed_us);
+
+  uint64_t *latency = malloc(replay->num_packets * sizeof(uint64_t));
+  uint64_t *round_trip = malloc(replay->num_packets * sizeof(uint64_t));
+  size_t count = 0;
+  if (latency && round_trip) {
+    for (size_t i = 0; i < replay->num_packets; ++i) {
+      if (replay->round_trip_us[i] == UINT64_MAX)
+        continue;
+      latency[count] = replay->latency_us[i];
+      round_trip[count] = replay->round_trip_us[i];
+      ++count;
+    }
+    print_latency("stack", latency, count);
+    print_latency("round trip", round_trip, count);
+  }
+  free(round_trip);
+  free(latency);
+}
+
+int hci_replay(int argc, char **argv) {
+  if (argc < 1 || argc > 2) {
+    printf("Usage: replay <btsnoop file> [speed]\n");
+    return 1;
+  }
+
+  double speed = 1.0;
+  if (argc == 2) {
+    char *end;
+    speed = strtod(argv[1], &end);
+    if (*end || speed < 0) {
+      printf("Invalid speed '%s'.\n", argv[1]);
+      return 2;
+    }
+  }
+
+  size_t size = 0;
+  uint8_t *file = read_file(argv[0], &size);
+  if (!file) {
+    printf("Unable to read '%s'.\n", argv[0]);
+    return 3;
+  }
+
+  int ret = 0;
+  record_t *records = NULL;
+  size_t skipped;
+  replay_t replay;
+  memset(&replay, 0, sizeof(replay));
+  replay.sock = INVALID_FD;
+
+  ssize_t num_records = parse_btsnoop(file, size, &records, &skipped);
+  if (num_records < 0) {
+    printf("'%s' is not an H4 btsnoop log.\n", argv[0]);
+    ret = 4;
+    goto done;
+  }
+  if (skipped)
+    printf("Skipping %zu truncated or unsupported packets.\n", skipped);
+  if (num_records == 0) {
+    printf("No controller packets to replay.\n");
+    goto done;
+  }
+
+  replay.num_packets = num_records;
+  replay.sent_us = calloc(num_records, sizeof(uint64_t));
+  replay.latency_us = calloc(num_records, sizeof(uint32_t));
+  replay.round_trip_us = malloc(num_records * sizeof(uint64_t));
+  if (!replay.sent_us || !replay.latency_us || !replay.round_trip_us) {
+    printf("Out of memory.\n");
+    ret = 5;
+    goto done;
+  }
+  memset(replay.round_trip_us, 0xFF, num_records * sizeof(uint64_t));
+
+  replay.sock = connect_to_stack();
+  if (replay.sock == INVALID_FD) {
+    printf("Unable to connect to the stack; is BT_NET_DEBUG enabled?\n");
+    ret = 6;
+    goto done;
+  }
+
+  static uint8_t frame[3 + UINT16_MAX];
+  const uint64_t start_us = now_us();
+  for (ssize_t i = 0; i < num_records; ++i) {
+    const record_t *record = &records[i];
+
+    // Pace the packets as they were captured, scaled by |speed|, and read
+    // acknowledgements while waiting.
+    uint64_t deadline_us = start_us;
+    if (speed > 0)
+      deadline_us += (uint64_t)((record->timestamp_us - records[0].timestamp_us) / speed);
+    if (!read_acks(&replay, deadline_us))
+      goto lost;
+
+    const size_t packet_len = record->length - 1;
+    frame[0] = HCI_INJECT_INBOUND | record->data[0];
+    frame[1] = packet_len;
+    frame[2] = packet_len >> 8;
+    memcpy(frame + 3, record->data + 1, packet_len);
+
+    replay.sent_us[i] = now_us();
+    if (!write_all(replay.sock, frame, 3 + packet_len))
+      goto lost;
+  }
+
+  const uint64_t drain_deadline_us = now_us() + DRAIN_TIMEOUT_US;
+  while (replay.num_acked < replay.num_packets && now_us() < drain_deadline_us) {
+    if (!read_acks(&replay, now_us() + 100 * 1000))
+      goto lost;
+  }
+
+  report(&replay, records, start_us);
+  goto done;
+
+lost:;
+  printf("Lost the connection to the stack.\n");
+  ret = 7;
+
+done:;
+  if (replay.sock != INVALID_FD)
+    close(replay.sock);
+  free(replay.round_trip_us);
+  free(replay.latency_us);
+  free(replay.sent_us);
+  free(records);
+  free(file);
+  return ret;
+}
@@ -0,0 +1,26 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+// Streams the packets a controller sent in a btsnoop log into the stack
+// through the HCI injection port, and reports how quickly the stack took
+// them in. Arguments: <btsnoop file> [speed]. |speed| scales the gaps
+// between the recorded timestamps; 0 sends the packets back to back.
+// Returns 0 on success.
+int hci_replay(int argc, char **argv);
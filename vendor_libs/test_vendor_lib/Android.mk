@@ -7,9 +7,11 @@ include $(CLEAR_VARS)
 BT_DIR := $(TOP_DIR)system/bt
 
 LOCAL_SRC_FILES := \
+    src/acl_packet.cc \
     src/bt_vendor.cc \
     src/command_packet.cc \
     src/dual_mode_controller.cc \
+    src/echo_peer.cc \
     src/event_packet.cc \
     src/hci_transport.cc \
     src/packet.cc \
@@ -47,11 +49,14 @@ ifeq ($(HOST_OS), linux)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES := \
+    src/acl_packet.cc \
     src/command_packet.cc \
+    src/echo_peer.cc \
     src/event_packet.cc \
     src/hci_transport.cc \
     src/packet.cc \
     src/packet_stream.cc \
+    test/echo_peer_unittest.cc \
     test/hci_transport_unittest.cc \
     test/packet_stream_unittest.cc
 
@@ -0,0 +1,72 @@
+//
+// Copyright 2016 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "vendor_libs/test_vendor_lib/include/packet.h"
+
+namespace test_vendor_lib {
+
+// ACL data packet. See the Bluetooth Core Specification Version 4.2, Volume 2,
+// Part E, Section 5.4.2 for the packet format.
+class AclPacket : public Packet {
+ public:
+  AclPacket();
+
+  virtual ~AclPacket() override = default;
+
+  // Creates and returns a packet carrying |payload| on the connection
+  // |handle|. Returns nullptr if |payload| does not fit in a single packet.
+  static std::unique_ptr<AclPacket> CreateAclPacket(
+      uint16_t handle, uint8_t packet_boundary_flag, uint8_t broadcast_flag,
+      const std::vector<uint8_t>& payload);
+
+  // Returns the 12 bit connection handle the packet belongs to.
+  uint16_t GetHandle() const;
+
+  // Returns the 2 bit packet boundary flag:
+  // - 0x00: First non-automatically-flushable packet (host to controller).
+  // - 0x01: Continuing fragment.
+  // - 0x02: First automatically flushable packet.
+  uint8_t GetPacketBoundaryFlag() const;
+
+  // Returns the 2 bit broadcast flag.
+  uint8_t GetBroadcastFlag() const;
+
+  // Size in octets of an ACL packet header, which consists of a 2 octet
+  // handle and flags field and a 2 octet payload size.
+  static const size_t kAclHeaderSize = 4;
+
+  static const uint8_t kFirstNonFlushable = 0x00;
+  static const uint8_t kContinuing = 0x01;
+  static const uint8_t kFirstFlushable = 0x02;
+
+ protected:
+  // Packet overrides:
+  size_t GetPayloadSizeFromHeader(
+      const std::vector<uint8_t>& header) const override;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(AclPacket);
+};
+
+}  // namespace test_vendor_lib
@@ -22,9 +22,13 @@
 #include <vector>
 #include <unordered_map>
 
+#include "base/callback.h"
 #include "base/json/json_value_converter.h"
+#include "base/memory/weak_ptr.h"
 #include "base/time/time.h"
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
+#include "vendor_libs/test_vendor_lib/include/echo_peer.h"
 #include "vendor_libs/test_vendor_lib/include/hci_transport.h"
 #include "vendor_libs/test_vendor_lib/include/test_channel_transport.h"
 
@@ -84,6 +88,39 @@ class DualModeController {
     // Specification Version 4.2, Volume 2, Part E, Section 7.4.1 (page 788).
     const std::vector<uint8_t> GetLocalVersionInformation();
 
+    // Aggregates and returns the result for the LE Read Buffer Size command.
+    // This result consists of the |le_data_packet_length_| and
+    // |num_le_data_packets_| properties. See the Bluetooth Core Specification
+    // Version 4.2, Volume 2, Part E, Section 7.8.2.
+    const std::vector<uint8_t> GetLeBufferSize();
+
+    // Returns the result for the LE Read Local Supported Features command. See
+    // the Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+    // 7.8.3.
+    const std::vector<uint8_t> GetLeLocalSupportedFeatures();
+
+    // Returns the result for the LE Read Supported States command. See the
+    // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+    // 7.8.27.
+    const std::vector<uint8_t> GetLeSupportedStates();
+
+    // Returns the result for the LE Read White List Size command. See the
+    // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+    // 7.8.14.
+    const std::vector<uint8_t> GetLeWhiteListSize();
+
+    // Number of ACL data packets the controller can buffer. LE data shares
+    // these buffers when |num_le_data_packets_| is 0.
+    uint16_t GetNumAclDataPackets() const;
+
+    uint8_t GetNumLeDataPackets() const;
+
+    // Largest ACL data packet payload the controller sends and receives, on
+    // BR/EDR and on LE when |num_le_data_packets_| is not 0.
+    uint16_t GetAclDataPacketSize() const;
+
+    uint16_t GetLeDataPacketLength() const;
+
     static void RegisterJSONConverter(
         base::JSONValueConverter<Properties>* converter);
 
@@ -101,6 +138,9 @@ class DualModeController {
     uint8_t local_supported_commands_size_;
     uint8_t local_name_size_;
     std::vector<uint8_t> bd_address_;
+    uint16_t le_data_packet_length_;
+    uint8_t num_le_data_packets_;
+    uint8_t le_white_list_size_;
   };
 
   // Sets all of the methods to be used as callbacks in the HciHandler.
@@ -113,6 +153,11 @@ class DualModeController {
   // carry out the command.
   void HandleCommand(std::unique_ptr<CommandPacket> command_packet);
 
+  // Accepts an ACL data packet from the host on behalf of the virtual peer of
+  // its connection. The packet is either dropped or looped back to the host,
+  // and its buffer is returned with a Number Of Completed Packets event.
+  void HandleAcl(std::unique_ptr<AclPacket> acl_packet);
+
   // Dispatches the test channel action corresponding to the command specified
   // by |name|.
   void HandleTestChannelCommand(const std::string& name,
@@ -137,6 +182,15 @@ class DualModeController {
       std::function<void(std::unique_ptr<EventPacket>, base::TimeDelta)>
           send_event);
 
+  // Sets the callback to be used for sending ACL data back to the HCI.
+  void RegisterAclChannel(
+      std::function<void(std::unique_ptr<AclPacket>)> send_acl);
+
+  // Sets the callback used to run controller tasks on a delay, such as
+  // generating advertising reports.
+  void RegisterTaskChannel(
+      std::function<void(const base::Closure&, base::TimeDelta)> post_task);
+
   // Controller commands. For error codes, see the Bluetooth Core Specification,
   // Version 4.2, Volume 2, Part D (page 370).
 
@@ -280,6 +334,146 @@ class DualModeController {
   // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.19
   void HciRemoteNameRequest(const std::vector<uint8_t>& args);
 
+  // OGF: 0x0001
+  // OCF: 0x0005
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.5
+  void HciCreateConnection(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0006
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.6
+  void HciDisconnect(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x001D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.23
+  void HciReadRemoteVersionInformation(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x000F
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.14
+  void HciChangeConnectionPacketType(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x001B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.21
+  void HciReadRemoteSupportedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x0003
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.2
+  void HciSniffMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x0004
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.3
+  void HciExitSniffMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x000D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.10
+  void HciWriteLinkPolicySettings(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0003
+  // OCF: 0x0037
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.3.42
+  void HciWriteLinkSupervisionTimeout(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0001
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.1
+  void HciLeSetEventMask(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0002
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.2
+  void HciLeReadBufferSize(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0003
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.3
+  void HciLeReadLocalSupportedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0005
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.4
+  void HciLeSetRandomAddress(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0006
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.5
+  void HciLeSetAdvertisingParameters(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0007
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.6
+  void HciLeReadAdvertisingChannelTxPower(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0008
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.7
+  void HciLeSetAdvertisingData(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0009
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.8
+  void HciLeSetScanResponseData(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000A
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.9
+  void HciLeSetAdvertiseEnable(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.10
+  void HciLeSetScanParameters(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.11
+  void HciLeSetScanEnable(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.12
+  void HciLeCreateConnection(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000E
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.13
+  void HciLeCreateConnectionCancel(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000F
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.14
+  void HciLeReadWhiteListSize(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0010
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.15
+  void HciLeClearWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0011
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.16
+  void HciLeAddDeviceToWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0012
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.17
+  void HciLeRemoveDeviceFromWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0016
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.21
+  void HciLeReadRemoteUsedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x001C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.27
+  void HciLeReadSupportedStates(const std::vector<uint8_t>& args);
+
   // Test Channel commands:
 
   // Clears all test channel modifications.
@@ -297,6 +491,27 @@ class DualModeController {
   // Causes all future HCI commands to timeout.
   void TestChannelTimeoutAll(const std::vector<std::string>& args);
 
+  // Selects what the virtual peers do with ACL data from the host: "sink"
+  // drops it (default), "loopback" sends it back on the same connection, and
+  // "echo" accepts RFCOMM and LE credit based channels and echoes the data sent
+  // on them.
+  void TestChannelSetAclMode(const std::vector<std::string>& args);
+
+  // Arguments: batch [delay_in_ms]
+  // Reports completed ACL packets once |batch| of them are outstanding (or the
+  // host has no buffers left), |delay_in_ms| after the last one was received.
+  void TestChannelSetCompletedPackets(const std::vector<std::string>& args);
+
+  // Arguments: reports_per_second num_addresses [data_length ...]
+  // Generates LE advertising reports while the host is scanning, cycling
+  // through |num_addresses| advertisers and the given advertising data
+  // lengths (0-31 octets).
+  void TestChannelStartAdvertisingReports(
+      const std::vector<std::string>& args);
+
+  // Stops generating LE advertising reports.
+  void TestChannelStopAdvertisingReports(const std::vector<std::string>& args);
+
  private:
   // Current link layer state of the controller.
   enum State {
@@ -310,6 +525,25 @@ class DualModeController {
     kDelayedResponse,  // Event responses are sent after a delay.
   };
 
+  // What the virtual peer of a connection does with ACL data from the host.
+  enum AclMode {
+    kAclSink,  // Data is consumed by the peer.
+    kAclLoopback,  // Data is sent back to the host on the same connection.
+    kAclEcho,  // Data on L2CAP channels is echoed by an EchoPeer.
+  };
+
+  // A connection to a virtual peer.
+  struct Connection {
+    bool is_le;
+    std::vector<uint8_t> address;
+    // Packets transmitted to the peer that have not been reported to the host
+    // in a Number Of Completed Packets event yet.
+    uint16_t completed_packets;
+    // The peer's L2CAP side in the echo ACL mode, created with the first
+    // packet.
+    std::unique_ptr<EchoPeer> echo_peer;
+  };
+
   // Creates a command complete event and sends it back to the HCI.
   void SendCommandComplete(uint16_t command_opcode,
                            const std::vector<uint8_t>& return_parameters) const;
@@ -333,12 +567,34 @@ class DualModeController {
 
   void SetEventDelay(int64_t delay);
 
+  // Adds a connection to a virtual peer at |address| and returns its handle.
+  uint16_t AddConnection(bool is_le, const std::vector<uint8_t>& address);
+
+  // Reports the completed packets of all connections to the host.
+  void SendNumberOfCompletedPackets();
+
+  // Generates the advertising reports that are due since the last tick and
+  // schedules the next tick.
+  void LeAdvertisingReportTick();
+
+  void ScheduleLeAdvertisingReportTick();
+
+  // Appends the advertising report numbered |report| to |reports|, followed by
+  // a scan response when the host scans actively. Returns the number of
+  // reports appended.
+  uint8_t AppendLeAdvertisingReports(uint64_t report,
+                                     std::vector<uint8_t>* reports) const;
+
   // Callback provided to send events from the controller back to the HCI.
   std::function<void(std::unique_ptr<EventPacket>)> send_event_;
 
   std::function<void(std::unique_ptr<EventPacket>, base::TimeDelta)>
       send_delayed_event_;
 
+  std::function<void(std::unique_ptr<AclPacket>)> send_acl_;
+
+  std::function<void(const base::Closure&, base::TimeDelta)> post_task_;
+
   // Maintains the commands to be registered and used in the HciHandler object.
   // Keys are command opcodes and values are the callbacks to handle each
   // command.
@@ -363,6 +619,40 @@ class DualModeController {
 
   TestChannelState test_channel_state_;
 
+  // Connections to virtual peers, keyed by connection handle.
+  std::unordered_map<uint16_t, Connection> connections_;
+
+  uint16_t next_connection_handle_;
+
+  AclMode acl_mode_;
+
+  // Packets in the BR/EDR and LE controller buffers that have been transmitted
+  // but not yet reported to the host.
+  uint16_t unreported_acl_packets_;
+  uint16_t unreported_le_packets_;
+
+  // Number Of Completed Packets pacing set through the test channel.
+  uint16_t completed_packets_batch_;
+  base::TimeDelta completed_packets_delay_;
+
+  // LE scan state set by the host.
+  bool le_scan_enabled_;
+  uint8_t le_scan_type_;
+
+  // Advertising report generator state set through the test channel. A rate of
+  // 0 disables the generator.
+  uint32_t le_advertising_report_rate_;
+  uint32_t le_advertising_num_addresses_;
+  std::vector<uint8_t> le_advertising_data_lengths_;
+  uint64_t le_advertising_next_report_;
+  double le_advertising_reports_due_;
+  base::TimeTicks le_advertising_last_tick_;
+  bool le_advertising_tick_pending_;
+
+  // This should remain the last member so it'll be destroyed and invalidate
+  // its weak pointers before any other members are destroyed.
+  base::WeakPtrFactory<DualModeController> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(DualModeController);
 };
 
@@ -0,0 +1,129 @@
+//
+// Copyright 2016 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace test_vendor_lib {
+
+// The virtual peer of one connection in the echo ACL mode. It is just enough
+// of an L2CAP and RFCOMM implementation for the host to open channels to it,
+// and sends back whatever the host sends on them:
+// - On BR/EDR, it accepts channels to the RFCOMM PSM only and runs an RFCOMM
+//   multiplexer on them that echoes the data of every DLC, with credit based
+//   flow control. See the RFCOMM specification version 1.2 and 3GPP TS 07.10.
+// - On LE, it accepts LE credit based connections to any PSM and echoes every
+//   SDU. See the Bluetooth Core Specification Version 4.2, Volume 3, Part A,
+//   Section 3.4.
+// Data is only sent back as the host hands out credits for it, and credits
+// are only returned to the host once what they were spent on has been echoed,
+// so a host that stops reading eventually stops being able to send.
+class EchoPeer {
+ public:
+  // |send_acl| is called with the packet boundary flag and payload of every
+  // ACL data packet for the host. L2CAP frames are fragmented into packets of
+  // at most |max_acl_payload| octets.
+  EchoPeer(bool is_le, size_t max_acl_payload,
+           std::function<void(uint8_t, const std::vector<uint8_t>&)> send_acl);
+
+  ~EchoPeer() = default;
+
+  // Takes the packet boundary flag and payload of an ACL data packet from the
+  // host, and answers every L2CAP frame it completes.
+  void ReceiveAcl(uint8_t packet_boundary_flag,
+                  const std::vector<uint8_t>& payload);
+
+ private:
+  // A DLC opened by the host on an RFCOMM multiplexer.
+  struct Dlc {
+    // Frames the host allows the peer to send.
+    uint16_t tx_credits;
+    // Whether the peer has sent its own modem status command.
+    bool msc_sent;
+    // Information fields waiting for credits to be echoed.
+    std::deque<std::vector<uint8_t>> echoes;
+  };
+
+  // One L2CAP channel opened by the host, keyed by its peer side CID.
+  struct Channel {
+    uint16_t host_cid;
+    // LE: the largest SDU and K-frame payload the host takes, and the
+    // K-frames it allows the peer to send.
+    uint16_t host_mtu;
+    uint16_t host_mps;
+    uint16_t tx_credits;
+    // LE: the SDU being received, its length, and the K-frames it took.
+    std::vector<uint8_t> sdu;
+    uint16_t sdu_length;
+    uint16_t sdu_frames;
+    // LE: K-frames waiting for credits, each with the credits to return to
+    // the host once it has been sent.
+    std::deque<std::pair<std::vector<uint8_t>, uint16_t>> k_frames;
+    // BR/EDR: the RFCOMM DLCs, keyed by DLCI.
+    std::map<uint8_t, Dlc> dlcs;
+  };
+
+  // Answers a complete L2CAP frame from the host.
+  void ReceiveFrame(const std::vector<uint8_t>& frame);
+
+  // Sends an L2CAP frame on |cid| to the host.
+  void SendFrame(uint16_t cid, const std::vector<uint8_t>& payload);
+
+  // Sends a signaling command on the signaling channel of the link.
+  void SendSignal(uint8_t code, uint8_t id, const std::vector<uint8_t>& data);
+
+  // Answers the signaling command |code| of |length| octets at |data|.
+  void HandleSignal(uint8_t code, uint8_t id, const uint8_t* data,
+                    uint16_t length);
+
+  // LE credit based connection data.
+  void HandleLeFrame(Channel* channel, uint16_t peer_cid, const uint8_t* data,
+                     size_t length);
+  void SendLeFrames(Channel* channel, uint16_t peer_cid);
+
+  // RFCOMM multiplexer.
+  void HandleRfcommFrame(Channel* channel, const uint8_t* data, size_t length);
+  void HandleRfcommControl(Channel* channel, const std::vector<uint8_t>& info);
+  void SendRfcommFrame(const Channel& channel, uint8_t dlci, uint8_t type,
+                       bool command, const std::vector<uint8_t>& info,
+                       uint8_t credits);
+  void SendRfcommControl(const Channel& channel, uint8_t type, bool command,
+                         const std::vector<uint8_t>& value);
+  void SendRfcommEchoes(Channel* channel, uint8_t dlci);
+
+  const bool is_le_;
+  const size_t max_acl_payload_;
+  std::function<void(uint8_t, const std::vector<uint8_t>&)> send_acl_;
+
+  // The L2CAP frame being reassembled from ACL data packets.
+  std::vector<uint8_t> rx_frame_;
+
+  std::map<uint16_t, Channel> channels_;
+  uint16_t next_peer_cid_;
+  uint8_t next_signal_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(EchoPeer);
+};
+
+}  // namespace test_vendor_lib
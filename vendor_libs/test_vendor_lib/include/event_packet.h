@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "base/logging.h"
@@ -148,6 +150,134 @@ class EventPacket : public Packet {
       const std::vector<uint8_t>& rssi,
       const std::vector<uint8_t>& extended_inquiry_response);
 
+  // Creates and returns a connection complete event packet. See the Bluetooth
+  // Core Specification Version 4.2, Volume 2, Part E, Section 7.7.3.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   BD_ADDR (6 octets)
+  //   Link Type (1 octet)
+  //     0x01: ACL connection.
+  //   Encryption Enabled (1 octet)
+  static std::unique_ptr<EventPacket> CreateConnectionCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& bd_address,
+      uint8_t link_type, uint8_t encryption_enabled);
+
+  // Creates and returns a disconnection complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.5.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   Reason (1 octet)
+  static std::unique_ptr<EventPacket> CreateDisconnectionCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t reason);
+
+  // Creates and returns a remote name request complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.7.
+  // |name| is padded with zeros to 248 octets.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   BD_ADDR (6 octets)
+  //   Remote Name (248 octets)
+  static std::unique_ptr<EventPacket> CreateRemoteNameRequestCompleteEvent(
+      uint8_t status, const std::vector<uint8_t>& bd_address,
+      const std::string& name);
+
+  // Creates and returns a read remote supported features complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part E,
+  // Section 7.7.11.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   LMP Features (8 octets)
+  static std::unique_ptr<EventPacket>
+  CreateReadRemoteSupportedFeaturesCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& features);
+
+  // Creates and returns a read remote version information complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part E,
+  // Section 7.7.12.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   Version (1 octet)
+  //   Manufacturer Name (2 octets)
+  //   Subversion (2 octets)
+  static std::unique_ptr<EventPacket>
+  CreateReadRemoteVersionInformationCompleteEvent(uint8_t status,
+                                                  uint16_t handle,
+                                                  uint8_t version,
+                                                  uint16_t manufacturer_name,
+                                                  uint16_t subversion);
+
+  // Creates and returns a mode change event packet. See the Bluetooth Core
+  // Specification Version 4.2, Volume 2, Part E, Section 7.7.20.
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   Current Mode (1 octet)
+  //     0x00: Active Mode.
+  //     0x02: Sniff Mode.
+  //   Interval (2 octets)
+  static std::unique_ptr<EventPacket> CreateModeChangeEvent(uint8_t status,
+                                                            uint16_t handle,
+                                                            uint8_t mode,
+                                                            uint16_t interval);
+
+  // Creates and returns a number of completed packets event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.19. |handles_and_counts| holds one (handle, number of completed
+  // packets) pair per connection, at most 63 pairs.
+  static std::unique_ptr<EventPacket> CreateNumberOfCompletedPacketsEvent(
+      const std::vector<std::pair<uint16_t, uint16_t>>& handles_and_counts);
+
+  // Creates and returns an LE connection complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.65.1.
+  // Event Parameters:
+  //   Subevent Code (1 octet)
+  //     0x01: LE Connection Complete.
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   Role (1 octet)
+  //     0x00: Master.
+  //     0x01: Slave.
+  //   Peer Address Type (1 octet)
+  //   Peer Address (6 octets)
+  //   Connection Interval (2 octets)
+  //   Connection Latency (2 octets)
+  //   Supervision Timeout (2 octets)
+  //   Master Clock Accuracy (1 octet)
+  static std::unique_ptr<EventPacket> CreateLeConnectionCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t role, uint8_t peer_address_type,
+      const std::vector<uint8_t>& peer_address, uint16_t interval,
+      uint16_t latency, uint16_t supervision_timeout);
+
+  // Creates and returns an LE read remote used features complete event packet.
+  // See the Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+  // 7.7.65.4.
+  // Event Parameters:
+  //   Subevent Code (1 octet)
+  //     0x04: LE Read Remote Used Features Complete.
+  //   Status (1 octet)
+  //   Connection Handle (2 octets)
+  //   LE Features (8 octets)
+  static std::unique_ptr<EventPacket>
+  CreateLeReadRemoteUsedFeaturesCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& features);
+
+  // Creates and returns an LE advertising report event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+  // 7.7.65.2. |reports| holds the already encoded reports, each made
+  // of Event Type (1 octet), Address Type (1 octet), Address (6 octets), Length
+  // (1 octet), Data (Length octets) and RSSI (1 octet), in the order the host
+  // parses them.
+  // Event Parameters:
+  //   Subevent Code (1 octet)
+  //     0x02: LE Advertising Report.
+  //   Num Reports (1 octet)
+  //     0x01-0x19: Number of reports in the event.
+  static std::unique_ptr<EventPacket> CreateLeAdvertisingReportEvent(
+      uint8_t num_reports, const std::vector<uint8_t>& reports);
+
   // Size in octets of a data packet header, which consists of a 1 octet
   // event code and a 1 octet payload size.
   static const size_t kEventHeaderSize = 2;
@@ -28,6 +28,7 @@ extern "C" {
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/time/time.h"
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 #include "vendor_libs/test_vendor_lib/include/packet.h"
@@ -60,6 +61,10 @@ class HciTransport : public base::MessageLoopForIO::Watcher {
   void RegisterCommandHandler(
       std::function<void(std::unique_ptr<CommandPacket>)> callback);
 
+  // Sets the callback that is run when ACL data packets are received.
+  void RegisterAclHandler(
+      std::function<void(std::unique_ptr<AclPacket>)> callback);
+
   // Posts the event onto |outbound_events_| to be written sometime in the
   // future when the vendor file descriptor is ready for writing.
   void PostEventResponse(std::unique_ptr<EventPacket> event);
@@ -69,27 +74,31 @@ class HciTransport : public base::MessageLoopForIO::Watcher {
   void PostDelayedEventResponse(std::unique_ptr<EventPacket> event,
                                 base::TimeDelta delay);
 
+  // Posts the ACL data packet onto |outbound_packets_| to be written when the
+  // vendor file descriptor is ready for writing.
+  void PostAclData(std::unique_ptr<AclPacket> acl);
+
  private:
-  // Wrapper class for sending events on a delay. The TimeStampedEvent object
-  // takes ownership of a given event packet.
-  class TimeStampedEvent {
+  // Wrapper class for sending packets on a delay. The TimeStampedPacket object
+  // takes ownership of a given event or data packet.
+  class TimeStampedPacket {
    public:
-    TimeStampedEvent(std::unique_ptr<EventPacket> event, base::TimeDelta delay);
+    TimeStampedPacket(std::unique_ptr<Packet> packet, base::TimeDelta delay);
 
     // Using this constructor is equivalent to calling the 2-argument
     // constructor with a |delay| of 0. It is used to generate event responses
-    // with no delay.
-    TimeStampedEvent(std::unique_ptr<EventPacket> event);
+    // and data with no delay.
+    TimeStampedPacket(std::unique_ptr<Packet> packet);
 
     const base::TimeTicks& GetTimeStamp() const;
 
-    const EventPacket& GetEvent();
+    const Packet& GetPacket();
 
    private:
-    std::shared_ptr<EventPacket> event_;
+    std::shared_ptr<Packet> packet_;
 
-    // The time associated with the event, indicating the earliest time at which
-    // |event_| will be sent.
+    // The time associated with the packet, indicating the earliest time at
+    // which |packet_| will be sent.
     base::TimeTicks time_stamp_;
   };
 
@@ -102,17 +111,25 @@ class HciTransport : public base::MessageLoopForIO::Watcher {
   // |command_handler_|, passing ownership of the command packet to the handler.
   void ReceiveReadyCommand() const;
 
-  void AddEventToOutboundEvents(std::unique_ptr<TimeStampedEvent> event);
+  // Reads in an ACL data packet and calls |acl_handler_|, passing ownership of
+  // the packet to the handler.
+  void ReceiveReadyAcl() const;
 
-  // Write queue for sending events to the HCI. Event packets are removed from
-  // the queue and written when write-readiness is signalled by the message
-  // loop. After being written, the event packets are destructed.
-  std::list<std::unique_ptr<TimeStampedEvent>> outbound_events_;
+  void AddPacketToOutboundPackets(std::unique_ptr<TimeStampedPacket> packet);
+
+  // Write queue for sending events and data to the HCI. Packets are removed
+  // from the queue and written when write-readiness is signalled by the message
+  // loop. After being written, the packets are destructed.
+  std::list<std::unique_ptr<TimeStampedPacket>> outbound_packets_;
 
   // Callback executed in ReceiveReadyCommand() to pass the incoming command
   // over to the handler for further processing.
   std::function<void(std::unique_ptr<CommandPacket>)> command_handler_;
 
+  // Callback executed in ReceiveReadyAcl() to pass incoming ACL data over to
+  // the handler for further processing.
+  std::function<void(std::unique_ptr<AclPacket>)> acl_handler_;
+
   // For performing packet-based IO.
   PacketStream packet_stream_;
 
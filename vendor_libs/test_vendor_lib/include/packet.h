@@ -38,7 +38,7 @@ class Packet {
 
   const std::vector<uint8_t>& GetPayload() const;
 
-  uint8_t GetPayloadSize() const;
+  size_t GetPayloadSize() const;
 
   const std::vector<uint8_t>& GetHeader() const;
 
@@ -61,6 +61,11 @@ class Packet {
   // to check and fill in the packet's data.
   Packet(serial_data_type_t type);
 
+  // Returns the payload size encoded in |header|. Command and event headers end
+  // with a one octet size; packets with a wider size field override this.
+  virtual size_t GetPayloadSizeFromHeader(
+      const std::vector<uint8_t>& header) const;
+
  private:
   // Underlying containers for storing the actual packet, broken down into the
   // packet header and the packet payload. Data is copied into the vectors
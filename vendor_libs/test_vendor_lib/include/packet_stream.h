@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 #include "vendor_libs/test_vendor_lib/include/packet.h"
@@ -39,6 +40,11 @@ class PacketStream {
   // packet.
   std::unique_ptr<CommandPacket> ReceiveCommand(int fd) const;
 
+  // Reads an ACL data packet from the file descriptor at |fd| and returns the
+  // packet back to the caller, along with the responsibility of managing the
+  // packet.
+  std::unique_ptr<AclPacket> ReceiveAcl(int fd) const;
+
   // Reads a single octet from |fd| and interprets it as a packet type octet.
   // Validates the type octet for correctness.
   serial_data_type_t ReceivePacketType(int fd) const;
@@ -47,6 +53,14 @@ class PacketStream {
   // with the caller.
   bool SendEvent(const EventPacket& event, int fd) const;
 
+  // Sends an ACL data packet to file descriptor |fd|. The ownership of the
+  // packet is left with the caller.
+  bool SendAcl(const AclPacket& acl, int fd) const;
+
+  // Sends the type octet, header and payload of |packet| to |fd| in a single
+  // write. The ownership of the packet is left with the caller.
+  bool SendPacket(const Packet& packet, int fd) const;
+
  private:
   // Checks if |type| is in the valid range from DATA_TYPE_COMMAND to
   // DATA_TYPE_SCO.
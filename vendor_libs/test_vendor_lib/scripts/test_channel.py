@@ -206,6 +206,38 @@ class TestChannelShell(cmd.Cmd):
     """
     self._test_channel.send_command('SET_EVENT_DELAY', args.split())
 
+  def do_set_acl_mode(self, args):
+    """
+    Arguments: sink | loopback | echo
+    Sets what the controller's virtual peers do with ACL data from the HCI:
+    drop it (default), send it back on the same connection, or accept RFCOMM
+    and LE credit based channels and echo the data sent on them.
+    """
+    self._test_channel.send_command('SET_ACL_MODE', args.split())
+
+  def do_set_completed_packets(self, args):
+    """
+    Arguments: batch [delay_in_ms]
+    Reports completed ACL packets to the HCI once batch packets are
+    outstanding, delay_in_ms after the last one was received.
+    """
+    self._test_channel.send_command('SET_COMPLETED_PACKETS', args.split())
+
+  def do_start_advertising_reports(self, args):
+    """
+    Arguments: reports_per_second num_addresses [data_length ...]
+    Generates LE advertising reports while the HCI is scanning, cycling through
+    num_addresses advertisers and the given advertising data lengths (0-31).
+    """
+    self._test_channel.send_command('START_ADVERTISING_REPORTS', args.split())
+
+  def do_stop_advertising_reports(self, args):
+    """
+    Arguments: None.
+    Stops generating LE advertising reports.
+    """
+    self._test_channel.send_command('STOP_ADVERTISING_REPORTS', [])
+
   def do_timeout_all(self, args):
     """
     Arguments: None.
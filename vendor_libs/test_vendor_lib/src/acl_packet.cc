@@ -0,0 +1,75 @@
+//
+// Copyright 2016 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define LOG_TAG "acl_packet"
+
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
+
+extern "C" {
+#include "hci/include/hci_hal.h"
+#include "osi/include/log.h"
+}  // extern "C"
+
+namespace test_vendor_lib {
+
+const size_t AclPacket::kAclHeaderSize;
+const uint8_t AclPacket::kFirstNonFlushable;
+const uint8_t AclPacket::kContinuing;
+const uint8_t AclPacket::kFirstFlushable;
+
+AclPacket::AclPacket() : Packet(DATA_TYPE_ACL) {}
+
+// static
+std::unique_ptr<AclPacket> AclPacket::CreateAclPacket(
+    uint16_t handle, uint8_t packet_boundary_flag, uint8_t broadcast_flag,
+    const std::vector<uint8_t>& payload) {
+  if (payload.size() > 0xFFFF) {
+    LOG_ERROR(LOG_TAG, "ACL payload of %zu octets does not fit in a packet.",
+              payload.size());
+    return nullptr;
+  }
+
+  const uint16_t handle_and_flags = (handle & 0x0FFF) |
+                                    ((packet_boundary_flag & 0x03) << 12) |
+                                    ((broadcast_flag & 0x03) << 14);
+  std::unique_ptr<AclPacket> acl(new AclPacket());
+  acl->Encode({static_cast<uint8_t>(handle_and_flags),
+               static_cast<uint8_t>(handle_and_flags >> 8),
+               static_cast<uint8_t>(payload.size()),
+               static_cast<uint8_t>(payload.size() >> 8)},
+              payload);
+  return acl;
+}
+
+uint16_t AclPacket::GetHandle() const {
+  return (GetHeader()[0] | (GetHeader()[1] << 8)) & 0x0FFF;
+}
+
+uint8_t AclPacket::GetPacketBoundaryFlag() const {
+  return (GetHeader()[1] >> 4) & 0x03;
+}
+
+uint8_t AclPacket::GetBroadcastFlag() const {
+  return (GetHeader()[1] >> 6) & 0x03;
+}
+
+size_t AclPacket::GetPayloadSizeFromHeader(
+    const std::vector<uint8_t>& header) const {
+  return header[2] | (header[3] << 8);
+}
+
+}  // namespace test_vendor_lib
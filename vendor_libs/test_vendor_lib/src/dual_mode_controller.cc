@@ -18,6 +18,9 @@
 
 #include "vendor_libs/test_vendor_lib/include/dual_mode_controller.h"
 
+#include <algorithm>
+
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/files/file_util.h"
 #include "base/json/json_reader.h"
@@ -59,6 +62,48 @@ const std::vector<uint8_t> kPageScanMode = {0};
 const std::vector<uint8_t> kClassOfDevice = {1, 2, 3};
 const std::vector<uint8_t> kClockOffset = {1, 2};
 
+// Connection handles are 12 bits wide.
+const uint16_t kMaxConnectionHandle = 0x0EFF;
+
+const uint8_t kAclLinkType = 0x01;
+
+// LMP features of BR/EDR virtual peers: everything but LE, Secure Simple
+// Pairing, sniff subrating and extended features, so the host reads no more
+// feature pages and pairs no differently than with a legacy device.
+const std::vector<uint8_t> kPeerLmpFeatures = {0xFF, 0xFF, 0xFF, 0xFF,
+                                               0x9F, 0xFD, 0xF5, 0x7F};
+const uint8_t kLeMasterRole = 0x00;
+
+// LE advertising report event types and the address type used for the
+// generated advertisers.
+const uint8_t kLeAdvInd = 0x00;
+const uint8_t kLeAdvScanInd = 0x02;
+const uint8_t kLeAdvNonconnInd = 0x03;
+const uint8_t kLeScanRsp = 0x04;
+const uint8_t kLeRandomAddressType = 0x01;
+const uint8_t kLeActiveScan = 0x01;
+
+// Advertisers cycle through these event types; the scannable ones are followed
+// by a scan response when the host scans actively.
+const uint8_t kLeAdvertisingEventTypes[] = {kLeAdvInd, kLeAdvScanInd,
+                                            kLeAdvNonconnInd};
+
+const uint8_t kLeMaxAdvertisingDataLength = 31;
+
+// Reports are batched into events of at most 0x19 reports whose parameters
+// (including subevent code and number of reports) fit in 255 octets.
+const uint8_t kLeMaxReportsPerEvent = 0x19;
+const size_t kLeMaxReportOctetsPerEvent = 255 - 2;
+
+// Advertising reports are generated in batches every 10 ms.
+const int64_t kLeAdvertisingReportTickMs = 10;
+
+// Caps the burst sent after the controller thread was held up.
+const uint32_t kLeMaxAdvertisingReportsPerTick = 1000;
+
+// Number Of Completed Packets events carry at most this many handles.
+const size_t kMaxCompletedPacketsHandles = 63;
+
 void LogCommand(const char* command) {
   LOG_INFO(LOG_TAG, "Controller performing command: %s", command);
 }
@@ -82,6 +127,33 @@ bool ParseUint8tVector(const base::StringPiece& value,
   return true;
 }
 
+// Returns the random static address of generated advertiser |index|.
+std::vector<uint8_t> LeAdvertiserAddress(uint32_t index) {
+  return {static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8),
+          static_cast<uint8_t>(index >> 16), 0x5A, 0xDB, 0xC0};
+}
+
+// Appends |length| octets of well formed advertising data for advertiser
+// |index|: a flags structure followed by manufacturer specific data.
+void AppendLeAdvertisingData(uint32_t index, uint8_t length,
+                             std::vector<uint8_t>* data) {
+  uint8_t remaining = length;
+  if (remaining >= 3) {
+    // LE General Discoverable, BR/EDR not supported.
+    data->insert(data->end(), {0x02, 0x01, 0x06});
+    remaining -= 3;
+  }
+  if (remaining >= 2) {
+    data->push_back(remaining - 1);
+    data->push_back(0xFF);
+    for (uint8_t i = 0; i < remaining - 2; ++i)
+      data->push_back(static_cast<uint8_t>(index >> (8 * (i % 4))));
+  } else if (remaining == 1) {
+    // A zero length structure ends the data early.
+    data->push_back(0x00);
+  }
+}
+
 }  // namespace
 
 namespace test_vendor_lib {
@@ -141,8 +213,21 @@ void DualModeController::SendExtendedInquiryResult(
 
 DualModeController::DualModeController()
     : state_(kStandby),
+      properties_(kControllerPropertiesFile),
       test_channel_state_(kNone),
-      properties_(kControllerPropertiesFile) {
+      next_connection_handle_(0),
+      acl_mode_(kAclSink),
+      unreported_acl_packets_(0),
+      unreported_le_packets_(0),
+      completed_packets_batch_(1),
+      le_scan_enabled_(false),
+      le_scan_type_(0),
+      le_advertising_report_rate_(0),
+      le_advertising_num_addresses_(0),
+      le_advertising_next_report_(0),
+      le_advertising_reports_due_(0),
+      le_advertising_tick_pending_(false),
+      weak_ptr_factory_(this) {
 #define SET_HANDLER(opcode, method) \
   active_hci_commands_[opcode] =    \
       std::bind(&DualModeController::method, this, std::placeholders::_1);
@@ -174,6 +259,35 @@ DualModeController::DualModeController()
   SET_HANDLER(HCI_INQUIRY_CANCEL, HciInquiryCancel);
   SET_HANDLER(HCI_DELETE_STORED_LINK_KEY, HciDeleteStoredLinkKey);
   SET_HANDLER(HCI_RMT_NAME_REQUEST, HciRemoteNameRequest);
+  SET_HANDLER(HCI_CREATE_CONNECTION, HciCreateConnection);
+  SET_HANDLER(HCI_DISCONNECT, HciDisconnect);
+  SET_HANDLER(HCI_READ_RMT_VERSION_INFO, HciReadRemoteVersionInformation);
+  SET_HANDLER(HCI_CHANGE_CONN_PACKET_TYPE, HciChangeConnectionPacketType);
+  SET_HANDLER(HCI_READ_RMT_FEATURES, HciReadRemoteSupportedFeatures);
+  SET_HANDLER(HCI_SNIFF_MODE, HciSniffMode);
+  SET_HANDLER(HCI_EXIT_SNIFF_MODE, HciExitSniffMode);
+  SET_HANDLER(HCI_WRITE_POLICY_SETTINGS, HciWriteLinkPolicySettings);
+  SET_HANDLER(HCI_WRITE_LINK_SUPER_TOUT, HciWriteLinkSupervisionTimeout);
+  SET_HANDLER(HCI_BLE_SET_EVENT_MASK, HciLeSetEventMask);
+  SET_HANDLER(HCI_BLE_READ_BUFFER_SIZE, HciLeReadBufferSize);
+  SET_HANDLER(HCI_BLE_READ_LOCAL_SPT_FEAT, HciLeReadLocalSupportedFeatures);
+  SET_HANDLER(HCI_BLE_WRITE_RANDOM_ADDR, HciLeSetRandomAddress);
+  SET_HANDLER(HCI_BLE_WRITE_ADV_PARAMS, HciLeSetAdvertisingParameters);
+  SET_HANDLER(HCI_BLE_READ_ADV_CHNL_TX_POWER,
+              HciLeReadAdvertisingChannelTxPower);
+  SET_HANDLER(HCI_BLE_WRITE_ADV_DATA, HciLeSetAdvertisingData);
+  SET_HANDLER(HCI_BLE_WRITE_SCAN_RSP_DATA, HciLeSetScanResponseData);
+  SET_HANDLER(HCI_BLE_WRITE_ADV_ENABLE, HciLeSetAdvertiseEnable);
+  SET_HANDLER(HCI_BLE_WRITE_SCAN_PARAMS, HciLeSetScanParameters);
+  SET_HANDLER(HCI_BLE_WRITE_SCAN_ENABLE, HciLeSetScanEnable);
+  SET_HANDLER(HCI_BLE_CREATE_LL_CONN, HciLeCreateConnection);
+  SET_HANDLER(HCI_BLE_CREATE_CONN_CANCEL, HciLeCreateConnectionCancel);
+  SET_HANDLER(HCI_BLE_READ_WHITE_LIST_SIZE, HciLeReadWhiteListSize);
+  SET_HANDLER(HCI_BLE_CLEAR_WHITE_LIST, HciLeClearWhiteList);
+  SET_HANDLER(HCI_BLE_ADD_WHITE_LIST, HciLeAddDeviceToWhiteList);
+  SET_HANDLER(HCI_BLE_REMOVE_WHITE_LIST, HciLeRemoveDeviceFromWhiteList);
+  SET_HANDLER(HCI_BLE_READ_REMOTE_FEAT, HciLeReadRemoteUsedFeatures);
+  SET_HANDLER(HCI_BLE_READ_SUPPORTED_STATES, HciLeReadSupportedStates);
 #undef SET_HANDLER
 
 #define SET_TEST_HANDLER(command_name, method)  \
@@ -184,6 +298,12 @@ DualModeController::DualModeController()
   SET_TEST_HANDLER("DISCOVER", TestChannelDiscover);
   SET_TEST_HANDLER("SET_EVENT_DELAY", TestChannelSetEventDelay);
   SET_TEST_HANDLER("TIMEOUT_ALL", TestChannelTimeoutAll);
+  SET_TEST_HANDLER("SET_ACL_MODE", TestChannelSetAclMode);
+  SET_TEST_HANDLER("SET_COMPLETED_PACKETS", TestChannelSetCompletedPackets);
+  SET_TEST_HANDLER("START_ADVERTISING_REPORTS",
+                   TestChannelStartAdvertisingReports);
+  SET_TEST_HANDLER("STOP_ADVERTISING_REPORTS",
+                   TestChannelStopAdvertisingReports);
 #undef SET_TEST_HANDLER
 }
 
@@ -191,6 +311,8 @@ void DualModeController::RegisterHandlersWithHciTransport(
     HciTransport& transport) {
   transport.RegisterCommandHandler(std::bind(&DualModeController::HandleCommand,
                                              this, std::placeholders::_1));
+  transport.RegisterAclHandler(std::bind(&DualModeController::HandleAcl, this,
+                                         std::placeholders::_1));
 }
 
 void DualModeController::RegisterHandlersWithTestChannelTransport(
@@ -222,6 +344,176 @@ void DualModeController::HandleCommand(
   active_hci_commands_[opcode](command_packet->GetPayload());
 }
 
+void DualModeController::HandleAcl(std::unique_ptr<AclPacket> acl_packet) {
+  auto connection = connections_.find(acl_packet->GetHandle());
+  if (connection == connections_.end()) {
+    LOG_INFO(LOG_TAG, "Dropping ACL data for unknown handle 0x%04X.",
+             acl_packet->GetHandle());
+    return;
+  }
+
+  if (acl_mode_ == kAclLoopback && send_acl_) {
+    // Host to controller only flag, the peer's data is automatically flushable.
+    uint8_t packet_boundary_flag = acl_packet->GetPacketBoundaryFlag();
+    if (packet_boundary_flag == AclPacket::kFirstNonFlushable)
+      packet_boundary_flag = AclPacket::kFirstFlushable;
+    std::unique_ptr<AclPacket> loopback = AclPacket::CreateAclPacket(
+        acl_packet->GetHandle(), packet_boundary_flag, 0,
+        acl_packet->GetPayload());
+    if (loopback)
+      send_acl_(std::move(loopback));
+  } else if (acl_mode_ == kAclEcho && send_acl_) {
+    Connection& peer = connection->second;
+    if (!peer.echo_peer) {
+      const bool le_buffers =
+          peer.is_le && properties_.GetNumLeDataPackets() != 0;
+      const uint16_t handle = connection->first;
+      peer.echo_peer.reset(new EchoPeer(
+          peer.is_le, le_buffers ? properties_.GetLeDataPacketLength()
+                                 : properties_.GetAclDataPacketSize(),
+          [this, handle](uint8_t packet_boundary_flag,
+                         const std::vector<uint8_t>& payload) {
+            std::unique_ptr<AclPacket> echo = AclPacket::CreateAclPacket(
+                handle, packet_boundary_flag, 0, payload);
+            if (echo)
+              send_acl_(std::move(echo));
+          }));
+    }
+    peer.echo_peer->ReceiveAcl(acl_packet->GetPacketBoundaryFlag(),
+                               acl_packet->GetPayload());
+  }
+
+  // The packet has been sent to the peer; return its buffer to the host once
+  // the batch is full, or before the host runs out of buffers.
+  ++connection->second.completed_packets;
+  const bool shared_buffers = properties_.GetNumLeDataPackets() == 0;
+  const bool le_buffers = connection->second.is_le && !shared_buffers;
+  uint16_t& unreported =
+      le_buffers ? unreported_le_packets_ : unreported_acl_packets_;
+  const uint16_t num_buffers = le_buffers
+                                   ? properties_.GetNumLeDataPackets()
+                                   : properties_.GetNumAclDataPackets();
+  ++unreported;
+  if (unreported >= std::min(completed_packets_batch_, num_buffers))
+    SendNumberOfCompletedPackets();
+}
+
+void DualModeController::SendNumberOfCompletedPackets() {
+  std::vector<std::pair<uint16_t, uint16_t>> handles_and_counts;
+  for (auto& connection : connections_) {
+    if (connection.second.completed_packets == 0)
+      continue;
+    handles_and_counts.emplace_back(connection.first,
+                                    connection.second.completed_packets);
+    connection.second.completed_packets = 0;
+    if (handles_and_counts.size() == kMaxCompletedPacketsHandles)
+      break;
+  }
+  if (handles_and_counts.empty())
+    return;
+
+  unreported_acl_packets_ = 0;
+  unreported_le_packets_ = 0;
+  for (const auto& connection : connections_) {
+    if (connection.second.is_le && properties_.GetNumLeDataPackets() != 0)
+      unreported_le_packets_ += connection.second.completed_packets;
+    else
+      unreported_acl_packets_ += connection.second.completed_packets;
+  }
+
+  std::unique_ptr<EventPacket> completed_packets =
+      EventPacket::CreateNumberOfCompletedPacketsEvent(handles_and_counts);
+  if (completed_packets_delay_.is_zero())
+    send_event_(std::move(completed_packets));
+  else
+    send_delayed_event_(std::move(completed_packets), completed_packets_delay_);
+}
+
+uint16_t DualModeController::AddConnection(
+    bool is_le, const std::vector<uint8_t>& address) {
+  while (connections_.count(next_connection_handle_) != 0)
+    next_connection_handle_ = (next_connection_handle_ + 1) %
+                              kMaxConnectionHandle;
+  const uint16_t handle = next_connection_handle_;
+  next_connection_handle_ = (next_connection_handle_ + 1) % kMaxConnectionHandle;
+  connections_[handle] = {is_le, address, 0};
+  return handle;
+}
+
+void DualModeController::ScheduleLeAdvertisingReportTick() {
+  if (le_advertising_tick_pending_ || !post_task_)
+    return;
+  le_advertising_tick_pending_ = true;
+  le_advertising_last_tick_ = base::TimeTicks::Now();
+  post_task_(base::Bind(&DualModeController::LeAdvertisingReportTick,
+                        weak_ptr_factory_.GetWeakPtr()),
+             base::TimeDelta::FromMilliseconds(kLeAdvertisingReportTickMs));
+}
+
+void DualModeController::LeAdvertisingReportTick() {
+  le_advertising_tick_pending_ = false;
+  if (!le_scan_enabled_ || le_advertising_report_rate_ == 0)
+    return;
+
+  // Accumulate fractional reports so that low rates are still honoured.
+  const base::TimeTicks now = base::TimeTicks::Now();
+  le_advertising_reports_due_ += le_advertising_report_rate_ *
+                                 (now - le_advertising_last_tick_).InSecondsF();
+  const uint32_t due = static_cast<uint32_t>(std::min<double>(
+      le_advertising_reports_due_, kLeMaxAdvertisingReportsPerTick));
+  le_advertising_reports_due_ -= due;
+  if (le_advertising_reports_due_ > kLeMaxAdvertisingReportsPerTick)
+    le_advertising_reports_due_ = 0;
+
+  std::vector<uint8_t> reports;
+  uint8_t num_reports = 0;
+  for (uint32_t i = 0; i < due; ++i) {
+    std::vector<uint8_t> next_reports;
+    const uint8_t num_next_reports =
+        AppendLeAdvertisingReports(le_advertising_next_report_++, &next_reports);
+    if (num_reports + num_next_reports > kLeMaxReportsPerEvent ||
+        reports.size() + next_reports.size() > kLeMaxReportOctetsPerEvent) {
+      send_event_(
+          EventPacket::CreateLeAdvertisingReportEvent(num_reports, reports));
+      reports.clear();
+      num_reports = 0;
+    }
+    reports.insert(reports.end(), next_reports.begin(), next_reports.end());
+    num_reports += num_next_reports;
+  }
+  if (num_reports > 0) {
+    send_event_(
+        EventPacket::CreateLeAdvertisingReportEvent(num_reports, reports));
+  }
+
+  ScheduleLeAdvertisingReportTick();
+}
+
+uint8_t DualModeController::AppendLeAdvertisingReports(
+    uint64_t report, std::vector<uint8_t>* reports) const {
+  const uint32_t index = report % le_advertising_num_addresses_;
+  const uint8_t event_type =
+      kLeAdvertisingEventTypes[index % arraysize(kLeAdvertisingEventTypes)];
+  const uint8_t data_length =
+      le_advertising_data_lengths_[report % le_advertising_data_lengths_.size()];
+  const std::vector<uint8_t> address = LeAdvertiserAddress(index);
+  // Spread the advertisers between -40 and -89 dBm.
+  const uint8_t rssi = static_cast<uint8_t>(-40 - static_cast<int>(index % 50));
+
+  const bool scan_response =
+      le_scan_type_ == kLeActiveScan && event_type != kLeAdvNonconnInd;
+  const uint8_t num_reports = scan_response ? 2 : 1;
+  for (uint8_t i = 0; i < num_reports; ++i) {
+    reports->push_back(i == 0 ? event_type : kLeScanRsp);
+    reports->push_back(kLeRandomAddressType);
+    reports->insert(reports->end(), address.begin(), address.end());
+    reports->push_back(data_length);
+    AppendLeAdvertisingData(index, data_length, reports);
+    reports->push_back(rssi);
+  }
+  return num_reports;
+}
+
 void DualModeController::RegisterEventChannel(
     std::function<void(std::unique_ptr<EventPacket>)> callback) {
   send_event_ = callback;
@@ -234,6 +526,16 @@ void DualModeController::RegisterDelayedEventChannel(
   SetEventDelay(0);
 }
 
+void DualModeController::RegisterAclChannel(
+    std::function<void(std::unique_ptr<AclPacket>)> callback) {
+  send_acl_ = callback;
+}
+
+void DualModeController::RegisterTaskChannel(
+    std::function<void(const base::Closure&, base::TimeDelta)> callback) {
+  post_task_ = callback;
+}
+
 void DualModeController::SetEventDelay(int64_t delay) {
   if (delay < 0)
     delay = 0;
@@ -246,6 +548,10 @@ void DualModeController::TestChannelClear(
   LogCommand("TestChannel Clear");
   test_channel_state_ = kNone;
   SetEventDelay(0);
+  acl_mode_ = kAclSink;
+  completed_packets_batch_ = 1;
+  completed_packets_delay_ = base::TimeDelta();
+  le_advertising_report_rate_ = 0;
 }
 
 void DualModeController::TestChannelDiscover(
@@ -261,6 +567,58 @@ void DualModeController::TestChannelTimeoutAll(
   test_channel_state_ = kTimeoutAll;
 }
 
+void DualModeController::TestChannelSetAclMode(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set ACL Mode");
+  if (args.empty())
+    return;
+  if (args[0] == "loopback")
+    acl_mode_ = kAclLoopback;
+  else if (args[0] == "echo")
+    acl_mode_ = kAclEcho;
+  else if (args[0] == "sink")
+    acl_mode_ = kAclSink;
+  else
+    LOG_INFO(LOG_TAG, "Unknown ACL mode: %s", args[0].c_str());
+}
+
+void DualModeController::TestChannelSetCompletedPackets(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Completed Packets");
+  if (args.empty())
+    return;
+  completed_packets_batch_ = std::max(std::stoi(args[0]), 1);
+  completed_packets_delay_ = base::TimeDelta::FromMilliseconds(
+      args.size() > 1 ? std::max(std::stoi(args[1]), 0) : 0);
+}
+
+void DualModeController::TestChannelStartAdvertisingReports(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Start Advertising Reports");
+  if (args.size() < 2)
+    return;
+  le_advertising_report_rate_ = std::max(std::stoi(args[0]), 0);
+  le_advertising_num_addresses_ = std::max(std::stoi(args[1]), 1);
+  le_advertising_data_lengths_.clear();
+  for (size_t i = 2; i < args.size(); ++i) {
+    le_advertising_data_lengths_.push_back(
+        std::min<int>(std::max(std::stoi(args[i]), 0),
+                      kLeMaxAdvertisingDataLength));
+  }
+  if (le_advertising_data_lengths_.empty())
+    le_advertising_data_lengths_.push_back(kLeMaxAdvertisingDataLength);
+  le_advertising_next_report_ = 0;
+  le_advertising_reports_due_ = 0;
+  if (le_scan_enabled_)
+    ScheduleLeAdvertisingReportTick();
+}
+
+void DualModeController::TestChannelStopAdvertisingReports(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Stop Advertising Reports");
+  le_advertising_report_rate_ = 0;
+}
+
 void DualModeController::TestChannelSetEventDelay(
     const std::vector<std::string>& args) {
   LogCommand("TestChannel Set Event Delay");
@@ -463,11 +821,291 @@ void DualModeController::HciDeleteStoredLinkKey(
 void DualModeController::HciRemoteNameRequest(
     const std::vector<uint8_t>& args) {
   LogCommand("Remote Name Request");
+  CHECK(args.size() >= 6);
   SendCommandStatusSuccess(HCI_RMT_NAME_REQUEST);
+  send_event_(EventPacket::CreateRemoteNameRequestCompleteEvent(
+      kSuccessStatus, std::vector<uint8_t>(args.begin(), args.begin() + 6),
+      ""));
+}
+
+void DualModeController::HciCreateConnection(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Create Connection");
+  CHECK(args.size() >= 6);
+  const std::vector<uint8_t> bd_address(args.begin(), args.begin() + 6);
+  SendCommandStatusSuccess(HCI_CREATE_CONNECTION);
+  const uint16_t handle = AddConnection(false, bd_address);
+  send_event_(EventPacket::CreateConnectionCompleteEvent(
+      kSuccessStatus, handle, bd_address, kAclLinkType, 0));
+}
+
+void DualModeController::HciDisconnect(const std::vector<uint8_t>& args) {
+  LogCommand("Disconnect");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  auto connection = connections_.find(handle);
+  if (connection == connections_.end()) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_DISCONNECT);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_DISCONNECT);
+
+  // Packets still in the controller for this connection are flushed, and the
+  // host treats them as completed on disconnection.
+  uint16_t& unreported =
+      (connection->second.is_le && properties_.GetNumLeDataPackets() != 0)
+          ? unreported_le_packets_
+          : unreported_acl_packets_;
+  unreported -= std::min(unreported, connection->second.completed_packets);
+  connections_.erase(connection);
+  send_event_(EventPacket::CreateDisconnectionCompleteEvent(
+      kSuccessStatus, handle, HCI_ERR_CONN_CAUSE_LOCAL_HOST));
+}
+
+void DualModeController::HciReadRemoteVersionInformation(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Read Remote Version Information");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_READ_RMT_VERSION_INFO);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_READ_RMT_VERSION_INFO);
+
+  // Virtual peers report the same LMP version as the local controller:
+  // Status, HCI Version, HCI Revision (2), LMP Version, Manufacturer Name (2),
+  // LMP Subversion (2).
+  const std::vector<uint8_t> version = properties_.GetLocalVersionInformation();
+  send_event_(EventPacket::CreateReadRemoteVersionInformationCompleteEvent(
+      kSuccessStatus, handle, version[4], version[5] | (version[6] << 8),
+      version[7] | (version[8] << 8)));
+}
+
+void DualModeController::HciChangeConnectionPacketType(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Change Connection Packet Type");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_CHANGE_CONN_PACKET_TYPE);
+    return;
+  }
+  // The host ignores the Connection Packet Type Changed event, so none is
+  // sent.
+  SendCommandStatusSuccess(HCI_CHANGE_CONN_PACKET_TYPE);
+}
+
+void DualModeController::HciReadRemoteSupportedFeatures(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Read Remote Supported Features");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_READ_RMT_FEATURES);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_READ_RMT_FEATURES);
+  send_event_(EventPacket::CreateReadRemoteSupportedFeaturesCompleteEvent(
+      kSuccessStatus, handle, kPeerLmpFeatures));
+}
+
+void DualModeController::HciSniffMode(const std::vector<uint8_t>& args) {
+  LogCommand("Sniff Mode");
+  CHECK(args.size() >= 4);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_SNIFF_MODE);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_SNIFF_MODE);
+  // The peer accepts the maximum interval the host asks for.
+  send_event_(EventPacket::CreateModeChangeEvent(
+      kSuccessStatus, handle, HCI_MODE_SNIFF, args[2] | (args[3] << 8)));
+}
+
+void DualModeController::HciExitSniffMode(const std::vector<uint8_t>& args) {
+  LogCommand("Exit Sniff Mode");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_EXIT_SNIFF_MODE);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_EXIT_SNIFF_MODE);
+  send_event_(EventPacket::CreateModeChangeEvent(kSuccessStatus, handle,
+                                                 HCI_MODE_ACTIVE, 0));
+}
+
+void DualModeController::HciWriteLinkPolicySettings(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Link Policy Settings");
+  CHECK(args.size() >= 2);
+  SendCommandComplete(HCI_WRITE_POLICY_SETTINGS,
+                      {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciWriteLinkSupervisionTimeout(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Link Supervision Timeout");
+  CHECK(args.size() >= 2);
+  SendCommandComplete(HCI_WRITE_LINK_SUPER_TOUT,
+                      {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciLeSetEventMask(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Event Mask");
+  SendCommandCompleteSuccess(HCI_BLE_SET_EVENT_MASK);
+}
+
+void DualModeController::HciLeReadBufferSize(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Buffer Size");
+  SendCommandComplete(HCI_BLE_READ_BUFFER_SIZE, properties_.GetLeBufferSize());
+}
+
+void DualModeController::HciLeReadLocalSupportedFeatures(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Local Supported Features");
+  SendCommandComplete(HCI_BLE_READ_LOCAL_SPT_FEAT,
+                      properties_.GetLeLocalSupportedFeatures());
+}
+
+void DualModeController::HciLeSetRandomAddress(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Random Address");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_RANDOM_ADDR);
+}
+
+void DualModeController::HciLeSetAdvertisingParameters(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Advertising Parameters");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_ADV_PARAMS);
+}
+
+void DualModeController::HciLeReadAdvertisingChannelTxPower(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Advertising Channel Tx Power");
+  SendCommandComplete(HCI_BLE_READ_ADV_CHNL_TX_POWER, {kSuccessStatus, 0});
+}
+
+void DualModeController::HciLeSetAdvertisingData(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Advertising Data");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_ADV_DATA);
+}
+
+void DualModeController::HciLeSetScanResponseData(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Scan Response Data");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_SCAN_RSP_DATA);
+}
+
+void DualModeController::HciLeSetAdvertiseEnable(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Advertise Enable");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_ADV_ENABLE);
+}
+
+void DualModeController::HciLeSetScanParameters(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Set Scan Parameters");
+  CHECK(args.size() >= 1);
+  le_scan_type_ = args[0];
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_SCAN_PARAMS);
+}
+
+void DualModeController::HciLeSetScanEnable(const std::vector<uint8_t>& args) {
+  LogCommand("LE Set Scan Enable");
+  CHECK(args.size() >= 1);
+  le_scan_enabled_ = args[0] != 0;
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_SCAN_ENABLE);
+  if (le_scan_enabled_ && le_advertising_report_rate_ != 0)
+    ScheduleLeAdvertisingReportTick();
+}
+
+void DualModeController::HciLeCreateConnection(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Create Connection");
+  CHECK(args.size() >= 25);
+  const uint8_t peer_address_type = args[5];
+  const std::vector<uint8_t> peer_address(args.begin() + 6, args.begin() + 12);
+  const uint16_t interval = args[15] | (args[16] << 8);
+  const uint16_t latency = args[17] | (args[18] << 8);
+  const uint16_t supervision_timeout = args[19] | (args[20] << 8);
+  SendCommandStatusSuccess(HCI_BLE_CREATE_LL_CONN);
+  const uint16_t handle = AddConnection(true, peer_address);
+  send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+      kSuccessStatus, handle, kLeMasterRole, peer_address_type, peer_address,
+      interval, latency, supervision_timeout));
+}
+
+void DualModeController::HciLeCreateConnectionCancel(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Create Connection Cancel");
+  // Connections complete as soon as they are created, so there is never one
+  // to cancel.
+  SendCommandComplete(HCI_BLE_CREATE_CONN_CANCEL, {HCI_ERR_COMMAND_DISALLOWED});
+}
+
+void DualModeController::HciLeReadWhiteListSize(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read White List Size");
+  SendCommandComplete(HCI_BLE_READ_WHITE_LIST_SIZE,
+                      properties_.GetLeWhiteListSize());
+}
+
+void DualModeController::HciLeClearWhiteList(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Clear White List");
+  SendCommandCompleteSuccess(HCI_BLE_CLEAR_WHITE_LIST);
+}
+
+void DualModeController::HciLeAddDeviceToWhiteList(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Add Device To White List");
+  SendCommandCompleteSuccess(HCI_BLE_ADD_WHITE_LIST);
+}
+
+void DualModeController::HciLeRemoveDeviceFromWhiteList(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Remove Device From White List");
+  SendCommandCompleteSuccess(HCI_BLE_REMOVE_WHITE_LIST);
+}
+
+void DualModeController::HciLeReadRemoteUsedFeatures(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Read Remote Used Features");
+  CHECK(args.size() >= 2);
+  const uint16_t handle = (args[0] | (args[1] << 8)) & 0x0FFF;
+  if (connections_.count(handle) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_BLE_READ_REMOTE_FEAT);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_BLE_READ_REMOTE_FEAT);
+
+  // Virtual peers support the same LE features as the local controller.
+  const std::vector<uint8_t> features =
+      properties_.GetLeLocalSupportedFeatures();
+  send_event_(EventPacket::CreateLeReadRemoteUsedFeaturesCompleteEvent(
+      kSuccessStatus, handle,
+      std::vector<uint8_t>(features.begin() + 1, features.end())));
+}
+
+void DualModeController::HciLeReadSupportedStates(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Supported States");
+  SendCommandComplete(HCI_BLE_READ_SUPPORTED_STATES,
+                      properties_.GetLeSupportedStates());
 }
 
 DualModeController::Properties::Properties(const std::string& file_name)
-    : local_supported_commands_size_(64), local_name_size_(248) {
+    : local_supported_commands_size_(64),
+      local_name_size_(248),
+      le_data_packet_length_(27),
+      num_le_data_packets_(0),
+      le_white_list_size_(8) {
   std::string properties_raw;
   if (!base::ReadFileToString(base::FilePath(file_name), &properties_raw))
     LOG_INFO(LOG_TAG, "Error reading controller properties from file.");
@@ -503,6 +1141,48 @@ DualModeController::Properties::GetLocalVersionInformation() {
                                lmp_pal_subversion_, lmp_pal_subversion_ >> 8});
 }
 
+const std::vector<uint8_t> DualModeController::Properties::GetLeBufferSize() {
+  return std::vector<uint8_t>({kSuccessStatus, le_data_packet_length_,
+                               le_data_packet_length_ >> 8,
+                               num_le_data_packets_});
+}
+
+const std::vector<uint8_t>
+DualModeController::Properties::GetLeLocalSupportedFeatures() {
+  // Only LE Encryption, so that the host does not expect privacy or data
+  // length extension support.
+  return std::vector<uint8_t>({kSuccessStatus, 0x01, 0x00, 0x00, 0x00, 0x00,
+                               0x00, 0x00, 0x00});
+}
+
+const std::vector<uint8_t>
+DualModeController::Properties::GetLeSupportedStates() {
+  // All 42 state combinations defined by the specification.
+  return std::vector<uint8_t>({kSuccessStatus, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                               0x03, 0x00, 0x00});
+}
+
+const std::vector<uint8_t>
+DualModeController::Properties::GetLeWhiteListSize() {
+  return std::vector<uint8_t>({kSuccessStatus, le_white_list_size_});
+}
+
+uint16_t DualModeController::Properties::GetNumAclDataPackets() const {
+  return num_acl_data_packets_;
+}
+
+uint8_t DualModeController::Properties::GetNumLeDataPackets() const {
+  return num_le_data_packets_;
+}
+
+uint16_t DualModeController::Properties::GetAclDataPacketSize() const {
+  return acl_data_packet_size_;
+}
+
+uint16_t DualModeController::Properties::GetLeDataPacketLength() const {
+  return le_data_packet_length_;
+}
+
 const std::vector<uint8_t> DualModeController::Properties::GetBdAddress() {
   return bd_address_;
 }
@@ -551,6 +1231,9 @@ void DualModeController::Properties::RegisterJSONConverter(
   REGISTER_UINT16_T("ManufacturerName", manufacturer_name_);
   REGISTER_UINT16_T("LmpPalSubversion", lmp_pal_subversion_);
   REGISTER_UINT8_T("MaximumPageNumber", maximum_page_number_);
+  REGISTER_UINT16_T("LeDataPacketLength", le_data_packet_length_);
+  REGISTER_UINT8_T("NumLeDataPackets", num_le_data_packets_);
+  REGISTER_UINT8_T("LeWhiteListSize", le_white_list_size_);
   converter->RegisterCustomField<std::vector<uint8_t>>(
       "BdAddress", &DualModeController::Properties::bd_address_,
       &ParseUint8tVector);
@@ -0,0 +1,469 @@
+//
+// Copyright 2016 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "echo_peer"
+
+#include "vendor_libs/test_vendor_lib/include/echo_peer.h"
+
+#include <algorithm>
+
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
+
+extern "C" {
+#include "osi/include/log.h"
+#include "stack/include/l2cdefs.h"
+#include "stack/include/rfcdefs.h"
+}  // extern "C"
+
+namespace {
+
+// The only PSM the peer accepts BR/EDR channels on.
+const uint16_t kRfcommPsm = 0x0003;
+
+// The MTU the peer configures on BR/EDR channels, as large as the host asks
+// for RFCOMM.
+const uint16_t kBrEdrMtu = 1691;
+
+uint16_t ReadUint16(const uint8_t* data) {
+  return data[0] | (data[1] << 8);
+}
+
+void AppendUint16(std::vector<uint8_t>* data, uint16_t value) {
+  data->push_back(value & 0xFF);
+  data->push_back(value >> 8);
+}
+
+// The TS 07.10 frame check sequence over the first |length| octets at |data|.
+uint8_t RfcommFcs(const uint8_t* data, size_t length) {
+  uint8_t fcs = 0xFF;
+  for (size_t i = 0; i < length; ++i) {
+    fcs ^= data[i];
+    for (int bit = 0; bit < 8; ++bit)
+      fcs = (fcs & 0x01) ? (fcs >> 1) ^ 0xE0 : fcs >> 1;
+  }
+  return 0xFF - fcs;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+EchoPeer::EchoPeer(
+    bool is_le, size_t max_acl_payload,
+    std::function<void(uint8_t, const std::vector<uint8_t>&)> send_acl)
+    : is_le_(is_le),
+      max_acl_payload_(max_acl_payload),
+      send_acl_(send_acl),
+      next_peer_cid_(L2CAP_BASE_APPL_CID),
+      next_signal_id_(1) {}
+
+void EchoPeer::ReceiveAcl(uint8_t packet_boundary_flag,
+                          const std::vector<uint8_t>& payload) {
+  if (packet_boundary_flag != AclPacket::kContinuing) {
+    rx_frame_ = payload;
+  } else if (!rx_frame_.empty()) {
+    rx_frame_.insert(rx_frame_.end(), payload.begin(), payload.end());
+  } else {
+    LOG_INFO(LOG_TAG, "Dropping continuing fragment without a start.");
+    return;
+  }
+
+  if (rx_frame_.size() < L2CAP_PKT_OVERHEAD) return;
+  const size_t frame_size = L2CAP_PKT_OVERHEAD + ReadUint16(&rx_frame_[0]);
+  if (rx_frame_.size() < frame_size) return;
+
+  std::vector<uint8_t> frame;
+  frame.swap(rx_frame_);
+  if (frame.size() > frame_size) {
+    LOG_INFO(LOG_TAG, "Dropping L2CAP frame longer than its header.");
+    return;
+  }
+  ReceiveFrame(frame);
+}
+
+void EchoPeer::ReceiveFrame(const std::vector<uint8_t>& frame) {
+  const uint16_t cid = ReadUint16(&frame[2]);
+  const uint8_t* data = frame.data() + L2CAP_PKT_OVERHEAD;
+  size_t length = frame.size() - L2CAP_PKT_OVERHEAD;
+
+  if (cid == (is_le_ ? L2CAP_BLE_SIGNALLING_CID : L2CAP_SIGNALLING_CID)) {
+    // BR/EDR C-frames may carry several commands.
+    while (length >= L2CAP_CMD_OVERHEAD) {
+      const uint16_t command_length = ReadUint16(data + 2);
+      if (command_length > length - L2CAP_CMD_OVERHEAD) break;
+      HandleSignal(data[0], data[1], data + L2CAP_CMD_OVERHEAD,
+                   command_length);
+      data += L2CAP_CMD_OVERHEAD + command_length;
+      length -= L2CAP_CMD_OVERHEAD + command_length;
+    }
+    return;
+  }
+
+  auto channel = channels_.find(cid);
+  if (channel == channels_.end()) {
+    LOG_INFO(LOG_TAG, "Dropping L2CAP frame for unknown CID 0x%04X.", cid);
+    return;
+  }
+  if (is_le_)
+    HandleLeFrame(&channel->second, cid, data, length);
+  else
+    HandleRfcommFrame(&channel->second, data, length);
+}
+
+void EchoPeer::SendFrame(uint16_t cid, const std::vector<uint8_t>& payload) {
+  std::vector<uint8_t> frame;
+  frame.reserve(L2CAP_PKT_OVERHEAD + payload.size());
+  AppendUint16(&frame, payload.size());
+  AppendUint16(&frame, cid);
+  frame.insert(frame.end(), payload.begin(), payload.end());
+
+  uint8_t packet_boundary_flag = AclPacket::kFirstFlushable;
+  for (size_t offset = 0; offset < frame.size(); offset += max_acl_payload_) {
+    const size_t end = std::min(frame.size(), offset + max_acl_payload_);
+    send_acl_(packet_boundary_flag, std::vector<uint8_t>(frame.begin() + offset,
+                                                         frame.begin() + end));
+    packet_boundary_flag = AclPacket::kContinuing;
+  }
+}
+
+void EchoPeer::SendSignal(uint8_t code, uint8_t id,
+                          const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> command = {code, id};
+  AppendUint16(&command, data.size());
+  command.insert(command.end(), data.begin(), data.end());
+  SendFrame(is_le_ ? L2CAP_BLE_SIGNALLING_CID : L2CAP_SIGNALLING_CID, command);
+}
+
+void EchoPeer::HandleSignal(uint8_t code, uint8_t id, const uint8_t* data,
+                            uint16_t length) {
+  switch (code) {
+    case L2CAP_CMD_CONN_REQ: {
+      if (is_le_ || length < 4) break;
+      const uint16_t psm = ReadUint16(data);
+      const uint16_t host_cid = ReadUint16(data + 2);
+      std::vector<uint8_t> response;
+      if (psm != kRfcommPsm) {
+        AppendUint16(&response, 0);
+        AppendUint16(&response, host_cid);
+        AppendUint16(&response, L2CAP_CONN_NO_PSM);
+        AppendUint16(&response, 0);
+        SendSignal(L2CAP_CMD_CONN_RSP, id, response);
+        return;
+      }
+      const uint16_t peer_cid = next_peer_cid_++;
+      Channel channel = Channel();
+      channel.host_cid = host_cid;
+      channels_[peer_cid] = channel;
+      AppendUint16(&response, peer_cid);
+      AppendUint16(&response, host_cid);
+      AppendUint16(&response, L2CAP_CONN_OK);
+      AppendUint16(&response, 0);
+      SendSignal(L2CAP_CMD_CONN_RSP, id, response);
+
+      std::vector<uint8_t> config;
+      AppendUint16(&config, host_cid);
+      AppendUint16(&config, 0);
+      config.push_back(L2CAP_CFG_TYPE_MTU);
+      config.push_back(L2CAP_CFG_MTU_OPTION_LEN);
+      AppendUint16(&config, kBrEdrMtu);
+      SendSignal(L2CAP_CMD_CONFIG_REQ, next_signal_id_++, config);
+      if (next_signal_id_ == 0) next_signal_id_ = 1;
+      return;
+    }
+
+    case L2CAP_CMD_CONFIG_REQ: {
+      if (is_le_ || length < 4) break;
+      auto channel = channels_.find(ReadUint16(data));
+      if (channel == channels_.end()) return;
+      std::vector<uint8_t> response;
+      AppendUint16(&response, channel->second.host_cid);
+      AppendUint16(&response, 0);
+      AppendUint16(&response, L2CAP_CFG_OK);
+      SendSignal(L2CAP_CMD_CONFIG_RSP, id, response);
+      return;
+    }
+
+    case L2CAP_CMD_DISC_REQ: {
+      if (length < 4) break;
+      channels_.erase(ReadUint16(data));
+      SendSignal(L2CAP_CMD_DISC_RSP, id,
+                 std::vector<uint8_t>(data, data + 4));
+      return;
+    }
+
+    case L2CAP_CMD_ECHO_REQ:
+      if (is_le_) break;
+      SendSignal(L2CAP_CMD_ECHO_RSP, id,
+                 std::vector<uint8_t>(data, data + length));
+      return;
+
+    case L2CAP_CMD_INFO_REQ: {
+      if (is_le_ || length < 2) break;
+      const uint16_t type = ReadUint16(data);
+      std::vector<uint8_t> response;
+      AppendUint16(&response, type);
+      if (type == L2CAP_EXTENDED_FEATURES_INFO_TYPE) {
+        AppendUint16(&response, L2CAP_INFO_RESP_RESULT_SUCCESS);
+        response.resize(response.size() + 4, 0);
+      } else {
+        AppendUint16(&response, L2CAP_INFO_RESP_RESULT_NOT_SUPPORTED);
+      }
+      SendSignal(L2CAP_CMD_INFO_RSP, id, response);
+      return;
+    }
+
+    case L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ: {
+      if (!is_le_ || length < L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ_LEN) break;
+      // Takes the host's MTU, MPS and initial credits for its own, so the
+      // host can send as much as it can take back.
+      const uint16_t peer_cid = next_peer_cid_++;
+      Channel channel = Channel();
+      channel.host_cid = ReadUint16(data + 2);
+      channel.host_mtu = ReadUint16(data + 4);
+      channel.host_mps = ReadUint16(data + 6);
+      channel.tx_credits = ReadUint16(data + 8);
+      channels_[peer_cid] = channel;
+
+      std::vector<uint8_t> response;
+      AppendUint16(&response, peer_cid);
+      response.insert(response.end(), data + 4, data + 10);
+      AppendUint16(&response, L2CAP_LE_CONN_OK);
+      SendSignal(L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES, id, response);
+      return;
+    }
+
+    case L2CAP_CMD_BLE_FLOW_CTRL_CREDIT: {
+      if (!is_le_ || length < L2CAP_CMD_BLE_FLOW_CTRL_CREDIT_LEN) break;
+      const uint16_t host_cid = ReadUint16(data);
+      for (auto& channel : channels_) {
+        if (channel.second.host_cid != host_cid) continue;
+        channel.second.tx_credits += ReadUint16(data + 2);
+        SendLeFrames(&channel.second, channel.first);
+        break;
+      }
+      return;
+    }
+
+    case L2CAP_CMD_REJECT:
+    case L2CAP_CMD_CONFIG_RSP:
+    case L2CAP_CMD_DISC_RSP:
+    case L2CAP_CMD_INFO_RSP:
+    case L2CAP_CMD_BLE_UPDATE_RSP:
+      return;
+  }
+
+  std::vector<uint8_t> reject;
+  AppendUint16(&reject, L2CAP_CMD_REJ_NOT_UNDERSTOOD);
+  SendSignal(L2CAP_CMD_REJECT, id, reject);
+}
+
+void EchoPeer::HandleLeFrame(Channel* channel, uint16_t peer_cid,
+                             const uint8_t* data, size_t length) {
+  // The first K-frame of an SDU starts with the SDU length.
+  if (channel->sdu_frames == 0) {
+    if (length < L2CAP_SDU_LEN_OVERHEAD) return;
+    channel->sdu_length = ReadUint16(data);
+    channel->sdu.clear();
+    data += L2CAP_SDU_LEN_OVERHEAD;
+    length -= L2CAP_SDU_LEN_OVERHEAD;
+  }
+  channel->sdu.insert(channel->sdu.end(), data, data + length);
+  channel->sdu_frames++;
+  if (channel->sdu.size() < channel->sdu_length) return;
+
+  // Segments the echo by the host's MPS. The credits the SDU took are
+  // returned with its last K-frame.
+  std::vector<uint8_t> k_frame;
+  AppendUint16(&k_frame, channel->sdu.size());
+  size_t offset = 0;
+  do {
+    const size_t end = std::min(channel->sdu.size(),
+                                offset + channel->host_mps - k_frame.size());
+    k_frame.insert(k_frame.end(), channel->sdu.begin() + offset,
+                   channel->sdu.begin() + end);
+    offset = end;
+    channel->k_frames.emplace_back(
+        std::move(k_frame),
+        offset == channel->sdu.size() ? channel->sdu_frames : 0);
+    k_frame.clear();
+  } while (offset < channel->sdu.size());
+
+  channel->sdu.clear();
+  channel->sdu_frames = 0;
+  SendLeFrames(channel, peer_cid);
+}
+
+void EchoPeer::SendLeFrames(Channel* channel, uint16_t peer_cid) {
+  while (channel->tx_credits > 0 && !channel->k_frames.empty()) {
+    SendFrame(channel->host_cid, channel->k_frames.front().first);
+    const uint16_t credits = channel->k_frames.front().second;
+    channel->k_frames.pop_front();
+    channel->tx_credits--;
+    if (credits == 0) continue;
+
+    std::vector<uint8_t> credit;
+    AppendUint16(&credit, peer_cid);
+    AppendUint16(&credit, credits);
+    SendSignal(L2CAP_CMD_BLE_FLOW_CTRL_CREDIT, next_signal_id_++, credit);
+    if (next_signal_id_ == 0) next_signal_id_ = 1;
+  }
+}
+
+void EchoPeer::HandleRfcommFrame(Channel* channel, const uint8_t* data,
+                                 size_t length) {
+  if (length < 4) return;
+  const uint8_t dlci = data[0] >> RFCOMM_SHIFT_DLCI;
+  const uint8_t type = data[1] & ~RFCOMM_PF_MASK;
+  const bool poll = data[1] & RFCOMM_PF_MASK;
+
+  size_t header = 3;
+  size_t info_length = data[2] >> RFCOMM_SHIFT_LENGTH1;
+  if (!(data[2] & RFCOMM_EA))
+    info_length += data[header++] << RFCOMM_SHIFT_LENGTH2;
+  uint8_t credits = 0;
+  if (type == RFCOMM_UIH && poll && dlci != RFCOMM_MX_DLCI && header < length)
+    credits = data[header++];
+  if (header + info_length + 1 != length) return;
+
+  // UIH frames are checked over the address and control fields only.
+  if (RfcommFcs(data, type == RFCOMM_UIH ? 2 : RFCOMM_CTRL_FRAME_LEN) !=
+      data[length - 1]) {
+    LOG_INFO(LOG_TAG, "Dropping RFCOMM frame with a bad FCS.");
+    return;
+  }
+
+  switch (type) {
+    case RFCOMM_SABME:
+      if (dlci != RFCOMM_MX_DLCI) channel->dlcs.insert({dlci, Dlc()});
+      SendRfcommFrame(*channel, dlci, RFCOMM_UA, false, {}, 0);
+      break;
+
+    case RFCOMM_DISC:
+      if (dlci == RFCOMM_MX_DLCI)
+        channel->dlcs.clear();
+      else
+        channel->dlcs.erase(dlci);
+      SendRfcommFrame(*channel, dlci, RFCOMM_UA, false, {}, 0);
+      break;
+
+    case RFCOMM_UIH: {
+      const std::vector<uint8_t> info(data + header,
+                                      data + header + info_length);
+      if (dlci == RFCOMM_MX_DLCI) {
+        HandleRfcommControl(channel, info);
+        break;
+      }
+      auto dlc = channel->dlcs.find(dlci);
+      if (dlc == channel->dlcs.end()) break;
+      dlc->second.tx_credits += credits;
+      if (!info.empty()) dlc->second.echoes.push_back(info);
+      SendRfcommEchoes(channel, dlci);
+      break;
+    }
+  }
+}
+
+void EchoPeer::HandleRfcommControl(Channel* channel,
+                                   const std::vector<uint8_t>& info) {
+  if (info.size() < 2) return;
+  const uint8_t type = info[0] & ~(RFCOMM_EA | RFCOMM_CR_MASK);
+  // Responses to the peer's own commands need no answer.
+  if (!(info[0] & RFCOMM_CR_MASK)) return;
+  const size_t value_offset = (info[1] & RFCOMM_EA) ? 2 : 3;
+  if (info.size() < value_offset) return;
+  std::vector<uint8_t> value(info.begin() + value_offset, info.end());
+
+  switch (type) {
+    case RFCOMM_MX_PN: {
+      if (value.size() != RFCOMM_MX_PN_LEN) return;
+      // Credit based flow control, starting with as many credits as the host
+      // gives and handing it the most it can take.
+      Dlc& dlc = channel->dlcs[value[0] & RFCOMM_PN_DLCI_MASK];
+      dlc.tx_credits = value[7] & RFCOMM_PN_K_MASK;
+      value[1] = (value[1] & ~RFCOMM_PN_CONV_LAYER_MASK) |
+                 RFCOMM_PN_CONV_LAYER_CBFC_R;
+      value[7] = RFCOMM_K_MAX;
+      SendRfcommControl(*channel, type, false, value);
+      return;
+    }
+
+    case RFCOMM_MX_MSC: {
+      if (value.empty()) return;
+      SendRfcommControl(*channel, type, false, value);
+      auto dlc = channel->dlcs.find(value[0] >> RFCOMM_SHIFT_DLCI);
+      if (dlc == channel->dlcs.end() || dlc->second.msc_sent) return;
+      dlc->second.msc_sent = true;
+      SendRfcommControl(*channel, type, true,
+                        {value[0], RFCOMM_EA | RFCOMM_MSC_RTC |
+                                       RFCOMM_MSC_RTR | RFCOMM_MSC_DV});
+      return;
+    }
+
+    case RFCOMM_MX_RPN:
+    case RFCOMM_MX_RLS:
+    case RFCOMM_MX_TEST:
+    case RFCOMM_MX_FCON:
+    case RFCOMM_MX_FCOFF:
+      SendRfcommControl(*channel, type, false, value);
+      return;
+  }
+
+  SendRfcommControl(*channel, RFCOMM_MX_NSC, false, {info[0]});
+}
+
+void EchoPeer::SendRfcommFrame(const Channel& channel, uint8_t dlci,
+                               uint8_t type, bool command,
+                               const std::vector<uint8_t>& info,
+                               uint8_t credits) {
+  std::vector<uint8_t> frame;
+  frame.reserve(info.size() + 6);
+  frame.push_back(RFCOMM_EA | RFCOMM_CR(false, command) |
+                  (dlci << RFCOMM_SHIFT_DLCI));
+  frame.push_back(type | ((type != RFCOMM_UIH || credits) ? RFCOMM_PF : 0));
+  if (info.size() <= 127) {
+    frame.push_back(RFCOMM_EA | (info.size() << RFCOMM_SHIFT_LENGTH1));
+  } else {
+    frame.push_back((info.size() << RFCOMM_SHIFT_LENGTH1) & 0xFE);
+    frame.push_back(info.size() >> RFCOMM_SHIFT_LENGTH2);
+  }
+  if (credits) frame.push_back(credits);
+  frame.insert(frame.end(), info.begin(), info.end());
+  frame.push_back(
+      RfcommFcs(frame.data(), type == RFCOMM_UIH ? 2 : RFCOMM_CTRL_FRAME_LEN));
+  SendFrame(channel.host_cid, frame);
+}
+
+void EchoPeer::SendRfcommControl(const Channel& channel, uint8_t type,
+                                 bool command,
+                                 const std::vector<uint8_t>& value) {
+  std::vector<uint8_t> info;
+  info.push_back(RFCOMM_EA | RFCOMM_I_CR(command) | type);
+  info.push_back(RFCOMM_EA | (value.size() << RFCOMM_SHIFT_LENGTH1));
+  info.insert(info.end(), value.begin(), value.end());
+  SendRfcommFrame(channel, RFCOMM_MX_DLCI, RFCOMM_UIH, true, info, 0);
+}
+
+void EchoPeer::SendRfcommEchoes(Channel* channel, uint8_t dlci) {
+  // Each echo hands back the credit the host spent on what it echoes.
+  Dlc& dlc = channel->dlcs[dlci];
+  while (dlc.tx_credits > 0 && !dlc.echoes.empty()) {
+    SendRfcommFrame(*channel, dlci, RFCOMM_UIH, true, dlc.echoes.front(), 1);
+    dlc.echoes.pop_front();
+    dlc.tx_credits--;
+  }
+}
+
+}  // namespace test_vendor_lib
@@ -21,11 +21,21 @@
 
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 
+#include <algorithm>
+
 extern "C" {
 #include "osi/include/log.h"
 #include "stack/include/hcidefs.h"
 }  // extern "C"
 
+namespace {
+
+// Size in octets of the Remote Name parameter of a remote name request
+// complete event.
+const size_t kRemoteNameSize = 248;
+
+}  // namespace
+
 namespace test_vendor_lib {
 
 EventPacket::EventPacket(uint8_t event_code,
@@ -128,4 +138,147 @@ std::unique_ptr<EventPacket> EventPacket::CreateExtendedInquiryResultEvent(
       new EventPacket(HCI_EXTENDED_INQUIRY_RESULT_EVT, payload));
 }
 
+std::unique_ptr<EventPacket> EventPacket::CreateConnectionCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& bd_address,
+    uint8_t link_type, uint8_t encryption_enabled) {
+  std::vector<uint8_t> payload;
+  payload.reserve(sizeof(status) + sizeof(handle) + bd_address.size() +
+                  sizeof(link_type) + sizeof(encryption_enabled));
+  payload.push_back(status);
+  payload.push_back(handle);
+  payload.push_back(handle >> 8);
+  VECTOR_COPY_TO_END(bd_address, payload);
+  payload.push_back(link_type);
+  payload.push_back(encryption_enabled);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_CONNECTION_COMP_EVT, payload));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateDisconnectionCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t reason) {
+  return std::unique_ptr<EventPacket>(new EventPacket(
+      HCI_DISCONNECTION_COMP_EVT,
+      {status, static_cast<uint8_t>(handle), static_cast<uint8_t>(handle >> 8),
+       reason}));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateRemoteNameRequestCompleteEvent(
+    uint8_t status, const std::vector<uint8_t>& bd_address,
+    const std::string& name) {
+  std::vector<uint8_t> payload;
+  payload.reserve(sizeof(status) + bd_address.size() + kRemoteNameSize);
+  payload.push_back(status);
+  VECTOR_COPY_TO_END(bd_address, payload);
+  payload.insert(payload.end(), name.begin(),
+                 name.begin() + std::min(name.size(), kRemoteNameSize));
+  payload.resize(sizeof(status) + bd_address.size() + kRemoteNameSize, 0);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_RMT_NAME_REQUEST_COMP_EVT, payload));
+}
+
+std::unique_ptr<EventPacket>
+EventPacket::CreateReadRemoteSupportedFeaturesCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& features) {
+  std::vector<uint8_t> payload;
+  payload.reserve(3 + features.size());
+  payload.push_back(status);
+  payload.push_back(handle);
+  payload.push_back(handle >> 8);
+  VECTOR_COPY_TO_END(features, payload);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_READ_RMT_FEATURES_COMP_EVT, payload));
+}
+
+std::unique_ptr<EventPacket>
+EventPacket::CreateReadRemoteVersionInformationCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t version,
+    uint16_t manufacturer_name, uint16_t subversion) {
+  return std::unique_ptr<EventPacket>(new EventPacket(
+      HCI_READ_RMT_VERSION_COMP_EVT,
+      {status, static_cast<uint8_t>(handle), static_cast<uint8_t>(handle >> 8),
+       version, static_cast<uint8_t>(manufacturer_name),
+       static_cast<uint8_t>(manufacturer_name >> 8),
+       static_cast<uint8_t>(subversion), static_cast<uint8_t>(subversion >> 8)}));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateModeChangeEvent(
+    uint8_t status, uint16_t handle, uint8_t mode, uint16_t interval) {
+  return std::unique_ptr<EventPacket>(new EventPacket(
+      HCI_MODE_CHANGE_EVT,
+      {status, static_cast<uint8_t>(handle), static_cast<uint8_t>(handle >> 8),
+       mode, static_cast<uint8_t>(interval),
+       static_cast<uint8_t>(interval >> 8)}));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateNumberOfCompletedPacketsEvent(
+    const std::vector<std::pair<uint16_t, uint16_t>>& handles_and_counts) {
+  std::vector<uint8_t> payload;
+  payload.reserve(1 + 4 * handles_and_counts.size());
+  payload.push_back(handles_and_counts.size());
+  for (const auto& handle_and_count : handles_and_counts) {
+    payload.push_back(handle_and_count.first);
+    payload.push_back(handle_and_count.first >> 8);
+    payload.push_back(handle_and_count.second);
+    payload.push_back(handle_and_count.second >> 8);
+  }
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_NUM_COMPL_DATA_PKTS_EVT, payload));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateLeConnectionCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t role, uint8_t peer_address_type,
+    const std::vector<uint8_t>& peer_address, uint16_t interval,
+    uint16_t latency, uint16_t supervision_timeout) {
+  // The master clock accuracy is only valid for slaves; 0x00 is 500 ppm.
+  const uint8_t master_clock_accuracy = 0x00;
+
+  std::vector<uint8_t> payload;
+  payload.reserve(12 + peer_address.size());
+  payload.push_back(HCI_BLE_CONN_COMPLETE_EVT);
+  payload.push_back(status);
+  payload.push_back(handle);
+  payload.push_back(handle >> 8);
+  payload.push_back(role);
+  payload.push_back(peer_address_type);
+  VECTOR_COPY_TO_END(peer_address, payload);
+  payload.push_back(interval);
+  payload.push_back(interval >> 8);
+  payload.push_back(latency);
+  payload.push_back(latency >> 8);
+  payload.push_back(supervision_timeout);
+  payload.push_back(supervision_timeout >> 8);
+  payload.push_back(master_clock_accuracy);
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
+std::unique_ptr<EventPacket>
+EventPacket::CreateLeReadRemoteUsedFeaturesCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& features) {
+  std::vector<uint8_t> payload;
+  payload.reserve(4 + features.size());
+  payload.push_back(HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT);
+  payload.push_back(status);
+  payload.push_back(handle);
+  payload.push_back(handle >> 8);
+  VECTOR_COPY_TO_END(features, payload);
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateLeAdvertisingReportEvent(
+    uint8_t num_reports, const std::vector<uint8_t>& reports) {
+  std::vector<uint8_t> payload;
+  payload.reserve(2 + reports.size());
+  payload.push_back(HCI_BLE_ADV_PKT_RPT_EVT);
+  payload.push_back(num_reports);
+  VECTOR_COPY_TO_END(reports, payload);
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
 }  // namespace test_vendor_lib
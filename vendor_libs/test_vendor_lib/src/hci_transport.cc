@@ -72,7 +72,7 @@ void HciTransport::OnFileCanReadWithoutBlocking(int fd) {
     }
 
     case (DATA_TYPE_ACL): {
-      LOG_INFO(LOG_TAG, "ACL data packets not currently supported.");
+      ReceiveReadyAcl();
       break;
     }
 
@@ -96,39 +96,59 @@ void HciTransport::ReceiveReadyCommand() const {
   command_handler_(std::move(command));
 }
 
+void HciTransport::ReceiveReadyAcl() const {
+  std::unique_ptr<AclPacket> acl = packet_stream_.ReceiveAcl(GetVendorFd());
+  if (!acl)
+    return;
+  if (!acl_handler_) {
+    LOG_INFO(LOG_TAG, "Dropping ACL data packet, no handler registered.");
+    return;
+  }
+  acl_handler_(std::move(acl));
+}
+
 void HciTransport::RegisterCommandHandler(
     std::function<void(std::unique_ptr<CommandPacket>)> callback) {
   command_handler_ = callback;
 }
 
+void HciTransport::RegisterAclHandler(
+    std::function<void(std::unique_ptr<AclPacket>)> callback) {
+  acl_handler_ = callback;
+}
+
 void HciTransport::OnFileCanWriteWithoutBlocking(int fd) {
   CHECK(fd == GetVendorFd());
-  if (!outbound_events_.empty()) {
+  if (!outbound_packets_.empty()) {
     base::TimeTicks current_time = base::TimeTicks::Now();
-    auto it = outbound_events_.begin();
-    // Check outbound events for events that can be sent, i.e. events with a
-    // timestamp before the current time. Stop sending events when
+    // Check outbound packets for packets that can be sent, i.e. packets with a
+    // timestamp before the current time. Stop sending packets when
     // |packet_stream_| fails writing.
-    for (auto it = outbound_events_.begin(); it != outbound_events_.end();) {
+    for (auto it = outbound_packets_.begin(); it != outbound_packets_.end();) {
       if ((*it)->GetTimeStamp() > current_time) {
         ++it;
         continue;
       }
-      if (!packet_stream_.SendEvent((*it)->GetEvent(), fd))
+      if (!packet_stream_.SendPacket((*it)->GetPacket(), fd))
         return;
-      it = outbound_events_.erase(it);
+      it = outbound_packets_.erase(it);
     }
   }
 }
 
-void HciTransport::AddEventToOutboundEvents(
-    std::unique_ptr<TimeStampedEvent> event) {
-  outbound_events_.push_back(std::move(event));
+void HciTransport::AddPacketToOutboundPackets(
+    std::unique_ptr<TimeStampedPacket> packet) {
+  outbound_packets_.push_back(std::move(packet));
 }
 
 void HciTransport::PostEventResponse(std::unique_ptr<EventPacket> event) {
-  AddEventToOutboundEvents(
-      std::make_unique<TimeStampedEvent>(std::move(event)));
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(event)));
+}
+
+void HciTransport::PostAclData(std::unique_ptr<AclPacket> acl) {
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(acl)));
 }
 
 void HciTransport::PostDelayedEventResponse(std::unique_ptr<EventPacket> event,
@@ -151,24 +171,24 @@ void HciTransport::PostDelayedEventResponse(std::unique_ptr<EventPacket> event,
   LOG_INFO(LOG_TAG, "Posting event response with delay of %lld ms.",
            delay.InMilliseconds());
 
-  AddEventToOutboundEvents(
-      std::make_unique<TimeStampedEvent>(std::move(event), delay));
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(event), delay));
 }
 
-HciTransport::TimeStampedEvent::TimeStampedEvent(
-    std::unique_ptr<EventPacket> event, base::TimeDelta delay)
-    : event_(std::move(event)), time_stamp_(base::TimeTicks::Now() + delay) {}
+HciTransport::TimeStampedPacket::TimeStampedPacket(
+    std::unique_ptr<Packet> packet, base::TimeDelta delay)
+    : packet_(std::move(packet)), time_stamp_(base::TimeTicks::Now() + delay) {}
 
-HciTransport::TimeStampedEvent::TimeStampedEvent(
-    std::unique_ptr<EventPacket> event)
-    : event_(std::move(event)), time_stamp_(base::TimeTicks::UnixEpoch()) {}
+HciTransport::TimeStampedPacket::TimeStampedPacket(
+    std::unique_ptr<Packet> packet)
+    : packet_(std::move(packet)), time_stamp_(base::TimeTicks::UnixEpoch()) {}
 
-const base::TimeTicks& HciTransport::TimeStampedEvent::GetTimeStamp() const {
+const base::TimeTicks& HciTransport::TimeStampedPacket::GetTimeStamp() const {
   return time_stamp_;
 }
 
-const EventPacket& HciTransport::TimeStampedEvent::GetEvent() {
-  return *(event_.get());
+const Packet& HciTransport::TimeStampedPacket::GetPacket() {
+  return *(packet_.get());
 }
 
 }  // namespace test_vendor_lib
@@ -32,7 +32,7 @@ Packet::Packet(serial_data_type_t type) : type_(type) {}
 
 bool Packet::Encode(const std::vector<uint8_t>& header,
                     const std::vector<uint8_t>& payload) {
-  if (header.back() != payload.size())
+  if (GetPayloadSizeFromHeader(header) != payload.size())
     return false;
   header_ = header;
   payload_ = payload;
@@ -58,10 +58,15 @@ const std::vector<uint8_t>& Packet::GetPayload() const {
   return payload_;
 }
 
-uint8_t Packet::GetPayloadSize() const {
+size_t Packet::GetPayloadSize() const {
   return payload_.size();
 }
 
+size_t Packet::GetPayloadSizeFromHeader(
+    const std::vector<uint8_t>& header) const {
+  return header.back();
+}
+
 serial_data_type_t Packet::GetType() const {
   return type_;
 }
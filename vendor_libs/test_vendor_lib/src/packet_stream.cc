@@ -51,6 +51,28 @@ std::unique_ptr<CommandPacket> PacketStream::ReceiveCommand(int fd) const {
   return command;
 }
 
+std::unique_ptr<AclPacket> PacketStream::ReceiveAcl(int fd) const {
+  std::vector<uint8_t> header;
+  std::vector<uint8_t> payload;
+
+  if (!ReceiveAll(header, AclPacket::kAclHeaderSize, fd)) {
+    LOG_ERROR(LOG_TAG, "Error: receiving ACL header.");
+    return std::unique_ptr<AclPacket>(nullptr);
+  }
+
+  if (!ReceiveAll(payload, header[2] | (header[3] << 8), fd)) {
+    LOG_ERROR(LOG_TAG, "Error: receiving ACL payload.");
+    return std::unique_ptr<AclPacket>(nullptr);
+  }
+
+  std::unique_ptr<AclPacket> acl(new AclPacket());
+  if (!acl->Encode(header, payload)) {
+    LOG_ERROR(LOG_TAG, "Error: encoding ACL packet.");
+    acl.reset(nullptr);
+  }
+  return acl;
+}
+
 serial_data_type_t PacketStream::ReceivePacketType(int fd) const {
   LOG_INFO(LOG_TAG, "Receiving packet type.");
 
@@ -78,18 +100,27 @@ bool PacketStream::SendEvent(const EventPacket& event, int fd) const {
   LOG_INFO(LOG_TAG, "Sending event with size: %zu octets",
            event.GetPacketSize());
 
-  if (!SendAll({static_cast<uint8_t>(event.GetType())}, 1, fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event type.");
-    return false;
-  }
+  return SendPacket(event, fd);
+}
 
-  if (!SendAll(event.GetHeader(), event.GetHeaderSize(), fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event header.");
-    return false;
-  }
+bool PacketStream::SendAcl(const AclPacket& acl, int fd) const {
+  return SendPacket(acl, fd);
+}
 
-  if (!SendAll(event.GetPayload(), event.GetPayloadSize(), fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event payload.");
+bool PacketStream::SendPacket(const Packet& packet, int fd) const {
+  // Gather the packet so that it goes out in one write. Data packets are sent
+  // back to back, and three writes per packet dominate the cost of sending.
+  std::vector<uint8_t> raw_packet;
+  raw_packet.reserve(packet.GetPacketSize());
+  raw_packet.push_back(static_cast<uint8_t>(packet.GetType()));
+  raw_packet.insert(raw_packet.end(), packet.GetHeader().begin(),
+                    packet.GetHeader().end());
+  raw_packet.insert(raw_packet.end(), packet.GetPayload().begin(),
+                    packet.GetPayload().end());
+
+  if (!SendAll(raw_packet, raw_packet.size(), fd)) {
+    LOG_ERROR(LOG_TAG, "Error: Could not send packet of type 0x%02X.",
+              packet.GetType());
     return false;
   }
   return true;
@@ -82,6 +82,11 @@ bool VendorManager::Run() {
   controller_.RegisterDelayedEventChannel(
       std::bind(&HciTransport::PostDelayedEventResponse, &transport_,
                 std::placeholders::_1, std::placeholders::_2));
+  controller_.RegisterAclChannel(std::bind(&HciTransport::PostAclData,
+                                          &transport_, std::placeholders::_1));
+  controller_.RegisterTaskChannel(
+      std::bind(&VendorManager::PostDelayedTask, this, std::placeholders::_1,
+                std::placeholders::_2));
 
   running_ = true;
   if (!thread_.StartWithOptions(
@@ -0,0 +1,359 @@
+//
+// Copyright 2016 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "vendor_libs/test_vendor_lib/include/echo_peer.h"
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include "stack/include/l2cdefs.h"
+#include "stack/include/rfcdefs.h"
+}  // extern "C"
+
+namespace {
+
+const size_t kMaxAclPayload = 27;
+const uint16_t kHostCid = 0x0041;
+const uint16_t kPeerCid = L2CAP_BASE_APPL_CID;
+const uint16_t kRfcommPsm = 0x0003;
+const uint16_t kLePsm = 0x0080;
+const uint8_t kDlci = 2;
+
+void AppendUint16(std::vector<uint8_t>* data, uint16_t value) {
+  data->push_back(value & 0xFF);
+  data->push_back(value >> 8);
+}
+
+uint16_t ReadUint16(const std::vector<uint8_t>& data, size_t offset) {
+  return data[offset] | (data[offset + 1] << 8);
+}
+
+uint8_t RfcommFcs(const std::vector<uint8_t>& frame, size_t length) {
+  uint8_t fcs = 0xFF;
+  for (size_t i = 0; i < length; ++i) {
+    fcs ^= frame[i];
+    for (int bit = 0; bit < 8; ++bit)
+      fcs = (fcs & 0x01) ? (fcs >> 1) ^ 0xE0 : fcs >> 1;
+  }
+  return 0xFF - fcs;
+}
+
+// An L2CAP frame sent by the peer.
+struct Frame {
+  uint16_t cid;
+  std::vector<uint8_t> payload;
+};
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+class EchoPeerTest : public ::testing::Test {
+ public:
+  void CreatePeer(bool is_le) {
+    peer_.reset(new EchoPeer(
+        is_le, kMaxAclPayload,
+        [this](uint8_t packet_boundary_flag,
+               const std::vector<uint8_t>& payload) {
+          EXPECT_LE(payload.size(), kMaxAclPayload);
+          packets_.emplace_back(packet_boundary_flag, payload);
+        }));
+  }
+
+  // Sends an L2CAP frame to the peer in ACL packets of |fragment_size|.
+  void Send(uint16_t cid, const std::vector<uint8_t>& payload,
+            size_t fragment_size = kMaxAclPayload) {
+    std::vector<uint8_t> frame;
+    AppendUint16(&frame, payload.size());
+    AppendUint16(&frame, cid);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    uint8_t packet_boundary_flag = AclPacket::kFirstNonFlushable;
+    for (size_t offset = 0; offset < frame.size(); offset += fragment_size) {
+      const size_t end = std::min(frame.size(), offset + fragment_size);
+      peer_->ReceiveAcl(packet_boundary_flag,
+                        std::vector<uint8_t>(frame.begin() + offset,
+                                             frame.begin() + end));
+      packet_boundary_flag = AclPacket::kContinuing;
+    }
+  }
+
+  void SendSignal(uint16_t cid, uint8_t code, uint8_t id,
+                  const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> command = {code, id};
+    AppendUint16(&command, data.size());
+    command.insert(command.end(), data.begin(), data.end());
+    Send(cid, command);
+  }
+
+  // Returns the L2CAP frames the peer sent since the last call.
+  std::vector<Frame> TakeFrames() {
+    std::vector<Frame> frames;
+    std::vector<uint8_t> frame;
+    for (const auto& packet : packets_) {
+      if (packet.first == AclPacket::kContinuing) {
+        EXPECT_FALSE(frame.empty());
+      } else {
+        EXPECT_EQ(AclPacket::kFirstFlushable, packet.first);
+        EXPECT_TRUE(frame.empty());
+      }
+      frame.insert(frame.end(), packet.second.begin(), packet.second.end());
+      if (frame.size() >= L2CAP_PKT_OVERHEAD &&
+          frame.size() ==
+              static_cast<size_t>(L2CAP_PKT_OVERHEAD + ReadUint16(frame, 0))) {
+        frames.push_back(
+            {ReadUint16(frame, 2),
+             std::vector<uint8_t>(frame.begin() + L2CAP_PKT_OVERHEAD,
+                                  frame.end())});
+        frame.clear();
+      }
+    }
+    EXPECT_TRUE(frame.empty());
+    packets_.clear();
+    return frames;
+  }
+
+  // Returns an RFCOMM frame from the host, which opened the multiplexer.
+  std::vector<uint8_t> RfcommFrame(uint8_t dlci, uint8_t type, bool command,
+                                   const std::vector<uint8_t>& info,
+                                   uint8_t credits) {
+    std::vector<uint8_t> frame;
+    frame.push_back(RFCOMM_EA | RFCOMM_CR(true, command) |
+                    (dlci << RFCOMM_SHIFT_DLCI));
+    frame.push_back(type | ((type != RFCOMM_UIH || credits) ? RFCOMM_PF : 0));
+    frame.push_back(RFCOMM_EA | (info.size() << RFCOMM_SHIFT_LENGTH1));
+    if (credits) frame.push_back(credits);
+    frame.insert(frame.end(), info.begin(), info.end());
+    frame.push_back(
+        RfcommFcs(frame, type == RFCOMM_UIH ? 2 : RFCOMM_CTRL_FRAME_LEN));
+    return frame;
+  }
+
+  std::vector<uint8_t> RfcommControl(uint8_t type, bool command,
+                                     const std::vector<uint8_t>& value) {
+    std::vector<uint8_t> info = {
+        static_cast<uint8_t>(RFCOMM_EA | RFCOMM_I_CR(command) | type),
+        static_cast<uint8_t>(RFCOMM_EA | (value.size() << 1))};
+    info.insert(info.end(), value.begin(), value.end());
+    return RfcommFrame(RFCOMM_MX_DLCI, RFCOMM_UIH, true, info, 0);
+  }
+
+  // Opens an L2CAP channel to the RFCOMM PSM and the multiplexer on it.
+  void OpenRfcommChannel() {
+    CreatePeer(false);
+    std::vector<uint8_t> request;
+    AppendUint16(&request, kRfcommPsm);
+    AppendUint16(&request, kHostCid);
+    SendSignal(L2CAP_SIGNALLING_CID, L2CAP_CMD_CONN_REQ, 1, request);
+
+    std::vector<Frame> frames = TakeFrames();
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(L2CAP_SIGNALLING_CID, frames[0].cid);
+    EXPECT_EQ(L2CAP_CMD_CONN_RSP, frames[0].payload[0]);
+    EXPECT_EQ(kPeerCid, ReadUint16(frames[0].payload, 4));
+    EXPECT_EQ(kHostCid, ReadUint16(frames[0].payload, 6));
+    EXPECT_EQ(L2CAP_CONN_OK, ReadUint16(frames[0].payload, 8));
+    EXPECT_EQ(L2CAP_CMD_CONFIG_REQ, frames[1].payload[0]);
+    EXPECT_EQ(kHostCid, ReadUint16(frames[1].payload, 4));
+
+    std::vector<uint8_t> config;
+    AppendUint16(&config, kPeerCid);
+    AppendUint16(&config, 0);
+    SendSignal(L2CAP_SIGNALLING_CID, L2CAP_CMD_CONFIG_REQ, 2, config);
+    frames = TakeFrames();
+    ASSERT_EQ(1u, frames.size());
+    EXPECT_EQ(L2CAP_CMD_CONFIG_RSP, frames[0].payload[0]);
+    EXPECT_EQ(kHostCid, ReadUint16(frames[0].payload, 4));
+    EXPECT_EQ(L2CAP_CFG_OK, ReadUint16(frames[0].payload, 8));
+
+    // SABM on the multiplexer DLCI, answered by UA. Both frames are the
+    // examples of 3GPP TS 07.10.
+    const std::vector<uint8_t> sabm =
+        RfcommFrame(RFCOMM_MX_DLCI, RFCOMM_SABME, true, {}, 0);
+    ASSERT_EQ(std::vector<uint8_t>({0x03, 0x3F, 0x01, 0x1C}), sabm);
+    Send(kPeerCid, sabm);
+    frames = TakeFrames();
+    ASSERT_EQ(1u, frames.size());
+    EXPECT_EQ(kHostCid, frames[0].cid);
+    EXPECT_EQ(std::vector<uint8_t>({0x03, 0x73, 0x01, 0xD7}),
+              frames[0].payload);
+  }
+
+  std::unique_ptr<EchoPeer> peer_;
+  std::vector<std::pair<uint8_t, std::vector<uint8_t>>> packets_;
+};
+
+TEST_F(EchoPeerTest, RejectsUnknownPsmAndCommands) {
+  CreatePeer(false);
+  std::vector<uint8_t> request;
+  AppendUint16(&request, 0x0019);
+  AppendUint16(&request, kHostCid);
+  SendSignal(L2CAP_SIGNALLING_CID, L2CAP_CMD_CONN_REQ, 1, request);
+  SendSignal(L2CAP_SIGNALLING_CID, L2CAP_CMD_AMP_CONN_REQ, 2, {});
+
+  std::vector<Frame> frames = TakeFrames();
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(L2CAP_CMD_CONN_RSP, frames[0].payload[0]);
+  EXPECT_EQ(L2CAP_CONN_NO_PSM, ReadUint16(frames[0].payload, 8));
+  EXPECT_EQ(L2CAP_CMD_REJECT, frames[1].payload[0]);
+  EXPECT_EQ(2, frames[1].payload[1]);
+}
+
+TEST_F(EchoPeerTest, RfcommEchoesWithinCredits) {
+  OpenRfcommChannel();
+
+  // Parameter negotiation for credit based flow control with 3 credits.
+  const std::vector<uint8_t> pn = {kDlci, RFCOMM_PN_CONV_LAYER_CBFC_I, 0, 0,
+                                   100,   0,                           0, 3};
+  Send(kPeerCid, RfcommControl(RFCOMM_MX_PN, true, pn));
+  std::vector<Frame> frames = TakeFrames();
+  ASSERT_EQ(1u, frames.size());
+  const std::vector<uint8_t>& pn_rsp = frames[0].payload;
+  ASSERT_EQ(3u + 2 + RFCOMM_MX_PN_LEN + 1, pn_rsp.size());
+  EXPECT_EQ(RFCOMM_EA | RFCOMM_MX_PN, pn_rsp[3]);
+  EXPECT_EQ(RFCOMM_PN_CONV_LAYER_CBFC_R, pn_rsp[5 + 1]);
+  EXPECT_EQ(RFCOMM_K_MAX, pn_rsp[5 + 7]);
+
+  Send(kPeerCid, RfcommFrame(kDlci, RFCOMM_SABME, true, {}, 0));
+  frames = TakeFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(RFCOMM_UA | RFCOMM_PF, frames[0].payload[1]);
+
+  // The host's modem status is answered, and followed by the peer's.
+  const uint8_t address = RFCOMM_EA | RFCOMM_CR_MASK |
+                          (kDlci << RFCOMM_SHIFT_DLCI);
+  Send(kPeerCid, RfcommControl(RFCOMM_MX_MSC, true,
+                               {address, RFCOMM_EA | RFCOMM_MSC_RTC}));
+  frames = TakeFrames();
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(RFCOMM_EA | RFCOMM_MX_MSC, frames[0].payload[3]);
+  EXPECT_EQ(RFCOMM_EA | RFCOMM_I_CR(true) | RFCOMM_MX_MSC,
+            frames[1].payload[3]);
+
+  // Four frames with 3 credits: the last one waits for a credit.
+  std::vector<std::vector<uint8_t>> data;
+  for (uint8_t i = 0; i < 4; ++i) {
+    data.push_back(std::vector<uint8_t>(10 + i, i));
+    Send(kPeerCid, RfcommFrame(kDlci, RFCOMM_UIH, true, data.back(), 0), 7);
+  }
+  frames = TakeFrames();
+  ASSERT_EQ(3u, frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const std::vector<uint8_t>& echo = frames[i].payload;
+    EXPECT_EQ(RFCOMM_UIH | RFCOMM_PF, echo[1]);
+    EXPECT_EQ(1, echo[3]);
+    EXPECT_EQ(data[i], std::vector<uint8_t>(echo.begin() + 4, echo.end() - 1));
+    EXPECT_EQ(RfcommFcs(echo, 2), echo.back());
+  }
+
+  Send(kPeerCid, RfcommFrame(kDlci, RFCOMM_UIH, true, {}, 1));
+  frames = TakeFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(data[3], std::vector<uint8_t>(frames[0].payload.begin() + 4,
+                                          frames[0].payload.end() - 1));
+
+  // A frame with a bad FCS is dropped.
+  std::vector<uint8_t> bad = RfcommFrame(kDlci, RFCOMM_UIH, true, {1, 2}, 1);
+  bad.back() ^= 0x01;
+  Send(kPeerCid, bad);
+  EXPECT_TRUE(TakeFrames().empty());
+}
+
+TEST_F(EchoPeerTest, LeCreditBasedEchoesWithinCredits) {
+  CreatePeer(true);
+  const uint16_t mps = 23;
+  std::vector<uint8_t> request;
+  AppendUint16(&request, kLePsm);
+  AppendUint16(&request, kHostCid);
+  AppendUint16(&request, 100);
+  AppendUint16(&request, mps);
+  AppendUint16(&request, 2);
+  SendSignal(L2CAP_BLE_SIGNALLING_CID, L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ, 1,
+             request);
+
+  std::vector<Frame> frames = TakeFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(L2CAP_BLE_SIGNALLING_CID, frames[0].cid);
+  const std::vector<uint8_t>& response = frames[0].payload;
+  ASSERT_EQ(L2CAP_CMD_OVERHEAD + L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN,
+            response.size());
+  EXPECT_EQ(L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES, response[0]);
+  EXPECT_EQ(kPeerCid, ReadUint16(response, 4));
+  EXPECT_EQ(100, ReadUint16(response, 6));
+  EXPECT_EQ(mps, ReadUint16(response, 8));
+  EXPECT_EQ(2, ReadUint16(response, 10));
+  EXPECT_EQ(L2CAP_LE_CONN_OK, ReadUint16(response, 12));
+
+  // A 50 octet SDU in three K-frames, sent in small ACL packets.
+  std::vector<uint8_t> sdu(50);
+  for (size_t i = 0; i < sdu.size(); ++i)
+    sdu[i] = i;
+  std::vector<uint8_t> k_frame;
+  AppendUint16(&k_frame, sdu.size());
+  k_frame.insert(k_frame.end(), sdu.begin(), sdu.begin() + mps - 2);
+  Send(kPeerCid, k_frame, 10);
+  Send(kPeerCid, std::vector<uint8_t>(sdu.begin() + mps - 2,
+                                      sdu.begin() + 2 * mps - 2), 10);
+  Send(kPeerCid, std::vector<uint8_t>(sdu.begin() + 2 * mps - 2, sdu.end()),
+       10);
+
+  // Two credits send the first two K-frames of the echo.
+  frames = TakeFrames();
+  ASSERT_EQ(2u, frames.size());
+  std::vector<uint8_t> echo;
+  for (const Frame& frame : frames) {
+    EXPECT_EQ(kHostCid, frame.cid);
+    EXPECT_LE(frame.payload.size(), mps);
+    echo.insert(echo.end(), frame.payload.begin(), frame.payload.end());
+  }
+
+  // The last one goes with the next credit, followed by the three credits
+  // the SDU took.
+  std::vector<uint8_t> credit;
+  AppendUint16(&credit, kHostCid);
+  AppendUint16(&credit, 1);
+  SendSignal(L2CAP_BLE_SIGNALLING_CID, L2CAP_CMD_BLE_FLOW_CTRL_CREDIT, 2,
+             credit);
+  frames = TakeFrames();
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(kHostCid, frames[0].cid);
+  echo.insert(echo.end(), frames[0].payload.begin(), frames[0].payload.end());
+  EXPECT_EQ(L2CAP_BLE_SIGNALLING_CID, frames[1].cid);
+  EXPECT_EQ(L2CAP_CMD_BLE_FLOW_CTRL_CREDIT, frames[1].payload[0]);
+  EXPECT_EQ(kPeerCid, ReadUint16(frames[1].payload, 4));
+  EXPECT_EQ(3, ReadUint16(frames[1].payload, 6));
+
+  ASSERT_EQ(L2CAP_SDU_LEN_OVERHEAD + sdu.size(), echo.size());
+  EXPECT_EQ(sdu.size(), ReadUint16(echo, 0));
+  EXPECT_EQ(sdu, std::vector<uint8_t>(echo.begin() + L2CAP_SDU_LEN_OVERHEAD,
+                                      echo.end()));
+
+  std::vector<uint8_t> disconnect;
+  AppendUint16(&disconnect, kPeerCid);
+  AppendUint16(&disconnect, kHostCid);
+  SendSignal(L2CAP_BLE_SIGNALLING_CID, L2CAP_CMD_DISC_REQ, 3, disconnect);
+  frames = TakeFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(L2CAP_CMD_DISC_RSP, frames[0].payload[0]);
+  Send(kPeerCid, k_frame);
+  EXPECT_TRUE(TakeFrames().empty());
+}
+
+}  // namespace test_vendor_lib
@@ -15,11 +15,13 @@
 //
 
 #include "vendor_libs/test_vendor_lib/include/packet_stream.h"
+#include "vendor_libs/test_vendor_lib/include/acl_packet.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 #include "vendor_libs/test_vendor_lib/include/packet.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -142,6 +144,60 @@ TEST_F(PacketStreamTest, ReceiveLargeCommand) {
   CheckedReceiveCommand(large_payload, HCI_RESET);
 }
 
+TEST_F(PacketStreamTest, ReceiveAcl) {
+  // Larger than the one octet size field of commands and events.
+  const size_t payload_size = 1021;
+  const uint16_t handle_and_flags = 0x0042 | (AclPacket::kFirstFlushable << 12);
+  std::vector<uint8_t> packet = {DATA_TYPE_ACL,
+                                 static_cast<uint8_t>(handle_and_flags),
+                                 static_cast<uint8_t>(handle_and_flags >> 8),
+                                 static_cast<uint8_t>(payload_size),
+                                 static_cast<uint8_t>(payload_size >> 8)};
+  for (size_t i = 0; i < payload_size; ++i)
+    packet.push_back(i);
+  write(socketpair_fds_[1], &packet[0], packet.size());
+
+  EXPECT_EQ(DATA_TYPE_ACL,
+            packet_stream_.ReceivePacketType(socketpair_fds_[0]));
+  std::unique_ptr<AclPacket> acl =
+      packet_stream_.ReceiveAcl(socketpair_fds_[0]);
+  ASSERT_TRUE(acl != nullptr);
+  EXPECT_EQ(packet.size(), acl->GetPacketSize());
+  EXPECT_EQ(0x0042, acl->GetHandle());
+  EXPECT_EQ(AclPacket::kFirstFlushable, acl->GetPacketBoundaryFlag());
+  EXPECT_EQ(0, acl->GetBroadcastFlag());
+  ASSERT_EQ(payload_size, acl->GetPayloadSize());
+  EXPECT_TRUE(std::equal(packet.begin() + 5, packet.end(),
+                         acl->GetPayload().begin()));
+}
+
+TEST_F(PacketStreamTest, SendAcl) {
+  const std::vector<uint8_t> payload(large_payload,
+                                     large_payload + sizeof(large_payload));
+  std::unique_ptr<AclPacket> acl = AclPacket::CreateAclPacket(
+      0x0EFE, AclPacket::kContinuing, 0, payload);
+  ASSERT_TRUE(acl != nullptr);
+  EXPECT_TRUE(packet_stream_.SendAcl(*acl, socketpair_fds_[0]));
+
+  uint8_t header[5];
+  ASSERT_EQ((ssize_t)sizeof(header),
+            read(socketpair_fds_[1], header, sizeof(header)));
+  EXPECT_EQ(DATA_TYPE_ACL, header[0]);
+  EXPECT_EQ(0xFE, header[1]);
+  EXPECT_EQ(0x0E | (AclPacket::kContinuing << 4), header[2]);
+  EXPECT_EQ(payload.size(), (size_t)(header[3] | (header[4] << 8)));
+
+  std::vector<uint8_t> received(payload.size());
+  ASSERT_EQ((ssize_t)received.size(),
+            read(socketpair_fds_[1], &received[0], received.size()));
+  EXPECT_EQ(payload, received);
+}
+
+TEST_F(PacketStreamTest, SendNumberOfCompletedPacketsEvent) {
+  CheckedSendEvent(EventPacket::CreateNumberOfCompletedPacketsEvent(
+      {{0x0001, 3}, {0x0002, 0x0102}}));
+}
+
 TEST_F(PacketStreamTest, SendEvent) {
   const std::vector<uint8_t> return_parameters = {0};
   CheckedSendEvent(